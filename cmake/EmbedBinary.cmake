@@ -0,0 +1,39 @@
+#
+# Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+# Writes the contents of INPUT into OUTPUT as a C++ byte array named NAME.
+# Usage: cmake -DINPUT=<file> -DOUTPUT=<header> -DNAME=<identifier> -P EmbedBinary.cmake
+
+file(READ "${INPUT}" contents HEX)
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${contents}")
+# 32 bytes per line. CMake regular expressions have no {n} quantifier, and string(REPEAT) needs CMake 3.15.
+set(line_pattern "")
+foreach(index RANGE 31)
+    string(APPEND line_pattern "0x..,")
+endforeach()
+string(REGEX REPLACE "(${line_pattern})" "\\1\n    " bytes "${bytes}")
+
+get_filename_component(input_name "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+    "// Generated from ${input_name} by EmbedBinary.cmake, do not edit.\n"
+    "#pragma once\n"
+    "#include <cstdint>\n"
+    "static const uint8_t ${NAME}[] = {\n    ${bytes}\n};\n")
@@ -0,0 +1,100 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::capture
+{
+    // The capture layer wraps a device and serializes the command lists that are executed between beginCapture and
+    // endCapture into a binary stream, together with the descriptions of every object that they reference.
+    // The stream can be replayed on another device with createReplay, which makes it possible to measure the CPU
+    // recording time and GPU time of a production frame across NVRHI or driver versions without the application.
+    //
+    // Limitations:
+    //  - Objects are recreated from their descriptions, so the contents of buffers and textures that were written
+    //    before the capture started, or through mapped pointers, are not captured. Only the data passed to
+    //    writeBuffer, writeTexture and setPushConstants during the capture is.
+    //  - Shader bytecode is captured as is, so the stream can only be replayed on a device using the same graphics API
+    //    as the captured one, or on the null device. Specialization constants are not captured.
+    //  - Ray tracing, opacity micromaps, command bundles, sampler feedback and tiled resources are passed through to
+    //    the underlying device but not captured; a warning is issued when the capture contains any of them.
+    //    Virtual resources are replayed as committed resources.
+    class ICaptureDevice : public IDevice
+    {
+    public:
+        // Starts capturing the command lists that are opened from now on.
+        virtual void beginCapture() = 0;
+
+        // Stops the capture and writes the stream into outData.
+        // Returns false if no capture was active.
+        virtual bool endCapture(std::vector<uint8_t>& outData) = 0;
+
+        [[nodiscard]] virtual bool isCapturing() const = 0;
+    };
+
+    typedef RefCountPtr<ICaptureDevice> CaptureDeviceHandle;
+
+    NVRHI_API CaptureDeviceHandle createCaptureLayer(IDevice* underlyingDevice);
+
+    struct CaptureInfo
+    {
+        // The graphics API of the device that the stream was captured on
+        GraphicsAPI graphicsAPI = GraphicsAPI::D3D12;
+
+        // The c_HeaderVersion of the NVRHI build that captured the stream
+        uint32_t headerVersion = 0;
+    };
+
+    // Reads the header of a captured stream.
+    // Returns false if the data is not a stream that this version of NVRHI can replay.
+    NVRHI_API bool getCaptureInfo(const void* data, size_t size, CaptureInfo& outInfo);
+
+    struct ReplayStatistics
+    {
+        // CPU time spent recording the captured command lists, in seconds
+        double cpuRecordingTime = 0.0;
+
+        // GPU time of the captured command lists on the graphics and compute queues, in seconds,
+        // or 0 if timer queries are not available
+        double gpuTime = 0.0;
+
+        uint32_t commandListsRecorded = 0;
+        uint32_t commandsReplayed = 0;
+    };
+
+    class IReplay : public IResource
+    {
+    public:
+        // Records and executes all command lists of the captured frame, waits for the device to become idle,
+        // and returns the timings of this frame in outStatistics if it's not NULL.
+        // Returns false if the stream could not be decoded. Can be called multiple times.
+        virtual bool replayFrame(ReplayStatistics* outStatistics = nullptr) = 0;
+    };
+
+    typedef RefCountPtr<IReplay> ReplayHandle;
+
+    // Creates the objects described by a captured stream on the device.
+    // Returns nullptr if the stream is invalid or was captured with an incompatible version of NVRHI.
+    NVRHI_API ReplayHandle createReplay(IDevice* device, const void* data, size_t size);
+}
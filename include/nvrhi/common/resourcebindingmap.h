@@ -86,9 +86,10 @@ namespace std
     {
         std::size_t operator()(nvrhi::TextureBindingKey const& s) const noexcept
         {
-            return std::hash<nvrhi::Format>()(s.format)
-                ^ std::hash<nvrhi::TextureSubresourceSet>()(s)
-                ^ std::hash<bool>()(s.isReadOnlyDSV);
+            nvrhi::WordHasher hasher;
+            std::hash<nvrhi::TextureSubresourceSet>::append(hasher, s);
+            hasher.add(uint64_t(s.format) | (uint64_t(s.isReadOnlyDSV) << 8));
+            return hasher.get();
         }
     };
 
@@ -96,8 +97,10 @@ namespace std
     {
         std::size_t operator()(nvrhi::BufferBindingKey const& s) const noexcept
         {
-            return std::hash<nvrhi::Format>()(s.format)
-                ^ std::hash<nvrhi::BufferRange>()(s);
+            nvrhi::WordHasher hasher;
+            std::hash<nvrhi::BufferRange>::append(hasher, s);
+            hasher.add(uint64_t(s.format) | (uint64_t(s.type) << 8));
+            return hasher.get();
         }
     };
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// On-disk format of the shader archives written by nvrhi-scomp with --archive, and read by nvrhi::openShaderArchive.
+//
+// The file starts with a ShaderArchiveHeader, followed by numEntries ShaderArchiveEntry structures sorted by key.
+// Each entry points at its shader name and permutation strings, stored back to back without terminators,
+// and at the bytecode of the permutation. The bytecode is aligned to c_ShaderArchiveDataAlignment bytes,
+// so that SPIR-V can be passed to the driver straight from the mapped file. All values are little-endian.
+
+namespace nvrhi
+{
+    constexpr uint32_t c_ShaderArchiveSignature = 0x4153564e; // "NVSA"
+    constexpr uint32_t c_ShaderArchiveVersion = 1;
+    constexpr uint64_t c_ShaderArchiveDataAlignment = 16;
+
+    struct ShaderArchiveHeader
+    {
+        uint32_t signature = c_ShaderArchiveSignature;
+        uint32_t version = c_ShaderArchiveVersion;
+        uint32_t numEntries = 0;
+        uint32_t reserved = 0;
+    };
+
+    struct ShaderArchiveEntry
+    {
+        uint64_t key = 0;           // getShaderArchiveKey(name, permutation)
+        uint64_t dataOffset = 0;    // from the start of the file
+        uint64_t dataSize = 0;
+        uint64_t stringsOffset = 0; // the name, immediately followed by the permutation
+        uint32_t nameSize = 0;
+        uint32_t permutationSize = 0;
+    };
+
+    static_assert(sizeof(ShaderArchiveHeader) == 16, "ShaderArchiveHeader is part of the file format");
+    static_assert(sizeof(ShaderArchiveEntry) == 40, "ShaderArchiveEntry is part of the file format");
+
+    // 64-bit FNV-1a, stable across compilers and platforms unlike std::hash
+    inline uint64_t hashShaderArchiveString(const char* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= uint8_t(data[i]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    // The name is the output path of the shader in the nvrhi-scomp config file with '/' separators, e.g. "shaders/foo_main.bin".
+    // The permutation is the list of defines in config file order, each followed by a space: "A=1 B=2 ", or empty.
+    inline uint64_t getShaderArchiveKey(const char* name, size_t nameSize, const char* permutation, size_t permutationSize)
+    {
+        uint64_t hash = hashShaderArchiveString(name, nameSize);
+        // Separate the strings, so that moving characters between them changes the key
+        hash = hashShaderArchiveString("\n", 1, hash);
+        return hashShaderArchiveString(permutation, permutationSize, hash);
+    }
+}
@@ -117,9 +117,43 @@ namespace nvrhi::d3d12
         uint32_t shaderResourceViewHeapSize = 16384;
         uint32_t samplerHeapSize = 1024;
         uint32_t maxTimerQueries = 256;
+
+        // Use enhanced barriers (ID3D12GraphicsCommandList7::Barrier) instead of legacy resource barriers
+        // when the device supports them. Requires NVRHI to be built with a d3d12.h that declares them.
+        bool enableEnhancedBarriers = false;
+
+        // Track the residency of committed device-local resources and heaps, and when the local memory usage exceeds
+        // the budget, evict the least recently used ones after the GPU has finished using them. Evicted objects are
+        // made resident again in executeCommandLists before a command list that uses them is submitted.
+        // Only the resources whose states are tracked by the command lists are seen as used, so resources that are
+        // accessed only through descriptor tables or with automatic barriers disabled must have their states set
+        // explicitly with setTextureState/setBufferState in every command list that uses them.
+        bool enableResidencyManager = false;
+
+        // The node of a linked-adapter (explicit multi-GPU) device that the NVRHI device works on, as a single bit.
+        // 0 means single-node operation, which is the same as node 0. The command queues above must be created
+        // with the same node mask. Everything that the device creates - memory, descriptor heaps, pipelines,
+        // command lists and queries - belongs to that node, so use one NVRHI device per node on the same ID3D12Device.
+        // Objects cannot be used with the NVRHI device of another node. To share memory between nodes, create it with
+        // a visibleNodeMask that includes the other nodes, and open the native resource on the other node's device
+        // with createHandleForNativeTexture or createHandleForNativeBuffer; copy command lists of either node can then
+        // copy between it and the resources of their node. See queueWaitForCommandList below for synchronization.
+        uint32_t nodeMask = 0;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
 
+    // Makes the waitQueue of waitDevice wait on the GPU until the command lists executed on the executionQueue
+    // of executionDevice with the given instance have finished, like IDevice::queueWaitForCommandList.
+    // The devices must be created for different nodes of the same ID3D12Device, see DeviceDesc::nodeMask.
+    NVRHI_API void queueWaitForCommandList(nvrhi::IDevice* waitDevice, CommandQueue waitQueue,
+        nvrhi::IDevice* executionDevice, CommandQueue executionQueue, uint64_t instance);
+
+    // Makes the OS signal the event once all submissions (or any of them, when waitAny is true) have completed,
+    // so that applications can wait for GPU work together with their own handles, e.g. in WaitForMultipleObjects.
+    // Uses ID3D12Device1::SetEventOnMultipleFenceCompletion. Works through the validation and capture layers.
+    NVRHI_API bool setEventOnSubmissions(nvrhi::IDevice* device, const SubmissionPoint* submissions, size_t count,
+        bool waitAny, HANDLE event);
+
     NVRHI_API DXGI_FORMAT convertFormat(nvrhi::Format format);
 }
\ No newline at end of file
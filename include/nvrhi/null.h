@@ -0,0 +1,49 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::ObjectTypes
+{
+    constexpr ObjectType Nvrhi_Null_Device = 0x00040101;
+};
+
+namespace nvrhi::null
+{
+    // The null device implements the whole IDevice interface without a GPU or a graphics API.
+    // It creates the resource, pipeline and binding objects, tracks the resource states and the referenced resources
+    // in command lists, and suballocates upload memory like the other backends do, but executing a command list
+    // only retires it: no GPU work is emulated, and GPU-only resources have no contents.
+    // This makes it possible to measure the CPU cost of the NVRHI calls made by an application on machines without a GPU.
+    struct DeviceDesc
+    {
+        IMessageCallback* messageCallback = nullptr;
+
+        // The API that IDevice::getGraphicsAPI reports, so that the application takes the code paths
+        // and loads the shader binaries that it would use on that API. Shader binaries are not parsed.
+        GraphicsAPI graphicsAPI = GraphicsAPI::D3D12;
+    };
+
+    NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
+}
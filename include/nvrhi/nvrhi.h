@@ -28,6 +28,7 @@
 #include <cstdint>
 #include <cmath>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -62,7 +63,7 @@ namespace nvrhi
 {
     // Version of the public API provided by NVRHI.
     // Increment this when any changes to the API are made.
-    static constexpr uint32_t c_HeaderVersion = 14;
+    static constexpr uint32_t c_HeaderVersion = 59;
 
     // Verifies that the version of the implementation matches the version of the header.
     // Returns true if they match. Use this when initializing apps using NVRHI as a shared library.
@@ -75,6 +76,8 @@ namespace nvrhi
     static constexpr uint32_t c_MaxBindingsPerLayout = 128;
     static constexpr uint32_t c_MaxVolatileConstantBuffersPerLayout = 6;
     static constexpr uint32_t c_MaxVolatileConstantBuffers = 32;
+    static constexpr uint32_t c_MaxIndirectArguments = 16;
+    static constexpr uint32_t c_MaxRootDescriptorsPerLayout = 8; // D3D12: each root descriptor takes 2 of the 64 root signature DWORDs
     static constexpr uint32_t c_MaxPushConstantSize = 128; // D3D12: root signature is 256 bytes max., Vulkan: 128 bytes of push constants guaranteed
     static constexpr uint32_t c_ConstantBufferOffsetSizeAlignment = 256; // Partially bound constant buffers must have offsets aligned to this and sizes multiple of this
 
@@ -292,14 +295,44 @@ namespace nvrhi
         Readback
     };
 
+    // Kinds of resources that a heap can hold. D3D12 heaps on resource heap tier 1 can only hold one category,
+    // where Any means render target and depth-stencil textures, like before the categories were added.
+    // Only used on DX12.
+    enum class HeapCategory : uint8_t
+    {
+        Any,
+        Buffers,
+        Textures,               // textures with isRenderTarget = false
+        RenderTargetTextures    // textures with isRenderTarget = true, i.e. render targets and depth-stencil textures
+    };
+
+    // Hint for the OS memory manager about which allocations to keep in video memory when it is oversubscribed.
+    // Maps to ID3D12Device1::SetResidencyPriority on DX12, ID3D11Resource::SetEvictionPriority on DX11,
+    // and VK_EXT_memory_priority on Vulkan when the extension is enabled.
+    enum class ResidencyPriority : uint8_t
+    {
+        Minimum,
+        Low,
+        Normal,
+        High,
+        Maximum
+    };
+
     struct HeapDesc
     {
         uint64_t capacity = 0;
         HeapType type;
+        HeapCategory category = HeapCategory::Any;
+        ResidencyPriority residencyPriority = ResidencyPriority::Normal;
+        // Other linked-adapter nodes that can access the heap, see d3d12::DeviceDesc::nodeMask. Only used on DX12.
+        uint32_t visibleNodeMask = 0;
         std::string debugName;
 
         constexpr HeapDesc& setCapacity(uint64_t value) { capacity = value; return *this; }
         constexpr HeapDesc& setType(HeapType value) { type = value; return *this; }
+        constexpr HeapDesc& setCategory(HeapCategory value) { category = value; return *this; }
+        constexpr HeapDesc& setResidencyPriority(ResidencyPriority value) { residencyPriority = value; return *this; }
+        constexpr HeapDesc& setVisibleNodeMask(uint32_t value) { visibleNodeMask = value; return *this; }
                   HeapDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
     };
 
@@ -368,6 +401,7 @@ namespace nvrhi
         ShadingRateSurface          = 0x00100000,
         OpacityMicromapWrite        = 0x00200000,
         OpacityMicromapBuildInput   = 0x00400000,
+        Predication                 = 0x00800000,
     };
 
     NVRHI_ENUM_CLASS_FLAG_OPERATORS(ResourceStates)
@@ -415,13 +449,34 @@ namespace nvrhi
         bool isTypeless = false;
         bool isShadingRateSurface = false;
 
+        // Indicates that the texture is only used as a framebuffer attachment within render passes
+        // that clear or discard it on load and discard it on store, so its contents never need to reach memory.
+        // On Vulkan, the image is created with the transient attachment usage and placed in lazily allocated memory
+        // when the device provides it. Transient textures must be render targets and cannot be shader resources,
+        // UAVs or copy sources/destinations. Other backends create a regular render target.
+        bool isTransient = false;
+
         SharedResourceFlags sharedResourceFlags = SharedResourceFlags::None;
 
+        // Residency priority of the texture memory. Ignored for textures placed in a heap, which use the heap's priority.
+        ResidencyPriority residencyPriority = ResidencyPriority::Normal;
+
+        // Other linked-adapter nodes that can access the texture, e.g. to copy it, see d3d12::DeviceDesc::nodeMask.
+        // The texture memory always belongs to the node of the device that creates it. Only used on DX12,
+        // and ignored for textures placed in a heap, which use the heap's visibility.
+        uint32_t visibleNodeMask = 0;
+
         // Indicates that the texture is created with no backing memory,
         // and memory is bound to the texture later using bindTextureMemory.
         // On DX12, the texture resource is created at the time of memory binding.
         bool isVirtual = false;
 
+        // Indicates that the texture is a tiled (reserved, sparse) resource with no backing memory.
+        // Individual tiles are mapped to heap memory with IDevice::updateTextureTileMappings,
+        // and unmapped tiles read as zero. Requires Feature::TiledResources; on Vulkan, the application must also
+        // enable the sparseBinding and sparseResidency* device features that it uses.
+        bool isTiled = false;
+
         Color clearValue;
         bool useClearValue = false;
 
@@ -432,6 +487,14 @@ namespace nvrhi
         // on command list close.
         bool keepInitialState = true; // [rlaw]: change default value to 'true'
 
+        // Enables automatic liveness tracking of this texture by nvrhi command lists, see BindingSetDesc::trackLiveness.
+        bool trackLiveness = true;
+
+        // Allows the texture to be written with IDevice::writeTextureDirect, see Feature::DirectTextureWrite.
+        // On Vulkan, the image is created with the host transfer usage, which may disable some compression.
+        // The flag is cleared on the created Vulkan texture when its format doesn't support host transfers.
+        bool allowDirectWrite = false;
+
         constexpr TextureDesc& setWidth(uint32_t value) { width = value; return *this; }
         constexpr TextureDesc& setHeight(uint32_t value) { height = value; return *this; }
         constexpr TextureDesc& setDepth(uint32_t value) { depth = value; return *this; }
@@ -446,11 +509,17 @@ namespace nvrhi
         constexpr TextureDesc& setIsUAV(bool value) { isUAV = value; return *this; }
         constexpr TextureDesc& setIsTypeless(bool value) { isTypeless = value; return *this; }
         constexpr TextureDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+        constexpr TextureDesc& setIsTiled(bool value) { isTiled = value; return *this; }
+        constexpr TextureDesc& setIsTransient(bool value) { isTransient = value; return *this; }
         constexpr TextureDesc& setClearValue(const Color& value) { clearValue = value; useClearValue = true; return *this; }
         constexpr TextureDesc& setUseClearValue(bool value) { useClearValue = value; return *this; }
         constexpr TextureDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
         constexpr TextureDesc& setKeepInitialState(bool value) { keepInitialState = value; return *this; }
+        constexpr TextureDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
+        constexpr TextureDesc& setAllowDirectWrite(bool value) { allowDirectWrite = value; return *this; }
         constexpr TextureDesc& setSharedResourceFlags(SharedResourceFlags value) { sharedResourceFlags = value; return *this; }
+        constexpr TextureDesc& setResidencyPriority(ResidencyPriority value) { residencyPriority = value; return *this; }
+        constexpr TextureDesc& setVisibleNodeMask(uint32_t value) { visibleNodeMask = value; return *this; }
     };
 
     // describes a 2D section of a single mip level + single slice of a texture
@@ -541,6 +610,108 @@ namespace nvrhi
     };
     typedef RefCountPtr<IStagingTexture> StagingTextureHandle;
 
+    //////////////////////////////////////////////////////////////////////////
+    // Tiled Resources
+    //////////////////////////////////////////////////////////////////////////
+
+    // Mip levels too small to be split into whole tiles are packed together into a mip tail,
+    // which is mapped as a unit of numTilesForPackedMips tiles, separately for each array slice.
+    struct PackedMipDesc
+    {
+        uint32_t numStandardMips = 0;
+        uint32_t numPackedMips = 0;
+        uint32_t numTilesForPackedMips = 0;
+        uint32_t startTileIndexInOverallResource = 0;
+    };
+
+    struct TileShape
+    {
+        uint32_t widthInTexels = 0;
+        uint32_t heightInTexels = 0;
+        uint32_t depthInTexels = 0;
+    };
+
+    struct SubresourceTiling
+    {
+        uint32_t widthInTiles = 0;
+        uint32_t heightInTiles = 0;
+        uint32_t depthInTiles = 0;
+        uint32_t startTileIndexInOverallResource = 0;
+    };
+
+    // Coordinates of the first tile of a region, in tiles.
+    // Regions in the packed mips start at mipLevel = PackedMipDesc::numStandardMips and x,y,z = 0.
+    struct TiledTextureCoordinate
+    {
+        uint16_t mipLevel = 0;
+        uint16_t arrayLevel = 0;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t z = 0;
+    };
+
+    // Size of a region, in tiles. When width, height and depth are all non-zero, the region is a box,
+    // otherwise it covers tilesNum tiles starting at the coordinate, which is how the packed mips are mapped.
+    struct TiledTextureRegion
+    {
+        uint32_t tilesNum = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 0;
+    };
+
+    // Maps each region to consecutive tiles of the heap starting at the matching byte offset,
+    // or unmaps the regions when heap is null. Offsets must be multiples of the tile size, 64 KB.
+    struct TextureTilesMapping
+    {
+        TiledTextureCoordinate* tiledTextureCoordinates = nullptr;
+        TiledTextureRegion* tiledTextureRegions = nullptr;
+        uint64_t* byteOffsets = nullptr;
+        uint32_t numTextureRegions = 0;
+        IHeap* heap = nullptr;
+    };
+
+    // Maps a range of a tiled buffer to the heap, or unmaps it when heap is null.
+    // All values must be multiples of the tile size, 64 KB.
+    struct BufferTilesMapping
+    {
+        uint64_t bufferOffset = 0;
+        uint64_t byteSize = 0;
+        IHeap* heap = nullptr;
+        uint64_t heapOffset = 0;
+
+        constexpr BufferTilesMapping& setBufferOffset(uint64_t value) { bufferOffset = value; return *this; }
+        constexpr BufferTilesMapping& setByteSize(uint64_t value) { byteSize = value; return *this; }
+        constexpr BufferTilesMapping& setHeap(IHeap* value) { heap = value; return *this; }
+        constexpr BufferTilesMapping& setHeapOffset(uint64_t value) { heapOffset = value; return *this; }
+    };
+
+    enum class SamplerFeedbackFormat : uint8_t
+    {
+        MinMipOpaque,
+        MipRegionUsedOpaque
+    };
+
+    // A sampler feedback texture records which mip regions of its paired texture were sampled by the shaders
+    // that write to it through a FeedbackTexture2D UAV. Streaming reads it back with decodeSamplerFeedbackTexture
+    // to find the tiles that need to be resident. Requires Feature::SamplerFeedback.
+    struct SamplerFeedbackTextureDesc
+    {
+        SamplerFeedbackFormat samplerFeedbackFormat = SamplerFeedbackFormat::MinMipOpaque;
+        uint32_t samplerFeedbackMipRegionX = 0;
+        uint32_t samplerFeedbackMipRegionY = 0;
+        uint32_t samplerFeedbackMipRegionZ = 0;
+        ResourceStates initialState = ResourceStates::Unknown;
+        bool keepInitialState = false;
+
+        constexpr SamplerFeedbackTextureDesc& setSamplerFeedbackFormat(SamplerFeedbackFormat value) { samplerFeedbackFormat = value; return *this; }
+        constexpr SamplerFeedbackTextureDesc& setSamplerFeedbackMipRegionX(uint32_t value) { samplerFeedbackMipRegionX = value; return *this; }
+        constexpr SamplerFeedbackTextureDesc& setSamplerFeedbackMipRegionY(uint32_t value) { samplerFeedbackMipRegionY = value; return *this; }
+        constexpr SamplerFeedbackTextureDesc& setSamplerFeedbackMipRegionZ(uint32_t value) { samplerFeedbackMipRegionZ = value; return *this; }
+        constexpr SamplerFeedbackTextureDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
+        constexpr SamplerFeedbackTextureDesc& setKeepInitialState(bool value) { keepInitialState = value; return *this; }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Input Layout
     //////////////////////////////////////////////////////////////////////////
@@ -578,6 +749,9 @@ namespace nvrhi
     // Buffer
     //////////////////////////////////////////////////////////////////////////
 
+    // GPU virtual address (D3D12) or buffer device address (Vulkan)
+    typedef uint64_t GpuVirtualAddress;
+
     struct BufferDesc
     {
         uint64_t byteSize = 0;
@@ -596,6 +770,9 @@ namespace nvrhi
         bool isAccelStructStorage = false;
         bool isShaderBindingTable = false;
 
+        // The buffer can be used with ICommandList::setPredication, usually as the destination of resolveQueries.
+        bool isPredicationBuffer = false;
+
         // A dynamic/upload buffer whose contents only live in the current command list
         bool isVolatile = false;
 
@@ -604,6 +781,11 @@ namespace nvrhi
         // On DX12, the buffer resource is created at the time of memory binding.
         bool isVirtual = false;
 
+        // Indicates that the buffer is a tiled (reserved, sparse) resource with no backing memory.
+        // Ranges of the buffer are mapped to heap memory with IDevice::updateBufferTileMappings.
+        // Requires Feature::TiledResources.
+        bool isTiled = false;
+
         ResourceStates initialState = ResourceStates::Common;
 
         // see TextureDesc::keepInitialState
@@ -611,8 +793,31 @@ namespace nvrhi
 
         CpuAccessMode cpuAccess = CpuAccessMode::None;
 
+        // Places a CpuAccessMode::Write buffer into memory that is both CPU-writable and local to the GPU,
+        // so that the GPU doesn't read it over PCIe and no staging copy is needed.
+        // Uses D3D12_HEAP_TYPE_GPU_UPLOAD on DX12 and DEVICE_LOCAL | HOST_VISIBLE memory (ReBAR) on Vulkan.
+        // This is a hint: when Feature::DeviceLocalUploadHeap is not supported or that memory is exhausted,
+        // the buffer is created in regular upload memory, and the buffer's getDesc().preferDeviceLocal is cleared.
+        // Ignored for volatile buffers. On DX12, these buffers are never evicted by the residency manager.
+        bool preferDeviceLocal = false;
+
         SharedResourceFlags sharedResourceFlags = SharedResourceFlags::None;
 
+        // Residency priority of the buffer memory. Ignored for buffers placed in a heap, which use the heap's priority.
+        ResidencyPriority residencyPriority = ResidencyPriority::Normal;
+
+        // Other linked-adapter nodes that can access the buffer, see TextureDesc::visibleNodeMask.
+        uint32_t visibleNodeMask = 0;
+
+        // Enables automatic liveness tracking of this buffer by nvrhi command lists, see BindingSetDesc::trackLiveness.
+        bool trackLiveness = true;
+
+        // Guarantees that IBuffer::getGpuVirtualAddress returns a valid address for the buffer, so that shaders
+        // can access it through that address, e.g. for vertex pulling without a descriptor per buffer.
+        // Buffer creation fails when Feature::GpuVirtualAddress is not supported. Cannot be combined with isVolatile.
+        // Addresses are not tracked by command lists: keep the buffer alive while the GPU may still use its address.
+        bool isGpuAddressable = false;
+
         constexpr BufferDesc& setByteSize(uint64_t value) { byteSize = value; return *this; }
         constexpr BufferDesc& setStructStride(uint32_t value) { structStride = value; return *this; }
         constexpr BufferDesc& setMaxVersions(uint32_t value) { maxVersions = value; return *this; }
@@ -628,11 +833,18 @@ namespace nvrhi
         constexpr BufferDesc& setIsAccelStructBuildInput(bool value) { isAccelStructBuildInput = value; return *this; }
         constexpr BufferDesc& setIsAccelStructStorage(bool value) { isAccelStructStorage = value; return *this; }
         constexpr BufferDesc& setIsShaderBindingTable(bool value) { isShaderBindingTable = value; return *this; }
+        constexpr BufferDesc& setIsPredicationBuffer(bool value) { isPredicationBuffer = value; return *this; }
         constexpr BufferDesc& setIsVolatile(bool value) { isVolatile = value; return *this; }
         constexpr BufferDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+        constexpr BufferDesc& setIsTiled(bool value) { isTiled = value; return *this; }
         constexpr BufferDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
         constexpr BufferDesc& setKeepInitialState(bool value) { keepInitialState = value; return *this; }
         constexpr BufferDesc& setCpuAccess(CpuAccessMode value) { cpuAccess = value; return *this; }
+        constexpr BufferDesc& setPreferDeviceLocal(bool value) { preferDeviceLocal = value; return *this; }
+        constexpr BufferDesc& setResidencyPriority(ResidencyPriority value) { residencyPriority = value; return *this; }
+        constexpr BufferDesc& setVisibleNodeMask(uint32_t value) { visibleNodeMask = value; return *this; }
+        constexpr BufferDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
+        constexpr BufferDesc& setIsGpuAddressable(bool value) { isGpuAddressable = value; return *this; }
     };
 
     struct BufferRange
@@ -661,6 +873,11 @@ namespace nvrhi
     {
     public:
         [[nodiscard]] virtual const BufferDesc& getDesc() const = 0;
+
+        // Returns the GPU virtual address of the start of the buffer, or 0 when the buffer has no address:
+        // volatile buffers, virtual buffers without bound memory, and devices without Feature::GpuVirtualAddress.
+        // Backends may return an address for buffers without BufferDesc::isGpuAddressable, but only that flag guarantees it.
+        [[nodiscard]] virtual GpuVirtualAddress getGpuVirtualAddress() const = 0;
     };
 
     typedef RefCountPtr<IBuffer> BufferHandle;
@@ -797,6 +1014,34 @@ namespace nvrhi
 
     typedef RefCountPtr<IShaderLibrary> ShaderLibraryHandle;
 
+    //////////////////////////////////////////////////////////////////////////
+    // Shader Archive
+    //////////////////////////////////////////////////////////////////////////
+
+    class IDevice;
+
+    // A read-only view of an archive file written by nvrhi-scomp with --archive.
+    // The file is memory-mapped and stays mapped until the archive object is destroyed.
+    // Shaders created through the archive reference the mapped bytecode and keep the archive alive.
+    class IShaderArchive : public IResource
+    {
+    public:
+        [[nodiscard]] virtual uint32_t getNumShaders() const = 0;
+
+        // Looks up a shader by its output name in the nvrhi-scomp config file with '/' separators, e.g. "shaders/foo_main.bin",
+        // and the defines of the permutation in config file order, e.g. "A=1 B=2", or null for shaders without defines.
+        // The returned pointer points into the mapped file.
+        virtual bool findShader(const char* name, const char* permutation, const void** ppBytecode, size_t* pSize) const = 0;
+
+        // Finds the shader and creates it with IDevice::createShaderNoCopy. Returns null if the shader is not in the archive.
+        virtual ShaderHandle createShader(IDevice* device, const ShaderDesc& desc, const char* name, const char* permutation = nullptr) = 0;
+    };
+
+    typedef RefCountPtr<IShaderArchive> ShaderArchiveHandle;
+
+    // Maps the archive file into memory and validates its header. Returns null if the file cannot be opened or is not an archive.
+    NVRHI_API ShaderArchiveHandle openShaderArchive(const char* fileName);
+
     //////////////////////////////////////////////////////////////////////////
     // Blend State
     //////////////////////////////////////////////////////////////////////////
@@ -1151,6 +1396,22 @@ namespace nvrhi
         SamplerDesc& setAddressW(SamplerAddressMode mode) { addressW = mode; return *this; }
         SamplerDesc& setAllAddressModes(SamplerAddressMode mode) { addressU = addressV = addressW = mode; return *this; }
         SamplerDesc& setReductionType(SamplerReductionType type) { reductionType = type; return *this; }
+
+        bool operator ==(const SamplerDesc& other) const
+        {
+            return borderColor == other.borderColor
+                && maxAnisotropy == other.maxAnisotropy
+                && mipBias == other.mipBias
+                && minFilter == other.minFilter
+                && magFilter == other.magFilter
+                && mipFilter == other.mipFilter
+                && addressU == other.addressU
+                && addressV == other.addressV
+                && addressW == other.addressW
+                && reductionType == other.reductionType;
+        }
+
+        bool operator !=(const SamplerDesc& other) const { return !(*this == other); }
     };
 
     class ISampler : public IResource 
@@ -1165,12 +1426,58 @@ namespace nvrhi
     // Framebuffer
     //////////////////////////////////////////////////////////////////////////
 
+    // Specifies what happens to the contents of a framebuffer attachment when a render pass begins.
+    // The render pass begins when the framebuffer is bound with setGraphicsState or setMeshletState and
+    // the previously used framebuffer in the command list was different.
+    enum class AttachmentLoadOp : uint8_t
+    {
+        // The previous contents of the attachment are preserved.
+        Load,
+        // The attachment is cleared to the clear value specified in FramebufferAttachment.
+        Clear,
+        // The previous contents of the attachment are undefined, but the application promises
+        // to overwrite every pixel that it reads later. This saves a load on tiled GPUs.
+        DontCare
+    };
+
+    // Specifies what happens to the contents of a framebuffer attachment when a render pass ends,
+    // i.e. when a different framebuffer is bound, or on clearState or close.
+    enum class AttachmentStoreOp : uint8_t
+    {
+        // The rendered contents are written to the attachment texture.
+        Store,
+        // The rendered contents are not needed after the render pass and may be discarded.
+        DontCare,
+        // The multisampled contents are resolved into FramebufferAttachment::resolveTexture,
+        // and the multisampled contents themselves may be discarded.
+        // Only supported on color attachments.
+        Resolve
+    };
+
     struct FramebufferAttachment
     {
         ITexture* texture = nullptr;
         TextureSubresourceSet subresources = TextureSubresourceSet(0, 1, 0, 1);
         Format format = Format::UNKNOWN;
         bool isReadOnly = false;
+
+        // Note: commands that cannot be recorded inside a render pass, such as copies, clears, compute dispatches
+        // or resource state transitions, suspend the render pass. It is resumed with the original contents
+        // preserved, which is incompatible with the DontCare and Resolve store ops on Vulkan and D3D12,
+        // so render passes using those ops should not be interrupted.
+        AttachmentLoadOp loadOp = AttachmentLoadOp::Load;
+        AttachmentStoreOp storeOp = AttachmentStoreOp::Store;
+
+        // Clear values used with AttachmentLoadOp::Clear. Color attachments use clearColor,
+        // depth attachments use clearDepth and clearStencil.
+        Color clearColor;
+        float clearDepth = 1.f;
+        uint8_t clearStencil = 0;
+
+        // The single-sampled texture that receives the data with AttachmentStoreOp::Resolve.
+        // Must have the same format and dimensions as the attachment texture.
+        ITexture* resolveTexture = nullptr;
+        TextureSubresourceSet resolveSubresources = TextureSubresourceSet(0, 1, 0, 1);
         
         constexpr FramebufferAttachment& setTexture(ITexture* t) { texture = t; return *this; }
         constexpr FramebufferAttachment& setSubresources(TextureSubresourceSet value) { subresources = value; return *this; }
@@ -1179,6 +1486,15 @@ namespace nvrhi
         constexpr FramebufferAttachment& setMipLevel(MipLevel level) { subresources.baseMipLevel = level; subresources.numMipLevels = 1; return *this; }
         constexpr FramebufferAttachment& setFormat(Format f) { format = f; return *this; }
         constexpr FramebufferAttachment& setReadOnly(bool ro) { isReadOnly = ro; return *this; }
+        constexpr FramebufferAttachment& setLoadOp(AttachmentLoadOp value) { loadOp = value; return *this; }
+        constexpr FramebufferAttachment& setStoreOp(AttachmentStoreOp value) { storeOp = value; return *this; }
+        constexpr FramebufferAttachment& setClearColor(const Color& value) { clearColor = value; loadOp = AttachmentLoadOp::Clear; return *this; }
+        constexpr FramebufferAttachment& setClearDepthStencil(float depth, uint8_t stencil = 0) { clearDepth = depth; clearStencil = stencil; loadOp = AttachmentLoadOp::Clear; return *this; }
+        constexpr FramebufferAttachment& setResolveTexture(ITexture* t) { resolveTexture = t; storeOp = AttachmentStoreOp::Resolve; return *this; }
+        constexpr FramebufferAttachment& setResolveSubresources(TextureSubresourceSet value) { resolveSubresources = value; return *this; }
+
+        // Returns true if the attachment uses anything other than the default Load and Store ops.
+        [[nodiscard]] bool hasNonDefaultOps() const { return loadOp != AttachmentLoadOp::Load || storeOp != AttachmentStoreOp::Store; }
 
         [[nodiscard]] bool valid() const { return texture != nullptr; }
     };
@@ -1253,6 +1569,8 @@ namespace nvrhi
     public:
         [[nodiscard]] virtual const FramebufferDesc& getDesc() const = 0;
         [[nodiscard]] virtual const FramebufferInfoEx& getFramebufferInfo() const = 0;
+        // Returns std::hash<FramebufferInfo> of getFramebufferInfo(), computed once when the framebuffer is created.
+        [[nodiscard]] virtual size_t getFramebufferInfoHash() const = 0;
     };
 
     typedef RefCountPtr<IFramebuffer> FramebufferHandle;
@@ -1515,6 +1833,15 @@ namespace nvrhi
             bool isTopLevel = false;
             bool isVirtual = false;
 
+            // TLAS only: keeps the instance data in a GPU buffer owned by the TLAS between builds,
+            // see ICommandList::buildTopLevelAccelStructFromDirtyRanges.
+            bool persistentInstanceBuffer = false;
+
+            // BLAS only: places the AS storage in a large buffer shared with other BLAS'es instead of a dedicated buffer,
+            // which avoids the per-buffer alignment and allocation overhead for many small BLAS'es.
+            // getNativeObject then returns the shared buffer. Incompatible with isVirtual.
+            bool allowSuballocation = false;
+
             AccelStructDesc& setTopLevelMaxInstances(size_t value) { topLevelMaxInstances = value; isTopLevel = true; return *this; }
             AccelStructDesc& addBottomLevelGeometry(const GeometryDesc& value) { bottomLevelGeometries.push_back(value); isTopLevel = false; return *this; }
             AccelStructDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
@@ -1522,6 +1849,31 @@ namespace nvrhi
             AccelStructDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
             AccelStructDesc& setIsTopLevel(bool value) { isTopLevel = value; return *this; }
             AccelStructDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+            AccelStructDesc& setPersistentInstanceBuffer(bool value) { persistentInstanceBuffer = value; return *this; }
+            AccelStructDesc& setAllowSuballocation(bool value) { allowSuballocation = value; return *this; }
+        };
+
+        // A range of TLAS instances, see ICommandList::buildTopLevelAccelStructFromDirtyRanges.
+        struct InstanceRange
+        {
+            size_t firstInstance = 0;
+            size_t numInstances = 0;
+
+            InstanceRange& setFirstInstance(size_t value) { firstInstance = value; return *this; }
+            InstanceRange& setNumInstances(size_t value) { numInstances = value; return *this; }
+        };
+
+        // One BLAS build in a batch, see ICommandList::buildBottomLevelAccelStructs.
+        struct BottomLevelBuildDesc
+        {
+            IAccelStruct* accelStruct = nullptr;
+            const GeometryDesc* geometries = nullptr;
+            size_t numGeometries = 0;
+            AccelStructBuildFlags buildFlags = AccelStructBuildFlags::None;
+
+            BottomLevelBuildDesc& setAccelStruct(IAccelStruct* value) { accelStruct = value; return *this; }
+            BottomLevelBuildDesc& setGeometries(const GeometryDesc* value, size_t count) { geometries = value; numGeometries = count; return *this; }
+            BottomLevelBuildDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
         };
 
         //////////////////////////////////////////////////////////////////////////
@@ -1570,16 +1922,23 @@ namespace nvrhi
         uint32_t slot;
 
         ResourceType type : 8;
-        uint8_t unused : 8;
+        // DX12 only: bind the buffer directly through a root SRV, UAV or CBV instead of a descriptor table.
+        // Valid for StructuredBuffer_SRV/UAV, RawBuffer_SRV/UAV and ConstantBuffer. Root descriptors have no
+        // bounds checking, and the bound range starts at BufferRange::byteOffset. Ignored on other APIs.
+        uint8_t rootDescriptor : 1;
+        uint8_t unused : 7;
         uint16_t size : 16;
 
         bool operator ==(const BindingLayoutItem& b) const {
             return slot == b.slot
                 && type == b.type
+                && rootDescriptor == b.rootDescriptor
                 && size == b.size;
         }
         bool operator !=(const BindingLayoutItem& b) const { return !(*this == b); }
 
+        BindingLayoutItem& setRootDescriptor(bool value) { rootDescriptor = value ? 1 : 0; return *this; }
+
 
         // Helper functions for strongly typed initialization
 #define NVRHI_BINDING_LAYOUT_ITEM_INITIALIZER(TYPE) /* NOLINT(cppcoreguidelines-macro-usage) */ \
@@ -1648,12 +2007,20 @@ namespace nvrhi
         //   The motivation for such validation is that DXC maps register spaces to Vulkan descriptor sets by default.
         bool registerSpaceIsDescriptorSet = false;
 
+        // Requests that the binding sets using this layout are pushed into the command buffer at bind time
+        // (VK_KHR_push_descriptor) instead of being allocated from descriptor pools. This is cheaper for small sets
+        // that change on every draw. It is a hint: it is ignored on DX11 and DX12, when Feature::PushDescriptors
+        // is not supported, and for layouts with volatile constant buffers or more than 32 bindings.
+        // A pipeline may use at most one layout with push descriptors.
+        bool usePushDescriptors = false;
+
         BindingLayoutItemArray bindings;
         VulkanBindingOffsets bindingOffsets;
 
         BindingLayoutDesc& setVisibility(ShaderType value) { visibility = value; return *this; }
         BindingLayoutDesc& setRegisterSpace(uint32_t value) { registerSpace = value; return *this; }
         BindingLayoutDesc& setRegisterSpaceIsDescriptorSet(bool value) { registerSpaceIsDescriptorSet = value; return *this; }
+        BindingLayoutDesc& setUsePushDescriptors(bool value) { usePushDescriptors = value; return *this; }
         BindingLayoutDesc& addItem(const BindingLayoutItem& value) { bindings.push_back(value); return *this; }
         BindingLayoutDesc& setBindingOffsets(const VulkanBindingOffsets& value) { bindingOffsets = value; return *this; }
     };
@@ -1664,16 +2031,31 @@ namespace nvrhi
     // access different types of resources stored in the table through different arrays.
     // The `registerSpaces` vector specifies which spaces will the table be bound to,
     // with the table type (SRV or UAV) derived from the resource type assigned to each space.
+    enum class BindlessLayoutType : uint8_t
+    {
+        // Descriptor tables are bound to the register spaces listed in the layout.
+        RegisterSpaces,
+
+        // DX12 only, requires Feature::HeapDirectlyIndexed. The root signature is created with
+        // the CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED flag and has no parameters for this layout.
+        // Descriptor tables occupy a fixed range of the shader-visible heap that doesn't move when
+        // they're resized, and shaders access them through ResourceDescriptorHeap[] using
+        // IDescriptorTable::getFirstDescriptorIndexInHeap() as the base index.
+        DirectlyIndexed
+    };
+
     struct BindlessLayoutDesc
     {
         ShaderType visibility = ShaderType::None;
         uint32_t firstSlot = 0;
         uint32_t maxCapacity = 0;
+        BindlessLayoutType layoutType = BindlessLayoutType::RegisterSpaces;
         static_vector<BindingLayoutItem, 16> registerSpaces;
 
         BindlessLayoutDesc& setVisibility(ShaderType value) { visibility = value; return *this; }
         BindlessLayoutDesc& setFirstSlot(uint32_t value) { firstSlot = value; return *this; }
         BindlessLayoutDesc& setMaxCapacity(uint32_t value) { maxCapacity = value; return *this; }
+        BindlessLayoutDesc& setLayoutType(BindlessLayoutType value) { layoutType = value; return *this; }
         BindlessLayoutDesc& addRegisterSpace(const BindingLayoutItem& value) { registerSpaces.push_back(value); return *this; }
     };
 
@@ -1682,6 +2064,8 @@ namespace nvrhi
     public:
         [[nodiscard]] virtual const BindingLayoutDesc* getDesc() const = 0;           // returns nullptr for bindless layouts
         [[nodiscard]] virtual const BindlessLayoutDesc* getBindlessDesc() const = 0;  // returns nullptr for regular layouts
+        // Returns the std::hash of the regular or bindless layout desc, computed once when the layout is created.
+        [[nodiscard]] virtual size_t getDescHash() const = 0;
     };
 
     typedef RefCountPtr<IBindingLayout> BindingLayoutHandle;
@@ -1976,6 +2360,10 @@ namespace nvrhi
     {
     public:
         [[nodiscard]] virtual uint32_t getCapacity() const = 0;
+
+        // Returns the index of the table's first descriptor in the shader-visible heap on DX12, 0 otherwise.
+        // Only stable across resizeDescriptorTable(...) calls for BindlessLayoutType::DirectlyIndexed tables.
+        [[nodiscard]] virtual uint32_t getFirstDescriptorIndexInHeap() const = 0;
     };
 
     typedef RefCountPtr<IDescriptorTable> DescriptorTableHandle;
@@ -2110,6 +2498,8 @@ namespace nvrhi
     public:
         [[nodiscard]] virtual const GraphicsPipelineDesc& getDesc() const = 0;
         [[nodiscard]] virtual const FramebufferInfo& getFramebufferInfo() const = 0;
+        // Returns std::hash<FramebufferInfo> of getFramebufferInfo(), computed once when the pipeline is created.
+        [[nodiscard]] virtual size_t getFramebufferInfoHash() const = 0;
     };
 
     typedef RefCountPtr<IGraphicsPipeline> GraphicsPipelineHandle;
@@ -2159,6 +2549,8 @@ namespace nvrhi
     public:
         [[nodiscard]] virtual const MeshletPipelineDesc& getDesc() const = 0;
         [[nodiscard]] virtual const FramebufferInfo& getFramebufferInfo() const = 0;
+        // Returns std::hash<FramebufferInfo> of getFramebufferInfo(), computed once when the pipeline is created.
+        [[nodiscard]] virtual size_t getFramebufferInfoHash() const = 0;
     };
 
     typedef RefCountPtr<IMeshletPipeline> MeshletPipelineHandle;
@@ -2173,6 +2565,61 @@ namespace nvrhi
     class ITimerQuery : public IResource { };
     typedef RefCountPtr<ITimerQuery> TimerQueryHandle;
 
+    enum class QueryType : uint8_t
+    {
+        // Number of samples that passed the depth and stencil tests
+        Occlusion,
+        // Nonzero if any samples passed, can be cheaper than Occlusion
+        BinaryOcclusion,
+        // Shader invocation and primitive counts, resolved as PipelineStatistics structures
+        PipelineStatistics
+    };
+
+    struct QueryPoolDesc
+    {
+        QueryType type = QueryType::Occlusion;
+        uint32_t count = 0;
+        std::string debugName;
+
+        constexpr QueryPoolDesc& setType(QueryType value) { type = value; return *this; }
+        constexpr QueryPoolDesc& setCount(uint32_t value) { count = value; return *this; }
+                  QueryPoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Layout of one PipelineStatistics query written by ICommandList::resolveQueries,
+    // which is the same as D3D12_QUERY_DATA_PIPELINE_STATISTICS and the Vulkan result with all statistics enabled.
+    // Occlusion and BinaryOcclusion queries are resolved as one uint64_t each.
+    struct PipelineStatistics
+    {
+        uint64_t inputVertices = 0;
+        uint64_t inputPrimitives = 0;
+        uint64_t vertexShaderInvocations = 0;
+        uint64_t geometryShaderInvocations = 0;
+        uint64_t geometryShaderPrimitives = 0;
+        uint64_t clippingInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t pixelShaderInvocations = 0;
+        uint64_t hullShaderInvocations = 0;
+        uint64_t domainShaderInvocations = 0;
+        uint64_t computeShaderInvocations = 0;
+    };
+
+    // A fixed-size array of GPU queries of one type, see ICommandList::beginQuery. Not supported on D3D11.
+    class IQueryPool : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const QueryPoolDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<IQueryPool> QueryPoolHandle;
+
+    enum class PredicationOp : uint8_t
+    {
+        // Rendering and dispatches are skipped when the predicate is zero, e.g. when an occlusion query found no samples
+        SkipIfZero,
+        SkipIfNotZero
+    };
+
     struct VertexBufferBinding
     {
         IBuffer* buffer = nullptr;
@@ -2212,6 +2659,7 @@ namespace nvrhi
     };
 
     typedef static_vector<IBindingSet*, c_MaxBindingLayouts> BindingSetVector;
+    typedef static_vector<VertexBufferBinding, c_MaxVertexAttributes> VertexBufferBindingVector;
 
 
     struct GraphicsState
@@ -2225,7 +2673,7 @@ namespace nvrhi
 
         BindingSetVector bindings;
 
-        static_vector<VertexBufferBinding, c_MaxVertexAttributes> vertexBuffers;
+        VertexBufferBindingVector vertexBuffers;
         IndexBufferBinding indexBuffer;
 
         IBuffer* indirectParams = nullptr;
@@ -2286,6 +2734,18 @@ namespace nvrhi
         constexpr DrawIndexedIndirectArguments& setStartInstanceLocation(uint32_t value) { startInstanceLocation = value; return *this; }
     };
 
+    // Matches D3D12_DISPATCH_MESH_ARGUMENTS and VkDrawMeshTasksIndirectCommandEXT
+    struct DispatchMeshIndirectArguments
+    {
+        uint32_t groupsX = 1;
+        uint32_t groupsY = 1;
+        uint32_t groupsZ = 1;
+
+        constexpr DispatchMeshIndirectArguments& setGroupsX(uint32_t value) { groupsX = value; return *this; }
+        constexpr DispatchMeshIndirectArguments& setGroupsY(uint32_t value) { groupsY = value; return *this; }
+        constexpr DispatchMeshIndirectArguments& setGroupsZ(uint32_t value) { groupsZ = value; return *this; }
+    };
+
     struct ComputeState
     {
         IComputePipeline* pipeline = nullptr;
@@ -2319,9 +2779,112 @@ namespace nvrhi
         MeshletState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         MeshletState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         MeshletState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        MeshletState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
         MeshletState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+    // Indirect Commands
+    //////////////////////////////////////////////////////////////////////////
+
+    enum class IndirectArgumentType : uint8_t
+    {
+        // Commands, exactly one of these must be the last argument of a signature
+        Draw,           // DrawIndirectArguments
+        DrawIndexed,    // DrawIndexedIndirectArguments
+        Dispatch,       // uint32_t groupsX, groupsY, groupsZ
+        DispatchMesh,   // DispatchMeshIndirectArguments
+
+        // State changes, DX12 only
+        VertexBuffer,   // IndirectVertexBufferView
+        IndexBuffer,    // IndirectIndexBufferView
+        PushConstants   // 'size' bytes written at 'offset' into the push constant block of the pipeline
+    };
+
+    struct IndirectArgumentDesc
+    {
+        IndirectArgumentType type = IndirectArgumentType::Draw;
+        uint32_t slot = 0;   // VertexBuffer: the vertex buffer slot
+        uint32_t offset = 0; // PushConstants: byte offset into the push constant block, multiple of 4
+        uint32_t size = 0;   // PushConstants: byte size, multiple of 4
+
+        static IndirectArgumentDesc Command(IndirectArgumentType type)
+        {
+            IndirectArgumentDesc result;
+            result.type = type;
+            return result;
+        }
+
+        static IndirectArgumentDesc VertexBuffer(uint32_t slot)
+        {
+            IndirectArgumentDesc result;
+            result.type = IndirectArgumentType::VertexBuffer;
+            result.slot = slot;
+            return result;
+        }
+
+        static IndirectArgumentDesc IndexBuffer()
+        {
+            IndirectArgumentDesc result;
+            result.type = IndirectArgumentType::IndexBuffer;
+            return result;
+        }
+
+        static IndirectArgumentDesc PushConstants(uint32_t offset, uint32_t size)
+        {
+            IndirectArgumentDesc result;
+            result.type = IndirectArgumentType::PushConstants;
+            result.offset = offset;
+            result.size = size;
+            return result;
+        }
+    };
+
+    // Matches D3D12_VERTEX_BUFFER_VIEW
+    struct IndirectVertexBufferView
+    {
+        uint64_t gpuAddress = 0;
+        uint32_t sizeInBytes = 0;
+        uint32_t strideInBytes = 0;
+    };
+
+    // Matches D3D12_INDEX_BUFFER_VIEW, 'nativeFormat' is DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+    struct IndirectIndexBufferView
+    {
+        uint64_t gpuAddress = 0;
+        uint32_t sizeInBytes = 0;
+        uint32_t nativeFormat = 0;
+    };
+
+    struct CommandSignatureDesc
+    {
+        // Each command record contains the arguments in this order, tightly packed
+        static_vector<IndirectArgumentDesc, c_MaxIndirectArguments> arguments;
+
+        // Distance between command records, 0 means the packed size of the arguments
+        uint32_t byteStride = 0;
+
+        // DX12: the pipeline that the commands are executed with, required when the signature has PushConstants arguments.
+        // Set at most one of these.
+        IGraphicsPipeline* graphicsPipeline = nullptr;
+        IMeshletPipeline* meshletPipeline = nullptr;
+        IComputePipeline* computePipeline = nullptr;
+
+        CommandSignatureDesc& addArgument(const IndirectArgumentDesc& value) { arguments.push_back(value); return *this; }
+        CommandSignatureDesc& setByteStride(uint32_t value) { byteStride = value; return *this; }
+        CommandSignatureDesc& setGraphicsPipeline(IGraphicsPipeline* value) { graphicsPipeline = value; return *this; }
+        CommandSignatureDesc& setMeshletPipeline(IMeshletPipeline* value) { meshletPipeline = value; return *this; }
+        CommandSignatureDesc& setComputePipeline(IComputePipeline* value) { computePipeline = value; return *this; }
+    };
+
+    class ICommandSignature : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const CommandSignatureDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<ICommandSignature> CommandSignatureHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // Ray Tracing
     //////////////////////////////////////////////////////////////////////////
@@ -2375,19 +2938,59 @@ namespace nvrhi
             PipelineDesc& setHlslExtensionsUAV(int32_t value) { hlslExtensionsUAV = value; return *this; }
         };
 
+        struct ShaderTableDesc
+        {
+            // Keeps the table records in a device-local buffer owned by the table, and only copies
+            // the records that changed since the previous setRayTracingState with the table on the same
+            // command list into it instead of uploading the whole table again. The first use on each
+            // command list copies all records. Currently only implemented on D3D12; other backends
+            // treat cached tables as regular ones.
+            bool isCached = false;
+
+            // Initial capacity of a cached table, in records (ray generation + miss + hit + callable).
+            // The buffer is recreated with a larger size when the table outgrows it.
+            uint32_t maxEntries = 0;
+
+            // Creates the buffer of a cached table with UAV access so that the application can write
+            // records on the GPU, see IShaderTable::getBuffer. Records added with a null export name
+            // are reserved for such writes and never written by NVRHI.
+            bool allowGpuWrites = false;
+
+            std::string debugName;
+
+            ShaderTableDesc& setIsCached(bool value) { isCached = value; return *this; }
+            ShaderTableDesc& setMaxEntries(uint32_t value) { maxEntries = value; return *this; }
+            ShaderTableDesc& setAllowGpuWrites(bool value) { allowGpuWrites = value; return *this; }
+            ShaderTableDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+        };
+
         class IPipeline;
 
         class IShaderTable : public IResource
         {
         public:
+            [[nodiscard]] virtual const ShaderTableDesc& getDesc() const = 0;
             virtual void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
+
+            // Replace a single existing record. On cached tables, only that record is copied
+            // into the table buffer on the next setRayTracingState.
+            virtual bool setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            virtual bool setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            virtual bool setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+
             virtual void clearMissShaders() = 0;
             virtual void clearHitShaders() = 0;
             virtual void clearCallableShaders() = 0;
             virtual IPipeline* getPipeline() = 0;
+
+            // Returns the buffer holding the records of a cached table, or nullptr for regular tables.
+            // Records are laid out as ray generation, miss, hit and callable records, each
+            // IPipeline::getShaderTableEntrySize() bytes apart and starting with the identifier from
+            // IPipeline::getShaderIdentifier. The buffer changes when the table grows past its capacity.
+            [[nodiscard]] virtual IBuffer* getBuffer() const = 0;
         };
 
         typedef RefCountPtr<IShaderTable> ShaderTableHandle;
@@ -2397,6 +3000,12 @@ namespace nvrhi
         public:
             [[nodiscard]] virtual const rt::PipelineDesc& getDesc() const = 0;
             virtual ShaderTableHandle createShaderTable() = 0;
+            virtual ShaderTableHandle createShaderTable(const ShaderTableDesc& desc) = 0;
+
+            // Size of a shader table record, and the shader identifier that starts the record
+            // for the given export. Used to fill shader tables on the GPU.
+            [[nodiscard]] virtual uint32_t getShaderTableEntrySize() const = 0;
+            [[nodiscard]] virtual const void* getShaderIdentifier(const char* exportName) = 0;
         };
 
         typedef RefCountPtr<IPipeline> PipelineHandle;
@@ -2424,6 +3033,99 @@ namespace nvrhi
         };
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    // Work Graphs
+    //////////////////////////////////////////////////////////////////////////
+
+    // A work graph program, built from node shaders in one or more shader libraries (lib_6_8 or newer).
+    // Producer nodes launch their consumers on the GPU without going through memory and extra dispatches.
+    // Requires Feature::WorkGraphs, currently only implemented on DX12.
+    struct WorkGraphDesc
+    {
+        // All nodes exported by the libraries are added to the graph. The nodes that no other node
+        // outputs to become the entry points, see IWorkGraph::getEntryPointIndex.
+        std::vector<ShaderLibraryHandle> libraries;
+        BindingLayoutVector globalBindingLayouts;
+
+        // Size of the backing memory buffer that is created with the graph and used when
+        // WorkGraphState::backingMemory is null. The size is clamped to the range from
+        // IWorkGraph::getBackingMemoryRequirements; 0 selects the minimum, ~0 the maximum.
+        uint64_t backingMemorySize = 0;
+
+        // Skips the creation of the backing memory buffer, every WorkGraphState must provide one then.
+        bool createBackingMemory = true;
+
+        std::string debugName;
+
+        WorkGraphDesc& addLibrary(IShaderLibrary* value) { libraries.push_back(value); return *this; }
+        WorkGraphDesc& addBindingLayout(IBindingLayout* value) { globalBindingLayouts.push_back(value); return *this; }
+        WorkGraphDesc& setBackingMemorySize(uint64_t value) { backingMemorySize = value; return *this; }
+        WorkGraphDesc& setCreateBackingMemory(bool value) { createBackingMemory = value; return *this; }
+        WorkGraphDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    struct WorkGraphMemoryRequirements
+    {
+        uint64_t minSize = 0;
+        uint64_t maxSize = 0;
+        uint64_t sizeGranularity = 0;
+    };
+
+    class IWorkGraph : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const WorkGraphDesc& getDesc() const = 0;
+        [[nodiscard]] virtual const WorkGraphMemoryRequirements& getBackingMemoryRequirements() const = 0;
+
+        // The backing memory buffer created with the graph, or nullptr if WorkGraphDesc::createBackingMemory is false.
+        // Command lists that execute at the same time must not use the same backing memory.
+        [[nodiscard]] virtual IBuffer* getBackingMemory() const = 0;
+
+        // Entry points are identified by their node name and array index, as declared with [NodeId(...)].
+        // Returns ~0u if the node does not exist or is not an entry point of the graph.
+        [[nodiscard]] virtual uint32_t getNumEntryPoints() const = 0;
+        [[nodiscard]] virtual uint32_t getEntryPointIndex(const char* nodeName, uint32_t arrayIndex = 0) const = 0;
+        [[nodiscard]] virtual uint32_t getEntryPointRecordSize(uint32_t entryPointIndex) const = 0;
+    };
+
+    typedef RefCountPtr<IWorkGraph> WorkGraphHandle;
+
+    struct WorkGraphState
+    {
+        IWorkGraph* workGraph = nullptr;
+        BindingSetVector bindings;
+
+        // Buffer with canHaveUAVs and at least getBackingMemoryRequirements().minSize bytes that the graph uses
+        // for its queues and records. Null selects the buffer that was created with the graph.
+        // The memory is initialized when a command list first uses it with a given graph.
+        IBuffer* backingMemory = nullptr;
+
+        WorkGraphState& setWorkGraph(IWorkGraph* value) { workGraph = value; return *this; }
+        WorkGraphState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
+        WorkGraphState& setBackingMemory(IBuffer* value) { backingMemory = value; return *this; }
+    };
+
+    struct DispatchGraphArguments
+    {
+        // Launches numRecords records from CPU memory into the entry point. The records are copied
+        // by dispatchGraph, so the memory can be reused right after the call.
+        uint32_t entryPointIndex = 0;
+        const void* records = nullptr;
+        uint32_t numRecords = 1;
+        uint64_t recordStride = 0; // 0 means tightly packed records, see IWorkGraph::getEntryPointRecordSize
+
+        // Reads the launch from GPU memory instead: the buffer holds a D3D12_NODE_GPU_INPUT structure with
+        // the entry point index, the record count, and the GPU virtual address and stride of the records,
+        // see IBuffer::getGpuVirtualAddress. The input buffer is read like indirect arguments and needs
+        // isDrawIndirectArgs; the buffer that holds the records is not tracked and must be readable by shaders.
+        IBuffer* inputBuffer = nullptr;
+        uint64_t inputOffset = 0;
+
+        DispatchGraphArguments& setEntryPointIndex(uint32_t value) { entryPointIndex = value; return *this; }
+        DispatchGraphArguments& setRecords(const void* data, uint32_t count, uint64_t stride = 0) { records = data; numRecords = count; recordStride = stride; return *this; }
+        DispatchGraphArguments& setInputBuffer(IBuffer* buffer, uint64_t offset = 0) { inputBuffer = buffer; inputOffset = offset; return *this; }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Misc
     //////////////////////////////////////////////////////////////////////////
@@ -2445,7 +3147,19 @@ namespace nvrhi
         VirtualResources,
         ComputeQueue,
         CopyQueue,
-        ConstantBufferRanges
+        ConstantBufferRanges,
+        DrawIndirectCount,
+        TiledResources,
+        SamplerFeedback,
+        PushDescriptors,
+        HeapDirectlyIndexed,
+        DeviceLocalUploadHeap,
+        DirectTextureWrite,
+        OcclusionQueries,
+        PipelineStatisticsQueries,
+        Predication,
+        GpuVirtualAddress,
+        WorkGraphs
     };
 
     enum class MessageSeverity : uint8_t
@@ -2494,9 +3208,11 @@ namespace nvrhi
     {
         // A command list with enableImmediateExecution = true maps to the immediate context on DX11.
         // Two immediate command lists cannot be open at the same time, which is checked by the validation layer.
+        // Other command lists record into a deferred context on DX11 and must be passed to executeCommandLists.
         bool enableImmediateExecution = true;
 
-        // Minimum size of memory chunks created to upload data to the device on DX12.
+        // Minimum size of memory chunks created to upload data to the device on DX12 and Vulkan.
+        // The chunks come from a pool shared by all command lists, see UploadPoolSettings.
         size_t uploadChunkSize = 64 * 1024;
 
         // Minimum size of memory chunks created for AS build scratch buffers.
@@ -2505,6 +3221,10 @@ namespace nvrhi
         // Maximum total memory size used for all AS build scratch buffers owned by this command list.
         size_t scratchMaxMemory = 1024 * 1024 * 1024;
 
+        // Size of the scratch region shared by the builds in one buildBottomLevelAccelStructs call.
+        // The region is never smaller than the largest build's scratch size.
+        size_t blasBatchScratchSize = 64 * 1024 * 1024;
+
         // Type of the queue that this command list is to be executed on.
         // COPY and COMPUTE queues have limited subsets of methods available.
         CommandQueue queueType = CommandQueue::Graphics;
@@ -2513,16 +3233,290 @@ namespace nvrhi
         CommandListParameters& setUploadChunkSize(size_t value) { uploadChunkSize = value; return *this; }
         CommandListParameters& setScratchChunkSize(size_t value) { scratchChunkSize = value; return *this; }
         CommandListParameters& setScratchMaxMemory(size_t value) { scratchMaxMemory = value; return *this; }
+        CommandListParameters& setBlasBatchScratchSize(size_t value) { blasBatchScratchSize = value; return *this; }
         CommandListParameters& setQueueType(CommandQueue value) { queueType = value; return *this; }
     };
+
+    // Counters that a command list collects while recording, see ICommandList::getStatistics.
+    // Collecting them only costs a few increments per command, so they are always enabled.
+    // Indirect commands count as one call regardless of how many draws or dispatches they launch.
+    struct CommandListStatistics
+    {
+        // draw*, dispatchMesh*, and executeIndirect with a draw signature
+        uint32_t drawCalls = 0;
+        // dispatch*, dispatchRays, and executeIndirect with a dispatch signature
+        uint32_t dispatchCalls = 0;
+        // Pipeline state objects bound to the command list
+        uint32_t pipelineBinds = 0;
+        // Binding sets and descriptor tables bound to the command list
+        uint32_t bindingSetBinds = 0;
+        // Texture and buffer barriers generated by automatic or explicit state transitions,
+        // and the required states that were already satisfied and needed no barrier
+        uint32_t barriersEmitted = 0;
+        uint32_t barriersElided = 0;
+        // Descriptors written while recording, i.e. push descriptors on Vulkan.
+        // Binding sets and descriptor tables are filled at creation and are not counted.
+        uint32_t descriptorCopies = 0;
+        // Upload memory chunks acquired and bytes suballocated from them for writeBuffer, writeTexture and similar commands
+        uint32_t uploadChunks = 0;
+        uint64_t uploadBytes = 0;
+        // Objects that the command list keeps alive until it finishes executing
+        uint32_t referencedResources = 0;
+        // Heap allocations made by the command list while recording: recording objects that had to be created because
+        // the pools had none available, and groups of internal containers that had to grow. Once the application has
+        // warmed up, this should stay at zero. Only counted in debug builds of NVRHI (without NDEBUG), zero otherwise.
+        uint32_t recordingAllocations = 0;
+
+        CommandListStatistics& operator+=(const CommandListStatistics& other)
+        {
+            drawCalls += other.drawCalls;
+            dispatchCalls += other.dispatchCalls;
+            pipelineBinds += other.pipelineBinds;
+            bindingSetBinds += other.bindingSetBinds;
+            barriersEmitted += other.barriersEmitted;
+            barriersElided += other.barriersElided;
+            descriptorCopies += other.descriptorCopies;
+            uploadChunks += other.uploadChunks;
+            uploadBytes += other.uploadBytes;
+            referencedResources += other.referencedResources;
+            recordingAllocations += other.recordingAllocations;
+            return *this;
+        }
+    };
+
+    // Settings of the device-global pool of persistently mapped pages that command lists suballocate upload memory from,
+    // see IDevice::setUploadPoolSettings. A frame is the interval between two IDevice::runGarbageCollection calls.
+    struct UploadPoolSettings
+    {
+        // Minimum size of the pages created by the pool; larger uploads get a page of their own size.
+        uint64_t pageSize = 4 * 1024 * 1024;
+
+        // Free pages that have not been used for more than this many frames are released.
+        uint32_t maxIdleFrames = 60;
+
+        // Free pages are also released, least recently used first, while their total size exceeds this limit.
+        uint64_t maxFreeMemory = 64 * 1024 * 1024;
+
+        UploadPoolSettings& setPageSize(uint64_t value) { pageSize = value; return *this; }
+        UploadPoolSettings& setMaxIdleFrames(uint32_t value) { maxIdleFrames = value; return *this; }
+        UploadPoolSettings& setMaxFreeMemory(uint64_t value) { maxFreeMemory = value; return *this; }
+    };
+
+    struct UploadPoolStatistics
+    {
+        // Memory owned by the pool at the time of the query: pages being written, in flight, or free.
+        uint64_t allocatedMemory = 0;
+        uint32_t allocatedPages = 0;
+        uint64_t freeMemory = 0;
+
+        // Peak memory of the pages that were being written or in flight during the last frame.
+        uint64_t frameHighWaterMark = 0;
+
+        // Number of pages created, taken from the free list, and released by trimming during the last frame.
+        uint32_t framePagesCreated = 0;
+        uint32_t framePagesReused = 0;
+        uint32_t framePagesReleased = 0;
+    };
+
+    // Limits the work done by one IDevice::runGarbageCollection(budget) call. The references held by finished
+    // command list instances are released until either limit is reached; the rest is released by the next calls.
+    // A limit of 0 means unlimited.
+    struct GarbageCollectionBudget
+    {
+        // Maximum number of resource references released per call.
+        uint32_t maxReleasedObjects = 0;
+
+        // Approximate maximum time spent releasing references per call. The clock is checked every few dozen
+        // releases, so a single expensive destructor can overrun it.
+        uint32_t maxMicroseconds = 0;
+
+        GarbageCollectionBudget& setMaxReleasedObjects(uint32_t value) { maxReleasedObjects = value; return *this; }
+        GarbageCollectionBudget& setMaxMicroseconds(uint32_t value) { maxMicroseconds = value; return *this; }
+    };
+
+    // Identifies the work submitted by one IDevice::executeCommandLists call: the queue and the instance that the call returned.
+    // Instances of a queue complete in order, so a submission is complete when the queue's completed instance reaches it.
+    // Submissions with instance 0, which executeCommandLists returns on failure and on DX11, count as completed.
+    struct SubmissionPoint
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t instance = 0;
+
+        SubmissionPoint() = default;
+        SubmissionPoint(CommandQueue _queue, uint64_t _instance) : queue(_queue), instance(_instance) { }
+
+        SubmissionPoint& setQueue(CommandQueue value) { queue = value; return *this; }
+        SubmissionPoint& setInstance(uint64_t value) { instance = value; return *this; }
+    };
+
+    // Timeout value for the IDevice::waitFor... functions that makes them wait until the submissions complete.
+    static constexpr uint64_t c_InfiniteTimeout = ~0ull;
+
+    // Invoked by IDevice::notifyOnCompletion.
+    typedef std::function<void()> SubmissionCallback;
+
+    // Video memory budget reported by the OS for the application, in bytes.
+    // "Local" is the memory of a discrete GPU, or all GPU memory on a UMA system; "non-local" is system memory visible to the GPU.
+    // The budget changes at runtime, e.g. when other applications allocate memory, so query it every frame
+    // and keep the usage under the budget to avoid unpredictable paging.
+    struct MemoryBudget
+    {
+        uint64_t localBudget = 0;
+        uint64_t localUsage = 0;
+        uint64_t nonLocalBudget = 0;
+        uint64_t nonLocalUsage = 0;
+
+        // Memory of the allocations that the D3D12 residency manager has evicted, see d3d12::DeviceDesc::enableResidencyManager.
+        uint64_t evictedMemory = 0;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    // IGpuProfiler
+    //////////////////////////////////////////////////////////////////////////
+
+    struct GpuProfilerDesc
+    {
+        // Maximum number of marker scopes recorded in one frame, over all command lists
+        uint32_t maxScopesPerFrame = 4096;
+        // Number of frames that can be recorded or waiting for results at the same time
+        uint32_t maxFramesInFlight = 4;
+
+        constexpr GpuProfilerDesc& setMaxScopesPerFrame(uint32_t value) { maxScopesPerFrame = value; return *this; }
+        constexpr GpuProfilerDesc& setMaxFramesInFlight(uint32_t value) { maxFramesInFlight = value; return *this; }
+    };
+
+    struct GpuProfilerScope
+    {
+        std::string name;
+        CommandQueue queue = CommandQueue::Graphics;
+        // Nesting depth within the command list, 0 for top-level scopes
+        uint32_t depth = 0;
+        // Index of the enclosing scope in GpuProfilerFrame::scopes, or ~0u for top-level scopes
+        uint32_t parentIndex = ~0u;
+        // Times in seconds, relative to the earliest scope of the frame on the same queue
+        double beginTime = 0.0;
+        double endTime = 0.0;
+    };
+
+    struct GpuProfilerFrame
+    {
+        uint64_t frameIndex = 0;
+        // Scopes in depth-first order. Scopes of different command lists follow the order in which the command lists were closed.
+        std::vector<GpuProfilerScope> scopes;
+        // Set when the frame recorded more scopes than GpuProfilerDesc::maxScopesPerFrame, the extra scopes are missing
+        bool overflow = false;
+    };
+
+    // Hierarchical GPU profiler. Command lists that have a profiler set with ICommandList::setGpuProfiler
+    // write a timestamp for each beginMarker/endMarker call into the current frame. The timestamps of a command list
+    // are resolved with one GAPI call per block of queries when the command list is closed. Copy command lists are not profiled.
+    // beginFrame, endFrame and getFrameResults must not be called while profiled command lists are being recorded,
+    // and all command lists recorded for a frame must be executed before endFrame.
+    class IGpuProfiler : public IResource
+    {
+    public:
+        // Starts a new frame. If the frame slot is still in use by the GPU, waits for it, and its results are discarded.
+        virtual void beginFrame() = 0;
+        virtual void endFrame() = 0;
+
+        // Returns the oldest ended frame whose results are available, or false if there is none yet.
+        virtual bool getFrameResults(GpuProfilerFrame& outFrame) = 0;
+    };
+
+    typedef RefCountPtr<IGpuProfiler> GpuProfilerHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // IBreadcrumbBuffer
+    //////////////////////////////////////////////////////////////////////////
+
+    struct BreadcrumbBufferDesc
+    {
+        // Number of 32-bit slots. Each command list writes into the slot selected by its m_GPULog value.
+        uint32_t numSlots = 64;
+        std::string debugName;
+
+        BreadcrumbBufferDesc& setNumSlots(uint32_t value) { numSlots = value; return *this; }
+        BreadcrumbBufferDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Persistently mapped readback memory that command lists write marker IDs into with ICommandList::writeBreadcrumb.
+    // The writes are pipelined with the rest of the GPU work, so breadcrumbs can stay enabled in release builds.
+    // The memory stays mapped after device removal, which makes it possible to find the last marker that each
+    // command list completed before the fault. The contents of a slot are undefined until a marker is written into it.
+    class IBreadcrumbBuffer : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const BreadcrumbBufferDesc& getDesc() const = 0;
+
+        // Returns the last marker ID that the GPU has written into the slot.
+        [[nodiscard]] virtual uint32_t getLastMarker(uint32_t slot) const = 0;
+    };
+
+    typedef RefCountPtr<IBreadcrumbBuffer> BreadcrumbBufferHandle;
     
+    //////////////////////////////////////////////////////////////////////////
+    // ICommandBundle
+    //////////////////////////////////////////////////////////////////////////
+
+    struct CommandBundleDesc
+    {
+        // The framebuffer that all draws of the bundle render into, required.
+        // The bundle can only be executed with this framebuffer.
+        FramebufferHandle framebuffer;
+        std::string debugName;
+
+        CommandBundleDesc& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
+        CommandBundleDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A sequence of graphics draws that is recorded once and replayed with ICommandList::executeBundle.
+    // Maps to D3D12 bundles, Vulkan secondary command buffers and D3D11 deferred command lists.
+    // Bundles don't place barriers: the resource states required by the recorded draws are collected
+    // and set by the executing command list before the bundle runs, when automatic barriers are enabled.
+    // Restrictions: all graphics states must use the framebuffer from the desc and the same viewport state,
+    // volatile constant buffers and variable rate shading are not supported, and a bundle must not be
+    // re-recorded until the command lists that executed it have finished on the GPU.
+    class ICommandBundle : public IResource
+    {
+    public:
+        // Starts recording, discarding the previous contents of the bundle.
+        virtual void open() = 0;
+        virtual void close() = 0;
+
+        virtual void setGraphicsState(const GraphicsState& state) = 0;
+        virtual void setPushConstants(const void* data, size_t byteSize) = 0;
+
+        virtual void draw(const DrawArguments& args) = 0;
+        virtual void drawIndexed(const DrawArguments& args) = 0;
+        virtual void drawIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+        virtual void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+
+        [[nodiscard]] virtual const CommandBundleDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<ICommandBundle> CommandBundleHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // ICommandList
     //////////////////////////////////////////////////////////////////////////
 
+    // Source data of one subresource for the batched ICommandList::writeTexture.
+    struct TextureSubresourceData
+    {
+        const void* data = nullptr;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+
+        TextureSubresourceData& setData(const void* value) { data = value; return *this; }
+        TextureSubresourceData& setRowPitch(size_t value) { rowPitch = value; return *this; }
+        TextureSubresourceData& setDepthPitch(size_t value) { depthPitch = value; return *this; }
+    };
+
     class ICommandList : public IResource
     {
     public:
+        // On Vulkan, the command buffer comes from a command pool owned by the calling thread,
+        // so a command list should be recorded on the thread that opened it.
         virtual void open() = 0;
         virtual void close() = 0;
 
@@ -2537,8 +3531,18 @@ namespace nvrhi
         virtual void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) = 0;
         virtual void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) = 0;
         virtual void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch = 0) = 0;
+
+        // Writes multiple subresources with one upload allocation and one state transition.
+        // The data array is ordered like D3D subresources, mip levels of the first array slice first:
+        // data[arraySlice * numMipLevels + mipLevel], relative to the resolved subresource set.
+        // numSubresources must be equal to numArraySlices * numMipLevels of the resolved set.
+        virtual void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) = 0;
         virtual void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) = 0;
 
+        // Decodes the opaque contents of the first array slice of a sampler feedback texture into an R8_UINT texture,
+        // one texel per mip region. Only supported on D3D12, see IDevice::createSamplerFeedbackTexture.
+        virtual void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) = 0;
+
         virtual void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) = 0;
         virtual void clearBufferUInt(IBuffer* b, uint32_t clearValue) = 0;
         virtual void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) = 0;
@@ -2548,10 +3552,24 @@ namespace nvrhi
         virtual void setPushConstants(const void* data, size_t byteSize) = 0;
 
         virtual void setGraphicsState(const GraphicsState& state) = 0;
+
+        // Replace only the binding sets, or only the vertex and index buffers, of the graphics state set by the last
+        // setGraphicsState call, keeping the pipeline, framebuffer, viewports and dynamic state as they are.
+        // These skip most of the state comparisons done by setGraphicsState and are intended for long sequences of draws
+        // that only differ in their resources. Only valid after setGraphicsState and before any other set[...]State call.
+        virtual void setGraphicsBindings(const BindingSetVector& bindings) = 0;
+        virtual void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) = 0;
+
         virtual void draw(const DrawArguments& args) = 0;
         virtual void drawIndexed(const DrawArguments& args) = 0;
         virtual void drawIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
         virtual void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+
+        // Multi-draw indirect where the number of draws is read from 'countBuffer' as a uint32 at 'countOffsetBytes'
+        // and clamped to 'maxDrawCount'. Arguments are read from GraphicsState::indirectParams at 'paramOffsetBytes'.
+        // Requires Feature::DrawIndirectCount.
+        virtual void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
+        virtual void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
         
         virtual void setComputeState(const ComputeState& state) = 0;
         virtual void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
@@ -2560,13 +3578,44 @@ namespace nvrhi
         virtual void setMeshletState(const MeshletState& state) = 0;
         virtual void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
 
+        // Dispatches 'drawCount' tightly packed DispatchMeshIndirectArguments records read from MeshletState::indirectParams
+        // at 'offsetBytes'. If MeshletState::indirectCountBuffer is set, it provides the actual count at offset 0.
+        // The Count version reads the count from 'countBuffer' and clamps it to 'maxDrawCount'.
+        // On Vulkan, both require VK_EXT_mesh_shader to be enabled on the device.
+        virtual void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+        virtual void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
+
+        // Executes up to 'maxCommandCount' command records laid out as described by 'signature', read from 'argumentBuffer'
+        // at 'argumentOffsetBytes'. If 'countBuffer' is not null, the actual count is read from it as a uint32 at 'countOffsetBytes'.
+        // The graphics, meshlet or compute state matching the signature's command must be set; anything the records don't
+        // change is taken from it. Buffers referenced by VertexBuffer and IndexBuffer arguments are not tracked, the application
+        // must place them into the right states. On Vulkan, only signatures without state changes are supported.
+        virtual void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) = 0;
+
+        // Executes a closed command bundle inside its framebuffer. Ends any render pass of the command list,
+        // and the graphics, compute and other pipeline states are unset afterwards. Graphics command lists only.
+        virtual void executeBundle(ICommandBundle* bundle) = 0;
+
         virtual void setRayTracingState(const rt::State& state) = 0;
         virtual void dispatchRays(const rt::DispatchRaysArguments& args) = 0;
 
+        // Requires Feature::WorkGraphs.
+        virtual void setWorkGraphState(const WorkGraphState& state) = 0;
+        virtual void dispatchGraph(const DispatchGraphArguments& args) = 0;
+
         virtual void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) = 0;
         
         virtual void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Builds or updates multiple BLAS'es at once. The input transitions are committed together, and the builds
+        // share one scratch region of up to CommandListParameters::blasBatchScratchSize bytes: they are sorted by scratch size
+        // and recorded without barriers between them until the region is exhausted, then the region is reused after a single UAV barrier.
+        // Every BLAS may appear only once in a batch.
+        // With RTXMU, the whole batch is passed to RTXMU at once, and compaction of the built BLAS'es
+        // happens in a later compactBottomLevelAccelStructs call, after the builds have completed on the GPU.
+        virtual void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) = 0;
         virtual void compactBottomLevelAccelStructs() = 0;
         virtual void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
@@ -2577,13 +3626,60 @@ namespace nvrhi
         virtual void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
 
+        // A version of buildTopLevelAccelStruct for TLAS'es created with persistentInstanceBuffer = true.
+        // pInstances is the complete array of numInstances instances, but only the instances in dirtyRanges are converted
+        // and uploaded into the persistent instance buffer; the others are expected to be unchanged since the previous build.
+        // Instances beyond the instance count of the previous build are always uploaded.
+        // The TLAS keeps references to the BLAS'es of its persistent instances and transitions each of them once per build.
+        // buildTopLevelAccelStruct on such a TLAS uploads all instances.
+        virtual void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
         virtual void beginTimerQuery(ITimerQuery* query) = 0;
         virtual void endTimerQuery(ITimerQuery* query) = 0;
 
+        // Query pools, see IQueryPool.
+        // Queries must be reset before they're begun, and again after they have been resolved before they're reused.
+        // The reset is required on Vulkan and ignored on DX12, and it ends the current render pass.
+        virtual void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) = 0;
+        // A query must be ended before the framebuffer or the pipeline type changes, and only one query
+        // of each type can be active at a time.
+        virtual void beginQuery(IQueryPool* pool, uint32_t queryIndex) = 0;
+        virtual void endQuery(IQueryPool* pool, uint32_t queryIndex) = 0;
+        // Writes the results of a range of ended queries into the buffer with one GAPI call, see PipelineStatistics
+        // for the layout. The offset must be a multiple of 8. Ends the current render pass.
+        virtual void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) = 0;
+
+        // Makes the following draws and dispatches conditional on a value in a buffer created with
+        // isPredicationBuffer = true. Pass a null buffer to disable predication.
+        // The offset must be a multiple of 8. Changing the predication ends the current render pass.
+        // Requires Feature::Predication.
+        // The set of predicated commands and the predicate size differ between the APIs:
+        // - On DX12, copyBuffer, copyTexture, resolveTexture and the clear commands are skipped as well.
+        //   The internal copies of writeBuffer, writeTexture and shader table updates are not.
+        // - On Vulkan, only draws and dispatches are predicated.
+        // - DX12 reads a 64-bit predicate and Vulkan only the lower 32 bits of it. Both agree on the results of
+        //   BinaryOcclusion queries. An Occlusion query count that is a nonzero multiple of 2^32 reads as zero on Vulkan.
+        // For portable code, predicate only draws and dispatches, preferably on BinaryOcclusion results.
+        virtual void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) = 0;
+
         // Command list range markers
         virtual void beginMarker(const char *name) = 0;
         virtual void endMarker() = 0;
 
+        // Makes subsequent beginMarker/endMarker pairs write GPU timestamps into the profiler's current frame.
+        // The profiler stays set until it's changed, including across open() calls; pass nullptr to stop profiling.
+        // Changing the profiler while markers are open drops the open scopes.
+        virtual void setGpuProfiler(IGpuProfiler* profiler) = 0;
+
+        // Writes the marker ID into the breadcrumb buffer slot selected by m_GPULog once all preceding commands
+        // of the command list have completed, without stalling the pipeline: WriteBufferImmediate on D3D12,
+        // vkCmdWriteBufferMarkerAMD on Vulkan if VK_AMD_buffer_marker is enabled, and vkCmdFillBuffer otherwise,
+        // which is not ordered with the preceding commands and only gives an approximate position.
+        // Nothing is written while m_GPULog is ULLONG_MAX.
+        // Not supported on D3D11.
+        virtual void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) = 0;
+
         // Enables or disables the automatic barrier placement on set[...]State, copy, write, and clear operations.
         // By default, automatic barriers are enabled, but can be optionally disabled to improve CPU performance and/or specific barrier placement.
         // When automatic barriers are disabled, it is application's responsibility to set correct states for all used resources.
@@ -2617,6 +3713,23 @@ namespace nvrhi
         // Flushes the barriers from the pending list into the GAPI command list.
         virtual void commitBarriers() = 0;
 
+        // Split barriers. begin[...]StateTransition commits the pending barriers, starts transitioning the resource
+        // into the new state, and updates the tracked state. end[...]StateTransition completes all transitions started
+        // for the resource. The commands recorded in between must not use the resource, and the GPU can overlap them
+        // with the transition. Transitions that are still open when the command list is closed are completed by close().
+        // On D3D11 and on Vulkan without KHR_synchronization2, the whole transition happens in begin[...]StateTransition.
+        virtual void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) = 0;
+        virtual void endTextureStateTransition(ITexture* texture) = 0;
+        virtual void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) = 0;
+        virtual void endBufferStateTransition(IBuffer* buffer) = 0;
+
+        // Aliasing barriers, for resources placed in memory that other resources have used before, see ITransientResourcePool.
+        // Commits the pending barriers and makes the resource wait for all previous accesses to the memory, made through any resource.
+        // The contents of the resource are undefined after the barrier, so it must be fully written (e.g. cleared) before it is read.
+        // No-op on D3D11.
+        virtual void textureAliasingBarrier(ITexture* texture) = 0;
+        virtual void bufferAliasingBarrier(IBuffer* buffer) = 0;
+
         // Returns the current tracked state of a texture subresource or a buffer.
         virtual ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) = 0;
         virtual ResourceStates getBufferState(IBuffer* buffer) = 0;
@@ -2625,11 +3738,261 @@ namespace nvrhi
         virtual IDevice* getDevice() = 0;
         virtual const CommandListParameters& getDesc() = 0;
 
+        // Returns the counters collected since the last open(). The upload and referenced resource counts are filled in close().
+        // D3D11 only counts draws, dispatches, and pipeline and binding set binds.
+        [[nodiscard]] virtual const CommandListStatistics& getStatistics() const = 0;
+
         uint64_t m_GPULog = ULLONG_MAX; // [rlaw]
     };
 
     typedef RefCountPtr<ICommandList> CommandListHandle;
 
+    //////////////////////////////////////////////////////////////////////////
+    // IPipelineCreationTask
+    //////////////////////////////////////////////////////////////////////////
+
+    enum class PipelineCreationStatus : uint8_t
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    // Represents a pipeline being created by one of the IDevice::create...PipelineAsync functions.
+    // No work is done until a thread calls join() or wait(), which lets the application decide where pipelines are compiled,
+    // for example by spawning getMaxConcurrency() jobs that call join() on a job system.
+    class IPipelineCreationTask : public IResource
+    {
+    public:
+        // Contributes the calling thread to the creation and returns when this thread has no more work to do.
+        // The first caller creates the pipeline. Other callers help compiling ray tracing pipelines on Vulkan
+        // through VK_KHR_deferred_host_operations and return immediately in all other cases.
+        // Returns true if the task has completed, successfully or not.
+        virtual bool join() = 0;
+
+        // Blocks until the task has completed, doing the work on the calling thread if no other thread has started it.
+        virtual void wait() = 0;
+
+        virtual PipelineCreationStatus getStatus() = 0;
+
+        // Returns the number of threads that can currently make progress by calling join().
+        virtual uint32_t getMaxConcurrency() = 0;
+
+        // Return the created pipeline when the status is Ready, or null if it's not ready or is of a different type.
+        virtual GraphicsPipelineHandle getGraphicsPipeline() = 0;
+        virtual ComputePipelineHandle getComputePipeline() = 0;
+        virtual MeshletPipelineHandle getMeshletPipeline() = 0;
+        virtual rt::PipelineHandle getRayTracingPipeline() = 0;
+    };
+
+    typedef RefCountPtr<IPipelineCreationTask> PipelineCreationTaskHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // ITransientResourcePool
+    //////////////////////////////////////////////////////////////////////////
+
+    struct TransientResourcePoolDesc
+    {
+        // Capacity of the heaps created by the pool; larger resources get a heap of their own size.
+        uint64_t heapSize = 64 * 1024 * 1024;
+        std::string debugName;
+
+        TransientResourcePoolDesc& setHeapSize(uint64_t value) { heapSize = value; return *this; }
+        TransientResourcePoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    struct TransientResourcePoolStatistics
+    {
+        // Memory of the heaps owned by the pool.
+        uint64_t heapMemory = 0;
+        uint32_t numHeaps = 0;
+
+        // Total memory of the compiled resources, as it would be without aliasing.
+        uint64_t resourceMemory = 0;
+        uint32_t numResources = 0;
+    };
+
+    // Places short-lived textures and buffers into shared heaps, letting resources with disjoint lifetimes alias the same memory.
+    // Lifetimes are expressed in use points, arbitrary increasing numbers chosen by the application, e.g. render pass indices.
+    //
+    // Usage, once per frame or whenever the set of resources changes:
+    //  - declareTexture / declareBuffer with the first and last use point of every resource;
+    //  - compile() to place the resources and bind their memory;
+    //  - getTexture / getBuffer to get the resources for the declaration IDs;
+    //  - while recording, beginUsePoint(commandList, usePoint) before the commands of each use point
+    //    to place aliasing barriers for the resources whose lifetime begins there.
+    // When the declarations are identical to the previously compiled ones, compile() keeps the existing resources,
+    // so that binding sets and framebuffers created for them remain valid.
+    //
+    // The contents of a resource are undefined at its first use point, and resources should use keepInitialState.
+    // The resources must be used on a single queue. Buffers, render target textures and other textures are placed
+    // in separate heaps, which D3D12 requires on resource heap tier 1.
+    class ITransientResourcePool : public IResource
+    {
+    public:
+        // Declarations return IDs that are used with getTexture and getBuffer after the next compile() call.
+        virtual uint32_t declareTexture(const TextureDesc& desc, uint32_t firstUse, uint32_t lastUse) = 0;
+        virtual uint32_t declareBuffer(const BufferDesc& desc, uint32_t firstUse, uint32_t lastUse) = 0;
+
+        // Places the declared resources and starts a new set of declarations. Returns false if the resources or heaps could not be created.
+        virtual bool compile() = 0;
+
+        virtual ITexture* getTexture(uint32_t id) = 0;
+        virtual IBuffer* getBuffer(uint32_t id) = 0;
+
+        virtual void beginUsePoint(ICommandList* commandList, uint32_t usePoint) = 0;
+
+        virtual TransientResourcePoolStatistics getStatistics() = 0;
+    };
+
+    typedef RefCountPtr<ITransientResourcePool> TransientResourcePoolHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // IStreamingUploader
+    //////////////////////////////////////////////////////////////////////////
+
+    struct StreamingUploaderDesc
+    {
+        // Queue that executes the uploads. Falls back to the graphics queue when the device doesn't have the requested queue.
+        CommandQueue queue = CommandQueue::Copy;
+        std::string debugName;
+
+        StreamingUploaderDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        StreamingUploaderDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Collects texture and buffer writes from any thread and submits them in large batches on a separate queue.
+    // Every write returns a ticket, which identifies the batch that will contain it. Tickets increase monotonically,
+    // and completion of a ticket implies completion of all earlier tickets.
+    //
+    // The source data is copied when the write is made, so the application can release it immediately.
+    // Writes are submitted by flush(), or implicitly by wait() and queueWait() for tickets that are still open.
+    // Completion callbacks are called from update(), on the thread that calls it, once the GPU has finished the batch.
+    //
+    // The destination resources should use keepInitialState, so that they return to their initial state after the upload.
+    // On D3D12, resources written on the copy queue must have initialState = Common, CopySource or CopyDest.
+    // Before the written data is used on another queue, call queueWait(queue, ticket) or wait for the ticket on the CPU.
+    // flush() calls executeCommandLists on the uploader queue, and it must not run concurrently with other
+    // submissions to the same queue.
+    class IStreamingUploader : public IResource
+    {
+    public:
+        virtual uint64_t writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch = 0) = 0;
+        virtual uint64_t writeBuffer(IBuffer* dest, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) = 0;
+
+        // Registers a callback that is called from update() after the ticket is complete.
+        virtual void addCompletionCallback(uint64_t ticket, std::function<void()> callback) = 0;
+
+        // Submits the pending writes and returns the ticket of the submitted batch.
+        virtual uint64_t flush() = 0;
+
+        // Retires the completed batches and calls their completion callbacks.
+        virtual void update() = 0;
+
+        virtual bool isComplete(uint64_t ticket) = 0;
+        virtual void wait(uint64_t ticket) = 0;
+
+        // Makes the work submitted to waitQueue after this call wait for the ticket on the GPU.
+        virtual void queueWait(CommandQueue waitQueue, uint64_t ticket) = 0;
+    };
+
+    typedef RefCountPtr<IStreamingUploader> StreamingUploaderHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // IReadbackRing
+    //////////////////////////////////////////////////////////////////////////
+
+    struct ReadbackRingDesc
+    {
+        uint64_t byteSize = 0;
+        // Number of readback buffers, at least 2. Use one more than the number of frames the GPU may be behind.
+        uint32_t numSlots = 3;
+        std::string debugName;
+
+        ReadbackRingDesc& setByteSize(uint64_t value) { byteSize = value; return *this; }
+        ReadbackRingDesc& setNumSlots(uint32_t value) { numSlots = value; return *this; }
+        ReadbackRingDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A set of readback buffers that are written by the GPU in round-robin order and read by the CPU without stalling.
+    // Typical use, once per frame:
+    //  - acquireBuffer() and record a copy into the returned buffer, then execute the command list;
+    //  - mapOldestCompleted(), which returns nullptr if the GPU hasn't finished any of the pending copies yet;
+    //  - read the data and unmap().
+    // A slot is only considered after the command list that writes it has been executed. When all slots are pending,
+    // acquireBuffer() reuses the oldest one and its data is lost. The ring is not thread-safe.
+    class IReadbackRing : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const ReadbackRingDesc& getDesc() const = 0;
+
+        // Returns the buffer that the next GPU copy should write to, and the serial number of that copy in outSerial.
+        virtual IBuffer* acquireBuffer(uint64_t* outSerial = nullptr) = 0;
+
+        // Maps the oldest slot whose copy has completed and returns its serial number in outSerial.
+        virtual const void* mapOldestCompleted(uint64_t* outSerial = nullptr) = 0;
+        virtual void unmap() = 0;
+    };
+
+    typedef RefCountPtr<IReadbackRing> ReadbackRingHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // IBindingSetCache
+    //////////////////////////////////////////////////////////////////////////
+
+    // Returns existing binding sets for requests with an identical BindingSetDesc and layout instead of creating
+    // new ones. All functions are thread-safe; lookups of different descs rarely contend.
+    //
+    // The cache references its sets weakly: a set leaves the cache when the application releases its last
+    // reference, so the cache doesn't keep the bound resources alive. The exception are pre-warmed sets, which the
+    // cache keeps alive until the next evictUnused() call, so that they survive until the first request.
+    class IBindingSetCache : public IResource
+    {
+    public:
+        virtual BindingSetHandle getOrCreateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) = 0;
+
+        // Creates the sets for the descs that are not in the cache yet, e.g. during a level load.
+        // Different threads can pre-warm different ranges of descs in parallel.
+        virtual void prewarm(const BindingSetDesc* descs, size_t numDescs, IBindingLayout* layout) = 0;
+
+        // Releases the references of the cache to the pre-warmed sets. Returns the number of sets that were
+        // destroyed because nothing else referenced them.
+        virtual size_t evictUnused() = 0;
+
+        [[nodiscard]] virtual size_t getNumCachedSets() = 0;
+    };
+
+    typedef RefCountPtr<IBindingSetCache> BindingSetCacheHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // IMipGenerator
+    //////////////////////////////////////////////////////////////////////////
+
+    // Fills mip chains from their first mip with a 2x2 box filter, using a compute shader that produces
+    // up to 12 mips per dispatch. The textures must be 2D, 2D array, cube or cube array textures with isUAV set
+    // and a non-sRGB color format that supports typed UAV stores. On Vulkan, the device must support
+    // shaderStorageImageWriteWithoutFormat.
+    //
+    // The calls go through the automatic state tracking of the command list: the first mip of each range is put into
+    // ShaderResource and the other mips into UnorderedAccess, and they are left in these states. For textures
+    // of up to 4096x4096 that is all the barriers needed, larger ones take a transition per additional dispatch.
+    // Textures that don't meet the requirements, or have only one mip in the range, are skipped.
+    //
+    // The generator keeps internal buffers that the dispatches use, so command lists using the same generator
+    // must not execute concurrently on different queues. The generator is not thread-safe.
+    class IMipGenerator : public IResource
+    {
+    public:
+        // Generates mips 1 and up of the subresources from mip 0 of the subresources, for each array slice.
+        virtual void generateMips(ICommandList* commandList, ITexture* texture, TextureSubresourceSet subresources = AllSubresources) = 0;
+
+        // Generates the full mip chains of several textures, with all of their transitions placed
+        // before the first dispatch, and without barriers between the dispatches for different textures.
+        virtual void generateMips(ICommandList* commandList, ITexture* const* textures, size_t numTextures) = 0;
+    };
+
+    typedef RefCountPtr<IMipGenerator> MipGeneratorHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // IDevice
     //////////////////////////////////////////////////////////////////////////
@@ -2639,28 +4002,72 @@ namespace nvrhi
     public:
         virtual HeapHandle createHeap(const HeapDesc& d) = 0;
 
+        // Not supported on D3D11.
+        virtual TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) = 0;
+
+        virtual StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) = 0;
+        virtual ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) = 0;
+        virtual BindingSetCacheHandle createBindingSetCache() = 0;
+
+        // Returns nullptr on D3D11, and when NVRHI was built without DXC to compile the mip generation shader.
+        virtual MipGeneratorHandle createMipGenerator() = 0;
+
         virtual TextureHandle createTexture(const TextureDesc& d) = 0;
         virtual MemoryRequirements getTextureMemoryRequirements(ITexture* texture) = 0;
         virtual bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) = 0;
 
+        // Copies data from CPU memory straight into one subresource of the texture, without staging memory,
+        // a command list or a queue submission. Can be called from any thread.
+        // Uses VK_EXT_host_image_copy on Vulkan, not supported on DX11 and DX12, see Feature::DirectTextureWrite.
+        // The texture must be created with allowDirectWrite and keepInitialState, and it must not be in use
+        // by the GPU or by command lists that are being recorded. Returns false if the data wasn't written.
+        virtual bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch = 0) = 0;
+
         virtual TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) = 0;
 
         virtual StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) = 0;
         virtual void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) = 0;
         virtual void unmapStagingTexture(IStagingTexture* tex) = 0;
 
+        // Non-blocking versions of mapStagingTexture and mapBuffer: return nullptr instead of waiting
+        // when the GPU is still using the resource.
+        virtual void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) = 0;
+
         virtual BufferHandle createBuffer(const BufferDesc& d) = 0;
         virtual void *mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess) = 0;
         virtual void unmapBuffer(IBuffer* buffer) = 0;
+        virtual void *tryMapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess) = 0;
         virtual MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) = 0;
         virtual bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) = 0;
 
+        // Tiled resources, see TextureDesc::isTiled and BufferDesc::isTiled. Not supported on D3D11.
+        // getTextureTiling fills up to *subresourceTilingsNum entries, one per standard mip level, and updates the count.
+        // Tile mappings are updated on the given queue, ordered with the command lists executed on it.
+        // On Vulkan, the queue family must support sparse binding, and Feature::TiledResources reports
+        // whether the graphics queue does.
+        virtual void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) = 0;
+        virtual void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
+        virtual void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
+
+        // Creates a sampler feedback texture for the paired texture, bound to shaders as a Texture_UAV.
+        // Only supported on D3D12.
+        virtual TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) = 0;
+
         virtual BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) = 0;
 
         virtual ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) = 0;
         virtual ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) = 0;
         virtual ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) = 0;
+
+        // Versions of createShader and createShaderLibrary that may reference the binary instead of copying it,
+        // e.g. the contents of a memory-mapped IShaderArchive. The binary must stay valid and unchanged while the
+        // returned object exists; the object holds a reference to binaryOwner, if any.
+        // Backends that hand the binary to the driver at creation time ignore binaryOwner.
+        virtual ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner) = 0;
+        virtual ShaderLibraryHandle createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner) = 0;
         
+        // Samplers are interned by the device: identical descriptions return the same sampler object
+        // while the application holds a reference to it. Descriptions with NaN fields are not interned.
         virtual SamplerHandle createSampler(const SamplerDesc& d) = 0;
 
         // Note: vertexShader is only necessary on D3D11, otherwise it may be null
@@ -2680,6 +4087,21 @@ namespace nvrhi
         virtual float getTimerQueryTime(ITimerQuery* query) = 0;
         virtual void resetTimerQuery(ITimerQuery* query) = 0;
 
+        // Creates a query pool, see IQueryPool. PipelineStatistics pools require Feature::PipelineStatisticsQueries.
+        virtual QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) = 0;
+
+        // Creates a GPU profiler - see IGpuProfiler and ICommandList::setGpuProfiler. Not supported on D3D11.
+        virtual GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) = 0;
+
+        // Creates a breadcrumb buffer - see IBreadcrumbBuffer and ICommandList::writeBreadcrumb. Not supported on D3D11.
+        virtual BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) = 0;
+
+        // Creates a layout for indirect command records, see ICommandList::executeIndirect. Not supported on D3D11.
+        virtual CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) = 0;
+
+        // Creates an empty command bundle, see ICommandBundle.
+        virtual CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) = 0;
+
         // Returns the API kind that the RHI backend is running on top of.
         virtual GraphicsAPI getGraphicsAPI() = 0;
         
@@ -2692,11 +4114,42 @@ namespace nvrhi
         virtual MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) = 0;
 
         virtual rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) = 0;
+
+        // Requires Feature::WorkGraphs, see WorkGraphDesc.
+        virtual WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) = 0;
+
+        // Non-blocking versions of the pipeline creation functions, see IPipelineCreationTask.
+        // The task keeps references to the desc contents, the framebuffer and the device until it has completed,
+        // so it can be joined after the application has released the device.
+        // Creation errors are reported to the message callback from the thread that performs the work.
+        // On D3D11, the pipeline is created immediately and the returned task is already complete.
+        virtual PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) = 0;
+        virtual PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) = 0;
+        virtual PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) = 0;
+        virtual PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) = 0;
+
+        // Persistent pipeline cache used by the create*Pipeline functions.
+        // loadPipelineCache replaces the current cache with the contents of a blob previously returned by savePipelineCache,
+        // or with an empty cache when no data is provided. Blobs produced by a different graphics API, device or driver
+        // version are rejected: the function returns false and the device keeps using an empty cache.
+        // savePipelineCache serializes the cache, including the pipelines created since the last load, into outData.
+        // Must not be called concurrently with pipeline creation. Not supported on D3D11; on D3D12, ray tracing pipelines are not cached,
+        // but the serialized root signatures of all pipelines are.
+        virtual bool loadPipelineCache(const void* data, size_t size) = 0;
+        virtual bool savePipelineCache(std::vector<uint8_t>& outData) = 0;
         
         virtual BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) = 0;
         virtual BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) = 0;
 
         virtual BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) = 0;
+
+        // Creates 'count' binding sets that share the same layout, writing them into outBindingSets[0..count-1].
+        // Equivalent to calling createBindingSet for each desc, but cheaper for large batches: on D3D12, the descriptor tables
+        // of all sets are allocated as one contiguous range and copied to the shader-visible heap at once; on Vulkan,
+        // the descriptor writes are generated in parallel and submitted with a single vkUpdateDescriptorSets call.
+        // Returns false if any set couldn't be created, in which case its handle is null and the other sets are still valid.
+        virtual bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) = 0;
+
         virtual DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) = 0;
 
         virtual void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) = 0;
@@ -2708,14 +4161,54 @@ namespace nvrhi
         virtual bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) = 0;
         
         virtual CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) = 0;
+
+        // Submits the command lists to a queue and returns the instance that identifies the submission on that queue.
+        // On DX12 and Vulkan, submissions to different queues may be made concurrently from different threads and don't block
+        // each other; concurrent submissions to the same queue are serialized in an unspecified order. Not thread-safe on DX11.
         virtual uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
         virtual void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) = 0;
         virtual void waitForIdle() = 0;
 
+        // CPU-side waits on the submissions made with executeCommandLists, see SubmissionPoint.
+        // getCompletedInstance returns the last completed instance of the queue, or 0 if the device doesn't have the queue.
+        // waitForAll blocks until all submissions complete and returns false if the timeout (in nanoseconds) expires first.
+        // waitForAny blocks until at least one submission completes and returns its index, or 'count' if the timeout expires.
+        // These functions may be called from any thread; waiting for an instance that hasn't been submitted yet is an error.
+        virtual uint64_t getCompletedInstance(CommandQueue queue) = 0;
+        virtual bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) = 0;
+        virtual size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) = 0;
+
+        // Invokes the callback once all submissions (or any of them, when waitAny is true) have completed.
+        // Callbacks run in order of completion on a thread owned by the device, which sleeps on the GPU fences
+        // while callbacks are pending; they should return quickly, e.g. by scheduling a job, and must not release
+        // the last reference to the device.
+        // Callbacks that are still pending when the device is destroyed run after waitForIdle in the destructor.
+        // Submissions on queues that the device doesn't have, or with an invalid queue, count as completed.
+        virtual void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) = 0;
+
         // Releases the resources that were referenced in the command lists that have finished executing.
         // IMPORTANT: Call this method at least once per frame.
         virtual void runGarbageCollection() = 0;
 
+        // Incremental version of runGarbageCollection that spreads the release of large numbers of references
+        // over several calls. Each call counts as the per-frame call above.
+        // Returns true if all the finished command lists were retired, false if the budget ran out first.
+        virtual bool runGarbageCollection(const GarbageCollectionBudget& budget) = 0;
+
+        // Upload memory used by writeBuffer, writeTexture and other commands that copy data from the CPU.
+        // The pool is trimmed and the statistics are collected in runGarbageCollection. Not supported on D3D11.
+        virtual void setUploadPoolSettings(const UploadPoolSettings& settings) = 0;
+        virtual UploadPoolStatistics getUploadPoolStatistics() = 0;
+
+        // Queries the current memory budget and usage of the device.
+        // Returns false if the budget is not available: on Vulkan, this requires the VK_EXT_memory_budget extension,
+        // and on DX11, a DXGI 1.4 adapter.
+        virtual bool queryMemoryBudget(MemoryBudget& outBudget) = 0;
+
+        // Returns the sum of the statistics of the command lists passed to executeCommandLists
+        // since the device was created or since the last call with reset = true.
+        virtual CommandListStatistics getCommandListStatistics(bool reset = true) = 0;
+
         virtual bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) = 0;
 
         virtual FormatSupport queryFormatSupport(Format format) = 0;
@@ -2739,6 +4232,42 @@ namespace nvrhi
         std::hash<T> hasher;
         seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
+
+    // Hashes a sequence of 64-bit words using the MurmurHash3 x64 block mix and finalizer.
+    // Descriptors that are hashed on hot paths (binding sets, framebuffer infos, blend states)
+    // pack their fields into a few words and feed them here, which is much cheaper than
+    // calling hash_combine for every field.
+    class WordHasher
+    {
+    public:
+        constexpr WordHasher& add(uint64_t word)
+        {
+            word *= 0x87c37b91114253d5ull;
+            word = rotl(word, 31);
+            word *= 0x4cf5ad432745937full;
+            m_State ^= word;
+            m_State = rotl(m_State, 27) * 5 + 0x52dce729;
+            ++m_Count;
+            return *this;
+        }
+
+        [[nodiscard]] constexpr size_t get() const
+        {
+            uint64_t h = m_State ^ (m_Count * 8);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            return size_t(h);
+        }
+
+    private:
+        static constexpr uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+        uint64_t m_State = 0x9e3779b97f4a7c15ull;
+        uint64_t m_Count = 0;
+    };
 }
 
 #undef NVRHI_ENUM_CLASS_FLAG_OPERATORS
@@ -2756,41 +4285,55 @@ namespace std
 
     template<> struct hash<nvrhi::TextureSubresourceSet>
     {
+        static void append(nvrhi::WordHasher& hasher, nvrhi::TextureSubresourceSet const& s)
+        {
+            hasher.add(uint64_t(s.baseMipLevel) | (uint64_t(s.numMipLevels) << 32));
+            hasher.add(uint64_t(s.baseArraySlice) | (uint64_t(s.numArraySlices) << 32));
+        }
+
         std::size_t operator()(nvrhi::TextureSubresourceSet const& s) const noexcept
         {
-            size_t hash = 0;
-            nvrhi::hash_combine(hash, s.baseMipLevel);
-            nvrhi::hash_combine(hash, s.numMipLevels);
-            nvrhi::hash_combine(hash, s.baseArraySlice);
-            nvrhi::hash_combine(hash, s.numArraySlices);
-            return hash;
+            nvrhi::WordHasher hasher;
+            append(hasher, s);
+            return hasher.get();
         }
     };
 
     template<> struct hash<nvrhi::BufferRange>
     {
+        static void append(nvrhi::WordHasher& hasher, nvrhi::BufferRange const& s)
+        {
+            hasher.add(s.byteOffset);
+            hasher.add(s.byteSize);
+        }
+
         std::size_t operator()(nvrhi::BufferRange const& s) const noexcept
         {
-            size_t hash = 0;
-            nvrhi::hash_combine(hash, s.byteOffset);
-            nvrhi::hash_combine(hash, s.byteSize);
-            return hash;
+            nvrhi::WordHasher hasher;
+            append(hasher, s);
+            return hasher.get();
         }
     };
 
     template<> struct hash<nvrhi::BindingSetItem>
     {
+        // The 'unused' bitfield is not initialized by most helpers, so the header word is packed explicitly.
+        static void append(nvrhi::WordHasher& hasher, nvrhi::BindingSetItem const& s)
+        {
+            hasher.add(uint64_t(reinterpret_cast<uintptr_t>(s.resourceHandle)));
+            hasher.add(uint64_t(s.slot)
+                | (uint64_t(s.type) << 32)
+                | (uint64_t(s.dimension) << 40)
+                | (uint64_t(s.format) << 48));
+            hasher.add(s.rawData[0]);
+            hasher.add(s.rawData[1]);
+        }
+
         std::size_t operator()(nvrhi::BindingSetItem const& s) const noexcept
         {
-            size_t value = 0;
-            nvrhi::hash_combine(value, s.resourceHandle);
-            nvrhi::hash_combine(value, s.slot);
-            nvrhi::hash_combine(value, s.type);
-            nvrhi::hash_combine(value, s.dimension);
-            nvrhi::hash_combine(value, s.format);
-            nvrhi::hash_combine(value, s.rawData[0]);
-            nvrhi::hash_combine(value, s.rawData[1]);
-            return value;
+            nvrhi::WordHasher hasher;
+            append(hasher, s);
+            return hasher.get();
         }
     };
 
@@ -2798,41 +4341,120 @@ namespace std
     {
         std::size_t operator()(nvrhi::BindingSetDesc const& s) const noexcept
         {
-            size_t value = 0;
+            nvrhi::WordHasher hasher;
             for (const auto& item : s.bindings)
-                hash_combine(value, item);
-            return value;
+                hash<nvrhi::BindingSetItem>::append(hasher, item);
+            return hasher.get();
         }
     };
 
     template<> struct hash<nvrhi::FramebufferInfo>
     {
+        static_assert(nvrhi::c_MaxRenderTargets <= 8, "all color formats are supposed to fit into one 64-bit word");
+
         std::size_t operator()(nvrhi::FramebufferInfo const& s) const noexcept
+        {
+            uint64_t colorFormats = 0;
+            for (size_t i = 0; i < s.colorFormats.size(); i++)
+                colorFormats |= uint64_t(s.colorFormats[i]) << (i * 8);
+
+            nvrhi::WordHasher hasher;
+            hasher.add(colorFormats);
+            hasher.add(uint64_t(s.colorFormats.size()) | (uint64_t(s.depthFormat) << 8));
+            hasher.add(uint64_t(s.sampleCount) | (uint64_t(s.sampleQuality) << 32));
+            return hasher.get();
+        }
+    };
+
+    template<> struct hash<nvrhi::BindingLayoutItem>
+    {
+        static void append(nvrhi::WordHasher& hasher, nvrhi::BindingLayoutItem const& s)
+        {
+            hasher.add(uint64_t(s.slot)
+                | (uint64_t(s.type) << 32)
+                | (uint64_t(s.rootDescriptor) << 40)
+                | (uint64_t(s.size) << 48));
+        }
+
+        std::size_t operator()(nvrhi::BindingLayoutItem const& s) const noexcept
+        {
+            nvrhi::WordHasher hasher;
+            append(hasher, s);
+            return hasher.get();
+        }
+    };
+
+    template<> struct hash<nvrhi::BindingLayoutDesc>
+    {
+        std::size_t operator()(nvrhi::BindingLayoutDesc const& s) const noexcept
+        {
+            nvrhi::WordHasher hasher;
+            hasher.add(uint64_t(s.visibility) | (uint64_t(s.registerSpace) << 32));
+            hasher.add(uint64_t(s.registerSpaceIsDescriptorSet)
+                | (uint64_t(s.usePushDescriptors) << 1)
+                | (uint64_t(s.bindings.size()) << 32));
+            hasher.add(uint64_t(s.bindingOffsets.shaderResource) | (uint64_t(s.bindingOffsets.sampler) << 32));
+            hasher.add(uint64_t(s.bindingOffsets.constantBuffer) | (uint64_t(s.bindingOffsets.unorderedAccess) << 32));
+            for (const auto& item : s.bindings)
+                hash<nvrhi::BindingLayoutItem>::append(hasher, item);
+            return hasher.get();
+        }
+    };
+
+    template<> struct hash<nvrhi::BindlessLayoutDesc>
+    {
+        std::size_t operator()(nvrhi::BindlessLayoutDesc const& s) const noexcept
+        {
+            nvrhi::WordHasher hasher;
+            hasher.add(uint64_t(s.visibility) | (uint64_t(s.firstSlot) << 32));
+            hasher.add(uint64_t(s.maxCapacity)
+                | (uint64_t(s.layoutType) << 32)
+                | (uint64_t(s.registerSpaces.size()) << 40));
+            for (const auto& item : s.registerSpaces)
+                hash<nvrhi::BindingLayoutItem>::append(hasher, item);
+            return hasher.get();
+        }
+    };
+
+    template<> struct hash<nvrhi::SamplerDesc>
+    {
+        std::size_t operator()(nvrhi::SamplerDesc const& s) const noexcept
         {
             size_t hash = 0;
-            for (auto format : s.colorFormats)
-                nvrhi::hash_combine(hash, format);
-            nvrhi::hash_combine(hash, s.depthFormat);
-            nvrhi::hash_combine(hash, s.sampleCount);
-            nvrhi::hash_combine(hash, s.sampleQuality);
+            nvrhi::hash_combine(hash, s.borderColor.r);
+            nvrhi::hash_combine(hash, s.borderColor.g);
+            nvrhi::hash_combine(hash, s.borderColor.b);
+            nvrhi::hash_combine(hash, s.borderColor.a);
+            nvrhi::hash_combine(hash, s.maxAnisotropy);
+            nvrhi::hash_combine(hash, s.mipBias);
+            nvrhi::hash_combine(hash, s.minFilter);
+            nvrhi::hash_combine(hash, s.magFilter);
+            nvrhi::hash_combine(hash, s.mipFilter);
+            nvrhi::hash_combine(hash, s.addressU);
+            nvrhi::hash_combine(hash, s.addressV);
+            nvrhi::hash_combine(hash, s.addressW);
+            nvrhi::hash_combine(hash, s.reductionType);
             return hash;
         }
     };
 
     template<> struct hash<nvrhi::BlendState::RenderTarget>
     {
+        static uint64_t pack(nvrhi::BlendState::RenderTarget const& s)
+        {
+            return uint64_t(s.blendEnable)
+                | (uint64_t(s.srcBlend) << 8)
+                | (uint64_t(s.destBlend) << 16)
+                | (uint64_t(s.blendOp) << 24)
+                | (uint64_t(s.srcBlendAlpha) << 32)
+                | (uint64_t(s.destBlendAlpha) << 40)
+                | (uint64_t(s.blendOpAlpha) << 48)
+                | (uint64_t(s.colorWriteMask) << 56);
+        }
+
         std::size_t operator()(nvrhi::BlendState::RenderTarget const& s) const noexcept
         {
-            size_t hash = 0;
-            nvrhi::hash_combine(hash, s.blendEnable);
-            nvrhi::hash_combine(hash, s.srcBlend);
-            nvrhi::hash_combine(hash, s.destBlend);
-            nvrhi::hash_combine(hash, s.blendOp);
-            nvrhi::hash_combine(hash, s.srcBlendAlpha);
-            nvrhi::hash_combine(hash, s.destBlendAlpha);
-            nvrhi::hash_combine(hash, s.blendOpAlpha);
-            nvrhi::hash_combine(hash, s.colorWriteMask);
-            return hash;
+            return nvrhi::WordHasher().add(pack(s)).get();
         }
     };
 
@@ -2840,11 +4462,11 @@ namespace std
     {
         std::size_t operator()(nvrhi::BlendState const& s) const noexcept
         {
-            size_t hash = 0;
-            nvrhi::hash_combine(hash, s.alphaToCoverageEnable);
+            nvrhi::WordHasher hasher;
+            hasher.add(uint64_t(s.alphaToCoverageEnable));
             for (const auto& target : s.targets)
-                nvrhi::hash_combine(hash, target);
-            return hash;
+                hasher.add(hash<nvrhi::BlendState::RenderTarget>::pack(target));
+            return hasher.get();
         }
     };
 }
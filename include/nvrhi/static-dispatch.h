@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Direct access to the backend implementation classes in builds with NVRHI_STATIC_DISPATCH=ON, which compile exactly one backend.
+// Calls made through nvrhi::Device and nvrhi::CommandList are resolved at compile time instead of through the vtable,
+// and the backend classes are final, so the compiler can inline hot calls like draw or setPushConstants with LTO.
+//
+// Including this header also includes the backend's internal header, so the application must be compiled with the same
+// backend configuration as NVRHI; CMake propagates it through the backend target. Because of that, the header only works
+// in the build tree, i.e. with add_subdirectory(nvrhi), and not with an installed NVRHI.
+// The objects must be created by the backend device directly: the validation layer wraps them in different classes,
+// which toBackend detects with an assert in debug builds.
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/misc.h>
+
+#if !NVRHI_STATIC_DISPATCH
+#error "nvrhi/static-dispatch.h requires NVRHI to be built with NVRHI_STATIC_DISPATCH=ON"
+#endif
+
+#if NVRHI_STATIC_DISPATCH_D3D11
+#include "d3d11-backend.h"
+#elif NVRHI_STATIC_DISPATCH_D3D12
+#include "d3d12-backend.h"
+#elif NVRHI_STATIC_DISPATCH_VULKAN
+#include "vulkan-backend.h"
+#else
+#error "NVRHI_STATIC_DISPATCH is set without a backend"
+#endif
+
+namespace nvrhi
+{
+#if NVRHI_STATIC_DISPATCH_D3D11
+    namespace backend = d3d11;
+#elif NVRHI_STATIC_DISPATCH_D3D12
+    namespace backend = d3d12;
+#elif NVRHI_STATIC_DISPATCH_VULKAN
+    namespace backend = vulkan;
+#endif
+
+    using Device = backend::Device;
+    using CommandList = backend::CommandList;
+
+    inline Device* toBackend(IDevice* device) { return checked_cast<Device*>(device); }
+    inline CommandList* toBackend(ICommandList* commandList) { return checked_cast<CommandList*>(commandList); }
+}
@@ -100,6 +100,10 @@ namespace nvrhi::utils
     NVRHI_API const char* FormatToString(Format format);
     NVRHI_API const char* CommandQueueToString(CommandQueue queue);
 
+    // Size of one argument in an indirect command record, and the record stride implied by a command signature
+    NVRHI_API uint32_t GetIndirectArgumentSize(const IndirectArgumentDesc& argument);
+    NVRHI_API uint32_t GetCommandSignatureByteStride(const CommandSignatureDesc& desc);
+
     std::string GenerateHeapDebugName(const HeapDesc& desc);
     std::string GenerateTextureDebugName(const TextureDesc& desc);
     std::string GenerateBufferDebugName(const BufferDesc& desc);
@@ -26,5 +26,36 @@
 
 namespace nvrhi::validation
 {
+    enum class ValidationLevel : uint8_t
+    {
+        // All checks on every call
+        Full,
+
+        // Cheap checks only, such as NULL handles, the command list state and queue type, and immediate command list
+        // exclusivity, which don't allocate memory unless they fail. The expensive checks of the state and binding
+        // functions, such as binding set completeness, run for one in fullCheckInterval calls.
+        // Object creation is always fully validated.
+        Lite
+    };
+
+    struct ValidationLayerDesc
+    {
+        ValidationLevel level = ValidationLevel::Full;
+
+        // Only used with ValidationLevel::Lite. 0 disables the expensive command list checks entirely.
+        uint32_t fullCheckInterval = 0;
+
+        // Remembers the address ranges of destroyed BufferDesc::isGpuAddressable buffers and reports data passed to
+        // writeBuffer and setPushConstants that contains such addresses, as part of the expensive command list checks.
+        // The layer notices that a buffer was released on the next executeCommandLists or runGarbageCollection call,
+        // so the destruction of these buffers is deferred until then.
+        bool trackGpuVirtualAddresses = true;
+
+        ValidationLayerDesc& setLevel(ValidationLevel value) { level = value; return *this; }
+        ValidationLayerDesc& setFullCheckInterval(uint32_t value) { fullCheckInterval = value; return *this; }
+        ValidationLayerDesc& setTrackGpuVirtualAddresses(bool value) { trackGpuVirtualAddresses = value; return *this; }
+    };
+
     NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice);
+    NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc);
 }
@@ -35,16 +35,47 @@ namespace nvrhi
 
 namespace nvrhi::vulkan
 {
+    struct MemoryAllocatorStatistics
+    {
+        // Large memory objects that resources are sub-allocated from
+        uint32_t blockCount = 0;
+        uint64_t blockBytes = 0;
+
+        // Resources placed into the blocks and the total size they occupy
+        uint32_t suballocationCount = 0;
+        uint64_t suballocatedBytes = 0;
+
+        // Resources that got their own vkAllocateMemory call (exportable, driver-preferred dedicated, or too large)
+        uint32_t dedicatedAllocationCount = 0;
+        uint64_t dedicatedAllocationBytes = 0;
+
+        // Number of free ranges across all blocks and the size of the largest one, indicating fragmentation
+        uint32_t freeRangeCount = 0;
+        uint64_t largestFreeRange = 0;
+    };
+
     class IDevice : public nvrhi::IDevice
     {
     public:
         // Additional Vulkan-specific public methods
+
+        // Returns the timeline semaphore that the queue signals with the instances returned by executeCommandLists.
+        // Applications can wait on it together with their own semaphores with vkWaitSemaphores, see also IDevice::waitForAny.
         virtual VkSemaphore getQueueSemaphore(CommandQueue queue) = 0;
         virtual void queueWaitForSemaphore(CommandQueue waitQueue, VkSemaphore semaphore, uint64_t value) = 0;
         virtual void queueSignalSemaphore(CommandQueue executionQueue, VkSemaphore semaphore, uint64_t value) = 0;
         virtual uint64_t queueGetCompletedInstance(CommandQueue queue) = 0;
         virtual FramebufferHandle createHandleForNativeFramebuffer(VkRenderPass renderPass, 
             VkFramebuffer framebuffer, const FramebufferDesc& desc, bool transferOwnership) = 0;
+        virtual MemoryAllocatorStatistics getMemoryAllocatorStatistics() = 0;
+
+        // Submits the work that has been deferred with DeviceDesc::deferQueueSubmissions, does nothing otherwise.
+        virtual void flushSubmissions() = 0;
+
+        // Returns a task that links the pipeline again from its graphics pipeline libraries with link-time optimization,
+        // see DeviceDesc::graphicsPipelineLibrarySupported. When the task is complete, commands recorded after that use
+        // the optimized pipeline. For pipelines that weren't linked from libraries, the returned task is already complete.
+        virtual PipelineCreationTaskHandle createOptimizedGraphicsPipelineAsync(IGraphicsPipeline* pipeline) = 0;
     };
 
     typedef RefCountPtr<IDevice> DeviceHandle;
@@ -57,7 +88,13 @@ namespace nvrhi::vulkan
         VkPhysicalDevice physicalDevice;
         VkDevice device;
 
-        // any of the queues can be null if this context doesn't intend to use them
+        // any of the queues can be null if this context doesn't intend to use them.
+        // Buffers and images are created with VK_SHARING_MODE_EXCLUSIVE. When the queues are from different families,
+        // executeCommandLists transfers the queue family ownership of the resources whose states the command lists track.
+        // Resources in a permanent state (setPermanentTextureState / setPermanentBufferState) are not tracked and not
+        // transferred, so use each of them on queues of one family. Resources that are only accessed through descriptor
+        // tables are transferred only when the command list that uses them on the other queue calls setTextureState
+        // or setBufferState on them.
         VkQueue graphicsQueue;
         int graphicsQueueIndex = -1;
         VkQueue transferQueue;
@@ -75,8 +112,48 @@ namespace nvrhi::vulkan
 
         uint32_t maxTimerQueries = 256;
 
+        // Size of the memory blocks that buffers and textures are sub-allocated from.
+        // Resources larger than half of the block size get a dedicated allocation. Set to 0 to disable sub-allocation.
+        uint64_t memoryBlockSize = 64ull * 1024 * 1024;
+
         // Indicates if VkPhysicalDeviceVulkan12Features::bufferDeviceAddress was set to 'true' at device creation time
         bool bufferDeviceAddressSupported = false;
+
+        // Indicates if VkPhysicalDeviceVulkan12Features::drawIndirectCount was set to 'true' at device creation time
+        bool drawIndirectCountSupported = false;
+
+        // Indicates if VkPhysicalDeviceVulkan13Features::dynamicRendering was set to 'true' at device creation time.
+        // With dynamic rendering, which is also used when VK_KHR_dynamic_rendering is enabled, createFramebuffer doesn't
+        // create VkRenderPass and VkFramebuffer objects and graphics pipelines only depend on the attachment formats.
+        // Framebuffers created with createHandleForNativeFramebuffer keep using their render pass.
+        bool dynamicRenderingSupported = false;
+
+        // Indicates if VkPhysicalDeviceDescriptorBufferFeaturesEXT::descriptorBuffer was set to 'true' at device creation time,
+        // with VK_EXT_descriptor_buffer in the device extension list. Binding sets and descriptor tables are then stored
+        // in one host-visible descriptor buffer of descriptorBufferSize bytes instead of descriptor pools: writing
+        // a descriptor copies it into the buffer, and binding a set only sets its offset. Requires bufferDeviceAddress.
+        // Volatile constant buffers and push descriptors are not available in this mode, and robustBufferAccess
+        // must be disabled, because the descriptor sizes for robust access are not used.
+        bool descriptorBufferSupported = false;
+        uint64_t descriptorBufferSize = 64ull * 1024 * 1024;
+
+        // When enabled, executeCommandLists doesn't submit the command lists right away. The submissions of every queue
+        // are accumulated and made with one vkQueueSubmit2 call per queue (or vkQueueSubmit without VK_KHR_synchronization2)
+        // when IDevice::flushSubmissions or runGarbageCollection is called, and before the CPU waits for or polls a submission,
+        // e.g. in getCompletedInstance, waitForAll, waitForAny, pollEventQuery or mapBuffer.
+        // Submission IDs and queueWaitForCommandList dependencies work as without deferral, but submissions that
+        // the application makes outside of NVRHI, such as vkQueuePresentKHR, must be preceded by flushSubmissions.
+        bool deferQueueSubmissions = false;
+
+        // Indicates if VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT::graphicsPipelineLibrary was set to 'true'
+        // at device creation time, with VK_EXT_graphics_pipeline_library and VK_KHR_pipeline_library in the device
+        // extension list. On devices that support fast linking, createGraphicsPipeline then compiles the vertex input,
+        // pre-rasterization, fragment shader and fragment output parts of the pipeline as separate libraries,
+        // which are kept for the lifetime of the device and shared by all pipelines that use the same state for that part,
+        // and links them without link-time optimization. Use IDevice::createOptimizedGraphicsPipelineAsync
+        // to get an optimized version later. Only pipelines for framebuffers without a VkRenderPass,
+        // i.e. with dynamicRenderingSupported, are created this way.
+        bool graphicsPipelineLibrarySupported = false;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
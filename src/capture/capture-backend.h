@@ -0,0 +1,457 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/capture.h>
+#include "capture-stream.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace nvrhi::capture
+{
+    class DeviceWrapper;
+
+    // Descriptor tables are wrapped to keep a copy of their contents, which are serialized when the table is referenced
+    // in a capture. The wrapper references the resources written into the table, so that they stay alive until
+    // they are serialized, which is why it's only used by the capture layer.
+    class DescriptorTableWrapper : public RefCounter<IDescriptorTable>
+    {
+    public:
+        struct Entry
+        {
+            BindingSetItem item;
+            RefCountPtr<IResource> resource;
+            bool valid = false;
+        };
+
+        explicit DescriptorTableWrapper(IDescriptorTable* table) : m_DescriptorTable(table) { }
+        IDescriptorTable* getUnderlyingObject() const { return m_DescriptorTable; }
+
+        void resize(uint32_t newSize, bool keepContents);
+        void write(const BindingSetItem& item);
+        [[nodiscard]] std::vector<BindingSetItem> getContents() const;
+
+        // IResource
+
+        Object getNativeObject(ObjectType objectType) override { return m_DescriptorTable->getNativeObject(objectType); }
+
+        // IBindingSet
+
+        const BindingSetDesc* getDesc() const override { return nullptr; }
+        IBindingLayout* getLayout() const override { return m_DescriptorTable->getLayout(); }
+
+        // IDescriptorTable
+
+        uint32_t getCapacity() const override { return m_DescriptorTable->getCapacity(); }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return m_DescriptorTable->getFirstDescriptorIndexInHeap(); }
+
+    private:
+        DescriptorTableHandle m_DescriptorTable;
+        mutable std::mutex m_Mutex;
+        std::vector<Entry> m_Entries;
+    };
+
+    [[nodiscard]] IBindingSet* unwrapBindingSet(IBindingSet* bindingSet);
+
+    class CommandListWrapper : public RefCounter<ICommandList>
+    {
+    public:
+        friend class DeviceWrapper;
+
+        CommandListWrapper(DeviceWrapper* device, ICommandList* commandList);
+        
+    protected:
+        CommandListHandle m_CommandList;
+        RefCountPtr<DeviceWrapper> m_Device;
+
+        // The commands recorded since open(), if the command list was opened while a capture was active
+        std::vector<uint8_t> m_Commands;
+        StreamWriter m_Writer;
+        bool m_Capturing = false;
+        uint32_t m_CaptureIndex = 0;
+
+        [[nodiscard]] StreamWriter* beginCommand(Opcode opcode);
+        void endCommand();
+        void unsupportedCall(const char* function) const;
+        ICommandList* getUnderlyingCommandList() const { return m_CommandList; }
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) override;
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindings(const BindingSetVector& bindings) override;
+        void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes)  override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) override;
+
+        void executeBundle(ICommandBundle* bundle) override;
+
+        void setRayTracingState(const rt::State& state) override;
+        void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const DispatchGraphArguments& args) override;
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactBottomLevelAccelStructs() override;
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) override;
+        void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) override;
+
+        void beginMarker(const char* name) override;
+        void endMarker() override;
+        void setGpuProfiler(IGpuProfiler* profiler) override;
+        void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) override;
+
+        void setEnableAutomaticBarriers(bool enable) override;
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override;
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void commitBarriers() override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void endTextureStateTransition(ITexture* texture) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void endBufferStateTransition(IBuffer* buffer) override;
+        void textureAliasingBarrier(ITexture* texture) override;
+        void bufferAliasingBarrier(IBuffer* buffer) override;
+
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override;
+        const CommandListStatistics& getStatistics() const override;
+    };
+
+    class DeviceWrapper : public RefCounter<ICaptureDevice>, public IObjectMap
+    {
+    public:
+        friend class CommandListWrapper;
+
+        explicit DeviceWrapper(IDevice* device);
+
+    protected:
+        struct CapturedObject
+        {
+            RefCountPtr<IResource> object;
+            ObjectKind kind = ObjectKind::None;
+            bool written = false;
+
+            // Graphics and meshlet pipelines: the first framebuffer that the pipeline was used with,
+            // which is needed to create the pipeline on replay
+            FramebufferHandle framebuffer;
+
+            // Input layouts: the vertex shader of the first pipeline that uses the layout
+            ShaderHandle vertexShader;
+        };
+
+        // Collects the objects referenced by an object description, so that they can be written before it
+        class DependencyCollector : public IObjectMap
+        {
+        public:
+            DependencyCollector(DeviceWrapper& device, std::vector<uint32_t>& dependencies)
+                : m_Device(device)
+                , m_Dependencies(dependencies)
+            { }
+
+            uint32_t getObjectId(IResource* object, ObjectKind kind) override;
+
+        private:
+            DeviceWrapper& m_Device;
+            std::vector<uint32_t>& m_Dependencies;
+        };
+
+        DeviceHandle m_Device;
+        IMessageCallback* m_MessageCallback;
+
+        std::mutex m_Mutex;
+        std::atomic<bool> m_Capturing = false;
+        std::atomic<uint32_t> m_CaptureIndex = 0;
+
+        // All members below are protected by m_Mutex
+
+        std::vector<CapturedObject> m_CapturedObjects;
+        std::unordered_map<IResource*, uint32_t> m_ObjectIds;
+        std::vector<uint8_t> m_Frame;
+        StreamWriter m_FrameWriter;
+        uint32_t m_NumExecutions = 0;
+        std::unordered_map<uint64_t, uint32_t> m_ExecutionIndices[size_t(CommandQueue::Count)];
+        std::unordered_set<const char*> m_UnsupportedCalls;
+
+        // CPU access modes of the staging textures, which are not part of their descriptions
+        std::unordered_map<IStagingTexture*, CpuAccessMode> m_StagingTextureAccess;
+
+        void warning(const std::string& messageText) const;
+        void unsupportedCall(const char* function);
+        void unsupportedCallLocked(const char* function);
+
+        uint32_t getObjectIdLocked(IResource* object, ObjectKind kind);
+        void setPipelineFramebuffer(IResource* pipeline, ObjectKind kind, IFramebuffer* framebuffer);
+        void writeObject(uint32_t id, StreamWriter& writer);
+        void serializeObject(uint32_t id, StreamWriter& writer);
+        void resetCapture();
+
+    public:
+
+        // IObjectMap implementation
+
+        uint32_t getObjectId(IResource* object, ObjectKind kind) override;
+
+        // ICaptureDevice implementation
+
+        void beginCapture() override;
+        bool endCapture(std::vector<uint8_t>& outData) override;
+        bool isCapturing() const override { return m_Capturing; }
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+        TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) override;
+        StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) override;
+        ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) override;
+        BindingSetCacheHandle createBindingSetCache() override;
+        MipGeneratorHandle createMipGenerator() override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override;
+        void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void unmapBuffer(IBuffer* b) override;
+        void *tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner) override;
+        ShaderLibraryHandle createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override;
+        void resetEventQuery(IEventQuery* query) override;
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override;
+        void resetTimerQuery(ITimerQuery* query) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+        GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) override;
+        BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+
+        GraphicsAPI getGraphicsAPI() override;
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+
+        WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) override;
+
+        PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override;
+        PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override;
+
+        bool loadPipelineCache(const void* data, size_t size) override;
+        bool savePipelineCache(std::vector<uint8_t>& outData) override;
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc)  override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void waitForIdle() override;
+        uint64_t getCompletedInstance(CommandQueue queue) override;
+        bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) override;
+        void runGarbageCollection() override;
+        bool runGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setUploadPoolSettings(const UploadPoolSettings& settings) override;
+        UploadPoolStatistics getUploadPoolStatistics() override;
+        bool queryMemoryBudget(MemoryBudget& outBudget) override;
+        CommandListStatistics getCommandListStatistics(bool reset = true) override;
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        IMessageCallback* getMessageCallback() override;
+    };
+
+    class Replay : public RefCounter<IReplay>, public IObjectResolver
+    {
+    public:
+        explicit Replay(IDevice* device);
+
+        bool load(const void* data, size_t size);
+
+        // IObjectResolver implementation
+
+        IResource* getObject(uint32_t id, ObjectKind kind) override;
+
+        // IReplay implementation
+
+        bool replayFrame(ReplayStatistics* outStatistics) override;
+
+    private:
+        struct ReplayObject
+        {
+            RefCountPtr<IResource> object;
+            ObjectKind kind = ObjectKind::None;
+        };
+
+        DeviceHandle m_Device;
+        std::vector<uint8_t> m_Data;
+        size_t m_FrameOffset = 0;
+        std::vector<ReplayObject> m_Objects;
+
+        // One timer query for each command list recorded on the graphics or compute queues in a frame
+        std::vector<TimerQueryHandle> m_TimerQueries;
+
+        void error(const std::string& messageText) const;
+        bool createObject(StreamReader& ar);
+        bool replayCommand(ICommandList* commandList, Opcode opcode, StreamReader& ar);
+    };
+
+} // namespace nvrhi::capture
@@ -0,0 +1,949 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+namespace nvrhi::capture
+{
+    // Replaces the descriptor table wrappers in the binding arrays with the underlying tables.
+    // Returns the original state if it doesn't contain any descriptor tables, to avoid the copy.
+    template<typename TState>
+    static const TState& unwrapState(const TState& state, TState& storage)
+    {
+        bool anyDescriptorTables = false;
+        for (IBindingSet* bindingSet : state.bindings)
+        {
+            if (bindingSet && bindingSet->getDesc() == nullptr)
+            {
+                anyDescriptorTables = true;
+                break;
+            }
+        }
+
+        if (!anyDescriptorTables)
+            return state;
+
+        storage = state;
+        for (IBindingSet*& bindingSet : storage.bindings)
+            bindingSet = unwrapBindingSet(bindingSet);
+
+        return storage;
+    }
+
+    CommandListWrapper::CommandListWrapper(DeviceWrapper* device, ICommandList* commandList)
+        : m_CommandList(commandList)
+        , m_Device(device)
+        , m_Writer(m_Commands, device)
+    {
+    }
+
+    StreamWriter* CommandListWrapper::beginCommand(Opcode opcode)
+    {
+        if (!m_Capturing)
+            return nullptr;
+
+        m_Writer.beginRecord(opcode);
+        return &m_Writer;
+    }
+
+    void CommandListWrapper::endCommand()
+    {
+        m_Writer.endRecord();
+    }
+
+    void CommandListWrapper::unsupportedCall(const char* function) const
+    {
+        if (m_Capturing)
+            m_Device->unsupportedCall(function);
+    }
+
+    Object CommandListWrapper::getNativeObject(ObjectType objectType)
+    {
+        return m_CommandList->getNativeObject(objectType);
+    }
+
+    void CommandListWrapper::open()
+    {
+        m_CommandList->open();
+
+        m_Commands.clear();
+        m_CaptureIndex = m_Device->m_CaptureIndex;
+        m_Capturing = m_Device->m_Capturing;
+    }
+
+    void CommandListWrapper::close()
+    {
+        m_CommandList->close();
+    }
+
+    void CommandListWrapper::clearState()
+    {
+        m_CommandList->clearState();
+
+        if (beginCommand(Opcode::ClearState))
+            endCommand();
+    }
+
+    void CommandListWrapper::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        m_CommandList->clearTextureFloat(t, subresources, clearColor);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ClearTextureFloat))
+        {
+            ar->object(ObjectKind::Texture, t);
+            ar->value(subresources);
+            ar->value(clearColor);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        m_CommandList->clearDepthStencilTexture(t, subresources, clearDepth, depth, clearStencil, stencil);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ClearDepthStencilTexture))
+        {
+            ar->object(ObjectKind::Texture, t);
+            ar->value(subresources);
+            ar->value(clearDepth);
+            ar->value(depth);
+            ar->value(clearStencil);
+            ar->value(stencil);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        m_CommandList->clearTextureUInt(t, subresources, clearColor);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ClearTextureUInt))
+        {
+            ar->object(ObjectKind::Texture, t);
+            ar->value(subresources);
+            ar->value(clearColor);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+
+        if (StreamWriter* ar = beginCommand(Opcode::CopyTexture))
+        {
+            ar->object(ObjectKind::Texture, dest);
+            ar->value(destSlice);
+            ar->object(ObjectKind::Texture, src);
+            ar->value(srcSlice);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+
+        if (StreamWriter* ar = beginCommand(Opcode::CopyTextureToStaging))
+        {
+            ar->object(ObjectKind::StagingTexture, dest);
+            ar->value(destSlice);
+            ar->object(ObjectKind::Texture, src);
+            ar->value(srcSlice);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice)
+    {
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+
+        if (StreamWriter* ar = beginCommand(Opcode::CopyTextureFromStaging))
+        {
+            ar->object(ObjectKind::Texture, dest);
+            ar->value(destSlice);
+            ar->object(ObjectKind::StagingTexture, src);
+            ar->value(srcSlice);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+
+        if (StreamWriter* ar = beginCommand(Opcode::WriteTexture))
+        {
+            ar->object(ObjectKind::Texture, dest);
+            ar->value(arraySlice);
+            ar->value(mipLevel);
+            ar->value(uint64_t(rowPitch));
+            ar->value(uint64_t(depthPitch));
+            ar->bytes(data, getSubresourceDataSize(dest->getDesc(), mipLevel, rowPitch, depthPitch));
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources)
+    {
+        m_CommandList->writeTexture(dest, subresources, data, numSubresources);
+
+        if (StreamWriter* ar = beginCommand(Opcode::WriteTextureSubresources))
+        {
+            const TextureDesc& desc = dest->getDesc();
+            const TextureSubresourceSet resolvedSubresources = subresources.resolve(desc, false);
+
+            ar->object(ObjectKind::Texture, dest);
+            ar->value(subresources);
+            ar->value(uint64_t(numSubresources));
+            for (size_t index = 0; index < numSubresources; index++)
+            {
+                const MipLevel mipLevel = resolvedSubresources.baseMipLevel + MipLevel(index % std::max(resolvedSubresources.numMipLevels, 1u));
+                ar->value(uint64_t(data[index].rowPitch));
+                ar->value(uint64_t(data[index].depthPitch));
+                ar->bytes(data[index].data, getSubresourceDataSize(desc, mipLevel, data[index].rowPitch, data[index].depthPitch));
+            }
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
+    {
+        m_CommandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ResolveTexture))
+        {
+            ar->object(ObjectKind::Texture, dest);
+            ar->value(dstSubresources);
+            ar->object(ObjectKind::Texture, src);
+            ar->value(srcSubresources);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture)
+    {
+        unsupportedCall("decodeSamplerFeedbackTexture");
+        m_CommandList->decodeSamplerFeedbackTexture(dest, feedbackTexture);
+    }
+
+    void CommandListWrapper::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
+
+        if (StreamWriter* ar = beginCommand(Opcode::WriteBuffer))
+        {
+            ar->object(ObjectKind::Buffer, b);
+            ar->value(destOffsetBytes);
+            ar->bytes(data, dataSize);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::clearBufferUInt(IBuffer* b, uint32_t clearValue)
+    {
+        m_CommandList->clearBufferUInt(b, clearValue);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ClearBufferUInt))
+        {
+            ar->object(ObjectKind::Buffer, b);
+            ar->value(clearValue);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        m_CommandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+
+        if (StreamWriter* ar = beginCommand(Opcode::CopyBuffer))
+        {
+            ar->object(ObjectKind::Buffer, dest);
+            ar->value(destOffsetBytes);
+            ar->object(ObjectKind::Buffer, src);
+            ar->value(srcOffsetBytes);
+            ar->value(dataSizeBytes);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setPushConstants(const void* data, size_t byteSize)
+    {
+        m_CommandList->setPushConstants(data, byteSize);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetPushConstants))
+        {
+            ar->bytes(data, byteSize);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        GraphicsState storage;
+        m_CommandList->setGraphicsState(unwrapState(state, storage));
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetGraphicsState))
+        {
+            ar->serialize(state);
+            endCommand();
+
+            m_Device->setPipelineFramebuffer(state.pipeline, ObjectKind::GraphicsPipeline, state.framebuffer);
+        }
+    }
+
+    void CommandListWrapper::setGraphicsBindings(const BindingSetVector& bindings)
+    {
+        BindingSetVector unwrappedBindings = bindings;
+        for (IBindingSet*& bindingSet : unwrappedBindings)
+            bindingSet = unwrapBindingSet(bindingSet);
+
+        m_CommandList->setGraphicsBindings(unwrappedBindings);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetGraphicsBindings))
+        {
+            BindingSetVector bindingsCopy = bindings;
+            serializeBindingSets(*ar, bindingsCopy);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        m_CommandList->setGraphicsVertexBuffers(vertexBuffers, indexBuffer);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetGraphicsVertexBuffers))
+        {
+            VertexBufferBindingVector vertexBuffersCopy = vertexBuffers;
+            serializeObjects(*ar, vertexBuffersCopy);
+            ar->serialize(indexBuffer);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::draw(const DrawArguments& args)
+    {
+        m_CommandList->draw(args);
+
+        if (StreamWriter* ar = beginCommand(Opcode::Draw))
+        {
+            ar->value(args);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::drawIndexed(const DrawArguments& args)
+    {
+        m_CommandList->drawIndexed(args);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DrawIndexed))
+        {
+            ar->value(args);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        m_CommandList->drawIndirect(offsetBytes, drawCount);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DrawIndirect))
+        {
+            ar->value(offsetBytes);
+            ar->value(drawCount);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DrawIndexedIndirect))
+        {
+            ar->value(offsetBytes);
+            ar->value(drawCount);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        m_CommandList->drawIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DrawIndirectCount))
+        {
+            ar->value(paramOffsetBytes);
+            ar->object(ObjectKind::Buffer, countBuffer);
+            ar->value(countOffsetBytes);
+            ar->value(maxDrawCount);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        m_CommandList->drawIndexedIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DrawIndexedIndirectCount))
+        {
+            ar->value(paramOffsetBytes);
+            ar->object(ObjectKind::Buffer, countBuffer);
+            ar->value(countOffsetBytes);
+            ar->value(maxDrawCount);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        ComputeState storage;
+        m_CommandList->setComputeState(unwrapState(state, storage));
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetComputeState))
+        {
+            ar->serialize(state);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        m_CommandList->dispatch(groupsX, groupsY, groupsZ);
+
+        if (StreamWriter* ar = beginCommand(Opcode::Dispatch))
+        {
+            ar->value(groupsX);
+            ar->value(groupsY);
+            ar->value(groupsZ);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::dispatchIndirect(uint32_t offsetBytes)
+    {
+        m_CommandList->dispatchIndirect(offsetBytes);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DispatchIndirect))
+        {
+            ar->value(offsetBytes);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    {
+        MeshletState storage;
+        m_CommandList->setMeshletState(unwrapState(state, storage));
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetMeshletState))
+        {
+            ar->serialize(state);
+            endCommand();
+
+            m_Device->setPipelineFramebuffer(state.pipeline, ObjectKind::MeshletPipeline, state.framebuffer);
+        }
+    }
+
+    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DispatchMesh))
+        {
+            ar->value(groupsX);
+            ar->value(groupsY);
+            ar->value(groupsZ);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        m_CommandList->dispatchMeshIndirect(offsetBytes, drawCount);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DispatchMeshIndirect))
+        {
+            ar->value(offsetBytes);
+            ar->value(drawCount);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+
+        if (StreamWriter* ar = beginCommand(Opcode::DispatchMeshIndirectCount))
+        {
+            ar->value(paramOffsetBytes);
+            ar->object(ObjectKind::Buffer, countBuffer);
+            ar->value(countOffsetBytes);
+            ar->value(maxDrawCount);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+        uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countOffsetBytes)
+    {
+        m_CommandList->executeIndirect(signature, argumentBuffer, argumentOffsetBytes, maxCommandCount, countBuffer, countOffsetBytes);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ExecuteIndirect))
+        {
+            ar->object(ObjectKind::CommandSignature, signature);
+            ar->object(ObjectKind::Buffer, argumentBuffer);
+            ar->value(argumentOffsetBytes);
+            ar->value(maxCommandCount);
+            ar->object(ObjectKind::Buffer, countBuffer);
+            ar->value(countOffsetBytes);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::executeBundle(ICommandBundle* bundle)
+    {
+        unsupportedCall("executeBundle");
+        m_CommandList->executeBundle(bundle);
+    }
+
+    void CommandListWrapper::setRayTracingState(const rt::State& state)
+    {
+        unsupportedCall("setRayTracingState");
+
+        rt::State storage;
+        m_CommandList->setRayTracingState(unwrapState(state, storage));
+    }
+
+    void CommandListWrapper::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        unsupportedCall("dispatchRays");
+        m_CommandList->dispatchRays(args);
+    }
+
+    void CommandListWrapper::setWorkGraphState(const WorkGraphState& state)
+    {
+        unsupportedCall("setWorkGraphState");
+
+        WorkGraphState storage;
+        m_CommandList->setWorkGraphState(unwrapState(state, storage));
+    }
+
+    void CommandListWrapper::dispatchGraph(const DispatchGraphArguments& args)
+    {
+        unsupportedCall("dispatchGraph");
+        m_CommandList->dispatchGraph(args);
+    }
+
+    void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        unsupportedCall("buildOpacityMicromap");
+        m_CommandList->buildOpacityMicromap(omm, desc);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupportedCall("buildBottomLevelAccelStruct");
+        m_CommandList->buildBottomLevelAccelStruct(as, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds)
+    {
+        unsupportedCall("buildBottomLevelAccelStructs");
+        m_CommandList->buildBottomLevelAccelStructs(pBuilds, numBuilds);
+    }
+
+    void CommandListWrapper::compactBottomLevelAccelStructs()
+    {
+        unsupportedCall("compactBottomLevelAccelStructs");
+        m_CommandList->compactBottomLevelAccelStructs();
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupportedCall("buildTopLevelAccelStruct");
+        m_CommandList->buildTopLevelAccelStruct(as, pInstances, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+        const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupportedCall("buildTopLevelAccelStructFromDirtyRanges");
+        m_CommandList->buildTopLevelAccelStructFromDirtyRanges(as, pInstances, numInstances, dirtyRanges, numDirtyRanges, buildFlags);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupportedCall("buildTopLevelAccelStructFromBuffer");
+        m_CommandList->buildTopLevelAccelStructFromBuffer(as, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    {
+        m_CommandList->beginTimerQuery(query);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginTimerQuery))
+        {
+            ar->object(ObjectKind::TimerQuery, query);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
+    {
+        m_CommandList->endTimerQuery(query);
+
+        if (StreamWriter* ar = beginCommand(Opcode::EndTimerQuery))
+        {
+            ar->object(ObjectKind::TimerQuery, query);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries)
+    {
+        m_CommandList->resetQueries(pool, firstQuery, numQueries);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ResetQueries))
+        {
+            ar->object(ObjectKind::QueryPool, pool);
+            ar->value(firstQuery);
+            ar->value(numQueries);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::beginQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        m_CommandList->beginQuery(pool, queryIndex);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginQuery))
+        {
+            ar->object(ObjectKind::QueryPool, pool);
+            ar->value(queryIndex);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::endQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        m_CommandList->endQuery(pool, queryIndex);
+
+        if (StreamWriter* ar = beginCommand(Opcode::EndQuery))
+        {
+            ar->object(ObjectKind::QueryPool, pool);
+            ar->value(queryIndex);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes)
+    {
+        m_CommandList->resolveQueries(pool, firstQuery, numQueries, buffer, offsetBytes);
+
+        if (StreamWriter* ar = beginCommand(Opcode::ResolveQueries))
+        {
+            ar->object(ObjectKind::QueryPool, pool);
+            ar->value(firstQuery);
+            ar->value(numQueries);
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(offsetBytes);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        m_CommandList->setPredication(buffer, offsetBytes, op);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetPredication))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(offsetBytes);
+            ar->value(op);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::beginMarker(const char* name)
+    {
+        m_CommandList->beginMarker(name);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginMarker))
+        {
+            ar->string(name ? name : "");
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::endMarker()
+    {
+        m_CommandList->endMarker();
+
+        if (beginCommand(Opcode::EndMarker))
+            endCommand();
+    }
+
+    // GPU profiler scopes and breadcrumbs are diagnostics of the captured application and are not replayed
+
+    void CommandListWrapper::setGpuProfiler(IGpuProfiler* profiler)
+    {
+        m_CommandList->setGpuProfiler(profiler);
+    }
+
+    void CommandListWrapper::writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId)
+    {
+        m_CommandList->writeBreadcrumb(buffer, markerId);
+    }
+
+    void CommandListWrapper::setEnableAutomaticBarriers(bool enable)
+    {
+        m_CommandList->setEnableAutomaticBarriers(enable);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetEnableAutomaticBarriers))
+        {
+            ar->value(enable);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setResourceStatesForBindingSet(IBindingSet* bindingSet)
+    {
+        m_CommandList->setResourceStatesForBindingSet(unwrapBindingSet(bindingSet));
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetResourceStatesForBindingSet))
+        {
+            const bool isDescriptorTable = bindingSet && bindingSet->getDesc() == nullptr;
+            ar->value(isDescriptorTable);
+            ar->object(isDescriptorTable ? ObjectKind::DescriptorTable : ObjectKind::BindingSet, bindingSet);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
+    {
+        m_CommandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetEnableUavBarriersForTexture))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            ar->value(enableBarriers);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers)
+    {
+        m_CommandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetEnableUavBarriersForBuffer))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(enableBarriers);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginTrackingTextureState))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            ar->value(subresources);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_CommandList->beginTrackingBufferState(buffer, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginTrackingBufferState))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        m_CommandList->setTextureState(texture, subresources, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetTextureState))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            ar->value(subresources);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_CommandList->setBufferState(buffer, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetBufferState))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits)
+    {
+        unsupportedCall("setAccelStructState");
+        m_CommandList->setAccelStructState(as, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentTextureState(ITexture* texture, ResourceStates stateBits)
+    {
+        m_CommandList->setPermanentTextureState(texture, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetPermanentTextureState))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_CommandList->setPermanentBufferState(buffer, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::SetPermanentBufferState))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::commitBarriers()
+    {
+        m_CommandList->commitBarriers();
+
+        if (beginCommand(Opcode::CommitBarriers))
+            endCommand();
+    }
+
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        m_CommandList->beginTextureStateTransition(texture, subresources, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginTextureStateTransition))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            ar->value(subresources);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::endTextureStateTransition(ITexture* texture)
+    {
+        m_CommandList->endTextureStateTransition(texture);
+
+        if (StreamWriter* ar = beginCommand(Opcode::EndTextureStateTransition))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_CommandList->beginBufferStateTransition(buffer, stateBits);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BeginBufferStateTransition))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            ar->value(stateBits);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::endBufferStateTransition(IBuffer* buffer)
+    {
+        m_CommandList->endBufferStateTransition(buffer);
+
+        if (StreamWriter* ar = beginCommand(Opcode::EndBufferStateTransition))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::textureAliasingBarrier(ITexture* texture)
+    {
+        m_CommandList->textureAliasingBarrier(texture);
+
+        if (StreamWriter* ar = beginCommand(Opcode::TextureAliasingBarrier))
+        {
+            ar->object(ObjectKind::Texture, texture);
+            endCommand();
+        }
+    }
+
+    void CommandListWrapper::bufferAliasingBarrier(IBuffer* buffer)
+    {
+        m_CommandList->bufferAliasingBarrier(buffer);
+
+        if (StreamWriter* ar = beginCommand(Opcode::BufferAliasingBarrier))
+        {
+            ar->object(ObjectKind::Buffer, buffer);
+            endCommand();
+        }
+    }
+
+    ResourceStates CommandListWrapper::getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        return m_CommandList->getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandListWrapper::getBufferState(IBuffer* buffer)
+    {
+        return m_CommandList->getBufferState(buffer);
+    }
+
+    IDevice* CommandListWrapper::getDevice()
+    {
+        return m_Device;
+    }
+
+    const CommandListParameters& CommandListWrapper::getDesc()
+    {
+        return m_CommandList->getDesc();
+    }
+
+    const CommandListStatistics& CommandListWrapper::getStatistics() const
+    {
+        return m_CommandList->getStatistics();
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,980 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include "../common/transient-resource-pool.h"
+#include "../common/readback-ring.h"
+#include "../common/binding-set-cache.h"
+#include "../common/mip-generator.h"
+#include "../common/streaming-uploader.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace nvrhi::capture
+{
+    CaptureDeviceHandle createCaptureLayer(IDevice* underlyingDevice)
+    {
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        return CaptureDeviceHandle::Create(wrapper);
+    }
+
+    ObjectKind getBindingResourceKind(ResourceType type)
+    {
+        switch (type)
+        {
+        case ResourceType::Texture_SRV:
+        case ResourceType::Texture_UAV:
+            return ObjectKind::Texture;
+
+        case ResourceType::TypedBuffer_SRV:
+        case ResourceType::TypedBuffer_UAV:
+        case ResourceType::StructuredBuffer_SRV:
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_SRV:
+        case ResourceType::RawBuffer_UAV:
+        case ResourceType::ConstantBuffer:
+        case ResourceType::VolatileConstantBuffer:
+            return ObjectKind::Buffer;
+
+        case ResourceType::Sampler:
+            return ObjectKind::Sampler;
+
+        case ResourceType::RayTracingAccelStruct:
+        case ResourceType::PushConstants:
+        case ResourceType::None:
+        case ResourceType::Count:
+        default:
+            return ObjectKind::None;
+        }
+    }
+
+    size_t getSubresourceDataSize(const TextureDesc& desc, MipLevel mipLevel, size_t rowPitch, size_t depthPitch)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max(uint32_t(formatInfo.blockSize), 1u);
+
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        const size_t rowBytes = size_t((width + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+        const size_t numRows = (height + blockSize - 1) / blockSize;
+
+        // The last row and slice are only read up to the end of the data, not the full pitch
+        return depthPitch * (depth - 1) + rowPitch * (numRows - 1) + rowBytes;
+    }
+
+    IBindingSet* unwrapBindingSet(IBindingSet* bindingSet)
+    {
+        if (bindingSet && bindingSet->getDesc() == nullptr)
+            return checked_cast<DescriptorTableWrapper*>(bindingSet)->getUnderlyingObject();
+
+        return bindingSet;
+    }
+
+    void DescriptorTableWrapper::resize(uint32_t newSize, bool keepContents)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!keepContents)
+            m_Entries.clear();
+
+        m_Entries.resize(newSize);
+    }
+
+    void DescriptorTableWrapper::write(const BindingSetItem& item)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (item.slot >= m_Entries.size())
+            m_Entries.resize(item.slot + 1);
+
+        Entry& entry = m_Entries[item.slot];
+        entry.item = item;
+        entry.resource = item.resourceHandle;
+        entry.valid = true;
+    }
+
+    std::vector<BindingSetItem> DescriptorTableWrapper::getContents() const
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        std::vector<BindingSetItem> contents;
+        for (const Entry& entry : m_Entries)
+        {
+            if (entry.valid)
+                contents.push_back(entry.item);
+        }
+        return contents;
+    }
+
+    DeviceWrapper::DeviceWrapper(IDevice* device)
+        : m_Device(device)
+        , m_MessageCallback(device->getMessageCallback())
+        , m_FrameWriter(m_Frame, nullptr)
+    {
+
+    }
+
+    void DeviceWrapper::warning(const std::string& messageText) const
+    {
+        m_MessageCallback->message(MessageSeverity::Warning, messageText.c_str());
+    }
+
+    void DeviceWrapper::unsupportedCall(const char* function)
+    {
+        if (!m_Capturing)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+        unsupportedCallLocked(function);
+    }
+
+    void DeviceWrapper::unsupportedCallLocked(const char* function)
+    {
+        if (!m_UnsupportedCalls.insert(function).second)
+            return;
+
+        std::stringstream ss;
+        ss << "The capture layer does not capture " << function << ", the replay of this capture will be incomplete";
+        warning(ss.str());
+    }
+
+    uint32_t DeviceWrapper::getObjectId(IResource* object, ObjectKind kind)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        return getObjectIdLocked(object, kind);
+    }
+
+    uint32_t DeviceWrapper::getObjectIdLocked(IResource* object, ObjectKind kind)
+    {
+        if (!object || kind == ObjectKind::None || !m_Capturing)
+            return 0;
+
+        auto it = m_ObjectIds.find(object);
+        if (it != m_ObjectIds.end())
+            return it->second;
+
+        CapturedObject captured;
+        captured.object = object;
+        captured.kind = kind;
+        m_CapturedObjects.push_back(std::move(captured));
+
+        const uint32_t id = uint32_t(m_CapturedObjects.size());
+        m_ObjectIds[object] = id;
+        return id;
+    }
+
+    uint32_t DeviceWrapper::DependencyCollector::getObjectId(IResource* object, ObjectKind kind)
+    {
+        const uint32_t id = m_Device.getObjectIdLocked(object, kind);
+        if (id)
+            m_Dependencies.push_back(id);
+        return id;
+    }
+
+    void DeviceWrapper::setPipelineFramebuffer(IResource* pipeline, ObjectKind kind, IFramebuffer* framebuffer)
+    {
+        if (!pipeline || !framebuffer)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        const uint32_t id = getObjectIdLocked(pipeline, kind);
+        if (id && !m_CapturedObjects[id - 1].framebuffer)
+            m_CapturedObjects[id - 1].framebuffer = framebuffer;
+    }
+
+    void DeviceWrapper::beginCapture()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_Capturing)
+        {
+            warning("beginCapture: a capture is already active");
+            return;
+        }
+
+        resetCapture();
+        ++m_CaptureIndex;
+        m_Capturing = true;
+    }
+
+    bool DeviceWrapper::endCapture(std::vector<uint8_t>& outData)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_Capturing)
+            return false;
+
+        outData.clear();
+        StreamWriter writer(outData, nullptr);
+
+        StreamHeader header;
+        header.graphicsAPI = m_Device->getGraphicsAPI();
+        writer.value(header);
+
+        // Writing an object can add its dependencies to the table, so the size is re-evaluated on every iteration
+        for (size_t index = 0; index < m_CapturedObjects.size(); index++)
+        {
+            writeObject(uint32_t(index + 1), writer);
+        }
+
+        writer.raw(m_Frame.data(), m_Frame.size());
+
+        // Stop the capture after the objects are written, getObjectIdLocked doesn't assign IDs without a capture
+        m_Capturing = false;
+        resetCapture();
+        return true;
+    }
+
+    void DeviceWrapper::resetCapture()
+    {
+        m_CapturedObjects.clear();
+        m_ObjectIds.clear();
+        m_Frame.clear();
+        m_NumExecutions = 0;
+        for (auto& indices : m_ExecutionIndices)
+            indices.clear();
+        m_UnsupportedCalls.clear();
+    }
+
+    void DeviceWrapper::writeObject(uint32_t id, StreamWriter& writer)
+    {
+        if (m_CapturedObjects[id - 1].written)
+            return;
+
+        m_CapturedObjects[id - 1].written = true;
+
+        // Serialize the object into a separate buffer first to discover its dependencies,
+        // which must be created before it on replay
+        std::vector<uint8_t> payload;
+        std::vector<uint32_t> dependencies;
+        DependencyCollector collector(*this, dependencies);
+        StreamWriter payloadWriter(payload, &collector);
+        serializeObject(id, payloadWriter);
+
+        for (uint32_t dependency : dependencies)
+        {
+            writeObject(dependency, writer);
+        }
+
+        writer.beginRecord(Opcode::CreateObject);
+        writer.raw(payload.data(), payload.size());
+        writer.endRecord();
+    }
+
+    void DeviceWrapper::serializeObject(uint32_t id, StreamWriter& writer)
+    {
+        // Copy the handles, serializing the object can reallocate the object table
+        const ObjectKind kind = m_CapturedObjects[id - 1].kind;
+        IResource* const object = m_CapturedObjects[id - 1].object;
+        const FramebufferHandle framebuffer = m_CapturedObjects[id - 1].framebuffer;
+
+        writer.value(kind);
+        writer.value(id);
+
+        switch (kind)
+        {
+        case ObjectKind::Texture: {
+            writer.serialize(static_cast<ITexture*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::StagingTexture: {
+            IStagingTexture* stagingTexture = static_cast<IStagingTexture*>(object);
+            auto it = m_StagingTextureAccess.find(stagingTexture);
+            writer.serialize(stagingTexture->getDesc());
+            writer.value(it != m_StagingTextureAccess.end() ? it->second : CpuAccessMode::Read);
+            break;
+        }
+
+        case ObjectKind::Buffer: {
+            writer.serialize(static_cast<IBuffer*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::Sampler: {
+            writer.value(static_cast<ISampler*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::Shader: {
+            IShader* shader = static_cast<IShader*>(object);
+            const void* bytecode = nullptr;
+            size_t bytecodeSize = 0;
+            shader->getBytecode(&bytecode, &bytecodeSize);
+            writer.serialize(shader->getDesc());
+            writer.bytes(bytecode, bytecodeSize);
+            break;
+        }
+
+        case ObjectKind::InputLayout: {
+            IInputLayout* inputLayout = static_cast<IInputLayout*>(object);
+            const uint32_t numAttributes = inputLayout->getNumAttributes();
+            writer.value(numAttributes);
+            for (uint32_t index = 0; index < numAttributes; index++)
+                writer.serialize(*inputLayout->getAttributeDesc(index));
+            writer.object(ObjectKind::Shader, m_CapturedObjects[id - 1].vertexShader);
+            break;
+        }
+
+        case ObjectKind::Framebuffer: {
+            writer.serialize(static_cast<IFramebuffer*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::GraphicsPipeline: {
+            const GraphicsPipelineDesc& desc = static_cast<IGraphicsPipeline*>(object)->getDesc();
+            writer.serialize(desc);
+            writer.object(ObjectKind::Framebuffer, framebuffer);
+
+            // D3D11 needs the vertex shader to create the input layout
+            const uint32_t inputLayoutId = getObjectIdLocked(desc.inputLayout, ObjectKind::InputLayout);
+            if (inputLayoutId && !m_CapturedObjects[inputLayoutId - 1].vertexShader)
+                m_CapturedObjects[inputLayoutId - 1].vertexShader = desc.VS;
+
+            if (!framebuffer)
+                warning("The capture contains a graphics pipeline that was not used with a framebuffer, "
+                    "it cannot be recreated on replay");
+            break;
+        }
+
+        case ObjectKind::ComputePipeline: {
+            writer.serialize(static_cast<IComputePipeline*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::MeshletPipeline: {
+            writer.serialize(static_cast<IMeshletPipeline*>(object)->getDesc());
+            writer.object(ObjectKind::Framebuffer, framebuffer);
+
+            if (!framebuffer)
+                warning("The capture contains a meshlet pipeline that was not used with a framebuffer, "
+                    "it cannot be recreated on replay");
+            break;
+        }
+
+        case ObjectKind::BindingLayout: {
+            IBindingLayout* layout = static_cast<IBindingLayout*>(object);
+            const bool isBindless = layout->getDesc() == nullptr;
+            writer.value(isBindless);
+            if (isBindless)
+                writer.serialize(*layout->getBindlessDesc());
+            else
+                writer.serialize(*layout->getDesc());
+            break;
+        }
+
+        case ObjectKind::BindingSet: {
+            IBindingSet* bindingSet = static_cast<IBindingSet*>(object);
+            writer.object(ObjectKind::BindingLayout, bindingSet->getLayout());
+            writer.serialize(*bindingSet->getDesc());
+
+            for (const BindingSetItem& item : bindingSet->getDesc()->bindings)
+            {
+                if (item.type == ResourceType::RayTracingAccelStruct)
+                    unsupportedCallLocked("acceleration structure bindings");
+            }
+            break;
+        }
+
+        case ObjectKind::DescriptorTable: {
+            DescriptorTableWrapper* descriptorTable = checked_cast<DescriptorTableWrapper*>(static_cast<IDescriptorTable*>(object));
+            const std::vector<BindingSetItem> contents = descriptorTable->getContents();
+            writer.object(ObjectKind::BindingLayout, descriptorTable->getLayout());
+            writer.value(descriptorTable->getCapacity());
+            writer.value(uint32_t(contents.size()));
+            for (const BindingSetItem& item : contents)
+                writer.serialize(item);
+            break;
+        }
+
+        case ObjectKind::CommandSignature: {
+            writer.serialize(static_cast<ICommandSignature*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::QueryPool: {
+            writer.serialize(static_cast<IQueryPool*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::CommandList: {
+            writer.serialize(static_cast<ICommandList*>(object)->getDesc());
+            break;
+        }
+
+        case ObjectKind::TimerQuery:
+        case ObjectKind::None:
+        default:
+            break;
+        }
+    }
+
+    Object DeviceWrapper::getNativeObject(ObjectType objectType)
+    {
+        return m_Device->getNativeObject(objectType);
+    }
+
+    HeapHandle DeviceWrapper::createHeap(const HeapDesc& d)
+    {
+        return m_Device->createHeap(d);
+    }
+
+    TransientResourcePoolHandle DeviceWrapper::createTransientResourcePool(const TransientResourcePoolDesc& desc)
+    {
+        // The helper objects are created on top of the wrapper, so that the work they record is captured
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(this, desc));
+    }
+
+    StreamingUploaderHandle DeviceWrapper::createStreamingUploader(const StreamingUploaderDesc& desc)
+    {
+        return StreamingUploaderHandle::Create(new StreamingUploader(this, desc));
+    }
+
+    ReadbackRingHandle DeviceWrapper::createReadbackRing(const ReadbackRingDesc& desc)
+    {
+        return ReadbackRing::create(this, desc);
+    }
+
+    BindingSetCacheHandle DeviceWrapper::createBindingSetCache()
+    {
+        return BindingSetCacheHandle::Create(new BindingSetCache(this));
+    }
+
+    MipGeneratorHandle DeviceWrapper::createMipGenerator()
+    {
+        return MipGenerator::create(this);
+    }
+
+    TextureHandle DeviceWrapper::createTexture(const TextureDesc& d)
+    {
+        return m_Device->createTexture(d);
+    }
+
+    MemoryRequirements DeviceWrapper::getTextureMemoryRequirements(ITexture* texture)
+    {
+        return m_Device->getTextureMemoryRequirements(texture);
+    }
+
+    bool DeviceWrapper::bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindTextureMemory(texture, heap, offset);
+    }
+
+    bool DeviceWrapper::writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        return m_Device->writeTextureDirect(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+    }
+
+    TextureHandle DeviceWrapper::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        return m_Device->createHandleForNativeTexture(objectType, texture, desc);
+    }
+
+    StagingTextureHandle DeviceWrapper::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTextureHandle stagingTexture = m_Device->createStagingTexture(d, cpuAccess);
+
+        if (stagingTexture)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            // Entries are never removed, a new texture at the address of a deleted one replaces its entry
+            m_StagingTextureAccess[stagingTexture.Get()] = cpuAccess;
+        }
+
+        return stagingTexture;
+    }
+
+    void* DeviceWrapper::mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        return m_Device->mapStagingTexture(tex, slice, cpuAccess, outRowPitch);
+    }
+
+    void DeviceWrapper::unmapStagingTexture(IStagingTexture* tex)
+    {
+        m_Device->unmapStagingTexture(tex);
+    }
+
+    void* DeviceWrapper::tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        return m_Device->tryMapStagingTexture(tex, slice, cpuAccess, outRowPitch);
+    }
+
+    BufferHandle DeviceWrapper::createBuffer(const BufferDesc& d)
+    {
+        return m_Device->createBuffer(d);
+    }
+
+    void* DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        return m_Device->mapBuffer(b, mapFlags);
+    }
+
+    void DeviceWrapper::unmapBuffer(IBuffer* b)
+    {
+        m_Device->unmapBuffer(b);
+    }
+
+    void* DeviceWrapper::tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        return m_Device->tryMapBuffer(b, mapFlags);
+    }
+
+    MemoryRequirements DeviceWrapper::getBufferMemoryRequirements(IBuffer* buffer)
+    {
+        return m_Device->getBufferMemoryRequirements(buffer);
+    }
+
+    bool DeviceWrapper::bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindBufferMemory(buffer, heap, offset);
+    }
+
+    void DeviceWrapper::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        m_Device->getTextureTiling(texture, numTiles, desc, tileShape, subresourceTilingsNum, subresourceTilings);
+    }
+
+    void DeviceWrapper::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        unsupportedCall("updateTextureTileMappings");
+        m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
+    }
+
+    void DeviceWrapper::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        unsupportedCall("updateBufferTileMappings");
+        m_Device->updateBufferTileMappings(buffer, tileMappings, numTileMappings, executionQueue);
+    }
+
+    TextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        return m_Device->createSamplerFeedbackTexture(pairedTexture, desc);
+    }
+
+    BufferHandle DeviceWrapper::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        return m_Device->createHandleForNativeBuffer(objectType, buffer, desc);
+    }
+
+    ShaderHandle DeviceWrapper::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        return m_Device->createShader(d, binary, binarySize);
+    }
+
+    ShaderHandle DeviceWrapper::createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        return m_Device->createShaderSpecialization(baseShader, constants, numConstants);
+    }
+
+    ShaderLibraryHandle DeviceWrapper::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        return m_Device->createShaderLibrary(binary, binarySize);
+    }
+
+    ShaderHandle DeviceWrapper::createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner)
+    {
+        return m_Device->createShaderNoCopy(d, binary, binarySize, binaryOwner);
+    }
+
+    ShaderLibraryHandle DeviceWrapper::createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner)
+    {
+        return m_Device->createShaderLibraryNoCopy(binary, binarySize, binaryOwner);
+    }
+
+    SamplerHandle DeviceWrapper::createSampler(const SamplerDesc& d)
+    {
+        return m_Device->createSampler(d);
+    }
+
+    InputLayoutHandle DeviceWrapper::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        return m_Device->createInputLayout(d, attributeCount, vertexShader);
+    }
+
+    EventQueryHandle DeviceWrapper::createEventQuery()
+    {
+        return m_Device->createEventQuery();
+    }
+
+    void DeviceWrapper::setEventQuery(IEventQuery* query, CommandQueue queue)
+    {
+        m_Device->setEventQuery(query, queue);
+    }
+
+    bool DeviceWrapper::pollEventQuery(IEventQuery* query)
+    {
+        return m_Device->pollEventQuery(query);
+    }
+
+    void DeviceWrapper::waitEventQuery(IEventQuery* query)
+    {
+        m_Device->waitEventQuery(query);
+    }
+
+    void DeviceWrapper::resetEventQuery(IEventQuery* query)
+    {
+        m_Device->resetEventQuery(query);
+    }
+
+    TimerQueryHandle DeviceWrapper::createTimerQuery()
+    {
+        return m_Device->createTimerQuery();
+    }
+
+    bool DeviceWrapper::pollTimerQuery(ITimerQuery* query)
+    {
+        return m_Device->pollTimerQuery(query);
+    }
+
+    float DeviceWrapper::getTimerQueryTime(ITimerQuery* query)
+    {
+        return m_Device->getTimerQueryTime(query);
+    }
+
+    void DeviceWrapper::resetTimerQuery(ITimerQuery* query)
+    {
+        m_Device->resetTimerQuery(query);
+    }
+
+    QueryPoolHandle DeviceWrapper::createQueryPool(const QueryPoolDesc& desc)
+    {
+        return m_Device->createQueryPool(desc);
+    }
+
+    GpuProfilerHandle DeviceWrapper::createGpuProfiler(const GpuProfilerDesc& desc)
+    {
+        return m_Device->createGpuProfiler(desc);
+    }
+
+    BreadcrumbBufferHandle DeviceWrapper::createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc)
+    {
+        return m_Device->createBreadcrumbBuffer(desc);
+    }
+
+    CommandSignatureHandle DeviceWrapper::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        return m_Device->createCommandSignature(desc);
+    }
+
+    CommandBundleHandle DeviceWrapper::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        return m_Device->createCommandBundle(desc);
+    }
+
+    GraphicsAPI DeviceWrapper::getGraphicsAPI()
+    {
+        return m_Device->getGraphicsAPI();
+    }
+
+    FramebufferHandle DeviceWrapper::createFramebuffer(const FramebufferDesc& desc)
+    {
+        return m_Device->createFramebuffer(desc);
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return m_Device->createGraphicsPipeline(desc, fb);
+    }
+
+    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        return m_Device->createComputePipeline(desc);
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return m_Device->createMeshletPipeline(desc, fb);
+    }
+
+    rt::PipelineHandle DeviceWrapper::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        return m_Device->createRayTracingPipeline(desc);
+    }
+
+    WorkGraphHandle DeviceWrapper::createWorkGraph(const WorkGraphDesc& desc)
+    {
+        return m_Device->createWorkGraph(desc);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return m_Device->createGraphicsPipelineAsync(desc, fb);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createComputePipelineAsync(const ComputePipelineDesc& desc)
+    {
+        return m_Device->createComputePipelineAsync(desc);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return m_Device->createMeshletPipelineAsync(desc, fb);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createRayTracingPipelineAsync(const rt::PipelineDesc& desc)
+    {
+        return m_Device->createRayTracingPipelineAsync(desc);
+    }
+
+    bool DeviceWrapper::loadPipelineCache(const void* data, size_t size)
+    {
+        return m_Device->loadPipelineCache(data, size);
+    }
+
+    bool DeviceWrapper::savePipelineCache(std::vector<uint8_t>& outData)
+    {
+        return m_Device->savePipelineCache(outData);
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        return m_Device->createBindingLayout(desc);
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        return m_Device->createBindlessLayout(desc);
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        return m_Device->createBindingSet(desc, layout);
+    }
+
+    bool DeviceWrapper::createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets)
+    {
+        return m_Device->createBindingSets(descs, count, layout, outBindingSets);
+    }
+
+    DescriptorTableHandle DeviceWrapper::createDescriptorTable(IBindingLayout* layout)
+    {
+        DescriptorTableHandle descriptorTable = m_Device->createDescriptorTable(layout);
+        if (!descriptorTable)
+            return nullptr;
+
+        DescriptorTableWrapper* wrapper = new DescriptorTableWrapper(descriptorTable);
+        wrapper->resize(descriptorTable->getCapacity(), false);
+        return DescriptorTableHandle::Create(wrapper);
+    }
+
+    void DeviceWrapper::resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        DescriptorTableWrapper* wrapper = checked_cast<DescriptorTableWrapper*>(descriptorTable);
+        m_Device->resizeDescriptorTable(wrapper->getUnderlyingObject(), newSize, keepContents);
+        wrapper->resize(newSize, keepContents);
+    }
+
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item)
+    {
+        DescriptorTableWrapper* wrapper = checked_cast<DescriptorTableWrapper*>(descriptorTable);
+        if (!m_Device->writeDescriptorTable(wrapper->getUnderlyingObject(), item))
+            return false;
+
+        wrapper->write(item);
+        return true;
+    }
+
+    rt::OpacityMicromapHandle DeviceWrapper::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
+    {
+        return m_Device->createOpacityMicromap(desc);
+    }
+
+    rt::AccelStructHandle DeviceWrapper::createAccelStruct(const rt::AccelStructDesc& desc)
+    {
+        return m_Device->createAccelStruct(desc);
+    }
+
+    MemoryRequirements DeviceWrapper::getAccelStructMemoryRequirements(rt::IAccelStruct* as)
+    {
+        return m_Device->getAccelStructMemoryRequirements(as);
+    }
+
+    bool DeviceWrapper::bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindAccelStructMemory(as, heap, offset);
+    }
+
+    CommandListHandle DeviceWrapper::createCommandList(const CommandListParameters& params)
+    {
+        CommandListHandle commandList = m_Device->createCommandList(params);
+        if (!commandList)
+            return nullptr;
+
+        CommandListWrapper* wrapper = new CommandListWrapper(this, commandList);
+        return CommandListHandle::Create(wrapper);
+    }
+
+    uint64_t DeviceWrapper::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        std::vector<ICommandList*> unwrappedCommandLists;
+        unwrappedCommandLists.resize(numCommandLists);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            unwrappedCommandLists[i] = checked_cast<CommandListWrapper*>(pCommandLists[i])->getUnderlyingCommandList();
+        }
+
+        if (!m_Capturing)
+            return m_Device->executeCommandLists(unwrappedCommandLists.data(), numCommandLists, executionQueue);
+
+        // Hold the lock over the execution, so that the order of the records matches the order of the submissions
+        std::lock_guard lockGuard(m_Mutex);
+
+        const uint64_t instance = m_Device->executeCommandLists(unwrappedCommandLists.data(), numCommandLists, executionQueue);
+
+        uint32_t numCaptured = 0;
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandListWrapper* wrapper = checked_cast<CommandListWrapper*>(pCommandLists[i]);
+
+            // Command lists opened before the capture started are incomplete and are not captured
+            if (!wrapper->m_Capturing || wrapper->m_CaptureIndex != m_CaptureIndex)
+                continue;
+
+            m_FrameWriter.beginRecord(Opcode::RecordCommandList);
+            m_FrameWriter.value(getObjectIdLocked(wrapper, ObjectKind::CommandList));
+            m_FrameWriter.raw(wrapper->m_Commands.data(), wrapper->m_Commands.size());
+            m_FrameWriter.endRecord();
+            ++numCaptured;
+        }
+
+        if (numCaptured != 0)
+        {
+            m_FrameWriter.beginRecord(Opcode::ExecuteCommandLists);
+            m_FrameWriter.value(executionQueue);
+            m_FrameWriter.value(numCaptured);
+            m_FrameWriter.endRecord();
+
+            m_ExecutionIndices[size_t(executionQueue)][instance] = m_NumExecutions;
+            ++m_NumExecutions;
+        }
+
+        return instance;
+    }
+
+    void DeviceWrapper::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance)
+    {
+        m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance);
+
+        if (!m_Capturing)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Waits for submissions made before the capture started are already satisfied on replay
+        const auto& indices = m_ExecutionIndices[size_t(executionQueue)];
+        auto it = indices.find(instance);
+        if (it == indices.end())
+            return;
+
+        m_FrameWriter.beginRecord(Opcode::QueueWaitForCommandList);
+        m_FrameWriter.value(waitQueue);
+        m_FrameWriter.value(executionQueue);
+        m_FrameWriter.value(it->second);
+        m_FrameWriter.endRecord();
+    }
+
+    void DeviceWrapper::waitForIdle()
+    {
+        m_Device->waitForIdle();
+    }
+
+    // The CPU-side waits don't affect the command stream and are not recorded
+
+    uint64_t DeviceWrapper::getCompletedInstance(CommandQueue queue)
+    {
+        return m_Device->getCompletedInstance(queue);
+    }
+
+    bool DeviceWrapper::waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        return m_Device->waitForAll(submissions, count, timeout);
+    }
+
+    size_t DeviceWrapper::waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        return m_Device->waitForAny(submissions, count, timeout);
+    }
+
+    void DeviceWrapper::notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        m_Device->notifyOnCompletion(submissions, count, waitAny, std::move(callback));
+    }
+
+    void DeviceWrapper::runGarbageCollection()
+    {
+        m_Device->runGarbageCollection();
+    }
+
+    bool DeviceWrapper::runGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        return m_Device->runGarbageCollection(budget);
+    }
+
+    void DeviceWrapper::setUploadPoolSettings(const UploadPoolSettings& settings)
+    {
+        m_Device->setUploadPoolSettings(settings);
+    }
+
+    UploadPoolStatistics DeviceWrapper::getUploadPoolStatistics()
+    {
+        return m_Device->getUploadPoolStatistics();
+    }
+
+    bool DeviceWrapper::queryMemoryBudget(MemoryBudget& outBudget)
+    {
+        return m_Device->queryMemoryBudget(outBudget);
+    }
+
+    CommandListStatistics DeviceWrapper::getCommandListStatistics(bool reset)
+    {
+        return m_Device->getCommandListStatistics(reset);
+    }
+
+    bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
+    }
+
+    FormatSupport DeviceWrapper::queryFormatSupport(Format format)
+    {
+        return m_Device->queryFormatSupport(format);
+    }
+
+    Object DeviceWrapper::getNativeQueue(ObjectType objectType, CommandQueue queue)
+    {
+        return m_Device->getNativeQueue(objectType, queue);
+    }
+
+    IMessageCallback* DeviceWrapper::getMessageCallback()
+    {
+        return m_MessageCallback;
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,1078 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace nvrhi::capture
+{
+    static const char* getObjectKindName(ObjectKind kind)
+    {
+        switch (kind)
+        {
+        case ObjectKind::Texture:           return "texture";
+        case ObjectKind::StagingTexture:    return "staging texture";
+        case ObjectKind::Buffer:            return "buffer";
+        case ObjectKind::Sampler:           return "sampler";
+        case ObjectKind::Shader:            return "shader";
+        case ObjectKind::InputLayout:       return "input layout";
+        case ObjectKind::Framebuffer:       return "framebuffer";
+        case ObjectKind::GraphicsPipeline:  return "graphics pipeline";
+        case ObjectKind::ComputePipeline:   return "compute pipeline";
+        case ObjectKind::MeshletPipeline:   return "meshlet pipeline";
+        case ObjectKind::BindingLayout:     return "binding layout";
+        case ObjectKind::BindingSet:        return "binding set";
+        case ObjectKind::DescriptorTable:   return "descriptor table";
+        case ObjectKind::CommandSignature:  return "command signature";
+        case ObjectKind::QueryPool:         return "query pool";
+        case ObjectKind::TimerQuery:        return "timer query";
+        case ObjectKind::CommandList:       return "command list";
+        case ObjectKind::None:
+        default:                            return "unknown object";
+        }
+    }
+
+    bool getCaptureInfo(const void* data, size_t size, CaptureInfo& outInfo)
+    {
+        StreamReader reader(data, size, nullptr);
+        StreamHeader header;
+        reader.value(header);
+
+        if (reader.failed() || header.magic != c_StreamMagic || header.streamVersion != c_StreamVersion)
+            return false;
+
+        outInfo.graphicsAPI = header.graphicsAPI;
+        outInfo.headerVersion = header.headerVersion;
+        return true;
+    }
+
+    ReplayHandle createReplay(IDevice* device, const void* data, size_t size)
+    {
+        RefCountPtr<Replay> replay = RefCountPtr<Replay>::Create(new Replay(device));
+
+        if (!replay->load(data, size))
+            return nullptr;
+
+        return replay;
+    }
+
+    Replay::Replay(IDevice* device)
+        : m_Device(device)
+    {
+    }
+
+    void Replay::error(const std::string& messageText) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, messageText.c_str());
+    }
+
+    IResource* Replay::getObject(uint32_t id, ObjectKind kind)
+    {
+        if (id == 0 || id > m_Objects.size() || m_Objects[id - 1].kind != kind)
+            return nullptr;
+
+        return m_Objects[id - 1].object;
+    }
+
+    bool Replay::load(const void* data, size_t size)
+    {
+        CaptureInfo info;
+        if (!getCaptureInfo(data, size, info))
+        {
+            error("createReplay: the data is not an NVRHI capture, or it was captured with an incompatible version of NVRHI");
+            return false;
+        }
+
+        // Keep a copy of the stream, the command payloads are read from it on every frame
+        m_Data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+        StreamReader reader(m_Data.data() + sizeof(StreamHeader), m_Data.size() - sizeof(StreamHeader), this);
+
+        // The object records come first, followed by the frame records
+        while (!reader.atEnd())
+        {
+            const size_t recordOffset = sizeof(StreamHeader) + reader.getOffset();
+
+            Opcode opcode = Opcode::CreateObject;
+            StreamReader payload(nullptr, 0, nullptr);
+            if (!reader.readRecord(opcode, payload))
+            {
+                error("createReplay: the capture is truncated");
+                return false;
+            }
+
+            if (opcode != Opcode::CreateObject)
+            {
+                m_FrameOffset = recordOffset;
+                return true;
+            }
+
+            if (!createObject(payload))
+                return false;
+        }
+
+        m_FrameOffset = m_Data.size();
+        return true;
+    }
+
+    bool Replay::createObject(StreamReader& ar)
+    {
+        ObjectKind kind = ObjectKind::None;
+        uint32_t id = 0;
+        ar.value(kind);
+        ar.value(id);
+
+        // Every object has a record, so a valid ID can't be larger than the stream
+        if (ar.failed() || id == 0 || id > m_Data.size())
+        {
+            error("createReplay: the capture is corrupt");
+            return false;
+        }
+
+        RefCountPtr<IResource> object;
+
+        switch (kind)
+        {
+        case ObjectKind::Texture: {
+            TextureDesc desc;
+            ar.serialize(desc);
+            desc.isVirtual = false;
+            desc.isTiled = false;
+            if (!ar.failed())
+                object = m_Device->createTexture(desc);
+            break;
+        }
+
+        case ObjectKind::StagingTexture: {
+            TextureDesc desc;
+            CpuAccessMode cpuAccess = CpuAccessMode::Read;
+            ar.serialize(desc);
+            ar.value(cpuAccess);
+            if (!ar.failed())
+                object = m_Device->createStagingTexture(desc, cpuAccess);
+            break;
+        }
+
+        case ObjectKind::Buffer: {
+            BufferDesc desc;
+            ar.serialize(desc);
+            desc.isVirtual = false;
+            desc.isTiled = false;
+            if (!ar.failed())
+                object = m_Device->createBuffer(desc);
+            break;
+        }
+
+        case ObjectKind::Sampler: {
+            SamplerDesc desc;
+            ar.value(desc);
+            if (!ar.failed())
+                object = m_Device->createSampler(desc);
+            break;
+        }
+
+        case ObjectKind::Shader: {
+            ShaderDesc desc;
+            size_t bytecodeSize = 0;
+            ar.serialize(desc);
+            const void* bytecode = ar.bytes(bytecodeSize);
+            if (!ar.failed())
+                object = m_Device->createShader(desc, bytecode, bytecodeSize);
+            break;
+        }
+
+        case ObjectKind::InputLayout: {
+            uint32_t numAttributes = 0;
+            ar.value(numAttributes);
+            std::vector<VertexAttributeDesc> attributes;
+            for (uint32_t index = 0; index < numAttributes && !ar.failed(); index++)
+            {
+                VertexAttributeDesc attribute;
+                ar.serialize(attribute);
+                attributes.push_back(attribute);
+            }
+            IShader* vertexShader = nullptr;
+            ar.object(ObjectKind::Shader, vertexShader);
+            if (!ar.failed())
+                object = m_Device->createInputLayout(attributes.data(), numAttributes, vertexShader);
+            break;
+        }
+
+        case ObjectKind::Framebuffer: {
+            FramebufferDesc desc;
+            ar.serialize(desc);
+            if (!ar.failed())
+                object = m_Device->createFramebuffer(desc);
+            break;
+        }
+
+        case ObjectKind::GraphicsPipeline: {
+            GraphicsPipelineDesc desc;
+            IFramebuffer* framebuffer = nullptr;
+            ar.serialize(desc);
+            ar.object(ObjectKind::Framebuffer, framebuffer);
+            if (!ar.failed() && framebuffer)
+                object = m_Device->createGraphicsPipeline(desc, framebuffer);
+            break;
+        }
+
+        case ObjectKind::ComputePipeline: {
+            ComputePipelineDesc desc;
+            ar.serialize(desc);
+            if (!ar.failed())
+                object = m_Device->createComputePipeline(desc);
+            break;
+        }
+
+        case ObjectKind::MeshletPipeline: {
+            MeshletPipelineDesc desc;
+            IFramebuffer* framebuffer = nullptr;
+            ar.serialize(desc);
+            ar.object(ObjectKind::Framebuffer, framebuffer);
+            if (!ar.failed() && framebuffer)
+                object = m_Device->createMeshletPipeline(desc, framebuffer);
+            break;
+        }
+
+        case ObjectKind::BindingLayout: {
+            bool isBindless = false;
+            ar.value(isBindless);
+            if (isBindless)
+            {
+                BindlessLayoutDesc desc;
+                ar.serialize(desc);
+                if (!ar.failed())
+                    object = m_Device->createBindlessLayout(desc);
+            }
+            else
+            {
+                BindingLayoutDesc desc;
+                ar.serialize(desc);
+                if (!ar.failed())
+                    object = m_Device->createBindingLayout(desc);
+            }
+            break;
+        }
+
+        case ObjectKind::BindingSet: {
+            IBindingLayout* layout = nullptr;
+            BindingSetDesc desc;
+            ar.object(ObjectKind::BindingLayout, layout);
+            ar.serialize(desc);
+            if (!ar.failed())
+                object = m_Device->createBindingSet(desc, layout);
+            break;
+        }
+
+        case ObjectKind::DescriptorTable: {
+            IBindingLayout* layout = nullptr;
+            uint32_t capacity = 0;
+            uint32_t numItems = 0;
+            ar.object(ObjectKind::BindingLayout, layout);
+            ar.value(capacity);
+            ar.value(numItems);
+            if (ar.failed())
+                break;
+
+            DescriptorTableHandle descriptorTable = m_Device->createDescriptorTable(layout);
+            if (!descriptorTable)
+                break;
+
+            m_Device->resizeDescriptorTable(descriptorTable, capacity, false);
+            for (uint32_t index = 0; index < numItems && !ar.failed(); index++)
+            {
+                BindingSetItem item;
+                ar.serialize(item);
+                if (!ar.failed())
+                    m_Device->writeDescriptorTable(descriptorTable, item);
+            }
+            object = descriptorTable;
+            break;
+        }
+
+        case ObjectKind::CommandSignature: {
+            CommandSignatureDesc desc;
+            ar.serialize(desc);
+            if (!ar.failed())
+                object = m_Device->createCommandSignature(desc);
+            break;
+        }
+
+        case ObjectKind::QueryPool: {
+            QueryPoolDesc desc;
+            ar.serialize(desc);
+            if (!ar.failed())
+                object = m_Device->createQueryPool(desc);
+            break;
+        }
+
+        case ObjectKind::TimerQuery: {
+            object = m_Device->createTimerQuery();
+            break;
+        }
+
+        case ObjectKind::CommandList: {
+            CommandListParameters params;
+            ar.serialize(params);
+            if (!ar.failed())
+                object = m_Device->createCommandList(params);
+            break;
+        }
+
+        case ObjectKind::None:
+        default:
+            break;
+        }
+
+        if (!object)
+        {
+            std::stringstream ss;
+            ss << "createReplay: cannot create the " << getObjectKindName(kind) << " with ID " << id;
+            if (ar.failed())
+                ss << ", the capture is corrupt";
+            error(ss.str());
+            return false;
+        }
+
+        if (id > m_Objects.size())
+            m_Objects.resize(id);
+
+        m_Objects[id - 1].object = object;
+        m_Objects[id - 1].kind = kind;
+        return true;
+    }
+
+    bool Replay::replayFrame(ReplayStatistics* outStatistics)
+    {
+        ReplayStatistics statistics;
+        StreamReader reader(m_Data.data() + m_FrameOffset, m_Data.size() - m_FrameOffset, this);
+
+        // The command lists recorded since the last ExecuteCommandLists record
+        std::vector<ICommandList*> recordedCommandLists;
+
+        // The submission instances of the ExecuteCommandLists records of this frame, for the queue waits
+        std::vector<uint64_t> instances;
+
+        uint32_t numTimerQueries = 0;
+
+        while (!reader.atEnd())
+        {
+            Opcode opcode = Opcode::CreateObject;
+            StreamReader payload(nullptr, 0, nullptr);
+            if (!reader.readRecord(opcode, payload))
+            {
+                error("replayFrame: the capture is truncated");
+                return false;
+            }
+
+            switch (opcode)
+            {
+            case Opcode::RecordCommandList: {
+                ICommandList* commandList = nullptr;
+                payload.object(ObjectKind::CommandList, commandList);
+                if (!commandList)
+                {
+                    error("replayFrame: the capture is corrupt");
+                    return false;
+                }
+
+                ITimerQuery* timerQuery = nullptr;
+                if (commandList->getDesc().queueType != CommandQueue::Copy)
+                {
+                    if (numTimerQueries == m_TimerQueries.size())
+                        m_TimerQueries.push_back(m_Device->createTimerQuery());
+                    timerQuery = m_TimerQueries[numTimerQueries];
+                    ++numTimerQueries;
+                }
+
+                const auto startTime = std::chrono::high_resolution_clock::now();
+
+                commandList->open();
+                if (timerQuery)
+                    commandList->beginTimerQuery(timerQuery);
+
+                bool success = true;
+                while (success && !payload.atEnd())
+                {
+                    Opcode commandOpcode = Opcode::ClearState;
+                    StreamReader command(nullptr, 0, nullptr);
+                    success = payload.readRecord(commandOpcode, command)
+                        && replayCommand(commandList, commandOpcode, command);
+                    ++statistics.commandsReplayed;
+                }
+
+                if (timerQuery)
+                    commandList->endTimerQuery(timerQuery);
+                commandList->close();
+
+                const auto endTime = std::chrono::high_resolution_clock::now();
+                statistics.cpuRecordingTime += std::chrono::duration<double>(endTime - startTime).count();
+                ++statistics.commandListsRecorded;
+
+                if (!success)
+                {
+                    error("replayFrame: the capture contains a corrupt command");
+                    return false;
+                }
+
+                recordedCommandLists.push_back(commandList);
+                break;
+            }
+
+            case Opcode::ExecuteCommandLists: {
+                CommandQueue queue = CommandQueue::Graphics;
+                uint32_t numCommandLists = 0;
+                payload.value(queue);
+                payload.value(numCommandLists);
+                if (payload.failed() || numCommandLists != recordedCommandLists.size())
+                {
+                    error("replayFrame: the capture is corrupt");
+                    return false;
+                }
+
+                instances.push_back(m_Device->executeCommandLists(recordedCommandLists.data(), recordedCommandLists.size(), queue));
+                recordedCommandLists.clear();
+                break;
+            }
+
+            case Opcode::QueueWaitForCommandList: {
+                CommandQueue waitQueue = CommandQueue::Graphics;
+                CommandQueue executionQueue = CommandQueue::Graphics;
+                uint32_t executionIndex = 0;
+                payload.value(waitQueue);
+                payload.value(executionQueue);
+                payload.value(executionIndex);
+                if (!payload.failed() && executionIndex < instances.size())
+                    m_Device->queueWaitForCommandList(waitQueue, executionQueue, instances[executionIndex]);
+                break;
+            }
+
+            default:
+                error("replayFrame: the capture contains an unexpected record");
+                return false;
+            }
+        }
+
+        m_Device->waitForIdle();
+
+        for (uint32_t index = 0; index < numTimerQueries; index++)
+        {
+            statistics.gpuTime += double(m_Device->getTimerQueryTime(m_TimerQueries[index]));
+            m_Device->resetTimerQuery(m_TimerQueries[index]);
+        }
+
+        if (outStatistics)
+            *outStatistics = statistics;
+
+        return true;
+    }
+
+    bool Replay::replayCommand(ICommandList* commandList, Opcode opcode, StreamReader& ar)
+    {
+        switch (opcode)
+        {
+        case Opcode::ClearState: {
+            commandList->clearState();
+            return true;
+        }
+
+        case Opcode::ClearTextureFloat: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            Color clearColor;
+            ar.object(ObjectKind::Texture, texture);
+            ar.value(subresources);
+            ar.value(clearColor);
+            if (ar.failed())
+                return false;
+            commandList->clearTextureFloat(texture, subresources, clearColor);
+            return true;
+        }
+
+        case Opcode::ClearDepthStencilTexture: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            bool clearDepth = false;
+            float depth = 0.f;
+            bool clearStencil = false;
+            uint8_t stencil = 0;
+            ar.object(ObjectKind::Texture, texture);
+            ar.value(subresources);
+            ar.value(clearDepth);
+            ar.value(depth);
+            ar.value(clearStencil);
+            ar.value(stencil);
+            if (ar.failed())
+                return false;
+            commandList->clearDepthStencilTexture(texture, subresources, clearDepth, depth, clearStencil, stencil);
+            return true;
+        }
+
+        case Opcode::ClearTextureUInt: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            uint32_t clearColor = 0;
+            ar.object(ObjectKind::Texture, texture);
+            ar.value(subresources);
+            ar.value(clearColor);
+            if (ar.failed())
+                return false;
+            commandList->clearTextureUInt(texture, subresources, clearColor);
+            return true;
+        }
+
+        case Opcode::CopyTexture: {
+            ITexture* dest = nullptr;
+            ITexture* src = nullptr;
+            TextureSlice destSlice;
+            TextureSlice srcSlice;
+            ar.object(ObjectKind::Texture, dest);
+            ar.value(destSlice);
+            ar.object(ObjectKind::Texture, src);
+            ar.value(srcSlice);
+            if (ar.failed())
+                return false;
+            commandList->copyTexture(dest, destSlice, src, srcSlice);
+            return true;
+        }
+
+        case Opcode::CopyTextureToStaging: {
+            IStagingTexture* dest = nullptr;
+            ITexture* src = nullptr;
+            TextureSlice destSlice;
+            TextureSlice srcSlice;
+            ar.object(ObjectKind::StagingTexture, dest);
+            ar.value(destSlice);
+            ar.object(ObjectKind::Texture, src);
+            ar.value(srcSlice);
+            if (ar.failed())
+                return false;
+            commandList->copyTexture(dest, destSlice, src, srcSlice);
+            return true;
+        }
+
+        case Opcode::CopyTextureFromStaging: {
+            ITexture* dest = nullptr;
+            IStagingTexture* src = nullptr;
+            TextureSlice destSlice;
+            TextureSlice srcSlice;
+            ar.object(ObjectKind::Texture, dest);
+            ar.value(destSlice);
+            ar.object(ObjectKind::StagingTexture, src);
+            ar.value(srcSlice);
+            if (ar.failed())
+                return false;
+            commandList->copyTexture(dest, destSlice, src, srcSlice);
+            return true;
+        }
+
+        case Opcode::WriteTexture: {
+            ITexture* dest = nullptr;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            uint64_t rowPitch = 0;
+            uint64_t depthPitch = 0;
+            size_t dataSize = 0;
+            ar.object(ObjectKind::Texture, dest);
+            ar.value(arraySlice);
+            ar.value(mipLevel);
+            ar.value(rowPitch);
+            ar.value(depthPitch);
+            const void* data = ar.bytes(dataSize);
+            if (ar.failed())
+                return false;
+            commandList->writeTexture(dest, arraySlice, mipLevel, data, size_t(rowPitch), size_t(depthPitch));
+            return true;
+        }
+
+        case Opcode::WriteTextureSubresources: {
+            ITexture* dest = nullptr;
+            TextureSubresourceSet subresources;
+            uint64_t numSubresources = 0;
+            ar.object(ObjectKind::Texture, dest);
+            ar.value(subresources);
+            ar.value(numSubresources);
+
+            std::vector<TextureSubresourceData> data;
+            for (uint64_t index = 0; index < numSubresources && !ar.failed(); index++)
+            {
+                uint64_t rowPitch = 0;
+                uint64_t depthPitch = 0;
+                size_t dataSize = 0;
+                ar.value(rowPitch);
+                ar.value(depthPitch);
+
+                TextureSubresourceData& subresourceData = data.emplace_back();
+                subresourceData.data = ar.bytes(dataSize);
+                subresourceData.rowPitch = size_t(rowPitch);
+                subresourceData.depthPitch = size_t(depthPitch);
+            }
+            if (ar.failed())
+                return false;
+            commandList->writeTexture(dest, subresources, data.data(), data.size());
+            return true;
+        }
+
+        case Opcode::ResolveTexture: {
+            ITexture* dest = nullptr;
+            ITexture* src = nullptr;
+            TextureSubresourceSet dstSubresources;
+            TextureSubresourceSet srcSubresources;
+            ar.object(ObjectKind::Texture, dest);
+            ar.value(dstSubresources);
+            ar.object(ObjectKind::Texture, src);
+            ar.value(srcSubresources);
+            if (ar.failed())
+                return false;
+            commandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
+            return true;
+        }
+
+        case Opcode::WriteBuffer: {
+            IBuffer* buffer = nullptr;
+            uint64_t destOffsetBytes = 0;
+            size_t dataSize = 0;
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(destOffsetBytes);
+            const void* data = ar.bytes(dataSize);
+            if (ar.failed())
+                return false;
+            commandList->writeBuffer(buffer, data, dataSize, destOffsetBytes);
+            return true;
+        }
+
+        case Opcode::ClearBufferUInt: {
+            IBuffer* buffer = nullptr;
+            uint32_t clearValue = 0;
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(clearValue);
+            if (ar.failed())
+                return false;
+            commandList->clearBufferUInt(buffer, clearValue);
+            return true;
+        }
+
+        case Opcode::CopyBuffer: {
+            IBuffer* dest = nullptr;
+            IBuffer* src = nullptr;
+            uint64_t destOffsetBytes = 0;
+            uint64_t srcOffsetBytes = 0;
+            uint64_t dataSizeBytes = 0;
+            ar.object(ObjectKind::Buffer, dest);
+            ar.value(destOffsetBytes);
+            ar.object(ObjectKind::Buffer, src);
+            ar.value(srcOffsetBytes);
+            ar.value(dataSizeBytes);
+            if (ar.failed())
+                return false;
+            commandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+            return true;
+        }
+
+        case Opcode::SetPushConstants: {
+            size_t byteSize = 0;
+            const void* data = ar.bytes(byteSize);
+            if (ar.failed())
+                return false;
+            commandList->setPushConstants(data, byteSize);
+            return true;
+        }
+
+        case Opcode::SetGraphicsState: {
+            GraphicsState state;
+            ar.serialize(state);
+            if (ar.failed())
+                return false;
+            commandList->setGraphicsState(state);
+            return true;
+        }
+
+        case Opcode::SetGraphicsBindings: {
+            BindingSetVector bindings;
+            serializeBindingSets(ar, bindings);
+            if (ar.failed())
+                return false;
+            commandList->setGraphicsBindings(bindings);
+            return true;
+        }
+
+        case Opcode::SetGraphicsVertexBuffers: {
+            VertexBufferBindingVector vertexBuffers;
+            IndexBufferBinding indexBuffer;
+            serializeObjects(ar, vertexBuffers);
+            ar.serialize(indexBuffer);
+            if (ar.failed())
+                return false;
+            commandList->setGraphicsVertexBuffers(vertexBuffers, indexBuffer);
+            return true;
+        }
+
+        case Opcode::Draw:
+        case Opcode::DrawIndexed: {
+            DrawArguments args;
+            ar.value(args);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::Draw)
+                commandList->draw(args);
+            else
+                commandList->drawIndexed(args);
+            return true;
+        }
+
+        case Opcode::DrawIndirect:
+        case Opcode::DrawIndexedIndirect: {
+            uint32_t offsetBytes = 0;
+            uint32_t drawCount = 0;
+            ar.value(offsetBytes);
+            ar.value(drawCount);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::DrawIndirect)
+                commandList->drawIndirect(offsetBytes, drawCount);
+            else
+                commandList->drawIndexedIndirect(offsetBytes, drawCount);
+            return true;
+        }
+
+        case Opcode::DrawIndirectCount:
+        case Opcode::DrawIndexedIndirectCount:
+        case Opcode::DispatchMeshIndirectCount: {
+            uint32_t paramOffsetBytes = 0;
+            IBuffer* countBuffer = nullptr;
+            uint32_t countOffsetBytes = 0;
+            uint32_t maxDrawCount = 0;
+            ar.value(paramOffsetBytes);
+            ar.object(ObjectKind::Buffer, countBuffer);
+            ar.value(countOffsetBytes);
+            ar.value(maxDrawCount);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::DrawIndirectCount)
+                commandList->drawIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+            else if (opcode == Opcode::DrawIndexedIndirectCount)
+                commandList->drawIndexedIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+            else
+                commandList->dispatchMeshIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+            return true;
+        }
+
+        case Opcode::SetComputeState: {
+            ComputeState state;
+            ar.serialize(state);
+            if (ar.failed())
+                return false;
+            commandList->setComputeState(state);
+            return true;
+        }
+
+        case Opcode::Dispatch:
+        case Opcode::DispatchMesh: {
+            uint32_t groupsX = 0;
+            uint32_t groupsY = 0;
+            uint32_t groupsZ = 0;
+            ar.value(groupsX);
+            ar.value(groupsY);
+            ar.value(groupsZ);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::Dispatch)
+                commandList->dispatch(groupsX, groupsY, groupsZ);
+            else
+                commandList->dispatchMesh(groupsX, groupsY, groupsZ);
+            return true;
+        }
+
+        case Opcode::DispatchIndirect: {
+            uint32_t offsetBytes = 0;
+            ar.value(offsetBytes);
+            if (ar.failed())
+                return false;
+            commandList->dispatchIndirect(offsetBytes);
+            return true;
+        }
+
+        case Opcode::SetMeshletState: {
+            MeshletState state;
+            ar.serialize(state);
+            if (ar.failed())
+                return false;
+            commandList->setMeshletState(state);
+            return true;
+        }
+
+        case Opcode::DispatchMeshIndirect: {
+            uint32_t offsetBytes = 0;
+            uint32_t drawCount = 0;
+            ar.value(offsetBytes);
+            ar.value(drawCount);
+            if (ar.failed())
+                return false;
+            commandList->dispatchMeshIndirect(offsetBytes, drawCount);
+            return true;
+        }
+
+        case Opcode::ExecuteIndirect: {
+            ICommandSignature* signature = nullptr;
+            IBuffer* argumentBuffer = nullptr;
+            uint32_t argumentOffsetBytes = 0;
+            uint32_t maxCommandCount = 0;
+            IBuffer* countBuffer = nullptr;
+            uint32_t countOffsetBytes = 0;
+            ar.object(ObjectKind::CommandSignature, signature);
+            ar.object(ObjectKind::Buffer, argumentBuffer);
+            ar.value(argumentOffsetBytes);
+            ar.value(maxCommandCount);
+            ar.object(ObjectKind::Buffer, countBuffer);
+            ar.value(countOffsetBytes);
+            if (ar.failed())
+                return false;
+            commandList->executeIndirect(signature, argumentBuffer, argumentOffsetBytes, maxCommandCount, countBuffer, countOffsetBytes);
+            return true;
+        }
+
+        case Opcode::BeginTimerQuery:
+        case Opcode::EndTimerQuery: {
+            ITimerQuery* query = nullptr;
+            ar.object(ObjectKind::TimerQuery, query);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::BeginTimerQuery)
+                commandList->beginTimerQuery(query);
+            else
+                commandList->endTimerQuery(query);
+            return true;
+        }
+
+        case Opcode::ResetQueries: {
+            IQueryPool* pool = nullptr;
+            uint32_t firstQuery = 0;
+            uint32_t numQueries = 0;
+            ar.object(ObjectKind::QueryPool, pool);
+            ar.value(firstQuery);
+            ar.value(numQueries);
+            if (ar.failed())
+                return false;
+            commandList->resetQueries(pool, firstQuery, numQueries);
+            return true;
+        }
+
+        case Opcode::BeginQuery:
+        case Opcode::EndQuery: {
+            IQueryPool* pool = nullptr;
+            uint32_t queryIndex = 0;
+            ar.object(ObjectKind::QueryPool, pool);
+            ar.value(queryIndex);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::BeginQuery)
+                commandList->beginQuery(pool, queryIndex);
+            else
+                commandList->endQuery(pool, queryIndex);
+            return true;
+        }
+
+        case Opcode::ResolveQueries: {
+            IQueryPool* pool = nullptr;
+            uint32_t firstQuery = 0;
+            uint32_t numQueries = 0;
+            IBuffer* buffer = nullptr;
+            uint64_t offsetBytes = 0;
+            ar.object(ObjectKind::QueryPool, pool);
+            ar.value(firstQuery);
+            ar.value(numQueries);
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(offsetBytes);
+            if (ar.failed())
+                return false;
+            commandList->resolveQueries(pool, firstQuery, numQueries, buffer, offsetBytes);
+            return true;
+        }
+
+        case Opcode::SetPredication: {
+            IBuffer* buffer = nullptr;
+            uint64_t offsetBytes = 0;
+            PredicationOp op = PredicationOp::SkipIfZero;
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(offsetBytes);
+            ar.value(op);
+            if (ar.failed())
+                return false;
+            commandList->setPredication(buffer, offsetBytes, op);
+            return true;
+        }
+
+        case Opcode::BeginMarker: {
+            std::string name;
+            ar.string(name);
+            if (ar.failed())
+                return false;
+            commandList->beginMarker(name.c_str());
+            return true;
+        }
+
+        case Opcode::EndMarker: {
+            commandList->endMarker();
+            return true;
+        }
+
+        case Opcode::SetEnableAutomaticBarriers: {
+            bool enable = true;
+            ar.value(enable);
+            if (ar.failed())
+                return false;
+            commandList->setEnableAutomaticBarriers(enable);
+            return true;
+        }
+
+        case Opcode::SetResourceStatesForBindingSet: {
+            bool isDescriptorTable = false;
+            IBindingSet* bindingSet = nullptr;
+            ar.value(isDescriptorTable);
+            ar.object(isDescriptorTable ? ObjectKind::DescriptorTable : ObjectKind::BindingSet, bindingSet);
+            if (ar.failed())
+                return false;
+            commandList->setResourceStatesForBindingSet(bindingSet);
+            return true;
+        }
+
+        case Opcode::SetEnableUavBarriersForTexture: {
+            ITexture* texture = nullptr;
+            bool enableBarriers = true;
+            ar.object(ObjectKind::Texture, texture);
+            ar.value(enableBarriers);
+            if (ar.failed())
+                return false;
+            commandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+            return true;
+        }
+
+        case Opcode::SetEnableUavBarriersForBuffer: {
+            IBuffer* buffer = nullptr;
+            bool enableBarriers = true;
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(enableBarriers);
+            if (ar.failed())
+                return false;
+            commandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+            return true;
+        }
+
+        case Opcode::BeginTrackingTextureState:
+        case Opcode::SetTextureState:
+        case Opcode::BeginTextureStateTransition: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            ResourceStates stateBits = ResourceStates::Unknown;
+            ar.object(ObjectKind::Texture, texture);
+            ar.value(subresources);
+            ar.value(stateBits);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::BeginTrackingTextureState)
+                commandList->beginTrackingTextureState(texture, subresources, stateBits);
+            else if (opcode == Opcode::SetTextureState)
+                commandList->setTextureState(texture, subresources, stateBits);
+            else
+                commandList->beginTextureStateTransition(texture, subresources, stateBits);
+            return true;
+        }
+
+        case Opcode::BeginTrackingBufferState:
+        case Opcode::SetBufferState:
+        case Opcode::BeginBufferStateTransition: {
+            IBuffer* buffer = nullptr;
+            ResourceStates stateBits = ResourceStates::Unknown;
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(stateBits);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::BeginTrackingBufferState)
+                commandList->beginTrackingBufferState(buffer, stateBits);
+            else if (opcode == Opcode::SetBufferState)
+                commandList->setBufferState(buffer, stateBits);
+            else
+                commandList->beginBufferStateTransition(buffer, stateBits);
+            return true;
+        }
+
+        case Opcode::SetPermanentTextureState: {
+            ITexture* texture = nullptr;
+            ResourceStates stateBits = ResourceStates::Unknown;
+            ar.object(ObjectKind::Texture, texture);
+            ar.value(stateBits);
+            if (ar.failed())
+                return false;
+            commandList->setPermanentTextureState(texture, stateBits);
+            return true;
+        }
+
+        case Opcode::SetPermanentBufferState: {
+            IBuffer* buffer = nullptr;
+            ResourceStates stateBits = ResourceStates::Unknown;
+            ar.object(ObjectKind::Buffer, buffer);
+            ar.value(stateBits);
+            if (ar.failed())
+                return false;
+            commandList->setPermanentBufferState(buffer, stateBits);
+            return true;
+        }
+
+        case Opcode::CommitBarriers: {
+            commandList->commitBarriers();
+            return true;
+        }
+
+        case Opcode::EndTextureStateTransition:
+        case Opcode::TextureAliasingBarrier: {
+            ITexture* texture = nullptr;
+            ar.object(ObjectKind::Texture, texture);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::EndTextureStateTransition)
+                commandList->endTextureStateTransition(texture);
+            else
+                commandList->textureAliasingBarrier(texture);
+            return true;
+        }
+
+        case Opcode::EndBufferStateTransition:
+        case Opcode::BufferAliasingBarrier: {
+            IBuffer* buffer = nullptr;
+            ar.object(ObjectKind::Buffer, buffer);
+            if (ar.failed())
+                return false;
+            if (opcode == Opcode::EndBufferStateTransition)
+                commandList->endBufferStateTransition(buffer);
+            else
+                commandList->bufferAliasingBarrier(buffer);
+            return true;
+        }
+
+        default:
+            return false;
+        }
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,704 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace nvrhi::capture
+{
+    constexpr uint32_t c_StreamMagic = 0x4352564e; // 'NVRC'
+    // Incremented whenever the layout of a record or of a serialized description changes
+    constexpr uint32_t c_StreamVersion = 2;
+
+    struct StreamHeader
+    {
+        uint32_t magic = c_StreamMagic;
+        uint32_t streamVersion = c_StreamVersion;
+        uint32_t headerVersion = c_HeaderVersion;
+        GraphicsAPI graphicsAPI = GraphicsAPI::D3D12;
+    };
+
+    // Objects are referenced in the stream by their ID, which is their index in the object table plus one.
+    // ID 0 is a NULL reference.
+    enum class ObjectKind : uint8_t
+    {
+        None,
+        Texture,
+        StagingTexture,
+        Buffer,
+        Sampler,
+        Shader,
+        InputLayout,
+        Framebuffer,
+        GraphicsPipeline,
+        ComputePipeline,
+        MeshletPipeline,
+        BindingLayout,
+        BindingSet,
+        DescriptorTable,
+        CommandSignature,
+        QueryPool,
+        TimerQuery,
+        CommandList
+    };
+
+    // The stream is a sequence of records: [Opcode : uint16][payload size : uint32][payload].
+    // The top level of the stream contains CreateObject records for every referenced object, dependencies first,
+    // followed by the captured frame: RecordCommandList, ExecuteCommandLists and QueueWaitForCommandList records,
+    // in the order in which the command lists were executed. The payload of RecordCommandList is the command list ID,
+    // followed by a nested sequence of command records.
+    enum class Opcode : uint16_t
+    {
+        // Top level
+        CreateObject = 1,
+        RecordCommandList,
+        ExecuteCommandLists,
+        QueueWaitForCommandList,
+
+        // Command lists
+        ClearState = 100,
+        ClearTextureFloat,
+        ClearDepthStencilTexture,
+        ClearTextureUInt,
+        CopyTexture,
+        CopyTextureToStaging,
+        CopyTextureFromStaging,
+        WriteTexture,
+        WriteTextureSubresources,
+        ResolveTexture,
+        WriteBuffer,
+        ClearBufferUInt,
+        CopyBuffer,
+        SetPushConstants,
+        SetGraphicsState,
+        SetGraphicsBindings,
+        SetGraphicsVertexBuffers,
+        Draw,
+        DrawIndexed,
+        DrawIndirect,
+        DrawIndexedIndirect,
+        DrawIndirectCount,
+        DrawIndexedIndirectCount,
+        SetComputeState,
+        Dispatch,
+        DispatchIndirect,
+        SetMeshletState,
+        DispatchMesh,
+        DispatchMeshIndirect,
+        DispatchMeshIndirectCount,
+        ExecuteIndirect,
+        BeginTimerQuery,
+        EndTimerQuery,
+        ResetQueries,
+        BeginQuery,
+        EndQuery,
+        ResolveQueries,
+        SetPredication,
+        BeginMarker,
+        EndMarker,
+        SetEnableAutomaticBarriers,
+        SetResourceStatesForBindingSet,
+        SetEnableUavBarriersForTexture,
+        SetEnableUavBarriersForBuffer,
+        BeginTrackingTextureState,
+        BeginTrackingBufferState,
+        SetTextureState,
+        SetBufferState,
+        SetPermanentTextureState,
+        SetPermanentBufferState,
+        CommitBarriers,
+        BeginTextureStateTransition,
+        EndTextureStateTransition,
+        BeginBufferStateTransition,
+        EndBufferStateTransition,
+        TextureAliasingBarrier,
+        BufferAliasingBarrier
+    };
+
+    [[nodiscard]] ObjectKind getBindingResourceKind(ResourceType type);
+
+    // Returns the number of bytes that writeTexture reads from the data pointer for one subresource
+    [[nodiscard]] size_t getSubresourceDataSize(const TextureDesc& desc, MipLevel mipLevel, size_t rowPitch, size_t depthPitch);
+
+    class IObjectMap
+    {
+    public:
+        virtual ~IObjectMap() = default;
+        virtual uint32_t getObjectId(IResource* object, ObjectKind kind) = 0;
+    };
+
+    class IObjectResolver
+    {
+    public:
+        virtual ~IObjectResolver() = default;
+        virtual IResource* getObject(uint32_t id, ObjectKind kind) = 0;
+    };
+
+    class StreamWriter
+    {
+    public:
+        static constexpr bool IsReading = false;
+
+        StreamWriter(std::vector<uint8_t>& data, IObjectMap* objects)
+            : m_Data(data)
+            , m_Objects(objects)
+        { }
+
+        void beginRecord(Opcode opcode)
+        {
+            value(opcode);
+            m_RecordSizeOffset = m_Data.size();
+            value(uint32_t(0));
+        }
+
+        void endRecord()
+        {
+            const uint32_t size = uint32_t(m_Data.size() - m_RecordSizeOffset - sizeof(uint32_t));
+            memcpy(m_Data.data() + m_RecordSizeOffset, &size, sizeof(size));
+        }
+
+        void raw(const void* data, size_t size)
+        {
+            m_Data.insert(m_Data.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        }
+
+        template<typename T>
+        void value(const T& v)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written as values");
+            raw(&v, sizeof(T));
+        }
+
+        void string(const std::string& s)
+        {
+            value(uint32_t(s.size()));
+            raw(s.data(), s.size());
+        }
+
+        void bytes(const void* data, size_t size)
+        {
+            value(uint64_t(size));
+            raw(data, size);
+        }
+
+        template<typename T>
+        void object(ObjectKind kind, T* const& object)
+        {
+            value(object && m_Objects ? m_Objects->getObjectId(object, kind) : 0u);
+        }
+
+        template<typename T>
+        void object(ObjectKind kind, const RefCountPtr<T>& object)
+        {
+            T* const ptr = object.Get();
+            this->object(kind, ptr);
+        }
+
+        // The serialize functions are shared with StreamReader and take non-const references,
+        // but they don't modify the object when writing.
+        template<typename T>
+        void serialize(const T& v);
+
+    private:
+        std::vector<uint8_t>& m_Data;
+        IObjectMap* m_Objects;
+        size_t m_RecordSizeOffset = 0;
+    };
+
+    class StreamReader
+    {
+    public:
+        static constexpr bool IsReading = true;
+
+        StreamReader(const void* data, size_t size, IObjectResolver* objects)
+            : m_Data(static_cast<const uint8_t*>(data))
+            , m_Size(size)
+            , m_Objects(objects)
+        { }
+
+        [[nodiscard]] bool failed() const { return m_Failed; }
+        [[nodiscard]] bool atEnd() const { return m_Offset >= m_Size; }
+        [[nodiscard]] size_t getOffset() const { return m_Offset; }
+
+        // Reads the next record and creates a reader for its payload
+        bool readRecord(Opcode& outOpcode, StreamReader& outPayload)
+        {
+            uint32_t size = 0;
+            value(outOpcode);
+            value(size);
+            const void* payload = raw(size);
+            if (!payload)
+                return false;
+
+            outPayload = StreamReader(payload, size, m_Objects);
+            return true;
+        }
+
+        const void* raw(size_t size)
+        {
+            if (m_Failed || size > m_Size - m_Offset)
+            {
+                m_Failed = true;
+                return nullptr;
+            }
+
+            const void* result = m_Data + m_Offset;
+            m_Offset += size;
+            return result;
+        }
+
+        template<typename T>
+        void value(T& v)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read as values");
+            const void* data = raw(sizeof(T));
+            if (data)
+                memcpy(&v, data, sizeof(T));
+        }
+
+        void string(std::string& s)
+        {
+            uint32_t size = 0;
+            value(size);
+            const void* data = raw(size);
+            if (data)
+                s.assign(static_cast<const char*>(data), size);
+        }
+
+        // Returns a pointer into the stream, valid for the lifetime of the stream data
+        const void* bytes(size_t& outSize)
+        {
+            uint64_t size = 0;
+            value(size);
+            outSize = size_t(size);
+            return raw(outSize);
+        }
+
+        template<typename T>
+        void object(ObjectKind kind, T*& object)
+        {
+            uint32_t id = 0;
+            value(id);
+            IResource* resource = id && m_Objects ? m_Objects->getObject(id, kind) : nullptr;
+            if (id && !resource)
+                m_Failed = true;
+            object = static_cast<T*>(resource);
+        }
+
+        template<typename T>
+        void object(ObjectKind kind, RefCountPtr<T>& object)
+        {
+            T* ptr = nullptr;
+            this->object(kind, ptr);
+            object = ptr;
+        }
+
+        template<typename T>
+        void serialize(T& v);
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+        size_t m_Offset = 0;
+        IObjectResolver* m_Objects = nullptr;
+        bool m_Failed = false;
+    };
+
+    // Serialization of the NVRHI structures, shared between StreamWriter and StreamReader.
+    // Plain structures without object references are written as values by the callers.
+
+    template<typename Archive, typename T, uint32_t N>
+    void serializeValues(Archive& ar, static_vector<T, N>& v)
+    {
+        uint32_t size = uint32_t(v.size());
+        ar.value(size);
+        if constexpr (Archive::IsReading)
+        {
+            if (size > N)
+            {
+                // Force a read failure, the stream is corrupt
+                ar.raw(~size_t(0));
+                return;
+            }
+            v.resize(size);
+        }
+        for (T& item : v)
+            ar.value(item);
+    }
+
+    template<typename Archive, typename T, uint32_t N>
+    void serializeObjects(Archive& ar, static_vector<T, N>& v)
+    {
+        uint32_t size = uint32_t(v.size());
+        ar.value(size);
+        if constexpr (Archive::IsReading)
+        {
+            if (size > N)
+            {
+                ar.raw(~size_t(0));
+                return;
+            }
+            v.resize(size);
+        }
+        for (T& item : v)
+            serialize(ar, item);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, TextureDesc& d)
+    {
+        ar.value(d.width);
+        ar.value(d.height);
+        ar.value(d.depth);
+        ar.value(d.arraySize);
+        ar.value(d.mipLevels);
+        ar.value(d.sampleCount);
+        ar.value(d.sampleQuality);
+        ar.value(d.format);
+        ar.value(d.dimension);
+        ar.string(d.debugName);
+        ar.value(d.isShaderResource);
+        ar.value(d.isRenderTarget);
+        ar.value(d.isUAV);
+        ar.value(d.isTypeless);
+        ar.value(d.isShadingRateSurface);
+        ar.value(d.isTransient);
+        ar.value(d.isVirtual);
+        ar.value(d.isTiled);
+        ar.value(d.clearValue);
+        ar.value(d.useClearValue);
+        ar.value(d.initialState);
+        ar.value(d.keepInitialState);
+        ar.value(d.trackLiveness);
+        ar.value(d.allowDirectWrite);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, BufferDesc& d)
+    {
+        ar.value(d.byteSize);
+        ar.value(d.structStride);
+        ar.value(d.maxVersions);
+        ar.string(d.debugName);
+        ar.value(d.format);
+        ar.value(d.canHaveUAVs);
+        ar.value(d.canHaveTypedViews);
+        ar.value(d.canHaveRawViews);
+        ar.value(d.isVertexBuffer);
+        ar.value(d.isIndexBuffer);
+        ar.value(d.isConstantBuffer);
+        ar.value(d.isDrawIndirectArgs);
+        ar.value(d.isAccelStructBuildInput);
+        ar.value(d.isAccelStructStorage);
+        ar.value(d.isShaderBindingTable);
+        ar.value(d.isPredicationBuffer);
+        ar.value(d.isVolatile);
+        ar.value(d.isVirtual);
+        ar.value(d.isTiled);
+        ar.value(d.initialState);
+        ar.value(d.keepInitialState);
+        ar.value(d.cpuAccess);
+        ar.value(d.preferDeviceLocal);
+        ar.value(d.trackLiveness);
+        ar.value(d.isGpuAddressable);
+    }
+
+    // The NVAPI custom semantics and coordinate swizzling arrays are not serialized
+    template<typename Archive>
+    void serialize(Archive& ar, ShaderDesc& d)
+    {
+        ar.value(d.shaderType);
+        ar.string(d.debugName);
+        ar.string(d.entryName);
+        ar.value(d.hlslExtensionsUAV);
+        ar.value(d.useSpecificShaderExt);
+        ar.value(d.fastGSFlags);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, VertexAttributeDesc& d)
+    {
+        ar.string(d.name);
+        ar.value(d.format);
+        ar.value(d.arraySize);
+        ar.value(d.bufferIndex);
+        ar.value(d.offset);
+        ar.value(d.elementStride);
+        ar.value(d.isInstanced);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, FramebufferAttachment& d)
+    {
+        ar.object(ObjectKind::Texture, d.texture);
+        ar.value(d.subresources);
+        ar.value(d.format);
+        ar.value(d.isReadOnly);
+        ar.value(d.loadOp);
+        ar.value(d.storeOp);
+        ar.value(d.clearColor);
+        ar.value(d.clearDepth);
+        ar.value(d.clearStencil);
+        ar.object(ObjectKind::Texture, d.resolveTexture);
+        ar.value(d.resolveSubresources);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, FramebufferDesc& d)
+    {
+        serializeObjects(ar, d.colorAttachments);
+        serialize(ar, d.depthAttachment);
+        serialize(ar, d.shadingRateAttachment);
+    }
+
+    template<typename Archive, uint32_t N>
+    void serializeBindingLayouts(Archive& ar, static_vector<BindingLayoutHandle, N>& layouts)
+    {
+        uint32_t size = uint32_t(layouts.size());
+        ar.value(size);
+        if constexpr (Archive::IsReading)
+        {
+            if (size > N)
+            {
+                ar.raw(~size_t(0));
+                return;
+            }
+            layouts.resize(size);
+        }
+        for (BindingLayoutHandle& layout : layouts)
+            ar.object(ObjectKind::BindingLayout, layout);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, GraphicsPipelineDesc& d)
+    {
+        ar.value(d.primType);
+        ar.value(d.patchControlPoints);
+        ar.object(ObjectKind::InputLayout, d.inputLayout);
+        ar.object(ObjectKind::Shader, d.VS);
+        ar.object(ObjectKind::Shader, d.HS);
+        ar.object(ObjectKind::Shader, d.DS);
+        ar.object(ObjectKind::Shader, d.GS);
+        ar.object(ObjectKind::Shader, d.PS);
+        ar.value(d.renderState);
+        ar.value(d.shadingRateState);
+        serializeBindingLayouts(ar, d.bindingLayouts);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, ComputePipelineDesc& d)
+    {
+        ar.object(ObjectKind::Shader, d.CS);
+        serializeBindingLayouts(ar, d.bindingLayouts);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, MeshletPipelineDesc& d)
+    {
+        ar.value(d.primType);
+        ar.object(ObjectKind::Shader, d.AS);
+        ar.object(ObjectKind::Shader, d.MS);
+        ar.object(ObjectKind::Shader, d.PS);
+        ar.value(d.renderState);
+        serializeBindingLayouts(ar, d.bindingLayouts);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, BindingLayoutDesc& d)
+    {
+        ar.value(d.visibility);
+        ar.value(d.registerSpace);
+        ar.value(d.registerSpaceIsDescriptorSet);
+        ar.value(d.usePushDescriptors);
+        serializeValues(ar, d.bindings);
+        ar.value(d.bindingOffsets);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, BindlessLayoutDesc& d)
+    {
+        ar.value(d.visibility);
+        ar.value(d.firstSlot);
+        ar.value(d.maxCapacity);
+        ar.value(d.layoutType);
+        serializeValues(ar, d.registerSpaces);
+    }
+
+    // The item is written with a NULL resource handle, followed by the reference to the resource,
+    // whose kind is derived from the resource type in the item
+    template<typename Archive>
+    void serialize(Archive& ar, BindingSetItem& d)
+    {
+        if constexpr (Archive::IsReading)
+        {
+            ar.value(d);
+            ar.object(getBindingResourceKind(d.type), d.resourceHandle);
+        }
+        else
+        {
+            BindingSetItem item = d;
+            item.resourceHandle = nullptr;
+            ar.value(item);
+            ar.object(getBindingResourceKind(d.type), d.resourceHandle);
+        }
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, BindingSetDesc& d)
+    {
+        serializeObjects(ar, d.bindings);
+        ar.value(d.trackLiveness);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, CommandSignatureDesc& d)
+    {
+        serializeValues(ar, d.arguments);
+        ar.value(d.byteStride);
+        ar.object(ObjectKind::GraphicsPipeline, d.graphicsPipeline);
+        ar.object(ObjectKind::MeshletPipeline, d.meshletPipeline);
+        ar.object(ObjectKind::ComputePipeline, d.computePipeline);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, QueryPoolDesc& d)
+    {
+        ar.value(d.type);
+        ar.value(d.count);
+        ar.string(d.debugName);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, CommandListParameters& d)
+    {
+        ar.value(d.enableImmediateExecution);
+        ar.value(d.uploadChunkSize);
+        ar.value(d.scratchChunkSize);
+        ar.value(d.scratchMaxMemory);
+        ar.value(d.blasBatchScratchSize);
+        ar.value(d.queueType);
+    }
+
+    template<typename Archive, uint32_t N>
+    void serializeBindingSets(Archive& ar, static_vector<IBindingSet*, N>& bindings)
+    {
+        uint32_t size = uint32_t(bindings.size());
+        ar.value(size);
+        if constexpr (Archive::IsReading)
+        {
+            if (size > N)
+            {
+                ar.raw(~size_t(0));
+                return;
+            }
+            bindings.resize(size);
+        }
+        for (IBindingSet*& bindingSet : bindings)
+        {
+            // Descriptor tables are mixed with binding sets in the binding arrays, store the kind with the reference
+            bool isDescriptorTable = false;
+            if constexpr (!Archive::IsReading)
+                isDescriptorTable = bindingSet && bindingSet->getDesc() == nullptr;
+            ar.value(isDescriptorTable);
+            ar.object(isDescriptorTable ? ObjectKind::DescriptorTable : ObjectKind::BindingSet, bindingSet);
+        }
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, VertexBufferBinding& d)
+    {
+        ar.object(ObjectKind::Buffer, d.buffer);
+        ar.value(d.slot);
+        ar.value(d.offset);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, IndexBufferBinding& d)
+    {
+        ar.object(ObjectKind::Buffer, d.buffer);
+        ar.value(d.format);
+        ar.value(d.offset);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, ViewportState& d)
+    {
+        serializeValues(ar, d.viewports);
+        serializeValues(ar, d.scissorRects);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, GraphicsState& d)
+    {
+        ar.object(ObjectKind::GraphicsPipeline, d.pipeline);
+        ar.object(ObjectKind::Framebuffer, d.framebuffer);
+        serialize(ar, d.viewport);
+        ar.value(d.shadingRateState);
+        ar.value(d.blendConstantColor);
+        ar.value(d.dynamicStencilRefValue);
+        serializeBindingSets(ar, d.bindings);
+        serializeObjects(ar, d.vertexBuffers);
+        serialize(ar, d.indexBuffer);
+        ar.object(ObjectKind::Buffer, d.indirectParams);
+        ar.object(ObjectKind::Buffer, d.indirectCountBuffer);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, ComputeState& d)
+    {
+        ar.object(ObjectKind::ComputePipeline, d.pipeline);
+        serializeBindingSets(ar, d.bindings);
+        ar.object(ObjectKind::Buffer, d.indirectParams);
+        ar.object(ObjectKind::Buffer, d.indirectCountBuffer);
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar, MeshletState& d)
+    {
+        ar.object(ObjectKind::MeshletPipeline, d.pipeline);
+        ar.object(ObjectKind::Framebuffer, d.framebuffer);
+        serialize(ar, d.viewport);
+        ar.value(d.blendConstantColor);
+        ar.value(d.dynamicStencilRefValue);
+        serializeBindingSets(ar, d.bindings);
+        ar.object(ObjectKind::Buffer, d.indirectParams);
+        ar.object(ObjectKind::Buffer, d.indirectCountBuffer);
+    }
+
+    template<typename T>
+    void StreamWriter::serialize(const T& v)
+    {
+        nvrhi::capture::serialize(*this, const_cast<T&>(v));
+    }
+
+    template<typename T>
+    void StreamReader::serialize(T& v)
+    {
+        nvrhi::capture::serialize(*this, v);
+    }
+
+} // namespace nvrhi::capture
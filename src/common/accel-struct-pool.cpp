@@ -0,0 +1,150 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "accel-struct-pool.h"
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi
+{
+    bool AccelStructPool::allocateFromBlock(Block& block, uint64_t size, uint64_t& outOffset)
+    {
+        // First fit: the free ranges are always aligned, and so are the allocation sizes
+        for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+        {
+            if (it->second < size)
+                continue;
+
+            outOffset = it->first;
+            const uint64_t remainingSize = it->second - size;
+            block.freeRanges.erase(it);
+
+            if (remainingSize > 0)
+                block.freeRanges[outOffset + size] = remainingSize;
+
+            block.allocatedSize += size;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool AccelStructPool::allocate(uint64_t size, Allocation& outAllocation)
+    {
+        size = align(size, c_Alignment);
+
+        if (size == 0 || size > m_BlockSize / 4)
+            return false;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (Block& block : m_Blocks)
+        {
+            uint64_t offset = 0;
+            if (allocateFromBlock(block, size, offset))
+            {
+                outAllocation.buffer = block.buffer;
+                outAllocation.offset = offset;
+                outAllocation.size = size;
+                return true;
+            }
+        }
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = m_BlockSize;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.isAccelStructStorage = true;
+        bufferDesc.initialState = ResourceStates::AccelStructBuildBlas;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = "AccelStructPool";
+
+        BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+        if (!buffer)
+            return false;
+
+        Block& block = m_Blocks.emplace_back();
+        block.buffer = buffer;
+        block.freeRanges[0] = m_BlockSize;
+
+        uint64_t offset = 0;
+        [[maybe_unused]] const bool allocated = allocateFromBlock(block, size, offset);
+        assert(allocated);
+
+        outAllocation.buffer = block.buffer;
+        outAllocation.offset = offset;
+        outAllocation.size = size;
+        return true;
+    }
+
+    void AccelStructPool::release(const Allocation& allocation)
+    {
+        if (!allocation.valid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto blockIt = std::find_if(m_Blocks.begin(), m_Blocks.end(),
+            [&allocation](const Block& block) { return block.buffer == allocation.buffer; });
+
+        assert(blockIt != m_Blocks.end());
+        if (blockIt == m_Blocks.end())
+            return;
+
+        Block& block = *blockIt;
+        uint64_t offset = allocation.offset;
+        uint64_t size = allocation.size;
+
+        // Merge with the following free range
+        auto next = block.freeRanges.lower_bound(offset);
+        if (next != block.freeRanges.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next = block.freeRanges.erase(next);
+        }
+
+        // Merge with the preceding free range
+        if (next != block.freeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                size += prev->second;
+                block.freeRanges.erase(prev);
+            }
+        }
+
+        block.freeRanges[offset] = size;
+        block.allocatedSize -= allocation.size;
+
+        if (block.allocatedSize == 0)
+        {
+            // Keep one empty block around to avoid re-creating it when BLAS'es are streamed in and out
+            const size_t numEmptyBlocks = size_t(std::count_if(m_Blocks.begin(), m_Blocks.end(),
+                [](const Block& b) { return b.allocatedSize == 0; }));
+
+            if (numEmptyBlocks > 1)
+                m_Blocks.erase(blockIt);
+        }
+    }
+}
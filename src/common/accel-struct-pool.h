@@ -0,0 +1,76 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Suballocates acceleration structure storage from large shared buffers, used for BLAS'es created with
+    // rt::AccelStructDesc::allowSuballocation. Backend-independent, the buffers are created through IDevice::createBuffer.
+    // Free ranges are coalesced on release, and empty blocks are destroyed, except for one that is kept for reuse.
+    class AccelStructPool
+    {
+    public:
+        // Required by both DXR and Vulkan for the acceleration structure storage offsets
+        static constexpr uint64_t c_Alignment = 256;
+        static constexpr uint64_t c_DefaultBlockSize = 32 * 1024 * 1024;
+
+        struct Allocation
+        {
+            BufferHandle buffer;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+
+            [[nodiscard]] bool valid() const { return buffer != nullptr; }
+        };
+
+        explicit AccelStructPool(IDevice* device, uint64_t blockSize = c_DefaultBlockSize)
+            : m_Device(device)
+            , m_BlockSize(blockSize)
+        { }
+
+        // Returns false if the size is too large to be pooled (more than a quarter of a block)
+        // or a new block could not be created; the caller should create a dedicated buffer then.
+        bool allocate(uint64_t size, Allocation& outAllocation);
+        void release(const Allocation& allocation);
+
+    private:
+        struct Block
+        {
+            BufferHandle buffer;
+            std::map<uint64_t, uint64_t> freeRanges; // offset -> size
+            uint64_t allocatedSize = 0;
+        };
+
+        IDevice* m_Device; // not a strong reference, the pool is owned by the device
+        uint64_t m_BlockSize;
+        std::vector<Block> m_Blocks;
+        std::mutex m_Mutex;
+
+        static bool allocateFromBlock(Block& block, uint64_t size, uint64_t& outOffset);
+    };
+}
@@ -0,0 +1,166 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "binding-set-cache.h"
+#include <nvrhi/common/misc.h>
+
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    typedef BindingSetCacheStorage::Entry Entry;
+    typedef BindingSetCacheStorage::Shard Shard;
+
+    static size_t hashKey(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        size_t hash = std::hash<BindingSetDesc>()(desc);
+        hash_combine(hash, layout);
+        hash_combine(hash, desc.trackLiveness);
+        return hash;
+    }
+
+    // Returns a new reference to the cached set, skipping the sets that are being destroyed
+    static BindingSetHandle findLocked(const Shard& shard, size_t hash, const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        const auto range = shard.entries.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const Entry& entry = it->second;
+
+            // BindingSetDesc::operator == doesn't compare trackLiveness
+            if (entry.layout == layout && entry.desc.trackLiveness == desc.trackLiveness && entry.desc == desc
+                && entry.bindingSet->tryAddRef())
+                return BindingSetHandle::Create(entry.bindingSet);
+        }
+
+        return nullptr;
+    }
+
+    CacheableBindingSet::~CacheableBindingSet()
+    {
+        if (m_CacheStorage)
+            BindingSetCache::remove(this);
+    }
+
+    BindingSetCache::BindingSetCache(IDevice* device)
+        : m_Device(device)
+        , m_Storage(std::make_shared<BindingSetCacheStorage>())
+    { }
+
+    void BindingSetCache::remove(CacheableBindingSet* bindingSet)
+    {
+        Shard& shard = bindingSet->m_CacheStorage->shards[bindingSet->m_CacheHash % BindingSetCacheStorage::c_NumShards];
+
+        std::unique_lock lock(shard.mutex);
+
+        const auto range = shard.entries.equal_range(bindingSet->m_CacheHash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.bindingSet == bindingSet)
+            {
+                shard.entries.erase(it);
+                break;
+            }
+        }
+    }
+
+    BindingSetHandle BindingSetCache::getOrCreateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        const size_t hash = hashKey(desc, layout);
+        Shard& shard = m_Storage->shards[hash % BindingSetCacheStorage::c_NumShards];
+
+        {
+            std::shared_lock lock(shard.mutex);
+            if (BindingSetHandle bindingSet = findLocked(shard, hash, desc, layout))
+                return bindingSet;
+        }
+
+        // Create the set outside of the lock, descriptor allocation and writes are the expensive part.
+        // Declared before the lock so that a duplicate is released after the lock, because its destructor takes the lock.
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+        if (!bindingSet)
+            return nullptr;
+
+        std::unique_lock lock(shard.mutex);
+
+        // Another thread could have created the same set in the meantime, return that one and drop ours
+        if (BindingSetHandle existing = findLocked(shard, hash, desc, layout))
+            return existing;
+
+        CacheableBindingSet* cacheable = checked_cast<CacheableBindingSet*>(bindingSet.Get());
+        cacheable->m_CacheStorage = m_Storage;
+        cacheable->m_CacheHash = hash;
+
+        shard.entries.emplace(hash, Entry{ desc, layout, cacheable });
+
+        return bindingSet;
+    }
+
+    void BindingSetCache::prewarm(const BindingSetDesc* descs, size_t numDescs, IBindingLayout* layout)
+    {
+        std::vector<BindingSetHandle> bindingSets;
+        bindingSets.reserve(numDescs);
+
+        for (size_t index = 0; index < numDescs; index++)
+        {
+            if (BindingSetHandle bindingSet = getOrCreateBindingSet(descs[index], layout))
+                bindingSets.push_back(std::move(bindingSet));
+        }
+
+        std::lock_guard lockGuard(m_PinnedMutex);
+        m_PinnedSets.insert(m_PinnedSets.end(), std::make_move_iterator(bindingSets.begin()), std::make_move_iterator(bindingSets.end()));
+    }
+
+    size_t BindingSetCache::evictUnused()
+    {
+        std::vector<BindingSetHandle> pinnedSets;
+        {
+            std::lock_guard lockGuard(m_PinnedMutex);
+            pinnedSets.swap(m_PinnedSets);
+        }
+
+        // The other sets leave the cache on their own when their last reference goes away,
+        // so only the pre-warmed ones can be left without references outside the cache
+        size_t numEvicted = 0;
+        for (BindingSetHandle& bindingSet : pinnedSets)
+        {
+            if (bindingSet.Detach()->Release() == 0)
+                ++numEvicted;
+        }
+
+        return numEvicted;
+    }
+
+    size_t BindingSetCache::getNumCachedSets()
+    {
+        size_t numSets = 0;
+
+        for (Shard& shard : m_Storage->shards)
+        {
+            std::shared_lock lock(shard.mutex);
+            numSets += shard.entries.size();
+        }
+
+        return numSets;
+    }
+}
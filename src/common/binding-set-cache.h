@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include "weak-cached-ref-counter.h"
+#include <array>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    class BindingSetCache;
+    struct BindingSetCacheStorage;
+
+    // Base class of the binding sets of all backends, which lets BindingSetCache hold them weakly.
+    // A cached set removes itself from the cache in its destructor, like the samplers in SamplerCache.
+    class CacheableBindingSet : public WeakCachedRefCounter<IBindingSet>
+    {
+    public:
+        ~CacheableBindingSet() override;
+
+    private:
+        friend class BindingSetCache;
+
+        // the storage of the cache that the set is in, if any, which stays alive while any of its sets does
+        std::shared_ptr<BindingSetCacheStorage> m_CacheStorage;
+        size_t m_CacheHash = 0;
+    };
+
+    // Backend-independent implementation of IBindingSetCache on top of IDevice::createBindingSet.
+    // The binding sets returned by createBindingSet must derive from CacheableBindingSet.
+    class BindingSetCache : public RefCounter<IBindingSetCache>
+    {
+    public:
+        explicit BindingSetCache(IDevice* device);
+
+        BindingSetHandle getOrCreateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        void prewarm(const BindingSetDesc* descs, size_t numDescs, IBindingLayout* layout) override;
+        size_t evictUnused() override;
+        size_t getNumCachedSets() override;
+
+        // Called from the binding set destructor
+        static void remove(CacheableBindingSet* bindingSet);
+
+    private:
+        IDevice* m_Device;
+        std::shared_ptr<BindingSetCacheStorage> m_Storage;
+
+        // references that keep the pre-warmed sets alive until evictUnused (protected by m_PinnedMutex)
+        std::vector<BindingSetHandle> m_PinnedSets;
+        std::mutex m_PinnedMutex;
+    };
+
+    struct BindingSetCacheStorage
+    {
+        struct Entry
+        {
+            BindingSetDesc desc;
+            BindingLayoutHandle layout;
+
+            // not a reference, the set removes the entry when it's destroyed
+            CacheableBindingSet* bindingSet = nullptr;
+        };
+
+        // Entries are spread over shards by their hash, each with its own lock,
+        // so that threads creating different sets don't wait for each other.
+        struct Shard
+        {
+            std::unordered_multimap<size_t, Entry> entries;
+            std::shared_mutex mutex;
+        };
+
+        static constexpr size_t c_NumShards = 16;
+
+        std::array<Shard, c_NumShards> shards;
+    };
+}
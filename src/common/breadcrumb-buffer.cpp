@@ -0,0 +1,70 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "breadcrumb-buffer.h"
+
+namespace nvrhi
+{
+    BreadcrumbBufferHandle BreadcrumbBuffer::create(IDevice* device, const BreadcrumbBufferDesc& desc)
+    {
+        BreadcrumbBuffer* breadcrumbs = new BreadcrumbBuffer(device, desc);
+        BreadcrumbBufferHandle handle = BreadcrumbBufferHandle::Create(breadcrumbs);
+
+        if (!breadcrumbs->m_MappedData)
+            return nullptr;
+
+        return handle;
+    }
+
+    BreadcrumbBuffer::BreadcrumbBuffer(IDevice* device, const BreadcrumbBufferDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = uint64_t(desc.numSlots) * sizeof(uint32_t);
+        bufferDesc.debugName = desc.debugName.empty() ? "BreadcrumbBuffer" : desc.debugName;
+        bufferDesc.cpuAccess = CpuAccessMode::Read;
+        bufferDesc.initialState = ResourceStates::CopyDest;
+        bufferDesc.keepInitialState = true;
+
+        m_Buffer = m_Device->createBuffer(bufferDesc);
+        if (!m_Buffer)
+            return;
+
+        // The buffer has not been used by any command list yet, so mapping doesn't wait
+        m_MappedData = static_cast<const volatile uint32_t*>(m_Device->mapBuffer(m_Buffer, CpuAccessMode::Read));
+    }
+
+    BreadcrumbBuffer::~BreadcrumbBuffer()
+    {
+        if (m_MappedData)
+            m_Device->unmapBuffer(m_Buffer);
+    }
+
+    uint32_t BreadcrumbBuffer::getLastMarker(uint32_t slot) const
+    {
+        if (slot >= m_Desc.numSlots)
+            return 0;
+
+        return m_MappedData[slot];
+    }
+}
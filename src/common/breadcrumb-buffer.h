@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    // Backend-independent implementation of IBreadcrumbBuffer: a readback buffer that stays mapped for its whole lifetime.
+    // The backends write into it from ICommandList::writeBreadcrumb without going through the state tracker,
+    // because the buffer never leaves the CopyDest state.
+    class BreadcrumbBuffer : public RefCounter<IBreadcrumbBuffer>
+    {
+    public:
+        // Creates and maps the buffer, returns nullptr if either fails.
+        static BreadcrumbBufferHandle create(IDevice* device, const BreadcrumbBufferDesc& desc);
+
+        ~BreadcrumbBuffer() override;
+
+        [[nodiscard]] const BreadcrumbBufferDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] uint32_t getLastMarker(uint32_t slot) const override;
+
+        [[nodiscard]] IBuffer* getBuffer() const { return m_Buffer; }
+
+    private:
+        BreadcrumbBuffer(IDevice* device, const BreadcrumbBufferDesc& desc);
+
+        IDevice* m_Device;
+        BreadcrumbBufferDesc m_Desc;
+        BufferHandle m_Buffer;
+        // The GPU writes into this memory behind the compiler's back
+        const volatile uint32_t* m_MappedData = nullptr;
+    };
+}
@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include "referenced-resources.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace nvrhi
+{
+    /*
+    Tracks the remaining GarbageCollectionBudget of one runGarbageCollection call.
+
+    References are released in steps of at most c_TimeCheckInterval objects when there is a time limit, so that
+    the clock is read once per step rather than once per object. A default budget releases everything in one step.
+    */
+    class GarbageCollectionBudgetTracker
+    {
+    public:
+        static constexpr size_t c_TimeCheckInterval = 64;
+
+        explicit GarbageCollectionBudgetTracker(const GarbageCollectionBudget& budget)
+            : m_RemainingObjects(budget.maxReleasedObjects ? size_t(budget.maxReleasedObjects) : SIZE_MAX)
+            , m_TimeLimited(budget.maxMicroseconds != 0)
+        {
+            if (m_TimeLimited)
+                m_Deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget.maxMicroseconds);
+        }
+
+        [[nodiscard]] bool exhausted() const { return m_Exhausted; }
+
+        // Releases up to the remaining budget of elements from the back of the container.
+        // Returns true if the container is empty afterwards.
+        template<typename TContainer>
+        bool release(TContainer& container)
+        {
+            while (!container.empty())
+            {
+                if (m_Exhausted)
+                    return false;
+
+                size_t count = std::min(container.size(), m_RemainingObjects);
+                if (m_TimeLimited)
+                    count = std::min(count, c_TimeCheckInterval);
+
+                releaseBack(container, count);
+                consume(count);
+            }
+
+            return true;
+        }
+
+    private:
+        size_t m_RemainingObjects;
+        bool m_TimeLimited;
+        bool m_Exhausted = false;
+        std::chrono::steady_clock::time_point m_Deadline;
+
+        template<typename T>
+        static void releaseBack(std::vector<T>& container, size_t count)
+        {
+            container.erase(container.end() - ptrdiff_t(count), container.end());
+        }
+
+        static void releaseBack(ReferencedResources& container, size_t count)
+        {
+            container.releaseBack(count);
+        }
+
+        void consume(size_t count)
+        {
+            if (m_RemainingObjects != SIZE_MAX)
+            {
+                m_RemainingObjects -= count;
+                if (m_RemainingObjects == 0)
+                    m_Exhausted = true;
+            }
+
+            if (m_TimeLimited && std::chrono::steady_clock::now() >= m_Deadline)
+                m_Exhausted = true;
+        }
+    };
+}
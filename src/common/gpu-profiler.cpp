@@ -0,0 +1,296 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "gpu-profiler.h"
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+
+namespace nvrhi
+{
+    GpuProfilerBase::GpuProfilerBase(IDevice* device, const GpuProfilerDesc& desc)
+        : m_Device(device)
+    {
+        // Every scope needs a begin and an end timestamp
+        m_QueriesPerFrame = align(std::max(desc.maxScopesPerFrame, 1u) * 2, c_GpuProfilerQueryBlockSize);
+
+        const uint32_t numFrames = std::max(desc.maxFramesInFlight, 1u);
+        m_Frames.reserve(numFrames);
+        for (uint32_t i = 0; i < numFrames; i++)
+            m_Frames.push_back(std::make_unique<Frame>());
+    }
+
+    void GpuProfilerBase::beginFrame()
+    {
+        if (m_Frames[m_CurrentSlot]->state == FrameState::Recording)
+            endFrame();
+
+        const uint32_t slot = uint32_t(m_NextFrameIndex % m_Frames.size());
+        Frame& frame = *m_Frames[slot];
+
+        if (frame.state == FrameState::Ended)
+        {
+            // Nobody has read this frame's results, but the GPU may still be writing them
+            isFrameCompleted(slot, true);
+        }
+
+        frame.state = FrameState::Recording;
+        frame.frameIndex = m_NextFrameIndex++;
+        frame.nextQuery = 0;
+        frame.scopes.clear();
+        frame.scopeQueues.clear();
+        frame.overflow = false;
+
+        m_CurrentSlot = slot;
+    }
+
+    void GpuProfilerBase::endFrame()
+    {
+        Frame& frame = *m_Frames[m_CurrentSlot];
+
+        if (frame.state != FrameState::Recording)
+            return;
+
+        frame.state = FrameState::Ended;
+        onFrameEnded(m_CurrentSlot);
+    }
+
+    bool GpuProfilerBase::getFrameResults(GpuProfilerFrame& outFrame)
+    {
+        uint32_t oldestSlot = ~0u;
+        for (uint32_t slot = 0; slot < uint32_t(m_Frames.size()); slot++)
+        {
+            const Frame& frame = *m_Frames[slot];
+            if (frame.state == FrameState::Ended && (oldestSlot == ~0u || frame.frameIndex < m_Frames[oldestSlot]->frameIndex))
+                oldestSlot = slot;
+        }
+
+        if (oldestSlot == ~0u)
+            return false;
+
+        if (!isFrameCompleted(oldestSlot, false))
+            return false;
+
+        Frame& frame = *m_Frames[oldestSlot];
+
+        outFrame.frameIndex = frame.frameIndex;
+        outFrame.overflow = frame.overflow;
+        outFrame.scopes.clear();
+        outFrame.scopes.reserve(frame.scopes.size());
+
+        const uint64_t* timestamps = nullptr;
+        if (!frame.scopes.empty())
+            timestamps = static_cast<const uint64_t*>(m_Device->mapBuffer(readbackBuffer, CpuAccessMode::Read));
+
+        if (timestamps)
+        {
+            constexpr uint32_t numQueues = uint32_t(CommandQueue::Count);
+            uint64_t baseTimestamps[numQueues];
+            double frequencies[numQueues] = {};
+            std::fill_n(baseTimestamps, numQueues, ~0ull);
+
+            for (size_t i = 0; i < frame.scopes.size(); i++)
+            {
+                const int beginQuery = frame.scopes[i].beginQuery;
+                uint64_t& base = baseTimestamps[uint32_t(frame.scopeQueues[i])];
+                if (beginQuery >= 0)
+                    base = std::min(base, timestamps[beginQuery]);
+            }
+
+            for (size_t i = 0; i < frame.scopes.size(); i++)
+            {
+                const RecordedScope& recorded = frame.scopes[i];
+                const CommandQueue queue = frame.scopeQueues[i];
+                const uint32_t queueIndex = uint32_t(queue);
+
+                if (frequencies[queueIndex] == 0.0)
+                    frequencies[queueIndex] = getTimestampFrequency(queue);
+
+                const uint64_t base = baseTimestamps[queueIndex];
+                const uint64_t begin = recorded.beginQuery >= 0 ? timestamps[recorded.beginQuery] : base;
+                // Scopes that were never ended, or ran out of queries for the end timestamp, get a zero duration
+                const uint64_t end = recorded.endQuery >= 0 ? std::max(timestamps[recorded.endQuery], begin) : begin;
+
+                GpuProfilerScope scope;
+                scope.name = recorded.name;
+                scope.queue = queue;
+                scope.depth = recorded.depth;
+                scope.parentIndex = recorded.parentIndex;
+                scope.beginTime = double(begin - base) / frequencies[queueIndex];
+                scope.endTime = double(end - base) / frequencies[queueIndex];
+                outFrame.scopes.push_back(std::move(scope));
+            }
+
+            m_Device->unmapBuffer(readbackBuffer);
+        }
+
+        frame.state = FrameState::Idle;
+        frame.scopes.clear();
+        frame.scopeQueues.clear();
+
+        return true;
+    }
+
+    int GpuProfilerBase::allocateQueryBlock(uint32_t frameSlot)
+    {
+        Frame& frame = *m_Frames[frameSlot];
+
+        if (frame.state != FrameState::Recording)
+            return -1;
+
+        const uint32_t firstQuery = frame.nextQuery.fetch_add(c_GpuProfilerQueryBlockSize);
+        if (firstQuery + c_GpuProfilerQueryBlockSize > m_QueriesPerFrame)
+            return -1;
+
+        return int(frameSlot * m_QueriesPerFrame + firstQuery);
+    }
+
+    void GpuProfilerBase::submitScopes(uint32_t frameSlot, CommandQueue queue, std::vector<RecordedScope>& scopes, bool overflow)
+    {
+        Frame& frame = *m_Frames[frameSlot];
+
+        std::lock_guard lockGuard(frame.mutex);
+
+        if (frame.state == FrameState::Idle)
+            return;
+
+        const uint32_t offset = uint32_t(frame.scopes.size());
+        for (RecordedScope& scope : scopes)
+        {
+            if (scope.parentIndex != ~0u)
+                scope.parentIndex += offset;
+
+            frame.scopes.push_back(std::move(scope));
+            frame.scopeQueues.push_back(queue);
+        }
+
+        frame.overflow = frame.overflow || overflow;
+    }
+
+    void GpuProfilerRecording::setProfiler(IGpuProfiler* profiler, CommandQueue queue)
+    {
+        reset();
+
+        m_Profiler = profiler ? checked_cast<GpuProfilerBase*>(profiler) : nullptr;
+        m_Queue = queue;
+    }
+
+    GpuProfilerRecording::Query GpuProfilerRecording::allocateQuery()
+    {
+        if (!m_Profiler)
+            return Query();
+
+        if (!m_HasFrame)
+        {
+            m_FrameSlot = m_Profiler->getCurrentFrameSlot();
+            m_HasFrame = true;
+        }
+
+        if (!m_Blocks.empty() && m_Blocks.back().numQueries < c_GpuProfilerQueryBlockSize)
+        {
+            QueryBlock& block = m_Blocks.back();
+            Query query;
+            query.index = int(block.firstQuery + block.numQueries);
+            ++block.numQueries;
+            return query;
+        }
+
+        if (m_Overflow)
+            return Query();
+
+        const int firstQuery = m_Profiler->allocateQueryBlock(m_FrameSlot);
+        if (firstQuery < 0)
+        {
+            m_Overflow = true;
+            return Query();
+        }
+
+        QueryBlock block;
+        block.firstQuery = uint32_t(firstQuery);
+        block.numQueries = 1;
+        m_Blocks.push_back(block);
+
+        Query query;
+        query.index = firstQuery;
+        query.startsBlock = true;
+        return query;
+    }
+
+    GpuProfilerRecording::Query GpuProfilerRecording::beginScope(const char* name)
+    {
+        if (!m_Profiler)
+            return Query();
+
+        const Query query = allocateQuery();
+        if (query.index < 0)
+        {
+            // Keep the nesting balanced so that the matching endScope is ignored
+            m_OpenScopes.push_back(~0u);
+            return query;
+        }
+
+        GpuProfilerBase::RecordedScope scope;
+        scope.name = name ? name : "";
+        scope.parentIndex = m_OpenScopes.empty() ? ~0u : m_OpenScopes.back();
+        scope.depth = uint32_t(m_OpenScopes.size());
+        scope.beginQuery = query.index;
+
+        m_OpenScopes.push_back(uint32_t(m_Scopes.size()));
+        m_Scopes.push_back(std::move(scope));
+
+        return query;
+    }
+
+    GpuProfilerRecording::Query GpuProfilerRecording::endScope()
+    {
+        if (!m_Profiler || m_OpenScopes.empty())
+            return Query();
+
+        const uint32_t scopeIndex = m_OpenScopes.back();
+        m_OpenScopes.pop_back();
+
+        if (scopeIndex == ~0u)
+            return Query();
+
+        const Query query = allocateQuery();
+        m_Scopes[scopeIndex].endQuery = query.index;
+        return query;
+    }
+
+    void GpuProfilerRecording::finish()
+    {
+        if (m_Profiler && m_HasFrame && (!m_Scopes.empty() || m_Overflow))
+            m_Profiler->submitScopes(m_FrameSlot, m_Queue, m_Scopes, m_Overflow);
+
+        reset();
+    }
+
+    void GpuProfilerRecording::reset()
+    {
+        m_Blocks.clear();
+        m_Scopes.clear();
+        m_OpenScopes.clear();
+        m_HasFrame = false;
+        m_Overflow = false;
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,155 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nvrhi
+{
+    // Timestamp queries are handed out to command lists in blocks of this size, each block is resolved with one GAPI call
+    constexpr uint32_t c_GpuProfilerQueryBlockSize = 128;
+
+    // Backend-independent part of IGpuProfiler: the frame ring, query allocation, and building the scope tree.
+    // All frames share one query heap/pool and one readback buffer, frame N uses the queries starting at N * getQueriesPerFrame().
+    class GpuProfilerBase : public RefCounter<IGpuProfiler>
+    {
+    public:
+        struct RecordedScope
+        {
+            std::string name;
+            uint32_t parentIndex = ~0u; // local to the recording that produced the scope
+            uint32_t depth = 0;
+            int beginQuery = -1;
+            int endQuery = -1;
+        };
+
+        // Created by the backend, large enough for getTotalQueryCount() timestamps
+        BufferHandle readbackBuffer;
+
+        GpuProfilerBase(IDevice* device, const GpuProfilerDesc& desc);
+
+        // IGpuProfiler implementation
+
+        void beginFrame() override;
+        void endFrame() override;
+        bool getFrameResults(GpuProfilerFrame& outFrame) override;
+
+        // Internal methods used by GpuProfilerRecording
+
+        [[nodiscard]] uint32_t getQueriesPerFrame() const { return m_QueriesPerFrame; }
+        [[nodiscard]] uint32_t getTotalQueryCount() const { return m_QueriesPerFrame * uint32_t(m_Frames.size()); }
+        [[nodiscard]] uint32_t getCurrentFrameSlot() const { return m_CurrentSlot; }
+        [[nodiscard]] uint32_t getFrameCount() const { return uint32_t(m_Frames.size()); }
+
+        // Allocates a block of c_GpuProfilerQueryBlockSize queries from the current frame and returns its first query,
+        // or -1 if the frame is not being recorded or has no queries left. Thread-safe.
+        int allocateQueryBlock(uint32_t frameSlot);
+
+        // Appends the scopes recorded by one command list to the frame. Thread-safe.
+        void submitScopes(uint32_t frameSlot, CommandQueue queue, std::vector<RecordedScope>& scopes, bool overflow);
+
+    protected:
+        enum class FrameState
+        {
+            Idle,
+            Recording,
+            Ended,
+        };
+
+        struct Frame
+        {
+            FrameState state = FrameState::Idle;
+            uint64_t frameIndex = 0;
+            std::atomic<uint32_t> nextQuery = 0;
+            std::mutex mutex;
+            std::vector<RecordedScope> scopes;
+            std::vector<CommandQueue> scopeQueues; // parallel to scopes
+            bool overflow = false;
+        };
+
+        // Called from endFrame to remember which submissions the frame's results depend on
+        virtual void onFrameEnded(uint32_t frameSlot) = 0;
+        // Returns true if the GPU has finished writing the frame's timestamps; waits for it first if wait is set
+        virtual bool isFrameCompleted(uint32_t frameSlot, bool wait) = 0;
+        // Timestamp ticks per second on the given queue
+        virtual double getTimestampFrequency(CommandQueue queue) = 0;
+
+    private:
+        RefCountPtr<IDevice> m_Device;
+        std::vector<std::unique_ptr<Frame>> m_Frames;
+        uint32_t m_QueriesPerFrame = 0;
+        uint32_t m_CurrentSlot = 0;
+        uint64_t m_NextFrameIndex = 0;
+    };
+
+    // Per-command-list recording state for a GpuProfilerBase, owned by the backend command list
+    class GpuProfilerRecording
+    {
+    public:
+        struct QueryBlock
+        {
+            uint32_t firstQuery = 0;
+            uint32_t numQueries = 0; // number of queries written so far
+        };
+
+        struct Query
+        {
+            int index = -1;
+            // Set when the query starts a new block: on Vulkan, the block must be reset before its first query is written
+            bool startsBlock = false;
+        };
+
+        // Detaching or replacing the profiler drops the scopes that have not been handed to the profiler yet
+        void setProfiler(IGpuProfiler* profiler, CommandQueue queue);
+        [[nodiscard]] GpuProfilerBase* getProfiler() const { return m_Profiler; }
+
+        // Returns the query to write the timestamp into. The index is -1 if there is no profiler or no queries are left.
+        Query beginScope(const char* name);
+        Query endScope();
+
+        // Blocks that have been written since the last call to finish
+        [[nodiscard]] const std::vector<QueryBlock>& getQueryBlocks() const { return m_Blocks; }
+
+        // Hands the recorded scopes over to the profiler frame, call after the blocks have been resolved
+        void finish();
+
+    private:
+        RefCountPtr<GpuProfilerBase> m_Profiler;
+        CommandQueue m_Queue = CommandQueue::Graphics;
+        uint32_t m_FrameSlot = 0;
+        bool m_HasFrame = false;
+        bool m_Overflow = false;
+        std::vector<QueryBlock> m_Blocks;
+        std::vector<GpuProfilerBase::RecordedScope> m_Scopes;
+        std::vector<uint32_t> m_OpenScopes;
+
+        Query allocateQuery();
+        void reset();
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,303 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "mip-generator.h"
+
+#include <algorithm>
+
+#if NVRHI_WITH_MIP_GENERATOR_DXIL
+#include "generate-mips.dxil.h"
+#endif
+#if NVRHI_WITH_MIP_GENERATOR_SPIRV
+#include "generate-mips.spirv.h"
+#endif
+
+namespace nvrhi
+{
+    MipGeneratorHandle MipGenerator::create(IDevice* device)
+    {
+        const void* binary = nullptr;
+        size_t binarySize = 0;
+
+        switch (device->getGraphicsAPI())
+        {
+#if NVRHI_WITH_MIP_GENERATOR_DXIL
+        case GraphicsAPI::D3D12:
+            binary = g_GenerateMips_dxil;
+            binarySize = sizeof(g_GenerateMips_dxil);
+            break;
+#endif
+#if NVRHI_WITH_MIP_GENERATOR_SPIRV
+        case GraphicsAPI::VULKAN:
+            binary = g_GenerateMips_spirv;
+            binarySize = sizeof(g_GenerateMips_spirv);
+            break;
+#endif
+        default:
+            break;
+        }
+
+        if (!binary)
+            return nullptr;
+
+        MipGenerator* generator = new MipGenerator(device);
+        MipGeneratorHandle handle = MipGeneratorHandle::Create(generator);
+
+        ShaderDesc shaderDesc(ShaderType::Compute);
+        shaderDesc.debugName = "MipGenerator";
+        generator->m_Shader = device->createShader(shaderDesc, binary, binarySize);
+        if (!generator->m_Shader)
+            return nullptr;
+
+        BindingLayoutDesc layoutDesc;
+        layoutDesc.visibility = ShaderType::Compute;
+        layoutDesc.addItem(BindingLayoutItem::Texture_SRV(0));
+        for (uint32_t mip = 0; mip < c_MaxMipsPerDispatch; mip++)
+            layoutDesc.addItem(BindingLayoutItem::Texture_UAV(mip));
+        layoutDesc.addItem(BindingLayoutItem::StructuredBuffer_UAV(c_MaxMipsPerDispatch));
+        layoutDesc.addItem(BindingLayoutItem::StructuredBuffer_UAV(c_MaxMipsPerDispatch + 1));
+        layoutDesc.addItem(BindingLayoutItem::PushConstants(0, sizeof(Constants)));
+
+        generator->m_BindingLayout = device->createBindingLayout(layoutDesc);
+        if (!generator->m_BindingLayout)
+            return nullptr;
+
+        generator->m_Pipeline = device->createComputePipeline(ComputePipelineDesc()
+            .setComputeShader(generator->m_Shader)
+            .addBindingLayout(generator->m_BindingLayout));
+        if (!generator->m_Pipeline)
+            return nullptr;
+
+        generator->m_Counters = device->createBuffer(BufferDesc()
+            .setByteSize(c_NumCounters * sizeof(uint32_t))
+            .setStructStride(sizeof(uint32_t))
+            .setCanHaveUAVs(true)
+            .setInitialState(ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true)
+            .setDebugName("MipGenerator/Counters"));
+
+        generator->m_Intermediate = device->createBuffer(BufferDesc()
+            .setByteSize(c_NumIntermediateElements * sizeof(float) * 4)
+            .setStructStride(sizeof(float) * 4)
+            .setCanHaveUAVs(true)
+            .setInitialState(ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true)
+            .setDebugName("MipGenerator/Intermediate"));
+
+        if (!generator->m_Counters || !generator->m_Intermediate)
+            return nullptr;
+
+        return handle;
+    }
+
+    MipGenerator::MipGenerator(IDevice* device)
+        : m_Device(device)
+    { }
+
+    void MipGenerator::generateMips(ICommandList* commandList, ITexture* texture, TextureSubresourceSet subresources)
+    {
+        const Job job = { texture, subresources };
+        generate(commandList, &job, 1);
+    }
+
+    void MipGenerator::generateMips(ICommandList* commandList, ITexture* const* textures, size_t numTextures)
+    {
+        std::vector<Job> jobs;
+        jobs.reserve(numTextures);
+
+        for (size_t index = 0; index < numTextures; index++)
+            jobs.push_back({ textures[index], AllSubresources });
+
+        generate(commandList, jobs.data(), jobs.size());
+    }
+
+    static bool canGenerateMips(const TextureDesc& desc)
+    {
+        switch (desc.dimension)
+        {
+        case TextureDimension::Texture2D:
+        case TextureDimension::Texture2DArray:
+        case TextureDimension::TextureCube:
+        case TextureDimension::TextureCubeArray:
+            break;
+        default:
+            return false;
+        }
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        return desc.isUAV && !formatInfo.isSRGB &&
+            (formatInfo.kind == FormatKind::Normalized || formatInfo.kind == FormatKind::Float);
+    }
+
+    void MipGenerator::generate(ICommandList* commandList, const Job* jobs, size_t numJobs)
+    {
+        std::vector<Job> validJobs;
+        validJobs.reserve(numJobs);
+
+        for (size_t index = 0; index < numJobs; index++)
+        {
+            if (!jobs[index].texture)
+                continue;
+
+            const TextureDesc& desc = jobs[index].texture->getDesc();
+            const TextureSubresourceSet subresources = jobs[index].subresources.resolve(desc, false);
+
+            if (!canGenerateMips(desc) || subresources.numMipLevels < 2)
+                continue;
+
+            validJobs.push_back({ jobs[index].texture, subresources });
+        }
+
+        if (validJobs.empty())
+            return;
+
+        // Place all transitions up front, so that they are committed as one batch. setComputeState then finds
+        // the textures already in the right states, except for the source mips of additional dispatches.
+        for (const Job& job : validJobs)
+        {
+            const TextureSubresourceSet& subresources = job.subresources;
+
+            commandList->setTextureState(job.texture, TextureSubresourceSet(subresources.baseMipLevel, 1,
+                subresources.baseArraySlice, subresources.numArraySlices), ResourceStates::ShaderResource);
+            commandList->setTextureState(job.texture, TextureSubresourceSet(subresources.baseMipLevel + 1, subresources.numMipLevels - 1,
+                subresources.baseArraySlice, subresources.numArraySlices), ResourceStates::UnorderedAccess);
+        }
+
+        // The counters must start at zero, and the shader resets each counter it uses after the last group is done.
+        // The clear is ordered with the first dispatch by a UAV barrier, later dispatches don't need any.
+        commandList->clearBufferUInt(m_Counters, 0);
+        commandList->setEnableUavBarriersForBuffer(m_Counters, false);
+        commandList->setEnableUavBarriersForBuffer(m_Intermediate, false);
+        commandList->commitBarriers();
+
+        m_NextCounter = 0;
+        m_NextIntermediate = 0;
+
+        for (const Job& job : validJobs)
+        {
+            const TextureSubresourceSet& subresources = job.subresources;
+
+            MipLevel sourceMip = subresources.baseMipLevel;
+            uint32_t remainingMips = subresources.numMipLevels - 1;
+
+            while (remainingMips > 0)
+            {
+                const TextureDesc& desc = job.texture->getDesc();
+                const uint32_t width = std::max(desc.width >> sourceMip, 1u);
+                const uint32_t height = std::max(desc.height >> sourceMip, 1u);
+
+                // The last group of a slice can only finish the chain when the group grid fits into a 64x64 tile
+                uint32_t numMips = std::min(remainingMips, c_MaxMipsPerDispatch);
+                if (width > c_TileSize * c_TileSize || height > c_TileSize * c_TileSize)
+                    numMips = std::min(numMips, c_MipsPerGroup);
+
+                for (ArraySlice slice = 0; slice < subresources.numArraySlices; slice += c_MaxSlicesPerDispatch)
+                {
+                    dispatch(commandList, job.texture, sourceMip, numMips, subresources.baseArraySlice + slice,
+                        std::min(subresources.numArraySlices - slice, c_MaxSlicesPerDispatch));
+                }
+
+                sourceMip += numMips;
+                remainingMips -= numMips;
+            }
+        }
+
+        commandList->setEnableUavBarriersForBuffer(m_Counters, true);
+        commandList->setEnableUavBarriersForBuffer(m_Intermediate, true);
+    }
+
+    void MipGenerator::dispatch(ICommandList* commandList, ITexture* texture, MipLevel sourceMip, uint32_t numMips,
+        ArraySlice baseArraySlice, uint32_t numArraySlices)
+    {
+        const TextureDesc& desc = texture->getDesc();
+
+        Constants constants{};
+        constants.sourceSize[0] = std::max(desc.width >> sourceMip, 1u);
+        constants.sourceSize[1] = std::max(desc.height >> sourceMip, 1u);
+        constants.numMips = numMips;
+        constants.groupsX = (constants.sourceSize[0] + c_TileSize - 1) / c_TileSize;
+        constants.groupsY = (constants.sourceSize[1] + c_TileSize - 1) / c_TileSize;
+
+        // Only the dispatches that finish the chain in their last group use the counters and the intermediate buffer
+        bool reuseRanges = false;
+        if (numMips > c_MipsPerGroup)
+        {
+            const uint32_t intermediateSize = constants.groupsX * constants.groupsY * numArraySlices;
+
+            if (m_NextCounter + numArraySlices > c_NumCounters ||
+                m_NextIntermediate + intermediateSize > c_NumIntermediateElements)
+            {
+                m_NextCounter = 0;
+                m_NextIntermediate = 0;
+                reuseRanges = true;
+            }
+
+            constants.counterOffset = m_NextCounter;
+            constants.intermediateOffset = m_NextIntermediate;
+            m_NextCounter += numArraySlices;
+            m_NextIntermediate += intermediateSize;
+        }
+
+        const TextureSubresourceSet sourceSubresources(sourceMip, 1, baseArraySlice, numArraySlices);
+
+        BindingSetDesc bindingSetDesc;
+        bindingSetDesc.addItem(BindingSetItem::Texture_SRV(0, texture, Format::UNKNOWN, sourceSubresources,
+            TextureDimension::Texture2DArray));
+
+        // The unused outputs are bound to the last generated mip, the shader never writes them
+        for (uint32_t index = 0; index < c_MaxMipsPerDispatch; index++)
+        {
+            const MipLevel mipLevel = sourceMip + 1 + std::min(index, numMips - 1);
+            bindingSetDesc.addItem(BindingSetItem::Texture_UAV(index, texture, Format::UNKNOWN,
+                TextureSubresourceSet(mipLevel, 1, baseArraySlice, numArraySlices), TextureDimension::Texture2DArray));
+        }
+
+        bindingSetDesc.addItem(BindingSetItem::StructuredBuffer_UAV(c_MaxMipsPerDispatch, m_Intermediate));
+        bindingSetDesc.addItem(BindingSetItem::StructuredBuffer_UAV(c_MaxMipsPerDispatch + 1, m_Counters));
+        bindingSetDesc.addItem(BindingSetItem::PushConstants(0, sizeof(Constants)));
+
+        BindingSetHandle bindingSet = m_Device->createBindingSet(bindingSetDesc, m_BindingLayout);
+        if (!bindingSet)
+            return;
+
+        // Reusing the ranges needs the previous dispatches to be done with them
+        if (reuseRanges)
+        {
+            commandList->setEnableUavBarriersForBuffer(m_Counters, true);
+            commandList->setEnableUavBarriersForBuffer(m_Intermediate, true);
+        }
+
+        commandList->setComputeState(ComputeState()
+            .setPipeline(m_Pipeline)
+            .addBindingSet(bindingSet));
+
+        if (reuseRanges)
+        {
+            commandList->setEnableUavBarriersForBuffer(m_Counters, false);
+            commandList->setEnableUavBarriersForBuffer(m_Intermediate, false);
+        }
+
+        commandList->setPushConstants(&constants, sizeof(constants));
+        commandList->dispatch(constants.groupsX, constants.groupsY, numArraySlices);
+    }
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    // Backend-independent implementation of IMipGenerator on top of the compute shader in shaders/generate-mips.hlsl,
+    // which is compiled and embedded into the library when DXC is available at build time.
+    class MipGenerator : public RefCounter<IMipGenerator>
+    {
+    public:
+        // Returns nullptr if there is no shader binary for the graphics API of the device, or if any of the objects
+        // could not be created.
+        static MipGeneratorHandle create(IDevice* device);
+
+        void generateMips(ICommandList* commandList, ITexture* texture, TextureSubresourceSet subresources) override;
+        void generateMips(ICommandList* commandList, ITexture* const* textures, size_t numTextures) override;
+
+    private:
+        static constexpr uint32_t c_MaxMipsPerDispatch = 12;
+        // The number of mips produced by each thread group on its own, from a 64x64 tile
+        static constexpr uint32_t c_MipsPerGroup = 6;
+        static constexpr uint32_t c_TileSize = 64;
+        static constexpr uint32_t c_MaxSlicesPerDispatch = 16;
+        static constexpr uint32_t c_NumCounters = 256;
+        // Enough for c_MaxSlicesPerDispatch slices with the largest supported grid of 64x64 groups
+        static constexpr uint32_t c_NumIntermediateElements = c_MaxSlicesPerDispatch * c_TileSize * c_TileSize;
+
+        struct Constants
+        {
+            uint32_t sourceSize[2];
+            uint32_t numMips;
+            uint32_t groupsX;
+            uint32_t groupsY;
+            uint32_t counterOffset;
+            uint32_t intermediateOffset;
+            uint32_t padding;
+        };
+
+        struct Job
+        {
+            ITexture* texture;
+            TextureSubresourceSet subresources;
+        };
+
+        explicit MipGenerator(IDevice* device);
+
+        void generate(ICommandList* commandList, const Job* jobs, size_t numJobs);
+        void dispatch(ICommandList* commandList, ITexture* texture, MipLevel sourceMip, uint32_t numMips,
+            ArraySlice baseArraySlice, uint32_t numArraySlices);
+
+        IDevice* m_Device;
+        ShaderHandle m_Shader;
+        BindingLayoutHandle m_BindingLayout;
+        ComputePipelineHandle m_Pipeline;
+        BufferHandle m_Counters;
+        BufferHandle m_Intermediate;
+
+        // Allocation cursors in m_Counters and m_Intermediate for the current generateMips call. The dispatches of one call
+        // use separate ranges, so that they don't need UAV barriers between them.
+        uint32_t m_NextCounter = 0;
+        uint32_t m_NextIntermediate = 0;
+    };
+}
@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pipeline-cache.h"
+#include <cstring>
+
+namespace nvrhi
+{
+    namespace
+    {
+        constexpr uint32_t c_PipelineCacheMagic = 0x4350564E; // 'NVPC'
+        constexpr uint32_t c_PipelineCacheVersion = 2; // 2: D3D12 payloads include serialized root signatures
+
+        struct PipelineCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t headerVersion;
+            uint32_t graphicsAPI;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint64_t driverVersion;
+            uint8_t cacheUUID[16];
+            uint64_t payloadSize;
+            uint64_t payloadHash;
+        };
+    }
+
+    uint64_t hashPipelineCacheBytes(const void* data, size_t size, uint64_t hash)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    void writePipelineCacheBlob(const PipelineCacheIdentity& identity, const void* payload, size_t payloadSize, std::vector<uint8_t>& outBlob)
+    {
+        PipelineCacheHeader header{};
+        header.magic = c_PipelineCacheMagic;
+        header.version = c_PipelineCacheVersion;
+        header.headerVersion = c_HeaderVersion;
+        header.graphicsAPI = uint32_t(identity.graphicsAPI);
+        header.vendorID = identity.vendorID;
+        header.deviceID = identity.deviceID;
+        header.driverVersion = identity.driverVersion;
+        memcpy(header.cacheUUID, identity.cacheUUID, sizeof(header.cacheUUID));
+        header.payloadSize = payloadSize;
+        header.payloadHash = hashPipelineCacheBytes(payload, payloadSize);
+
+        outBlob.resize(sizeof(header) + payloadSize);
+        memcpy(outBlob.data(), &header, sizeof(header));
+        if (payloadSize)
+            memcpy(outBlob.data() + sizeof(header), payload, payloadSize);
+    }
+
+    bool readPipelineCacheBlob(const PipelineCacheIdentity& identity, const void* blob, size_t blobSize, const void*& outPayload, size_t& outPayloadSize)
+    {
+        outPayload = nullptr;
+        outPayloadSize = 0;
+
+        if (!blob || blobSize < sizeof(PipelineCacheHeader))
+            return false;
+
+        PipelineCacheHeader header;
+        memcpy(&header, blob, sizeof(header));
+
+        if (header.magic != c_PipelineCacheMagic ||
+            header.version != c_PipelineCacheVersion ||
+            header.headerVersion != c_HeaderVersion ||
+            header.graphicsAPI != uint32_t(identity.graphicsAPI) ||
+            header.vendorID != identity.vendorID ||
+            header.deviceID != identity.deviceID ||
+            header.driverVersion != identity.driverVersion ||
+            memcmp(header.cacheUUID, identity.cacheUUID, sizeof(header.cacheUUID)) != 0)
+            return false;
+
+        if (header.payloadSize != blobSize - sizeof(header))
+            return false;
+
+        const uint8_t* payload = static_cast<const uint8_t*>(blob) + sizeof(header);
+        if (header.payloadHash != hashPipelineCacheBytes(payload, size_t(header.payloadSize)))
+            return false;
+
+        outPayload = payload;
+        outPayloadSize = size_t(header.payloadSize);
+        return true;
+    }
+}
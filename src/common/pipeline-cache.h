@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <vector>
+#include <cstdint>
+
+namespace nvrhi
+{
+    // Identifies the device and driver that produced a pipeline cache blob.
+    // Blobs are only accepted by a device with the same identity.
+    struct PipelineCacheIdentity
+    {
+        GraphicsAPI graphicsAPI = GraphicsAPI::D3D11;
+        uint32_t vendorID = 0;
+        uint32_t deviceID = 0;
+        uint64_t driverVersion = 0;
+        uint8_t cacheUUID[16] = {};
+    };
+
+    constexpr uint64_t c_PipelineCacheHashSeed = 0xcbf29ce484222325ull;
+
+    // 64-bit FNV-1a hash used for the blob checksum and for building pipeline keys.
+    // Unlike std::hash, the result is stable across runs and platforms.
+    uint64_t hashPipelineCacheBytes(const void* data, size_t size, uint64_t hash = c_PipelineCacheHashSeed);
+
+    // Wraps the backend-specific cache data into a blob with a header that records the identity and a payload hash.
+    void writePipelineCacheBlob(const PipelineCacheIdentity& identity, const void* payload, size_t payloadSize, std::vector<uint8_t>& outBlob);
+
+    // Validates the blob header against the identity and returns the payload in outPayload and outPayloadSize.
+    // Returns false if the blob is truncated, corrupted, or was produced by a different device or driver.
+    bool readPipelineCacheBlob(const PipelineCacheIdentity& identity, const void* blob, size_t blobSize, const void*& outPayload, size_t& outPayloadSize);
+}
@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pipeline-creation-task.h"
+
+namespace nvrhi
+{
+    PipelineCreationTask::PipelineCreationTask(CreateFunction createFunction)
+        : m_CreateFunction(std::move(createFunction))
+    {
+        if (!m_CreateFunction)
+            m_Started = true;
+    }
+
+    bool PipelineCreationTask::join()
+    {
+        if (!m_Started.exchange(true))
+        {
+            m_CreateFunction(*this);
+            complete();
+            return true;
+        }
+
+        HelperFunction helper;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (!m_Helper || m_ActiveHelpers >= m_HelperConcurrency)
+                return m_Status.load() != PipelineCreationStatus::Pending;
+
+            // Copy the helper so that it can be called without holding the mutex;
+            // clearHelper waits for m_ActiveHelpers to drop to zero before the resources it uses go away.
+            helper = m_Helper;
+            ++m_ActiveHelpers;
+        }
+
+        helper();
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            --m_ActiveHelpers;
+        }
+        m_Condition.notify_all();
+
+        return m_Status.load() != PipelineCreationStatus::Pending;
+    }
+
+    void PipelineCreationTask::wait()
+    {
+        if (join())
+            return;
+
+        std::unique_lock lock(m_Mutex);
+        m_Condition.wait(lock, [this] { return m_Status.load() != PipelineCreationStatus::Pending; });
+    }
+
+    uint32_t PipelineCreationTask::getMaxConcurrency()
+    {
+        if (!m_Started.load())
+            return 1;
+
+        std::lock_guard lockGuard(m_Mutex);
+        return m_Helper ? m_HelperConcurrency - m_ActiveHelpers : 0;
+    }
+
+    void PipelineCreationTask::setHelper(HelperFunction helper, uint32_t maxConcurrency)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        m_Helper = std::move(helper);
+        m_HelperConcurrency = maxConcurrency;
+    }
+
+    void PipelineCreationTask::clearHelper()
+    {
+        std::unique_lock lock(m_Mutex);
+        m_Helper = nullptr;
+        m_Condition.wait(lock, [this] { return m_ActiveHelpers == 0; });
+    }
+
+    void PipelineCreationTask::complete()
+    {
+        const bool succeeded = m_GraphicsPipeline || m_ComputePipeline || m_MeshletPipeline || m_RayTracingPipeline;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Status = succeeded ? PipelineCreationStatus::Ready : PipelineCreationStatus::Failed;
+        }
+        m_Condition.notify_all();
+    }
+}
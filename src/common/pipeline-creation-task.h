@@ -0,0 +1,94 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace nvrhi
+{
+    // Backend-independent implementation of IPipelineCreationTask.
+    // The create function runs once, on the first thread that joins the task, and publishes its result through setResult.
+    // While it runs, the create function may install a helper that other joining threads execute to share the work.
+    class PipelineCreationTask : public RefCounter<IPipelineCreationTask>
+    {
+    public:
+        typedef std::function<void(PipelineCreationTask& task)> CreateFunction;
+        typedef std::function<void()> HelperFunction;
+
+        explicit PipelineCreationTask(CreateFunction createFunction);
+
+        // Returns a task that is already complete, for pipelines that have been created synchronously
+        template<typename T>
+        static PipelineCreationTaskHandle createCompleted(T pipeline)
+        {
+            PipelineCreationTask* task = new PipelineCreationTask(nullptr);
+            task->setResult(std::move(pipeline));
+            task->complete();
+            return PipelineCreationTaskHandle::Create(task);
+        }
+
+        // IPipelineCreationTask implementation
+        bool join() override;
+        void wait() override;
+        PipelineCreationStatus getStatus() override { return m_Status.load(); }
+        uint32_t getMaxConcurrency() override;
+        GraphicsPipelineHandle getGraphicsPipeline() override { return isReady() ? m_GraphicsPipeline : nullptr; }
+        ComputePipelineHandle getComputePipeline() override { return isReady() ? m_ComputePipeline : nullptr; }
+        MeshletPipelineHandle getMeshletPipeline() override { return isReady() ? m_MeshletPipeline : nullptr; }
+        rt::PipelineHandle getRayTracingPipeline() override { return isReady() ? m_RayTracingPipeline : nullptr; }
+
+        // Internal interface, used by the create function
+        void setResult(GraphicsPipelineHandle pipeline) { m_GraphicsPipeline = std::move(pipeline); }
+        void setResult(ComputePipelineHandle pipeline) { m_ComputePipeline = std::move(pipeline); }
+        void setResult(MeshletPipelineHandle pipeline) { m_MeshletPipeline = std::move(pipeline); }
+        void setResult(rt::PipelineHandle pipeline) { m_RayTracingPipeline = std::move(pipeline); }
+
+        // Lets up to maxConcurrency joining threads execute the helper, in addition to the thread running the create function.
+        // clearHelper must be called before the create function returns; it waits until all helpers have exited.
+        void setHelper(HelperFunction helper, uint32_t maxConcurrency);
+        void clearHelper();
+
+    private:
+        CreateFunction m_CreateFunction;
+        std::atomic<bool> m_Started = false;
+        std::atomic<PipelineCreationStatus> m_Status = PipelineCreationStatus::Pending;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        HelperFunction m_Helper;
+        uint32_t m_HelperConcurrency = 0;
+        uint32_t m_ActiveHelpers = 0;
+
+        GraphicsPipelineHandle m_GraphicsPipeline;
+        ComputePipelineHandle m_ComputePipeline;
+        MeshletPipelineHandle m_MeshletPipeline;
+        rt::PipelineHandle m_RayTracingPipeline;
+
+        bool isReady() const { return m_Status.load() == PipelineCreationStatus::Ready; }
+        void complete();
+    };
+}
@@ -0,0 +1,166 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nvrhi
+{
+    // A hash map with pointer keys for per-recording data in command lists.
+    // Open addressing with linear probing in a power-of-two table. Every entry is stamped with the generation
+    // that wrote it, so clear() is O(1) and keeps the table: once the table has grown to the size that a
+    // recording needs, later recordings don't allocate.
+    template<typename Key, typename Value>
+    class PointerMap
+    {
+    public:
+        const Value* find(const Key* key) const
+        {
+            if (m_Size == 0)
+                return nullptr;
+
+            const size_t mask = m_Entries.size() - 1;
+            for (size_t index = hash(key) & mask; ; index = (index + 1) & mask)
+            {
+                const Entry& entry = m_Entries[index];
+                if (entry.generation != m_Generation)
+                    return nullptr;
+                if (entry.key == key)
+                    return &entry.value;
+            }
+        }
+
+        Value* find(const Key* key)
+        {
+            return const_cast<Value*>(static_cast<const PointerMap*>(this)->find(key));
+        }
+
+        // Inserts a value-initialized entry if the key is not present
+        Value& operator[](Key* key)
+        {
+            // Keep the load factor at or below 1/2
+            if ((m_Size + 1) * 2 > m_Entries.size())
+                grow();
+
+            const size_t mask = m_Entries.size() - 1;
+            for (size_t index = hash(key) & mask; ; index = (index + 1) & mask)
+            {
+                Entry& entry = m_Entries[index];
+                if (entry.generation != m_Generation)
+                {
+                    entry.generation = m_Generation;
+                    entry.key = key;
+                    entry.value = Value();
+                    ++m_Size;
+                    return entry.value;
+                }
+                if (entry.key == key)
+                    return entry.value;
+            }
+        }
+
+        void clear()
+        {
+            if (m_Size == 0)
+                return;
+
+            m_Size = 0;
+            if (++m_Generation == 0)
+            {
+                // Entries written 2^32 generations ago would become valid again
+                for (Entry& entry : m_Entries)
+                    entry.generation = 0;
+                m_Generation = 1;
+            }
+        }
+
+        // Calls func(Key*, Value&) for every entry, in no particular order
+        template<typename Func>
+        void forEach(Func&& func)
+        {
+            if (m_Size == 0)
+                return;
+
+            for (Entry& entry : m_Entries)
+            {
+                if (entry.generation == m_Generation)
+                    func(entry.key, entry.value);
+            }
+        }
+
+        template<typename Func>
+        void forEach(Func&& func) const
+        {
+            if (m_Size == 0)
+                return;
+
+            for (const Entry& entry : m_Entries)
+            {
+                if (entry.generation == m_Generation)
+                    func(entry.key, entry.value);
+            }
+        }
+
+        [[nodiscard]] size_t size() const { return m_Size; }
+        [[nodiscard]] bool empty() const { return m_Size == 0; }
+        [[nodiscard]] size_t capacity() const { return m_Entries.size(); }
+
+    private:
+        struct Entry
+        {
+            Key* key = nullptr;
+            Value value = Value();
+            uint32_t generation = 0; // the entry is in use when this matches m_Generation
+        };
+
+        std::vector<Entry> m_Entries;
+        size_t m_Size = 0;
+        uint32_t m_Generation = 1;
+
+        static size_t hash(const Key* key)
+        {
+            // Fibonacci hashing, the low bits of pointers are mostly zero
+            return size_t((uint64_t(reinterpret_cast<uintptr_t>(key)) * 0x9e3779b97f4a7c15ull) >> 32);
+        }
+
+        void grow()
+        {
+            std::vector<Entry> oldEntries;
+            oldEntries.swap(m_Entries);
+            m_Entries.resize(oldEntries.empty() ? 16 : oldEntries.size() * 2);
+
+            const uint32_t oldGeneration = m_Generation;
+            m_Generation = 1;
+            m_Size = 0;
+
+            for (const Entry& entry : oldEntries)
+            {
+                if (entry.generation == oldGeneration)
+                    (*this)[entry.key] = entry.value;
+            }
+        }
+    };
+}
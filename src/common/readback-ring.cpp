@@ -0,0 +1,126 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "readback-ring.h"
+
+#include <sstream>
+
+namespace nvrhi
+{
+    ReadbackRingHandle ReadbackRing::create(IDevice* device, const ReadbackRingDesc& desc)
+    {
+        ReadbackRing* ring = new ReadbackRing(device, desc);
+        ReadbackRingHandle handle = ReadbackRingHandle::Create(ring);
+
+        for (const Slot& slot : ring->m_Slots)
+        {
+            if (!slot.buffer)
+                return nullptr;
+        }
+
+        return handle;
+    }
+
+    ReadbackRing::ReadbackRing(IDevice* device, const ReadbackRingDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        m_Slots.resize(desc.numSlots);
+
+        for (uint32_t index = 0; index < desc.numSlots; index++)
+        {
+            std::stringstream ss;
+            ss << (desc.debugName.empty() ? "ReadbackRing" : desc.debugName) << "[" << index << "]";
+
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = desc.byteSize;
+            bufferDesc.debugName = ss.str();
+            bufferDesc.cpuAccess = CpuAccessMode::Read;
+            bufferDesc.initialState = ResourceStates::CopyDest;
+            bufferDesc.keepInitialState = true;
+
+            m_Slots[index].buffer = m_Device->createBuffer(bufferDesc);
+        }
+    }
+
+    ReadbackRing::~ReadbackRing()
+    {
+        if (m_MappedSlot != c_NoSlot)
+            m_Device->unmapBuffer(m_Slots[m_MappedSlot].buffer);
+    }
+
+    IBuffer* ReadbackRing::acquireBuffer(uint64_t* outSerial)
+    {
+        // Never hand out the slot that the application is reading
+        if (m_NextSlot == m_MappedSlot)
+            m_NextSlot = (m_NextSlot + 1) % uint32_t(m_Slots.size());
+
+        Slot& slot = m_Slots[m_NextSlot];
+        m_NextSlot = (m_NextSlot + 1) % uint32_t(m_Slots.size());
+
+        slot.serial = m_NextSerial++;
+
+        if (outSerial)
+            *outSerial = slot.serial;
+
+        return slot.buffer;
+    }
+
+    const void* ReadbackRing::mapOldestCompleted(uint64_t* outSerial)
+    {
+        if (m_MappedSlot != c_NoSlot)
+            return nullptr;
+
+        // Copies complete in submission order, so if the oldest pending copy is not complete, none of the others are
+        uint32_t oldestSlot = c_NoSlot;
+        for (uint32_t index = 0; index < uint32_t(m_Slots.size()); index++)
+        {
+            if (m_Slots[index].serial != 0 && (oldestSlot == c_NoSlot || m_Slots[index].serial < m_Slots[oldestSlot].serial))
+                oldestSlot = index;
+        }
+
+        if (oldestSlot == c_NoSlot)
+            return nullptr;
+
+        Slot& slot = m_Slots[oldestSlot];
+        const void* data = m_Device->tryMapBuffer(slot.buffer, CpuAccessMode::Read);
+        if (!data)
+            return nullptr;
+
+        if (outSerial)
+            *outSerial = slot.serial;
+
+        slot.serial = 0;
+        m_MappedSlot = oldestSlot;
+
+        return data;
+    }
+
+    void ReadbackRing::unmap()
+    {
+        if (m_MappedSlot == c_NoSlot)
+            return;
+
+        m_Device->unmapBuffer(m_Slots[m_MappedSlot].buffer);
+        m_MappedSlot = c_NoSlot;
+    }
+}
@@ -0,0 +1,63 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <vector>
+
+namespace nvrhi
+{
+    // Backend-independent implementation of IReadbackRing on top of IDevice::tryMapBuffer.
+    class ReadbackRing : public RefCounter<IReadbackRing>
+    {
+    public:
+        // Creates the ring and its buffers, returns nullptr if any of the buffers could not be created.
+        static ReadbackRingHandle create(IDevice* device, const ReadbackRingDesc& desc);
+
+        ~ReadbackRing() override;
+
+        [[nodiscard]] const ReadbackRingDesc& getDesc() const override { return m_Desc; }
+        IBuffer* acquireBuffer(uint64_t* outSerial) override;
+        const void* mapOldestCompleted(uint64_t* outSerial) override;
+        void unmap() override;
+
+    private:
+        static constexpr uint32_t c_NoSlot = ~0u;
+
+        ReadbackRing(IDevice* device, const ReadbackRingDesc& desc);
+
+        struct Slot
+        {
+            BufferHandle buffer;
+            // Serial number of the pending copy, 0 if the slot has no unread data
+            uint64_t serial = 0;
+        };
+
+        IDevice* m_Device;
+        ReadbackRingDesc m_Desc;
+        std::vector<Slot> m_Slots;
+        uint64_t m_NextSerial = 1;
+        uint32_t m_NextSlot = 0;
+        uint32_t m_MappedSlot = c_NoSlot;
+    };
+}
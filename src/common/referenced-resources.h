@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include "pointer-map.h"
+#include <vector>
+
+namespace nvrhi
+{
+    // The strong references that a command list recording keeps to the resources it uses, until the GPU is done with them.
+    // Each resource is added once per recording: a PointerMap of the referenced resources filters out the duplicates
+    // and their AddRef/Release pairs. The map belongs to the recording, so recordings on different threads don't share any state.
+    // Textures and buffers created with trackLiveness = false are not referenced when they are added through their own types.
+    class ReferencedResources
+    {
+    public:
+        // Doesn't know the type of the resource and can't check trackLiveness, add textures and buffers with the overloads below
+        void push_back(IResource* resource)
+        {
+            if (!resource)
+                return;
+
+            bool& referenced = m_Referenced[resource];
+            if (referenced)
+                return;
+
+            referenced = true;
+            m_Resources.emplace_back(resource);
+        }
+
+        void push_back(ITexture* texture)
+        {
+            if (texture && texture->getDesc().trackLiveness)
+                push_back(static_cast<IResource*>(texture));
+        }
+
+        void push_back(IBuffer* buffer)
+        {
+            if (buffer && buffer->getDesc().trackLiveness)
+                push_back(static_cast<IResource*>(buffer));
+        }
+
+        // Releases the references and starts a new recording
+        void clear()
+        {
+            m_Resources.clear();
+            m_Referenced.clear();
+        }
+
+        // Releases the last 'count' references without starting a new recording, for the incremental garbage collection.
+        // The recording is still finished with clear() once all the references have been released.
+        void releaseBack(size_t count)
+        {
+            m_Resources.erase(m_Resources.end() - ptrdiff_t(count), m_Resources.end());
+        }
+
+        [[nodiscard]] size_t size() const { return m_Resources.size(); }
+        [[nodiscard]] size_t capacity() const { return m_Resources.capacity(); }
+        [[nodiscard]] bool empty() const { return m_Resources.empty(); }
+
+    private:
+        std::vector<RefCountPtr<IResource>> m_Resources;
+        PointerMap<IResource, bool> m_Referenced;
+    };
+}
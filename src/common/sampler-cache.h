@@ -0,0 +1,100 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include "weak-cached-ref-counter.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace nvrhi
+{
+    // Interns samplers by their desc, see IDevice::createSampler.
+    // The cache doesn't keep samplers alive: every sampler removes itself in its destructor by calling remove(),
+    // so the cache never holds more samplers than the application does.
+    // SamplerType must derive from WeakCachedRefCounter<ISampler>.
+    template<class SamplerType>
+    class SamplerCache
+    {
+    public:
+        // Descs with NaN fields never compare equal to anything, so samplers with those are not interned
+        static bool canIntern(const SamplerDesc& desc)
+        {
+            return desc.mipBias == desc.mipBias
+                && desc.maxAnisotropy == desc.maxAnisotropy
+                && desc.borderColor == desc.borderColor;
+        }
+
+        SamplerHandle find(const SamplerDesc& desc)
+        {
+            if (!canIntern(desc))
+                return nullptr;
+
+            std::shared_lock lock(m_Mutex);
+            const auto it = m_Samplers.find(desc);
+            if (it != m_Samplers.end() && it->second->tryAddRef())
+                return SamplerHandle::Create(it->second);
+
+            return nullptr;
+        }
+
+        // Takes ownership of a new sampler and returns it, or the sampler with the same desc
+        // that another thread has added in the meantime.
+        SamplerHandle add(SamplerType* sampler)
+        {
+            // Declared before the lock so that a duplicate is released after the lock,
+            // because its destructor takes the lock as well
+            SamplerHandle newSampler = SamplerHandle::Create(sampler);
+
+            const SamplerDesc& desc = sampler->getDesc();
+            if (!canIntern(desc))
+                return newSampler;
+
+            std::unique_lock lock(m_Mutex);
+            SamplerType*& cachedSampler = m_Samplers[desc];
+            if (cachedSampler && cachedSampler->tryAddRef())
+                return SamplerHandle::Create(cachedSampler);
+
+            cachedSampler = sampler;
+            return newSampler;
+        }
+
+        // Called from the sampler destructor
+        void remove(SamplerType* sampler)
+        {
+            const SamplerDesc& desc = sampler->getDesc();
+            if (!canIntern(desc))
+                return;
+
+            std::unique_lock lock(m_Mutex);
+            const auto it = m_Samplers.find(desc);
+            if (it != m_Samplers.end() && it->second == sampler)
+                m_Samplers.erase(it);
+        }
+
+    private:
+        std::unordered_map<SamplerDesc, SamplerType*> m_Samplers;
+        std::shared_mutex m_Mutex;
+    };
+}
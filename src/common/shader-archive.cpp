@@ -0,0 +1,217 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/shader-archive.h>
+#include <algorithm>
+#include <string>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nvrhi
+{
+    class ShaderArchive : public RefCounter<IShaderArchive>
+    {
+    public:
+        ~ShaderArchive() override;
+
+        bool open(const char* fileName);
+
+        [[nodiscard]] uint32_t getNumShaders() const override { return m_Header ? m_Header->numEntries : 0; }
+        bool findShader(const char* name, const char* permutation, const void** ppBytecode, size_t* pSize) const override;
+        ShaderHandle createShader(IDevice* device, const ShaderDesc& desc, const char* name, const char* permutation) override;
+
+    private:
+        bool validate() const;
+
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+        const ShaderArchiveHeader* m_Header = nullptr;
+        const ShaderArchiveEntry* m_Entries = nullptr;
+
+#ifdef _WIN32
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        HANDLE m_Mapping = nullptr;
+#else
+        int m_File = -1;
+#endif
+    };
+
+    ShaderArchive::~ShaderArchive()
+    {
+#ifdef _WIN32
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE)
+            CloseHandle(m_File);
+#else
+        if (m_Data)
+            munmap(const_cast<uint8_t*>(m_Data), m_Size);
+        if (m_File >= 0)
+            close(m_File);
+#endif
+    }
+
+    bool ShaderArchive::open(const char* fileName)
+    {
+#ifdef _WIN32
+        m_File = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_File, &fileSize) || fileSize.QuadPart < LONGLONG(sizeof(ShaderArchiveHeader)))
+            return false;
+
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_Mapping)
+            return false;
+
+        m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_Data)
+            return false;
+
+        m_Size = size_t(fileSize.QuadPart);
+#else
+        m_File = ::open(fileName, O_RDONLY);
+        if (m_File < 0)
+            return false;
+
+        struct stat fileStat;
+        if (fstat(m_File, &fileStat) != 0 || fileStat.st_size < off_t(sizeof(ShaderArchiveHeader)))
+            return false;
+
+        void* data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+        if (data == MAP_FAILED)
+            return false;
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = size_t(fileStat.st_size);
+#endif
+
+        m_Header = reinterpret_cast<const ShaderArchiveHeader*>(m_Data);
+        m_Entries = reinterpret_cast<const ShaderArchiveEntry*>(m_Data + sizeof(ShaderArchiveHeader));
+
+        if (!validate())
+        {
+            m_Header = nullptr;
+            m_Entries = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Checks all offsets once, so that lookups can trust the file
+    bool ShaderArchive::validate() const
+    {
+        if (m_Header->signature != c_ShaderArchiveSignature || m_Header->version != c_ShaderArchiveVersion)
+            return false;
+
+        const uint64_t entriesEnd = sizeof(ShaderArchiveHeader) + uint64_t(m_Header->numEntries) * sizeof(ShaderArchiveEntry);
+        if (entriesEnd > m_Size)
+            return false;
+
+        for (uint32_t i = 0; i < m_Header->numEntries; i++)
+        {
+            const ShaderArchiveEntry& entry = m_Entries[i];
+
+            if (i > 0 && m_Entries[i - 1].key >= entry.key)
+                return false;
+
+            if (entry.dataOffset > m_Size || entry.dataSize > m_Size - entry.dataOffset)
+                return false;
+
+            const uint64_t stringsSize = uint64_t(entry.nameSize) + entry.permutationSize;
+            if (entry.stringsOffset > m_Size || stringsSize > m_Size - entry.stringsOffset)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool ShaderArchive::findShader(const char* name, const char* permutation, const void** ppBytecode, size_t* pSize) const
+    {
+        if (!m_Header || !name)
+            return false;
+
+        // The compiler stores every define followed by a space, accept the permutation with or without the last one
+        std::string permutationString = permutation ? permutation : "";
+        if (!permutationString.empty() && permutationString.back() != ' ')
+            permutationString += ' ';
+
+        const size_t nameSize = strlen(name);
+        const uint64_t key = getShaderArchiveKey(name, nameSize, permutationString.data(), permutationString.size());
+
+        const ShaderArchiveEntry* entriesEnd = m_Entries + m_Header->numEntries;
+        const ShaderArchiveEntry* entry = std::lower_bound(m_Entries, entriesEnd, key,
+            [](const ShaderArchiveEntry& e, uint64_t k) { return e.key < k; });
+
+        if (entry == entriesEnd || entry->key != key)
+            return false;
+
+        // Guard against hash collisions with shaders that are not in the archive
+        const char* strings = reinterpret_cast<const char*>(m_Data + entry->stringsOffset);
+        if (entry->nameSize != nameSize || entry->permutationSize != permutationString.size()
+            || memcmp(strings, name, nameSize) != 0
+            || memcmp(strings + nameSize, permutationString.data(), permutationString.size()) != 0)
+            return false;
+
+        if (ppBytecode) *ppBytecode = m_Data + entry->dataOffset;
+        if (pSize) *pSize = size_t(entry->dataSize);
+        return true;
+    }
+
+    ShaderHandle ShaderArchive::createShader(IDevice* device, const ShaderDesc& desc, const char* name, const char* permutation)
+    {
+        const void* bytecode = nullptr;
+        size_t size = 0;
+        if (!device || !findShader(name, permutation, &bytecode, &size))
+            return nullptr;
+
+        return device->createShaderNoCopy(desc, bytecode, size, this);
+    }
+
+    ShaderArchiveHandle openShaderArchive(const char* fileName)
+    {
+        if (!fileName)
+            return nullptr;
+
+        RefCountPtr<ShaderArchive> archive = RefCountPtr<ShaderArchive>::Create(new ShaderArchive());
+        if (!archive->open(fileName))
+            return nullptr;
+
+        return archive;
+    }
+}
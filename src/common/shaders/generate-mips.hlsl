@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Single-pass mip chain generation, used by MipGenerator (src/common/mip-generator.cpp).
+//
+// Each thread group reduces a 64x64 tile of the source mip down to 1x1, producing up to 6 mips with a 2x2 box filter
+// through groupshared memory. When more mips are requested, the groups also write their 1x1 results into the
+// intermediate buffer, and the last group of each slice to finish, as counted by an atomic counter, reduces the
+// intermediate 64x64 image into the remaining 6 mips. One dispatch therefore produces up to 12 mips, and the
+// intermediate buffer limits the source mip to 4096x4096 when more than 6 mips are generated.
+//
+// Odd sizes are handled by clamping the source coordinates, so the texels on the last row or column of an odd-sized
+// mip are not filtered with their neighbors. The outputs are bounds-checked against their actual sizes.
+
+struct Constants
+{
+    uint2 sourceSize;
+    uint numMips;               // 1 to 12
+    uint groupsX;               // thread groups per slice, each group covers 64x64 source texels
+    uint groupsY;
+    uint counterOffset;         // counter used for slice 0, one counter per slice
+    uint intermediateOffset;    // element used for slice 0, groupsX * groupsY elements per slice
+    uint padding;
+};
+
+#ifdef __spirv__
+[[vk::push_constant]] ConstantBuffer<Constants> g_Const;
+#else
+ConstantBuffer<Constants> g_Const : register(b0);
+#endif
+
+Texture2DArray<float4> t_Source : register(t0);
+
+RWTexture2DArray<float4> u_Mip0 : register(u0);
+RWTexture2DArray<float4> u_Mip1 : register(u1);
+RWTexture2DArray<float4> u_Mip2 : register(u2);
+RWTexture2DArray<float4> u_Mip3 : register(u3);
+RWTexture2DArray<float4> u_Mip4 : register(u4);
+RWTexture2DArray<float4> u_Mip5 : register(u5);
+RWTexture2DArray<float4> u_Mip6 : register(u6);
+RWTexture2DArray<float4> u_Mip7 : register(u7);
+RWTexture2DArray<float4> u_Mip8 : register(u8);
+RWTexture2DArray<float4> u_Mip9 : register(u9);
+RWTexture2DArray<float4> u_Mip10 : register(u10);
+RWTexture2DArray<float4> u_Mip11 : register(u11);
+
+globallycoherent RWStructuredBuffer<float4> u_Intermediate : register(u12);
+globallycoherent RWStructuredBuffer<uint> u_Counters : register(u13);
+
+groupshared float4 s_Tile[32][32];
+groupshared uint s_IsLastGroup;
+
+#define STORE_MIP(INDEX) \
+    case INDEX: { \
+        uint width, height, elements; \
+        u_Mip##INDEX.GetDimensions(width, height, elements); \
+        if (coord.x < width && coord.y < height) \
+            u_Mip##INDEX[coord] = value; \
+        break; }
+
+void StoreMip(uint mip, uint3 coord, float4 value)
+{
+    switch (mip)
+    {
+        STORE_MIP(0)
+        STORE_MIP(1)
+        STORE_MIP(2)
+        STORE_MIP(3)
+        STORE_MIP(4)
+        STORE_MIP(5)
+        STORE_MIP(6)
+        STORE_MIP(7)
+        STORE_MIP(8)
+        STORE_MIP(9)
+        STORE_MIP(10)
+        STORE_MIP(11)
+    }
+}
+
+float4 LoadSource(uint2 pos, uint slice, bool fromIntermediate)
+{
+    if (fromIntermediate)
+    {
+        pos = min(pos, uint2(g_Const.groupsX, g_Const.groupsY) - 1);
+        uint index = g_Const.intermediateOffset + slice * g_Const.groupsX * g_Const.groupsY + pos.y * g_Const.groupsX + pos.x;
+        return u_Intermediate[index];
+    }
+
+    pos = min(pos, g_Const.sourceSize - 1);
+    return t_Source.Load(int4(pos, slice, 0));
+}
+
+// Produces mips firstMip to firstMip + 5 of the tile whose texels in firstMip start at tileOrigin
+void DownsampleTile(uint threadIndex, uint2 tileOrigin, uint slice, uint firstMip, bool fromIntermediate)
+{
+    // The first level has 32x32 texels, 4 per thread
+    for (uint i = 0; i < 4; i++)
+    {
+        uint index = threadIndex + i * 256;
+        uint2 local = uint2(index % 32, index / 32);
+        uint2 pos = (tileOrigin + local) * 2;
+
+        float4 value = (LoadSource(pos, slice, fromIntermediate)
+            + LoadSource(pos + uint2(1, 0), slice, fromIntermediate)
+            + LoadSource(pos + uint2(0, 1), slice, fromIntermediate)
+            + LoadSource(pos + uint2(1, 1), slice, fromIntermediate)) * 0.25;
+
+        StoreMip(firstMip, uint3(tileOrigin + local, slice), value);
+        s_Tile[local.y][local.x] = value;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // The following levels reduce the tile in place. numMips is uniform, so all threads leave the loop together.
+    for (uint level = 1; level < 6; level++)
+    {
+        uint mip = firstMip + level;
+        if (mip >= g_Const.numMips)
+            break;
+
+        uint size = 32 >> level;
+        uint2 local = uint2(threadIndex % size, threadIndex / size);
+        bool active = threadIndex < size * size;
+
+        float4 value = 0;
+        if (active)
+        {
+            value = (s_Tile[local.y * 2][local.x * 2]
+                + s_Tile[local.y * 2][local.x * 2 + 1]
+                + s_Tile[local.y * 2 + 1][local.x * 2]
+                + s_Tile[local.y * 2 + 1][local.x * 2 + 1]) * 0.25;
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (active)
+        {
+            s_Tile[local.y][local.x] = value;
+
+            uint2 coord = (tileOrigin >> level) + local;
+            StoreMip(mip, uint3(coord, slice), value);
+
+            // Level 5 is the 1x1 result of the group, which the last group reads back
+            if (level == 5 && !fromIntermediate && g_Const.numMips > 6)
+            {
+                uint index = g_Const.intermediateOffset + slice * g_Const.groupsX * g_Const.groupsY + coord.y * g_Const.groupsX + coord.x;
+                u_Intermediate[index] = value;
+            }
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+[numthreads(256, 1, 1)]
+void main(uint3 groupID : SV_GroupID, uint threadIndex : SV_GroupIndex)
+{
+    uint slice = groupID.z;
+
+    DownsampleTile(threadIndex, groupID.xy * 32, slice, 0, false);
+
+    if (g_Const.numMips <= 6)
+        return;
+
+    // Make the intermediate result of this group visible to the other groups before counting it
+    DeviceMemoryBarrierWithGroupSync();
+
+    if (threadIndex == 0)
+    {
+        uint previous;
+        InterlockedAdd(u_Counters[g_Const.counterOffset + slice], 1, previous);
+        s_IsLastGroup = (previous == g_Const.groupsX * g_Const.groupsY - 1) ? 1 : 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (s_IsLastGroup == 0)
+        return;
+
+    // Reset the counter for the next use of it
+    if (threadIndex == 0)
+        u_Counters[g_Const.counterOffset + slice] = 0;
+
+    DownsampleTile(threadIndex, uint2(0, 0), slice, 6, true);
+}
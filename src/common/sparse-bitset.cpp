@@ -22,24 +22,60 @@
 
 #include "sparse-bitset.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <utility>
 
 using namespace nvrhi;
 
 // Set this macro to 1 to run the unit test at initialization time - see below
 #define SPARSE_BITSET_UNIT_TEST 0
 
+// Set this macro to 1 to run the set operation benchmark at initialization time - see below
+#define SPARSE_BITSET_BENCHMARK 0
 
-uint32_t& sparse_bitset::findOrInsertWord(uint32_t wordIndex)
+
+void sparse_bitset::insertElement(uint32_t position, const element& elem)
+{
+    if (m_size < c_InlineCapacity)
+    {
+        // Still fits into the inline storage - shift the tail and insert.
+        for (uint32_t i = m_size; i > position; --i)
+            m_inline[i] = m_inline[i - 1];
+        m_inline[position] = elem;
+    }
+    else
+    {
+        if (m_size == c_InlineCapacity)
+        {
+            // Inline storage is full - move the elements to the heap.
+            m_heap.reserve(c_InlineCapacity * 2);
+            m_heap.assign(m_inline, m_inline + m_size);
+        }
+
+        m_heap.insert(m_heap.begin() + position, elem);
+    }
+
+    ++m_size;
+}
+
+void sparse_bitset::reserve(uint32_t count)
+{
+    if (count > c_InlineCapacity)
+        m_heap.reserve(count);
+}
+
+sparse_bitset::word_type& sparse_bitset::findOrInsertWord(uint32_t wordIndex)
 {
     // Use binary search to locate an existing element first.
 
+    element* storage = data();
     int left = 0;
-    int right = int(m_storage.size()) - 1;
+    int right = int(m_size) - 1;
     while (left <= right)
     {
         int middle = (left + right) / 2;
-        element& elem = m_storage[middle];
+        element& elem = storage[middle];
         if (elem.wordIndex < wordIndex)
             left = middle + 1;
         else if (elem.wordIndex > wordIndex)
@@ -57,21 +93,22 @@ uint32_t& sparse_bitset::findOrInsertWord(uint32_t wordIndex)
     element elem{};
     elem.wordIndex = wordIndex;
     elem.bits = 0;
-    m_storage.insert(m_storage.begin() + left, elem);
+    insertElement(uint32_t(left), elem);
 
-    return m_storage[left].bits;
+    return data()[left].bits;
 }
 
-uint32_t sparse_bitset::tryGetWord(uint32_t wordIndex) const
+sparse_bitset::word_type sparse_bitset::tryGetWord(uint32_t wordIndex) const
 {
     // Use binary search to locate an existing element first.
 
+    const element* storage = data();
     int left = 0;
-    int right = int(m_storage.size()) - 1;
+    int right = int(m_size) - 1;
     while (left <= right)
     {
         int middle = (left + right) / 2;
-        const element& elem = m_storage[middle];
+        const element& elem = storage[middle];
         if (elem.wordIndex < wordIndex)
             left = middle + 1;
         else if (elem.wordIndex > wordIndex)
@@ -87,21 +124,22 @@ uint32_t sparse_bitset::tryGetWord(uint32_t wordIndex) const
 
 void sparse_bitset::set(uint32_t bitIndex, bool value)
 {
-    const uint32_t wordIndex = bitIndex >> 5;
-    uint32_t& bits = findOrInsertWord(wordIndex);
-    const uint32_t mask = 1 << (bitIndex & 0x1f);
+    const uint32_t wordIndex = bitIndex >> c_WordShift;
+    const word_type mask = word_type(1) << (bitIndex & (c_WordBits - 1));
 
     if (value)
-        bits |= mask;
-    else
-        bits &= ~mask;
+        findOrInsertWord(wordIndex) |= mask;
+    else if (tryGetWord(wordIndex) & mask)
+        // Only touch the storage when the bit is actually set, so that clearing
+        // bits in a missing word doesn't insert empty elements.
+        findOrInsertWord(wordIndex) &= ~mask;
 }
 
 bool sparse_bitset::get(uint32_t bitIndex) const
 {
-    const uint32_t wordIndex = bitIndex >> 5;
-    const uint32_t bits = tryGetWord(wordIndex);
-    const uint32_t mask = 1 << (bitIndex & 0x1f);
+    const uint32_t wordIndex = bitIndex >> c_WordShift;
+    const word_type bits = tryGetWord(wordIndex);
+    const word_type mask = word_type(1) << (bitIndex & (c_WordBits - 1));
 
     return (bits & mask) != 0;
 }
@@ -109,12 +147,16 @@ bool sparse_bitset::get(uint32_t bitIndex) const
 sparse_bitset sparse_bitset::intersect(const sparse_bitset& a, const sparse_bitset& b)
 {
     sparse_bitset r;
-    std::vector<element>::const_iterator pa = a.m_storage.begin();
-    std::vector<element>::const_iterator pb = b.m_storage.begin();
+    const element* pa = a.data();
+    const element* pb = b.data();
+    const element* const ea = pa + a.m_size;
+    const element* const eb = pb + b.m_size;
+
+    r.reserve(std::min(a.m_size, b.m_size));
 
     // Iterate while there are elements in both sets - if one set runs out of elements,
     // all remaining elements of the other one are AND'ed with 0 and therefore can be discarded.
-    while (pa != a.m_storage.end() && pb != b.m_storage.end())
+    while (pa != ea && pb != eb)
     {
         if (pa->wordIndex < pb->wordIndex)
         {
@@ -130,13 +172,13 @@ sparse_bitset sparse_bitset::intersect(const sparse_bitset& a, const sparse_bits
         {
             // Element present in both A and B - compute the intersection and insert a new
             // element if the result is non-empty.
-            uint32_t rbits = pa->bits & pb->bits;
+            const word_type rbits = pa->bits & pb->bits;
             if (rbits)
             {
                 element elem{};
                 elem.wordIndex = pa->wordIndex;
                 elem.bits = rbits;
-                r.m_storage.push_back(elem);
+                r.appendElement(elem);
             }
 
             ++pa;
@@ -150,18 +192,22 @@ sparse_bitset sparse_bitset::intersect(const sparse_bitset& a, const sparse_bits
 sparse_bitset sparse_bitset::difference(const sparse_bitset& a, const sparse_bitset& b)
 {
     sparse_bitset r;
-    std::vector<element>::const_iterator pa = a.m_storage.begin();
-    std::vector<element>::const_iterator pb = b.m_storage.begin();
+    const element* pa = a.data();
+    const element* pb = b.data();
+    const element* const ea = pa + a.m_size;
+    const element* const eb = pb + b.m_size;
+
+    r.reserve(a.m_size);
 
     // Iterate while there are elements in A, because we don't care about
     // the contents of B past the end of A.
-    while (pa != a.m_storage.end())
+    while (pa != ea)
     {
-        if (pb == b.m_storage.end() || pa->wordIndex < pb->wordIndex)
+        if (pb == eb || pa->wordIndex < pb->wordIndex)
         {
             // Next element in A is missing from B - copy the element from A.
             // This includes the situation when we reached the end of B.
-            r.m_storage.push_back(*pa);
+            r.appendElement(*pa);
             ++pa;
         }
         else if (pb->wordIndex < pa->wordIndex)
@@ -173,13 +219,13 @@ sparse_bitset sparse_bitset::difference(const sparse_bitset& a, const sparse_bit
         {
             // Element present in both A and B - compute the difference and insert a new
             // element if the result is non-empty.
-            uint32_t rbits = pa->bits & ~pb->bits;
+            const word_type rbits = pa->bits & ~pb->bits;
             if (rbits)
             {
                 element elem{};
                 elem.wordIndex = pa->wordIndex;
                 elem.bits = rbits;
-                r.m_storage.push_back(elem);
+                r.appendElement(elem);
             }
 
             ++pa;
@@ -192,42 +238,75 @@ sparse_bitset sparse_bitset::difference(const sparse_bitset& a, const sparse_bit
 
 void sparse_bitset::include(const sparse_bitset& b)
 {
-    std::vector<element>::iterator pr = m_storage.begin();
-    std::vector<element>::const_iterator pb = b.m_storage.begin();
+    element* pr = data();
+    const element* pb = b.data();
+    const element* const er = pr + m_size;
+    const element* const eb = pb + b.m_size;
+
+    // First try to compute the union in place, which works when every word of B
+    // is already present in this bitset. That is the common case when the same
+    // binding slots are included repeatedly.
+    while (pb != eb)
+    {
+        while (pr != er && pr->wordIndex < pb->wordIndex)
+            ++pr;
+
+        if (pr == er || pr->wordIndex != pb->wordIndex)
+            break;
+
+        pr->bits |= pb->bits;
+        ++pr;
+        ++pb;
+    }
 
-    // Iterate while there are elements in B.
-    // Once B runs out of elements, this bitset stays the same.
-    while (pb != b.m_storage.end())
+    if (pb == eb)
+        return;
+
+    // B has words that are missing from this bitset - build the union in one pass
+    // instead of inserting the missing words one by one.
+    // OR'ing the already processed words again doesn't change them.
+    sparse_bitset r;
+    r.reserve(m_size + b.m_size);
+
+    const element* pa = data();
+    const element* const ea = pa + m_size;
+    pb = b.data();
+
+    while (pa != ea || pb != eb)
     {
-        if (pr == m_storage.end() || pb->wordIndex < pr->wordIndex)
+        if (pb == eb || (pa != ea && pa->wordIndex < pb->wordIndex))
         {
-            // Next element in B is missing from this - insert it.
-            const size_t ir = pr - m_storage.begin();
-            m_storage.insert(pr, *pb);
-            // Recalculate the iterator and make it point at the next element.
-            pr = m_storage.begin() + ir + 1;
-            ++pb;
+            // Next element in this is missing from B - copy it.
+            r.appendElement(*pa);
+            ++pa;
         }
-        else if (pr->wordIndex < pb->wordIndex)
+        else if (pa == ea || pb->wordIndex < pa->wordIndex)
         {
-            // Next element in this is missing from B - skip this.
-            ++pr;
+            // Next element in B is missing from this - copy it.
+            r.appendElement(*pb);
+            ++pb;
         }
         else
         {
             // Element present in both this and B - compute the union.
-            pr->bits |= pb->bits;
-            ++pr;
+            element elem{};
+            elem.wordIndex = pa->wordIndex;
+            elem.bits = pa->bits | pb->bits;
+            r.appendElement(elem);
+            ++pa;
             ++pb;
         }
     }
+
+    *this = std::move(r);
 }
 
 bool sparse_bitset::any() const
 {
-    for (const element& elem : m_storage)
+    const element* storage = data();
+    for (uint32_t i = 0; i < m_size; ++i)
     {
-        if (elem.bits)
+        if (storage[i].bits)
             return true;
     }
 
@@ -236,40 +315,42 @@ bool sparse_bitset::any() const
 
 uint32_t sparse_bitset::const_iterator::operator*() const
 {
-    const element& elem = bitset->m_storage[elemIndex];
-    return (elem.wordIndex << 5) + bit;
+    const element& elem = bitset->data()[elemIndex];
+    return (elem.wordIndex << c_WordShift) + bit;
 }
 
 sparse_bitset::const_iterator& sparse_bitset::const_iterator::operator++()
 {
-    while (elemIndex < bitset->m_storage.size())
+    while (elemIndex < bitset->m_size)
     {
-        const element& elem = bitset->m_storage[elemIndex];
+        const element& elem = bitset->data()[elemIndex];
 
         // Mask out the bits that we already processed
-        [[maybe_unused]] const uint32_t nextBits = elem.bits & ~((1 << (bit + 1)) - 1);
+        [[maybe_unused]] const word_type nextBits = (bit < int(c_WordBits) - 1)
+            ? elem.bits & ~((word_type(1) << (bit + 1)) - 1)
+            : 0;
 
-#if defined(_MSC_VER)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
         // Find the index of the lowest unprocessed bit with the MSVC intrinsic
         unsigned long nextBitIndex;
-        if (_BitScanForward(&nextBitIndex, nextBits))
+        if (_BitScanForward64(&nextBitIndex, nextBits))
         {
             bit = int(nextBitIndex);
             return *this;
         }
 #elif defined(__GNUC__) || defined(__clang__)
         // Find the index of the lowest unprocessed bit with the GCC/Clang intrinsic
-        int nextBitIndexPlusOne = __builtin_ffs(nextBits);
+        int nextBitIndexPlusOne = __builtin_ffsll((long long)nextBits);
         if (nextBitIndexPlusOne > 0)
         {
             bit = nextBitIndexPlusOne - 1;
             return *this;
         }
 #else
-        // Linear search through bits - fallback for unsupported compilers
-        while (++bit < 32)
+        // Linear search through bits - fallback for unsupported compilers and 32-bit MSVC targets
+        while (++bit < int(c_WordBits))
         {
-            if (elem.bits & (1 << bit))
+            if (elem.bits & (word_type(1) << bit))
                 return *this;
         }
 #endif
@@ -300,14 +381,15 @@ sparse_bitset::const_iterator sparse_bitset::begin() const
 
 sparse_bitset::const_iterator sparse_bitset::end() const
 {
-    return const_iterator{this, uint32_t(m_storage.size()), 0};
+    return const_iterator{this, m_size, 0};
 }
 
 bool sparse_bitset::isOrdered() const
 {
-    for (size_t i = 1; i < m_storage.size(); ++i)
+    const element* storage = data();
+    for (uint32_t i = 1; i < m_size; ++i)
     {
-        if (m_storage[i].wordIndex <= m_storage[i-1].wordIndex)
+        if (storage[i].wordIndex <= storage[i-1].wordIndex)
             return false;
     }
 
@@ -409,11 +491,92 @@ public:
         assert(!c.get(1234));
         assert(c.isOrdered());
 
+        // Test the word boundaries and the transition from inline to heap storage
+        sparse_bitset d;
+        for (uint32_t bit = 0; bit < 1024; bit += 63)
+            d.set(bit, true);
+        d.set(63, true);
+        d.set(64, true);
+        assert(d.m_size > sparse_bitset::c_InlineCapacity);
+        assert(d.isOrdered());
+        assert(d.get(63));
+        assert(d.get(64));
+        assert(d.get(1008));
+        assert(!d.get(65));
+
+        d.set(5000, false);
+        assert(!d.get(5000));
+        assert(d.tryGetWord(5000 >> sparse_bitset::c_WordShift) == 0);
+
+        bits.clear();
+        for (uint32_t bit : d)
+            bits.push_back(bit);
+        assert(bits.size() == 18);
+        assert(bits[0] == 0 && bits[1] == 63 && bits[2] == 64 && bits[3] == 126);
+
+        c = a;
+        c |= d;
+        assert(c.get(13));
+        assert(c.get(1234));
+        assert(c.get(1008));
+        assert(c.isOrdered());
+
         return true;
     }
 };
 
 static bool g_SparseBitSetUnitTest = sparse_bitset_test::run();
 
+} // namespace nvrhi
+#endif
+
+#if SPARSE_BITSET_BENCHMARK
+
+#include <chrono>
+#include <cstdio>
+
+namespace nvrhi
+{
+
+class sparse_bitset_benchmark
+{
+public:
+    // Measures the set operations on bitsets shaped like the ones the validation layer
+    // builds for binding sets: a few dozen low slots, and occasionally a high slot.
+    static bool run()
+    {
+        constexpr int iterations = 1000000;
+
+        sparse_bitset layout;
+        sparse_bitset bound;
+        for (uint32_t slot = 0; slot < 24; ++slot)
+            layout.set(slot, true);
+        for (uint32_t slot = 4; slot < 32; slot += 2)
+            bound.set(slot, true);
+        bound.set(300, true);
+
+        volatile uint32_t sink = 0;
+        const auto measure = [&sink](const char* name, auto&& op)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i)
+                sink = sink + op();
+            const auto end = std::chrono::high_resolution_clock::now();
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            printf("sparse_bitset %-12s %6.1f ns/op\n", name, ns / iterations);
+        };
+
+        measure("set", [&]() { sparse_bitset s; for (uint32_t slot = 0; slot < 16; ++slot) s.set(slot, true); return uint32_t(s.any()); });
+        measure("intersect", [&]() { return uint32_t((layout & bound).any()); });
+        measure("difference", [&]() { return uint32_t((bound - layout).any()); });
+        measure("include", [&]() { sparse_bitset s = layout; s |= bound; return uint32_t(s.any()); });
+        measure("iterate", [&]() { uint32_t sum = 0; for (uint32_t slot : bound) sum += slot; return sum; });
+
+        return true;
+    }
+};
+
+static bool g_SparseBitSetBenchmark = sparse_bitset_benchmark::run();
+
 } // namespace nvrhi
 #endif
\ No newline at end of file
@@ -28,29 +28,55 @@
 namespace nvrhi {
 
 // This is a container for bits that has virtually unlimited capacity, otherwise similar to std::bitset.
-// It maintains a sorted vector of elements where each element is a 32-bit word of bits at a given offset.
+// It maintains a sorted array of elements where each element is a 64-bit word of bits at a given offset.
+// The first few elements are stored inline in the object, so small sets never touch the heap.
 // It is used in the validation layer to compute, modify and compare sets of binding indices,
 // and implements only the operations necessary for that purpose.
 class sparse_bitset
 {
 private:
     friend class sparse_bitset_test;
+    friend class sparse_bitset_benchmark;
+
+    typedef uint64_t word_type;
+    static constexpr uint32_t c_WordBits = 64;
+    static constexpr uint32_t c_WordShift = 6;
 
     struct element
     {
         uint32_t wordIndex;
-        uint32_t bits;
+        word_type bits;
     };
 
-    std::vector<element> m_storage;
+    // Number of elements stored in the object itself. Binding sets rarely use
+    // slots past 255, so this covers almost every set created by the validation layer.
+    static constexpr uint32_t c_InlineCapacity = 4;
+
+    // The elements live in m_inline while m_size <= c_InlineCapacity, and in m_heap after that.
+    // No pointers into the object are stored, so the default copy and move operations are correct.
+    element m_inline[c_InlineCapacity] = {};
+    std::vector<element> m_heap;
+    uint32_t m_size = 0;
+
+    [[nodiscard]] element* data() { return m_size <= c_InlineCapacity ? m_inline : m_heap.data(); }
+    [[nodiscard]] const element* data() const { return m_size <= c_InlineCapacity ? m_inline : m_heap.data(); }
+
+    // Inserts an element at the specified position, moving the storage to the heap if necessary.
+    void insertElement(uint32_t position, const element& elem);
+
+    // Appends an element to the end of the storage.
+    void appendElement(const element& elem) { insertElement(m_size, elem); }
+
+    // Prepares the storage for appending up to 'count' elements without reallocating.
+    void reserve(uint32_t count);
 
     // Internal function that finds an element containing the specified bit index.
     // If such element is not present, it is inserted.
-    uint32_t& findOrInsertWord(uint32_t wordIndex);
+    word_type& findOrInsertWord(uint32_t wordIndex);
 
     // Internal function that finds an element containing the specified bit index.
     // If such element is not present, returns zero.
-    [[nodiscard]] uint32_t tryGetWord(uint32_t wordIndex) const;
+    [[nodiscard]] word_type tryGetWord(uint32_t wordIndex) const;
 
     // Checks if the elements are ordered correctly - for testing.
     [[nodiscard]] bool isOrdered() const;
@@ -24,10 +24,83 @@
 
 #include <nvrhi/utils.h>
 
+#include <atomic>
+#include <mutex>
 #include <sstream>
 
 namespace nvrhi
 {
+    // Tracking slot entries pack the recording ID in the upper bits and the slot index in the lower bits.
+    // An entry is valid only for the recording that wrote it, so entries never need to be cleared.
+    constexpr uint32_t c_TrackingSlotIndexBits = 24;
+    constexpr uint64_t c_TrackingSlotIndexMask = (1ull << c_TrackingSlotIndexBits) - 1;
+    constexpr uint64_t c_RecordingIDMask = (1ull << (64 - c_TrackingSlotIndexBits)) - 1;
+    constexpr uint32_t c_NoLane = ~0u;
+    constexpr uint32_t c_NoSlot = ~0u;
+
+    static std::atomic<uint64_t> g_NextRecordingID = 1;
+    static std::mutex g_LaneMutex;
+    static uint32_t g_AllocatedLanes = 0;
+
+    static_assert(c_StateTrackingLaneCount <= 32, "g_AllocatedLanes is a 32-bit mask");
+
+    static uint64_t allocateRecordingID()
+    {
+        uint64_t id;
+        do
+        {
+            id = g_NextRecordingID.fetch_add(1, std::memory_order_relaxed) & c_RecordingIDMask;
+        } while (id == 0);
+        return id;
+    }
+
+    static uint32_t allocateLane()
+    {
+        std::lock_guard lockGuard(g_LaneMutex);
+        for (uint32_t lane = 0; lane < c_StateTrackingLaneCount; lane++)
+        {
+            if ((g_AllocatedLanes & (1u << lane)) == 0)
+            {
+                g_AllocatedLanes |= 1u << lane;
+                return lane;
+            }
+        }
+        return c_NoLane;
+    }
+
+    static void releaseLane(uint32_t lane)
+    {
+        if (lane == c_NoLane)
+            return;
+
+        std::lock_guard lockGuard(g_LaneMutex);
+        g_AllocatedLanes &= ~(1u << lane);
+    }
+
+    // Returns the slot index for the resource in the current recording, or c_NoSlot
+    template<typename T>
+    static uint32_t findTrackingSlot(T* resource, uint32_t lane, uint64_t recordingID, const PointerMap<T, uint32_t>& slotMap)
+    {
+        if (lane != c_NoLane)
+        {
+            const uint64_t entry = resource->trackingSlots[lane];
+            if ((entry >> c_TrackingSlotIndexBits) == recordingID)
+                return uint32_t(entry & c_TrackingSlotIndexMask);
+        }
+
+        const uint32_t* slot = slotMap.find(resource);
+        return slot ? *slot : c_NoSlot;
+    }
+
+    template<typename T>
+    static void storeTrackingSlot(T* resource, uint32_t slot, uint32_t lane, uint64_t recordingID, PointerMap<T, uint32_t>& slotMap)
+    {
+        if (lane != c_NoLane && slot <= c_TrackingSlotIndexMask)
+            resource->trackingSlots[lane] = (recordingID << c_TrackingSlotIndexBits) | slot;
+        else
+            slotMap[resource] = slot;
+    }
+
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback)
     {
         if ((permanentState & requiredState) != requiredState)
@@ -48,6 +121,48 @@ namespace nvrhi
         return mipLevel + arraySlice * desc.mipLevels;
     }
 
+    CommandListResourceStateTracker::CommandListResourceStateTracker(IMessageCallback* messageCallback)
+        : m_MessageCallback(messageCallback)
+        , m_Lane(c_NoLane)
+        , m_RecordingID(allocateRecordingID())
+    { }
+
+    CommandListResourceStateTracker::~CommandListResourceStateTracker()
+    {
+        if (m_LaneState == LaneState::Owned)
+            releaseLane(m_Lane);
+    }
+
+    void CommandListResourceStateTracker::acquireLane()
+    {
+        if (m_LaneState == LaneState::Released)
+        {
+            // The recording is used after close, e.g. for getTextureSubresourceState. Another recording may have taken
+            // the lane and overwritten the entries, so move all slots of this recording into the slot maps.
+            for (uint32_t slot = 0; slot < m_NumTrackedTextures; slot++)
+                m_TextureSlotMap[m_TextureStates[slot].texture] = slot;
+            for (uint32_t slot = 0; slot < m_NumTrackedBuffers; slot++)
+                m_BufferSlotMap[m_BufferStates[slot].buffer] = slot;
+
+            m_LaneState = LaneState::Unavailable;
+            return;
+        }
+
+        m_Lane = allocateLane();
+        m_LaneState = (m_Lane != c_NoLane) ? LaneState::Owned : LaneState::Unavailable;
+    }
+
+    void CommandListResourceStateTracker::commandListClosed()
+    {
+        // Let other recordings use the lane while this command list waits for execution
+        if (m_LaneState == LaneState::Owned)
+        {
+            releaseLane(m_Lane);
+            m_Lane = c_NoLane;
+            m_LaneState = LaneState::Released;
+        }
+    }
+
     void CommandListResourceStateTracker::setEnableUavBarriersForTexture(TextureStateExtension* texture, bool enableBarriers)
     {
         TextureState* tracking = getTextureStateTracking(texture, true);
@@ -139,6 +254,9 @@ namespace nvrhi
         if (!tracking)
             return ResourceStates::Unknown;
 
+        if (tracking->subresourceStates.empty())
+            return tracking->state;
+
         uint32_t subresource = calcSubresource(mipLevel, arraySlice, texture->descRef);
         return tracking->subresourceStates[subresource];
     }
@@ -245,7 +363,7 @@ namespace nvrhi
                         barrier.arraySlice = arraySlice;
                         barrier.stateBefore = priorState;
                         barrier.stateAfter = state;
-                        m_TextureBarriers.push_back(barrier);
+                        appendSubresourceBarrier(barrier);
                     }
 
                     tracking->subresourceStates[subresourceIndex] = state;
@@ -256,10 +374,70 @@ namespace nvrhi
                         tracking->firstUavBarrierPlaced = true;
                     }
                 }
+
+                mergeLastSubresourceBarriers();
+            }
+
+            // All subresources are in the same state now, switch back to the compact representation
+            if (subresources.isEntireTexture(texture->descRef))
+            {
+                tracking->subresourceStates.clear();
+                tracking->state = state;
             }
         }
     }
 
+    static bool canMergeSubresourceBarriers(const TextureBarrier& a, const TextureBarrier& b)
+    {
+        return a.texture == b.texture && !a.entireTexture && !b.entireTexture
+            && a.stateBefore == b.stateBefore && a.stateAfter == b.stateAfter;
+    }
+
+    static void promoteToEntireTexture(TextureBarrier& barrier)
+    {
+        const TextureDesc& desc = barrier.texture->descRef;
+        if (barrier.mipLevel == 0 && barrier.numMipLevels == desc.mipLevels &&
+            barrier.arraySlice == 0 && barrier.numArraySlices == desc.arraySize)
+        {
+            barrier.entireTexture = true;
+        }
+    }
+
+    void CommandListResourceStateTracker::appendSubresourceBarrier(const TextureBarrier& barrier)
+    {
+        if (!m_TextureBarriers.empty())
+        {
+            TextureBarrier& last = m_TextureBarriers.back();
+            if (canMergeSubresourceBarriers(last, barrier) && last.numArraySlices == 1 &&
+                last.arraySlice == barrier.arraySlice && last.mipLevel + last.numMipLevels == barrier.mipLevel)
+            {
+                last.numMipLevels++;
+                promoteToEntireTexture(last);
+                return;
+            }
+        }
+
+        m_TextureBarriers.push_back(barrier);
+        promoteToEntireTexture(m_TextureBarriers.back());
+    }
+
+    void CommandListResourceStateTracker::mergeLastSubresourceBarriers()
+    {
+        if (m_TextureBarriers.size() < 2)
+            return;
+
+        TextureBarrier& prev = m_TextureBarriers[m_TextureBarriers.size() - 2];
+        const TextureBarrier& last = m_TextureBarriers.back();
+        if (canMergeSubresourceBarriers(prev, last) && last.numArraySlices == 1 &&
+            prev.mipLevel == last.mipLevel && prev.numMipLevels == last.numMipLevels &&
+            prev.arraySlice + prev.numArraySlices == last.arraySlice)
+        {
+            prev.numArraySlices++;
+            m_TextureBarriers.pop_back();
+            promoteToEntireTexture(m_TextureBarriers.back());
+        }
+    }
+
     void CommandListResourceStateTracker::requireBufferState(BufferStateExtension* buffer, ResourceStates state)
     {
         if (buffer->descRef.isVolatile)
@@ -328,12 +506,14 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepBufferInitialStates()
     {
-        for (auto& [buffer, tracking] : m_BufferStates)
+        for (uint32_t slot = 0; slot < m_NumTrackedBuffers; slot++)
         {
+            BufferStateExtension* buffer = m_BufferStates[slot].buffer;
+
             if (buffer->descRef.keepInitialState && 
                 !buffer->permanentState &&
                 !buffer->descRef.isVolatile &&
-                !tracking->permanentTransition)
+                !m_BufferStates[slot].state.permanentTransition)
             {
                 requireBufferState(buffer, buffer->descRef.initialState);
             }
@@ -342,11 +522,13 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepTextureInitialStates()
     {
-        for (auto& [texture, tracking] : m_TextureStates)
+        for (uint32_t slot = 0; slot < m_NumTrackedTextures; slot++)
         {
+            TextureStateExtension* texture = m_TextureStates[slot].texture;
+
             if (texture->descRef.keepInitialState && 
                 !texture->permanentState && 
-                !tracking->permanentTransition)
+                !m_TextureStates[slot].state.permanentTransition)
             {
                 requireTextureState(texture, AllSubresources, texture->descRef.initialState);
             }
@@ -385,32 +567,73 @@ namespace nvrhi
         }
         m_PermanentBufferStates.clear();
 
-        for (const auto& [texture, stateTracking] : m_TextureStates)
+        for (uint32_t slot = 0; slot < m_NumTrackedTextures; slot++)
         {
+            TextureStateExtension* texture = m_TextureStates[slot].texture;
             if (texture->descRef.keepInitialState && !texture->stateInitialized)
                 texture->stateInitialized = true;
         }
 
-        m_TextureStates.clear();
-        m_BufferStates.clear();
+        // Release the slots for reuse. A new recording ID invalidates all tracking slot entries written so far.
+        m_NumTrackedTextures = 0;
+        m_NumTrackedBuffers = 0;
+        m_TextureSlotMap.clear();
+        m_BufferSlotMap.clear();
+        m_RecordingID = allocateRecordingID();
+
+        if (m_LaneState == LaneState::Owned)
+        {
+            releaseLane(m_Lane);
+            m_Lane = c_NoLane;
+        }
+        m_LaneState = LaneState::NotRequested;
+    }
+
+    size_t CommandListResourceStateTracker::getStorageCapacity() const
+    {
+        size_t capacity = m_TextureStates.capacity() + m_BufferStates.capacity()
+            + m_TextureSlotMap.capacity() + m_BufferSlotMap.capacity()
+            + m_PermanentTextureStates.capacity() + m_PermanentBufferStates.capacity()
+            + m_TextureBarriers.capacity() + m_BufferBarriers.capacity();
+
+        // Pooled entries keep their subresource state storage, see getTextureStateTracking
+        for (const TrackedTexture& entry : m_TextureStates)
+            capacity += entry.state.subresourceStates.capacity();
+
+        return capacity;
     }
 
     TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
     {
-        auto it = m_TextureStates.find(texture);
+        updateLane();
 
-        if (it != m_TextureStates.end())
+        uint32_t slot = findTrackingSlot(texture, m_Lane, m_RecordingID, m_TextureSlotMap);
+
+        if (slot != c_NoSlot)
         {
-            return it->second.get();
+            assert(slot < m_NumTrackedTextures && m_TextureStates[slot].texture == texture);
+            return &m_TextureStates[slot].state;
         }
 
         if (!allowCreate)
             return nullptr;
-        
-        std::unique_ptr<TextureState> trackingRef = std::make_unique<TextureState>();
 
-        TextureState* tracking = trackingRef.get();
-        m_TextureStates.insert(std::make_pair(texture, std::move(trackingRef)));
+        slot = m_NumTrackedTextures++;
+        if (slot == m_TextureStates.size())
+            m_TextureStates.emplace_back();
+
+        TrackedTexture& entry = m_TextureStates[slot];
+        entry.texture = texture;
+
+        // Reset the pooled state, keeping the subresource state storage
+        TextureState* tracking = &entry.state;
+        tracking->subresourceStates.clear();
+        tracking->state = ResourceStates::Unknown;
+        tracking->enableUavBarriers = true;
+        tracking->firstUavBarrierPlaced = false;
+        tracking->permanentTransition = false;
+
+        storeTrackingSlot(texture, slot, m_Lane, m_RecordingID, m_TextureSlotMap);
         
         if (texture->descRef.keepInitialState)
         {
@@ -422,20 +645,29 @@ namespace nvrhi
 
     BufferState* CommandListResourceStateTracker::getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate)
     {
-        auto it = m_BufferStates.find(buffer);
+        updateLane();
 
-        if (it != m_BufferStates.end())
+        uint32_t slot = findTrackingSlot(buffer, m_Lane, m_RecordingID, m_BufferSlotMap);
+
+        if (slot != c_NoSlot)
         {
-            return it->second.get();
+            assert(slot < m_NumTrackedBuffers && m_BufferStates[slot].buffer == buffer);
+            return &m_BufferStates[slot].state;
         }
 
         if (!allowCreate)
             return nullptr;
 
-        std::unique_ptr<BufferState> trackingRef = std::make_unique<BufferState>();
+        slot = m_NumTrackedBuffers++;
+        if (slot == m_BufferStates.size())
+            m_BufferStates.emplace_back();
+
+        TrackedBuffer& entry = m_BufferStates[slot];
+        entry.buffer = buffer;
+        entry.state = BufferState();
+        BufferState* tracking = &entry.state;
 
-        BufferState* tracking = trackingRef.get();
-        m_BufferStates.insert(std::make_pair(buffer, std::move(trackingRef)));
+        storeTrackingSlot(buffer, slot, m_Lane, m_RecordingID, m_BufferSlotMap);
                                                    
         if (buffer->descRef.keepInitialState)
         {
@@ -444,4 +676,36 @@ namespace nvrhi
 
         return tracking;
     }
+
+    void BundleStateRequirements::requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        auto it = m_LastTextureRequirement.find(texture);
+        if (it != m_LastTextureRequirement.end())
+        {
+            const TextureRequirement& last = m_Textures[it->second];
+            if (last.subresources == subresources && last.state == state)
+                return;
+        }
+
+        m_LastTextureRequirement[texture] = m_Textures.size();
+        m_Textures.push_back({ texture, subresources, state });
+    }
+
+    void BundleStateRequirements::requireBufferState(IBuffer* buffer, ResourceStates state)
+    {
+        auto it = m_LastBufferRequirement.find(buffer);
+        if (it != m_LastBufferRequirement.end() && m_Buffers[it->second].state == state)
+            return;
+
+        m_LastBufferRequirement[buffer] = m_Buffers.size();
+        m_Buffers.push_back({ buffer, state });
+    }
+
+    void BundleStateRequirements::clear()
+    {
+        m_Textures.clear();
+        m_Buffers.clear();
+        m_LastTextureRequirement.clear();
+        m_LastBufferRequirement.clear();
+    }
 } // namespace nvrhi
\ No newline at end of file
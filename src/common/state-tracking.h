@@ -23,15 +23,21 @@
 #pragma once
 
 #include <nvrhi/nvrhi.h>
-#include <memory>
+#include "pointer-map.h"
 #include <unordered_map>
 
 namespace nvrhi
 {
+    // Number of command list recordings that can find their tracking data for a resource without a hash map lookup.
+    // Every resource stores one tracking slot per lane, and each recording owns one lane from its first state lookup
+    // until the command list is closed, so the lanes only need to cover the recordings that are open at the same time.
+    constexpr uint32_t c_StateTrackingLaneCount = 8;
+
     struct BufferStateExtension
     {
         const BufferDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
+        uint64_t trackingSlots[c_StateTrackingLaneCount] = {}; // see CommandListResourceStateTracker
 
         explicit BufferStateExtension(const BufferDesc& desc)
             : descRef(desc)
@@ -43,6 +49,7 @@ namespace nvrhi
         const TextureDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
         bool stateInitialized = false;
+        uint64_t trackingSlots[c_StateTrackingLaneCount] = {}; // see CommandListResourceStateTracker
 
         explicit TextureStateExtension(const TextureDesc& desc)
             : descRef(desc)
@@ -51,6 +58,7 @@ namespace nvrhi
 
     struct TextureState
     {
+        // Empty when all subresources are in 'state', which is the common case
         std::vector<ResourceStates> subresourceStates;
         ResourceStates state = ResourceStates::Unknown;
         bool enableUavBarriers = true;
@@ -69,8 +77,12 @@ namespace nvrhi
     struct TextureBarrier
     {
         TextureStateExtension* texture = nullptr;
+        // The range of subresources, ignored when entireTexture is set.
+        // Barriers on adjacent subresources with the same states are merged into one range by the tracker.
         MipLevel mipLevel = 0;
+        MipLevel numMipLevels = 1;
         ArraySlice arraySlice = 0;
+        ArraySlice numArraySlices = 1;
         bool entireTexture = false;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
@@ -83,12 +95,18 @@ namespace nvrhi
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
 
+    // Tracks the states of the resources used in one command list.
+    // The tracking data lives in pooled slots that are reused across recordings. The tracker finds the slot for a resource
+    // through the resource's trackingSlots entry for the lane owned by the recording, which stores the current recording ID
+    // and the slot index. Recordings that could not get a lane, or slots that don't fit in the entry, use a hash map instead.
     class CommandListResourceStateTracker
     {
     public:
-        explicit CommandListResourceStateTracker(IMessageCallback* messageCallback)
-            : m_MessageCallback(messageCallback)
-        { }
+        explicit CommandListResourceStateTracker(IMessageCallback* messageCallback);
+        ~CommandListResourceStateTracker();
+
+        CommandListResourceStateTracker(const CommandListResourceStateTracker&) = delete;
+        CommandListResourceStateTracker& operator=(const CommandListResourceStateTracker&) = delete;
 
         // ICommandList-like interface
 
@@ -111,17 +129,59 @@ namespace nvrhi
 
         void keepBufferInitialStates();
         void keepTextureInitialStates();
+        void commandListClosed();
         void commandListSubmitted();
 
         [[nodiscard]] const std::vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
         [[nodiscard]] const std::vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
         void clearBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
 
+        // The resources used by the current recording and their states at the end of it, valid until commandListSubmitted
+        [[nodiscard]] uint32_t getNumTrackedTextures() const { return m_NumTrackedTextures; }
+        [[nodiscard]] TextureStateExtension* getTrackedTexture(uint32_t index) const { return m_TextureStates[index].texture; }
+        [[nodiscard]] const TextureState& getTrackedTextureState(uint32_t index) const { return m_TextureStates[index].state; }
+        [[nodiscard]] uint32_t getNumTrackedBuffers() const { return m_NumTrackedBuffers; }
+        [[nodiscard]] BufferStateExtension* getTrackedBuffer(uint32_t index) const { return m_BufferStates[index].buffer; }
+
+        // Total capacity of the storage that is reused across recordings, grows only until the recordings reach a steady state
+        [[nodiscard]] size_t getStorageCapacity() const;
+
     private:
         IMessageCallback* m_MessageCallback;
 
-        std::unordered_map<TextureStateExtension*, std::unique_ptr<TextureState>> m_TextureStates;
-        std::unordered_map<BufferStateExtension*, std::unique_ptr<BufferState>> m_BufferStates;
+        struct TrackedTexture
+        {
+            TextureStateExtension* texture = nullptr;
+            TextureState state;
+        };
+
+        struct TrackedBuffer
+        {
+            BufferStateExtension* buffer = nullptr;
+            BufferState state;
+        };
+
+        // Only the first m_NumTracked* elements are in use; the rest keep their allocations for future recordings
+        std::vector<TrackedTexture> m_TextureStates;
+        std::vector<TrackedBuffer> m_BufferStates;
+        uint32_t m_NumTrackedTextures = 0;
+        uint32_t m_NumTrackedBuffers = 0;
+
+        // Fallback lookup for the resources that have no valid tracking slot entry
+        PointerMap<TextureStateExtension, uint32_t> m_TextureSlotMap;
+        PointerMap<BufferStateExtension, uint32_t> m_BufferSlotMap;
+
+        enum class LaneState : uint8_t
+        {
+            NotRequested,   // no lookups in the current recording yet
+            Owned,          // m_Lane belongs to the recording
+            Unavailable,    // all lanes were taken, or the slot maps have all the slots of the recording
+            Released        // released in commandListClosed, some slots are only in the resources' lane entries
+        };
+
+        uint32_t m_Lane;
+        LaneState m_LaneState = LaneState::NotRequested;
+        uint64_t m_RecordingID;
 
         // Deferred transitions of textures and buffers to permanent states.
         // They are executed only when the command list is executed, not when the app calls setPermanentTextureState or setPermanentBufferState.
@@ -131,10 +191,59 @@ namespace nvrhi
         std::vector<TextureBarrier> m_TextureBarriers;
         std::vector<BufferBarrier> m_BufferBarriers;
 
+        // Prepares m_Lane for the lookups of the current recording
+        void updateLane()
+        {
+            if (m_LaneState == LaneState::Owned || m_LaneState == LaneState::Unavailable)
+                return;
+            acquireLane();
+        }
+        void acquireLane();
+
         TextureState* getTextureStateTracking(TextureStateExtension* texture, bool allowCreate);
+
+        // Adds a barrier for one subresource, extending the previous barrier's mip range if it's on the preceding mip
+        void appendSubresourceBarrier(const TextureBarrier& barrier);
+        // Merges the last barrier into the one before it if they cover the same mips on adjacent array slices
+        void mergeLastSubresourceBarriers();
         BufferState* getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate);
     };
 
+    // Resource states required by the commands recorded into a command bundle.
+    // Bundles cannot place barriers, so the command list that executes a bundle requires these states before running it.
+    // Repeated requirements for the same resource and state are stored once.
+    class BundleStateRequirements
+    {
+    public:
+        struct TextureRequirement
+        {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            ResourceStates state = ResourceStates::Unknown;
+        };
+
+        struct BufferRequirement
+        {
+            IBuffer* buffer = nullptr;
+            ResourceStates state = ResourceStates::Unknown;
+        };
+
+        void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
+        void requireBufferState(IBuffer* buffer, ResourceStates state);
+        void clear();
+
+        [[nodiscard]] const std::vector<TextureRequirement>& getTextures() const { return m_Textures; }
+        [[nodiscard]] const std::vector<BufferRequirement>& getBuffers() const { return m_Buffers; }
+
+    private:
+        std::vector<TextureRequirement> m_Textures;
+        std::vector<BufferRequirement> m_Buffers;
+
+        // Index of the last requirement for each resource
+        std::unordered_map<ITexture*, size_t> m_LastTextureRequirement;
+        std::unordered_map<IBuffer*, size_t> m_LastBufferRequirement;
+    };
+
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback);
 
 } // namespace nvrhi
\ No newline at end of file
@@ -0,0 +1,286 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "streaming-uploader.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace nvrhi
+{
+    StreamingUploader::StreamingUploader(IDevice* device, const StreamingUploaderDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Queue(desc.queue)
+    {
+        if (m_Queue == CommandQueue::Copy && !m_Device->queryFeatureSupport(Feature::CopyQueue))
+            m_Queue = CommandQueue::Graphics;
+        if (m_Queue == CommandQueue::Compute && !m_Device->queryFeatureSupport(Feature::ComputeQueue))
+            m_Queue = CommandQueue::Graphics;
+
+        m_CommandList = m_Device->createCommandList(CommandListParameters()
+            .setQueueType(m_Queue)
+            .setEnableImmediateExecution(false));
+    }
+
+    uint64_t StreamingUploader::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        if (!dest || !data)
+            return 0;
+
+        const TextureDesc& desc = dest->getDesc();
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        const uint32_t mipWidth = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t mipHeight = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t mipDepth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        // Copy only the bytes that writeTexture reads, the last row and slice may be shorter than the pitch
+        const size_t blocksX = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const size_t blocksY = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const size_t sliceSize = (blocksY - 1) * rowPitch + blocksX * formatInfo.bytesPerBlock;
+        const size_t dataSize = (mipDepth - 1) * depthPitch + sliceSize;
+
+        Write write;
+        write.texture = dest;
+        write.arraySlice = arraySlice;
+        write.mipLevel = mipLevel;
+        write.rowPitch = rowPitch;
+        write.depthPitch = depthPitch;
+        write.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + dataSize);
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_PendingWrites.push_back(std::move(write));
+        return m_OpenTicket;
+    }
+
+    uint64_t StreamingUploader::writeBuffer(IBuffer* dest, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        if (!dest || !data || dataSize == 0)
+            return 0;
+
+        Write write;
+        write.buffer = dest;
+        write.destOffset = destOffsetBytes;
+        write.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + dataSize);
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_PendingWrites.push_back(std::move(write));
+        return m_OpenTicket;
+    }
+
+    void StreamingUploader::addCompletionCallback(uint64_t ticket, std::function<void()> callback)
+    {
+        if (!callback)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (ticket >= m_OpenTicket)
+            m_PendingCallbacks.push_back(std::move(callback));
+        else if (Batch* batch = findBatch(ticket))
+            batch->callbacks.push_back(std::move(callback));
+        else
+            m_CompletedCallbacks.push_back(std::move(callback));
+    }
+
+    uint64_t StreamingUploader::flush()
+    {
+        std::lock_guard flushLockGuard(m_FlushMutex);
+        return flushLocked();
+    }
+
+    uint64_t StreamingUploader::flushLocked()
+    {
+        std::vector<Write> writes;
+        uint64_t ticket;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (m_PendingWrites.empty() && m_PendingCallbacks.empty())
+                return m_OpenTicket - 1;
+
+            writes.swap(m_PendingWrites);
+            ticket = m_OpenTicket++;
+
+            Batch batch;
+            batch.ticket = ticket;
+            batch.callbacks.swap(m_PendingCallbacks);
+
+            if (writes.empty())
+            {
+                // A batch with only callbacks completes together with the previous batch
+                if (!m_Batches.empty())
+                {
+                    batch.instance = m_Batches.back().instance;
+                    batch.query = m_Batches.back().query;
+                }
+                batch.submitted = true;
+            }
+
+            m_Batches.push_back(std::move(batch));
+
+            if (writes.empty())
+                return ticket;
+        }
+
+        EventQueryHandle query = m_Device->createEventQuery();
+
+        m_CommandList->open();
+
+        for (const Write& write : writes)
+        {
+            if (write.texture)
+                m_CommandList->writeTexture(write.texture, write.arraySlice, write.mipLevel, write.data.data(), write.rowPitch, write.depthPitch);
+            else
+                m_CommandList->writeBuffer(write.buffer, write.data.data(), write.data.size(), write.destOffset);
+        }
+
+        m_CommandList->close();
+
+        ICommandList* commandList = m_CommandList;
+        const uint64_t instance = m_Device->executeCommandLists(&commandList, 1, m_Queue);
+        m_Device->setEventQuery(query, m_Queue);
+
+        std::lock_guard lockGuard(m_Mutex);
+        Batch* batch = findBatch(ticket);
+        assert(batch);
+        batch->instance = instance;
+        batch->query = query;
+        batch->submitted = true;
+
+        return ticket;
+    }
+
+    void StreamingUploader::update()
+    {
+        std::vector<std::function<void()>> callbacks;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            callbacks.swap(m_CompletedCallbacks);
+
+            while (!m_Batches.empty())
+            {
+                Batch& batch = m_Batches.front();
+                if (!batch.submitted)
+                    break;
+
+                if (batch.query && !m_Device->pollEventQuery(batch.query))
+                    break;
+
+                for (auto& callback : batch.callbacks)
+                    callbacks.push_back(std::move(callback));
+
+                m_Batches.pop_front();
+            }
+        }
+
+        // Callbacks are called outside of the lock, so that they can issue new writes
+        for (const auto& callback : callbacks)
+            callback();
+    }
+
+    bool StreamingUploader::isComplete(uint64_t ticket)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (ticket >= m_OpenTicket)
+            return false;
+
+        const Batch* batch = findBatch(ticket);
+        if (!batch)
+            return true;
+
+        if (!batch->submitted)
+            return false;
+
+        return !batch->query || m_Device->pollEventQuery(batch->query);
+    }
+
+    void StreamingUploader::wait(uint64_t ticket)
+    {
+        EventQueryHandle query;
+
+        {
+            std::lock_guard flushLockGuard(m_FlushMutex);
+
+            bool isOpen;
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                isOpen = ticket >= m_OpenTicket;
+            }
+
+            if (isOpen)
+                flushLocked();
+
+            // All batches up to the ticket are submitted now, because submissions are serialized by m_FlushMutex
+            std::lock_guard lockGuard(m_Mutex);
+            if (const Batch* batch = findBatch(ticket))
+                query = batch->query;
+        }
+
+        if (query)
+            m_Device->waitEventQuery(query);
+    }
+
+    void StreamingUploader::queueWait(CommandQueue waitQueue, uint64_t ticket)
+    {
+        uint64_t instance = 0;
+
+        {
+            std::lock_guard flushLockGuard(m_FlushMutex);
+
+            bool isOpen;
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                isOpen = ticket >= m_OpenTicket;
+            }
+
+            if (isOpen)
+                flushLocked();
+
+            std::lock_guard lockGuard(m_Mutex);
+            if (const Batch* batch = findBatch(ticket))
+                instance = batch->instance;
+        }
+
+        // Work on the same queue is ordered after the batch already
+        if (instance != 0 && waitQueue != m_Queue)
+            m_Device->queueWaitForCommandList(waitQueue, m_Queue, instance);
+    }
+
+    StreamingUploader::Batch* StreamingUploader::findBatch(uint64_t ticket)
+    {
+        // Tickets of the batches in flight are consecutive, older batches have been retired
+        if (m_Batches.empty() || ticket < m_Batches.front().ticket)
+            return nullptr;
+
+        const size_t index = size_t(ticket - m_Batches.front().ticket);
+        if (index >= m_Batches.size())
+            return nullptr;
+
+        return &m_Batches[index];
+    }
+}
@@ -0,0 +1,89 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Backend-independent implementation of IStreamingUploader on top of a command list for the uploader queue
+    // and the IDevice event query functions.
+    class StreamingUploader : public RefCounter<IStreamingUploader>
+    {
+    public:
+        StreamingUploader(IDevice* device, const StreamingUploaderDesc& desc);
+
+        uint64_t writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        uint64_t writeBuffer(IBuffer* dest, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        void addCompletionCallback(uint64_t ticket, std::function<void()> callback) override;
+        uint64_t flush() override;
+        void update() override;
+        bool isComplete(uint64_t ticket) override;
+        void wait(uint64_t ticket) override;
+        void queueWait(CommandQueue waitQueue, uint64_t ticket) override;
+
+    private:
+        struct Write
+        {
+            TextureHandle texture;
+            BufferHandle buffer;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            size_t rowPitch = 0;
+            size_t depthPitch = 0;
+            uint64_t destOffset = 0;
+            std::vector<uint8_t> data;
+        };
+
+        struct Batch
+        {
+            uint64_t ticket = 0;
+            uint64_t instance = 0;
+            EventQueryHandle query;
+            bool submitted = false;
+            std::vector<std::function<void()>> callbacks;
+        };
+
+        IDevice* m_Device;
+        StreamingUploaderDesc m_Desc;
+        CommandQueue m_Queue;
+        CommandListHandle m_CommandList;
+
+        // Protects the pending writes and the batch list
+        std::mutex m_Mutex;
+        // Serializes the recording and submission of batches
+        std::mutex m_FlushMutex;
+
+        std::vector<Write> m_PendingWrites;
+        std::vector<std::function<void()>> m_PendingCallbacks;
+        std::vector<std::function<void()>> m_CompletedCallbacks;
+        uint64_t m_OpenTicket = 1;
+        std::deque<Batch> m_Batches;
+
+        uint64_t flushLocked();
+        Batch* findBatch(uint64_t ticket);
+    };
+}
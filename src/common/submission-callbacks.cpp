@@ -0,0 +1,170 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "submission-callbacks.h"
+
+namespace nvrhi
+{
+    static bool isSubmissionCompleted(const SubmissionPoint& submission, const CompletedInstances& completed)
+    {
+        return submission.instance == 0
+            || size_t(submission.queue) >= completed.size()
+            || completed[size_t(submission.queue)] >= submission.instance;
+    }
+
+    size_t findCompletedSubmission(const SubmissionPoint* submissions, size_t count, const CompletedInstances& completed)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            if (isSubmissionCompleted(submissions[index], completed))
+                return index;
+        }
+
+        return count;
+    }
+
+    bool allSubmissionsCompleted(const SubmissionPoint* submissions, size_t count, const CompletedInstances& completed)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            if (!isSubmissionCompleted(submissions[index], completed))
+                return false;
+        }
+
+        return true;
+    }
+
+    SubmissionCallbackThread::SubmissionCallbackThread(GetCompletedFunction getCompleted, WaitAnyFunction waitAny)
+        : m_GetCompleted(std::move(getCompleted))
+        , m_WaitAny(std::move(waitAny))
+    {
+    }
+
+    SubmissionCallbackThread::~SubmissionCallbackThread()
+    {
+        shutdown();
+    }
+
+    void SubmissionCallbackThread::add(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        if (!callback)
+            return;
+
+        Entry entry;
+        entry.submissions.assign(submissions, submissions + count);
+        entry.waitAny = waitAny;
+        entry.callback = std::move(callback);
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (m_Stop)
+                return;
+
+            m_Entries.push_back(std::move(entry));
+
+            if (!m_Thread.joinable())
+                m_Thread = std::thread(&SubmissionCallbackThread::threadProc, this);
+        }
+
+        m_Condition.notify_one();
+    }
+
+    bool SubmissionCallbackThread::hasPendingCallbacks()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        return !m_Entries.empty();
+    }
+
+    void SubmissionCallbackThread::shutdown()
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Stop = true;
+        }
+
+        m_Condition.notify_one();
+
+        if (m_Thread.joinable())
+            m_Thread.join();
+    }
+
+    void SubmissionCallbackThread::threadProc()
+    {
+        std::vector<SubmissionCallback> readyCallbacks;
+        std::vector<SubmissionPoint> pendingSubmissions;
+
+        std::unique_lock lock(m_Mutex);
+
+        while (true)
+        {
+            m_Condition.wait(lock, [this] { return m_Stop || !m_Entries.empty(); });
+
+            if (m_Entries.empty())
+                break;
+
+            CompletedInstances completed;
+            m_GetCompleted(completed);
+
+            // Take out the entries that are ready and collect the submissions that the others are waiting for
+            pendingSubmissions.clear();
+            for (size_t index = 0; index < m_Entries.size(); )
+            {
+                Entry& entry = m_Entries[index];
+                const bool ready = entry.waitAny
+                    ? findCompletedSubmission(entry.submissions.data(), entry.submissions.size(), completed) < entry.submissions.size()
+                    : allSubmissionsCompleted(entry.submissions.data(), entry.submissions.size(), completed);
+
+                if (ready || m_Stop)
+                {
+                    if (ready)
+                        readyCallbacks.push_back(std::move(entry.callback));
+                    m_Entries.erase(m_Entries.begin() + ptrdiff_t(index));
+                    continue;
+                }
+
+                for (const SubmissionPoint& submission : entry.submissions)
+                {
+                    // Submissions on invalid queues count as completed, like in IDevice::setEventOnSubmissions
+                    if (!isSubmissionCompleted(submission, completed))
+                        pendingSubmissions.push_back(submission);
+                }
+                ++index;
+            }
+
+            lock.unlock();
+
+            if (!readyCallbacks.empty())
+            {
+                for (const SubmissionCallback& callback : readyCallbacks)
+                    callback();
+                readyCallbacks.clear();
+            }
+            else if (!pendingSubmissions.empty())
+            {
+                m_WaitAny(pendingSubmissions.data(), pendingSubmissions.size(), c_RegistrationLatency);
+            }
+
+            lock.lock();
+        }
+    }
+}
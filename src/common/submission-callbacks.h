@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nvrhi
+{
+    // Completed instance per queue, indexed by CommandQueue. Queues that the device doesn't have are set to ~0,
+    // so that submissions on them count as completed.
+    typedef std::array<uint64_t, size_t(CommandQueue::Count)> CompletedInstances;
+
+    // Returns the index of the first completed submission, or count if none of them has completed.
+    size_t findCompletedSubmission(const SubmissionPoint* submissions, size_t count, const CompletedInstances& completed);
+
+    // Returns true if all submissions have completed.
+    bool allSubmissionsCompleted(const SubmissionPoint* submissions, size_t count, const CompletedInstances& completed);
+
+    // Backend-independent implementation of IDevice::notifyOnCompletion.
+    // The callbacks are invoked from a thread that is started by the first registration. While callbacks are pending,
+    // the thread sleeps in the backend's wait-any function on the submissions that haven't completed yet;
+    // that wait is limited to c_RegistrationLatency so that callbacks registered in the meantime are picked up.
+    class SubmissionCallbackThread
+    {
+    public:
+        typedef std::function<void(CompletedInstances& completed)> GetCompletedFunction;
+        typedef std::function<void(const SubmissionPoint* submissions, size_t count, uint64_t timeout)> WaitAnyFunction;
+
+        static constexpr uint64_t c_RegistrationLatency = 1'000'000; // 1 ms
+
+        SubmissionCallbackThread(GetCompletedFunction getCompleted, WaitAnyFunction waitAny);
+        ~SubmissionCallbackThread();
+
+        void add(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback);
+
+        bool hasPendingCallbacks();
+
+        // Invokes the callbacks whose submissions have completed, drops the others and joins the thread.
+        // Called by the device destructor after waitForIdle, while the queues still exist.
+        void shutdown();
+
+    private:
+        struct Entry
+        {
+            std::vector<SubmissionPoint> submissions;
+            bool waitAny = false;
+            SubmissionCallback callback;
+        };
+
+        void threadProc();
+
+        GetCompletedFunction m_GetCompleted;
+        WaitAnyFunction m_WaitAny;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::vector<Entry> m_Entries;
+        std::thread m_Thread;
+        bool m_Stop = false;
+    };
+}
@@ -0,0 +1,357 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "transient-resource-pool.h"
+
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+
+namespace nvrhi
+{
+    // Heap sizes are kept a multiple of the D3D12 MSAA placement alignment, which D3D12 heaps use
+    static constexpr uint64_t c_HeapSizeAlignment = 4 * 1024 * 1024;
+
+    static bool textureDescsMatch(const TextureDesc& a, const TextureDesc& b)
+    {
+        return a.width == b.width
+            && a.height == b.height
+            && a.depth == b.depth
+            && a.arraySize == b.arraySize
+            && a.mipLevels == b.mipLevels
+            && a.sampleCount == b.sampleCount
+            && a.sampleQuality == b.sampleQuality
+            && a.format == b.format
+            && a.dimension == b.dimension
+            && a.debugName == b.debugName
+            && a.isShaderResource == b.isShaderResource
+            && a.isRenderTarget == b.isRenderTarget
+            && a.isUAV == b.isUAV
+            && a.isTypeless == b.isTypeless
+            && a.isShadingRateSurface == b.isShadingRateSurface
+            && a.isTransient == b.isTransient
+            && a.sharedResourceFlags == b.sharedResourceFlags
+            && a.clearValue == b.clearValue
+            && a.useClearValue == b.useClearValue
+            && a.initialState == b.initialState
+            && a.keepInitialState == b.keepInitialState;
+    }
+
+    static bool bufferDescsMatch(const BufferDesc& a, const BufferDesc& b)
+    {
+        return a.byteSize == b.byteSize
+            && a.structStride == b.structStride
+            && a.maxVersions == b.maxVersions
+            && a.debugName == b.debugName
+            && a.format == b.format
+            && a.canHaveUAVs == b.canHaveUAVs
+            && a.canHaveTypedViews == b.canHaveTypedViews
+            && a.canHaveRawViews == b.canHaveRawViews
+            && a.isVertexBuffer == b.isVertexBuffer
+            && a.isIndexBuffer == b.isIndexBuffer
+            && a.isConstantBuffer == b.isConstantBuffer
+            && a.isDrawIndirectArgs == b.isDrawIndirectArgs
+            && a.isAccelStructBuildInput == b.isAccelStructBuildInput
+            && a.isAccelStructStorage == b.isAccelStructStorage
+            && a.isShaderBindingTable == b.isShaderBindingTable
+            && a.isVolatile == b.isVolatile
+            && a.initialState == b.initialState
+            && a.keepInitialState == b.keepInitialState
+            && a.cpuAccess == b.cpuAccess
+            && a.sharedResourceFlags == b.sharedResourceFlags;
+    }
+
+    static HeapCategory getHeapCategory(const TextureDesc& desc)
+    {
+        return desc.isRenderTarget ? HeapCategory::RenderTargetTextures : HeapCategory::Textures;
+    }
+
+    static bool lifetimesOverlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+    {
+        return firstA <= lastB && firstB <= lastA;
+    }
+
+    TransientResourcePool::TransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    { }
+
+    uint32_t TransientResourcePool::declareTexture(const TextureDesc& desc, uint32_t firstUse, uint32_t lastUse)
+    {
+        Declaration declaration;
+        declaration.isTexture = true;
+        declaration.textureDesc = desc;
+        declaration.textureDesc.isVirtual = true;
+        declaration.firstUse = std::min(firstUse, lastUse);
+        declaration.lastUse = std::max(firstUse, lastUse);
+
+        m_PendingDeclarations.push_back(std::move(declaration));
+        return uint32_t(m_PendingDeclarations.size() - 1);
+    }
+
+    uint32_t TransientResourcePool::declareBuffer(const BufferDesc& desc, uint32_t firstUse, uint32_t lastUse)
+    {
+        Declaration declaration;
+        declaration.bufferDesc = desc;
+        declaration.bufferDesc.isVirtual = true;
+        declaration.firstUse = std::min(firstUse, lastUse);
+        declaration.lastUse = std::max(firstUse, lastUse);
+
+        m_PendingDeclarations.push_back(std::move(declaration));
+        return uint32_t(m_PendingDeclarations.size() - 1);
+    }
+
+    bool TransientResourcePool::compile()
+    {
+        std::vector<Declaration> declarations = std::move(m_PendingDeclarations);
+        m_PendingDeclarations.clear();
+
+        // Keep the existing resources if nothing has changed
+        if (!m_Allocations.empty() && declarations.size() == m_CompiledDeclarations.size())
+        {
+            bool allMatch = true;
+            for (size_t index = 0; index < declarations.size() && allMatch; index++)
+            {
+                const Declaration& a = declarations[index];
+                const Declaration& b = m_CompiledDeclarations[index];
+
+                allMatch = a.isTexture == b.isTexture
+                    && a.firstUse == b.firstUse
+                    && a.lastUse == b.lastUse
+                    && (a.isTexture ? textureDescsMatch(a.textureDesc, b.textureDesc) : bufferDescsMatch(a.bufferDesc, b.bufferDesc));
+            }
+
+            if (allMatch)
+                return true;
+        }
+
+        // Release the previous resources. Command lists that still use them keep references until they have finished executing.
+        m_Allocations.clear();
+        m_CompiledDeclarations.clear();
+
+        std::vector<Allocation> allocations(declarations.size());
+        std::vector<MemoryRequirements> requirements(declarations.size());
+
+        for (size_t index = 0; index < declarations.size(); index++)
+        {
+            const Declaration& declaration = declarations[index];
+            Allocation& allocation = allocations[index];
+
+            if (declaration.isTexture)
+            {
+                allocation.texture = m_Device->createTexture(declaration.textureDesc);
+                if (!allocation.texture)
+                    return false;
+
+                requirements[index] = m_Device->getTextureMemoryRequirements(allocation.texture);
+            }
+            else
+            {
+                allocation.buffer = m_Device->createBuffer(declaration.bufferDesc);
+                if (!allocation.buffer)
+                    return false;
+
+                requirements[index] = m_Device->getBufferMemoryRequirements(allocation.buffer);
+            }
+        }
+
+        m_CompiledDeclarations = std::move(declarations);
+        m_Allocations = std::move(allocations);
+
+        if (!placeAllocations(requirements))
+        {
+            m_CompiledDeclarations.clear();
+            m_Allocations.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TransientResourcePool::placeAllocations(const std::vector<MemoryRequirements>& requirements)
+    {
+        // Place the largest resources first, which leaves fewer gaps
+        std::vector<uint32_t> order(m_Allocations.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&requirements](uint32_t a, uint32_t b)
+        {
+            return requirements[a].size > requirements[b].size;
+        });
+
+        struct Range
+        {
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        std::vector<uint32_t> placed;
+        std::vector<Range> occupiedRanges;
+        std::vector<bool> heapUsed(m_Heaps.size(), false);
+
+        for (uint32_t index : order)
+        {
+            const Declaration& declaration = m_CompiledDeclarations[index];
+            Allocation& allocation = m_Allocations[index];
+            const uint64_t size = requirements[index].size;
+            const uint64_t alignment = std::max<uint64_t>(requirements[index].alignment, 1);
+            const HeapCategory category = declaration.isTexture ? getHeapCategory(declaration.textureDesc) : HeapCategory::Buffers;
+
+            allocation.size = size;
+
+            bool found = false;
+            for (uint32_t heapIndex = 0; heapIndex < uint32_t(m_Heaps.size()) && !found; heapIndex++)
+            {
+                if (m_Heaps[heapIndex].category != category)
+                    continue;
+
+                // Collect the memory of the placed resources in this heap that are alive at the same time
+                occupiedRanges.clear();
+                for (uint32_t other : placed)
+                {
+                    const Allocation& otherAllocation = m_Allocations[other];
+                    const Declaration& otherDeclaration = m_CompiledDeclarations[other];
+
+                    if (otherAllocation.heapIndex == heapIndex &&
+                        lifetimesOverlap(declaration.firstUse, declaration.lastUse, otherDeclaration.firstUse, otherDeclaration.lastUse))
+                    {
+                        occupiedRanges.push_back(Range{ otherAllocation.offset, otherAllocation.offset + otherAllocation.size });
+                    }
+                }
+
+                std::sort(occupiedRanges.begin(), occupiedRanges.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+                // Find the first gap that fits the resource
+                uint64_t offset = 0;
+                for (const Range& range : occupiedRanges)
+                {
+                    if (align(offset, alignment) + size <= range.begin)
+                        break;
+
+                    offset = std::max(offset, range.end);
+                }
+                offset = align(offset, alignment);
+
+                if (offset + size <= m_Heaps[heapIndex].heap->getDesc().capacity)
+                {
+                    allocation.heapIndex = heapIndex;
+                    allocation.offset = offset;
+                    heapUsed[heapIndex] = true;
+                    found = true;
+                }
+            }
+
+            if (!found)
+            {
+                std::stringstream ss;
+                ss << m_Desc.debugName << " heap " << m_Heaps.size();
+
+                HeapDesc heapDesc;
+                heapDesc.capacity = align(std::max(m_Desc.heapSize, size), c_HeapSizeAlignment);
+                heapDesc.type = HeapType::DeviceLocal;
+                heapDesc.category = category;
+                heapDesc.debugName = ss.str();
+
+                HeapHandle heap = m_Device->createHeap(heapDesc);
+                if (!heap)
+                    return false;
+
+                allocation.heapIndex = uint32_t(m_Heaps.size());
+                allocation.offset = 0;
+                m_Heaps.push_back(PoolHeap{ heap, category });
+                heapUsed.push_back(true);
+            }
+
+            placed.push_back(index);
+        }
+
+        // Release the heaps that are no longer used. The previous resources keep references to their heaps while they are alive.
+        std::vector<uint32_t> heapRemap(m_Heaps.size(), 0);
+        std::vector<PoolHeap> usedHeaps;
+        for (uint32_t heapIndex = 0; heapIndex < uint32_t(m_Heaps.size()); heapIndex++)
+        {
+            if (heapUsed[heapIndex])
+            {
+                heapRemap[heapIndex] = uint32_t(usedHeaps.size());
+                usedHeaps.push_back(std::move(m_Heaps[heapIndex]));
+            }
+        }
+        m_Heaps = std::move(usedHeaps);
+
+        for (Allocation& allocation : m_Allocations)
+        {
+            allocation.heapIndex = heapRemap[allocation.heapIndex];
+            IHeap* heap = m_Heaps[allocation.heapIndex].heap;
+
+            const bool bound = allocation.texture
+                ? m_Device->bindTextureMemory(allocation.texture, heap, allocation.offset)
+                : m_Device->bindBufferMemory(allocation.buffer, heap, allocation.offset);
+
+            if (!bound)
+                return false;
+        }
+
+        return true;
+    }
+
+    ITexture* TransientResourcePool::getTexture(uint32_t id)
+    {
+        return id < m_Allocations.size() ? m_Allocations[id].texture.Get() : nullptr;
+    }
+
+    IBuffer* TransientResourcePool::getBuffer(uint32_t id)
+    {
+        return id < m_Allocations.size() ? m_Allocations[id].buffer.Get() : nullptr;
+    }
+
+    void TransientResourcePool::beginUsePoint(ICommandList* commandList, uint32_t usePoint)
+    {
+        // Every resource aliases some memory at its first use: if not memory of another resource in this frame,
+        // then memory of a resource from a previous frame.
+        for (size_t index = 0; index < m_Allocations.size(); index++)
+        {
+            if (m_CompiledDeclarations[index].firstUse != usePoint)
+                continue;
+
+            const Allocation& allocation = m_Allocations[index];
+            if (allocation.texture)
+                commandList->textureAliasingBarrier(allocation.texture);
+            else
+                commandList->bufferAliasingBarrier(allocation.buffer);
+        }
+    }
+
+    TransientResourcePoolStatistics TransientResourcePool::getStatistics()
+    {
+        TransientResourcePoolStatistics result;
+
+        for (const PoolHeap& heap : m_Heaps)
+            result.heapMemory += heap.heap->getDesc().capacity;
+        result.numHeaps = uint32_t(m_Heaps.size());
+
+        for (const Allocation& allocation : m_Allocations)
+            result.resourceMemory += allocation.size;
+        result.numResources = uint32_t(m_Allocations.size());
+
+        return result;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <vector>
+
+namespace nvrhi
+{
+    // Backend-independent implementation of ITransientResourcePool on top of the IDevice heap functions:
+    // resources are created as virtual resources, and compile() binds them to offsets in pooled heaps.
+    class TransientResourcePool : public RefCounter<ITransientResourcePool>
+    {
+    public:
+        TransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc);
+
+        uint32_t declareTexture(const TextureDesc& desc, uint32_t firstUse, uint32_t lastUse) override;
+        uint32_t declareBuffer(const BufferDesc& desc, uint32_t firstUse, uint32_t lastUse) override;
+        bool compile() override;
+        ITexture* getTexture(uint32_t id) override;
+        IBuffer* getBuffer(uint32_t id) override;
+        void beginUsePoint(ICommandList* commandList, uint32_t usePoint) override;
+        TransientResourcePoolStatistics getStatistics() override;
+
+    private:
+        struct Declaration
+        {
+            bool isTexture = false;
+            TextureDesc textureDesc;
+            BufferDesc bufferDesc;
+            uint32_t firstUse = 0;
+            uint32_t lastUse = 0;
+        };
+
+        struct Allocation
+        {
+            TextureHandle texture;
+            BufferHandle buffer;
+            uint32_t heapIndex = 0;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+
+        struct PoolHeap
+        {
+            HeapHandle heap;
+            HeapCategory category = HeapCategory::Any; // buffers, render targets and other textures use separate heaps, for D3D12 resource heap tier 1
+        };
+
+        IDevice* m_Device; // not a strong reference, the pool must not outlive the device
+        TransientResourcePoolDesc m_Desc;
+
+        std::vector<Declaration> m_PendingDeclarations;
+        std::vector<Declaration> m_CompiledDeclarations;
+        std::vector<Allocation> m_Allocations;
+        std::vector<PoolHeap> m_Heaps;
+
+        bool placeAllocations(const std::vector<MemoryRequirements>& requirements);
+    };
+}
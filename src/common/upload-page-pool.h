@@ -0,0 +1,287 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/misc.h>
+#include "versioning.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    /*
+    Device-global pool of persistently mapped upload pages, shared by the upload managers of all command lists.
+
+    A command list acquires a page, suballocates from it while recording, and hands it back with submitPages
+    when the recording is executed. Submitted pages stay in flight until the queue has finished the command list
+    instance that their version refers to; after that, they become free and can be acquired by any command list.
+    Pages that were written but never submitted are given back with returnPage and are free immediately.
+
+    endFrame is called from runGarbageCollection. It retires completed pages, releases free pages according to
+    the UploadPoolSettings, and publishes the statistics of the frame that has just ended.
+
+    TPage is the backend's buffer chunk type, with version, bufferSize and writePointer members.
+    */
+    template<typename TPage>
+    class UploadPagePool
+    {
+    public:
+        typedef std::shared_ptr<TPage> PagePtr;
+        typedef std::function<PagePtr(uint64_t size)> CreatePageFunction;
+        typedef std::function<uint64_t(CommandQueue queue)> CompletedInstanceFunction;
+
+        UploadPagePool(CreatePageFunction createPage, CompletedInstanceFunction getCompletedInstance)
+            : m_CreatePage(std::move(createPage))
+            , m_GetCompletedInstance(std::move(getCompletedInstance))
+        { }
+
+        // Returns a free page that can hold at least 'size' bytes, creating a new page of at least
+        // max(size, minPageSize, settings.pageSize) bytes if necessary. Returns nullptr if the page cannot be created.
+        PagePtr acquirePage(uint64_t size, uint64_t minPageSize)
+        {
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                PagePtr page = takeFreePage(size);
+                if (!page)
+                {
+                    retireCompletedPages();
+                    page = takeFreePage(size);
+                }
+
+                if (page)
+                {
+                    ++m_FramePagesReused;
+                    markPageUsed(*page);
+                    return page;
+                }
+
+                minPageSize = std::max(minPageSize, m_Settings.pageSize);
+            }
+
+            // Create the page outside of the lock, it may take a while
+            const uint64_t sizeToAllocate = align(std::max(size, minPageSize), TPage::c_sizeAlignment);
+            PagePtr page = m_CreatePage(sizeToAllocate);
+            if (!page)
+                return nullptr;
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            m_AllocatedMemory += page->bufferSize;
+            ++m_AllocatedPages;
+            ++m_FramePagesCreated;
+            markPageUsed(*page);
+
+            return page;
+        }
+
+        // Takes the pages of an executed command list instance. Their version must have the submitted flag set.
+        void submitPages(std::vector<PagePtr>& pages)
+        {
+            if (pages.empty())
+                return;
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            for (PagePtr& page : pages)
+            {
+                assert(VersionGetSubmitted(page->version));
+                m_InFlightPages.push_back(std::move(page));
+            }
+
+            pages.clear();
+        }
+
+        // Takes a page that has not been submitted to any queue, making it available for reuse right away.
+        void returnPage(PagePtr page)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            m_UsedMemory -= page->bufferSize;
+            addFreePage(std::move(page));
+        }
+
+        // Retires the completed pages, trims the free pages, and starts a new statistics frame.
+        void endFrame()
+        {
+            std::vector<PagePtr> pagesToRelease;
+
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                retireCompletedPages();
+
+                // Release the pages that have been idle for too long, then the oldest ones while over the free memory limit.
+                // The free list is ordered by the time the pages became free, so the oldest pages are at the front.
+                size_t numPagesToRelease = 0;
+                uint64_t freeMemory = m_FreeMemory;
+                for (const FreePage& freePage : m_FreePages)
+                {
+                    const bool idle = m_FrameIndex - freePage.lastUsedFrame > m_Settings.maxIdleFrames;
+                    if (!idle && freeMemory <= m_Settings.maxFreeMemory)
+                        break;
+
+                    freeMemory -= freePage.page->bufferSize;
+                    ++numPagesToRelease;
+                }
+
+                for (size_t index = 0; index < numPagesToRelease; ++index)
+                {
+                    PagePtr& page = m_FreePages[index].page;
+                    m_FreeMemory -= page->bufferSize;
+                    m_AllocatedMemory -= page->bufferSize;
+                    --m_AllocatedPages;
+                    pagesToRelease.push_back(std::move(page));
+                }
+                m_FreePages.erase(m_FreePages.begin(), m_FreePages.begin() + ptrdiff_t(numPagesToRelease));
+
+                m_LastFrameStatistics.frameHighWaterMark = m_FrameHighWaterMark;
+                m_LastFrameStatistics.framePagesCreated = m_FramePagesCreated;
+                m_LastFrameStatistics.framePagesReused = m_FramePagesReused;
+                m_LastFrameStatistics.framePagesReleased = uint32_t(numPagesToRelease);
+
+                m_FrameHighWaterMark = m_UsedMemory;
+                m_FramePagesCreated = 0;
+                m_FramePagesReused = 0;
+                ++m_FrameIndex;
+            }
+
+            // The pages are destroyed here, outside of the lock
+        }
+
+        void setSettings(const UploadPoolSettings& settings)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Settings = settings;
+        }
+
+        UploadPoolStatistics getStatistics()
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            UploadPoolStatistics result = m_LastFrameStatistics;
+            result.allocatedMemory = m_AllocatedMemory;
+            result.allocatedPages = m_AllocatedPages;
+            result.freeMemory = m_FreeMemory;
+            return result;
+        }
+
+    private:
+        struct FreePage
+        {
+            PagePtr page;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        CreatePageFunction m_CreatePage;
+        CompletedInstanceFunction m_GetCompletedInstance;
+
+        std::mutex m_Mutex;
+        UploadPoolSettings m_Settings;
+
+        std::vector<PagePtr> m_InFlightPages;
+        std::vector<FreePage> m_FreePages;
+
+        uint64_t m_FrameIndex = 0;
+        uint64_t m_AllocatedMemory = 0;
+        uint32_t m_AllocatedPages = 0;
+        uint64_t m_FreeMemory = 0;
+        uint64_t m_UsedMemory = 0; // pages owned by command lists or in flight
+
+        uint64_t m_FrameHighWaterMark = 0;
+        uint32_t m_FramePagesCreated = 0;
+        uint32_t m_FramePagesReused = 0;
+        UploadPoolStatistics m_LastFrameStatistics;
+
+        void markPageUsed(TPage& page)
+        {
+            m_UsedMemory += page.bufferSize;
+            m_FrameHighWaterMark = std::max(m_FrameHighWaterMark, m_UsedMemory);
+        }
+
+        void addFreePage(PagePtr page)
+        {
+            page->version = 0;
+            page->writePointer = 0;
+            m_FreeMemory += page->bufferSize;
+            m_FreePages.push_back(FreePage{ std::move(page), m_FrameIndex });
+        }
+
+        // Finds the smallest free page that fits the allocation, preferring the most recently used one among equals.
+        PagePtr takeFreePage(uint64_t size)
+        {
+            auto best = m_FreePages.end();
+            for (auto it = m_FreePages.begin(); it != m_FreePages.end(); ++it)
+            {
+                if (it->page->bufferSize >= size && (best == m_FreePages.end() || it->page->bufferSize <= best->page->bufferSize))
+                    best = it;
+            }
+
+            if (best == m_FreePages.end())
+                return nullptr;
+
+            PagePtr page = std::move(best->page);
+            m_FreePages.erase(best);
+            m_FreeMemory -= page->bufferSize;
+            return page;
+        }
+
+        void retireCompletedPages()
+        {
+            if (m_InFlightPages.empty())
+                return;
+
+            std::array<uint64_t, size_t(CommandQueue::Count)> completedInstances;
+            std::array<bool, size_t(CommandQueue::Count)> completedInstanceKnown = {};
+
+            for (size_t index = 0; index < m_InFlightPages.size(); )
+            {
+                PagePtr& page = m_InFlightPages[index];
+                const size_t queueIndex = size_t(VersionGetQueue(page->version));
+
+                if (!completedInstanceKnown[queueIndex])
+                {
+                    completedInstances[queueIndex] = m_GetCompletedInstance(CommandQueue(queueIndex));
+                    completedInstanceKnown[queueIndex] = true;
+                }
+
+                if (VersionGetInstance(page->version) <= completedInstances[queueIndex])
+                {
+                    m_UsedMemory -= page->bufferSize;
+                    addFreePage(std::move(page));
+
+                    page = std::move(m_InFlightPages.back());
+                    m_InFlightPages.pop_back();
+                }
+                else
+                    ++index;
+            }
+        }
+    };
+}
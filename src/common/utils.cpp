@@ -264,6 +264,34 @@ namespace nvrhi::utils
         }
     }
 
+    uint32_t GetIndirectArgumentSize(const IndirectArgumentDesc& argument)
+    {
+        switch (argument.type)
+        {
+        case IndirectArgumentType::Draw:         return sizeof(DrawIndirectArguments);
+        case IndirectArgumentType::DrawIndexed:  return sizeof(DrawIndexedIndirectArguments);
+        case IndirectArgumentType::Dispatch:     return sizeof(uint32_t) * 3;
+        case IndirectArgumentType::DispatchMesh: return sizeof(DispatchMeshIndirectArguments);
+        case IndirectArgumentType::VertexBuffer: return sizeof(IndirectVertexBufferView);
+        case IndirectArgumentType::IndexBuffer:  return sizeof(IndirectIndexBufferView);
+        case IndirectArgumentType::PushConstants: return argument.size;
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t GetCommandSignatureByteStride(const CommandSignatureDesc& desc)
+    {
+        if (desc.byteStride != 0)
+            return desc.byteStride;
+
+        uint32_t stride = 0;
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+            stride += GetIndirectArgumentSize(argument);
+
+        return stride;
+    }
+
     std::string GenerateHeapDebugName(const HeapDesc& desc)
     {
         std::stringstream ss;
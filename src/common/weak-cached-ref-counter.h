@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+
+namespace nvrhi
+{
+    // Reference counter for objects kept in a cache that only holds weak references to them,
+    // such as the sampler, binding set and root signature caches. Lets the cache tell apart
+    // the objects whose last reference is gone and that wait for their destructor to remove them.
+    template<class T>
+    class WeakCachedRefCounter : public T
+    {
+    public:
+        unsigned long AddRef() override { return ++m_RefCount; }
+        unsigned long Release() override
+        {
+            unsigned long result = --m_RefCount;
+            if (result == 0)
+                delete this;
+            return result;
+        }
+
+        // Adds a reference unless the last one is already gone and the object waits for its destructor
+        // to remove it from the cache. Must be called with the cache locked.
+        bool tryAddRef()
+        {
+            unsigned long count = m_RefCount.load();
+            while (count != 0)
+            {
+                if (m_RefCount.compare_exchange_weak(count, count + 1))
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        std::atomic<unsigned long> m_RefCount = 1;
+    };
+}
@@ -25,9 +25,15 @@
 #include <nvrhi/d3d11.h>
 #include <nvrhi/common/resourcebindingmap.h>
 #include "../common/dxgi-format.h"
+#include "../common/pointer-map.h"
+#include "../common/submission-callbacks.h"
+#include "../common/binding-set-cache.h"
+#include "../common/sampler-cache.h"
 
 #include <d3d11_1.h>
+#include <dxgi1_4.h>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #ifndef NVRHI_D3D11_WITH_NVAPI
@@ -50,6 +56,7 @@ namespace nvrhi::d3d11
     D3D_PRIMITIVE_TOPOLOGY convertPrimType(PrimitiveType pt, uint32_t controlPoints);
     D3D11_TEXTURE_ADDRESS_MODE convertSamplerAddressMode(SamplerAddressMode mode);
     UINT convertSamplerReductionType(SamplerReductionType reductionType);
+    UINT convertResidencyPriority(ResidencyPriority priority);
 
     struct Context
     {
@@ -57,8 +64,13 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11DeviceContext> immediateContext;
         RefCountPtr<ID3D11DeviceContext1> immediateContext1;
         RefCountPtr<ID3D11Buffer> pushConstantBuffer;
+        RefCountPtr<IDXGIAdapter3> adapter; // null if the DXGI runtime is older than 1.4
         IMessageCallback* messageCallback = nullptr;
         bool nvapiAvailable = false;
+        bool driverCommandLists = false; // D3D11_FEATURE_DATA_THREADING::DriverCommandLists
+        // D3D11_FEATURE_DATA_D3D11_OPTIONS::ConstantBufferOffsetting and MapNoOverwriteOnDynamicConstantBuffer,
+        // which allow suballocating volatile constant buffers from a ring buffer
+        bool constantBufferRing = false;
 
         void error(const std::string& message) const;
     };
@@ -82,6 +94,7 @@ namespace nvrhi::d3d11
 
     private:
         const Context& m_Context;
+        std::mutex m_ViewCacheMutex; // views are created while recording, which can happen on multiple threads with deferred command lists
         TextureBindingKey_HashMap<RefCountPtr<ID3D11ShaderResourceView>> m_ShaderResourceViews;
         TextureBindingKey_HashMap<RefCountPtr<ID3D11RenderTargetView>> m_RenderTargetViews;
         TextureBindingKey_HashMap<RefCountPtr<ID3D11DepthStencilView>> m_DepthStencilViews;
@@ -107,6 +120,7 @@ namespace nvrhi::d3d11
         
         Buffer(const Context& context) : m_Context(context) { }
         const BufferDesc& getDesc() const override { return desc; }
+        GpuVirtualAddress getGpuVirtualAddress() const override { return 0; }
         Object getNativeObject(ObjectType objectType) override;
 
         ID3D11ShaderResourceView* getSRV(Format format, BufferRange range, ResourceType type);
@@ -114,6 +128,7 @@ namespace nvrhi::d3d11
         
     private:
         const Context& m_Context;
+        std::mutex m_ViewCacheMutex;
         std::unordered_map<BufferBindingKey, RefCountPtr<ID3D11ShaderResourceView>> m_ShaderResourceViews;
         std::unordered_map<BufferBindingKey, RefCountPtr<ID3D11UnorderedAccessView>> m_UnorderedAccessViews;
     };
@@ -135,13 +150,22 @@ namespace nvrhi::d3d11
         void getBytecode(const void** ppBytecode, size_t* pSize) const override;
     };
 
-    class Sampler : public RefCounter<ISampler>
+    class Sampler : public WeakCachedRefCounter<ISampler>
     {
     public:
         SamplerDesc desc;
         RefCountPtr<ID3D11SamplerState> sampler;
+
+        explicit Sampler(SamplerCache<Sampler>& cache)
+            : m_Cache(cache)
+        { }
+
+        ~Sampler() override { m_Cache.remove(this); }
         
         const SamplerDesc& getDesc() const override { return desc; }
+
+    private:
+        SamplerCache<Sampler>& m_Cache;
     };
 
     class EventQuery : public RefCounter<IEventQuery>
@@ -180,11 +204,14 @@ namespace nvrhi::d3d11
     public:
         FramebufferDesc desc;
         FramebufferInfoEx framebufferInfo;
+        size_t framebufferInfoHash = 0;
         static_vector<RefCountPtr<ID3D11RenderTargetView>, c_MaxRenderTargets> RTVs;
         RefCountPtr<ID3D11DepthStencilView> DSV;
+        static_vector<TextureHandle, c_MaxRenderTargets> resolveTextures;
         
         const FramebufferDesc& getDesc() const override { return desc; }
         const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
     };
 
     struct DX11_ViewportState
@@ -201,6 +228,7 @@ namespace nvrhi::d3d11
         GraphicsPipelineDesc desc;
         ShaderType shaderMask = ShaderType::None;
         FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
 
         D3D11_PRIMITIVE_TOPOLOGY primitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
         InputLayout *inputLayout = nullptr;
@@ -220,6 +248,7 @@ namespace nvrhi::d3d11
         
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
     };
 
     class ComputePipeline : public RefCounter<IComputePipeline>
@@ -236,12 +265,14 @@ namespace nvrhi::d3d11
     {
     public:
         BindingLayoutDesc desc;
+        size_t descHash = 0;
 
         const BindingLayoutDesc* getDesc() const override { return &desc; }
         const BindlessLayoutDesc* getBindlessDesc() const override { return nullptr; }
+        size_t getDescHash() const override { return descHash; }
     };
 
-    class BindingSet : public RefCounter<IBindingSet>
+    class BindingSet : public CacheableBindingSet
     {
     public:
         BindingSetDesc desc;
@@ -266,6 +297,16 @@ namespace nvrhi::d3d11
         uint32_t minUAVSlot = D3D11_1_UAV_SLOT_COUNT;
         uint32_t maxUAVSlot = 0;
 
+        // Volatile constant buffers are rebound to their current location in the command list's ring buffer,
+        // on top of the bindings in the constantBuffers array.
+        struct VolatileConstantBuffer
+        {
+            Buffer* buffer = nullptr;
+            uint32_t slot = 0;
+            UINT firstConstant = 0; // offset of the bound range within the buffer, in 16-byte constants
+        };
+        std::vector<VolatileConstantBuffer> volatileConstantBuffers;
+
         std::vector<RefCountPtr<IResource>> resources;
         
         const BindingSetDesc* getDesc() const override { return &desc; }
@@ -273,10 +314,16 @@ namespace nvrhi::d3d11
         bool isSupersetOf(const BindingSet& other) const;
     };
 
-    class CommandList : public RefCounter<ICommandList>
+    class CommandList final : public RefCounter<ICommandList>
     {
     public:
-        explicit CommandList(const Context& context, IDevice* device, const CommandListParameters& params);
+        // Immediate command lists record directly into the immediate context. Deferred command lists record into
+        // their own deferred context, and close() produces an ID3D11CommandList that executeCommandLists plays back.
+        // Bundle command lists are deferred command lists that leave the attachment load and store ops to executeBundle.
+        explicit CommandList(const Context& context, IDevice* device, ID3D11DeviceContext* d3dContext, const CommandListParameters& params, bool isBundle = false);
+
+        bool isDeferred() const { return !m_Desc.enableImmediateExecution; }
+        ID3D11CommandList* getD3DCommandList() const { return m_D3DCommandList; }
 
         // IResource implementation
 
@@ -296,7 +343,9 @@ namespace nvrhi::d3d11
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -305,10 +354,14 @@ namespace nvrhi::d3d11
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindings(const BindingSetVector& bindings) override;
+        void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -316,23 +369,44 @@ namespace nvrhi::d3d11
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) override;
+
+        void executeBundle(ICommandBundle* bundle) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const DispatchGraphArguments& args) override;
+
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
 
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) override { (void)pool; (void)firstQuery; (void)numQueries; }
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override { (void)pool; (void)queryIndex; }
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override { (void)pool; (void)queryIndex; }
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) override { (void)pool; (void)firstQuery; (void)numQueries; (void)buffer; (void)offsetBytes; }
+        void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) override { (void)buffer; (void)offsetBytes; (void)op; }
+
         // perf markers
         void beginMarker(const char* name) override;
         void endMarker() override;
+        void setGpuProfiler(IGpuProfiler* profiler) override { (void)profiler; }
+        void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) override { (void)buffer; (void)markerId; }
 
         void setEnableAutomaticBarriers(bool enable) override { (void)enable; }
         void setResourceStatesForBindingSet(IBindingSet* bindingSet) override { (void)bindingSet; }
@@ -351,20 +425,62 @@ namespace nvrhi::d3d11
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
 
         void commitBarriers() override { }
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override { (void)texture; (void)subresources; (void)stateBits; }
+        void endTextureStateTransition(ITexture* texture) override { (void)texture; }
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
+        void endBufferStateTransition(IBuffer* buffer) override { (void)buffer; }
+        void textureAliasingBarrier(ITexture* texture) override { (void)texture; }
+        void bufferAliasingBarrier(IBuffer* buffer) override { (void)buffer; }
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override { (void)texture; (void)arraySlice; (void)mipLevel; return ResourceStates::Common; }
         ResourceStates getBufferState(IBuffer* buffer) override { (void)buffer; return ResourceStates::Common; }
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_Desc; }
+        const CommandListStatistics& getStatistics() const override { return m_Statistics; }
 
     private:
         const Context& m_Context;
         IDevice* m_Device; // weak reference - to avoid a cyclic reference between Device and its ImmediateCommandList
         CommandListParameters m_Desc;
+        bool m_IsBundle;
 
+        CommandListStatistics m_Statistics;
+
+        RefCountPtr<ID3D11DeviceContext> m_D3DContext;
+        RefCountPtr<ID3D11DeviceContext1> m_D3DContext1;
+        RefCountPtr<ID3D11CommandList> m_D3DCommandList;
         RefCountPtr<ID3DUserDefinedAnnotation> m_UserDefinedAnnotation;
 
+        char m_PushConstantPaddingBuffer[c_MaxPushConstantSize] = {};
+
+        // CPU-writable buffers that were mapped with WRITE_DISCARD in the current deferred recording,
+        // which makes WRITE_NO_OVERWRITE legal for subsequent partial writes
+        std::vector<RefCountPtr<Buffer>> m_DiscardedBuffers;
+
+        // Writes to volatile constant buffers are appended to a dynamic ring buffer with WRITE_NO_OVERWRITE,
+        // and the buffers are bound at their last written location using the *SetConstantBuffers1 offsets.
+        // The ring is mapped with WRITE_DISCARD when it wraps around and on the first write in each recording,
+        // which lets the driver rename it instead of tracking the GPU progress here.
+        // A CPU copy of the ring contents is kept so that the live buffers can be moved into the new ring instance
+        // when it wraps; the ones that don't fit are written to their own resources.
+        static constexpr uint32_t c_VolatileConstantBufferRingSize = 1024 * 1024;
+        RefCountPtr<ID3D11Buffer> m_VolatileConstantBufferRing;
+        std::vector<char> m_VolatileConstantBufferShadow;
+        uint32_t m_VolatileConstantBufferRingOffset = 0;
+        PointerMap<Buffer, UINT> m_VolatileConstantBufferOffsets; // first 16-byte constant of the last write
+        static constexpr UINT c_VolatileConstantBufferInResource = ~0u; // the last write was moved to the buffer's own resource
+        std::vector<std::pair<UINT, Buffer*>> m_LiveVolatileConstantBuffers; // used locally in writeVolatileConstantBuffer
+        bool m_VolatileConstantBuffersDirty = false;
+
+        bool writeVolatileConstantBuffer(Buffer* buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes);
+        void moveLiveVolatileConstantBuffers(Buffer* writtenBuffer, uint32_t allocationSize, char* mappedRing);
+        void writeVolatileConstantBufferResource(Buffer* buffer, const void* data);
+        void bindVolatileConstantBuffers(const BindingSetVector& bindingSets, ShaderType stages);
+        // Rebind the volatile CBs written after the last set*State call, before a draw or dispatch uses them
+        void updateGraphicsVolatileBuffers();
+        void updateComputeVolatileBuffers();
+
         int m_NumUAVOverlapCommands = 0;
         void enterUAVOverlapSection();
         void leaveUAVOverlapSection();
@@ -390,10 +506,21 @@ namespace nvrhi::d3d11
         bool m_CurrentGraphicsStateValid = false;
         bool m_CurrentComputeStateValid = false;
 
+        // The framebuffer of the current logical render pass, whose attachment load ops have been applied,
+        // and whose store ops are applied when a different framebuffer is bound, or on clearState or close.
+        FramebufferHandle m_RenderPassFramebuffer;
+
+        void resetContextState();
+        void beginRenderPass(Framebuffer* framebuffer);
+        void endRenderPass();
+
         void copyTexture(ID3D11Resource* dst, const TextureDesc& dstDesc, const TextureSlice& dstSlice,
             ID3D11Resource* src, const TextureDesc& srcDesc, const TextureSlice& srcSlice);
         
         void bindGraphicsPipeline(const GraphicsPipeline* pso) const;
+        void bindVertexBuffers(const GraphicsPipeline* pipeline, const VertexBufferBindingVector& vertexBuffers);
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void setCurrentVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer);
 
         void prepareToBindGraphicsResourceSets(
             const BindingSetVector& resourceSets,
@@ -406,7 +533,33 @@ namespace nvrhi::d3d11
         void bindComputeResourceSets(const BindingSetVector& resourceSets, const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets) const;
     };
 
-    class Device : public RefCounter<IDevice>
+    class CommandBundle : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+        RefCountPtr<CommandList> commandList;
+
+        CommandBundle(const CommandBundleDesc& desc, RefCountPtr<CommandList> commandList)
+            : desc(desc)
+            , commandList(std::move(commandList))
+        { }
+
+        void open() override { commandList->open(); }
+        void close() override { commandList->close(); }
+
+        void setGraphicsState(const GraphicsState& state) override { commandList->setGraphicsState(state); }
+        void setPushConstants(const void* data, size_t byteSize) override { commandList->setPushConstants(data, byteSize); }
+
+        void draw(const DrawArguments& args) override { commandList->draw(args); }
+        void drawIndexed(const DrawArguments& args) override { commandList->drawIndexed(args); }
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndirect(offsetBytes, drawCount); }
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndexedIndirect(offsetBytes, drawCount); }
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override { return commandList->getNativeObject(objectType); }
+    };
+
+    class Device final : public RefCounter<IDevice>
     {
     public:
         explicit Device(const DeviceDesc& desc);
@@ -418,28 +571,44 @@ namespace nvrhi::d3d11
         // IDevice implementation
 
         HeapHandle createHeap(const HeapDesc& d) override;
+        TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) override;
+        StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) override;
+        ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) override;
+        BindingSetCacheHandle createBindingSetCache() override;
+        MipGeneratorHandle createMipGenerator() override;
 
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
         StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
         void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
         void unmapStagingTexture(IStagingTexture* tex) override;
+        void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         void unmapBuffer(IBuffer* b) override;
+        void *tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+
         BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
 
         ShaderHandle createShader(const ShaderDesc& d, const void* binary, const size_t binarySize) override;
         ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
         ShaderLibraryHandle createShaderLibrary(const void* binary, const size_t binarySize) override { (void)binary; (void)binarySize; return nullptr; }
+        // The shader objects are created from the binary right away, only vertex shaders keep a copy for createInputLayout
+        ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource*) override { return createShader(d, binary, binarySize); }
+        ShaderLibraryHandle createShaderLibraryNoCopy(const void*, size_t, IResource*) override { return nullptr; }
 
         SamplerHandle createSampler(const SamplerDesc& d) override;
 
@@ -457,6 +626,12 @@ namespace nvrhi::d3d11
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+        GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) override;
+        BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -470,10 +645,21 @@ namespace nvrhi::d3d11
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
 
+        WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) override;
+
+        PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override;
+        PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override;
+
+        bool loadPipelineCache(const void* data, size_t size) override { (void)data; (void)size; return false; }
+        bool savePipelineCache(std::vector<uint8_t>& outData) override { (void)outData; return false; }
+
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
 
         BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) override;
         DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
@@ -485,10 +671,19 @@ namespace nvrhi::d3d11
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
         
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
-        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override { (void)pCommandLists; (void)numCommandLists; (void)executionQueue; return 0; }
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { (void)waitQueue; (void)executionQueue; (void)instance; }
         void waitForIdle() override;
+        uint64_t getCompletedInstance(CommandQueue queue) override;
+        bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) override;
         void runGarbageCollection() override { }
+        bool runGarbageCollection(const GarbageCollectionBudget& budget) override { (void)budget; return true; }
+        void setUploadPoolSettings(const UploadPoolSettings& settings) override { (void)settings; }
+        UploadPoolStatistics getUploadPoolStatistics() override { return UploadPoolStatistics(); }
+        bool queryMemoryBudget(MemoryBudget& outBudget) override;
+        CommandListStatistics getCommandListStatistics(bool reset = true) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue;  return nullptr; }
@@ -496,8 +691,14 @@ namespace nvrhi::d3d11
 
     private:
         Context m_Context;
+
+        // Interned samplers, see createSampler.
+        // Declared early, so that it outlives the members that can hold samplers.
+        SamplerCache<Sampler> m_SamplerCache;
+
         EventQueryHandle m_WaitForIdleQuery;
         CommandListHandle m_ImmediateCommandList;
+        CommandListStatistics m_CommandListStatistics;
 
         std::unordered_map<size_t, RefCountPtr<ID3D11BlendState>> m_BlendStates;
         std::unordered_map<size_t, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
@@ -506,8 +707,16 @@ namespace nvrhi::d3d11
         bool m_SinglePassStereoSupported = false;
         bool m_FastGeometryShaderSupported = false;
 
+        // executeCommandLists returns 0 on DX11, so every submission counts as completed
+        SubmissionCallbackThread m_SubmissionCallbacks {
+            [](CompletedInstances& completed) { completed.fill(0); },
+            [](const SubmissionPoint*, size_t, uint64_t) { } };
+
         TextureHandle createTexture(const TextureDesc& d, CpuAccessMode cpuAccess) const;
 
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, bool wait);
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch, bool wait);
+
         ID3D11RenderTargetView* getRTVForAttachment(const FramebufferAttachment& attachment);
         ID3D11DepthStencilView* getDSVForAttachment(const FramebufferAttachment& attachment);
 
@@ -27,6 +27,7 @@
 #include <nvrhi/utils.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 namespace nvrhi::d3d11
 {
@@ -49,6 +50,12 @@ namespace nvrhi::d3d11
     {
         assert(d.byteSize <= UINT_MAX);
 
+        if (d.isTiled || d.isGpuAddressable)
+        {
+            utils::NotSupported();
+            return nullptr;
+        }
+
         D3D11_BUFFER_DESC desc11 = {};
         desc11.ByteWidth = (UINT)d.byteSize;
 
@@ -137,28 +144,192 @@ namespace nvrhi::d3d11
         if (!d.debugName.empty())
             SetDebugName(newBuffer, d.debugName.c_str());
 
+        if (d.residencyPriority != ResidencyPriority::Normal)
+            newBuffer->SetEvictionPriority(convertResidencyPriority(d.residencyPriority));
+
         Buffer* buffer = new Buffer(m_Context);
         buffer->desc = d;
+        buffer->desc.preferDeviceLocal = false; // DX11 has no control over the upload memory placement
         buffer->resource = newBuffer;
         buffer->sharedHandle = sharedHandle;
         return BufferHandle::Create(buffer);
     }
 
+    bool CommandList::writeVolatileConstantBuffer(Buffer* buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        const uint32_t allocationSize = align(uint32_t(buffer->desc.byteSize), c_ConstantBufferOffsetSizeAlignment);
+
+        if (!m_Context.constantBufferRing || !m_D3DContext1 || allocationSize > c_VolatileConstantBufferRingSize)
+            return false;
+
+        if (!m_VolatileConstantBufferRing)
+        {
+            D3D11_BUFFER_DESC desc11 = {};
+            desc11.ByteWidth = c_VolatileConstantBufferRingSize;
+            desc11.Usage = D3D11_USAGE_DYNAMIC;
+            desc11.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+            desc11.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+            const HRESULT res = m_Context.device->CreateBuffer(&desc11, nullptr, &m_VolatileConstantBufferRing);
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "CreateBuffer call failed for the volatile constant buffer ring, HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+                return false;
+            }
+
+            SetDebugName(m_VolatileConstantBufferRing, "VolatileConstantBufferRing");
+            m_VolatileConstantBufferShadow.resize(c_VolatileConstantBufferRingSize);
+        }
+
+        const bool wrap = m_VolatileConstantBufferRingOffset + allocationSize > c_VolatileConstantBufferRingSize;
+        const D3D11_MAP mapType = wrap ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+        D3D11_MAPPED_SUBRESOURCE mappedData;
+        const HRESULT res = m_D3DContext->Map(m_VolatileConstantBufferRing, 0, mapType, 0, &mappedData);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "Map call failed for the volatile constant buffer ring, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        if (wrap)
+            moveLiveVolatileConstantBuffers(buffer, allocationSize, static_cast<char*>(mappedData.pData));
+
+        // Like on the other APIs, the contents of a volatile buffer outside of the written range are undefined
+        const size_t writeOffset = m_VolatileConstantBufferRingOffset + destOffsetBytes;
+        memcpy(static_cast<char*>(mappedData.pData) + writeOffset, data, dataSize);
+        memcpy(m_VolatileConstantBufferShadow.data() + writeOffset, data, dataSize);
+        m_D3DContext->Unmap(m_VolatileConstantBufferRing, 0);
+
+        m_VolatileConstantBufferOffsets[buffer] = m_VolatileConstantBufferRingOffset / 16;
+        m_VolatileConstantBufferRingOffset += allocationSize;
+        m_VolatileConstantBuffersDirty = true;
+
+        return true;
+    }
+
+    void CommandList::moveLiveVolatileConstantBuffers(Buffer* writtenBuffer, uint32_t allocationSize, char* mappedRing)
+    {
+        // The discarded ring instance may still be used by earlier draws, but the buffers that were written before
+        // must stay valid for later draws too. Copy them to the start of the new instance, in the order of their
+        // offsets, so that the copies within the shadow never overwrite data that is yet to be moved.
+        m_LiveVolatileConstantBuffers.clear();
+        m_VolatileConstantBufferOffsets.forEach([this, writtenBuffer](Buffer* liveBuffer, UINT& firstConstant)
+        {
+            // The written buffer gets new contents, the previous ones are not needed
+            if (liveBuffer != writtenBuffer && firstConstant != c_VolatileConstantBufferInResource)
+                m_LiveVolatileConstantBuffers.push_back(std::make_pair(firstConstant, liveBuffer));
+        });
+        std::sort(m_LiveVolatileConstantBuffers.begin(), m_LiveVolatileConstantBuffers.end());
+
+        char* shadow = m_VolatileConstantBufferShadow.data();
+        uint32_t ringOffset = 0;
+
+        for (const auto& [firstConstant, liveBuffer] : m_LiveVolatileConstantBuffers)
+        {
+            const uint32_t liveSize = align(uint32_t(liveBuffer->desc.byteSize), c_ConstantBufferOffsetSizeAlignment);
+            const char* liveData = shadow + size_t(firstConstant) * 16;
+            UINT& entry = *m_VolatileConstantBufferOffsets.find(liveBuffer);
+
+            if (ringOffset + liveSize + allocationSize <= c_VolatileConstantBufferRingSize)
+            {
+                memmove(shadow + ringOffset, liveData, liveSize);
+                memcpy(mappedRing + ringOffset, shadow + ringOffset, liveSize);
+                entry = ringOffset / 16;
+                ringOffset += liveSize;
+            }
+            else
+            {
+                writeVolatileConstantBufferResource(liveBuffer, liveData);
+                entry = c_VolatileConstantBufferInResource;
+            }
+        }
+
+        m_VolatileConstantBufferRingOffset = ringOffset;
+
+        // The moved buffers must be rebound at their new offsets
+        if (!m_LiveVolatileConstantBuffers.empty())
+            m_VolatileConstantBuffersDirty = true;
+    }
+
+    void CommandList::writeVolatileConstantBufferResource(Buffer* buffer, const void* data)
+    {
+        // A full write, which deferred contexts allow with WRITE_DISCARD
+        if (buffer->desc.cpuAccess == CpuAccessMode::Write)
+        {
+            D3D11_MAPPED_SUBRESOURCE mappedData;
+            const HRESULT res = m_D3DContext->Map(buffer->resource, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "Map call failed for buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                    << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+                return;
+            }
+
+            memcpy(mappedData.pData, data, buffer->desc.byteSize);
+            m_D3DContext->Unmap(buffer->resource, 0);
+        }
+        else
+        {
+            m_D3DContext->UpdateSubresource(buffer->resource, 0, nullptr, data, UINT(buffer->desc.byteSize), 0);
+        }
+    }
+
     void CommandList::writeBuffer(IBuffer* _buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
         assert(destOffsetBytes + dataSize <= UINT_MAX);
 
+        if (buffer->desc.isVolatile && buffer->desc.isConstantBuffer && writeVolatileConstantBuffer(buffer, data, dataSize, destOffsetBytes))
+            return;
+
         if (buffer->desc.cpuAccess == CpuAccessMode::Write)
         {
             // we can map if it it's D3D11_USAGE_DYNAMIC, but not UpdateSubresource
             D3D11_MAPPED_SUBRESOURCE mappedData;
             D3D11_MAP mapType = D3D11_MAP_WRITE_DISCARD;
             if (destOffsetBytes > 0 || dataSize + destOffsetBytes < buffer->desc.byteSize)
-                mapType = D3D11_MAP_WRITE;
+            {
+                if (isDeferred())
+                {
+                    // Deferred contexts only allow WRITE_DISCARD and WRITE_NO_OVERWRITE. The first write in a recording
+                    // has to discard, leaving the rest of the buffer undefined - the same contract as volatile buffers
+                    // on the other APIs. Writes after that can use NO_OVERWRITE to preserve the discarded contents.
+                    if (std::find(m_DiscardedBuffers.begin(), m_DiscardedBuffers.end(), buffer) != m_DiscardedBuffers.end())
+                    {
+                        mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+                    }
+                    else if (!buffer->desc.isVolatile)
+                    {
+                        // Discarding would silently destroy the rest of a buffer that is expected to keep its contents
+                        std::stringstream ss;
+                        ss << "Partial write to the non-volatile CPU-writable buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                            << " in a deferred command list. The first write to such a buffer in a deferred recording "
+                            "must cover the whole buffer; use a volatile buffer or the immediate command list for partial writes.";
+                        m_Context.error(ss.str());
+                        return;
+                    }
+                }
+                else
+                {
+                    mapType = D3D11_MAP_WRITE;
+                }
+            }
+
+            if (isDeferred() && mapType == D3D11_MAP_WRITE_DISCARD)
+            {
+                if (std::find(m_DiscardedBuffers.begin(), m_DiscardedBuffers.end(), buffer) == m_DiscardedBuffers.end())
+                    m_DiscardedBuffers.push_back(buffer);
+            }
 
-            const HRESULT res = m_Context.immediateContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
+            const HRESULT res = m_D3DContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
             if (FAILED(res))
             {
                 std::stringstream ss;
@@ -169,14 +340,22 @@ namespace nvrhi::d3d11
             }
 
             memcpy((char*)mappedData.pData + destOffsetBytes, data, dataSize);
-            m_Context.immediateContext->Unmap(buffer->resource, 0);
+            m_D3DContext->Unmap(buffer->resource, 0);
         }
         else
         {
             D3D11_BOX box = { UINT(destOffsetBytes), 0, 0, UINT(destOffsetBytes + dataSize), 1, 1 };
             bool useBox = destOffsetBytes > 0 || dataSize < buffer->desc.byteSize;
 
-            m_Context.immediateContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, data, (UINT)dataSize, 0);
+            const void* srcData = data;
+            if (useBox && isDeferred() && !m_Context.driverCommandLists)
+            {
+                // When the driver does not support command lists, the runtime emulation applies the destination box
+                // offset to the source pointer, see the remarks for ID3D11DeviceContext::UpdateSubresource.
+                srcData = static_cast<const char*>(data) - destOffsetBytes;
+            }
+
+            m_D3DContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, srcData, (UINT)dataSize, 0);
         }
     }
 
@@ -191,7 +370,7 @@ namespace nvrhi::d3d11
         ID3D11UnorderedAccessView* uav = checked_cast<Buffer*>(buffer)->getUAV(Format::UNKNOWN, EntireBuffer, viewType);
 
         UINT clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
-        m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+        m_D3DContext->ClearUnorderedAccessViewUint(uav, clearValues);
     }
 
     void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
@@ -210,10 +389,20 @@ namespace nvrhi::d3d11
         srcBox.top = 0;
         srcBox.front = 0;
         srcBox.back = 1;
-        m_Context.immediateContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
+        m_D3DContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
     }
     
-    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags)
+    void *Device::mapBuffer(IBuffer* buffer, CpuAccessMode flags)
+    {
+        return mapBuffer(buffer, flags, true);
+    }
+
+    void *Device::tryMapBuffer(IBuffer* buffer, CpuAccessMode flags)
+    {
+        return mapBuffer(buffer, flags, false);
+    }
+
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, bool wait)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
@@ -235,8 +424,11 @@ namespace nvrhi::d3d11
                 return nullptr;
         }
 
+        // DO_NOT_WAIT is not allowed with WRITE_DISCARD, which doesn't wait anyway
+        const UINT mapFlags = (!wait && mapType == D3D11_MAP_READ) ? D3D11_MAP_FLAG_DO_NOT_WAIT : 0;
+
         D3D11_MAPPED_SUBRESOURCE res;
-        if (SUCCEEDED(m_Context.immediateContext->Map(buffer->resource, 0, mapType, 0, &res)))
+        if (SUCCEEDED(m_Context.immediateContext->Map(buffer->resource, 0, mapType, mapFlags, &res)))
         {
             return res.pData;
         } else {
@@ -263,6 +455,11 @@ namespace nvrhi::d3d11
         return false;
     }
 
+    void Device::updateBufferTileMappings(IBuffer*, const BufferTilesMapping*, uint32_t, CommandQueue)
+    {
+        utils::NotSupported();
+    }
+
     BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object _buffer, const BufferDesc& desc)
     {
         if (!_buffer.pointer)
@@ -288,6 +485,8 @@ namespace nvrhi::d3d11
 
         range = range.resolve(desc);
 
+        std::lock_guard lockGuard(m_ViewCacheMutex);
+
         RefCountPtr<ID3D11ShaderResourceView>& srv = m_ShaderResourceViews[BufferBindingKey(range, format, type)];
         if (srv)
             return srv;
@@ -351,6 +550,8 @@ namespace nvrhi::d3d11
 
         range = range.resolve(desc);
 
+        std::lock_guard lockGuard(m_ViewCacheMutex);
+
         RefCountPtr<ID3D11UnorderedAccessView>& uav = m_UnorderedAccessViews[BufferBindingKey(range, format, type)];
         if (uav)
             return uav;
@@ -22,15 +22,20 @@
 
 #include "d3d11-backend.h"
 #include <nvrhi/utils.h>
+#include <sstream>
+#include <iomanip>
 
 namespace nvrhi::d3d11
 {
-    CommandList::CommandList(const Context& context, IDevice* device, const CommandListParameters& params)
+    CommandList::CommandList(const Context& context, IDevice* device, ID3D11DeviceContext* d3dContext, const CommandListParameters& params, bool isBundle)
         : m_Context(context)
         , m_Device(device)
         , m_Desc(params)
+        , m_IsBundle(isBundle)
+        , m_D3DContext(d3dContext)
     {
-        m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
+        m_D3DContext->QueryInterface(IID_PPV_ARGS(&m_D3DContext1));
+        m_D3DContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
     }
 
     Object CommandList::getNativeObject(ObjectType objectType)
@@ -38,7 +43,7 @@ namespace nvrhi::d3d11
         switch (objectType)
         {
         case ObjectTypes::D3D11_DeviceContext:
-            return Object(m_Context.immediateContext);
+            return Object(m_D3DContext);
         default:
             return nullptr;
         }
@@ -46,6 +51,14 @@ namespace nvrhi::d3d11
 
     void CommandList::open()
     {
+        m_D3DCommandList = nullptr;
+        m_DiscardedBuffers.clear();
+        m_VolatileConstantBufferOffsets.clear();
+        m_VolatileConstantBuffersDirty = false;
+        // Forces a WRITE_DISCARD on the first write, which deferred contexts require
+        m_VolatileConstantBufferRingOffset = c_VolatileConstantBufferRingSize;
+        m_Statistics = CommandListStatistics();
+
         clearState();
     }
 
@@ -55,16 +68,35 @@ namespace nvrhi::d3d11
             leaveUAVOverlapSection();
 
         clearState();
+
+        if (isDeferred())
+        {
+            const HRESULT res = m_D3DContext->FinishCommandList(FALSE, &m_D3DCommandList);
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "FinishCommandList call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+            }
+
+            m_DiscardedBuffers.clear();
+        }
     }
 
     void CommandList::clearState()
     {
-        m_Context.immediateContext->ClearState();
+        endRenderPass();
+        resetContextState();
+    }
+
+    void CommandList::resetContextState()
+    {
+        m_D3DContext->ClearState();
 
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_CurrentGraphicsStateValid && m_CurrentSinglePassStereoState.enabled)
         {
-            NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, 1, 0, 0);
+            NvAPI_D3D_SetSinglePassStereoMode(m_D3DContext, 1, 0, 0);
         }
 #endif
 
@@ -106,7 +138,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 0)
-            NvAPI_D3D11_BeginUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_BeginUAVOverlap(m_D3DContext);
 #endif
 
         m_NumUAVOverlapCommands += 1;
@@ -116,7 +148,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 1)
-            NvAPI_D3D11_EndUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_EndUAVOverlap(m_D3DContext);
 #endif
 
         m_NumUAVOverlapCommands = std::max(0, m_NumUAVOverlapCommands - 1);
@@ -141,18 +173,18 @@ namespace nvrhi::d3d11
         }
     }
     
-    static char g_PushConstantPaddingBuffer[c_MaxPushConstantSize] = {};
-
     void CommandList::setPushConstants(const void* data, size_t byteSize)
     {
         if (byteSize > c_MaxPushConstantSize)
             return;
 
-        memcpy(g_PushConstantPaddingBuffer, data, byteSize);
+        memcpy(m_PushConstantPaddingBuffer, data, byteSize);
 
-        m_Context.immediateContext->UpdateSubresource(
+        // The push constant buffer is shared by all command lists, which is fine because
+        // deferred contexts capture the data at UpdateSubresource time and execution is serialized.
+        m_D3DContext->UpdateSubresource(
             m_Context.pushConstantBuffer, 0, nullptr, 
-            g_PushConstantPaddingBuffer, 0, 0);
+            m_PushConstantPaddingBuffer, 0, 0);
     }
 
     void CommandList::setMeshletState(const MeshletState&)
@@ -165,6 +197,21 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::dispatchMeshIndirect(uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t, IBuffer*, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::executeIndirect(ICommandSignature*, IBuffer*, uint32_t, uint32_t, IBuffer*, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::setRayTracingState(const rt::State&)
     {
         utils::NotSupported();
@@ -175,6 +222,16 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::setWorkGraphState(const WorkGraphState&)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchGraph(const DispatchGraphArguments&)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* , const rt::OpacityMicromapDesc& )
     {
         utils::NotSupported();
@@ -190,6 +247,11 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct*, const rt::InstanceDesc*, size_t, rt::AccelStructBuildFlags)
     {
         utils::NotSupported();
@@ -199,4 +261,9 @@ namespace nvrhi::d3d11
     {
         utils::NotSupported();
     }
+
+    void CommandList::buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct*, const rt::InstanceDesc*, size_t, const rt::InstanceRange*, size_t, rt::AccelStructBuildFlags)
+    {
+        utils::NotSupported();
+    }
 } // namespace nvrhi::d3d11
@@ -46,15 +46,28 @@ namespace nvrhi::d3d11
             // If the previous operation has been a Draw call, there is a possibility of RT/UAV/SRV hazards.
             // Unbind everything to be sure, and to avoid checking the binding sets against each other. 
             // This only happens on switches between compute and graphics modes.
+            // The render pass stays open, so that returning to the same framebuffer doesn't apply the load ops again.
 
-            clearState();
+            resetContextState();
         }
 
         bool updatePipeline = !m_CurrentComputeStateValid || pso != m_CurrentComputePipeline;
         bool updateBindings = updatePipeline || arraysAreDifferent(m_CurrentBindings, state.bindings);
 
-        if (updatePipeline) m_Context.immediateContext->CSSetShader(pso->shader, nullptr, 0);
-        if (updateBindings) bindComputeResourceSets(state.bindings, m_CurrentComputeStateValid ? &m_CurrentBindings : nullptr);
+        if (updatePipeline)
+        {
+            m_D3DContext->CSSetShader(pso->shader, nullptr, 0);
+            m_Statistics.pipelineBinds++;
+        }
+        if (updateBindings)
+        {
+            bindComputeResourceSets(state.bindings, m_CurrentComputeStateValid ? &m_CurrentBindings : nullptr);
+            m_Statistics.bindingSetBinds += uint32_t(state.bindings.size());
+        }
+        if (updateBindings || m_VolatileConstantBuffersDirty)
+        {
+            bindVolatileConstantBuffers(state.bindings, ShaderType::Compute);
+        }
 
         m_CurrentIndirectBuffer = state.indirectParams;
 
@@ -72,9 +85,24 @@ namespace nvrhi::d3d11
         }
     }
 
+    void CommandList::updateComputeVolatileBuffers()
+    {
+        if (!m_VolatileConstantBuffersDirty || !m_CurrentComputeStateValid)
+            return;
+
+        BindingSetVector bindings;
+        for (const BindingSetHandle& bindingSet : m_CurrentBindings)
+            bindings.push_back(bindingSet);
+
+        bindVolatileConstantBuffers(bindings, ShaderType::Compute);
+    }
+
     void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
-        m_Context.immediateContext->Dispatch(groupsX, groupsY, groupsZ);
+        updateComputeVolatileBuffers();
+
+        m_D3DContext->Dispatch(groupsX, groupsY, groupsZ);
+        m_Statistics.dispatchCalls++;
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
@@ -83,7 +111,10 @@ namespace nvrhi::d3d11
         
         if (indirectParams) // validation layer will issue an error otherwise
         {
-            m_Context.immediateContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
+            updateComputeVolatileBuffers();
+
+            m_D3DContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
+            m_Statistics.dispatchCalls++;
         }
     }
 
@@ -217,5 +217,25 @@ namespace nvrhi::d3d11
         }
     }
 
+    UINT convertResidencyPriority(ResidencyPriority priority)
+    {
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum:
+            return DXGI_RESOURCE_PRIORITY_MINIMUM;
+        case ResidencyPriority::Low:
+            return DXGI_RESOURCE_PRIORITY_LOW;
+        case ResidencyPriority::Normal:
+            return DXGI_RESOURCE_PRIORITY_NORMAL;
+        case ResidencyPriority::High:
+            return DXGI_RESOURCE_PRIORITY_HIGH;
+        case ResidencyPriority::Maximum:
+            return DXGI_RESOURCE_PRIORITY_MAXIMUM;
+        default:
+            utils::InvalidEnum();
+            return DXGI_RESOURCE_PRIORITY_NORMAL;
+        }
+    }
+
 
 } // namespace nvrhi::d3d11
@@ -21,6 +21,10 @@
 */
 
 #include "d3d11-backend.h"
+#include "../common/pipeline-creation-task.h"
+#include "../common/readback-ring.h"
+#include "../common/binding-set-cache.h"
+#include "../common/streaming-uploader.h"
 
 #include <nvrhi/utils.h>
 #include <sstream>
@@ -51,6 +55,30 @@ namespace nvrhi::d3d11
         m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_Context.immediateContext1));
         desc.context->GetDevice(&m_Context.device);
 
+        D3D11_FEATURE_DATA_THREADING threadingFeatures = {};
+        if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threadingFeatures, sizeof(threadingFeatures))))
+        {
+            m_Context.driverCommandLists = threadingFeatures.DriverCommandLists != FALSE;
+        }
+
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+        if (m_Context.immediateContext1 &&
+            SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+        {
+            m_Context.constantBufferRing = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+        }
+
+        {
+            // The budget query needs DXGI 1.4, which is not available on Windows 8.1 and older
+            RefCountPtr<IDXGIDevice> dxgiDevice;
+            RefCountPtr<IDXGIAdapter> dxgiAdapter;
+            if (SUCCEEDED(m_Context.device->QueryInterface(IID_PPV_ARGS(&dxgiDevice))) &&
+                SUCCEEDED(dxgiDevice->GetAdapter(&dxgiAdapter)))
+            {
+                dxgiAdapter->QueryInterface(IID_PPV_ARGS(&m_Context.adapter));
+            }
+        }
+
 #if NVRHI_D3D11_WITH_NVAPI
         m_Context.nvapiAvailable = NvAPI_Initialize() == NVAPI_OK;
 
@@ -88,7 +116,7 @@ namespace nvrhi::d3d11
             m_Context.error(ss.str());
         }
 
-        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, CommandListParameters()));   
+        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, m_Context.immediateContext, CommandListParameters()));   
     }
 
     GraphicsAPI Device::getGraphicsAPI()
@@ -117,21 +145,130 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    TransientResourcePoolHandle Device::createTransientResourcePool(const TransientResourcePoolDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    StreamingUploaderHandle Device::createStreamingUploader(const StreamingUploaderDesc& desc)
+    {
+        return StreamingUploaderHandle::Create(new StreamingUploader(this, desc));
+    }
+
+    ReadbackRingHandle Device::createReadbackRing(const ReadbackRingDesc& desc)
+    {
+        return ReadbackRing::create(this, desc);
+    }
+
+    BindingSetCacheHandle Device::createBindingSetCache()
+    {
+        return BindingSetCacheHandle::Create(new BindingSetCache(this));
+    }
+
+    MipGeneratorHandle Device::createMipGenerator()
+    {
+        // The mip generation shader is only compiled to DXIL and SPIR-V
+        utils::NotSupported();
+        return nullptr;
+    }
+
     CommandListHandle Device::createCommandList(const CommandListParameters& params)
     {
-        if (!params.enableImmediateExecution)
+        if (params.queueType != CommandQueue::Graphics)
         {
-            m_Context.error("Deferred command lists are not supported by the D3D11 backend.");
+            m_Context.error("Non-graphics queues are not supported by the D3D11 backend.");
             return nullptr;
         }
+        
+        if (params.enableImmediateExecution)
+            return m_ImmediateCommandList;
 
-        if (params.queueType != CommandQueue::Graphics)
+        RefCountPtr<ID3D11DeviceContext> deferredContext;
+        const HRESULT res = m_Context.device->CreateDeferredContext(0, &deferredContext);
+        if (FAILED(res))
         {
-            m_Context.error("Non-graphics queues are not supported by the D3D11 backend.");
+            std::stringstream ss;
+            ss << "CreateDeferredContext call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
             return nullptr;
         }
-        
-        return m_ImmediateCommandList;
+
+        return CommandListHandle::Create(new CommandList(m_Context, this, deferredContext, params));
+    }
+
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (!desc.framebuffer)
+        {
+            m_Context.error("Cannot create a command bundle without a framebuffer");
+            return nullptr;
+        }
+
+        // Bundles are recorded into a deferred context like deferred command lists
+        RefCountPtr<ID3D11DeviceContext> deferredContext;
+        const HRESULT res = m_Context.device->CreateDeferredContext(0, &deferredContext);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateDeferredContext call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        const CommandListParameters params = CommandListParameters()
+            .setEnableImmediateExecution(false);
+
+        RefCountPtr<CommandList> commandList = RefCountPtr<CommandList>::Create(new CommandList(m_Context, this, deferredContext, params, true));
+
+        return CommandBundleHandle::Create(new CommandBundle(desc, commandList));
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        (void)executionQueue;
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            m_CommandListStatistics += commandList->getStatistics();
+
+            // Immediate command lists have already been executed while they were recorded
+            ID3D11CommandList* d3dCommandList = commandList->getD3DCommandList();
+            if (d3dCommandList)
+                m_Context.immediateContext->ExecuteCommandList(d3dCommandList, FALSE);
+        }
+
+        return 0;
+    }
+
+    bool Device::queryMemoryBudget(MemoryBudget& outBudget)
+    {
+        if (!m_Context.adapter)
+            return false;
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO localInfo{};
+        DXGI_QUERY_VIDEO_MEMORY_INFO nonLocalInfo{};
+
+        if (FAILED(m_Context.adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &localInfo)) ||
+            FAILED(m_Context.adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocalInfo)))
+            return false;
+
+        outBudget = MemoryBudget();
+        outBudget.localBudget = localInfo.Budget;
+        outBudget.localUsage = localInfo.CurrentUsage;
+        outBudget.nonLocalBudget = nonLocalInfo.Budget;
+        outBudget.nonLocalUsage = nonLocalInfo.CurrentUsage;
+
+        return true;
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(bool reset)
+    {
+        CommandListStatistics statistics = m_CommandListStatistics;
+        if (reset)
+            m_CommandListStatistics = CommandListStatistics();
+        return statistics;
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -142,7 +279,7 @@ namespace nvrhi::d3d11
         switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
         {
         case Feature::DeferredCommandLists:
-            return false;
+            return true;
         case Feature::SinglePassStereo:
             return m_SinglePassStereoSupported;
         case Feature::FastGeometryShader:
@@ -215,6 +352,34 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    WorkGraphHandle Device::createWorkGraph(const WorkGraphDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    // D3D11 compiles the shaders at creation time and the remaining state objects are cheap, so create the pipelines immediately
+
+    PipelineCreationTaskHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return PipelineCreationTask::createCompleted(createGraphicsPipeline(desc, fb));
+    }
+
+    PipelineCreationTaskHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc)
+    {
+        return PipelineCreationTask::createCompleted(createComputePipeline(desc));
+    }
+
+    PipelineCreationTaskHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return PipelineCreationTask::createCompleted(createMeshletPipeline(desc, fb));
+    }
+
+    PipelineCreationTaskHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc)
+    {
+        return PipelineCreationTask::createCompleted(createRayTracingPipeline(desc));
+    }
+
     rt::OpacityMicromapHandle Device::createOpacityMicromap(const rt::OpacityMicromapDesc& )
     {
         utils::NotSupported();
@@ -243,6 +408,35 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    uint64_t Device::getCompletedInstance(CommandQueue queue)
+    {
+        (void)queue;
+        return 0;
+    }
+
+    bool Device::waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        (void)timeout;
+
+        CompletedInstances completed;
+        completed.fill(0);
+        return allSubmissionsCompleted(submissions, count, completed);
+    }
+
+    size_t Device::waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        (void)timeout;
+
+        CompletedInstances completed;
+        completed.fill(0);
+        return findCompletedSubmission(submissions, count, completed);
+    }
+
+    void Device::notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        m_SubmissionCallbacks.add(submissions, count, waitAny, std::move(callback));
+    }
+
     void Device::waitForIdle()
     {
         if (!m_WaitForIdleQuery)
@@ -260,6 +454,9 @@ namespace nvrhi::d3d11
 
     SamplerHandle Device::createSampler(const SamplerDesc& d)
     {
+        if (SamplerHandle cachedSampler = m_SamplerCache.find(d))
+            return cachedSampler;
+
         D3D11_SAMPLER_DESC desc11;
 
         UINT reductionType = convertSamplerReductionType(d.reductionType);
@@ -301,10 +498,12 @@ namespace nvrhi::d3d11
             return nullptr;
         }
 
-        Sampler* sampler = new Sampler();
+        Sampler* sampler = new Sampler(m_SamplerCache);
         sampler->sampler = sState;
         sampler->desc = d;
-        return SamplerHandle::Create(sampler);
+
+        // Another thread could have created the same sampler in the meantime, then the cache returns that one
+        return m_SamplerCache.add(sampler);
     }
 
 } // namespace nvrhi::d3d11
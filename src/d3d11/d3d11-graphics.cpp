@@ -35,11 +35,15 @@ namespace nvrhi::d3d11
         Framebuffer *ret = new Framebuffer();
         ret->desc = desc;
         ret->framebufferInfo = FramebufferInfoEx(desc);
+        ret->framebufferInfoHash = std::hash<FramebufferInfo>()(ret->framebufferInfo);
         
         for(auto colorAttachment : desc.colorAttachments)
         {
             assert(colorAttachment.valid());
             ret->RTVs.push_back(getRTVForAttachment(colorAttachment));
+
+            if (colorAttachment.storeOp == AttachmentStoreOp::Resolve && colorAttachment.resolveTexture)
+                ret->resolveTextures.push_back(colorAttachment.resolveTexture);
         }
 
         if (desc.depthAttachment.valid())
@@ -63,6 +67,7 @@ namespace nvrhi::d3d11
         GraphicsPipeline *pso = new GraphicsPipeline();
         pso->desc = desc;
         pso->framebufferInfo = fb->getFramebufferInfo();
+        pso->framebufferInfoHash = fb->getFramebufferInfoHash();
 
         pso->primitiveTopology = convertPrimType(desc.primType, desc.patchControlPoints);
         pso->inputLayout = checked_cast<InputLayout*>(desc.inputLayout.Get());
@@ -106,16 +111,16 @@ namespace nvrhi::d3d11
 
     void CommandList::bindGraphicsPipeline(const GraphicsPipeline* pso) const
     {
-        m_Context.immediateContext->IASetPrimitiveTopology(pso->primitiveTopology);
-        m_Context.immediateContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
+        m_D3DContext->IASetPrimitiveTopology(pso->primitiveTopology);
+        m_D3DContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
 
-        m_Context.immediateContext->RSSetState(pso->pRS);
+        m_D3DContext->RSSetState(pso->pRS);
 
-        m_Context.immediateContext->VSSetShader(pso->pVS, nullptr, 0);
-        m_Context.immediateContext->HSSetShader(pso->pHS, nullptr, 0);
-        m_Context.immediateContext->DSSetShader(pso->pDS, nullptr, 0);
-        m_Context.immediateContext->GSSetShader(pso->pGS, nullptr, 0);
-        m_Context.immediateContext->PSSetShader(pso->pPS, nullptr, 0);
+        m_D3DContext->VSSetShader(pso->pVS, nullptr, 0);
+        m_D3DContext->HSSetShader(pso->pHS, nullptr, 0);
+        m_D3DContext->DSSetShader(pso->pDS, nullptr, 0);
+        m_D3DContext->GSSetShader(pso->pGS, nullptr, 0);
+        m_D3DContext->PSSetShader(pso->pPS, nullptr, 0);
     }
 
     static DX11_ViewportState convertViewportState(const ViewportState& vpState)
@@ -145,6 +150,108 @@ namespace nvrhi::d3d11
         return ret;
     }
 
+    void CommandList::beginRenderPass(Framebuffer* framebuffer)
+    {
+        // D3D11 has no render passes, so emulate the attachment load ops with clears and discards
+        m_RenderPassFramebuffer = framebuffer;
+
+        // The load and store ops of a bundle are applied by the command list that executes it
+        if (m_IsBundle)
+            return;
+
+        const FramebufferDesc& desc = framebuffer->desc;
+
+        for (size_t i = 0; i < desc.colorAttachments.size(); i++)
+        {
+            const FramebufferAttachment& attachment = desc.colorAttachments[i];
+
+            if (attachment.loadOp == AttachmentLoadOp::Clear)
+                m_D3DContext->ClearRenderTargetView(framebuffer->RTVs[i], &attachment.clearColor.r);
+            else if (attachment.loadOp == AttachmentLoadOp::DontCare && m_D3DContext1)
+                m_D3DContext1->DiscardView(framebuffer->RTVs[i]);
+        }
+
+        const FramebufferAttachment& depth = desc.depthAttachment;
+        if (depth.valid() && !depth.isReadOnly)
+        {
+            if (depth.loadOp == AttachmentLoadOp::Clear)
+            {
+                UINT clearFlags = D3D11_CLEAR_DEPTH;
+                if (getFormatInfo(depth.texture->getDesc().format).hasStencil)
+                    clearFlags |= D3D11_CLEAR_STENCIL;
+
+                m_D3DContext->ClearDepthStencilView(framebuffer->DSV, clearFlags, depth.clearDepth, depth.clearStencil);
+            }
+            else if (depth.loadOp == AttachmentLoadOp::DontCare && m_D3DContext1)
+                m_D3DContext1->DiscardView(framebuffer->DSV);
+        }
+    }
+
+    void CommandList::endRenderPass()
+    {
+        if (!m_RenderPassFramebuffer)
+            return;
+
+        if (m_IsBundle)
+        {
+            m_RenderPassFramebuffer = nullptr;
+            return;
+        }
+
+        // Emulate the attachment store ops with resolves and discards
+        const Framebuffer* framebuffer = checked_cast<Framebuffer*>(m_RenderPassFramebuffer.Get());
+        const FramebufferDesc& desc = framebuffer->desc;
+
+        for (size_t i = 0; i < desc.colorAttachments.size(); i++)
+        {
+            const FramebufferAttachment& attachment = desc.colorAttachments[i];
+
+            if (attachment.storeOp == AttachmentStoreOp::Resolve && attachment.resolveTexture)
+            {
+                // The validation layer makes sure that resolved attachments use a single mip level and array slice
+                const Texture* src = checked_cast<Texture*>(attachment.texture);
+                const Texture* dest = checked_cast<Texture*>(attachment.resolveTexture);
+                const TextureSubresourceSet srcSR = attachment.subresources.resolve(src->desc, true);
+                const TextureSubresourceSet dstSR = attachment.resolveSubresources.resolve(dest->desc, true);
+                const Format format = attachment.format == Format::UNKNOWN ? src->desc.format : attachment.format;
+
+                m_D3DContext->ResolveSubresource(
+                    dest->resource, D3D11CalcSubresource(dstSR.baseMipLevel, dstSR.baseArraySlice, dest->desc.mipLevels),
+                    src->resource, D3D11CalcSubresource(srcSR.baseMipLevel, srcSR.baseArraySlice, src->desc.mipLevels),
+                    getDxgiFormatMapping(format).rtvFormat);
+            }
+
+            if (attachment.storeOp != AttachmentStoreOp::Store && m_D3DContext1)
+                m_D3DContext1->DiscardView(framebuffer->RTVs[i]);
+        }
+
+        const FramebufferAttachment& depth = desc.depthAttachment;
+        if (depth.valid() && !depth.isReadOnly && depth.storeOp != AttachmentStoreOp::Store && m_D3DContext1)
+            m_D3DContext1->DiscardView(framebuffer->DSV);
+
+        m_RenderPassFramebuffer = nullptr;
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(bundle->desc.framebuffer.Get());
+
+        if (m_RenderPassFramebuffer != framebuffer)
+        {
+            endRenderPass();
+            beginRenderPass(framebuffer);
+        }
+
+        ID3D11CommandList* d3dCommandList = bundle->commandList->getD3DCommandList();
+        if (d3dCommandList)
+            m_D3DContext->ExecuteCommandList(d3dCommandList, FALSE);
+
+        // Executing a command list resets the context to its default state.
+        // The render pass stays active, so that its store ops are applied when a different framebuffer is bound.
+        resetContextState();
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
         GraphicsPipeline* pipeline = checked_cast<GraphicsPipeline*>(state.pipeline);
@@ -156,10 +263,16 @@ namespace nvrhi::d3d11
             // Unbind everything to be sure, and to avoid checking the binding sets against each other. 
             // This only happens on switches between compute and graphics modes.
 
-            clearState();
+            resetContextState();
         }
 
         const bool updateFramebuffer = !m_CurrentGraphicsStateValid || m_CurrentFramebuffer != state.framebuffer;
+
+        if (m_RenderPassFramebuffer != state.framebuffer)
+        {
+            endRenderPass();
+            beginRenderPass(framebuffer);
+        }
         const bool updatePipeline = !m_CurrentGraphicsStateValid || m_CurrentGraphicsPipeline != state.pipeline;
         const bool updateBindings = updateFramebuffer || arraysAreDifferent(m_CurrentBindings, state.bindings);
 
@@ -191,14 +304,14 @@ namespace nvrhi::d3d11
 
             if (pipeline->pixelShaderHasUAVs)
             {
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(
+                m_D3DContext->OMSetRenderTargetsAndUnorderedAccessViews(
                     UINT(RTVs.size()), RTVs.data(),
                     framebuffer->DSV,
                     D3D11_KEEP_UNORDERED_ACCESS_VIEWS, 0, nullptr, nullptr);
             }
             else
             {
-                m_Context.immediateContext->OMSetRenderTargets(
+                m_D3DContext->OMSetRenderTargets(
                     UINT(RTVs.size()),RTVs.data(),
                     framebuffer->DSV);
             }
@@ -207,6 +320,7 @@ namespace nvrhi::d3d11
         if (updatePipeline)
         {
             bindGraphicsPipeline(pipeline);
+            m_Statistics.pipelineBinds++;
         }
 
         if (updatePipeline || updateStencilRef)
@@ -214,18 +328,19 @@ namespace nvrhi::d3d11
             m_CurrentStencilRefValue = pipeline->desc.renderState.depthStencilState.dynamicStencilRef
                 ? state.dynamicStencilRefValue
                 : pipeline->desc.renderState.depthStencilState.stencilRefValue;
-            m_Context.immediateContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
+            m_D3DContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
         }
 
         if (updatePipeline || updateBlendState)
         {
             float blendFactor[4]{ state.blendConstantColor.r, state.blendConstantColor.g, state.blendConstantColor.b, state.blendConstantColor.a };
-            m_Context.immediateContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
+            m_D3DContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
         }
 
         if (updateBindings)
         {
             bindGraphicsResourceSets(setsToBind, state.pipeline);
+            m_Statistics.bindingSetBinds += uint32_t(setsToBind.size());
 
             if (pipeline->pixelShaderHasUAVs)
             {
@@ -248,22 +363,28 @@ namespace nvrhi::d3d11
                     maxUAVSlot = std::max(maxUAVSlot, bindingSet->maxUAVSlot);
                 }
 
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+                m_D3DContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
             }
         }
 
+        // Volatile constant buffers move in the ring on every write, so they are rebound even if the sets are the same
+        if (updateBindings || m_VolatileConstantBuffersDirty)
+        {
+            bindVolatileConstantBuffers(state.bindings, pipeline->shaderMask);
+        }
+
         if (updateViewports)
         {
             DX11_ViewportState vpState = convertViewportState(state.viewport);
 
             if (vpState.numViewports)
             {
-                m_Context.immediateContext->RSSetViewports(vpState.numViewports, vpState.viewports);
+                m_D3DContext->RSSetViewports(vpState.numViewports, vpState.viewports);
             }
 
             if (vpState.numScissorRects)
             {
-                m_Context.immediateContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+                m_D3DContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
             }
         }
 
@@ -274,7 +395,7 @@ namespace nvrhi::d3d11
         {
             const SinglePassStereoState& spsState = pipeline->desc.renderState.singlePassStereo;
 
-            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
+            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_D3DContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
 
             if (Status != NVAPI_OK)
             {
@@ -287,55 +408,12 @@ namespace nvrhi::d3d11
 
         if (updateVertexBuffers)
         {
-            ID3D11Buffer *pVertexBuffers[c_MaxVertexAttributes] = {};
-            UINT pVertexBufferStrides[c_MaxVertexAttributes] = {};
-            UINT pVertexBufferOffsets[c_MaxVertexAttributes] = {};
-            uint32_t maxVbIndex = 0;
-
-            const auto *inputLayout = pipeline->inputLayout;
-            for (size_t i = 0; i < state.vertexBuffers.size(); i++)
-            {
-                const VertexBufferBinding& binding = state.vertexBuffers[i];
-
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-                
-                assert(binding.offset <= UINT_MAX);
-
-                pVertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->resource;
-                pVertexBufferStrides[binding.slot] = inputLayout->elementStrides.at(binding.slot);
-                pVertexBufferOffsets[binding.slot] = UINT(binding.offset);
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-            }
-
-            if (m_CurrentGraphicsStateValid)
-            {
-                for (const VertexBufferBinding& binding : m_CurrentVertexBufferBindings)
-                {
-                    if (binding.slot < c_MaxVertexAttributes)
-                        maxVbIndex = std::max(maxVbIndex, binding.slot);
-                }
-            }
-
-            m_Context.immediateContext->IASetVertexBuffers(0, maxVbIndex + 1,
-                pVertexBuffers,
-                pVertexBufferStrides,
-                pVertexBufferOffsets);
+            bindVertexBuffers(pipeline, state.vertexBuffers);
         }
 
         if (updateIndexBuffer)
         {
-            if (state.indexBuffer.buffer)
-            {
-                m_Context.immediateContext->IASetIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->resource,
-                    getDxgiFormatMapping(state.indexBuffer.format).srvFormat,
-                    state.indexBuffer.offset);
-            }
-            else
-            {
-                m_Context.immediateContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
-            }
+            bindIndexBuffer(state.indexBuffer);
         }
 
         m_CurrentIndirectBuffer = state.indirectParams;
@@ -354,26 +432,153 @@ namespace nvrhi::d3d11
                 m_CurrentBindings[i] = state.bindings[i];
             }
 
-            m_CurrentVertexBufferBindings = state.vertexBuffers;
-            m_CurrentIndexBufferBinding = state.indexBuffer;
+            setCurrentVertexBuffers(state.vertexBuffers, state.indexBuffer);
+        }
+    }
+
+    void CommandList::setGraphicsBindings(const BindingSetVector& bindings)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsBindings can only be used after setGraphicsState");
+            return;
+        }
+
+        // Binding changes on DX11 may need to rebind the UAVs together with the render targets,
+        // so go through the full path which only updates what's different.
+        GraphicsState state;
+        state.pipeline = m_CurrentGraphicsPipeline;
+        state.framebuffer = m_CurrentFramebuffer;
+        state.viewport = m_CurrentViewports;
+        state.blendConstantColor = m_CurrentBlendConstantColor;
+        state.dynamicStencilRefValue = m_CurrentStencilRefValue;
+        state.bindings = bindings;
+        state.vertexBuffers = m_CurrentVertexBufferBindings;
+        state.indexBuffer = m_CurrentIndexBufferBinding;
+        state.indirectParams = m_CurrentIndirectBuffer;
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsVertexBuffers can only be used after setGraphicsState");
+            return;
+        }
+
+        const bool updateIndexBuffer = m_CurrentIndexBufferBinding != indexBuffer;
+        const bool updateVertexBuffers = arraysAreDifferent(m_CurrentVertexBufferBindings, vertexBuffers);
+
+        if (updateVertexBuffers)
+        {
+            bindVertexBuffers(checked_cast<GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get()), vertexBuffers);
+        }
+
+        if (updateIndexBuffer)
+        {
+            bindIndexBuffer(indexBuffer);
+        }
 
-            m_CurrentVertexBuffers.resize(state.vertexBuffers.size());
-            for (size_t i = 0; i < state.vertexBuffers.size(); i++)
+        if (updateVertexBuffers || updateIndexBuffer)
+        {
+            setCurrentVertexBuffers(vertexBuffers, indexBuffer);
+        }
+    }
+
+    void CommandList::bindVertexBuffers(const GraphicsPipeline* pipeline, const VertexBufferBindingVector& vertexBuffers)
+    {
+        ID3D11Buffer *pVertexBuffers[c_MaxVertexAttributes] = {};
+        UINT pVertexBufferStrides[c_MaxVertexAttributes] = {};
+        UINT pVertexBufferOffsets[c_MaxVertexAttributes] = {};
+        uint32_t maxVbIndex = 0;
+
+        const auto *inputLayout = pipeline->inputLayout;
+        for (size_t i = 0; i < vertexBuffers.size(); i++)
+        {
+            const VertexBufferBinding& binding = vertexBuffers[i];
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+            
+            assert(binding.offset <= UINT_MAX);
+
+            pVertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->resource;
+            pVertexBufferStrides[binding.slot] = inputLayout->elementStrides.at(binding.slot);
+            pVertexBufferOffsets[binding.slot] = UINT(binding.offset);
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+        }
+
+        if (m_CurrentGraphicsStateValid)
+        {
+            for (const VertexBufferBinding& binding : m_CurrentVertexBufferBindings)
             {
-                m_CurrentVertexBuffers[i] = state.vertexBuffers[i].buffer;
+                if (binding.slot < c_MaxVertexAttributes)
+                    maxVbIndex = std::max(maxVbIndex, binding.slot);
             }
-            m_CurrentIndexBuffer = state.indexBuffer.buffer;
+        }
+
+        m_D3DContext->IASetVertexBuffers(0, maxVbIndex + 1,
+            pVertexBuffers,
+            pVertexBufferStrides,
+            pVertexBufferOffsets);
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        if (indexBuffer.buffer)
+        {
+            m_D3DContext->IASetIndexBuffer(checked_cast<Buffer*>(indexBuffer.buffer)->resource,
+                getDxgiFormatMapping(indexBuffer.format).srvFormat,
+                indexBuffer.offset);
+        }
+        else
+        {
+            m_D3DContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
         }
     }
 
+    void CommandList::setCurrentVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        m_CurrentVertexBufferBindings = vertexBuffers;
+        m_CurrentIndexBufferBinding = indexBuffer;
+
+        m_CurrentVertexBuffers.resize(vertexBuffers.size());
+        for (size_t i = 0; i < vertexBuffers.size(); i++)
+        {
+            m_CurrentVertexBuffers[i] = vertexBuffers[i].buffer;
+        }
+        m_CurrentIndexBuffer = indexBuffer.buffer;
+    }
+
+    void CommandList::updateGraphicsVolatileBuffers()
+    {
+        if (!m_VolatileConstantBuffersDirty || !m_CurrentGraphicsStateValid)
+            return;
+
+        BindingSetVector bindings;
+        for (const BindingSetHandle& bindingSet : m_CurrentBindings)
+            bindings.push_back(bindingSet);
+
+        bindVolatileConstantBuffers(bindings, checked_cast<GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get())->shaderMask);
+    }
+
     void CommandList::draw(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        updateGraphicsVolatileBuffers();
+
+        m_D3DContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        m_Statistics.drawCalls++;
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        updateGraphicsVolatileBuffers();
+
+        m_D3DContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        m_Statistics.drawCalls++;
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -382,12 +587,15 @@ namespace nvrhi::d3d11
         
         if (indirectParams) // validation layer will issue an error otherwise
         {
+            updateGraphicsVolatileBuffers();
+
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_D3DContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndirectArguments);
             }
+            m_Statistics.drawCalls++;
         }
     }
 
@@ -397,15 +605,39 @@ namespace nvrhi::d3d11
 
         if (indirectParams)
         {
+            updateGraphicsVolatileBuffers();
+
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_D3DContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndexedIndirectArguments);
             }
+            m_Statistics.drawCalls++;
         }
     }
 
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        // D3D11 has no way to source the draw count from a buffer without a CPU readback
+        (void)paramOffsetBytes;
+        (void)countBuffer;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        utils::NotSupported();
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countBuffer;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        utils::NotSupported();
+    }
+
     namespace
     {
         //Unfortunately we can't memcmp the structs since they have padding bytes in them
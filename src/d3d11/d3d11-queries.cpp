@@ -159,8 +159,8 @@ void CommandList::beginTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->Begin(query->disjoint.Get());
-    m_Context.immediateContext->End(query->start.Get());
+    m_D3DContext->Begin(query->disjoint.Get());
+    m_D3DContext->End(query->start.Get());
 }
 
 void CommandList::endTimerQuery(ITimerQuery* _query)
@@ -168,8 +168,8 @@ void CommandList::endTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->End(query->end.Get());
-    m_Context.immediateContext->End(query->disjoint.Get());
+    m_D3DContext->End(query->end.Get());
+    m_D3DContext->End(query->disjoint.Get());
 }
 
 bool Device::pollTimerQuery(ITimerQuery* _query)
@@ -243,4 +243,29 @@ void Device::resetTimerQuery(ITimerQuery* _query)
     query->time = 0.f;
 }
 
+QueryPoolHandle Device::createQueryPool(const QueryPoolDesc&)
+{
+    // DX11 has no query heaps or GPU-side resolves
+    utils::NotSupported();
+    return nullptr;
+}
+
+GpuProfilerHandle Device::createGpuProfiler(const GpuProfilerDesc&)
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
+BreadcrumbBufferHandle Device::createBreadcrumbBuffer(const BreadcrumbBufferDesc&)
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
+CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc&)
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
 } // namespace nvrhi::d3d11
\ No newline at end of file
@@ -35,6 +35,7 @@ BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
 {
     BindingLayout* layout = new BindingLayout();
     layout->desc = desc;
+    layout->descHash = std::hash<BindingLayoutDesc>()(desc);
     return BindingLayoutHandle::Create(layout);
 }
 
@@ -127,6 +128,9 @@ BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLa
             ret->constantBufferOffsets[slot] = (UINT)range.byteOffset / sizeOfConstantInBytes;
             ret->constantBufferCounts[slot] = align((UINT)range.byteSize, c_ConstantBufferOffsetSizeAlignment) / sizeOfConstantInBytes;
 
+            if (buffer->desc.isVolatile)
+                ret->volatileConstantBuffers.push_back({ buffer, slot, ret->constantBufferOffsets[slot] });
+
             ret->minConstantBufferSlot = std::min(ret->minConstantBufferSlot, slot);
             ret->maxConstantBufferSlot = std::max(ret->maxConstantBufferSlot, slot);
         }
@@ -175,6 +179,20 @@ BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLa
     return BindingSetHandle::Create(ret);
 }
 
+bool Device::createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets)
+{
+    // There are no descriptor heaps to batch on D3D11, the sets only hold the views
+    bool success = true;
+
+    for (size_t index = 0; index < count; index++)
+    {
+        outBindingSets[index] = createBindingSet(descs[index], layout);
+        success &= outBindingSets[index] != nullptr;
+    }
+
+    return success;
+}
+
 DescriptorTableHandle Device::createDescriptorTable(IBindingLayout*)
 {
     return nullptr;
@@ -207,10 +225,10 @@ bool BindingSet::isSupersetOf(const BindingSet& other) const
 
 #define D3D11_SET_ARRAY(method, min, max, array) \
         if ((max) >= (min)) \
-            m_Context.immediateContext->method(min, ((max) - (min) + 1), &(array)[min])
+            m_D3DContext->method(min, ((max) - (min) + 1), &(array)[min])
 #define D3D11_SET_ARRAY1(method, min, max, array, offsets, counts) \
         if ((max) >= (min)) \
-            m_Context.immediateContext1->method(min, ((max) - (min) + 1), &(array)[min], &(offsets)[min], &(counts)[min])
+            m_D3DContext1->method(min, ((max) - (min) + 1), &(array)[min], &(offsets)[min], &(counts)[min])
 
 void CommandList::prepareToBindGraphicsResourceSets(
     const BindingSetVector& resourceSets, 
@@ -332,7 +350,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Vertex) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_D3DContext1)
                 D3D11_SET_ARRAY1(VSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             else
                 D3D11_SET_ARRAY(VSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
@@ -342,7 +360,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Hull) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_D3DContext1)
                 D3D11_SET_ARRAY1(HSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             else
                 D3D11_SET_ARRAY(HSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
@@ -352,7 +370,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Domain) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_D3DContext1)
                 D3D11_SET_ARRAY1(DSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             else
                 D3D11_SET_ARRAY(DSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
@@ -362,7 +380,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Geometry) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_D3DContext1)
                 D3D11_SET_ARRAY1(GSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             else
                 D3D11_SET_ARRAY(GSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
@@ -372,7 +390,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Pixel) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_D3DContext1)
                 D3D11_SET_ARRAY1(PSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             else
                 D3D11_SET_ARRAY(PSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
@@ -442,7 +460,7 @@ void CommandList::bindComputeResourceSets(
 
             if (set->maxUAVSlot >= set->minUAVSlot)
             {
-                m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
+                m_D3DContext->CSSetUnorderedAccessViews(set->minUAVSlot,
                     set->maxUAVSlot - set->minUAVSlot + 1,
                     NullUAVs,
                     NullUAVInitialCounts);
@@ -457,7 +475,7 @@ void CommandList::bindComputeResourceSets(
         if ((set->visibility & ShaderType::Compute) == 0)
             continue;
 
-        if (m_Context.immediateContext1)
+        if (m_D3DContext1)
             D3D11_SET_ARRAY1(CSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
         else
             D3D11_SET_ARRAY(CSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
@@ -466,7 +484,7 @@ void CommandList::bindComputeResourceSets(
 
         if (set->maxUAVSlot >= set->minUAVSlot)
         {
-            m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
+            m_D3DContext->CSSetUnorderedAccessViews(set->minUAVSlot,
                 set->maxUAVSlot - set->minUAVSlot + 1,
                 &set->UAVs[set->minUAVSlot],
                 NullUAVInitialCounts);
@@ -474,6 +492,50 @@ void CommandList::bindComputeResourceSets(
     }
 }
 
+void CommandList::bindVolatileConstantBuffers(const BindingSetVector& bindingSets, ShaderType stages)
+{
+    m_VolatileConstantBuffersDirty = false;
+
+    if (!m_VolatileConstantBufferRing)
+        return;
+
+    for (IBindingSet* _set : bindingSets)
+    {
+        if (!_set)
+            continue;
+
+        BindingSet* set = checked_cast<BindingSet*>(_set);
+        const ShaderType setStages = set->visibility & stages;
+
+        for (const BindingSet::VolatileConstantBuffer& cb : set->volatileConstantBuffers)
+        {
+            // Buffers not written in this recording keep the binding of their own resource
+            const UINT* ringOffset = m_VolatileConstantBufferOffsets.find(cb.buffer);
+            if (!ringOffset)
+                continue;
+
+            // Buffers that didn't fit into the ring when it wrapped are bound from their own resource
+            const bool inResource = *ringOffset == c_VolatileConstantBufferInResource;
+            ID3D11Buffer* ring = inResource ? cb.buffer->resource.Get() : m_VolatileConstantBufferRing.Get();
+            const UINT firstConstant = (inResource ? 0 : *ringOffset) + cb.firstConstant;
+            const UINT numConstants = set->constantBufferCounts[cb.slot];
+
+            if ((setStages & ShaderType::Vertex) != 0)
+                m_D3DContext1->VSSetConstantBuffers1(cb.slot, 1, &ring, &firstConstant, &numConstants);
+            if ((setStages & ShaderType::Hull) != 0)
+                m_D3DContext1->HSSetConstantBuffers1(cb.slot, 1, &ring, &firstConstant, &numConstants);
+            if ((setStages & ShaderType::Domain) != 0)
+                m_D3DContext1->DSSetConstantBuffers1(cb.slot, 1, &ring, &firstConstant, &numConstants);
+            if ((setStages & ShaderType::Geometry) != 0)
+                m_D3DContext1->GSSetConstantBuffers1(cb.slot, 1, &ring, &firstConstant, &numConstants);
+            if ((setStages & ShaderType::Pixel) != 0)
+                m_D3DContext1->PSSetConstantBuffers1(cb.slot, 1, &ring, &firstConstant, &numConstants);
+            if ((setStages & ShaderType::Compute) != 0)
+                m_D3DContext1->CSSetConstantBuffers1(cb.slot, 1, &ring, &firstConstant, &numConstants);
+        }
+    }
+}
+
 #undef D3D11_SET_ARRAY
 
 } // namespace nvrhi::d3d11
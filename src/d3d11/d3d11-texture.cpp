@@ -62,7 +62,7 @@ namespace nvrhi::d3d11
 
     TextureHandle Device::createTexture(const TextureDesc& d, CpuAccessMode cpuAccess) const
     {
-        if (d.isVirtual)
+        if (d.isVirtual || d.isTiled)
         {
             utils::NotSupported();
             return nullptr;
@@ -209,6 +209,9 @@ namespace nvrhi::d3d11
 
         if (!d.debugName.empty())
             SetDebugName(pResource, d.debugName.c_str());
+
+        if (d.residencyPriority != ResidencyPriority::Normal)
+            pResource->SetEvictionPriority(convertResidencyPriority(d.residencyPriority));
         
         HANDLE sharedHandle = nullptr;
         if(isShared)
@@ -241,6 +244,28 @@ namespace nvrhi::d3d11
         utils::NotSupported();
         return false;
     }
+
+    bool Device::writeTextureDirect(ITexture*, uint32_t, uint32_t, const void*, size_t, size_t)
+    {
+        utils::NotSupported();
+        return false;
+    }
+
+    void Device::getTextureTiling(ITexture*, uint32_t*, PackedMipDesc*, TileShape*, uint32_t*, SubresourceTiling*)
+    {
+        utils::NotSupported();
+    }
+
+    void Device::updateTextureTileMappings(ITexture*, const TextureTilesMapping*, uint32_t, CommandQueue)
+    {
+        utils::NotSupported();
+    }
+
+    TextureHandle Device::createSamplerFeedbackTexture(ITexture*, const SamplerFeedbackTextureDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
     
     nvrhi::TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object _texture, const TextureDesc& desc)
     {
@@ -287,13 +312,13 @@ namespace nvrhi::d3d11
             {
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
-                m_Context.immediateContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
+                m_D3DContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
-                m_Context.immediateContext->ClearRenderTargetView(rtv, &clearColor.r);
+                m_D3DContext->ClearRenderTargetView(rtv, &clearColor.r);
             }
             else
             {
@@ -330,7 +355,7 @@ namespace nvrhi::d3d11
                 UINT clearFlags = 0;
                 if (clearDepth)   clearFlags |= D3D11_CLEAR_DEPTH;
                 if (clearStencil) clearFlags |= D3D11_CLEAR_STENCIL;
-                m_Context.immediateContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
+                m_D3DContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
             }
         }
     }
@@ -356,14 +381,14 @@ namespace nvrhi::d3d11
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
                 uint32_t clearValues[4] = { clearColor, clearColor, clearColor, clearColor };
-                m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+                m_D3DContext->ClearUnorderedAccessViewUint(uav, clearValues);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
                 float clearValues[4] = { float(clearColor), float(clearColor), float(clearColor), float(clearColor) };
-                m_Context.immediateContext->ClearRenderTargetView(rtv, clearValues);
+                m_D3DContext->ClearRenderTargetView(rtv, clearValues);
             }
             else
             {
@@ -392,7 +417,7 @@ namespace nvrhi::d3d11
         srcBox.bottom = resolvedSrcSlice.y + resolvedSrcSlice.height;
         srcBox.back = resolvedSrcSlice.z + resolvedSrcSlice.depth;
 
-        m_Context.immediateContext->CopySubresourceRegion(dst,
+        m_D3DContext->CopySubresourceRegion(dst,
                                        dstSubresource,
                                        resolvedDstSlice.x, resolvedDstSlice.y, resolvedDstSlice.z,
                                        src,
@@ -433,7 +458,28 @@ namespace nvrhi::d3d11
 
         UINT subresource = D3D11CalcSubresource(mipLevel, arraySlice, dest->desc.mipLevels);
 
-        m_Context.immediateContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+        m_D3DContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+    }
+
+    void CommandList::writeTexture(ITexture* _dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        TextureSubresourceSet subresourceSet = subresources.resolve(dest->desc, false);
+        if (numSubresources != size_t(subresourceSet.numArraySlices) * subresourceSet.numMipLevels)
+            // let the validation layer handle the messages
+            return;
+
+        for (ArraySlice arrayIndex = 0; arrayIndex < subresourceSet.numArraySlices; arrayIndex++)
+        {
+            for (MipLevel mipIndex = 0; mipIndex < subresourceSet.numMipLevels; mipIndex++)
+            {
+                const TextureSubresourceData& subresourceData = data[arrayIndex * subresourceSet.numMipLevels + mipIndex];
+                UINT subresource = D3D11CalcSubresource(mipIndex + subresourceSet.baseMipLevel, arrayIndex + subresourceSet.baseArraySlice, dest->desc.mipLevels);
+
+                m_D3DContext->UpdateSubresource(dest->resource, subresource, nullptr, subresourceData.data, UINT(subresourceData.rowPitch), UINT(subresourceData.depthPitch));
+            }
+        }
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
@@ -456,12 +502,27 @@ namespace nvrhi::d3d11
             {
                 uint32_t dstSubresource = D3D11CalcSubresource(mipLevel + dstSR.baseMipLevel, arrayIndex + dstSR.baseArraySlice, dest->desc.mipLevels);
                 uint32_t srcSubresource = D3D11CalcSubresource(mipLevel + srcSR.baseMipLevel, arrayIndex + srcSR.baseArraySlice, src->desc.mipLevels);
-                m_Context.immediateContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
+                m_D3DContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
             }
         }
     }
 
-    void *Device::mapStagingTexture(IStagingTexture* _stagingTexture, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    void CommandList::decodeSamplerFeedbackTexture(ITexture*, ITexture*)
+    {
+        utils::NotSupported();
+    }
+
+    void *Device::mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch, true);
+    }
+
+    void *Device::tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch, false);
+    }
+
+    void *Device::mapStagingTexture(IStagingTexture* _stagingTexture, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch, bool wait)
     {
         StagingTexture* stagingTexture = checked_cast<StagingTexture*>(_stagingTexture);
 
@@ -493,7 +554,7 @@ namespace nvrhi::d3d11
         UINT subresource = D3D11CalcSubresource(resolvedSlice.mipLevel, resolvedSlice.arraySlice, t->desc.mipLevels);
 
         D3D11_MAPPED_SUBRESOURCE res;
-        if (SUCCEEDED(m_Context.immediateContext->Map(t->resource, subresource, mapType, 0, &res)))
+        if (SUCCEEDED(m_Context.immediateContext->Map(t->resource, subresource, mapType, wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &res)))
         {
             stagingTexture->mappedSubresource = subresource;
             *outRowPitch = (size_t) res.RowPitch;
@@ -526,6 +587,8 @@ namespace nvrhi::d3d11
 
         subresources = subresources.resolve(desc, false);
 
+        std::lock_guard lockGuard(m_ViewCacheMutex);
+
         RefCountPtr<ID3D11ShaderResourceView>& srvPtr = m_ShaderResourceViews[TextureBindingKey(subresources, format)];
         if (srvPtr == nullptr)
         {
@@ -624,6 +687,8 @@ namespace nvrhi::d3d11
 
         subresources = subresources.resolve(desc, true);
 
+        std::lock_guard lockGuard(m_ViewCacheMutex);
+
         RefCountPtr<ID3D11RenderTargetView>& rtvPtr = m_RenderTargetViews[TextureBindingKey(subresources, format)];
         if (rtvPtr == nullptr)
         {
@@ -704,6 +769,7 @@ namespace nvrhi::d3d11
     {
         subresources = subresources.resolve(desc, true);
 
+        std::lock_guard lockGuard(m_ViewCacheMutex);
 
         RefCountPtr<ID3D11DepthStencilView>& dsvPtr = m_DepthStencilViews[TextureBindingKey(subresources, desc.format, isReadOnly)];
         if (dsvPtr == nullptr)
@@ -787,6 +853,8 @@ namespace nvrhi::d3d11
 
         subresources = subresources.resolve(desc, true);
 
+        std::lock_guard lockGuard(m_ViewCacheMutex);
+
         RefCountPtr<ID3D11UnorderedAccessView>& uavPtr = m_UnorderedAccessViews[TextureBindingKey(subresources, format)];
         if (uavPtr == nullptr)
         {
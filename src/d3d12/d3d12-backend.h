@@ -28,8 +28,9 @@
 #define NVRHI_D3D12_WITH_NVAPI 0
 #endif
 
+#include <dxgi1_4.h>
+
 #if NVRHI_D3D12_WITH_NVAPI
-#include <dxgi.h>
 #include <nvapi.h>
 #endif
 
@@ -48,12 +49,61 @@
 #define NVRHI_WITH_NVAPI_DISPLACEMENT_MICROMAP (0)
 #endif
 
+// Native opacity micromaps (DXR 1.2) are only available with a d3d12.h from the Agility SDK 1.717 or newer
+#if defined(D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_BYTE_ALIGNMENT)
+#define NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP (1)
+#else
+#define NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP (0)
+#endif
+
+// Enhanced barriers are only available with a d3d12.h from Windows SDK 10.0.22621 or the Agility SDK
+#if defined(__ID3D12GraphicsCommandList7_INTERFACE_DEFINED__)
+#define NVRHI_D3D12_WITH_ENHANCED_BARRIERS (1)
+#else
+#define NVRHI_D3D12_WITH_ENHANCED_BARRIERS (0)
+#endif
+
+// Sampler feedback needs ID3D12Device8, which is available in d3d12.h from Windows SDK 10.0.19041 or newer
+#if defined(__ID3D12Device8_INTERFACE_DEFINED__)
+#define NVRHI_D3D12_WITH_SAMPLER_FEEDBACK (1)
+#else
+#define NVRHI_D3D12_WITH_SAMPLER_FEEDBACK (0)
+#endif
+
+// GPU upload heaps need D3D12_HEAP_TYPE_GPU_UPLOAD and D3D12_FEATURE_D3D12_OPTIONS16 from the Agility SDK 1.613
+// or Windows SDK 10.0.26100; ID3D12Device14 is used as the marker for a d3d12.h that is new enough
+#if defined(__ID3D12Device14_INTERFACE_DEFINED__)
+#define NVRHI_D3D12_WITH_GPU_UPLOAD_HEAP (1)
+#else
+#define NVRHI_D3D12_WITH_GPU_UPLOAD_HEAP (0)
+#endif
+
+// Work graphs need ID3D12GraphicsCommandList10 and D3D12_FEATURE_D3D12_OPTIONS21 from the Agility SDK 1.613
+// or Windows SDK 10.0.26100
+#if defined(__ID3D12GraphicsCommandList10_INTERFACE_DEFINED__)
+#define NVRHI_D3D12_WITH_WORK_GRAPHS (1)
+#else
+#define NVRHI_D3D12_WITH_WORK_GRAPHS (0)
+#endif
+
+// Direct heap indexing (SM 6.6) needs the root signature flags from d3d12.h in Windows SDK 10.0.20348 or newer,
+// which is also where ID3D12Device9 first appears
+#if defined(__ID3D12Device9_INTERFACE_DEFINED__)
+#define NVRHI_D3D12_WITH_DIRECT_HEAP_INDEXING (1)
+#else
+#define NVRHI_D3D12_WITH_DIRECT_HEAP_INDEXING (0)
+#endif
+
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <memory>
 #include <queue>
 #include <list>
 #include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include <nvrhi/common/resourcebindingmap.h>
@@ -61,6 +111,18 @@
 #include "../common/state-tracking.h"
 #include "../common/dxgi-format.h"
 #include "../common/versioning.h"
+#include "../common/pipeline-cache.h"
+#include "../common/pipeline-creation-task.h"
+#include "../common/gpu-profiler.h"
+#include "../common/referenced-resources.h"
+#include "../common/gc-budget.h"
+#include "../common/pointer-map.h"
+#include "../common/submission-callbacks.h"
+#include "../common/upload-page-pool.h"
+#include "../common/accel-struct-pool.h"
+#include "../common/binding-set-cache.h"
+#include "../common/sampler-cache.h"
+#include "../common/weak-cached-ref-counter.h"
 
 #ifdef NVRHI_WITH_RTXMU
 #include <rtxmu/D3D12AccelStructManager.h>
@@ -71,6 +133,8 @@ namespace nvrhi::d3d12
     class RootSignature;
     class Buffer;
     class CommandList;
+    class Device;
+    class Queue;
     struct Context;
 
     typedef uint32_t RootParameterIndex;
@@ -88,6 +152,7 @@ namespace nvrhi::d3d12
     UINT convertSamplerReductionType(SamplerReductionType reductionType);
     D3D12_SHADING_RATE convertPixelShadingRate(VariableShadingRate shadingRate);
     D3D12_SHADING_RATE_COMBINER convertShadingRateCombiner(ShadingRateCombiner combiner);
+    D3D12_RESIDENCY_PRIORITY convertResidencyPriority(ResidencyPriority priority);
 
     void WaitForFence(ID3D12Fence* fence, uint64_t value, HANDLE event);
     bool IsBlendFactorRequired(BlendFactor value);
@@ -99,8 +164,12 @@ namespace nvrhi::d3d12
     struct Context
     {
         RefCountPtr<ID3D12Device> device;
+        RefCountPtr<ID3D12Device1> device1;
         RefCountPtr<ID3D12Device2> device2;
         RefCountPtr<ID3D12Device5> device5;
+#if NVRHI_D3D12_WITH_SAMPLER_FEEDBACK
+        RefCountPtr<ID3D12Device8> device8;
+#endif
 #ifdef NVRHI_WITH_RTXMU
         std::unique_ptr<rtxmu::DxAccelStructManager> rtxMemUtil;
 #endif
@@ -108,15 +177,49 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12CommandSignature> drawIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> drawIndexedIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> dispatchIndirectSignature;
+        RefCountPtr<ID3D12CommandSignature> dispatchMeshIndirectSignature;
         RefCountPtr<ID3D12QueryHeap> timerQueryHeap;
         RefCountPtr<Buffer> timerQueryResolveBuffer;
 
+        // The adapter that the device was created on, used to query the memory budget. May be null.
+        RefCountPtr<IDXGIAdapter3> adapter;
+
         IMessageCallback* messageCallback = nullptr;
+
+        // Set at device creation when DeviceDesc::enableEnhancedBarriers is set and the device supports them
+        bool enhancedBarriersEnabled = false;
+
+        // Set at device creation when the device supports DXR 1.2; OMMs are then created and built
+        // through the core API instead of the NVAPI extension
+        bool nativeOpacityMicromapsEnabled = false;
+
+        // The node that all objects are created on, see DeviceDesc::nodeMask
+        uint32_t nodeMask = 0;
+
+        // Returns the VisibleNodeMask for memory created on the device's node that other nodes can also access
+        [[nodiscard]] uint32_t getVisibleNodeMask(uint32_t otherNodes) const
+        {
+            return otherNodes ? (nodeMask ? nodeMask : 1u) | otherNodes : nodeMask;
+        }
+
+        // Returns the index of the device's node, for the APIs that take a node index instead of a mask
+        [[nodiscard]] uint32_t getNodeIndex() const
+        {
+            uint32_t index = 0;
+            for (uint32_t mask = nodeMask; mask > 1; mask >>= 1)
+                ++index;
+            return index;
+        }
+
         void error(const std::string& message) const;
     };
 
     class StaticDescriptorHeap : public IDescriptorHeap
     {
+    public:
+        // Released ranges of up to this many descriptors are kept in per-size free lists for O(1) reuse
+        static constexpr uint32_t c_MaxFreeListRangeSize = 16;
+
     private:
         const Context& m_Context;
         RefCountPtr<ID3D12DescriptorHeap> m_Heap;
@@ -127,17 +230,33 @@ namespace nvrhi::d3d12
         D3D12_GPU_DESCRIPTOR_HANDLE m_StartGpuHandleShaderVisible = { 0 };
         uint32_t m_Stride = 0;
         uint32_t m_NumDescriptors = 0;
-        std::vector<bool> m_AllocatedDescriptors;
+        // One bit per descriptor, set when allocated. Bits past m_NumDescriptors in the last word are always set.
+        std::vector<uint64_t> m_AllocatedBits;
+        // Released ranges indexed by their size; these stay marked in m_AllocatedBits until flushed
+        std::vector<DescriptorIndex> m_FreeRanges[c_MaxFreeListRangeSize + 1];
+        uint32_t m_NumFreeRangeDescriptors = 0;
         DescriptorIndex m_SearchStart = 0;
         uint32_t m_NumAllocatedDescriptors = 0;
+        uint64_t m_HeapId = 0;
         std::mutex m_Mutex;
 
         HRESULT Grow(uint32_t minRequiredSize);
+        void resizeBitset(uint32_t numDescriptors);
+        void setBits(DescriptorIndex baseIndex, uint32_t count, bool value);
+        [[nodiscard]] DescriptorIndex findNextAllocated(DescriptorIndex start, DescriptorIndex limit) const;
+        [[nodiscard]] DescriptorIndex findFreeRange(uint32_t count) const;
+        void flushFreeRanges();
+        DescriptorIndex allocateDescriptorsLocked(uint32_t count);
+        void releaseDescriptorsLocked(DescriptorIndex baseIndex, uint32_t count);
     public:
         explicit StaticDescriptorHeap(const Context& context);
+        ~StaticDescriptorHeap() override;
 
         HRESULT allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible);
         void copyToShaderVisibleHeap(DescriptorIndex index, uint32_t count = 1);
+
+        // Returns single descriptors held in a per-thread cache back to the heap
+        void releaseCachedDescriptors(const DescriptorIndex* indices, uint32_t count);
         
         DescriptorIndex allocateDescriptors(uint32_t count) override;
         DescriptorIndex allocateDescriptor() override;
@@ -150,6 +269,48 @@ namespace nvrhi::d3d12
         [[nodiscard]] ID3D12DescriptorHeap* getShaderVisibleHeap() const override;
     };
 
+    // Residency state of a committed resource or a heap that is registered with the ResidencyManager
+    struct ResidencyObject
+    {
+        // Not owned: the object that contains this entry keeps the pageable alive while it is registered
+        ID3D12Pageable* pageable = nullptr;
+        uint64_t size = 0;
+        bool registered = false;
+        bool resident = true;
+
+        // Last submission on each queue that used the object, compared with Queue::lastCompletedInstance
+        std::array<uint64_t, size_t(CommandQueue::Count)> lastUsedInstance{};
+        std::list<ResidencyObject*>::iterator lruPosition;
+    };
+
+    // Evicts the least recently used objects when the local memory usage exceeds the budget,
+    // and makes them resident again before they are used by a submission. See DeviceDesc::enableResidencyManager.
+    class ResidencyManager
+    {
+    public:
+        explicit ResidencyManager(const Context& context) : m_Context(context) { }
+
+        void registerObject(ResidencyObject& object, ID3D12Pageable* pageable, uint64_t size);
+        void unregisterObject(ResidencyObject& object);
+
+        // Called before the submission with the given instance ID is executed on the queue.
+        // Makes the objects resident, marks them as used by the submission, and then evicts the least recently used
+        // objects that are no longer in use by any queue until the usage is within the budget.
+        void prepareSubmission(const std::vector<ResidencyObject*>& objects, CommandQueue queueType, uint64_t instance,
+            Queue* const* queues);
+
+        [[nodiscard]] uint64_t getEvictedMemory();
+
+    private:
+        const Context& m_Context;
+        std::mutex m_Mutex;
+        std::list<ResidencyObject*> m_LruList; // most recently used objects first
+        uint64_t m_EvictedMemory = 0;
+        std::vector<ID3D12Pageable*> m_PageableScratch;
+
+        void evictOverBudget(Queue* const* queues);
+    };
+
     class DeviceResources
     {
     public:
@@ -158,13 +319,26 @@ namespace nvrhi::d3d12
         StaticDescriptorHeap shaderResourceViewHeap;
         StaticDescriptorHeap samplerHeap;
         utils::BitSetAllocator timerQueries;
+
+        // Only created when DeviceDesc::enableResidencyManager is set
+        std::unique_ptr<ResidencyManager> residencyManager;
 #ifdef NVRHI_WITH_RTXMU
         std::mutex asListMutex;
         std::vector<uint64_t> asBuildsCompleted;
 #endif
 
-        // The cache does not own the RS objects, so store weak references
-        std::unordered_map<size_t, RootSignature*> rootsigCache;
+        // The cache does not own the RS objects, so store weak references.
+        // It is split into shards with reader-writer locks so that concurrent pipeline creation mostly takes shared locks;
+        // root signatures can also be released on the threads that create pipelines asynchronously.
+        struct RootSignatureCacheShard
+        {
+            std::unordered_map<size_t, RootSignature*> rootSignatures;
+            std::shared_mutex mutex;
+        };
+        static constexpr size_t c_NumRootSignatureCacheShards = 16;
+        std::array<RootSignatureCacheShard, c_NumRootSignatureCacheShards> rootsigCache;
+
+        RootSignatureCacheShard& getRootSignatureCacheShard(size_t hash) { return rootsigCache[hash % c_NumRootSignatureCacheShards]; }
 
         explicit DeviceResources(const Context& context, const DeviceDesc& desc);
 
@@ -180,7 +354,9 @@ namespace nvrhi::d3d12
     {
     public:
         ShaderDesc desc;
-        std::vector<char> bytecode;
+        D3D12_SHADER_BYTECODE bytecode = {};
+        std::vector<char> bytecodeStorage; // empty when the shader references an external binary
+        RefCountPtr<IResource> bytecodeOwner; // keeps the external binary alive, see createShaderNoCopy
     #if NVRHI_D3D12_WITH_NVAPI
         std::vector<NVAPI_D3D12_PSO_EXTENSION_DESC*> extensions;
         std::vector<NV_CUSTOM_SEMANTIC> customSemantics;
@@ -213,7 +389,9 @@ namespace nvrhi::d3d12
     class ShaderLibrary : public RefCounter<IShaderLibrary>
     {
     public:
-        std::vector<char> bytecode;
+        D3D12_SHADER_BYTECODE bytecode = {};
+        std::vector<char> bytecodeStorage;
+        RefCountPtr<IResource> bytecodeOwner;
 
         void getBytecode(const void** ppBytecode, size_t* pSize) const override;
         ShaderHandle getShader(const char* entryName, ShaderType shaderType) override;
@@ -224,6 +402,10 @@ namespace nvrhi::d3d12
     public:
         HeapDesc desc;
         RefCountPtr<ID3D12Heap> heap;
+        ResidencyObject residency;
+        ResidencyManager* residencyManager = nullptr;
+
+        ~Heap() override;
 
         const HeapDesc& getDesc() override { return desc; }
     };
@@ -238,6 +420,16 @@ namespace nvrhi::d3d12
         HANDLE sharedHandle = nullptr;
         HeapHandle heap;
 
+        // With enhanced barriers: the texture stays in D3D12_BARRIER_LAYOUT_COMMON for all states that layout supports,
+        // so transitions between those states need no layout change, and read-to-read transitions need no barrier at all.
+        bool commonLayout = false;
+
+        // Set for sampler feedback textures, whose UAVs are created for the pair of resources
+        TextureHandle pairedTexture;
+
+        // Registered with the residency manager for committed device-local textures
+        ResidencyObject residency;
+
         Texture(const Context& context, DeviceResources& resources, TextureDesc desc, const D3D12_RESOURCE_DESC& resourceDesc)
             : TextureStateExtension(this->desc)
             , desc(std::move(desc))
@@ -262,6 +454,9 @@ namespace nvrhi::d3d12
         void createDSV(size_t descriptor, TextureSubresourceSet subresources, bool isReadOnly = false) const;
         DescriptorIndex getClearMipLevelUAV(uint32_t mipLevel);
 
+        // Returns the residency entry that covers the texture memory: the heap's for placed textures, or null if not tracked
+        ResidencyObject* getResidencyObject();
+
     private:
         const Context& m_Context;
         DeviceResources& m_Resources;
@@ -287,6 +482,9 @@ namespace nvrhi::d3d12
         uint64_t lastUseFenceValue = 0;
         HANDLE sharedHandle = nullptr;
 
+        // Registered with the residency manager for committed device-local buffers
+        ResidencyObject residency;
+
         Buffer(const Context& context, DeviceResources& resources, BufferDesc desc)
             : BufferStateExtension(this->desc)
             , desc(std::move(desc))
@@ -297,6 +495,7 @@ namespace nvrhi::d3d12
         ~Buffer() override;
         
         const BufferDesc& getDesc() const override { return desc; }
+        GpuVirtualAddress getGpuVirtualAddress() const override { return gpuVA; }
 
         Object getNativeObject(ObjectType objectType) override;
 
@@ -308,6 +507,9 @@ namespace nvrhi::d3d12
         static void createNullSRV(size_t descriptor, Format format, const Context& context);
         static void createNullUAV(size_t descriptor, Format format, const Context& context);
 
+        // See Texture::getResidencyObject
+        ResidencyObject* getResidencyObject();
+
     private:
         const Context& m_Context;
         DeviceResources& m_Resources;
@@ -351,10 +553,11 @@ namespace nvrhi::d3d12
         Object getNativeObject(ObjectType objectType) override;
     };
 
-    class Sampler : public RefCounter<ISampler>
+    class Sampler : public WeakCachedRefCounter<ISampler>
     {
     public:
-        Sampler(const Context& context, const SamplerDesc& desc);
+        Sampler(const Context& context, SamplerCache<Sampler>& cache, const SamplerDesc& desc);
+        ~Sampler() override;
         
         void createDescriptor(size_t descriptor) const;
 
@@ -362,6 +565,7 @@ namespace nvrhi::d3d12
 
     private:
         const Context& m_Context;
+        SamplerCache<Sampler>& m_Cache;
         const SamplerDesc m_Desc;
         D3D12_SAMPLER_DESC m_d3d12desc;
     };
@@ -411,10 +615,40 @@ namespace nvrhi::d3d12
         DeviceResources& m_Resources;
     };
 
+    class QueryPool : public RefCounter<IQueryPool>
+    {
+    public:
+        QueryPoolDesc desc;
+        RefCountPtr<ID3D12QueryHeap> heap;
+
+        const QueryPoolDesc& getDesc() const override { return desc; }
+    };
+
+    class GpuProfiler final : public GpuProfilerBase
+    {
+    public:
+        RefCountPtr<ID3D12QueryHeap> queryHeap;
+
+        GpuProfiler(Device* device, const GpuProfilerDesc& desc);
+        ~GpuProfiler() override;
+
+    protected:
+        void onFrameEnded(uint32_t frameSlot) override;
+        bool isFrameCompleted(uint32_t frameSlot, bool wait) override;
+        double getTimestampFrequency(CommandQueue queue) override;
+
+    private:
+        Device* m_Device;
+        HANDLE m_FenceEvent = nullptr;
+        // Last submitted instance of each queue when the frame ended, indexed by [frameSlot * CommandQueue::Count + queue]
+        std::vector<uint64_t> m_FrameFenceValues;
+    };
+
     class BindingLayout : public RefCounter<IBindingLayout>
     {
     public:
         BindingLayoutDesc desc;
+        size_t descHash = 0;
         uint32_t pushConstantByteSize = 0;
         RootParameterIndex rootParameterPushConstants = ~0u;
         RootParameterIndex rootParameterSRVetc = ~0u;
@@ -425,31 +659,38 @@ namespace nvrhi::d3d12
         std::vector<D3D12_DESCRIPTOR_RANGE1> descriptorRangesSamplers;
         std::vector<BindingLayoutItem> bindingLayoutsSRVetc;
         static_vector<std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
+        static_vector<std::pair<RootParameterIndex, D3D12_ROOT_PARAMETER1>, c_MaxRootDescriptorsPerLayout> rootParametersBuffers;
         static_vector<D3D12_ROOT_PARAMETER1, 32> rootParameters;
 
         BindingLayout(const BindingLayoutDesc& desc);
 
         const BindingLayoutDesc* getDesc() const override { return &desc; }
         const BindlessLayoutDesc* getBindlessDesc() const override { return nullptr; }
+        size_t getDescHash() const override { return descHash; }
     };
 
     class BindlessLayout : public RefCounter<IBindingLayout>
     {
     public:
         BindlessLayoutDesc desc;
+        size_t descHash = 0;
         static_vector<D3D12_DESCRIPTOR_RANGE1, 32> descriptorRanges;
-        D3D12_ROOT_PARAMETER1 rootParameter{};
+        D3D12_ROOT_PARAMETER1 rootParameter{}; // not used for directly indexed layouts
+        bool directlyIndexed = false;
 
         BindlessLayout(const BindlessLayoutDesc& desc);
 
         const BindingLayoutDesc* getDesc() const override { return nullptr; }
         const BindlessLayoutDesc* getBindlessDesc() const override { return &desc; }
+        size_t getDescHash() const override { return descHash; }
     };
 
-    class RootSignature : public RefCounter<IRootSignature>
+    // The root signature cache only holds weak references, see WeakCachedRefCounter
+    class RootSignature : public WeakCachedRefCounter<IRootSignature>
     {
     public:
         size_t hash = 0;
+        uint64_t contentHash = 0; // stable hash of the serialized root signature, used in pipeline library keys
         static_vector<std::pair<BindingLayoutHandle, RootParameterIndex>, c_MaxBindingLayouts> pipelineLayouts;
         RefCountPtr<ID3D12RootSignature> handle;
         uint32_t pushConstantByteSize = 0;
@@ -466,18 +707,43 @@ namespace nvrhi::d3d12
         DeviceResources& m_Resources;
     };
 
+    // Accumulates a stable hash of the contents of a PSO and turns it into a pipeline library entry name.
+    // Pointers in the PSO descs must be added through their contents, not their values.
+    class PipelineLibraryKey
+    {
+    public:
+        template<typename T>
+        void add(const T& value) { m_Hash = hashPipelineCacheBytes(&value, sizeof(T), m_Hash); }
+        void addBytes(const void* data, size_t size) { add(size); m_Hash = hashPipelineCacheBytes(data, size, m_Hash); }
+        void addBytecode(const D3D12_SHADER_BYTECODE& bytecode) { addBytes(bytecode.pShaderBytecode, bytecode.BytecodeLength); }
+        void addInputLayout(const D3D12_INPUT_LAYOUT_DESC& inputLayout);
+        void addStreamOutput(const D3D12_STREAM_OUTPUT_DESC& streamOutput);
+        std::wstring getName() const;
+        uint64_t getHash() const { return m_Hash; }
+
+    private:
+        uint64_t m_Hash = c_PipelineCacheHashSeed;
+    };
+
     class Framebuffer : public RefCounter<IFramebuffer>
     {
     public:
         FramebufferDesc desc;
         FramebufferInfoEx framebufferInfo;
+        size_t framebufferInfoHash = 0;
 
-        static_vector<TextureHandle, c_MaxRenderTargets + 1> textures;
+        static_vector<TextureHandle, c_MaxRenderTargets * 2 + 1> textures; // render targets + depth + resolve targets
         static_vector<DescriptorIndex, c_MaxRenderTargets> RTVs;
         DescriptorIndex DSV = c_InvalidDescriptorIndex;
         uint32_t rtWidth = 0;
         uint32_t rtHeight = 0;
 
+        // True if some attachments use non-default load or store ops, which requires recording with BeginRenderPass
+        bool useRenderPass = false;
+
+        // True if some attachments use a store op other than Store, i.e. their contents don't survive a suspended render pass
+        bool discardsContents = false;
+
         Framebuffer(DeviceResources& resources)
             : m_Resources(resources)
         { }
@@ -486,6 +752,7 @@ namespace nvrhi::d3d12
 
         const FramebufferDesc& getDesc() const override { return desc; }
         const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
 
     private:
         DeviceResources& m_Resources;
@@ -504,6 +771,7 @@ namespace nvrhi::d3d12
     public:
         GraphicsPipelineDesc desc;
         FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
 
         RefCountPtr<RootSignature> rootSignature;
         RefCountPtr<ID3D12PipelineState> pipelineState;
@@ -512,6 +780,7 @@ namespace nvrhi::d3d12
         
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
         Object getNativeObject(ObjectType objectType) override;
     };
 
@@ -532,6 +801,7 @@ namespace nvrhi::d3d12
     public:
         MeshletPipelineDesc desc;
         FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
 
         RefCountPtr<RootSignature> rootSignature;
         RefCountPtr<ID3D12PipelineState> pipelineState;
@@ -542,10 +812,23 @@ namespace nvrhi::d3d12
         
         const MeshletPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
         Object getNativeObject(ObjectType objectType) override;
     };
+
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        RefCountPtr<ID3D12CommandSignature> handle;
+        RefCountPtr<RootSignature> rootSignature; // only set when the records change push constants
+        IndirectArgumentType commandType = IndirectArgumentType::Draw;
+        bool changesInputAssembler = false;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+    };
     
-    class BindingSet : public RefCounter<IBindingSet>
+    class BindingSet : public CacheableBindingSet
     {
     public:
         RefCountPtr<BindingLayout> layout;
@@ -561,6 +844,15 @@ namespace nvrhi::d3d12
         bool hasUavBindings = false;
 
         static_vector<std::pair<RootParameterIndex, IBuffer*>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
+
+        // Buffers bound through root SRVs, UAVs and CBVs, see BindingLayoutItem::rootDescriptor
+        struct RootDescriptorBinding
+        {
+            RootParameterIndex rootParameterIndex = 0;
+            D3D12_ROOT_PARAMETER_TYPE type = D3D12_ROOT_PARAMETER_TYPE_SRV;
+            D3D12_GPU_VIRTUAL_ADDRESS address = 0;
+        };
+        static_vector<RootDescriptorBinding, c_MaxRootDescriptorsPerLayout> rootDescriptors;
         
         std::vector<RefCountPtr<IResource>> resources;
 
@@ -573,7 +865,9 @@ namespace nvrhi::d3d12
 
         ~BindingSet() override;
 
-        void createDescriptors();
+        // Writes the descriptors into tables that the caller allocated, and leaves the copy to the shader-visible heap to the caller.
+        // The table bases are ignored when the layout has no table of that kind.
+        void createDescriptors(DescriptorIndex samplerTableBase, DescriptorIndex srvTableBase);
 
         const BindingSetDesc* getDesc() const override { return &desc; }
         IBindingLayout* getLayout() const override { return layout; }
@@ -589,6 +883,10 @@ namespace nvrhi::d3d12
         uint32_t capacity = 0;
         DescriptorIndex firstDescriptor = 0;
 
+        // Directly indexed tables reserve the layout's maxCapacity up front so that their range never moves
+        bool directlyIndexed = false;
+        uint32_t reservedCapacity = 0;
+
         DescriptorTable(DeviceResources& resources)
             : m_Resources(resources)
         { }
@@ -598,6 +896,7 @@ namespace nvrhi::d3d12
         const BindingSetDesc* getDesc() const override { return nullptr; }
         IBindingLayout* getLayout() const override { return nullptr; }
         uint32_t getCapacity() const override { return capacity; }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return firstDescriptor; }
 
     private:
         DeviceResources& m_Resources;
@@ -630,6 +929,17 @@ namespace nvrhi::d3d12
     };
 
     D3D12_RESOURCE_STATES convertResourceStates(ResourceStates stateBits);
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+    struct EnhancedBarrierState
+    {
+        D3D12_BARRIER_SYNC sync = D3D12_BARRIER_SYNC_NONE;
+        D3D12_BARRIER_ACCESS access = D3D12_BARRIER_ACCESS_COMMON;
+        D3D12_BARRIER_LAYOUT layout = D3D12_BARRIER_LAYOUT_UNDEFINED; // only meaningful for textures
+    };
+
+    EnhancedBarrierState convertResourceStatesEnhanced(ResourceStates stateBits);
+#endif
     
     class BufferChunk
     {
@@ -647,16 +957,27 @@ namespace nvrhi::d3d12
         ~BufferChunk();
     };
 
+    [[nodiscard]] std::shared_ptr<BufferChunk> createBufferChunk(const Context& context, uint64_t size, bool isScratchBuffer, uint32_t identifier);
+
+    typedef UploadPagePool<BufferChunk> UploadChunkPool;
+
     class UploadManager
     {
     public:
-        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
+        // Upload managers take their chunks from the device-global pSharedChunkPool, scratch managers (pSharedChunkPool = nullptr) own them
+        UploadManager(const Context& context, class Queue* pQueue, UploadChunkPool* pSharedChunkPool, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
+        ~UploadManager();
 
         bool suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
             D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment = 256);
 
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
+        // Counters for CommandListStatistics, reset by the command list in open()
+        [[nodiscard]] uint64_t getSuballocatedBytes() const { return m_SuballocatedBytes; }
+        [[nodiscard]] uint32_t getAcquiredChunks() const { return m_AcquiredChunks; }
+        void resetStatistics() { m_SuballocatedBytes = 0; m_AcquiredChunks = 0; }
+
     private:
         const Context& m_Context;
         Queue* m_Queue;
@@ -664,11 +985,15 @@ namespace nvrhi::d3d12
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
         bool m_IsScratchBuffer = false;
+        UploadChunkPool* m_SharedChunkPool = nullptr;
+        uint64_t m_SuballocatedBytes = 0;
+        uint32_t m_AcquiredChunks = 0;
 
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
 
-        [[nodiscard]] std::shared_ptr<BufferChunk> createChunk(size_t size) const;
+        bool acquireOwnedChunk(uint64_t size, ID3D12GraphicsCommandList* pCommandList, const std::shared_ptr<BufferChunk>& chunkToRetire);
+        void returnUnsubmittedChunks(uint64_t currentVersion);
     };
 
     class OpacityMicromap : public RefCounter<rt::IOpacityMicromap>
@@ -697,6 +1022,11 @@ namespace nvrhi::d3d12
     {
     public:
         RefCountPtr<d3d12::Buffer> dataBuffer;
+        // Location of the AS data in dataBuffer, which is shared with other BLAS'es when the AS is suballocated
+        uint64_t dataOffset = 0;
+        uint64_t dataSize = 0;
+        AccelStructPool* pool = nullptr;
+        AccelStructPool::Allocation poolAllocation;
         std::vector<rt::AccelStructHandle> bottomLevelASes;
         std::vector<D3D12_RAYTRACING_INSTANCE_DESC> dxrInstances;
         rt::AccelStructDesc desc;
@@ -707,6 +1037,20 @@ namespace nvrhi::d3d12
         D3D12_GPU_VIRTUAL_ADDRESS rtxmuGpuVA = 0;
 #endif
 
+        // Persistent instance data, only used when desc.persistentInstanceBuffer is set.
+        // The BLAS'es are referenced per instance and counted, so that each one is transitioned once per build.
+        struct BlasReference
+        {
+            rt::AccelStructHandle handle;
+            size_t numInstances = 0;
+        };
+
+        RefCountPtr<d3d12::Buffer> instanceBuffer;
+        std::vector<AccelStruct*> instanceBlases;
+        std::unordered_map<AccelStruct*, BlasReference> uniqueBlases;
+
+        void setInstanceBlas(size_t index, AccelStruct* blas);
+
         AccelStruct(const Context& context)
             : m_Context(context)
         { }
@@ -715,6 +1059,8 @@ namespace nvrhi::d3d12
 
         void createSRV(size_t descriptor) const;
 
+        D3D12_GPU_VIRTUAL_ADDRESS getDataGpuVA() const { return dataBuffer->gpuVA + dataOffset; }
+
         Object getNativeObject(ObjectType objectType) override;
 
         const rt::AccelStructDesc& getDesc() const override { return desc; }
@@ -744,18 +1090,51 @@ namespace nvrhi::d3d12
         std::unordered_map<std::string, ExportTableEntry> exports;
         uint32_t maxLocalRootParameters = 0;
 
-        RayTracingPipeline(const Context& context)
+        RayTracingPipeline(const Context& context, IDevice* device)
             : m_Context(context)
+            , m_Device(device)
         { }
 
         const ExportTableEntry* getExport(const char* name);
-        uint32_t getShaderTableEntrySize() const;
 
         const rt::PipelineDesc& getDesc() const override { return desc; }
         rt::ShaderTableHandle createShaderTable() override;
+        rt::ShaderTableHandle createShaderTable(const rt::ShaderTableDesc& desc) override;
+        uint32_t getShaderTableEntrySize() const override;
+        const void* getShaderIdentifier(const char* exportName) override;
 
     private:
         const Context& m_Context;
+        IDevice* m_Device;
+    };
+
+    class WorkGraph : public RefCounter<IWorkGraph>
+    {
+    public:
+        WorkGraphDesc desc;
+        WorkGraphMemoryRequirements memoryRequirements;
+        RefCountPtr<RootSignature> rootSignature;
+        BufferHandle backingMemory;
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        RefCountPtr<ID3D12StateObject> stateObject;
+        D3D12_PROGRAM_IDENTIFIER programIdentifier = {};
+#endif
+
+        struct EntryPoint
+        {
+            std::string nodeName;
+            uint32_t arrayIndex = 0;
+            uint32_t recordSize = 0;
+        };
+
+        std::vector<EntryPoint> entryPoints;
+
+        const WorkGraphDesc& getDesc() const override { return desc; }
+        const WorkGraphMemoryRequirements& getBackingMemoryRequirements() const override { return memoryRequirements; }
+        IBuffer* getBackingMemory() const override { return backingMemory; }
+        uint32_t getNumEntryPoints() const override { return uint32_t(entryPoints.size()); }
+        uint32_t getEntryPointIndex(const char* nodeName, uint32_t arrayIndex) const override;
+        uint32_t getEntryPointRecordSize(uint32_t entryPointIndex) const override;
     };
 
     class ShaderTable : public RefCounter<rt::IShaderTable>
@@ -763,10 +1142,12 @@ namespace nvrhi::d3d12
     public:
         struct Entry
         {
+            // nullptr for records reserved for GPU writes
             const void* pShaderIdentifier;
             BindingSetHandle localBindings;
         };
 
+        rt::ShaderTableDesc desc;
         RefCountPtr<RayTracingPipeline> pipeline;
 
         Entry rayGenerationShader = {};
@@ -776,26 +1157,61 @@ namespace nvrhi::d3d12
 
         uint32_t version = 0;
 
-        ShaderTable(const Context& context, RayTracingPipeline* _pipeline)
-            : pipeline(_pipeline)
+        // Cached tables only: the persistent record buffer and the log of record changes, ordered by version.
+        // Each command list tracks the version it last copied into the buffer, see CachedShaderTableState.
+        // Record indices are global, i.e. ray generation first, then miss, hit and callable records.
+        struct RecordChange
+        {
+            uint32_t version;
+            uint32_t recordIndex;
+        };
+
+        // Unique for the lifetime of the device, unlike the table address
+        const uint64_t cacheId;
+        RefCountPtr<Buffer> buffer;
+        uint32_t bufferCapacity = 0;
+        std::vector<RecordChange> recordChanges;
+        // Command lists that copied an older version have to copy all records
+        uint32_t allRecordsDirtyVersion = 0;
+
+        ShaderTable(const Context& context, IDevice* device, RayTracingPipeline* _pipeline, const rt::ShaderTableDesc& _desc)
+            : desc(_desc)
+            , pipeline(_pipeline)
+            , cacheId(++s_NextCacheId)
             , m_Context(context)
+            , m_Device(device)
         { }
 
         uint32_t getNumEntries() const;
+        const Entry& getRecord(uint32_t recordIndex) const;
 
+        // Makes sure the cached table buffer can hold numEntries records, recreating it if needed
+        bool reserveBuffer(uint32_t numEntries);
+
+        const rt::ShaderTableDesc& getDesc() const override { return desc; }
         void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
         rt::IPipeline* getPipeline() override;
+        IBuffer* getBuffer() const override { return buffer; }
 
     private:
+        static std::atomic<uint64_t> s_NextCacheId;
+
         const Context& m_Context;
+        IDevice* m_Device;
 
+        bool makeEntry(const char* exportName, IBindingSet* bindings, Entry& outEntry) const;
         bool verifyExport(const RayTracingPipeline::ExportTableEntry* pExport, IBindingSet* bindings) const;
+        void markRecordDirty(uint32_t recordIndex);
+        void markAllRecordsDirty();
     };
 
 
@@ -808,15 +1224,30 @@ namespace nvrhi::d3d12
         D3D12_DISPATCH_RAYS_DESC dispatchRaysTemplate = {};
     };
 
+    // What a command list has copied into the buffer of a cached shader table, kept across recordings
+    class CachedShaderTableState
+    {
+    public:
+        uint32_t committedVersion = 0;
+        ID3D12DescriptorHeap* descriptorHeapSRV = nullptr;
+        ID3D12DescriptorHeap* descriptorHeapSamplers = nullptr;
+    };
+
+    // Submissions to different queues are independent, each queue serializes its own submissions with submissionMutex.
     class Queue
     {
     public:
         RefCountPtr<ID3D12CommandQueue> queue;
         RefCountPtr<ID3D12Fence> fence;
-        uint64_t lastSubmittedInstance = 0;
-        uint64_t lastCompletedInstance = 0;
+        // written under submissionMutex, but read without it
+        std::atomic<uint64_t> lastSubmittedInstance = 0;
+        std::atomic<uint64_t> lastCompletedInstance = 0;
         std::atomic<uint64_t> recordingInstance = 1;
+
+        // protects the ExecuteCommandLists/Signal pairs and the members below
+        std::mutex submissionMutex;
         std::deque<std::shared_ptr<class CommandListInstance>> commandListsInFlight;
+        CommandListStatistics statistics;
 
         explicit Queue(const Context& context, ID3D12CommandQueue* queue);
         uint64_t updateLastCompletedInstance();
@@ -832,6 +1263,12 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12GraphicsCommandList> commandList;
         RefCountPtr<ID3D12GraphicsCommandList4> commandList4;
         RefCountPtr<ID3D12GraphicsCommandList6> commandList6;
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        RefCountPtr<ID3D12GraphicsCommandList7> commandList7;
+#endif
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        RefCountPtr<ID3D12GraphicsCommandList10> commandList10;
+#endif
         uint64_t lastSubmittedInstance = 0;
     };
 
@@ -843,7 +1280,7 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12Fence> fence;
         RefCountPtr<ID3D12CommandAllocator> commandAllocator;
         RefCountPtr<ID3D12CommandList> commandList;
-        std::vector<RefCountPtr<IResource>> referencedResources;
+        ReferencedResources referencedResources;
         std::vector<RefCountPtr<IUnknown>> referencedNativeResources;
         std::vector<RefCountPtr<StagingTexture>> referencedStagingTextures;
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers;
@@ -852,6 +1289,13 @@ namespace nvrhi::d3d12
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
 #endif
+
+        // Called when the GPU is done with the instance. Keeps the storage, the command list that recorded
+        // the instance reuses it for a later recording.
+        void releaseReferences();
+        // Incremental version for runGarbageCollection(budget), returns false if some references are left
+        bool releaseReferences(GarbageCollectionBudgetTracker& budget);
+        [[nodiscard]] size_t getStorageCapacity() const;
     };
 
     class CommandList final : public RefCounter<nvrhi::d3d12::ICommandList>
@@ -860,11 +1304,22 @@ namespace nvrhi::d3d12
 
         // Internal interface functions
 
-        CommandList(class Device* device, const Context& context, DeviceResources& resources, const CommandListParameters& params);
-        std::shared_ptr<CommandListInstance> executed(Queue* pQueue);
+        // Bundle command lists record into a D3D12 bundle for a CommandBundle and are never submitted to a queue
+        CommandList(class Device* device, const Context& context, DeviceResources& resources, const CommandListParameters& params, bool isBundle = false);
+        std::shared_ptr<CommandListInstance> executed(Queue* pQueue, uint64_t submittedInstance);
         void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
         void requireBufferState(IBuffer* buffer, ResourceStates state);
         ID3D12CommandList* getD3D12CommandList() const { return m_ActiveCommandList->commandList; }
+        ID3D12GraphicsCommandList* getD3D12GraphicsCommandList() const { return m_ActiveCommandList->commandList; }
+
+        // State recorded by bundle command lists, applied by the command list that executes the bundle
+        [[nodiscard]] const BundleStateRequirements& getBundleStates() const { return m_BundleStates; }
+        [[nodiscard]] const DX12_ViewportState& getBundleViewportState() const { return m_BundleViewportState; }
+        [[nodiscard]] ID3D12DescriptorHeap* getBundleHeapSRVetc() const { return m_BundleHeapSRVetc; }
+        [[nodiscard]] ID3D12DescriptorHeap* getBundleHeapSamplers() const { return m_BundleHeapSamplers; }
+
+        // Objects tracked by the residency manager that are used by the commands recorded since open()
+        [[nodiscard]] const PointerMap<ResidencyObject, bool>& getResidencyObjects() const { return m_ResidencyObjects; }
 
         // IResource implementation
 
@@ -884,7 +1339,9 @@ namespace nvrhi::d3d12
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -893,10 +1350,14 @@ namespace nvrhi::d3d12
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindings(const BindingSetVector& bindings) override;
+        void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -904,22 +1365,43 @@ namespace nvrhi::d3d12
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) override;
+
+        void executeBundle(ICommandBundle* bundle) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const DispatchGraphArguments& args) override;
+
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
 
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) override { (void)pool; (void)firstQuery; (void)numQueries; }
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) override;
+        void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) override;
+
         void beginMarker(const char *name) override;
         void endMarker() override;
+        void setGpuProfiler(IGpuProfiler* profiler) override;
+        void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) override;
 
         void setEnableAutomaticBarriers(bool enable) override;
         void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
@@ -938,12 +1420,19 @@ namespace nvrhi::d3d12
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
 
         void commitBarriers() override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void endTextureStateTransition(ITexture* texture) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void endBufferStateTransition(IBuffer* buffer) override;
+        void textureAliasingBarrier(ITexture* texture) override;
+        void bufferAliasingBarrier(IBuffer* buffer) override;
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
         ResourceStates getBufferState(IBuffer* buffer) override;
 
         nvrhi::IDevice* getDevice() override;
         const CommandListParameters& getDesc() override { return m_Desc; }
+        const CommandListStatistics& getStatistics() const override { return m_Statistics; }
 
         // D3D12 specific methods
 
@@ -979,8 +1468,27 @@ namespace nvrhi::d3d12
         
         CommandListParameters m_Desc;
 
+        const bool m_IsBundle;
+        BundleStateRequirements m_BundleStates;
+        DX12_ViewportState m_BundleViewportState;
+        ID3D12DescriptorHeap* m_BundleHeapSRVetc = nullptr;
+        ID3D12DescriptorHeap* m_BundleHeapSamplers = nullptr;
+
+        PointerMap<ResidencyObject, bool> m_ResidencyObjects;
+
+        CommandListStatistics m_Statistics;
+
+#ifndef NDEBUG
+        // Capacities of the instance, command list and state tracker storage when the recording was opened,
+        // see CommandListStatistics::recordingAllocations
+        std::array<size_t, 3> getStorageCapacities() const;
+        std::array<size_t, 3> m_StorageCapacitiesAtOpen{};
+#endif
+
         std::shared_ptr<InternalCommandList> m_ActiveCommandList;
-        std::list<std::shared_ptr<InternalCommandList>> m_CommandListPool;
+        // Both pools are in submission order, so only the front entries need to be checked for completion
+        std::vector<std::shared_ptr<InternalCommandList>> m_CommandListPool;
+        std::vector<std::shared_ptr<CommandListInstance>> m_InstancePool;
         std::shared_ptr<CommandListInstance> m_Instance;
         uint64_t m_RecordingVersion = 0;
 
@@ -990,37 +1498,113 @@ namespace nvrhi::d3d12
         ComputeState m_CurrentComputeState;
         MeshletState m_CurrentMeshletState;
         rt::State m_CurrentRayTracingState;
+        WorkGraphState m_CurrentWorkGraphState;
         bool m_CurrentGraphicsStateValid = false;
         bool m_CurrentComputeStateValid = false;
         bool m_CurrentMeshletStateValid = false;
         bool m_CurrentRayTracingStateValid = false;
+        bool m_CurrentWorkGraphStateValid = false;
+        IBuffer* m_CurrentWorkGraphBackingMemory = nullptr;
+
+        // The framebuffer of the current logical render pass, for framebuffers that are recorded with BeginRenderPass.
+        // It stays set while the render pass is suspended by commands that cannot be recorded inside it.
+        Framebuffer* m_RenderPassFramebuffer = nullptr;
+        bool m_RenderPassActive = false;
+        bool m_RenderPassStarted = false; // the load ops have been applied already
 
         // Cache for internal state
 
         ID3D12DescriptorHeap* m_CurrentHeapSRVetc = nullptr;
         ID3D12DescriptorHeap* m_CurrentHeapSamplers = nullptr;
         ID3D12Resource* m_CurrentUploadBuffer = nullptr;
+
+        // The predicate set with setPredication, so that internal upload copies can be recorded without it
+        ID3D12Resource* m_PredicationBuffer = nullptr;
+        uint64_t m_PredicationOffset = 0;
+        D3D12_PREDICATION_OP m_PredicationOp = D3D12_PREDICATION_OP_EQUAL_ZERO;
+
         SinglePassStereoState m_CurrentSinglePassStereoState;
         
-        std::unordered_map<IBuffer*, D3D12_GPU_VIRTUAL_ADDRESS> m_VolatileConstantBufferAddresses;
+        PointerMap<IBuffer, D3D12_GPU_VIRTUAL_ADDRESS> m_VolatileConstantBufferAddresses;
         bool m_AnyVolatileBufferWrites = false;
 
         std::vector<D3D12_RESOURCE_BARRIER> m_D3DBarriers; // Used locally in commitBarriers, member to avoid re-allocations
 
+        struct SplitBarrier
+        {
+            IResource* resource = nullptr;
+            D3D12_RESOURCE_BARRIER barrier{};
+        };
+
+        GpuProfilerRecording m_ProfilerRecording;
+
+        // END_ONLY halves of the split barriers started with begin[...]StateTransition
+        std::vector<SplitBarrier> m_SplitBarriers;
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        // Used instead of m_D3DBarriers when enhanced barriers are enabled
+        std::vector<D3D12_TEXTURE_BARRIER> m_D3DTextureBarriers;
+        std::vector<D3D12_BUFFER_BARRIER> m_D3DBufferBarriers;
+
+        struct SplitTextureBarrier
+        {
+            IResource* resource = nullptr;
+            D3D12_TEXTURE_BARRIER barrier{};
+        };
+
+        struct SplitBufferBarrier
+        {
+            IResource* resource = nullptr;
+            D3D12_BUFFER_BARRIER barrier{};
+        };
+
+        // Second halves (SyncBefore = SPLIT) of the enhanced split barriers
+        std::vector<SplitTextureBarrier> m_SplitTextureBarriers;
+        std::vector<SplitBufferBarrier> m_SplitBufferBarriers;
+#endif
+
         // Bound volatile buffer state. Saves currently bound volatile buffers and their current GPU VAs.
         // Necessary to patch the bound VAs when a buffer is updated between setGraphicsState and draw, or between draws.
 
         static_vector<VolatileConstantBufferBinding, c_MaxVolatileConstantBuffers> m_CurrentGraphicsVolatileCBs;
         static_vector<VolatileConstantBufferBinding, c_MaxVolatileConstantBuffers> m_CurrentComputeVolatileCBs;
 
-        std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_ShaderTableStates;
+        PointerMap<rt::IShaderTable, ShaderTableState> m_ShaderTableStates;
+        // Keyed by ShaderTable::cacheId, not cleared on open
+        static constexpr size_t c_MaxCachedShaderTableStates = 256;
+        std::unordered_map<uint64_t, CachedShaderTableState> m_CachedShaderTableStates;
+        std::vector<uint32_t> m_ShaderTableDirtyRecords;
+
+        // The graph that each backing memory buffer was last initialized for in this recording
+        PointerMap<IBuffer, IWorkGraph*> m_WorkGraphBackingMemoryOwners;
         ShaderTableState* getShaderTableStateTracking(rt::IShaderTable* shaderTable);
+        bool writeShaderTableRecord(uint8_t* cpuVA, const ShaderTable::Entry& entry);
+        bool updateCachedShaderTable(ShaderTable* shaderTable, ShaderTableState* shaderTableState);
         
         void clearStateCache();
 
+        void resolveProfilerQueries();
+        void convertPendingBarriers();
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        void convertPendingBarriersEnhanced();
+        void issueEnhancedBarriers();
+#endif
+        bool beginSplitBarriers(IResource* resource); // returns true if barriers were issued, the caller then references the resource
+        void endSplitBarriers(IResource* resource); // nullptr ends all open split barriers
+        void aliasingBarrier(ID3D12Resource* resource);
+
         void bindGraphicsPipeline(GraphicsPipeline* pso, bool updateRootSignature) const;
         void bindMeshletPipeline(MeshletPipeline* pso, bool updateRootSignature) const;
         void bindFramebuffer(Framebuffer* fb);
+        void beginRenderPass(Framebuffer* fb, bool resume);
+        void suspendRenderPass();
+        void resumeRenderPass();
+        // SetPredication applies to copies as well, the upload copies of writeBuffer, writeTexture and shader tables are recorded without it
+        void suspendPredication();
+        void resumePredication();
+        void commitBarriersInsideRenderPass();
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void bindVertexBuffers(const GraphicsPipeline* pso, const VertexBufferBindingVector& vertexBuffers);
         void unbindShadingRateState();
         
         std::shared_ptr<InternalCommandList> createInternalCommandList() const;
@@ -1028,6 +1612,32 @@ namespace nvrhi::d3d12
         void buildTopLevelAccelStructInternal(AccelStruct* as, D3D12_GPU_VIRTUAL_ADDRESS instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags);
     };
 
+    class CommandBundle final : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+        RefCountPtr<CommandList> commandList;
+
+        CommandBundle(const CommandBundleDesc& desc, RefCountPtr<CommandList> commandList)
+            : desc(desc)
+            , commandList(std::move(commandList))
+        { }
+
+        void open() override { commandList->open(); }
+        void close() override { commandList->close(); }
+
+        void setGraphicsState(const GraphicsState& state) override { commandList->setGraphicsState(state); }
+        void setPushConstants(const void* data, size_t byteSize) override { commandList->setPushConstants(data, byteSize); }
+
+        void draw(const DrawArguments& args) override { commandList->draw(args); }
+        void drawIndexed(const DrawArguments& args) override { commandList->drawIndexed(args); }
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndirect(offsetBytes, drawCount); }
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndexedIndirect(offsetBytes, drawCount); }
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override { return commandList->getNativeObject(objectType); }
+    };
+
     class Device final : public RefCounter<IDevice>
     {
     public:
@@ -1041,28 +1651,43 @@ namespace nvrhi::d3d12
         // IDevice implementation
 
         HeapHandle createHeap(const HeapDesc& d) override;
+        TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) override;
+        StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) override;
+        ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) override;
+        BindingSetCacheHandle createBindingSetCache() override;
+        MipGeneratorHandle createMipGenerator() override;
 
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
         StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
         void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
         void unmapStagingTexture(IStagingTexture* tex) override;
+        void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         void unmapBuffer(IBuffer* b) override;
+        void *tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
         BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
 
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+
         ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
         ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
         ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner) override;
+        ShaderLibraryHandle createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner) override;
 
         SamplerHandle createSampler(const SamplerDesc& d) override;
 
@@ -1078,6 +1703,12 @@ namespace nvrhi::d3d12
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+        GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) override;
+        BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -1091,10 +1722,21 @@ namespace nvrhi::d3d12
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
 
+        WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) override;
+
+        PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override;
+        PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override;
+
+        bool loadPipelineCache(const void* data, size_t size) override;
+        bool savePipelineCache(std::vector<uint8_t>& outData) override;
+
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
 
         BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) override;
         DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
@@ -1109,7 +1751,16 @@ namespace nvrhi::d3d12
         uint64_t executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
         void waitForIdle() override;
+        uint64_t getCompletedInstance(CommandQueue queue) override;
+        bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) override;
         void runGarbageCollection() override;
+        bool runGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setUploadPoolSettings(const UploadPoolSettings& settings) override;
+        UploadPoolStatistics getUploadPoolStatistics() override;
+        bool queryMemoryBudget(MemoryBudget& outBudget) override;
+        CommandListStatistics getCommandListStatistics(bool reset = true) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
@@ -1124,24 +1775,42 @@ namespace nvrhi::d3d12
 
         // Internal interface
         Queue* getQueue(CommandQueue type) { return m_Queues[int(type)].get(); }
+        UploadChunkPool* getUploadChunkPool() { return &m_UploadChunkPool; }
 
         Context& getContext() { return m_Context; }
 
         bool setHlslExtensionsUAV(uint32_t slot);
 
+        // See d3d12::setEventOnSubmissions
+        bool setEventOnSubmissions(const SubmissionPoint* submissions, size_t count, bool waitAny, HANDLE event);
+
         bool GetAccelStructPreBuildInfo(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO& outPreBuildInfo, const rt::AccelStructDesc& desc) const;
+        bool GetOpacityMicromapPreBuildInfo(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO& outPreBuildInfo, const rt::OpacityMicromapDesc& desc) const;
 
         bool GetNvapiIsInitialized() const { return m_NvapiIsInitialized; }
     private:
         Context m_Context;
+
+        // Interned samplers, see createSampler.
+        // Declared early, so that it outlives the members that can hold samplers.
+        SamplerCache<Sampler> m_SamplerCache;
+
         DeviceResources m_Resources;
 
+        // Upload chunks shared by all command lists. Declared before the queues, which may hold the last
+        // references to command lists whose upload managers give their chunks back on destruction.
+        std::atomic<uint32_t> m_UploadChunkCount = 0;
+        UploadChunkPool m_UploadChunkPool;
+
+        // Storage for suballocated BLAS'es. Also declared before the queues, for the same reason.
+        AccelStructPool m_AccelStructPool;
+
         std::array<std::unique_ptr<Queue>, (int)CommandQueue::Count> m_Queues;
         HANDLE m_FenceEvent;
 
-        std::mutex m_Mutex;
+        SubmissionCallbackThread m_SubmissionCallbacks;
 
-        std::vector<ID3D12CommandList*> m_CommandListsToExecute; // used locally in executeCommandLists, member to avoid re-allocations
+        std::mutex m_Mutex;
         
         bool m_NvapiIsInitialized = false;
         bool m_SinglePassStereoSupported = false;
@@ -1152,16 +1821,50 @@ namespace nvrhi::d3d12
         bool m_VariableRateShadingSupported = false;
         bool m_OpacityMicromapSupported = false;
         bool m_ShaderExecutionReorderingSupported = false;
+        bool m_SamplerFeedbackSupported = false;
+        bool m_HeapDirectlyIndexedSupported = false;
+        bool m_GpuUploadHeapSupported = false;
+        bool m_WorkGraphsSupported = false;
 
         D3D12_FEATURE_DATA_D3D12_OPTIONS  m_Options = {};
         D3D12_FEATURE_DATA_D3D12_OPTIONS5 m_Options5 = {};
         D3D12_FEATURE_DATA_D3D12_OPTIONS6 m_Options6 = {};
         D3D12_FEATURE_DATA_D3D12_OPTIONS7 m_Options7 = {};
 
+        // Pipeline library used as the persistent PSO cache, created by loadPipelineCache.
+        // The library references the serialized data, so the data is declared first and destroyed last.
+        std::vector<uint8_t> m_PipelineLibraryData;
+        RefCountPtr<ID3D12PipelineLibrary1> m_PipelineLibrary;
+        mutable std::mutex m_PipelineLibraryMutex;
+
+        // Serialized root signatures keyed by a hash of their description. They are saved into and restored from
+        // the pipeline cache, so that later runs don't need to call D3D12SerializeVersionedRootSignature.
+        std::unordered_map<uint64_t, std::vector<uint8_t>> m_RootSignatureBlobs;
+        mutable std::shared_mutex m_RootSignatureBlobsMutex;
+
+        void getCompletedInstances(CompletedInstances& completed);
+        bool waitForSubmissions(const SubmissionPoint* submissions, size_t count, bool waitAny, uint64_t timeout, size_t& outCompletedIndex);
+
+        bool findRootSignatureBlob(uint64_t descHash, std::vector<uint8_t>& outBlob) const;
+        void storeRootSignatureBlob(uint64_t descHash, const void* data, size_t size);
+
+        RefCountPtr<ID3D12PipelineLibrary1> getPipelineLibrary() const;
+        void storeLibraryPipeline(ID3D12PipelineLibrary1* library, const PipelineLibraryKey& key, ID3D12PipelineState* pipelineState) const;
+
+        // Shared by createShader and createShaderNoCopy, the caller sets up the bytecode
+        ShaderHandle initShader(Shader* shader, const ShaderDesc& d);
+
         RefCountPtr<RootSignature> getRootSignature(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& pipelineLayouts, bool allowInputLayout);
         RefCountPtr<ID3D12PipelineState> createPipelineState(const GraphicsPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const ComputePipelineDesc& desc, RootSignature* pRS) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const MeshletPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc, RootSignature* pRS);
+
+        // Applies the residency priority to a newly created pageable, and registers it with the residency manager if managed is set
+        void initResidency(ResidencyObject& residency, ID3D12Pageable* pageable, uint64_t size, ResidencyPriority priority, bool managed);
+
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, bool wait);
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch, bool wait);
     };
 
 } // namespace nvrhi::d3d12
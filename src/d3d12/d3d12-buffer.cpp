@@ -50,6 +50,9 @@ namespace nvrhi::d3d12
             m_Resources.shaderResourceViewHeap.releaseDescriptor(m_ClearUAV);
             m_ClearUAV = c_InvalidDescriptorIndex;
         }
+
+        if (m_Resources.residencyManager)
+            m_Resources.residencyManager->unregisterObject(residency);
     }
 
     BufferHandle Device::createBuffer(const BufferDesc& d)
@@ -87,7 +90,34 @@ namespace nvrhi::d3d12
             return BufferHandle::Create(buffer);
         }
 
+        if (d.isTiled)
+        {
+            // Tiles are mapped to heap memory later, in updateBufferTileMappings
+            HRESULT res = m_Context.device->CreateReservedResource(
+                &resourceDesc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "CreateReservedResource call failed for buffer " << utils::DebugNameToString(d.debugName)
+                    << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+
+                delete buffer;
+                return nullptr;
+            }
+
+            buffer->postCreate();
+
+            return BufferHandle::Create(buffer);
+        }
+
         D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.CreationNodeMask = m_Context.nodeMask;
+        heapProps.VisibleNodeMask = m_Context.getVisibleNodeMask(d.visibleNodeMask);
         D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_NONE;
         D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
 
@@ -122,6 +152,15 @@ namespace nvrhi::d3d12
                 break;
         }
 
+        bool gpuUploadHeap = false;
+#if NVRHI_D3D12_WITH_GPU_UPLOAD_HEAP
+        if (d.cpuAccess == CpuAccessMode::Write && d.preferDeviceLocal && m_GpuUploadHeapSupported && !isShared)
+        {
+            heapProps.Type = D3D12_HEAP_TYPE_GPU_UPLOAD;
+            gpuUploadHeap = true;
+        }
+#endif
+
         HRESULT res = m_Context.device->CreateCommittedResource(
             &heapProps,
             heapFlags,
@@ -130,6 +169,24 @@ namespace nvrhi::d3d12
             nullptr,
             IID_PPV_ARGS(&buffer->resource));
 
+        if (FAILED(res) && gpuUploadHeap)
+        {
+            // The GPU upload heap lives in video memory and can run out before the regular upload heap does
+            heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+            gpuUploadHeap = false;
+
+            res = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                heapFlags,
+                &resourceDesc,
+                initialState,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+        }
+
+        if (!gpuUploadHeap)
+            buffer->desc.preferDeviceLocal = false;
+
         if (FAILED(res))
         {
             std::stringstream ss;
@@ -165,6 +222,14 @@ namespace nvrhi::d3d12
 
         buffer->postCreate();
 
+        if (buffer->desc.cpuAccess == CpuAccessMode::None || gpuUploadHeap)
+        {
+            // GPU upload heap buffers get the priority but are not managed: the CPU can write to them through
+            // a mapping at any time, and an evicted resource must not be accessed by the CPU
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &resourceDesc);
+            initResidency(buffer->residency, buffer->resource, allocInfo.SizeInBytes, d.residencyPriority, !isShared && !gpuUploadHeap);
+        }
+
         return BufferHandle::Create(buffer);
     }
 
@@ -193,12 +258,25 @@ namespace nvrhi::d3d12
         return m_ClearUAV;
     }
 
-    void *Device::mapBuffer(IBuffer* _b, CpuAccessMode flags)
+    void *Device::mapBuffer(IBuffer* b, CpuAccessMode flags)
+    {
+        return mapBuffer(b, flags, true);
+    }
+
+    void *Device::tryMapBuffer(IBuffer* b, CpuAccessMode flags)
+    {
+        return mapBuffer(b, flags, false);
+    }
+
+    void *Device::mapBuffer(IBuffer* _b, CpuAccessMode flags, bool wait)
     {
         Buffer* b = checked_cast<Buffer*>(_b);
 
         if (b->lastUseFence)
         {
+            if (!wait && b->lastUseFence->GetCompletedValue() < b->lastUseFenceValue)
+                return nullptr;
+
             WaitForFence(b->lastUseFence, b->lastUseFenceValue, m_FenceEvent);
             b->lastUseFence = nullptr;
         }
@@ -286,6 +364,36 @@ namespace nvrhi::d3d12
         return true;
     }
 
+    void Device::updateBufferTileMappings(IBuffer* _buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+        Queue* queue = getQueue(executionQueue);
+
+        if (!queue)
+            return;
+
+        for (uint32_t n = 0; n < numTileMappings; ++n)
+        {
+            const BufferTilesMapping& mapping = tileMappings[n];
+            ID3D12Heap* heap = mapping.heap ? checked_cast<Heap*>(mapping.heap)->heap.Get() : nullptr;
+
+            D3D12_TILED_RESOURCE_COORDINATE resourceCoordinate = {};
+            resourceCoordinate.X = UINT(mapping.bufferOffset / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+            D3D12_TILE_REGION_SIZE regionSize = {};
+            regionSize.NumTiles = UINT(mapping.byteSize / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+            const D3D12_TILE_RANGE_FLAGS rangeFlags = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+            const UINT heapStartOffset = heap ? UINT(mapping.heapOffset / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES) : 0;
+
+            queue->queue->UpdateTileMappings(buffer->resource,
+                1, &resourceCoordinate, &regionSize,
+                heap,
+                1, &rangeFlags, &heapStartOffset, &regionSize.NumTiles,
+                D3D12_TILE_MAPPING_FLAG_NONE);
+        }
+    }
+
     nvrhi::BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object _buffer, const BufferDesc& desc)
     {
         if (_buffer.pointer == nullptr)
@@ -477,7 +585,9 @@ namespace nvrhi::d3d12
 
             m_Instance->referencedResources.push_back(buffer);
 
+            suspendPredication();
             m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, destOffsetBytes, uploadBuffer, offsetInUploadBuffer, dataSize);
+            resumePredication();
         }
     }
 
@@ -0,0 +1,116 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::d3d12
+{
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (!desc.framebuffer)
+        {
+            m_Context.error("Cannot create a command bundle without a framebuffer");
+            return nullptr;
+        }
+
+        const CommandListParameters params = CommandListParameters()
+            .setQueueType(CommandQueue::Graphics);
+
+        RefCountPtr<CommandList> commandList = RefCountPtr<CommandList>::Create(new CommandList(this, m_Context, m_Resources, params, true));
+        
+        CommandBundle* bundle = new CommandBundle(desc, commandList);
+        return CommandBundleHandle::Create(bundle);
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+        const CommandList* bundleList = bundle->commandList;
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(bundle->desc.framebuffer.Get());
+
+        // Bundles cannot place barriers, so transition everything that the bundle uses here
+        if (m_EnableAutomaticBarriers)
+        {
+            const BundleStateRequirements& states = bundleList->getBundleStates();
+
+            for (const auto& texture : states.getTextures())
+                requireTextureState(texture.texture, texture.subresources, texture.state);
+
+            for (const auto& buffer : states.getBuffers())
+                requireBufferState(buffer.buffer, buffer.state);
+        }
+
+        // The resources of the bundle must be resident whether or not this command list places their barriers
+        if (m_Resources.residencyManager)
+        {
+            bundleList->getResidencyObjects().forEach([this](ResidencyObject* residency, bool)
+            {
+                m_ResidencyObjects[residency] = true;
+            });
+        }
+
+        unbindShadingRateState();
+
+        bindFramebuffer(framebuffer);
+        commitBarriersInsideRenderPass();
+
+        commitDescriptorHeaps();
+
+        if ((bundleList->getBundleHeapSRVetc() && bundleList->getBundleHeapSRVetc() != m_CurrentHeapSRVetc) ||
+            (bundleList->getBundleHeapSamplers() && bundleList->getBundleHeapSamplers() != m_CurrentHeapSamplers))
+        {
+            m_Context.error("The descriptor heaps have been resized since the command bundle was recorded, "
+                "the bundle must be recorded again");
+            return;
+        }
+
+        const DX12_ViewportState& vpState = bundleList->getBundleViewportState();
+
+        if (vpState.numViewports)
+        {
+            m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+        }
+
+        if (vpState.numScissorRects)
+        {
+            m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+        }
+
+        m_ActiveCommandList->commandList->ExecuteBundle(bundleList->getD3D12GraphicsCommandList());
+
+        m_Instance->referencedResources.push_back(bundle);
+        m_Instance->referencedResources.push_back(framebuffer);
+
+        // The pipeline, root signature and input assembler state set by the bundle remain set on the command list,
+        // so the next set[...]State call must bind everything again
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
+        m_CurrentGraphicsVolatileCBs.resize(0);
+        m_CurrentComputeVolatileCBs.resize(0);
+    }
+
+} // namespace nvrhi::d3d12
@@ -28,15 +28,16 @@
 
 namespace nvrhi::d3d12
 {
-    CommandList::CommandList(Device* device, const Context& context, DeviceResources& resources, const CommandListParameters& params)
+    CommandList::CommandList(Device* device, const Context& context, DeviceResources& resources, const CommandListParameters& params, bool isBundle)
         : m_Context(context)
         , m_Resources(resources)
         , m_Device(device)
         , m_Queue(device->getQueue(params.queueType))
-        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false)
-        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true)
+        , m_UploadManager(context, m_Queue, device->getUploadChunkPool(), params.uploadChunkSize, 0, false)
+        , m_DxrScratchManager(context, m_Queue, nullptr, params.scratchChunkSize, params.scratchMaxMemory, true)
         , m_StateTracker(context.messageCallback)
         , m_Desc(params)
+        , m_IsBundle(isBundle)
     {
     }
     
@@ -72,7 +73,7 @@ namespace nvrhi::d3d12
         switch (m_Desc.queueType)
         {
         case CommandQueue::Graphics:
-            d3dCommandListType = D3D12_COMMAND_LIST_TYPE_DIRECT;
+            d3dCommandListType = m_IsBundle ? D3D12_COMMAND_LIST_TYPE_BUNDLE : D3D12_COMMAND_LIST_TYPE_DIRECT;
             break;
         case CommandQueue::Compute:
             d3dCommandListType = D3D12_COMMAND_LIST_TYPE_COMPUTE;
@@ -88,10 +89,17 @@ namespace nvrhi::d3d12
         }
 
         m_Context.device->CreateCommandAllocator(d3dCommandListType, IID_PPV_ARGS(&commandList->allocator));
-        m_Context.device->CreateCommandList(0, d3dCommandListType, commandList->allocator, nullptr, IID_PPV_ARGS(&commandList->commandList));
+        m_Context.device->CreateCommandList(m_Context.nodeMask, d3dCommandListType, commandList->allocator, nullptr, IID_PPV_ARGS(&commandList->commandList));
 
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList4));
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList6));
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (m_Context.enhancedBarriersEnabled)
+            commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList7));
+#endif
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList10));
+#endif
 
         return commandList;
     }
@@ -153,10 +161,24 @@ namespace nvrhi::d3d12
     void CommandList::beginMarker(const char* name)
     {
         PIXBeginEvent(m_ActiveCommandList->commandList, 0, name);
+
+        const GpuProfilerRecording::Query query = m_ProfilerRecording.beginScope(name);
+        if (query.index >= 0)
+        {
+            GpuProfiler* profiler = checked_cast<GpuProfiler*>(m_ProfilerRecording.getProfiler());
+            m_ActiveCommandList->commandList->EndQuery(profiler->queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, uint32_t(query.index));
+        }
     }
 
     void CommandList::endMarker()
     {
+        const GpuProfilerRecording::Query query = m_ProfilerRecording.endScope();
+        if (query.index >= 0)
+        {
+            GpuProfiler* profiler = checked_cast<GpuProfiler*>(m_ProfilerRecording.getProfiler());
+            m_ActiveCommandList->commandList->EndQuery(profiler->queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, uint32_t(query.index));
+        }
+
         PIXEndEvent(m_ActiveCommandList->commandList);
     }
 
@@ -189,6 +211,12 @@ namespace nvrhi::d3d12
             rootsig = pso->rootSignature;
             isGraphics = true;
         }
+        else if (m_CurrentWorkGraphStateValid && m_CurrentWorkGraphState.workGraph)
+        {
+            WorkGraph* workGraph = checked_cast<WorkGraph*>(m_CurrentWorkGraphState.workGraph);
+            rootsig = workGraph->rootSignature;
+            isGraphics = false;
+        }
 
         if (!rootsig || !rootsig->pushConstantByteSize)
             return;
@@ -207,7 +235,20 @@ namespace nvrhi::d3d12
 
         std::shared_ptr<InternalCommandList> chunk;
 
-        if (!m_CommandListPool.empty())
+        if (m_IsBundle)
+        {
+            // Bundles are never submitted, and the application makes sure that the GPU is done with the previous recording
+            chunk = m_ActiveCommandList;
+            if (chunk)
+            {
+                chunk->allocator->Reset();
+                chunk->commandList->Reset(chunk->allocator, nullptr);
+            }
+
+            m_BundleStates.clear();
+            m_BundleViewportState = DX12_ViewportState();
+        }
+        else if (!m_CommandListPool.empty())
         {
             chunk = m_CommandListPool.front();
 
@@ -215,7 +256,7 @@ namespace nvrhi::d3d12
             {
                 chunk->allocator->Reset();
                 chunk->commandList->Reset(chunk->allocator, nullptr);
-                m_CommandListPool.pop_front();
+                m_CommandListPool.erase(m_CommandListPool.begin());
             }
             else
             {
@@ -223,19 +264,103 @@ namespace nvrhi::d3d12
             }
         }
 
+        uint32_t poolMisses = 0;
+
         if (chunk == nullptr)
         {
             chunk = createInternalCommandList();
+            poolMisses++;
         }
 
         m_ActiveCommandList = chunk;
 
-        m_Instance = std::make_shared<CommandListInstance>();
+        if (m_Instance)
+        {
+            // Opened again without executing, or a bundle
+            m_Instance->releaseReferences();
+        }
+        else if (!m_InstancePool.empty() && m_InstancePool.front().use_count() == 1)
+        {
+            // The queue has retired the instance. The acquire fence pairs with the release
+            // in the last shared_ptr decrement, after runGarbageCollection released the references.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            m_Instance = std::move(m_InstancePool.front());
+            m_InstancePool.erase(m_InstancePool.begin());
+        }
+        else
+        {
+            m_Instance = std::make_shared<CommandListInstance>();
+            poolMisses++;
+        }
+
+        m_Instance->submittedInstance = 0;
+        m_Instance->fence = nullptr;
         m_Instance->commandAllocator = m_ActiveCommandList->allocator;
         m_Instance->commandList = m_ActiveCommandList->commandList;
         m_Instance->commandQueue = m_Desc.queueType;
 
         m_RecordingVersion = MakeVersion(m_Queue->recordingInstance++, m_Desc.queueType, false);
+
+        m_ResidencyObjects.clear();
+
+        m_Statistics = CommandListStatistics();
+        m_UploadManager.resetStatistics();
+
+#ifndef NDEBUG
+        m_Statistics.recordingAllocations = poolMisses;
+        m_StorageCapacitiesAtOpen = getStorageCapacities();
+#else
+        (void)poolMisses;
+#endif
+    }
+
+#ifndef NDEBUG
+    std::array<size_t, 3> CommandList::getStorageCapacities() const
+    {
+        size_t commandListCapacity = m_D3DBarriers.capacity() + m_SplitBarriers.capacity()
+            + m_ResidencyObjects.capacity() + m_VolatileConstantBufferAddresses.capacity() + m_ShaderTableStates.capacity()
+            + m_CommandListPool.capacity() + m_InstancePool.capacity();
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        commandListCapacity += m_D3DTextureBarriers.capacity() + m_D3DBufferBarriers.capacity()
+            + m_SplitTextureBarriers.capacity() + m_SplitBufferBarriers.capacity();
+#endif
+
+        return { m_Instance ? m_Instance->getStorageCapacity() : 0, commandListCapacity, m_StateTracker.getStorageCapacity() };
+    }
+#endif
+
+    void CommandListInstance::releaseReferences()
+    {
+        referencedResources.clear();
+        referencedNativeResources.clear();
+        referencedStagingTextures.clear();
+        referencedStagingBuffers.clear();
+        referencedTimerQueries.clear();
+#ifdef NVRHI_WITH_RTXMU
+        rtxmuBuildIds.clear();
+        rtxmuCompactionIds.clear();
+#endif
+    }
+
+    bool CommandListInstance::releaseReferences(GarbageCollectionBudgetTracker& budget)
+    {
+        // Release the lists with the most expensive destructors first
+        if (!budget.release(referencedResources) ||
+            !budget.release(referencedStagingTextures) ||
+            !budget.release(referencedStagingBuffers) ||
+            !budget.release(referencedTimerQueries) ||
+            !budget.release(referencedNativeResources))
+            return false;
+
+        // Everything is released, finish the recording of referencedResources
+        releaseReferences();
+        return true;
+    }
+
+    size_t CommandListInstance::getStorageCapacity() const
+    {
+        return referencedResources.capacity() + referencedNativeResources.capacity() + referencedStagingTextures.capacity()
+            + referencedStagingBuffers.capacity() + referencedTimerQueries.capacity();
     }
 
     void CommandList::clearStateCache()
@@ -245,15 +370,20 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentHeapSRVetc = nullptr;
         m_CurrentHeapSamplers = nullptr;
         m_CurrentGraphicsVolatileCBs.resize(0);
         m_CurrentComputeVolatileCBs.resize(0);
         m_CurrentSinglePassStereoState = SinglePassStereoState();
+        m_RenderPassFramebuffer = nullptr;
+        m_RenderPassStarted = false;
     }
 
     void CommandList::clearState()
     {
+        suspendRenderPass();
+
         m_ActiveCommandList->commandList->ClearState(nullptr);
 
 #if NVRHI_D3D12_WITH_NVAPI
@@ -276,10 +406,16 @@ namespace nvrhi::d3d12
 
     void CommandList::close()
     {
+        suspendRenderPass();
+
+        endSplitBarriers(nullptr);
+
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
 
+        resolveProfilerQueries();
+
 #ifdef NVRHI_WITH_RTXMU
         if (!m_Instance->rtxmuBuildIds.empty())
         {
@@ -289,24 +425,51 @@ namespace nvrhi::d3d12
 
         m_ActiveCommandList->commandList->Close();
 
+        m_Statistics.uploadBytes = m_UploadManager.getSuballocatedBytes();
+        m_Statistics.uploadChunks = m_UploadManager.getAcquiredChunks();
+        m_Statistics.referencedResources = uint32_t(m_Instance->referencedResources.size() + m_Instance->referencedNativeResources.size()
+            + m_Instance->referencedStagingTextures.size() + m_Instance->referencedStagingBuffers.size() + m_Instance->referencedTimerQueries.size());
+
+#ifndef NDEBUG
+        const std::array<size_t, 3> capacities = getStorageCapacities();
+        for (size_t i = 0; i < capacities.size(); i++)
+        {
+            if (capacities[i] > m_StorageCapacitiesAtOpen[i])
+                m_Statistics.recordingAllocations++;
+        }
+#endif
+
+        if (m_IsBundle)
+        {
+            // The executing command list must use the same descriptor heaps
+            m_BundleHeapSRVetc = m_CurrentHeapSRVetc;
+            m_BundleHeapSamplers = m_CurrentHeapSamplers;
+        }
+
         clearStateCache();
 
         m_CurrentUploadBuffer = nullptr;
+        m_PredicationBuffer = nullptr;
         m_VolatileConstantBufferAddresses.clear();
         m_ShaderTableStates.clear();
+        m_WorkGraphBackingMemoryOwners.clear();
+
+        m_StateTracker.commandListClosed();
     }
 
-    std::shared_ptr<CommandListInstance> CommandList::executed(Queue* pQueue)
+    std::shared_ptr<CommandListInstance> CommandList::executed(Queue* pQueue, uint64_t submittedInstance)
     {
         std::shared_ptr<CommandListInstance> instance = m_Instance;
         instance->fence = pQueue->fence;
-        instance->submittedInstance = pQueue->lastSubmittedInstance;
+        instance->submittedInstance = submittedInstance;
         m_Instance.reset();
 
-        m_ActiveCommandList->lastSubmittedInstance = pQueue->lastSubmittedInstance;
+        m_ActiveCommandList->lastSubmittedInstance = submittedInstance;
         m_CommandListPool.push_back(m_ActiveCommandList);
         m_ActiveCommandList.reset();
 
+        m_InstancePool.push_back(instance);
+
         for (const auto& it : instance->referencedStagingTextures)
         {
             it->lastUseFence = pQueue->fence;
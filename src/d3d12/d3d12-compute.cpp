@@ -48,8 +48,9 @@ namespace nvrhi::d3d12
         D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
 
         desc.pRootSignature = pRS->handle;
+        desc.NodeMask = m_Context.nodeMask;
         Shader* shader = checked_cast<Shader*>(state.CS.Get());
-        desc.CS = { &shader->bytecode[0], shader->bytecode.size() };
+        desc.CS = shader->bytecode;
 
 #if NVRHI_D3D12_WITH_NVAPI
         if (!shader->extensions.empty())
@@ -67,6 +68,19 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        RefCountPtr<ID3D12PipelineLibrary1> library = getPipelineLibrary();
+        PipelineLibraryKey key;
+        if (library)
+        {
+            key.add(pRS->contentHash);
+            key.addBytecode(desc.CS);
+            key.add(desc.NodeMask);
+            key.add(desc.Flags);
+
+            if (SUCCEEDED(library->LoadComputePipeline(key.getName().c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+                return pipelineState;
+        }
+
         const HRESULT hr = m_Context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
 
         if (FAILED(hr))
@@ -75,12 +89,20 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        storeLibraryPipeline(library, key, pipelineState);
+
         return pipelineState;
     }
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
+
+        return createComputePipeline(desc, pRS);
+    }
+
+    ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc, RootSignature* pRS)
+    {
         RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS);
 
         if (pPSO == nullptr)
@@ -123,6 +145,7 @@ namespace nvrhi::d3d12
 
         if (updatePipeline)
         {
+            m_Statistics.pipelineBinds++;
             m_ActiveCommandList->commandList->SetPipelineState(pso->pipelineState);
             
             m_Instance->referencedResources.push_back(pso);
@@ -136,6 +159,7 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = true;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentComputeState = state;
         
         commitBarriers();
@@ -166,6 +190,7 @@ namespace nvrhi::d3d12
     {
         updateComputeVolatileBuffers();
 
+        m_Statistics.dispatchCalls++;
         m_ActiveCommandList->commandList->Dispatch(groupsX, groupsY, groupsZ);
     }
 
@@ -178,6 +203,7 @@ namespace nvrhi::d3d12
 
         updateComputeVolatileBuffers();
 
+        m_Statistics.dispatchCalls++;
         // [rlaw]: added indirect count params
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchIndirectSignature, 1, indirectParams->resource, offsetBytes, indirectCountBuffer ? indirectCountBuffer->resource : nullptr, 0);
     }
@@ -267,10 +267,162 @@ namespace nvrhi::d3d12
         if ((stateBits & ResourceStates::ShadingRateSurface) != 0) result |= D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE;
         if ((stateBits & ResourceStates::OpacityMicromapBuildInput) != 0) result |= D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
         if ((stateBits & ResourceStates::OpacityMicromapWrite) != 0) result |= D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
+        if ((stateBits & ResourceStates::Predication) != 0) result |= D3D12_RESOURCE_STATE_PREDICATION;
 
         return result;
     }
 
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+    struct EnhancedBarrierStateMapping
+    {
+        ResourceStates nvrhiState;
+        D3D12_BARRIER_SYNC sync;
+        D3D12_BARRIER_ACCESS access;
+        D3D12_BARRIER_LAYOUT layout;
+    };
+
+    static const EnhancedBarrierStateMapping g_EnhancedBarrierStateMap[] =
+    {
+        { ResourceStates::Common,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_COMMON,
+            D3D12_BARRIER_LAYOUT_COMMON },
+        { ResourceStates::ConstantBuffer,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_CONSTANT_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::VertexBuffer,
+            D3D12_BARRIER_SYNC_VERTEX_SHADING,
+            D3D12_BARRIER_ACCESS_VERTEX_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::IndexBuffer,
+            D3D12_BARRIER_SYNC_INDEX_INPUT,
+            D3D12_BARRIER_ACCESS_INDEX_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::IndirectArgument,
+            D3D12_BARRIER_SYNC_EXECUTE_INDIRECT,
+            D3D12_BARRIER_ACCESS_INDIRECT_ARGUMENT,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ShaderResource,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_SHADER_RESOURCE },
+        { ResourceStates::UnorderedAccess,
+            D3D12_BARRIER_SYNC_ALL_SHADING | D3D12_BARRIER_SYNC_CLEAR_UNORDERED_ACCESS_VIEW,
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+            D3D12_BARRIER_LAYOUT_UNORDERED_ACCESS },
+        { ResourceStates::RenderTarget,
+            D3D12_BARRIER_SYNC_RENDER_TARGET,
+            D3D12_BARRIER_ACCESS_RENDER_TARGET,
+            D3D12_BARRIER_LAYOUT_RENDER_TARGET },
+        { ResourceStates::DepthWrite,
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL,
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE,
+            D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE },
+        { ResourceStates::DepthRead,
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL,
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ,
+            D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ },
+        { ResourceStates::StreamOut,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_STREAM_OUTPUT,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::CopyDest,
+            D3D12_BARRIER_SYNC_COPY,
+            D3D12_BARRIER_ACCESS_COPY_DEST,
+            D3D12_BARRIER_LAYOUT_COPY_DEST },
+        { ResourceStates::CopySource,
+            D3D12_BARRIER_SYNC_COPY,
+            D3D12_BARRIER_ACCESS_COPY_SOURCE,
+            D3D12_BARRIER_LAYOUT_COPY_SOURCE },
+        { ResourceStates::ResolveDest,
+            D3D12_BARRIER_SYNC_RESOLVE,
+            D3D12_BARRIER_ACCESS_RESOLVE_DEST,
+            D3D12_BARRIER_LAYOUT_RESOLVE_DEST },
+        { ResourceStates::ResolveSource,
+            D3D12_BARRIER_SYNC_RESOLVE,
+            D3D12_BARRIER_ACCESS_RESOLVE_SOURCE,
+            D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE },
+        { ResourceStates::Present,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_COMMON,
+            D3D12_BARRIER_LAYOUT_PRESENT },
+        { ResourceStates::AccelStructRead,
+            D3D12_BARRIER_SYNC_RAYTRACING | D3D12_BARRIER_SYNC_ALL_SHADING | D3D12_BARRIER_SYNC_COPY_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructWrite,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE | D3D12_BARRIER_SYNC_COPY_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructBuildInput,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructBuildBlas,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ShadingRateSurface,
+            D3D12_BARRIER_SYNC_PIXEL_SHADING,
+            D3D12_BARRIER_ACCESS_SHADING_RATE_SOURCE,
+            D3D12_BARRIER_LAYOUT_SHADING_RATE_SOURCE },
+        { ResourceStates::OpacityMicromapWrite,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::OpacityMicromapBuildInput,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::Predication,
+            D3D12_BARRIER_SYNC_PREDICATION,
+            D3D12_BARRIER_ACCESS_PREDICATION,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+    };
+
+    EnhancedBarrierState convertResourceStatesEnhanced(ResourceStates stateBits)
+    {
+        EnhancedBarrierState result;
+
+        bool layoutConflict = false;
+
+        for (const EnhancedBarrierStateMapping& mapping : g_EnhancedBarrierStateMap)
+        {
+            if ((stateBits & mapping.nvrhiState) == 0)
+                continue;
+
+            result.sync |= mapping.sync;
+            result.access |= mapping.access;
+
+            if (mapping.layout != D3D12_BARRIER_LAYOUT_UNDEFINED)
+            {
+                if (result.layout == D3D12_BARRIER_LAYOUT_UNDEFINED)
+                    result.layout = mapping.layout;
+                else if (result.layout != mapping.layout)
+                    layoutConflict = true;
+            }
+        }
+
+        if (layoutConflict)
+        {
+            // Same rules as the runtime uses for combined legacy states: depth-read supports shader resource access,
+            // other combinations of read states use the generic read layout.
+            result.layout = ((stateBits & ResourceStates::DepthRead) != 0)
+                ? D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ
+                : D3D12_BARRIER_LAYOUT_GENERIC_READ;
+        }
+
+        if (stateBits == ResourceStates::Unknown)
+        {
+            result.sync = D3D12_BARRIER_SYNC_ALL;
+            result.layout = D3D12_BARRIER_LAYOUT_COMMON;
+        }
+
+        return result;
+    }
+#endif
+
     D3D12_SHADING_RATE convertPixelShadingRate(VariableShadingRate shadingRate)
     {
         switch (shadingRate)
@@ -311,4 +463,22 @@ namespace nvrhi::d3d12
         }
     }
 
+    D3D12_RESIDENCY_PRIORITY convertResidencyPriority(ResidencyPriority priority)
+    {
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum:
+            return D3D12_RESIDENCY_PRIORITY_MINIMUM;
+        case ResidencyPriority::Low:
+            return D3D12_RESIDENCY_PRIORITY_LOW;
+        case ResidencyPriority::High:
+            return D3D12_RESIDENCY_PRIORITY_HIGH;
+        case ResidencyPriority::Maximum:
+            return D3D12_RESIDENCY_PRIORITY_MAXIMUM;
+        case ResidencyPriority::Normal:
+        default:
+            return D3D12_RESIDENCY_PRIORITY_NORMAL;
+        }
+    }
+
 } // namespace nvrhi::d3d12
@@ -22,12 +22,119 @@
 
 #include "d3d12-backend.h"
 
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace nvrhi::d3d12
 {
+    static uint32_t countTrailingZeros(uint64_t value)
+    {
+        assert(value != 0);
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return uint32_t(index);
+#else
+        return uint32_t(__builtin_ctzll(value));
+#endif
+    }
+
+    // Per-thread caches of single descriptors, so that the common allocateDescriptor / releaseDescriptor calls
+    // don't need to take the heap mutex. Cache entries refer to heaps by a unique ID rather than by pointer;
+    // the registry maps live IDs to heaps so that a thread can return its cached descriptors when it exits
+    // or when it needs the cache slot for a different heap.
+
+    struct DescriptorHeapRegistry
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, StaticDescriptorHeap*> heaps;
+        std::atomic<uint64_t> nextHeapId = 1;
+    };
+
+    static DescriptorHeapRegistry& getDescriptorHeapRegistry()
+    {
+        static DescriptorHeapRegistry registry;
+        return registry;
+    }
+
+    class ThreadDescriptorCache
+    {
+    public:
+        static constexpr uint32_t c_NumEntries = 4; // enough for the RTV, DSV, SRV and sampler heaps of one device
+        static constexpr uint32_t c_Capacity = 32;
+        static constexpr uint32_t c_RefillCount = c_Capacity / 2;
+
+        struct Entry
+        {
+            uint64_t heapId = 0;
+            uint32_t count = 0;
+            DescriptorIndex indices[c_Capacity];
+        };
+
+        ~ThreadDescriptorCache()
+        {
+            for (Entry& entry : m_Entries)
+                flush(entry);
+        }
+
+        Entry& getEntry(uint64_t heapId)
+        {
+            for (Entry& entry : m_Entries)
+            {
+                if (entry.heapId == heapId)
+                    return entry;
+            }
+
+            // Replace the least recently acquired entry
+            Entry& entry = m_Entries[m_NextVictim];
+            m_NextVictim = (m_NextVictim + 1) % c_NumEntries;
+
+            flush(entry);
+            entry.heapId = heapId;
+            return entry;
+        }
+
+    private:
+        Entry m_Entries[c_NumEntries];
+        uint32_t m_NextVictim = 0;
+
+        static void flush(Entry& entry)
+        {
+            if (entry.count == 0)
+                return;
+
+            DescriptorHeapRegistry& registry = getDescriptorHeapRegistry();
+            std::lock_guard lockGuard(registry.mutex);
+
+            // The heap might be gone already, then the descriptors went away together with it
+            auto it = registry.heaps.find(entry.heapId);
+            if (it != registry.heaps.end())
+                it->second->releaseCachedDescriptors(entry.indices, entry.count);
+
+            entry.count = 0;
+        }
+    };
+
+    static thread_local ThreadDescriptorCache t_DescriptorCache;
     
     StaticDescriptorHeap::StaticDescriptorHeap(const Context& context)
         : m_Context(context)
     {
+        DescriptorHeapRegistry& registry = getDescriptorHeapRegistry();
+        m_HeapId = registry.nextHeapId++;
+
+        std::lock_guard lockGuard(registry.mutex);
+        registry.heaps[m_HeapId] = this;
+    }
+
+    StaticDescriptorHeap::~StaticDescriptorHeap()
+    {
+        DescriptorHeapRegistry& registry = getDescriptorHeapRegistry();
+        std::lock_guard lockGuard(registry.mutex);
+        registry.heaps.erase(m_HeapId);
     }
     
     HRESULT StaticDescriptorHeap::allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible)
@@ -39,6 +146,7 @@ namespace nvrhi::d3d12
         heapDesc.Type = heapType;
         heapDesc.NumDescriptors = numDescriptors;
         heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        heapDesc.NodeMask = m_Context.nodeMask;
 
         HRESULT hr = m_Context.device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_Heap));
 
@@ -58,15 +166,33 @@ namespace nvrhi::d3d12
             m_StartGpuHandleShaderVisible = m_ShaderVisibleHeap->GetGPUDescriptorHandleForHeapStart();
         }
 
+        resizeBitset(heapDesc.NumDescriptors);
+
         m_NumDescriptors = heapDesc.NumDescriptors;
         m_HeapType = heapDesc.Type;
         m_StartCpuHandle = m_Heap->GetCPUDescriptorHandleForHeapStart();
         m_Stride = m_Context.device->GetDescriptorHandleIncrementSize(heapDesc.Type);
-        m_AllocatedDescriptors.resize(m_NumDescriptors);
 
         return S_OK;
     }
 
+    void StaticDescriptorHeap::resizeBitset(uint32_t numDescriptors)
+    {
+        // Clear the padding bits of the old last word, they become real descriptors now
+        if (m_NumDescriptors % 64 != 0)
+        {
+            m_AllocatedBits.back() &= (1ull << (m_NumDescriptors % 64)) - 1;
+        }
+
+        m_AllocatedBits.resize((numDescriptors + 63) / 64, 0);
+
+        // Mark the bits past the end of the heap as allocated so that the searches never return them
+        if (numDescriptors % 64 != 0)
+        {
+            m_AllocatedBits.back() |= ~((1ull << (numDescriptors % 64)) - 1);
+        }
+    }
+
     static uint32_t nextPowerOf2(uint32_t v)
     {
         // https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
@@ -104,32 +230,120 @@ namespace nvrhi::d3d12
         return S_OK;
     }
 
-    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    void StaticDescriptorHeap::setBits(DescriptorIndex baseIndex, uint32_t count, bool value)
     {
-        std::lock_guard lockGuard(m_Mutex);
+        DescriptorIndex index = baseIndex;
+        const DescriptorIndex end = baseIndex + count;
 
-        DescriptorIndex foundIndex = 0;
-        uint32_t freeCount = 0;
-        bool found = false;
+        while (index < end)
+        {
+            const uint32_t bit = index % 64;
+            const uint32_t numBits = std::min(64 - bit, end - index);
+            const uint64_t mask = (numBits == 64) ? ~0ull : (((1ull << numBits) - 1) << bit);
+
+            if (value)
+                m_AllocatedBits[index / 64] |= mask;
+            else
+                m_AllocatedBits[index / 64] &= ~mask;
 
-        // Find a contiguous range of 'count' indices for which m_AllocatedDescriptors[index] is false
+            index += numBits;
+        }
+    }
+
+    DescriptorIndex StaticDescriptorHeap::findNextAllocated(DescriptorIndex start, DescriptorIndex limit) const
+    {
+        // Returns the index of the first allocated descriptor in [start, limit), or 'limit' if there is none
+        uint32_t word = start / 64;
+        uint64_t bits = m_AllocatedBits[word] & (~0ull << (start % 64));
 
-        for (DescriptorIndex index = m_SearchStart; index < m_NumDescriptors; index++)
+        while (true)
         {
-            if (m_AllocatedDescriptors[index])
-                freeCount = 0;
-            else
-                freeCount += 1;
+            if (bits)
+                return std::min(word * 64 + countTrailingZeros(bits), limit);
+
+            ++word;
+            if (word * 64 >= limit)
+                return limit;
+
+            bits = m_AllocatedBits[word];
+        }
+    }
+
+    DescriptorIndex StaticDescriptorHeap::findFreeRange(uint32_t count) const
+    {
+        // Find a contiguous range of 'count' clear bits, skipping fully allocated words at once
+        const uint32_t numWords = uint32_t(m_AllocatedBits.size());
+        DescriptorIndex index = m_SearchStart;
+
+        while (index + count <= m_NumDescriptors)
+        {
+            uint32_t word = index / 64;
+            uint64_t freeBits = ~m_AllocatedBits[word] & (~0ull << (index % 64));
 
-            if (freeCount >= count)
+            while (!freeBits)
             {
-                foundIndex = index - count + 1;
-                found = true;
-                break;
+                if (++word == numWords)
+                    return c_InvalidDescriptorIndex;
+
+                freeBits = ~m_AllocatedBits[word];
+            }
+
+            const DescriptorIndex rangeStart = word * 64 + countTrailingZeros(freeBits);
+            if (rangeStart + count > m_NumDescriptors)
+                return c_InvalidDescriptorIndex;
+
+            const DescriptorIndex rangeEnd = findNextAllocated(rangeStart, rangeStart + count);
+            if (rangeEnd == rangeStart + count)
+                return rangeStart;
+
+            index = rangeEnd + 1;
+        }
+
+        return c_InvalidDescriptorIndex;
+    }
+
+    void StaticDescriptorHeap::flushFreeRanges()
+    {
+        for (uint32_t size = 1; size <= c_MaxFreeListRangeSize; size++)
+        {
+            for (DescriptorIndex baseIndex : m_FreeRanges[size])
+            {
+                setBits(baseIndex, size, false);
+                m_SearchStart = std::min(m_SearchStart, baseIndex);
             }
+            m_FreeRanges[size].clear();
         }
 
-        if (!found)
+        m_NumFreeRangeDescriptors = 0;
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptorsLocked(uint32_t count)
+    {
+        if (count == 0)
+            return c_InvalidDescriptorIndex;
+
+        DescriptorIndex foundIndex = c_InvalidDescriptorIndex;
+
+        if (count <= c_MaxFreeListRangeSize && !m_FreeRanges[count].empty())
+        {
+            // Exact size match from a recently released range, the bits are still set
+            foundIndex = m_FreeRanges[count].back();
+            m_FreeRanges[count].pop_back();
+            m_NumFreeRangeDescriptors -= count;
+            m_NumAllocatedDescriptors += count;
+            return foundIndex;
+        }
+
+        foundIndex = findFreeRange(count);
+
+        if (foundIndex == c_InvalidDescriptorIndex && m_NumFreeRangeDescriptors != 0)
+        {
+            // Return the cached ranges to the bitset so that they can merge with their neighbors, and try again
+            flushFreeRanges();
+            foundIndex = findFreeRange(count);
+        }
+
+        if (foundIndex == c_InvalidDescriptorIndex)
         {
             foundIndex = m_NumDescriptors;
 
@@ -140,10 +354,7 @@ namespace nvrhi::d3d12
             }
         }
 
-        for (DescriptorIndex index = foundIndex; index < foundIndex + count; index++)
-        {
-            m_AllocatedDescriptors[index] = true;
-        }
+        setBits(foundIndex, count, true);
 
         m_NumAllocatedDescriptors += count;
 
@@ -151,41 +362,103 @@ namespace nvrhi::d3d12
         return foundIndex;
     }
 
-    DescriptorIndex StaticDescriptorHeap::allocateDescriptor()
-    {
-        return allocateDescriptors(1);
-    }
-
-    void StaticDescriptorHeap::releaseDescriptors(DescriptorIndex baseIndex, uint32_t count)
+    void StaticDescriptorHeap::releaseDescriptorsLocked(DescriptorIndex baseIndex, uint32_t count)
     {
-        std::lock_guard lockGuard(m_Mutex);
-
         if (count == 0)
             return;
 
+#ifdef _DEBUG
         for (DescriptorIndex index = baseIndex; index < baseIndex + count; index++)
         {
-#ifdef _DEBUG
-            if (!m_AllocatedDescriptors[index])
+            if ((m_AllocatedBits[index / 64] & (1ull << (index % 64))) == 0)
             {
                 m_Context.error("Attempted to release an un-allocated descriptor");
+                break;
             }
+        }
 #endif
 
-            m_AllocatedDescriptors[index] = false;
+        m_NumAllocatedDescriptors -= count;
+
+        if (count <= c_MaxFreeListRangeSize)
+        {
+            m_FreeRanges[count].push_back(baseIndex);
+            m_NumFreeRangeDescriptors += count;
+            return;
         }
 
-        m_NumAllocatedDescriptors -= count;
+        setBits(baseIndex, count, false);
 
         if (m_SearchStart > baseIndex)
             m_SearchStart = baseIndex;
     }
 
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return allocateDescriptorsLocked(count);
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptor()
+    {
+        ThreadDescriptorCache::Entry& entry = t_DescriptorCache.getEntry(m_HeapId);
+
+        if (entry.count == 0)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            // Refill the cache with a batch of single descriptors, so that the next allocations are lock-free.
+            // Don't take more than what's available though, to avoid growing the heap just to fill the cache.
+            const uint32_t available = m_NumDescriptors - m_NumAllocatedDescriptors;
+            const uint32_t refillCount = std::max(1u, std::min(ThreadDescriptorCache::c_RefillCount, available));
+
+            while (entry.count < refillCount)
+            {
+                const DescriptorIndex index = allocateDescriptorsLocked(1);
+                if (index == c_InvalidDescriptorIndex)
+                    break;
+
+                entry.indices[entry.count++] = index;
+            }
+
+            if (entry.count == 0)
+                return c_InvalidDescriptorIndex;
+        }
+
+        return entry.indices[--entry.count];
+    }
+
+    void StaticDescriptorHeap::releaseDescriptors(DescriptorIndex baseIndex, uint32_t count)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        releaseDescriptorsLocked(baseIndex, count);
+    }
+
     void StaticDescriptorHeap::releaseDescriptor(DescriptorIndex index)
     {
+        ThreadDescriptorCache::Entry& entry = t_DescriptorCache.getEntry(m_HeapId);
+
+        if (entry.count < ThreadDescriptorCache::c_Capacity)
+        {
+            entry.indices[entry.count++] = index;
+            return;
+        }
+
         releaseDescriptors(index, 1);
     }
 
+    void StaticDescriptorHeap::releaseCachedDescriptors(const DescriptorIndex* indices, uint32_t count)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            releaseDescriptorsLocked(indices[i], 1);
+        }
+    }
+
     D3D12_CPU_DESCRIPTOR_HANDLE StaticDescriptorHeap::getCpuHandle(DescriptorIndex index)
     {
         D3D12_CPU_DESCRIPTOR_HANDLE handle = m_StartCpuHandle;
@@ -23,11 +23,18 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include "../common/transient-resource-pool.h"
+#include "../common/readback-ring.h"
+#include "../common/binding-set-cache.h"
+#include "../common/mip-generator.h"
+#include "../common/streaming-uploader.h"
 
 #if NVRHI_D3D12_WITH_NVAPI
 #include <nvShaderExtnEnums.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 #include <iomanip>
 
@@ -46,10 +53,7 @@ namespace nvrhi::d3d12
             // If it's not, wait for it to finish using an event
             ResetEvent(event);
             fence->SetEventOnCompletion(value, event);
-			
-            // [rlaw]: add 1 second time out
-            const DWORD result = WaitForSingleObject(event, 1000);
-            assert(result == WAIT_OBJECT_0);
+            WaitForSingleObject(event, INFINITE);
         }
     }
 
@@ -60,6 +64,42 @@ namespace nvrhi::d3d12
         return DeviceHandle::Create(device);
     }
 
+    void queueWaitForCommandList(nvrhi::IDevice* waitDevice, CommandQueue waitQueue,
+        nvrhi::IDevice* executionDevice, CommandQueue executionQueue, uint64_t instance)
+    {
+        // Works through the validation and capture layers, which forward getNativeObject to the underlying device
+        Device* pWaitDevice = waitDevice ? static_cast<Device*>(waitDevice->getNativeObject(ObjectTypes::Nvrhi_D3D12_Device).pointer) : nullptr;
+        Device* pExecutionDevice = executionDevice ? static_cast<Device*>(executionDevice->getNativeObject(ObjectTypes::Nvrhi_D3D12_Device).pointer) : nullptr;
+
+        if (!pWaitDevice || !pExecutionDevice)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        Queue* pWaitQueue = pWaitDevice->getQueue(waitQueue);
+        Queue* pExecutionQueue = pExecutionDevice->getQueue(executionQueue);
+        assert(pWaitQueue && pExecutionQueue);
+        assert(instance <= pExecutionQueue->lastSubmittedInstance);
+
+        // Fences are shared between the nodes of a linked-adapter device
+        pWaitQueue->queue->Wait(pExecutionQueue->fence, instance);
+    }
+
+    bool setEventOnSubmissions(nvrhi::IDevice* device, const SubmissionPoint* submissions, size_t count,
+        bool waitAny, HANDLE event)
+    {
+        Device* pDevice = device ? static_cast<Device*>(device->getNativeObject(ObjectTypes::Nvrhi_D3D12_Device).pointer) : nullptr;
+
+        if (!pDevice)
+        {
+            utils::NotSupported();
+            return false;
+        }
+
+        return pDevice->setEventOnSubmissions(submissions, count, waitAny, event);
+    }
+
     DeviceResources::DeviceResources(const Context& context, const DeviceDesc& desc)
         : renderTargetViewHeap(context)
         , depthStencilViewHeap(context)
@@ -80,18 +120,52 @@ namespace nvrhi::d3d12
 
     uint64_t Queue::updateLastCompletedInstance()
     {
-        if (lastCompletedInstance < lastSubmittedInstance)
+        uint64_t completed = lastCompletedInstance.load(std::memory_order_acquire);
+        if (completed < lastSubmittedInstance.load(std::memory_order_acquire))
         {
-            lastCompletedInstance = fence->GetCompletedValue();
+            // Several threads may update this, keep the largest value
+            const uint64_t fenceValue = fence->GetCompletedValue();
+            while (completed < fenceValue && !lastCompletedInstance.compare_exchange_weak(completed, fenceValue, std::memory_order_acq_rel))
+            { }
+            completed = std::max(completed, fenceValue);
         }
-        return lastCompletedInstance;
+        return completed;
     }
 
     Device::Device(const DeviceDesc& desc)
         : m_Resources(m_Context, desc)
+        , m_UploadChunkPool(
+            [this](uint64_t size) { return createBufferChunk(m_Context, size, false, m_UploadChunkCount++); },
+            [this](CommandQueue queueType)
+            {
+                Queue* queue = getQueue(queueType);
+                return queue ? queue->updateLastCompletedInstance() : 0;
+            })
+        , m_SubmissionCallbacks(
+            [this](CompletedInstances& completed) { getCompletedInstances(completed); },
+            [this](const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+            {
+                size_t completedIndex = 0;
+                waitForSubmissions(submissions, count, true, timeout, completedIndex);
+            })
+        , m_AccelStructPool(this)
     {
         m_Context.device = desc.pDevice;
+        m_Context.device->QueryInterface(&m_Context.device1);
         m_Context.messageCallback = desc.errorCB;
+        m_Context.nodeMask = desc.nodeMask;
+
+        {
+            // Find the DXGI adapter for the device to query its memory budget
+            RefCountPtr<IDXGIFactory4> factory;
+            if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))))
+            {
+                factory->EnumAdapterByLuid(m_Context.device->GetAdapterLuid(), IID_PPV_ARGS(&m_Context.adapter));
+            }
+        }
+
+        if (desc.enableResidencyManager)
+            m_Resources.residencyManager = std::make_unique<ResidencyManager>(m_Context);
 
         if (desc.pGraphicsCommandQueue)
             m_Queues[int(CommandQueue::Graphics)] = std::make_unique<Queue>(m_Context, desc.pGraphicsCommandQueue);
@@ -115,6 +189,15 @@ namespace nvrhi::d3d12
             m_RayTracingSupported = m_Options5.RaytracingTier >= D3D12_RAYTRACING_TIER_1_0;
             m_TraceRayInlineSupported = m_Options5.RaytracingTier >= D3D12_RAYTRACING_TIER_1_1;
 
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP && !defined(NVRHI_WITH_RTXMU)
+            // RTXMU does not support OMMs, otherwise prefer the core DXR 1.2 path over NVAPI
+            if (m_Options5.RaytracingTier >= D3D12_RAYTRACING_TIER_1_2)
+            {
+                m_Context.nativeOpacityMicromapsEnabled = true;
+                m_OpacityMicromapSupported = true;
+            }
+#endif
+
 #ifdef NVRHI_WITH_RTXMU
             if (m_RayTracingSupported)
             {
@@ -131,16 +214,65 @@ namespace nvrhi::d3d12
             m_MeshletsSupported = m_Options7.MeshShaderTier >= D3D12_MESH_SHADER_TIER_1;
         }
 
+#if NVRHI_D3D12_WITH_SAMPLER_FEEDBACK
+        if (SUCCEEDED(m_Context.device->QueryInterface(&m_Context.device8)) && hasOptions7)
+        {
+            m_SamplerFeedbackSupported = m_Options7.SamplerFeedbackTier >= D3D12_SAMPLER_FEEDBACK_TIER_0_9;
+        }
+#endif
+
+#if NVRHI_D3D12_WITH_DIRECT_HEAP_INDEXING
+        D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { D3D_SHADER_MODEL_6_6 };
+        if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))))
+        {
+            m_HeapDirectlyIndexedSupported = shaderModel.HighestShaderModel >= D3D_SHADER_MODEL_6_6
+                && m_Options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_3;
+        }
+#endif
+
         if (hasOptions6)
         {
             m_VariableRateShadingSupported = m_Options6.VariableShadingRateTier >= D3D12_VARIABLE_SHADING_RATE_TIER_2;
         }
+
+#if NVRHI_D3D12_WITH_GPU_UPLOAD_HEAP
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS16 options16 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS16, &options16, sizeof(options16))))
+            {
+                m_GpuUploadHeapSupported = options16.GPUUploadHeapSupported != FALSE;
+            }
+        }
+#endif
+
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        if (m_Context.device5)
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS21 options21 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS21, &options21, sizeof(options21))))
+            {
+                m_WorkGraphsSupported = options21.WorkGraphsTier != D3D12_WORK_GRAPHS_TIER_NOT_SUPPORTED;
+            }
+        }
+#endif
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (desc.enableEnhancedBarriers)
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options12, sizeof(options12))))
+            {
+                m_Context.enhancedBarriersEnabled = options12.EnhancedBarriersSupported != FALSE;
+            }
+        }
+#endif
         
         {
             D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
             D3D12_COMMAND_SIGNATURE_DESC csDesc = {};
             csDesc.NumArgumentDescs = 1;
             csDesc.pArgumentDescs = &argDesc;
+            csDesc.NodeMask = m_Context.nodeMask;
 
             csDesc.ByteStride = 16;
             argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
@@ -153,12 +285,17 @@ namespace nvrhi::d3d12
             csDesc.ByteStride = 12;
             argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
             m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchIndirectSignature));
+
+            if (m_MeshletsSupported)
+            {
+                csDesc.ByteStride = sizeof(D3D12_DISPATCH_MESH_ARGUMENTS);
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchMeshIndirectSignature));
+            }
         }
         
         m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
 
-        m_CommandListsToExecute.reserve(64);
-
 #if NVRHI_D3D12_WITH_NVAPI
         //We need to use NVAPI to set resource hints for SLI
         m_NvapiIsInitialized = NvAPI_Initialize() == NVAPI_OK;
@@ -192,14 +329,14 @@ namespace nvrhi::d3d12
 #ifdef NVRHI_WITH_RTXMU
         m_OpacityMicromapSupported = false; // RTXMU does not support OMMs
 #else
-        if (m_NvapiIsInitialized)
+        if (m_NvapiIsInitialized && !m_Context.nativeOpacityMicromapsEnabled)
         {
             NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_CAPS caps = NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_CAP_NONE;
             NvAPI_D3D12_GetRaytracingCaps(m_Context.device5, NVAPI_D3D12_RAYTRACING_CAPS_TYPE_OPACITY_MICROMAP, &caps, sizeof(NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_CAPS));
             m_OpacityMicromapSupported = caps == NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_CAP_STANDARD;
         }
 
-        if (m_OpacityMicromapSupported)
+        if (m_OpacityMicromapSupported && !m_Context.nativeOpacityMicromapsEnabled)
         {
             NVAPI_D3D12_SET_CREATE_PIPELINE_STATE_OPTIONS_PARAMS params = {};
             params.version = NVAPI_D3D12_SET_CREATE_PIPELINE_STATE_OPTIONS_PARAMS_VER;
@@ -216,6 +353,7 @@ namespace nvrhi::d3d12
     Device::~Device()
     {
         waitForIdle();
+        m_SubmissionCallbacks.shutdown();
 
         if (m_FenceEvent)
         {
@@ -250,8 +388,9 @@ namespace nvrhi::d3d12
         }
     }
     
-    Sampler::Sampler(const Context& context, const SamplerDesc& desc)
+    Sampler::Sampler(const Context& context, SamplerCache<Sampler>& cache, const SamplerDesc& desc)
         : m_Context(context)
+        , m_Cache(cache)
         , m_Desc(desc)
         , m_d3d12desc{}
     {
@@ -287,6 +426,11 @@ namespace nvrhi::d3d12
         m_d3d12desc.MaxLOD = D3D12_FLOAT32_MAX;
     }
     
+    Sampler::~Sampler()
+    {
+        m_Cache.remove(this);
+    }
+
     void Sampler::createDescriptor(size_t descriptor) const
     {
         m_Context.device->CreateSampler(&m_d3d12desc, { descriptor });
@@ -294,8 +438,13 @@ namespace nvrhi::d3d12
     
     SamplerHandle Device::createSampler(const SamplerDesc& d)
     {
-        Sampler* sampler = new Sampler(m_Context, d);
-        return SamplerHandle::Create(sampler);
+        if (SamplerHandle cachedSampler = m_SamplerCache.find(d))
+            return cachedSampler;
+
+        Sampler* sampler = new Sampler(m_Context, m_SamplerCache, d);
+
+        // Another thread could have created the same sampler in the meantime, then the cache returns that one
+        return m_SamplerCache.add(sampler);
     }
     
     GraphicsAPI Device::getGraphicsAPI()
@@ -327,22 +476,58 @@ namespace nvrhi::d3d12
     
     uint64_t Device::executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
     {
-        m_CommandListsToExecute.resize(numCommandLists);
+        // Scratch arrays, per thread so that submissions to different queues can run concurrently
+        thread_local std::vector<ID3D12CommandList*> t_CommandListsToExecute;
+        thread_local std::vector<ResidencyObject*> t_ResidencyObjectsToPrepare;
+
+        t_CommandListsToExecute.resize(numCommandLists);
         for (size_t i = 0; i < numCommandLists; i++)
         {
-            m_CommandListsToExecute[i] = checked_cast<CommandList*>(pCommandLists[i])->getD3D12CommandList();
+            t_CommandListsToExecute[i] = checked_cast<CommandList*>(pCommandLists[i])->getD3D12CommandList();
         }
 
         Queue* pQueue = getQueue(executionQueue);
 
-        pQueue->queue->ExecuteCommandLists(uint32_t(m_CommandListsToExecute.size()), m_CommandListsToExecute.data());
-        pQueue->lastSubmittedInstance++;
-        pQueue->queue->Signal(pQueue->fence, pQueue->lastSubmittedInstance);
+        if (m_Resources.residencyManager)
+        {
+            t_ResidencyObjectsToPrepare.clear();
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                checked_cast<CommandList*>(pCommandLists[i])->getResidencyObjects().forEach([](ResidencyObject* object, bool)
+                {
+                    t_ResidencyObjectsToPrepare.push_back(object);
+                });
+            }
+        }
 
-        for (size_t i = 0; i < numCommandLists; i++)
+        uint64_t submittedInstance;
         {
-            auto instance = checked_cast<CommandList*>(pCommandLists[i])->executed(pQueue);
-            pQueue->commandListsInFlight.push_front(instance);
+            std::lock_guard lockGuard(pQueue->submissionMutex);
+
+            submittedInstance = pQueue->lastSubmittedInstance.load(std::memory_order_relaxed) + 1;
+
+            if (m_Resources.residencyManager)
+            {
+                std::array<Queue*, size_t(CommandQueue::Count)> queues;
+                for (size_t i = 0; i < queues.size(); i++)
+                    queues[i] = m_Queues[i].get();
+
+                m_Resources.residencyManager->prepareSubmission(t_ResidencyObjectsToPrepare, executionQueue,
+                    submittedInstance, queues.data());
+            }
+
+            pQueue->queue->ExecuteCommandLists(uint32_t(t_CommandListsToExecute.size()), t_CommandListsToExecute.data());
+            pQueue->queue->Signal(pQueue->fence, submittedInstance);
+            pQueue->lastSubmittedInstance.store(submittedInstance, std::memory_order_release);
+
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+                pQueue->statistics += commandList->getStatistics();
+
+                auto instance = commandList->executed(pQueue, submittedInstance);
+                pQueue->commandListsInFlight.push_front(instance);
+            }
         }
 
         HRESULT hr = m_Context.device->GetDeviceRemovedReason();
@@ -351,7 +536,7 @@ namespace nvrhi::d3d12
             m_Context.messageCallback->message(MessageSeverity::Fatal, "Device Removed!");
         }
 
-        return pQueue->lastSubmittedInstance;
+        return submittedInstance;
     }
 
     void Device::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instanceID)
@@ -363,47 +548,538 @@ namespace nvrhi::d3d12
         pWaitQueue->queue->Wait(pExecutionQueue->fence, instanceID);
     }
 
+    void Device::getCompletedInstances(CompletedInstances& completed)
+    {
+        // Reads the fences directly, Queue::lastCompletedInstance is only updated on the submitting threads
+        for (size_t queueIndex = 0; queueIndex < completed.size(); queueIndex++)
+        {
+            const Queue* pQueue = m_Queues[queueIndex].get();
+            completed[queueIndex] = pQueue ? pQueue->fence->GetCompletedValue() : ~0ull;
+        }
+    }
+
+    uint64_t Device::getCompletedInstance(CommandQueue queue)
+    {
+        Queue* pQueue = queue < CommandQueue::Count ? getQueue(queue) : nullptr;
+
+        return pQueue ? pQueue->fence->GetCompletedValue() : 0;
+    }
+
+    bool Device::setEventOnSubmissions(const SubmissionPoint* submissions, size_t count, bool waitAny, HANDLE event)
+    {
+        std::vector<ID3D12Fence*> fences;
+        std::vector<UINT64> fenceValues;
+        fences.reserve(count);
+        fenceValues.reserve(count);
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const SubmissionPoint& submission = submissions[index];
+            Queue* pQueue = submission.queue < CommandQueue::Count ? getQueue(submission.queue) : nullptr;
+
+            if (!pQueue || submission.instance == 0)
+            {
+                // This submission counts as completed
+                if (waitAny)
+                    return SetEvent(event) != FALSE;
+                continue;
+            }
+
+            fences.push_back(pQueue->fence);
+            fenceValues.push_back(submission.instance);
+        }
+
+        if (fences.empty())
+            return SetEvent(event) != FALSE;
+
+        if (fences.size() == 1)
+            return SUCCEEDED(fences[0]->SetEventOnCompletion(fenceValues[0], event));
+
+        if (!m_Context.device1)
+        {
+            m_Context.error("Waiting for multiple submissions requires ID3D12Device1");
+            return false;
+        }
+
+        const D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags = waitAny
+            ? D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY
+            : D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL;
+
+        return SUCCEEDED(m_Context.device1->SetEventOnMultipleFenceCompletion(
+            fences.data(), fenceValues.data(), UINT(fences.size()), flags, event));
+    }
+
+    namespace
+    {
+        // An auto-reset event per thread for the submission waits, so that they can run concurrently
+        struct ThreadWaitEvent
+        {
+            HANDLE handle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+            ~ThreadWaitEvent() { if (handle) CloseHandle(handle); }
+        };
+
+        DWORD convertTimeoutToMilliseconds(uint64_t timeout)
+        {
+            if (timeout == c_InfiniteTimeout)
+                return INFINITE;
+
+            // Round up so that short timeouts still wait
+            const uint64_t milliseconds = timeout / 1'000'000 + (timeout % 1'000'000 != 0 ? 1 : 0);
+            return DWORD(std::min<uint64_t>(milliseconds, INFINITE - 1));
+        }
+    }
+
+    bool Device::waitForSubmissions(const SubmissionPoint* submissions, size_t count, bool waitAny, uint64_t timeout, size_t& outCompletedIndex)
+    {
+        if (count == 0)
+            return !waitAny;
+
+        static thread_local ThreadWaitEvent t_WaitEvent;
+        const auto startTime = std::chrono::steady_clock::now();
+
+        while (true)
+        {
+            // Completion is always checked on the fences: after a timeout, the event may stay registered
+            // with a fence and get signaled during a later wait on this thread.
+            CompletedInstances completed;
+            getCompletedInstances(completed);
+
+            if (waitAny)
+            {
+                outCompletedIndex = findCompletedSubmission(submissions, count, completed);
+                if (outCompletedIndex < count)
+                    return true;
+            }
+            else if (allSubmissionsCompleted(submissions, count, completed))
+                return true;
+
+            uint64_t remainingTime = c_InfiniteTimeout;
+            if (timeout != c_InfiniteTimeout)
+            {
+                const uint64_t elapsedTime = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - startTime).count());
+
+                if (elapsedTime >= timeout)
+                    return false;
+
+                remainingTime = timeout - elapsedTime;
+            }
+
+            if (!t_WaitEvent.handle || !setEventOnSubmissions(submissions, count, waitAny, t_WaitEvent.handle))
+                return false;
+
+            WaitForSingleObject(t_WaitEvent.handle, convertTimeoutToMilliseconds(remainingTime));
+        }
+    }
+
+    bool Device::waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        size_t completedIndex = 0;
+        return waitForSubmissions(submissions, count, false, timeout, completedIndex);
+    }
+
+    size_t Device::waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        size_t completedIndex = count;
+        if (!waitForSubmissions(submissions, count, true, timeout, completedIndex))
+            return count;
+
+        return completedIndex;
+    }
+
+    void Device::notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        m_SubmissionCallbacks.add(submissions, count, waitAny, std::move(callback));
+    }
+
     void Device::runGarbageCollection()
     {
+        runGarbageCollection(GarbageCollectionBudget());
+    }
+
+    bool Device::runGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        GarbageCollectionBudgetTracker budgetTracker(budget);
+        bool allRetired = true;
+
         for (const auto& pQueue : m_Queues)
         {
             if (!pQueue)
                 continue;
 
-            pQueue->updateLastCompletedInstance();
+            const uint64_t lastCompletedInstance = pQueue->updateLastCompletedInstance();
 
             // Starting from the back of the queue, i.e. oldest submitted command lists,
-            // see if those command lists have finished executing.
-            while (!pQueue->commandListsInFlight.empty())
+            // take the command lists that have finished executing. Their references are released
+            // without holding the submission lock, so that GC doesn't block submissions to the queue.
+            std::vector<std::shared_ptr<CommandListInstance>> completedInstances;
             {
-                std::shared_ptr<CommandListInstance> instance = pQueue->commandListsInFlight.back();
-                
-                if (pQueue->lastCompletedInstance >= instance->submittedInstance)
+                std::lock_guard lockGuard(pQueue->submissionMutex);
+
+                while (!pQueue->commandListsInFlight.empty() &&
+                    pQueue->commandListsInFlight.back()->submittedInstance <= lastCompletedInstance)
                 {
-#ifdef NVRHI_WITH_RTXMU
-                    if (!instance->rtxmuBuildIds.empty())
-                    {
-                        std::lock_guard lockGuard(m_Resources.asListMutex);
-
-                        m_Resources.asBuildsCompleted.insert(m_Resources.asBuildsCompleted.end(),
-                            instance->rtxmuBuildIds.begin(), instance->rtxmuBuildIds.end());
-
-                        instance->rtxmuBuildIds.clear();
-                    }
-                    if (!instance->rtxmuCompactionIds.empty())
-                    {
-                        m_Context.rtxMemUtil->GarbageCollection(instance->rtxmuCompactionIds);
-                        instance->rtxmuCompactionIds.clear();
-                    }
-#endif
+                    completedInstances.push_back(std::move(pQueue->commandListsInFlight.back()));
                     pQueue->commandListsInFlight.pop_back();
                 }
-                else
+            }
+
+            size_t numReleased = 0;
+            for (; numReleased < completedInstances.size(); numReleased++)
+            {
+                const std::shared_ptr<CommandListInstance>& instance = completedInstances[numReleased];
+
+#ifdef NVRHI_WITH_RTXMU
+                if (!instance->rtxmuBuildIds.empty())
+                {
+                    std::lock_guard lockGuard(m_Resources.asListMutex);
+
+                    m_Resources.asBuildsCompleted.insert(m_Resources.asBuildsCompleted.end(),
+                        instance->rtxmuBuildIds.begin(), instance->rtxmuBuildIds.end());
+
+                    instance->rtxmuBuildIds.clear();
+                }
+                if (!instance->rtxmuCompactionIds.empty())
+                {
+                    m_Context.rtxMemUtil->GarbageCollection(instance->rtxmuCompactionIds);
+                    instance->rtxmuCompactionIds.clear();
+                }
+#endif
+                // A partially released instance goes back to the back of the queue, the next call continues with it
+                if (!instance->releaseReferences(budgetTracker))
                 {
+                    allRetired = false;
                     break;
                 }
             }
+
+            if (numReleased < completedInstances.size())
+            {
+                // Everything submitted since then is newer, so the remaining instances are still the oldest ones
+                std::lock_guard lockGuard(pQueue->submissionMutex);
+
+                for (size_t index = completedInstances.size(); index > numReleased; index--)
+                    pQueue->commandListsInFlight.push_back(std::move(completedInstances[index - 1]));
+            }
+        }
+
+        m_UploadChunkPool.endFrame();
+
+        return allRetired;
+    }
+
+    void Device::setUploadPoolSettings(const UploadPoolSettings& settings)
+    {
+        m_UploadChunkPool.setSettings(settings);
+    }
+
+    UploadPoolStatistics Device::getUploadPoolStatistics()
+    {
+        return m_UploadChunkPool.getStatistics();
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(bool reset)
+    {
+        // The statistics are collected per queue, so that submissions to different queues don't share any state
+        CommandListStatistics statistics;
+        for (const auto& pQueue : m_Queues)
+        {
+            if (!pQueue)
+                continue;
+
+            std::lock_guard lockGuard(pQueue->submissionMutex);
+            statistics += pQueue->statistics;
+            if (reset)
+                pQueue->statistics = CommandListStatistics();
+        }
+        return statistics;
+    }
+
+    // The root signatures for raster and compute pipelines are looked up on the calling thread,
+    // which keeps cache lookups on the application threads; only the PSO compilation runs in the task.
+    // The tasks hold a reference to the device, because they may be joined after the application has released it.
+
+    PipelineCreationTaskHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+        {
+            m_Context.error("createGraphicsPipelineAsync: the framebuffer is NULL");
+            return PipelineCreationTask::createCompleted(GraphicsPipelineHandle());
+        }
+
+        RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, desc.inputLayout != nullptr);
+        if (!pRS)
+            return PipelineCreationTask::createCompleted(GraphicsPipelineHandle());
+
+        const FramebufferInfo framebufferInfo = fb->getFramebufferInfo();
+
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc, pRS, framebufferInfo](PipelineCreationTask& task)
+        {
+            RefCountPtr<ID3D12PipelineState> pPSO = device->createPipelineState(desc, pRS, framebufferInfo);
+            task.setResult(device->createHandleForNativeGraphicsPipeline(pRS, pPSO, desc, framebufferInfo));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    PipelineCreationTaskHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc)
+    {
+        RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
+        if (!pRS)
+            return PipelineCreationTask::createCompleted(ComputePipelineHandle());
+
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc, pRS](PipelineCreationTask& task)
+        {
+            task.setResult(device->createComputePipeline(desc, pRS));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    PipelineCreationTaskHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+        {
+            m_Context.error("createMeshletPipelineAsync: the framebuffer is NULL");
+            return PipelineCreationTask::createCompleted(MeshletPipelineHandle());
+        }
+
+        RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
+        if (!pRS)
+            return PipelineCreationTask::createCompleted(MeshletPipelineHandle());
+
+        const FramebufferInfo framebufferInfo = fb->getFramebufferInfo();
+
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc, pRS, framebufferInfo](PipelineCreationTask& task)
+        {
+            RefCountPtr<ID3D12PipelineState> pPSO = device->createPipelineState(desc, pRS, framebufferInfo);
+            task.setResult(device->createHandleForNativeMeshletPipeline(pRS, pPSO, desc, framebufferInfo));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    PipelineCreationTaskHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc)
+    {
+        // Ray tracing pipelines build their own uncached root signatures
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc](PipelineCreationTask& task)
+        {
+            task.setResult(device->createRayTracingPipeline(desc));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    void PipelineLibraryKey::addInputLayout(const D3D12_INPUT_LAYOUT_DESC& inputLayout)
+    {
+        add(inputLayout.NumElements);
+        for (UINT i = 0; i < inputLayout.NumElements; i++)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& element = inputLayout.pInputElementDescs[i];
+            addBytes(element.SemanticName, strlen(element.SemanticName));
+            add(element.SemanticIndex);
+            add(element.Format);
+            add(element.InputSlot);
+            add(element.AlignedByteOffset);
+            add(element.InputSlotClass);
+            add(element.InstanceDataStepRate);
+        }
+    }
+
+    void PipelineLibraryKey::addStreamOutput(const D3D12_STREAM_OUTPUT_DESC& streamOutput)
+    {
+        add(streamOutput.NumEntries);
+        for (UINT i = 0; i < streamOutput.NumEntries; i++)
+        {
+            const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+            add(entry.Stream);
+            // Gap entries have no semantic name
+            if (entry.SemanticName)
+                addBytes(entry.SemanticName, strlen(entry.SemanticName));
+            else
+                add(size_t(0));
+            add(entry.SemanticIndex);
+            add(entry.StartComponent);
+            add(entry.ComponentCount);
+            add(entry.OutputSlot);
+        }
+        addBytes(streamOutput.pBufferStrides, streamOutput.NumStrides * sizeof(UINT));
+        add(streamOutput.RasterizedStream);
+    }
+
+    std::wstring PipelineLibraryKey::getName() const
+    {
+        std::wstringstream ss;
+        ss << L"nvrhi_" << std::hex << std::setw(16) << std::setfill(L'0') << m_Hash;
+        return ss.str();
+    }
+
+    static PipelineCacheIdentity getPipelineCacheIdentity()
+    {
+        // The pipeline library blob is validated against the adapter and driver by the D3D12 runtime,
+        // so the NVRHI header only needs to reject blobs from other APIs and NVRHI versions.
+        PipelineCacheIdentity identity;
+        identity.graphicsAPI = GraphicsAPI::D3D12;
+        return identity;
+    }
+
+    // The pipeline cache payload holds the serialized pipeline library followed by the serialized root signatures:
+    // [uint64 library size][library][uint32 root signature count]([uint64 desc hash][uint64 blob size][blob])...
+    static bool parsePipelineCachePayload(const uint8_t* payload, size_t payloadSize,
+        std::vector<uint8_t>& outLibraryData, std::unordered_map<uint64_t, std::vector<uint8_t>>& outRootSignatureBlobs)
+    {
+        size_t offset = 0;
+        auto read = [payload, payloadSize, &offset](void* dst, size_t size)
+        {
+            if (payloadSize - offset < size)
+                return false;
+            memcpy(dst, payload + offset, size);
+            offset += size;
+            return true;
+        };
+
+        uint64_t librarySize = 0;
+        if (!read(&librarySize, sizeof(librarySize)) || payloadSize - offset < librarySize)
+            return false;
+        outLibraryData.assign(payload + offset, payload + offset + librarySize);
+        offset += size_t(librarySize);
+
+        uint32_t numRootSignatures = 0;
+        if (!read(&numRootSignatures, sizeof(numRootSignatures)))
+            return false;
+
+        for (uint32_t index = 0; index < numRootSignatures; index++)
+        {
+            uint64_t descHash = 0;
+            uint64_t blobSize = 0;
+            if (!read(&descHash, sizeof(descHash)) || !read(&blobSize, sizeof(blobSize)) || payloadSize - offset < blobSize)
+                return false;
+
+            outRootSignatureBlobs[descHash].assign(payload + offset, payload + offset + blobSize);
+            offset += size_t(blobSize);
+        }
+
+        return offset == payloadSize;
+    }
+
+    bool Device::loadPipelineCache(const void* data, size_t size)
+    {
+        std::vector<uint8_t> libraryData;
+        std::unordered_map<uint64_t, std::vector<uint8_t>> rootSignatureBlobs;
+        bool accepted = true;
+        if (data && size)
+        {
+            const void* payload = nullptr;
+            size_t payloadSize = 0;
+            accepted = readPipelineCacheBlob(getPipelineCacheIdentity(), data, size, payload, payloadSize) &&
+                parsePipelineCachePayload(static_cast<const uint8_t*>(payload), payloadSize, libraryData, rootSignatureBlobs);
+
+            if (!accepted)
+            {
+                libraryData.clear();
+                rootSignatureBlobs.clear();
+                m_Context.messageCallback->message(MessageSeverity::Warning, "The pipeline cache data is corrupted or was created by a different version of NVRHI, ignoring it");
+            }
+        }
+
+        // Root signature blobs don't depend on pipeline library support
+        {
+            std::unique_lock lock(m_RootSignatureBlobsMutex);
+            m_RootSignatureBlobs = std::move(rootSignatureBlobs);
+        }
+
+        D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+        if (FAILED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache))) ||
+            (shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) == 0)
+        {
+            return false;
+        }
+
+        RefCountPtr<ID3D12Device1> device1;
+        if (FAILED(m_Context.device->QueryInterface(IID_PPV_ARGS(&device1))))
+            return false;
+
+        RefCountPtr<ID3D12PipelineLibrary1> library;
+        HRESULT hr = device1->CreatePipelineLibrary(libraryData.data(), libraryData.size(), IID_PPV_ARGS(&library));
+
+        if (FAILED(hr) && !libraryData.empty())
+        {
+            // D3D12_ERROR_ADAPTER_NOT_FOUND or D3D12_ERROR_DRIVER_VERSION_MISMATCH: the blob is stale, start over
+            accepted = false;
+            libraryData.clear();
+            hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library));
+        }
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "CreatePipelineLibrary call failed, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        std::lock_guard lockGuard(m_PipelineLibraryMutex);
+
+        // Release the previous library before the data it references
+        m_PipelineLibrary = library;
+        m_PipelineLibraryData = std::move(libraryData);
+
+        return accepted;
+    }
+
+    bool Device::savePipelineCache(std::vector<uint8_t>& outData)
+    {
+        outData.clear();
+
+        std::vector<uint8_t> payload;
+        auto write = [&payload](const void* src, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(src);
+            payload.insert(payload.end(), bytes, bytes + size);
+        };
+
+        RefCountPtr<ID3D12PipelineLibrary1> library = getPipelineLibrary();
+        const uint64_t librarySize = library ? uint64_t(library->GetSerializedSize()) : 0;
+        write(&librarySize, sizeof(librarySize));
+
+        if (librarySize)
+        {
+            payload.resize(payload.size() + size_t(librarySize));
+            if (FAILED(library->Serialize(payload.data() + sizeof(librarySize), size_t(librarySize))))
+                return false;
+        }
+
+        {
+            std::shared_lock lock(m_RootSignatureBlobsMutex);
+
+            if (!library && m_RootSignatureBlobs.empty())
+                return false;
+
+            const uint32_t numRootSignatures = uint32_t(m_RootSignatureBlobs.size());
+            write(&numRootSignatures, sizeof(numRootSignatures));
+
+            for (const auto& [descHash, blob] : m_RootSignatureBlobs)
+            {
+                const uint64_t blobSize = blob.size();
+                write(&descHash, sizeof(descHash));
+                write(&blobSize, sizeof(blobSize));
+                write(blob.data(), blob.size());
+            }
         }
+
+        writePipelineCacheBlob(getPipelineCacheIdentity(), payload.data(), payload.size(), outData);
+        return true;
+    }
+
+    RefCountPtr<ID3D12PipelineLibrary1> Device::getPipelineLibrary() const
+    {
+        std::lock_guard lockGuard(m_PipelineLibraryMutex);
+        return m_PipelineLibrary;
+    }
+
+    void Device::storeLibraryPipeline(ID3D12PipelineLibrary1* library, const PipelineLibraryKey& key, ID3D12PipelineState* pipelineState) const
+    {
+        if (!library || !pipelineState)
+            return;
+
+        // StorePipeline fails with E_INVALIDARG if another thread has stored the same pipeline first, which is fine
+        (void)library->StorePipeline(key.getName().c_str(), pipelineState);
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -450,6 +1126,23 @@ namespace nvrhi::d3d12
             return true;
         case Feature::ConstantBufferRanges:
             return true;
+        case Feature::DrawIndirectCount:
+            return true;
+        case Feature::TiledResources:
+            return m_Options.TiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_2;
+        case Feature::SamplerFeedback:
+            return m_SamplerFeedbackSupported;
+        case Feature::HeapDirectlyIndexed:
+            return m_HeapDirectlyIndexedSupported;
+        case Feature::DeviceLocalUploadHeap:
+            return m_GpuUploadHeapSupported;
+        case Feature::WorkGraphs:
+            return m_WorkGraphsSupported;
+        case Feature::OcclusionQueries:
+        case Feature::PipelineStatisticsQueries:
+        case Feature::Predication:
+        case Feature::GpuVirtualAddress:
+            return true;
         default:
             return false;
         }
@@ -543,13 +1236,30 @@ namespace nvrhi::d3d12
         heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
         heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
         heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        heapDesc.Properties.CreationNodeMask = 1; // no mGPU support in nvrhi so far
-        heapDesc.Properties.VisibleNodeMask = 1;
+        heapDesc.Properties.CreationNodeMask = m_Context.nodeMask;
+        heapDesc.Properties.VisibleNodeMask = m_Context.getVisibleNodeMask(d.visibleNodeMask);
 
-        if (m_Options.ResourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1)
+        switch (d.category)
+        {
+        case HeapCategory::Any:
+            if (m_Options.ResourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1)
+                heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+            else
+                heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+            break;
+        case HeapCategory::Buffers:
+            heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            break;
+        case HeapCategory::Textures:
+            heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+            break;
+        case HeapCategory::RenderTargetTextures:
             heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
-        else
-            heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+            break;
+        default:
+            utils::InvalidEnum();
+            return nullptr;
+        }
 
         switch (d.type)
         {
@@ -589,7 +1299,37 @@ namespace nvrhi::d3d12
         Heap* heap = new Heap();
         heap->heap = d3dHeap;
         heap->desc = d;
+
+        if (m_Resources.residencyManager)
+            heap->residencyManager = m_Resources.residencyManager.get();
+        initResidency(heap->residency, heap->heap, d.capacity, d.residencyPriority, d.type == HeapType::DeviceLocal);
+
         return HeapHandle::Create(heap);
     }
 
+    TransientResourcePoolHandle Device::createTransientResourcePool(const TransientResourcePoolDesc& desc)
+    {
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(this, desc));
+    }
+
+    StreamingUploaderHandle Device::createStreamingUploader(const StreamingUploaderDesc& desc)
+    {
+        return StreamingUploaderHandle::Create(new StreamingUploader(this, desc));
+    }
+
+    ReadbackRingHandle Device::createReadbackRing(const ReadbackRingDesc& desc)
+    {
+        return ReadbackRing::create(this, desc);
+    }
+
+    BindingSetCacheHandle Device::createBindingSetCache()
+    {
+        return BindingSetCacheHandle::Create(new BindingSetCache(this));
+    }
+
+    MipGeneratorHandle Device::createMipGenerator()
+    {
+        return MipGenerator::create(this);
+    }
+
 } // namespace nvrhi::d3d12
@@ -51,22 +51,23 @@ namespace nvrhi::d3d12
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
         desc.pRootSignature = pRS->handle;
+        desc.NodeMask = m_Context.nodeMask;
 
         Shader* shader;
         shader = checked_cast<Shader*>(state.VS.Get());
-        if (shader) desc.VS = { &shader->bytecode[0], shader->bytecode.size() };
+        if (shader) desc.VS = shader->bytecode;
 
         shader = checked_cast<Shader*>(state.HS.Get());
-        if (shader) desc.HS = { &shader->bytecode[0], shader->bytecode.size() };
+        if (shader) desc.HS = shader->bytecode;
 
         shader = checked_cast<Shader*>(state.DS.Get());
-        if (shader) desc.DS = { &shader->bytecode[0], shader->bytecode.size() };
+        if (shader) desc.DS = shader->bytecode;
 
         shader = checked_cast<Shader*>(state.GS.Get());
-        if (shader) desc.GS = { &shader->bytecode[0], shader->bytecode.size() };
+        if (shader) desc.GS = shader->bytecode;
 
         shader = checked_cast<Shader*>(state.PS.Get());
-        if (shader) desc.PS = { &shader->bytecode[0], shader->bytecode.size() };
+        if (shader) desc.PS = shader->bytecode;
 
 
         TranslateBlendState(state.renderState.blendState, desc.BlendState);
@@ -163,6 +164,35 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        RefCountPtr<ID3D12PipelineLibrary1> library = getPipelineLibrary();
+        PipelineLibraryKey key;
+        if (library)
+        {
+            key.add(pRS->contentHash);
+            key.addBytecode(desc.VS);
+            key.addBytecode(desc.HS);
+            key.addBytecode(desc.DS);
+            key.addBytecode(desc.GS);
+            key.addBytecode(desc.PS);
+            key.addStreamOutput(desc.StreamOutput);
+            key.add(desc.BlendState);
+            key.add(desc.SampleMask);
+            key.add(desc.RasterizerState);
+            key.add(desc.DepthStencilState);
+            key.addInputLayout(desc.InputLayout);
+            key.add(desc.IBStripCutValue);
+            key.add(desc.PrimitiveTopologyType);
+            key.add(desc.NumRenderTargets);
+            key.add(desc.RTVFormats);
+            key.add(desc.DSVFormat);
+            key.add(desc.SampleDesc);
+            key.add(desc.NodeMask);
+            key.add(desc.Flags);
+
+            if (SUCCEEDED(library->LoadGraphicsPipeline(key.getName().c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+                return pipelineState;
+        }
+
         const HRESULT hr = m_Context.device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
 
         if (FAILED(hr))
@@ -171,6 +201,8 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        storeLibraryPipeline(library, key, pipelineState);
+
         return pipelineState;
     }
 
@@ -195,6 +227,7 @@ namespace nvrhi::d3d12
         GraphicsPipeline *pso = new GraphicsPipeline();
         pso->desc = desc;
         pso->framebufferInfo = framebufferInfo;
+        pso->framebufferInfoHash = std::hash<FramebufferInfo>()(framebufferInfo);
         pso->rootSignature = checked_cast<RootSignature*>(rootSignature);
         pso->pipelineState = pipelineState;
         pso->requiresBlendFactor = desc.renderState.blendState.usesConstantColor(uint32_t(pso->framebufferInfo.colorFormats.size()));
@@ -207,6 +240,7 @@ namespace nvrhi::d3d12
         Framebuffer *fb = new Framebuffer(m_Resources);
         fb->desc = desc;
         fb->framebufferInfo = FramebufferInfoEx(desc);
+        fb->framebufferInfoHash = std::hash<FramebufferInfo>()(fb->framebufferInfo);
 
         if (!desc.colorAttachments.empty())
         {
@@ -235,6 +269,12 @@ namespace nvrhi::d3d12
 
             fb->RTVs.push_back(index);
             fb->textures.push_back(texture);
+
+            if (attachment.storeOp == AttachmentStoreOp::Resolve && attachment.resolveTexture)
+                fb->textures.push_back(checked_cast<Texture*>(attachment.resolveTexture));
+
+            fb->useRenderPass = fb->useRenderPass || attachment.hasNonDefaultOps();
+            fb->discardsContents = fb->discardsContents || attachment.storeOp != AttachmentStoreOp::Store;
         }
 
         if (desc.depthAttachment.valid())
@@ -250,6 +290,13 @@ namespace nvrhi::d3d12
 
             fb->DSV = index;
             fb->textures.push_back(texture);
+
+            // Read-only depth attachments are never cleared or discarded
+            if (!desc.depthAttachment.isReadOnly)
+            {
+                fb->useRenderPass = fb->useRenderPass || desc.depthAttachment.hasNonDefaultOps();
+                fb->discardsContents = fb->discardsContents || desc.depthAttachment.storeOp != AttachmentStoreOp::Store;
+            }
         }
 
         return FramebufferHandle::Create(fb);
@@ -264,12 +311,70 @@ namespace nvrhi::d3d12
             m_Resources.depthStencilViewHeap.releaseDescriptor(DSV);
     }
     
+    static D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE convertBeginningAccess(AttachmentLoadOp loadOp)
+    {
+        switch (loadOp)
+        {
+        case AttachmentLoadOp::Load:
+            return D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_PRESERVE;
+        case AttachmentLoadOp::Clear:
+            return D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_CLEAR;
+        case AttachmentLoadOp::DontCare:
+            return D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_DISCARD;
+        default:
+            utils::InvalidEnum();
+            return D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_PRESERVE;
+        }
+    }
+
+    static D3D12_RENDER_PASS_ENDING_ACCESS_TYPE convertEndingAccess(AttachmentStoreOp storeOp)
+    {
+        switch (storeOp)
+        {
+        case AttachmentStoreOp::Store:
+            return D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_PRESERVE;
+        case AttachmentStoreOp::DontCare:
+            return D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_DISCARD;
+        case AttachmentStoreOp::Resolve:
+            return D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_RESOLVE;
+        default:
+            utils::InvalidEnum();
+            return D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_PRESERVE;
+        }
+    }
+    
     void CommandList::bindFramebuffer(Framebuffer *fb)
     {
+        // Bundles inherit the render targets of the command list that executes them, see executeBundle
+        if (m_IsBundle)
+            return;
+
         if (m_EnableAutomaticBarriers)
         {
             setResourceStatesForFramebuffer(fb);
+
+            for (const auto& attachment : fb->desc.colorAttachments)
+            {
+                if (attachment.storeOp == AttachmentStoreOp::Resolve && attachment.resolveTexture)
+                    requireTextureState(attachment.resolveTexture, attachment.resolveSubresources, ResourceStates::ResolveDest);
+            }
+        }
+
+        // Binding the framebuffer of the current render pass again, e.g. after a compute dispatch, resumes that render pass
+        if (fb == m_RenderPassFramebuffer)
+            return;
+
+        suspendRenderPass();
+
+        if (fb->useRenderPass)
+        {
+            // The render pass is begun after the barriers for its attachments are committed, see commitBarriersInsideRenderPass
+            m_RenderPassFramebuffer = fb;
+            m_RenderPassStarted = false;
+            return;
         }
+
+        m_RenderPassFramebuffer = nullptr;
         
         static_vector<D3D12_CPU_DESCRIPTOR_HANDLE, 16> RTVs;
         for (uint32_t rtIndex = 0; rtIndex < fb->RTVs.size(); rtIndex++)
@@ -284,6 +389,131 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->commandList->OMSetRenderTargets(UINT(RTVs.size()), RTVs.data(), false, fb->desc.depthAttachment.valid() ? &DSV : nullptr);
     }
 
+    void CommandList::beginRenderPass(Framebuffer* fb, bool resume)
+    {
+        if (resume && fb->discardsContents)
+        {
+            m_Context.warning("Resuming a render pass with attachments that use AttachmentStoreOp::DontCare or Resolve. "
+                "The render pass was suspended by a command that cannot be recorded inside it, "
+                "and the contents rendered before that command are undefined now.");
+        }
+
+        const FramebufferDesc& desc = fb->desc;
+
+        static_vector<D3D12_RENDER_PASS_RENDER_TARGET_DESC, c_MaxRenderTargets> renderTargets;
+        static_vector<D3D12_RENDER_PASS_ENDING_ACCESS_RESOLVE_SUBRESOURCE_PARAMETERS, c_MaxRenderTargets> resolveParameters;
+        resolveParameters.resize(desc.colorAttachments.size());
+
+        for (uint32_t i = 0; i < desc.colorAttachments.size(); i++)
+        {
+            const FramebufferAttachment& attachment = desc.colorAttachments[i];
+            const Texture* texture = checked_cast<Texture*>(attachment.texture);
+            const DXGI_FORMAT format = getDxgiFormatMapping(attachment.format == Format::UNKNOWN ? texture->desc.format : attachment.format).rtvFormat;
+
+            D3D12_RENDER_PASS_RENDER_TARGET_DESC rtDesc = {};
+            rtDesc.cpuDescriptor = m_Resources.renderTargetViewHeap.getCpuHandle(fb->RTVs[i]);
+            rtDesc.BeginningAccess.Type = resume ? D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_PRESERVE : convertBeginningAccess(attachment.loadOp);
+            rtDesc.EndingAccess.Type = convertEndingAccess(attachment.storeOp);
+
+            if (rtDesc.BeginningAccess.Type == D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_CLEAR)
+            {
+                rtDesc.BeginningAccess.Clear.ClearValue.Format = format;
+                rtDesc.BeginningAccess.Clear.ClearValue.Color[0] = attachment.clearColor.r;
+                rtDesc.BeginningAccess.Clear.ClearValue.Color[1] = attachment.clearColor.g;
+                rtDesc.BeginningAccess.Clear.ClearValue.Color[2] = attachment.clearColor.b;
+                rtDesc.BeginningAccess.Clear.ClearValue.Color[3] = attachment.clearColor.a;
+            }
+
+            if (rtDesc.EndingAccess.Type == D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_RESOLVE)
+            {
+                // The validation layer makes sure that resolved attachments use a single mip level and array slice
+                const Texture* resolveTexture = checked_cast<Texture*>(attachment.resolveTexture);
+                const TextureSubresourceSet srcSubresources = attachment.subresources.resolve(texture->desc, true);
+                const TextureSubresourceSet dstSubresources = attachment.resolveSubresources.resolve(resolveTexture->desc, true);
+
+                D3D12_RENDER_PASS_ENDING_ACCESS_RESOLVE_SUBRESOURCE_PARAMETERS& subresourceParameters = resolveParameters[i];
+                subresourceParameters.SrcSubresource = calcSubresource(srcSubresources.baseMipLevel, srcSubresources.baseArraySlice, 0,
+                    texture->desc.mipLevels, texture->desc.arraySize);
+                subresourceParameters.DstSubresource = calcSubresource(dstSubresources.baseMipLevel, dstSubresources.baseArraySlice, 0,
+                    resolveTexture->desc.mipLevels, resolveTexture->desc.arraySize);
+                subresourceParameters.SrcRect = { 0, 0, LONG(fb->framebufferInfo.width), LONG(fb->framebufferInfo.height) };
+
+                rtDesc.EndingAccess.Resolve.pSrcResource = texture->resource;
+                rtDesc.EndingAccess.Resolve.pDstResource = resolveTexture->resource;
+                rtDesc.EndingAccess.Resolve.SubresourceCount = 1;
+                rtDesc.EndingAccess.Resolve.pSubresourceParameters = &subresourceParameters;
+                rtDesc.EndingAccess.Resolve.Format = format;
+                rtDesc.EndingAccess.Resolve.ResolveMode = D3D12_RESOLVE_MODE_AVERAGE;
+                rtDesc.EndingAccess.Resolve.PreserveResolveSource = FALSE;
+            }
+
+            renderTargets.push_back(rtDesc);
+        }
+
+        D3D12_RENDER_PASS_DEPTH_STENCIL_DESC depthDesc = {};
+        const FramebufferAttachment& depth = desc.depthAttachment;
+
+        if (depth.valid())
+        {
+            const Texture* texture = checked_cast<Texture*>(depth.texture);
+            const bool hasStencil = getFormatInfo(texture->desc.format).hasStencil;
+
+            // Read-only depth attachments are never cleared or discarded
+            D3D12_RENDER_PASS_BEGINNING_ACCESS beginningAccess = {};
+            beginningAccess.Type = (resume || depth.isReadOnly) ? D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_PRESERVE : convertBeginningAccess(depth.loadOp);
+            beginningAccess.Clear.ClearValue.Format = getDxgiFormatMapping(texture->desc.format).rtvFormat;
+            beginningAccess.Clear.ClearValue.DepthStencil.Depth = depth.clearDepth;
+            beginningAccess.Clear.ClearValue.DepthStencil.Stencil = depth.clearStencil;
+
+            D3D12_RENDER_PASS_ENDING_ACCESS endingAccess = {};
+            endingAccess.Type = depth.isReadOnly ? D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_PRESERVE : convertEndingAccess(depth.storeOp);
+
+            D3D12_RENDER_PASS_BEGINNING_ACCESS noAccessBeginning = {};
+            noAccessBeginning.Type = D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_NO_ACCESS;
+            D3D12_RENDER_PASS_ENDING_ACCESS noAccessEnding = {};
+            noAccessEnding.Type = D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_NO_ACCESS;
+
+            depthDesc.cpuDescriptor = m_Resources.depthStencilViewHeap.getCpuHandle(fb->DSV);
+            depthDesc.DepthBeginningAccess = beginningAccess;
+            depthDesc.DepthEndingAccess = endingAccess;
+            depthDesc.StencilBeginningAccess = hasStencil ? beginningAccess : noAccessBeginning;
+            depthDesc.StencilEndingAccess = hasStencil ? endingAccess : noAccessEnding;
+        }
+
+        // The render pass doesn't know the pipelines that are used inside it, so always allow pixel shader UAV writes
+        m_ActiveCommandList->commandList4->BeginRenderPass(UINT(renderTargets.size()), renderTargets.data(),
+            depth.valid() ? &depthDesc : nullptr, D3D12_RENDER_PASS_FLAG_ALLOW_UAV_WRITES);
+    }
+
+    void CommandList::suspendRenderPass()
+    {
+        if (m_RenderPassActive)
+        {
+            m_ActiveCommandList->commandList4->EndRenderPass();
+            m_RenderPassActive = false;
+        }
+    }
+
+    void CommandList::resumeRenderPass()
+    {
+        if (m_RenderPassFramebuffer && !m_RenderPassActive)
+        {
+            beginRenderPass(m_RenderPassFramebuffer, m_RenderPassStarted);
+            m_RenderPassActive = true;
+            m_RenderPassStarted = true;
+        }
+    }
+
+    void CommandList::commitBarriersInsideRenderPass()
+    {
+        // Barriers cannot be recorded inside a render pass, and commitBarriers suspends it
+        if (!m_StateTracker.getTextureBarriers().empty() || !m_StateTracker.getBufferBarriers().empty())
+            commitBarriers();
+
+        // Begin the render pass, or resume it after the barriers above or a copy, clear or query command
+        resumeRenderPass();
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
         GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
@@ -311,7 +541,8 @@ namespace nvrhi::d3d12
         const bool updateIndexBuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indexBuffer != state.indexBuffer;
         const bool updateVertexBuffers = !m_CurrentGraphicsStateValid || arraysAreDifferent(m_CurrentGraphicsState.vertexBuffers, state.vertexBuffers);
 
-        const bool updateShadingRate = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.shadingRateState != state.shadingRateState;
+        // Bundles don't support variable rate shading, and the executing command list disables it
+        const bool updateShadingRate = !m_IsBundle && (!m_CurrentGraphicsStateValid || m_CurrentGraphicsState.shadingRateState != state.shadingRateState);
 
         uint32_t bindingUpdateMask = 0;
         if (!m_CurrentGraphicsStateValid || updateRootSignature)
@@ -326,6 +557,7 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindGraphicsPipeline(pso, updateRootSignature);
+            m_Statistics.pipelineBinds++;
             m_Instance->referencedResources.push_back(pso);
         }
 
@@ -350,67 +582,15 @@ namespace nvrhi::d3d12
 
         if (updateIndexBuffer)
         {
-            D3D12_INDEX_BUFFER_VIEW IBV = {};
-
-            if (state.indexBuffer.buffer)
-            {
-                Buffer* buffer = checked_cast<Buffer*>(state.indexBuffer.buffer);
-
-                if (m_EnableAutomaticBarriers)
-                {
-                    requireBufferState(buffer, ResourceStates::IndexBuffer);
-                }
-
-                IBV.Format = getDxgiFormatMapping(state.indexBuffer.format).srvFormat;
-                IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - state.indexBuffer.offset);
-                IBV.BufferLocation = buffer->gpuVA + state.indexBuffer.offset;
-
-                m_Instance->referencedResources.push_back(state.indexBuffer.buffer);
-            }
-
-            m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+            bindIndexBuffer(state.indexBuffer);
         }
 
         if (updateVertexBuffers)
         {
-            D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
-            uint32_t maxVbIndex = 0;
-            InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
-
-            for (const VertexBufferBinding& binding : state.vertexBuffers)
-            {
-                Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
-
-                if (m_EnableAutomaticBarriers)
-                {
-                    requireBufferState(buffer, ResourceStates::VertexBuffer);
-                }
-
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-
-                VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
-                VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
-                VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-
-                m_Instance->referencedResources.push_back(buffer);
-            }
-
-            if (m_CurrentGraphicsStateValid)
-            {
-                for (const VertexBufferBinding& binding : m_CurrentGraphicsState.vertexBuffers)
-                {
-                    if (binding.slot < c_MaxVertexAttributes)
-                        maxVbIndex = std::max(maxVbIndex, binding.slot);
-                }
-            }
-
-            m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
+            bindVertexBuffers(pso, state.vertexBuffers);
         }
 
-        if (updateShadingRate || updateFramebuffer)
+        if (!m_IsBundle && (updateShadingRate || updateFramebuffer))
         {
             auto framebufferDesc = framebuffer->getDesc();
             bool shouldEnableVariableRateShading = framebufferDesc.shadingRateAttachment.valid() && state.shadingRateState.enabled;
@@ -447,25 +627,33 @@ namespace nvrhi::d3d12
             }
         }
         
-        commitBarriers();
+        commitBarriersInsideRenderPass();
 
         if (updateViewports)
         {
             DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, framebuffer->framebufferInfo, state.viewport);
 
-            if (vpState.numViewports)
+            if (m_IsBundle)
             {
-                m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+                // Viewports and scissors cannot be set in bundles, the executing command list sets them
+                m_BundleViewportState = vpState;
             }
-
-            if (vpState.numScissorRects)
+            else
             {
-                m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+                if (vpState.numViewports)
+                {
+                    m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+                }
+
+                if (vpState.numScissorRects)
+                {
+                    m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+                }
             }
         }
 
 #if NVRHI_D3D12_WITH_NVAPI
-        bool updateSPS = m_CurrentSinglePassStereoState != pso->desc.renderState.singlePassStereo;
+        bool updateSPS = !m_IsBundle && m_CurrentSinglePassStereoState != pso->desc.renderState.singlePassStereo;
 
         if (updateSPS)
         {
@@ -486,9 +674,121 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentGraphicsState = state;
     }
 
+    void CommandList::setGraphicsBindings(const BindingSetVector& bindings)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsBindings can only be used after setGraphicsState");
+            return;
+        }
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+
+        uint32_t bindingUpdateMask = arrayDifferenceMask(m_CurrentGraphicsState.bindings, bindings);
+
+        if (commitDescriptorHeaps())
+            bindingUpdateMask = ~0u;
+
+        setGraphicsBindings(bindings, bindingUpdateMask, m_CurrentGraphicsState.indirectParams, false, m_CurrentGraphicsState.indirectCountBuffer, false, pso->rootSignature);
+
+        commitBarriersInsideRenderPass();
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandList::setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsVertexBuffers can only be used after setGraphicsState");
+            return;
+        }
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+
+        if (m_CurrentGraphicsState.indexBuffer != indexBuffer)
+        {
+            bindIndexBuffer(indexBuffer);
+        }
+
+        if (arraysAreDifferent(m_CurrentGraphicsState.vertexBuffers, vertexBuffers))
+        {
+            bindVertexBuffers(pso, vertexBuffers);
+        }
+
+        commitBarriersInsideRenderPass();
+
+        m_CurrentGraphicsState.indexBuffer = indexBuffer;
+        m_CurrentGraphicsState.vertexBuffers = vertexBuffers;
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        D3D12_INDEX_BUFFER_VIEW IBV = {};
+
+        if (indexBuffer.buffer)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(indexBuffer.buffer);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(buffer, ResourceStates::IndexBuffer);
+            }
+
+            IBV.Format = getDxgiFormatMapping(indexBuffer.format).srvFormat;
+            IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - indexBuffer.offset);
+            IBV.BufferLocation = buffer->gpuVA + indexBuffer.offset;
+
+            m_Instance->referencedResources.push_back(indexBuffer.buffer);
+        }
+
+        m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+    }
+
+    void CommandList::bindVertexBuffers(const GraphicsPipeline* pso, const VertexBufferBindingVector& vertexBuffers)
+    {
+        D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
+        uint32_t maxVbIndex = 0;
+        InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
+
+        for (const VertexBufferBinding& binding : vertexBuffers)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(buffer, ResourceStates::VertexBuffer);
+            }
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
+            VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
+            VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+
+            m_Instance->referencedResources.push_back(buffer);
+        }
+
+        // Unbind the slots used by the previous state but not by the new one
+        if (m_CurrentGraphicsStateValid)
+        {
+            for (const VertexBufferBinding& binding : m_CurrentGraphicsState.vertexBuffers)
+            {
+                if (binding.slot < c_MaxVertexAttributes)
+                    maxVbIndex = std::max(maxVbIndex, binding.slot);
+            }
+        }
+
+        m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
+    }
+
     void CommandList::unbindShadingRateState()
     {
         if (m_CurrentGraphicsStateValid && m_CurrentGraphicsState.shadingRateState.enabled)
@@ -538,15 +838,19 @@ namespace nvrhi::d3d12
 
     void CommandList::draw(const DrawArguments& args)
     {
+        resumeRenderPass();
         updateGraphicsVolatileBuffers();
 
+        m_Statistics.drawCalls++;
         m_ActiveCommandList->commandList->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
     {
+        resumeRenderPass();
         updateGraphicsVolatileBuffers();
 
+        m_Statistics.drawCalls++;
         m_ActiveCommandList->commandList->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
     }
 
@@ -557,8 +861,10 @@ namespace nvrhi::d3d12
 
         Buffer* indirectCountBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer); // [rlaw]
 
+        resumeRenderPass();
         updateGraphicsVolatileBuffers();
 
+        m_Statistics.drawCalls++;
         // [rlaw]: added indirect count params
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, drawCount, indirectParams->resource, offsetBytes, indirectCountBuffer ? indirectCountBuffer->resource : nullptr, 0);
     }
@@ -570,11 +876,55 @@ namespace nvrhi::d3d12
 
         Buffer* indirectCountBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer); // [rlaw]
 
+        resumeRenderPass();
         updateGraphicsVolatileBuffers();
 
+        m_Statistics.drawCalls++;
         // [rlaw]: added indirect count params
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, drawCount, indirectParams->resource, offsetBytes, indirectCountBuffer ? indirectCountBuffer->resource : nullptr, 0);
     }
+
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* _countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        assert(indirectParams); // validation layer handles this
+
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+            commitBarriers();
+        }
+        m_Instance->referencedResources.push_back(countBuffer);
+
+        resumeRenderPass();
+        updateGraphicsVolatileBuffers();
+
+        m_Statistics.drawCalls++;
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, maxDrawCount, indirectParams->resource, paramOffsetBytes, countBuffer->resource, countOffsetBytes);
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* _countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        assert(indirectParams);
+
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+            commitBarriers();
+        }
+        m_Instance->referencedResources.push_back(countBuffer);
+
+        resumeRenderPass();
+        updateGraphicsVolatileBuffers();
+
+        m_Statistics.drawCalls++;
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, maxDrawCount, indirectParams->resource, paramOffsetBytes, countBuffer->resource, countOffsetBytes);
+    }
     
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState)
     {
@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        if (desc.arguments.empty())
+        {
+            m_Context.error("Cannot create a command signature without arguments");
+            return nullptr;
+        }
+
+        RefCountPtr<RootSignature> rootSignature;
+        if (desc.graphicsPipeline)
+            rootSignature = checked_cast<GraphicsPipeline*>(desc.graphicsPipeline)->rootSignature;
+        else if (desc.meshletPipeline)
+            rootSignature = checked_cast<MeshletPipeline*>(desc.meshletPipeline)->rootSignature;
+        else if (desc.computePipeline)
+            rootSignature = checked_cast<ComputePipeline*>(desc.computePipeline)->rootSignature;
+
+        CommandSignature* signature = new CommandSignature();
+        signature->desc = desc;
+
+        static_vector<D3D12_INDIRECT_ARGUMENT_DESC, c_MaxIndirectArguments> argumentDescs;
+        bool changesRootArguments = false;
+
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC& argumentDesc = argumentDescs.emplace_back();
+            argumentDesc = {};
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::Draw:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+                break;
+            case IndirectArgumentType::DrawIndexed:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+                break;
+            case IndirectArgumentType::Dispatch:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+                break;
+            case IndirectArgumentType::DispatchMesh:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                break;
+            case IndirectArgumentType::VertexBuffer:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+                argumentDesc.VertexBuffer.Slot = argument.slot;
+                signature->changesInputAssembler = true;
+                break;
+            case IndirectArgumentType::IndexBuffer:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+                signature->changesInputAssembler = true;
+                break;
+            case IndirectArgumentType::PushConstants:
+                if (!rootSignature || rootSignature->pushConstantByteSize == 0)
+                {
+                    m_Context.error("Command signatures with PushConstants arguments need a pipeline that uses push constants");
+                    delete signature;
+                    return nullptr;
+                }
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+                argumentDesc.Constant.RootParameterIndex = rootSignature->rootParameterPushConstants;
+                argumentDesc.Constant.DestOffsetIn32BitValues = argument.offset / 4;
+                argumentDesc.Constant.Num32BitValuesToSet = argument.size / 4;
+                changesRootArguments = true;
+                break;
+            default:
+                utils::InvalidEnum();
+                delete signature;
+                return nullptr;
+            }
+        }
+
+        signature->commandType = desc.arguments[desc.arguments.size() - 1].type;
+
+        // The root signature must only be passed when the records change root arguments
+        if (changesRootArguments)
+            signature->rootSignature = rootSignature;
+
+        D3D12_COMMAND_SIGNATURE_DESC csDesc = {};
+        csDesc.ByteStride = utils::GetCommandSignatureByteStride(desc);
+        csDesc.NumArgumentDescs = UINT(argumentDescs.size());
+        csDesc.pArgumentDescs = argumentDescs.data();
+        csDesc.NodeMask = m_Context.nodeMask;
+
+        const HRESULT res = m_Context.device->CreateCommandSignature(&csDesc,
+            signature->rootSignature ? signature->rootSignature->handle.Get() : nullptr,
+            IID_PPV_ARGS(&signature->handle));
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateCommandSignature call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+
+            delete signature;
+            return nullptr;
+        }
+
+        return CommandSignatureHandle::Create(signature);
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* _signature, IBuffer* _argumentBuffer, uint32_t argumentOffsetBytes,
+        uint32_t maxCommandCount, IBuffer* _countBuffer, uint32_t countOffsetBytes)
+    {
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+        Buffer* argumentBuffer = checked_cast<Buffer*>(_argumentBuffer);
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(argumentBuffer, ResourceStates::IndirectArgument);
+            if (countBuffer)
+                requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+            commitBarriers();
+        }
+
+        m_Instance->referencedResources.push_back(signature);
+        m_Instance->referencedResources.push_back(argumentBuffer);
+        if (countBuffer)
+            m_Instance->referencedResources.push_back(countBuffer);
+
+        if (signature->commandType == IndirectArgumentType::Dispatch)
+        {
+            updateComputeVolatileBuffers();
+            m_Statistics.dispatchCalls++;
+        }
+        else
+        {
+            resumeRenderPass();
+            updateGraphicsVolatileBuffers();
+            m_Statistics.drawCalls++;
+        }
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(signature->handle, maxCommandCount,
+            argumentBuffer->resource, argumentOffsetBytes,
+            countBuffer ? countBuffer->resource : nullptr, countOffsetBytes);
+
+        if (signature->changesInputAssembler)
+        {
+            // The records leave their own vertex and index buffers bound, make the next setGraphicsState rebind ours
+            m_CurrentGraphicsState.vertexBuffers.resize(0);
+            m_CurrentGraphicsState.indexBuffer = IndexBufferBinding();
+        }
+    }
+
+} // namespace nvrhi::d3d12
@@ -62,6 +62,7 @@ namespace nvrhi::d3d12
             ALIGNED_TYPE SampleMask_Type;           UINT SampleMask;
             ALIGNED_TYPE RenderTargets_Type;        D3D12_RT_FORMAT_ARRAY RenderTargets;
             ALIGNED_TYPE DSVFormat_Type;            DXGI_FORMAT DSVFormat;
+            ALIGNED_TYPE NodeMask_Type;             D3D12_NODE_MASK NodeMask;
         } psoDesc = { };
 #pragma warning(pop)
 
@@ -77,8 +78,10 @@ namespace nvrhi::d3d12
         psoDesc.SampleMask_Type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK;
         psoDesc.RenderTargets_Type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS;
         psoDesc.DSVFormat_Type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT;
+        psoDesc.NodeMask_Type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK;
 
         psoDesc.RootSignature = pRS->handle;
+        psoDesc.NodeMask.NodeMask = m_Context.nodeMask;
 
         TranslateBlendState(state.renderState.blendState, psoDesc.BlendState);
         
@@ -145,6 +148,28 @@ namespace nvrhi::d3d12
         streamDesc.pPipelineStateSubobjectStream = &psoDesc;
         streamDesc.SizeInBytes = sizeof(psoDesc);
 
+        RefCountPtr<ID3D12PipelineLibrary1> library = getPipelineLibrary();
+        PipelineLibraryKey key;
+        if (library)
+        {
+            key.add(pRS->contentHash);
+            key.add(psoDesc.PrimitiveTopologyType);
+            key.addBytecode(psoDesc.AmplificationShader);
+            key.addBytecode(psoDesc.MeshShader);
+            key.addBytecode(psoDesc.PixelShader);
+            key.add(psoDesc.RasterizerState);
+            key.add(psoDesc.DepthStencilState);
+            key.add(psoDesc.BlendState);
+            key.add(psoDesc.SampleDesc);
+            key.add(psoDesc.SampleMask);
+            key.add(psoDesc.RenderTargets);
+            key.add(psoDesc.DSVFormat);
+            key.add(psoDesc.NodeMask);
+
+            if (SUCCEEDED(library->LoadPipeline(key.getName().c_str(), &streamDesc, IID_PPV_ARGS(&pipelineState))))
+                return pipelineState;
+        }
+
         HRESULT hr = m_Context.device2->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&pipelineState));
         if (FAILED(hr))
         {
@@ -152,6 +177,8 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        storeLibraryPipeline(library, key, pipelineState);
+
         return pipelineState;
     }
 
@@ -175,6 +202,7 @@ namespace nvrhi::d3d12
         MeshletPipeline *pso = new MeshletPipeline();
         pso->desc = desc;
         pso->framebufferInfo = framebufferInfo;
+        pso->framebufferInfoHash = std::hash<FramebufferInfo>()(framebufferInfo);
         pso->rootSignature = checked_cast<RootSignature*>(rootSignature);
         pso->pipelineState = pipelineState;
         pso->requiresBlendFactor = desc.renderState.blendState.usesConstantColor(uint32_t(pso->framebufferInfo.colorFormats.size()));
@@ -247,6 +275,7 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindMeshletPipeline(pso, updateRootSignature);
+            m_Statistics.pipelineBinds++;
             m_Instance->referencedResources.push_back(pso);
         }
 
@@ -269,7 +298,7 @@ namespace nvrhi::d3d12
         // [rlaw]: added indirect count params
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, state.indirectCountBuffer, updateIndirectCountParam, pso->rootSignature);
         
-        commitBarriers();
+        commitBarriersInsideRenderPass();
 
         if (updateViewports)
         {
@@ -292,13 +321,51 @@ namespace nvrhi::d3d12
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = true;
         m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentMeshletState = state;
     }
 
     void CommandList::dispatchMesh(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
     {
+        resumeRenderPass();
         updateGraphicsVolatileBuffers();
 
+        m_Statistics.drawCalls++;
         m_ActiveCommandList->commandList6->DispatchMesh(groupsX, groupsY, groupsZ);
     }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams); // validation layer handles this
+
+        Buffer* indirectCountBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+
+        resumeRenderPass();
+        updateGraphicsVolatileBuffers();
+
+        m_Statistics.drawCalls++;
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, drawCount, indirectParams->resource, offsetBytes, indirectCountBuffer ? indirectCountBuffer->resource : nullptr, 0);
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* _countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams); // validation layer handles this
+
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+            commitBarriers();
+        }
+        m_Instance->referencedResources.push_back(countBuffer);
+
+        resumeRenderPass();
+        updateGraphicsVolatileBuffers();
+
+        m_Statistics.drawCalls++;
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, maxDrawCount, indirectParams->resource, paramOffsetBytes, countBuffer->resource, countOffsetBytes);
+    }
 } // namespace nvrhi::d3d12
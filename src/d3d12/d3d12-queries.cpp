@@ -21,8 +21,12 @@
 */
 
 #include "d3d12-backend.h"
+#include "../common/breadcrumb-buffer.h"
 
 #include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include <sstream>
+#include <iomanip>
 
 namespace nvrhi::d3d12
 {
@@ -101,6 +105,7 @@ namespace nvrhi::d3d12
                 D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
                 queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
                 queryHeapDesc.Count = uint32_t(m_Resources.timerQueries.getCapacity()) * 2; // Use 2 D3D12 queries per 1 TimerQuery
+                queryHeapDesc.NodeMask = m_Context.nodeMask;
                 m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_Context.timerQueryHeap));
 
                 BufferDesc qbDesc;
@@ -211,6 +216,9 @@ namespace nvrhi::d3d12
 
         m_ActiveCommandList->commandList->EndQuery(m_Context.timerQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, query->endQueryIndex);
 
+        // Query data cannot be resolved inside a render pass
+        suspendRenderPass();
+
         m_ActiveCommandList->commandList->ResolveQueryData(m_Context.timerQueryHeap,
             D3D12_QUERY_TYPE_TIMESTAMP,
             query->beginQueryIndex,
@@ -219,5 +227,272 @@ namespace nvrhi::d3d12
             query->beginQueryIndex * 8);
     }
 
+    static D3D12_QUERY_TYPE convertQueryType(QueryType type)
+    {
+        switch (type)
+        {
+        case QueryType::Occlusion:          return D3D12_QUERY_TYPE_OCCLUSION;
+        case QueryType::BinaryOcclusion:    return D3D12_QUERY_TYPE_BINARY_OCCLUSION;
+        case QueryType::PipelineStatistics: return D3D12_QUERY_TYPE_PIPELINE_STATISTICS;
+        default:
+            utils::InvalidEnum();
+            return D3D12_QUERY_TYPE_OCCLUSION;
+        }
+    }
+
+    QueryPoolHandle Device::createQueryPool(const QueryPoolDesc& desc)
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = (desc.type == QueryType::PipelineStatistics)
+            ? D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS
+            : D3D12_QUERY_HEAP_TYPE_OCCLUSION;
+        queryHeapDesc.Count = desc.count;
+        queryHeapDesc.NodeMask = m_Context.nodeMask;
+
+        RefCountPtr<ID3D12QueryHeap> heap;
+        const HRESULT res = m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&heap));
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateQueryHeap call failed for query pool " << utils::DebugNameToString(desc.debugName)
+                << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+
+            return nullptr;
+        }
+
+        if (!desc.debugName.empty())
+        {
+            std::wstring wname(desc.debugName.begin(), desc.debugName.end());
+            heap->SetName(wname.c_str());
+        }
+
+        QueryPool* pool = new QueryPool();
+        pool->desc = desc;
+        pool->heap = heap;
+        return QueryPoolHandle::Create(pool);
+    }
+
+    void CommandList::beginQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        m_Instance->referencedResources.push_back(pool);
+
+        m_ActiveCommandList->commandList->BeginQuery(pool->heap, convertQueryType(pool->desc.type), queryIndex);
+    }
+
+    void CommandList::endQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        m_ActiveCommandList->commandList->EndQuery(pool->heap, convertQueryType(pool->desc.type), queryIndex);
+    }
+
+    void CommandList::resolveQueries(IQueryPool* _pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* _buffer, uint64_t offsetBytes)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        // Query data cannot be resolved inside a render pass
+        suspendRenderPass();
+
+        m_Instance->referencedResources.push_back(pool);
+        m_Instance->referencedResources.push_back(buffer);
+
+        m_ActiveCommandList->commandList->ResolveQueryData(pool->heap, convertQueryType(pool->desc.type),
+            firstQuery, numQueries, buffer->resource, offsetBytes);
+    }
+
+    void CommandList::setPredication(IBuffer* _buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (!buffer)
+        {
+            m_ActiveCommandList->commandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+            m_PredicationBuffer = nullptr;
+            return;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::Predication);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(buffer);
+
+        m_PredicationBuffer = buffer->resource;
+        m_PredicationOffset = offsetBytes;
+        m_PredicationOp = (op == PredicationOp::SkipIfZero) ? D3D12_PREDICATION_OP_EQUAL_ZERO : D3D12_PREDICATION_OP_NOT_EQUAL_ZERO;
+
+        m_ActiveCommandList->commandList->SetPredication(m_PredicationBuffer, m_PredicationOffset, m_PredicationOp);
+    }
+
+    void CommandList::suspendPredication()
+    {
+        if (m_PredicationBuffer)
+            m_ActiveCommandList->commandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+    }
+
+    void CommandList::resumePredication()
+    {
+        if (m_PredicationBuffer)
+            m_ActiveCommandList->commandList->SetPredication(m_PredicationBuffer, m_PredicationOffset, m_PredicationOp);
+    }
+
+    GpuProfiler::GpuProfiler(Device* device, const GpuProfilerDesc& desc)
+        : GpuProfilerBase(device, desc)
+        , m_Device(device)
+        , m_FrameFenceValues(size_t(getFrameCount()) * size_t(CommandQueue::Count), 0)
+    {
+        m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        if (m_FenceEvent)
+        {
+            CloseHandle(m_FenceEvent);
+            m_FenceEvent = nullptr;
+        }
+    }
+
+    void GpuProfiler::onFrameEnded(uint32_t frameSlot)
+    {
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            Queue* queue = m_Device->getQueue(CommandQueue(queueIndex));
+            m_FrameFenceValues[frameSlot * uint32_t(CommandQueue::Count) + queueIndex] = queue ? queue->lastSubmittedInstance.load() : 0;
+        }
+    }
+
+    bool GpuProfiler::isFrameCompleted(uint32_t frameSlot, bool wait)
+    {
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            const uint64_t fenceValue = m_FrameFenceValues[frameSlot * uint32_t(CommandQueue::Count) + queueIndex];
+            Queue* queue = m_Device->getQueue(CommandQueue(queueIndex));
+
+            if (!queue || fenceValue == 0 || queue->updateLastCompletedInstance() >= fenceValue)
+                continue;
+
+            if (!wait)
+                return false;
+
+            WaitForFence(queue->fence, fenceValue, m_FenceEvent);
+        }
+
+        return true;
+    }
+
+    double GpuProfiler::getTimestampFrequency(CommandQueue queueType)
+    {
+        Queue* queue = m_Device->getQueue(queueType);
+
+        uint64_t frequency = 0;
+        if (!queue || FAILED(queue->queue->GetTimestampFrequency(&frequency)) || frequency == 0)
+            return 1.0;
+
+        return double(frequency);
+    }
+
+    GpuProfilerHandle Device::createGpuProfiler(const GpuProfilerDesc& desc)
+    {
+        GpuProfiler* profiler = new GpuProfiler(this, desc);
+
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = profiler->getTotalQueryCount();
+        queryHeapDesc.NodeMask = m_Context.nodeMask;
+        const HRESULT hr = m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&profiler->queryHeap));
+
+        if (FAILED(hr))
+        {
+            m_Context.error("Failed to create a query heap for the GPU profiler");
+            delete profiler;
+            return nullptr;
+        }
+
+        BufferDesc readbackDesc;
+        readbackDesc.byteSize = uint64_t(queryHeapDesc.Count) * sizeof(uint64_t);
+        readbackDesc.cpuAccess = CpuAccessMode::Read;
+        readbackDesc.debugName = "GpuProfilerReadback";
+
+        profiler->readbackBuffer = createBuffer(readbackDesc);
+        if (!profiler->readbackBuffer)
+        {
+            delete profiler;
+            return nullptr;
+        }
+
+        return GpuProfilerHandle::Create(profiler);
+    }
+
+    void CommandList::setGpuProfiler(IGpuProfiler* profiler)
+    {
+        // Copy queues need a separate heap type for timestamps, they are not profiled
+        if (m_Desc.queueType == CommandQueue::Copy)
+            profiler = nullptr;
+
+        m_ProfilerRecording.setProfiler(profiler, m_Desc.queueType);
+    }
+
+    BreadcrumbBufferHandle Device::createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc)
+    {
+        return BreadcrumbBuffer::create(this, desc);
+    }
+
+    void CommandList::writeBreadcrumb(IBreadcrumbBuffer* _breadcrumbs, uint32_t markerId)
+    {
+        if (m_GPULog == ULLONG_MAX || !m_ActiveCommandList->commandList4)
+            return;
+
+        BreadcrumbBuffer* breadcrumbs = checked_cast<BreadcrumbBuffer*>(_breadcrumbs);
+        Buffer* buffer = checked_cast<Buffer*>(breadcrumbs->getBuffer());
+        assert(m_GPULog < breadcrumbs->getDesc().numSlots);
+
+        // The readback buffer always stays in the COPY_DEST state that WriteBufferImmediate requires
+        D3D12_WRITEBUFFERIMMEDIATE_PARAMETER parameter;
+        parameter.Dest = buffer->gpuVA + m_GPULog * sizeof(uint32_t);
+        parameter.Value = markerId;
+        const D3D12_WRITEBUFFERIMMEDIATE_MODE mode = D3D12_WRITEBUFFERIMMEDIATE_MODE_MARKER_OUT;
+
+        m_ActiveCommandList->commandList4->WriteBufferImmediate(1, &parameter, &mode);
+
+        m_Instance->referencedResources.push_back(breadcrumbs);
+    }
+
+    void CommandList::resolveProfilerQueries()
+    {
+        GpuProfiler* profiler = checked_cast<GpuProfiler*>(m_ProfilerRecording.getProfiler());
+        if (!profiler)
+            return;
+
+        Buffer* readbackBuffer = checked_cast<Buffer*>(profiler->readbackBuffer.Get());
+
+        for (const GpuProfilerRecording::QueryBlock& block : m_ProfilerRecording.getQueryBlocks())
+        {
+            m_ActiveCommandList->commandList->ResolveQueryData(profiler->queryHeap,
+                D3D12_QUERY_TYPE_TIMESTAMP,
+                block.firstQuery,
+                block.numQueries,
+                readbackBuffer->resource,
+                uint64_t(block.firstQuery) * sizeof(uint64_t));
+        }
+
+        if (!m_ProfilerRecording.getQueryBlocks().empty())
+            m_Instance->referencedResources.push_back(profiler);
+
+        m_ProfilerRecording.finish();
+    }
 
 } // namespace nvrhi::d3d12
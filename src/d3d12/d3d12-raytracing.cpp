@@ -51,6 +51,9 @@ namespace
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
                 NVAPI_D3D12_RAYTRACING_GEOMETRY_OMM_TRIANGLES_DESC ommTriangles;
 #endif
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+                D3D12_RAYTRACING_GEOMETRY_OMM_TRIANGLES_DESC       nativeOmmTriangles;
+#endif
 #if NVRHI_WITH_NVAPI_DISPLACEMENT_MICROMAP
                 // Note: this union member is currently only used to pad the structure so that it's the same size as NVAPI_D3D12_RAYTRACING_GEOMETRY_DESC_EX.
                 // There is no support for Displacement Micro Maps in NVRHI API yet.
@@ -58,6 +61,13 @@ namespace
 #endif
             };
         } m_data;
+
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        // The core OMM triangles desc references the triangles and linkage through pointers.
+        // The descs are always passed as an array of pointers, so this storage may trail m_data.
+        D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC m_nativeOmmTriangles;
+        D3D12_RAYTRACING_GEOMETRY_OMM_LINKAGE_DESC m_nativeOmmLinkage;
+#endif
     public:
 
         constexpr void Validate()
@@ -73,6 +83,10 @@ namespace
                 static_assert(sizeof(D3D12_RAYTRACING_GEOMETRY_DESC::Triangles) == sizeof(RaytracingGeometryDesc::triangles));
                 static_assert(offsetof(D3D12_RAYTRACING_GEOMETRY_DESC, AABBs) == offsetof(RaytracingGeometryDesc, aabbs));
                 static_assert(sizeof(D3D12_RAYTRACING_GEOMETRY_DESC::AABBs) == sizeof(RaytracingGeometryDesc::aabbs));
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+                static_assert(offsetof(D3D12_RAYTRACING_GEOMETRY_DESC, OmmTriangles) == offsetof(RaytracingGeometryDesc, nativeOmmTriangles));
+                static_assert(sizeof(D3D12_RAYTRACING_GEOMETRY_DESC::OmmTriangles) == sizeof(RaytracingGeometryDesc::nativeOmmTriangles));
+#endif
             }
             {
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_DISPLACEMENT_MICROMAP
@@ -126,6 +140,16 @@ namespace
             m_data.ommTriangles = ommTriangles;
         }
 #endif
+
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        void SetNativeOMMTriangles(const D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC& triangles, const D3D12_RAYTRACING_GEOMETRY_OMM_LINKAGE_DESC& ommLinkage) {
+            m_nativeOmmTriangles = triangles;
+            m_nativeOmmLinkage = ommLinkage;
+            m_data.type = decltype(m_data.type)(D3D12_RAYTRACING_GEOMETRY_TYPE_OMM_TRIANGLES);
+            m_data.nativeOmmTriangles.pTriangles = &m_nativeOmmTriangles;
+            m_data.nativeOmmTriangles.pOmmLinkage = &m_nativeOmmLinkage;
+        }
+#endif
     };
 
     class D3D12BuildRaytracingAccelerationStructureInputs
@@ -249,14 +273,117 @@ namespace nvrhi::d3d12
         return true;
     }
 
-    void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    bool ShaderTable::makeEntry(const char* exportName, IBindingSet* bindings, Entry& outEntry) const
     {
+        if (!exportName)
+        {
+            if (!desc.isCached || !desc.allowGpuWrites)
+            {
+                m_Context.error("Shader table records without an export name can only be added to cached tables that allow GPU writes");
+                return false;
+            }
+
+            if (bindings)
+            {
+                m_Context.error("Shader table records reserved for GPU writes cannot have local bindings");
+                return false;
+            }
+
+            outEntry = Entry{};
+            return true;
+        }
+
         const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
 
-        if (verifyExport(pipelineExport, bindings))
+        if (!verifyExport(pipelineExport, bindings))
+            return false;
+
+        outEntry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
+        outEntry.localBindings = bindings;
+        return true;
+    }
+
+    const ShaderTable::Entry& ShaderTable::getRecord(uint32_t recordIndex) const
+    {
+        if (recordIndex == 0)
+            return rayGenerationShader;
+        recordIndex -= 1;
+
+        if (recordIndex < missShaders.size())
+            return missShaders[recordIndex];
+        recordIndex -= uint32_t(missShaders.size());
+
+        if (recordIndex < hitGroups.size())
+            return hitGroups[recordIndex];
+        recordIndex -= uint32_t(hitGroups.size());
+
+        return callableShaders[recordIndex];
+    }
+
+    std::atomic<uint64_t> ShaderTable::s_NextCacheId = 0;
+
+    // The callers increment the version after marking, so the changes belong to version + 1
+
+    void ShaderTable::markRecordDirty(uint32_t recordIndex)
+    {
+        if (!desc.isCached)
+            return;
+
+        // Past this point a full copy is cheaper than replaying the log
+        if (recordChanges.size() >= getNumEntries() * 2)
+        {
+            markAllRecordsDirty();
+            return;
+        }
+
+        recordChanges.push_back({ version + 1, recordIndex });
+    }
+
+    void ShaderTable::markAllRecordsDirty()
+    {
+        allRecordsDirtyVersion = version + 1;
+        recordChanges.clear();
+    }
+
+    bool ShaderTable::reserveBuffer(uint32_t numEntries)
+    {
+        if (!desc.isCached || (buffer && bufferCapacity >= numEntries))
+            return true;
+
+        const uint32_t capacity = std::max(std::max(desc.maxEntries, numEntries), bufferCapacity * 2);
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = uint64_t(capacity) * pipeline->getShaderTableEntrySize();
+        bufferDesc.canHaveUAVs = desc.allowGpuWrites;
+        bufferDesc.initialState = ResourceStates::ShaderResource;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = desc.debugName;
+
+        BufferHandle newBuffer = m_Device->createBuffer(bufferDesc);
+        if (!newBuffer)
+        {
+            std::stringstream ss;
+            ss << "Couldn't create a buffer for shader table " << utils::DebugNameToString(desc.debugName)
+                << " with " << capacity << " records";
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        buffer = checked_cast<Buffer*>(newBuffer.Get());
+        bufferCapacity = capacity;
+
+        // The records written on the GPU are lost as well, the application has to fill the new buffer
+        markAllRecordsDirty();
+        return true;
+    }
+
+    void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        Entry entry;
+        if (makeEntry(exportName, bindings, entry))
         {
-            rayGenerationShader.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            rayGenerationShader.localBindings = bindings;
+            rayGenerationShader = entry;
+            markRecordDirty(0);
 
             ++version;
         }
@@ -264,15 +391,17 @@ namespace nvrhi::d3d12
 
     int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
-
-        if (verifyExport(pipelineExport, bindings))
+        Entry entry;
+        if (makeEntry(exportName, bindings, entry) && reserveBuffer(getNumEntries() + 1))
         {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
             missShaders.push_back(entry);
 
+            // Adding a record in the middle of the table moves all the records that follow it
+            if (hitGroups.empty() && callableShaders.empty())
+                markRecordDirty(getNumEntries() - 1);
+            else
+                markAllRecordsDirty();
+
             ++version;
 
             return int(missShaders.size()) - 1;
@@ -283,15 +412,16 @@ namespace nvrhi::d3d12
 
     int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
-
-        if (verifyExport(pipelineExport, bindings))
+        Entry entry;
+        if (makeEntry(exportName, bindings, entry) && reserveBuffer(getNumEntries() + 1))
         {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
             hitGroups.push_back(entry);
 
+            if (callableShaders.empty())
+                markRecordDirty(getNumEntries() - 1);
+            else
+                markAllRecordsDirty();
+
             ++version;
 
             return int(hitGroups.size()) - 1;
@@ -302,14 +432,11 @@ namespace nvrhi::d3d12
 
     int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
-
-        if (verifyExport(pipelineExport, bindings))
+        Entry entry;
+        if (makeEntry(exportName, bindings, entry) && reserveBuffer(getNumEntries() + 1))
         {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
             callableShaders.push_back(entry);
+            markRecordDirty(getNumEntries() - 1);
 
             ++version;
 
@@ -319,20 +446,80 @@ namespace nvrhi::d3d12
         return -1;
     }
 
+    bool ShaderTable::setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (index >= missShaders.size())
+        {
+            m_Context.error("Miss shader index is out of bounds");
+            return false;
+        }
+
+        Entry entry;
+        if (!makeEntry(exportName, bindings, entry))
+            return false;
+
+        missShaders[index] = entry;
+        markRecordDirty(1 + index);
+
+        ++version;
+        return true;
+    }
+
+    bool ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (index >= hitGroups.size())
+        {
+            m_Context.error("Hit group index is out of bounds");
+            return false;
+        }
+
+        Entry entry;
+        if (!makeEntry(exportName, bindings, entry))
+            return false;
+
+        hitGroups[index] = entry;
+        markRecordDirty(1 + uint32_t(missShaders.size()) + index);
+
+        ++version;
+        return true;
+    }
+
+    bool ShaderTable::setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (index >= callableShaders.size())
+        {
+            m_Context.error("Callable shader index is out of bounds");
+            return false;
+        }
+
+        Entry entry;
+        if (!makeEntry(exportName, bindings, entry))
+            return false;
+
+        callableShaders[index] = entry;
+        markRecordDirty(1 + uint32_t(missShaders.size() + hitGroups.size()) + index);
+
+        ++version;
+        return true;
+    }
+
     void ShaderTable::clearMissShaders()
     {
         missShaders.clear();
+        markAllRecordsDirty();
         ++version;
     }
 
     void ShaderTable::clearHitShaders()
     {
         hitGroups.clear();
+        markAllRecordsDirty();
         ++version;
     }
 
     void ShaderTable::clearCallableShaders()
     {
+        // Callable records are the last ones, so clearing them doesn't move any other record
         callableShaders.clear();
         ++version;
     }
@@ -356,7 +543,31 @@ namespace nvrhi::d3d12
 
     rt::ShaderTableHandle RayTracingPipeline::createShaderTable()
     { 
-        return rt::ShaderTableHandle::Create(new ShaderTable(m_Context, this));
+        return createShaderTable(rt::ShaderTableDesc());
+    }
+
+    rt::ShaderTableHandle RayTracingPipeline::createShaderTable(const rt::ShaderTableDesc& tableDesc)
+    {
+        if (tableDesc.allowGpuWrites && !tableDesc.isCached)
+        {
+            m_Context.error("ShaderTableDesc::allowGpuWrites requires a cached shader table");
+            return nullptr;
+        }
+
+        ShaderTable* shaderTable = new ShaderTable(m_Context, m_Device, this, tableDesc);
+        rt::ShaderTableHandle handle = rt::ShaderTableHandle::Create(shaderTable);
+
+        // Create the buffer upfront so that it can be filled on the GPU before the first use
+        if (tableDesc.isCached && !shaderTable->reserveBuffer(std::max(tableDesc.maxEntries, 1u)))
+            return nullptr;
+
+        return handle;
+    }
+
+    const void* RayTracingPipeline::getShaderIdentifier(const char* exportName)
+    {
+        const ExportTableEntry* pipelineExport = getExport(exportName);
+        return pipelineExport ? pipelineExport->pShaderIdentifier : nullptr;
     }
 
     uint32_t RayTracingPipeline::getShaderTableEntrySize() const
@@ -376,6 +587,9 @@ namespace nvrhi::d3d12
             rtxmuId = ~0ull;
         }
 #endif // NVRHI_WITH_RTXMU
+
+        if (pool)
+            pool->release(poolAllocation);
     }
 
     Object OpacityMicromap::getNativeObject(ObjectType objectType)
@@ -405,7 +619,7 @@ namespace nvrhi::d3d12
         if (!desc.isTopLevel)
             return m_Context.rtxMemUtil->GetAccelStructGPUVA(rtxmuId);
 #endif
-        return dataBuffer->gpuVA;
+        return getDataGpuVA();
     }
 
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
@@ -432,6 +646,50 @@ namespace nvrhi::d3d12
     }
 #endif
 
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+    static const D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY* CastToHistogramEntry(const nvrhi::rt::OpacityMicromapUsageCount* desc)
+    {
+        static_assert(sizeof(nvrhi::rt::OpacityMicromapUsageCount) == sizeof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY));
+        static_assert(offsetof(nvrhi::rt::OpacityMicromapUsageCount, count) == offsetof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY, Count));
+        static_assert(sizeof(nvrhi::rt::OpacityMicromapUsageCount::count) == sizeof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY::Count));
+        static_assert(offsetof(nvrhi::rt::OpacityMicromapUsageCount, subdivisionLevel) == offsetof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY, SubdivisionLevel));
+        static_assert(sizeof(nvrhi::rt::OpacityMicromapUsageCount::subdivisionLevel) == sizeof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY::SubdivisionLevel));
+        static_assert(offsetof(nvrhi::rt::OpacityMicromapUsageCount, format) == offsetof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY, Format));
+        static_assert(sizeof(nvrhi::rt::OpacityMicromapUsageCount::format) == sizeof(D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY::Format));
+        return reinterpret_cast<const D3D12_RAYTRACING_OPACITY_MICROMAP_HISTOGRAM_ENTRY*>(desc);
+    }
+
+    static D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS convertOpacityMicromapBuildFlags(rt::OpacityMicromapBuildFlags flags)
+    {
+        // Unlike the NVAPI flags, the core OMM array build shares its flags with acceleration structures
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS result = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
+        if ((flags & rt::OpacityMicromapBuildFlags::FastTrace) != 0)
+            result |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        if ((flags & rt::OpacityMicromapBuildFlags::FastBuild) != 0)
+            result |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD;
+        return result;
+    }
+
+    // outArrayDesc must outlive outInputs, which only references it
+    static void fillNativeOpacityMicromapInputs(
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& outInputs,
+        D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC& outArrayDesc,
+        const rt::OpacityMicromapDesc& desc)
+    {
+        outArrayDesc.NumOmmHistogramEntries = (UINT)desc.counts.size();
+        outArrayDesc.pOmmHistogram = CastToHistogramEntry(desc.counts.data());
+        outArrayDesc.InputBuffer = checked_cast<Buffer*>(desc.inputBuffer)->gpuVA + desc.inputBufferOffset;
+        outArrayDesc.PerOmmDescs = { checked_cast<Buffer*>(desc.perOmmDescs)->gpuVA + desc.perOmmDescsOffset, sizeof(D3D12_RAYTRACING_OPACITY_MICROMAP_DESC) };
+
+        outInputs = {};
+        outInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_OPACITY_MICROMAP_ARRAY;
+        outInputs.Flags = convertOpacityMicromapBuildFlags(desc.flags);
+        outInputs.NumDescs = 1;
+        outInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        outInputs.pOpacityMicromapArrayDesc = &outArrayDesc;
+    }
+#endif
+
     static void fillD3dGeometryTrianglesDesc(D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC& outDxrTriangles, const rt::GeometryDesc& geometryDesc, D3D12_GPU_VIRTUAL_ADDRESS transform4x4)
     {
         const auto& triangles = geometryDesc.geometryData.triangles;
@@ -494,7 +752,22 @@ namespace nvrhi::d3d12
     }
 #endif
 
-    static void fillD3dGeometryDesc(D3D12RaytracingGeometryDesc& outD3dGeometryDesc, const rt::GeometryDesc& geometryDesc, D3D12_GPU_VIRTUAL_ADDRESS transform4x4)
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+    static void fillNativeOmmLinkageDesc(D3D12_RAYTRACING_GEOMETRY_OMM_LINKAGE_DESC& ommLinkage, const rt::GeometryDesc& geometryDesc)
+    {
+        const auto& triangles = geometryDesc.geometryData.triangles;
+
+        // The core API derives the OMM usage from the index buffer, so pOmmUsageCounts is not forwarded here.
+        ommLinkage.OpacityMicromapArray = triangles.opacityMicromap == nullptr ? 0 : checked_cast<OpacityMicromap*>(triangles.opacityMicromap)->getDeviceAddress();
+        ommLinkage.OpacityMicromapBaseLocation = 0;
+        ommLinkage.OpacityMicromapIndexBuffer.StartAddress = triangles.ommIndexBuffer == nullptr ? 0 : checked_cast<Buffer*>(triangles.ommIndexBuffer)->gpuVA + triangles.ommIndexBufferOffset;
+        ommLinkage.OpacityMicromapIndexBuffer.StrideInBytes = triangles.ommIndexFormat == Format::R32_UINT ? 4 : 2;
+        ommLinkage.OpacityMicromapIndexFormat = getDxgiFormatMapping(triangles.ommIndexFormat).srvFormat;
+    }
+#endif
+
+    static void fillD3dGeometryDesc(D3D12RaytracingGeometryDesc& outD3dGeometryDesc, const rt::GeometryDesc& geometryDesc, D3D12_GPU_VIRTUAL_ADDRESS transform4x4,
+        [[maybe_unused]] bool nativeOpacityMicromaps)
     {
         outD3dGeometryDesc.SetFlags((D3D12_RAYTRACING_GEOMETRY_FLAGS)geometryDesc.flags);
 
@@ -502,6 +775,17 @@ namespace nvrhi::d3d12
         {
             const auto& triangles = geometryDesc.geometryData.triangles;
             if (triangles.opacityMicromap != nullptr || triangles.ommIndexBuffer != nullptr) {
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+                if (nativeOpacityMicromaps)
+                {
+                    D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC dxrTriangles = {};
+                    D3D12_RAYTRACING_GEOMETRY_OMM_LINKAGE_DESC ommLinkage = {};
+                    fillD3dGeometryTrianglesDesc(dxrTriangles, geometryDesc, transform4x4);
+                    fillNativeOmmLinkageDesc(ommLinkage, geometryDesc);
+                    outD3dGeometryDesc.SetNativeOMMTriangles(dxrTriangles, ommLinkage);
+                    return;
+                }
+#endif
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
                 NVAPI_D3D12_RAYTRACING_GEOMETRY_OMM_TRIANGLES_DESC ommTriangles = {};
                 fillD3dGeometryTrianglesDesc(ommTriangles.triangles, geometryDesc, transform4x4);
@@ -527,7 +811,8 @@ namespace nvrhi::d3d12
 
     static void fillAsInputDescForPreBuildInfo(
         D3D12BuildRaytracingAccelerationStructureInputs& outASInputs,
-        const rt::AccelStructDesc& desc)
+        const rt::AccelStructDesc& desc,
+        bool nativeOpacityMicromaps)
     {
         if (desc.isTopLevel)
         {
@@ -550,28 +835,61 @@ namespace nvrhi::d3d12
                 // Omitting this here will trigger a gpu hang due to incorrect memory calculation.
                 D3D12_GPU_VIRTUAL_ADDRESS transform4x4 = srcDesc.useTransform ? 16 : 0; 
                 D3D12RaytracingGeometryDesc& geomDesc = outASInputs.GetGeometryDesc(i);
-                fillD3dGeometryDesc(geomDesc, srcDesc, transform4x4);
+                fillD3dGeometryDesc(geomDesc, srcDesc, transform4x4, nativeOpacityMicromaps);
             }
         }
     }
 
-    rt::OpacityMicromapHandle Device::createOpacityMicromap([[maybe_unused]] const rt::OpacityMicromapDesc& desc)
+    bool Device::GetOpacityMicromapPreBuildInfo([[maybe_unused]] D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO& outPreBuildInfo, [[maybe_unused]] const rt::OpacityMicromapDesc& desc) const
     {
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        if (m_Context.nativeOpacityMicromapsEnabled)
+        {
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs;
+            D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC arrayDesc = {};
+            fillNativeOpacityMicromapInputs(inputs, arrayDesc, desc);
+
+            m_Context.device5->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &outPreBuildInfo);
+            return true;
+        }
+#endif
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
-        assert(m_OpacityMicromapSupported && "Opacity Micromap not supported");
-        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
-        fillD3dOpacityMicromapDesc(inputs, desc);
+        if (m_NvapiIsInitialized)
+        {
+            NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
+            fillD3dOpacityMicromapDesc(inputs, desc);
 
-        NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO omPreBuildInfo = {};
+            NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO omPreBuildInfo = {};
 
-        NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS params = {};
-        params.version = NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS_VER;
-        params.pDesc = &inputs;
-        params.pInfo = &omPreBuildInfo;
-        NvAPI_Status status = NvAPI_D3D12_GetRaytracingOpacityMicromapArrayPrebuildInfo(m_Context.device5.Get(), &params);
-        assert(status == S_OK);
-        if (status != S_OK)
+            NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS params = {};
+            params.version = NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS_VER;
+            params.pDesc = &inputs;
+            params.pInfo = &omPreBuildInfo;
+            NvAPI_Status status = NvAPI_D3D12_GetRaytracingOpacityMicromapArrayPrebuildInfo(m_Context.device5.Get(), &params);
+            assert(status == S_OK);
+            if (status != S_OK)
+                return false;
+
+            outPreBuildInfo.ResultDataMaxSizeInBytes = omPreBuildInfo.resultDataMaxSizeInBytes;
+            outPreBuildInfo.ScratchDataSizeInBytes = omPreBuildInfo.scratchDataSizeInBytes;
+            outPreBuildInfo.UpdateScratchDataSizeInBytes = 0;
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    rt::OpacityMicromapHandle Device::createOpacityMicromap([[maybe_unused]] const rt::OpacityMicromapDesc& desc)
+    {
+#if NVRHI_WITH_NVAPI_OPACITY_MICROMAP || NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        assert(m_OpacityMicromapSupported && "Opacity Micromap not supported");
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO omPreBuildInfo = {};
+        if (!GetOpacityMicromapPreBuildInfo(omPreBuildInfo, desc))
+        {
+            m_Context.error("Couldn't get the prebuild info for an opacity micromap; OMMs are not supported by the device");
             return nullptr;
+        }
 
         OpacityMicromap* om = new OpacityMicromap(m_Context);
         om->desc = desc;
@@ -580,7 +898,7 @@ namespace nvrhi::d3d12
         {
             BufferDesc bufferDesc;
             bufferDesc.canHaveUAVs = true;
-            bufferDesc.byteSize = omPreBuildInfo.resultDataMaxSizeInBytes;
+            bufferDesc.byteSize = omPreBuildInfo.ResultDataMaxSizeInBytes;
             bufferDesc.initialState = ResourceStates::OpacityMicromapWrite;
             bufferDesc.keepInitialState = true;
             bufferDesc.isAccelStructStorage = true;
@@ -588,7 +906,11 @@ namespace nvrhi::d3d12
             bufferDesc.isVirtual = false;
             BufferHandle buffer = createBuffer(bufferDesc);
             om->dataBuffer = checked_cast<Buffer*>(buffer.Get());
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+            assert((om->dataBuffer->gpuVA % D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_BYTE_ALIGNMENT) == 0);
+#else
             assert((om->dataBuffer->gpuVA % NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_BYTE_ALIGNMENT) == 0);
+#endif
         }
         return rt::OpacityMicromapHandle::Create(om);
 #else
@@ -600,10 +922,10 @@ namespace nvrhi::d3d12
     bool Device::GetAccelStructPreBuildInfo(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO& outPreBuildInfo, const rt::AccelStructDesc& desc) const
     {
         D3D12BuildRaytracingAccelerationStructureInputs ASInputs;
-        fillAsInputDescForPreBuildInfo(ASInputs, desc);
+        fillAsInputDescForPreBuildInfo(ASInputs, desc, m_Context.nativeOpacityMicromapsEnabled);
 
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
-        if (m_NvapiIsInitialized)
+        if (m_NvapiIsInitialized && !m_Context.nativeOpacityMicromapsEnabled)
         {
             const NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX inputs = ASInputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
 
@@ -644,17 +966,47 @@ namespace nvrhi::d3d12
 #endif
 
         if (needBuffer)
+        {
+            const bool suballocate = desc.allowSuballocation && !desc.isTopLevel && !desc.isVirtual;
+
+            if (suballocate && m_AccelStructPool.allocate(ASPreBuildInfo.ResultDataMaxSizeInBytes, as->poolAllocation))
+            {
+                as->pool = &m_AccelStructPool;
+                as->dataBuffer = checked_cast<Buffer*>(as->poolAllocation.buffer.Get());
+                as->dataOffset = as->poolAllocation.offset;
+            }
+            else
+            {
+                BufferDesc bufferDesc;
+                bufferDesc.canHaveUAVs = true;
+                bufferDesc.byteSize = ASPreBuildInfo.ResultDataMaxSizeInBytes;
+                bufferDesc.initialState = desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
+                bufferDesc.keepInitialState = true;
+                bufferDesc.isAccelStructStorage = true;
+                bufferDesc.debugName = desc.debugName;
+                bufferDesc.isVirtual = desc.isVirtual;
+                BufferHandle buffer = createBuffer(bufferDesc);
+                as->dataBuffer = checked_cast<Buffer*>(buffer.Get());
+            }
+
+            as->dataSize = ASPreBuildInfo.ResultDataMaxSizeInBytes;
+        }
+
+        if (desc.isTopLevel && desc.persistentInstanceBuffer)
         {
             BufferDesc bufferDesc;
-            bufferDesc.canHaveUAVs = true;
-            bufferDesc.byteSize = ASPreBuildInfo.ResultDataMaxSizeInBytes;
-            bufferDesc.initialState = desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
+            bufferDesc.byteSize = std::max<uint64_t>(desc.topLevelMaxInstances, 1) * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+            bufferDesc.isAccelStructBuildInput = true;
+            bufferDesc.initialState = ResourceStates::AccelStructBuildInput;
             bufferDesc.keepInitialState = true;
-            bufferDesc.isAccelStructStorage = true;
-            bufferDesc.debugName = desc.debugName;
-            bufferDesc.isVirtual = desc.isVirtual;
+            bufferDesc.debugName = desc.debugName + " instances";
             BufferHandle buffer = createBuffer(bufferDesc);
-            as->dataBuffer = checked_cast<Buffer*>(buffer.Get());
+            if (!buffer)
+            {
+                delete as;
+                return nullptr;
+            }
+            as->instanceBuffer = checked_cast<Buffer*>(buffer.Get());
         }
         
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the Desc
@@ -693,13 +1045,38 @@ namespace nvrhi::d3d12
         return false;
     }
 
+    void AccelStruct::setInstanceBlas(size_t index, AccelStruct* blas)
+    {
+        AccelStruct* previous = instanceBlases[index];
+        if (previous == blas)
+            return;
+
+        if (previous)
+        {
+            auto it = uniqueBlases.find(previous);
+            assert(it != uniqueBlases.end());
+            if (--it->second.numInstances == 0)
+                uniqueBlases.erase(it);
+        }
+
+        if (blas)
+        {
+            BlasReference& reference = uniqueBlases[blas];
+            if (!reference.handle)
+                reference.handle = blas;
+            ++reference.numInstances;
+        }
+
+        instanceBlases[index] = blas;
+    }
+
     void AccelStruct::createSRV(size_t descriptor) const
     {
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
         srvDesc.Format = DXGI_FORMAT_UNKNOWN;
         srvDesc.ViewDimension = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
         srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.RaytracingAccelerationStructure.Location = dataBuffer->gpuVA;
+        srvDesc.RaytracingAccelerationStructure.Location = getDataGpuVA();
 
         m_Context.device->CreateShaderResourceView(nullptr, &srvDesc, { descriptor });
     }
@@ -732,7 +1109,7 @@ namespace nvrhi::d3d12
     
     rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
     {
-        RayTracingPipeline* pso = new RayTracingPipeline(m_Context);
+        RayTracingPipeline* pso = new RayTracingPipeline(m_Context, this);
         pso->desc = desc;
         pso->maxLocalRootParameters = 0;
 
@@ -910,13 +1287,35 @@ namespace nvrhi::d3d12
 
         // Subobject: Pipeline config
 
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        // Core OMMs are ignored by TraceRay unless the pipeline opts in, which needs the CONFIG1 subobject
+        D3D12_RAYTRACING_PIPELINE_CONFIG1 d3dPipelineConfig = {};
+        d3dPipelineConfig.MaxTraceRecursionDepth = desc.maxRecursionDepth;
+        d3dPipelineConfig.Flags = m_Context.nativeOpacityMicromapsEnabled
+            ? D3D12_RAYTRACING_PIPELINE_FLAG_ALLOW_OPACITY_MICROMAPS
+            : D3D12_RAYTRACING_PIPELINE_FLAG_NONE;
+
+        d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG1;
+#else
         D3D12_RAYTRACING_PIPELINE_CONFIG d3dPipelineConfig = {};
         d3dPipelineConfig.MaxTraceRecursionDepth = desc.maxRecursionDepth;
 
         d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG;
+#endif
         d3dSubobject.pDesc = &d3dPipelineConfig;
         d3dSubobjects.push_back(d3dSubobject);
 
+        // Subobject: Node mask, see DeviceDesc::nodeMask
+
+        D3D12_NODE_MASK d3dNodeMask = { m_Context.nodeMask };
+
+        if (m_Context.nodeMask != 0)
+        {
+            d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_NODE_MASK;
+            d3dSubobject.pDesc = &d3dNodeMask;
+            d3dSubobjects.push_back(d3dSubobject);
+        }
+
         // Subobjects: DXIL libraries
 
         for (const D3D12_DXIL_LIBRARY_DESC& d3dLibraryDesc : d3dDxilLibraries)
@@ -1076,101 +1475,235 @@ namespace nvrhi::d3d12
         return rt::PipelineHandle::Create(pso);
     }
 
-    void CommandList::setRayTracingState(const rt::State& state)
+    static void fillDispatchRaysTemplate(D3D12_DISPATCH_RAYS_DESC& drd, const ShaderTable& shaderTable, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, uint32_t entrySize)
     {
-        ShaderTable* shaderTable = checked_cast<ShaderTable*>(state.shaderTable);
-        RayTracingPipeline* pso = shaderTable->pipeline;
+        memset(&drd, 0, sizeof(D3D12_DISPATCH_RAYS_DESC));
 
-        ShaderTableState* shaderTableState = getShaderTableStateTracking(shaderTable);
+        drd.RayGenerationShaderRecord.StartAddress = gpuVA;
+        drd.RayGenerationShaderRecord.SizeInBytes = entrySize;
+        gpuVA += entrySize;
 
-        bool rebuildShaderTable = shaderTableState->committedVersion != shaderTable->version ||
-            shaderTableState->descriptorHeapSRV != m_Resources.shaderResourceViewHeap.getShaderVisibleHeap() ||
-            shaderTableState->descriptorHeapSamplers != m_Resources.samplerHeap.getShaderVisibleHeap();
+        if (!shaderTable.missShaders.empty())
+        {
+            drd.MissShaderTable.StartAddress = gpuVA;
+            drd.MissShaderTable.StrideInBytes = (shaderTable.missShaders.size() == 1) ? 0 : entrySize;
+            drd.MissShaderTable.SizeInBytes = uint32_t(shaderTable.missShaders.size()) * entrySize;
+            gpuVA += drd.MissShaderTable.SizeInBytes;
+        }
 
-        if (rebuildShaderTable)
+        if (!shaderTable.hitGroups.empty())
         {
-            uint32_t entrySize = pso->getShaderTableEntrySize();
-            uint32_t sbtSize = shaderTable->getNumEntries() * entrySize;
+            drd.HitGroupTable.StartAddress = gpuVA;
+            drd.HitGroupTable.StrideInBytes = (shaderTable.hitGroups.size() == 1) ? 0 : entrySize;
+            drd.HitGroupTable.SizeInBytes = uint32_t(shaderTable.hitGroups.size()) * entrySize;
+            gpuVA += drd.HitGroupTable.SizeInBytes;
+        }
 
-            unsigned char* cpuVA;
-            D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
-            if (!m_UploadManager.suballocateBuffer(sbtSize, nullptr, nullptr, nullptr, 
-                (void**)&cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT))
+        if (!shaderTable.callableShaders.empty())
+        {
+            drd.CallableShaderTable.StartAddress = gpuVA;
+            drd.CallableShaderTable.StrideInBytes = (shaderTable.callableShaders.size() == 1) ? 0 : entrySize;
+            drd.CallableShaderTable.SizeInBytes = uint32_t(shaderTable.callableShaders.size()) * entrySize;
+        }
+    }
+
+    bool CommandList::writeShaderTableRecord(uint8_t* cpuVA, const ShaderTable::Entry& entry)
+    {
+        memcpy(cpuVA, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+
+        if (entry.localBindings)
+        {
+            d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
+            d3d12::BindingLayout* layout = bindingSet->layout;
+
+            if (layout->descriptorTableSizeSamplers > 0)
             {
-                m_Context.error("Couldn't suballocate an upload buffer");
-                return;
+                auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+                *pTable = m_Resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
             }
 
-            uint32_t entryIndex = 0;
+            if (layout->descriptorTableSizeSRVetc > 0)
+            {
+                auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+                *pTable = m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
+            }
 
-            auto writeEntry = [this, entrySize, &cpuVA, &gpuVA, &entryIndex](const ShaderTable::Entry& entry) 
+            for (const d3d12::BindingSet::RootDescriptorBinding& rootDescriptor : bindingSet->rootDescriptors)
             {
-                memcpy(cpuVA, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+                auto pAddress = reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + rootDescriptor.rootParameterIndex * sizeof(D3D12_GPU_VIRTUAL_ADDRESS));
+                *pAddress = rootDescriptor.address;
+            }
 
-                if (entry.localBindings)
-                {
-                    d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
-                    d3d12::BindingLayout* layout = bindingSet->layout;
+            if (!layout->rootParametersVolatileCB.empty())
+            {
+                m_Context.error("Cannot use Volatile CBs in a shader binding table");
+                return false;
+            }
+        }
 
-                    if (layout->descriptorTableSizeSamplers > 0)
-                    {
-                        auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                        *pTable = m_Resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
-                    }
+        return true;
+    }
 
-                    if (layout->descriptorTableSizeSRVetc > 0)
-                    {
-                        auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                        *pTable = m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
-                    }
+    bool CommandList::updateCachedShaderTable(ShaderTable* shaderTable, ShaderTableState* shaderTableState)
+    {
+        const uint32_t entrySize = shaderTable->pipeline->getShaderTableEntrySize();
+        const uint32_t numEntries = shaderTable->getNumEntries();
 
-                    if (!layout->rootParametersVolatileCB.empty())
-                    {
-                        m_Context.error("Cannot use Volatile CBs in a shader binding table");
-                        return;
-                    }
-                }
+        if (!shaderTable->buffer || shaderTable->bufferCapacity < numEntries)
+        {
+            m_Context.error("The buffer of a cached shader table couldn't be created");
+            return false;
+        }
 
-                cpuVA += entrySize;
-                gpuVA += entrySize;
-                entryIndex += 1;
-            };
+        ID3D12DescriptorHeap* heapSRV = m_Resources.shaderResourceViewHeap.getShaderVisibleHeap();
+        ID3D12DescriptorHeap* heapSamplers = m_Resources.samplerHeap.getShaderVisibleHeap();
 
-            D3D12_DISPATCH_RAYS_DESC& drd = shaderTableState->dispatchRaysTemplate;
-            memset(&drd, 0, sizeof(D3D12_DISPATCH_RAYS_DESC));
+        // Other command lists might have copied the records into the buffer, but that order is only
+        // known at execution time, so this command list copies everything it hasn't copied itself.
+        auto cachedStateIt = m_CachedShaderTableStates.find(shaderTable->cacheId);
+        const bool firstUse = cachedStateIt == m_CachedShaderTableStates.end();
+        if (firstUse)
+        {
+            // The entries of destroyed tables are never looked up again, drop them all once in a while
+            if (m_CachedShaderTableStates.size() >= c_MaxCachedShaderTableStates)
+                m_CachedShaderTableStates.clear();
 
-            drd.RayGenerationShaderRecord.StartAddress = gpuVA;
-            drd.RayGenerationShaderRecord.SizeInBytes = entrySize;
-            writeEntry(shaderTable->rayGenerationShader);
-            
-            if (!shaderTable->missShaders.empty())
+            cachedStateIt = m_CachedShaderTableStates.emplace(shaderTable->cacheId, CachedShaderTableState()).first;
+        }
+        CachedShaderTableState& cachedState = cachedStateIt->second;
+
+        // The records reference descriptor tables in the shader-visible heaps
+        const bool copyAllRecords = firstUse
+            || cachedState.committedVersion < shaderTable->allRecordsDirtyVersion
+            || cachedState.descriptorHeapSRV != heapSRV
+            || cachedState.descriptorHeapSamplers != heapSamplers;
+
+        std::vector<uint32_t>& dirtyRecords = m_ShaderTableDirtyRecords;
+        dirtyRecords.clear();
+        if (copyAllRecords)
+        {
+            dirtyRecords.resize(numEntries);
+            for (uint32_t recordIndex = 0; recordIndex < numEntries; recordIndex++)
+                dirtyRecords[recordIndex] = recordIndex;
+        }
+        else if (cachedState.committedVersion != shaderTable->version)
+        {
+            const auto& changes = shaderTable->recordChanges;
+            auto change = std::upper_bound(changes.begin(), changes.end(), cachedState.committedVersion,
+                [](uint32_t version, const ShaderTable::RecordChange& c) { return version < c.version; });
+            for (; change != changes.end(); ++change)
+                dirtyRecords.push_back(change->recordIndex);
+
+            std::sort(dirtyRecords.begin(), dirtyRecords.end());
+            dirtyRecords.erase(std::unique(dirtyRecords.begin(), dirtyRecords.end()), dirtyRecords.end());
+        }
+
+        // Records reserved for GPU writes are owned by the application
+        dirtyRecords.erase(std::remove_if(dirtyRecords.begin(), dirtyRecords.end(), [shaderTable, numEntries](uint32_t recordIndex)
             {
-                drd.MissShaderTable.StartAddress = gpuVA;
-                drd.MissShaderTable.StrideInBytes = (shaderTable->missShaders.size() == 1) ? 0 : entrySize;
-                drd.MissShaderTable.SizeInBytes = uint32_t(shaderTable->missShaders.size()) * entrySize;
+                return recordIndex >= numEntries || shaderTable->getRecord(recordIndex).pShaderIdentifier == nullptr;
+            }), dirtyRecords.end());
 
-                for (auto& entry : shaderTable->missShaders)
-                    writeEntry(entry);
-            }
+        if (!dirtyRecords.empty())
+        {
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(shaderTable->buffer, ResourceStates::CopyDest);
+            commitBarriers();
 
-            if (!shaderTable->hitGroups.empty())
+            // Copy each run of consecutive dirty records with a single upload
+            size_t runStart = 0;
+            while (runStart < dirtyRecords.size())
             {
-                drd.HitGroupTable.StartAddress = gpuVA;
-                drd.HitGroupTable.StrideInBytes = (shaderTable->hitGroups.size() == 1) ? 0 : entrySize;
-                drd.HitGroupTable.SizeInBytes = uint32_t(shaderTable->hitGroups.size()) * entrySize;
+                size_t runEnd = runStart + 1;
+                while (runEnd < dirtyRecords.size() && dirtyRecords[runEnd] == dirtyRecords[runEnd - 1] + 1)
+                    ++runEnd;
+
+                const uint32_t firstRecord = dirtyRecords[runStart];
+                const uint32_t numRecords = uint32_t(runEnd - runStart);
+                const uint64_t runSize = uint64_t(numRecords) * entrySize;
+
+                ID3D12Resource* uploadBuffer = nullptr;
+                size_t uploadOffset = 0;
+                uint8_t* cpuVA = nullptr;
+                if (!m_UploadManager.suballocateBuffer(runSize, nullptr, &uploadBuffer, &uploadOffset, (void**)&cpuVA, nullptr,
+                    m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT))
+                {
+                    m_Context.error("Couldn't suballocate an upload buffer");
+                    return false;
+                }
 
-                for (auto& entry : shaderTable->hitGroups)
-                    writeEntry(entry);
+                for (uint32_t i = 0; i < numRecords; i++)
+                {
+                    if (!writeShaderTableRecord(cpuVA + uint64_t(i) * entrySize, shaderTable->getRecord(firstRecord + i)))
+                        return false;
+                }
+
+                suspendPredication();
+                m_ActiveCommandList->commandList->CopyBufferRegion(shaderTable->buffer->resource, uint64_t(firstRecord) * entrySize,
+                    uploadBuffer, uploadOffset, runSize);
+                resumePredication();
+
+                runStart = runEnd;
             }
+        }
 
-            if (!shaderTable->callableShaders.empty())
+        cachedState.committedVersion = shaderTable->version;
+        cachedState.descriptorHeapSRV = heapSRV;
+        cachedState.descriptorHeapSamplers = heapSamplers;
+
+        if (m_EnableAutomaticBarriers)
+            requireBufferState(shaderTable->buffer, ResourceStates::ShaderResource);
+
+        const D3D12_GPU_VIRTUAL_ADDRESS tableGpuVA = shaderTable->buffer->gpuVA;
+        if (shaderTableState->committedVersion != shaderTable->version ||
+            shaderTableState->dispatchRaysTemplate.RayGenerationShaderRecord.StartAddress != tableGpuVA)
+        {
+            fillDispatchRaysTemplate(shaderTableState->dispatchRaysTemplate, *shaderTable, tableGpuVA, entrySize);
+            shaderTableState->committedVersion = shaderTable->version;
+
+            // The buffer is referenced separately because the table replaces it when it grows
+            m_Instance->referencedResources.push_back(shaderTable);
+            m_Instance->referencedResources.push_back(shaderTable->buffer);
+        }
+
+        return true;
+    }
+
+    void CommandList::setRayTracingState(const rt::State& state)
+    {
+        ShaderTable* shaderTable = checked_cast<ShaderTable*>(state.shaderTable);
+        RayTracingPipeline* pso = shaderTable->pipeline;
+
+        ShaderTableState* shaderTableState = getShaderTableStateTracking(shaderTable);
+
+        if (shaderTable->desc.isCached)
+        {
+            if (!updateCachedShaderTable(shaderTable, shaderTableState))
+                return;
+        }
+        else if (shaderTableState->committedVersion != shaderTable->version ||
+            shaderTableState->descriptorHeapSRV != m_Resources.shaderResourceViewHeap.getShaderVisibleHeap() ||
+            shaderTableState->descriptorHeapSamplers != m_Resources.samplerHeap.getShaderVisibleHeap())
+        {
+            uint32_t entrySize = pso->getShaderTableEntrySize();
+            uint32_t sbtSize = shaderTable->getNumEntries() * entrySize;
+
+            unsigned char* cpuVA;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
+            if (!m_UploadManager.suballocateBuffer(sbtSize, nullptr, nullptr, nullptr, 
+                (void**)&cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT))
             {
-                drd.CallableShaderTable.StartAddress = gpuVA;
-                drd.CallableShaderTable.StrideInBytes = (shaderTable->callableShaders.size() == 1) ? 0 : entrySize;
-                drd.CallableShaderTable.SizeInBytes = uint32_t(shaderTable->callableShaders.size()) * entrySize;
+                m_Context.error("Couldn't suballocate an upload buffer");
+                return;
+            }
+
+            fillDispatchRaysTemplate(shaderTableState->dispatchRaysTemplate, *shaderTable, gpuVA, entrySize);
 
-                for (auto& entry : shaderTable->callableShaders)
-                    writeEntry(entry);
+            const uint32_t numEntries = shaderTable->getNumEntries();
+            for (uint32_t recordIndex = 0; recordIndex < numEntries; recordIndex++)
+            {
+                writeShaderTableRecord(cpuVA, shaderTable->getRecord(recordIndex));
+                cpuVA += entrySize;
             }
 
             shaderTableState->committedVersion = shaderTable->version;
@@ -1203,6 +1736,7 @@ namespace nvrhi::d3d12
 
         if (updatePipeline)
         {
+            m_Statistics.pipelineBinds++;
             m_ActiveCommandList->commandList4->SetPipelineState1(pso->pipelineState);
 
             m_Instance->referencedResources.push_back(pso);
@@ -1214,6 +1748,7 @@ namespace nvrhi::d3d12
 
         m_CurrentComputeStateValid = false;
         m_CurrentGraphicsStateValid = false;
+        m_CurrentWorkGraphStateValid = false;
         m_CurrentRayTracingStateValid = true;
         m_CurrentRayTracingState = state;
 
@@ -1237,11 +1772,12 @@ namespace nvrhi::d3d12
         desc.Height = args.height;
         desc.Depth = args.depth;
 
+        m_Statistics.dispatchCalls++;
         m_ActiveCommandList->commandList4->DispatchRays(&desc);
     }
 
     void CommandList::buildOpacityMicromap([[maybe_unused]] rt::IOpacityMicromap* pOmm, [[maybe_unused]] const rt::OpacityMicromapDesc& desc) {
-#if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
+#if NVRHI_WITH_NVAPI_OPACITY_MICROMAP || NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
         OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pOmm);
 
         if (m_EnableAutomaticBarriers)
@@ -1261,35 +1797,44 @@ namespace nvrhi::d3d12
 
         commitBarriers();
 
-        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
-        fillD3dOpacityMicromapDesc(inputs, desc);
-
-        NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO vmPreBuildInfo = {};
-
-        NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS prebuildParams;
-        prebuildParams.version = NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS_VER;
-        prebuildParams.pDesc = &inputs;
-        prebuildParams.pInfo = &vmPreBuildInfo;
-        NvAPI_Status status = NvAPI_D3D12_GetRaytracingOpacityMicromapArrayPrebuildInfo(m_Context.device5.Get(), &prebuildParams);
-        assert(status == S_OK);
-        if (status != S_OK)
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO vmPreBuildInfo = {};
+        if (!checked_cast<d3d12::Device*>(m_Device)->GetOpacityMicromapPreBuildInfo(vmPreBuildInfo, desc))
             return;
 
         D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (vmPreBuildInfo.scratchDataSizeInBytes != 0)
+        if (vmPreBuildInfo.ScratchDataSizeInBytes != 0)
         {
-            if (!m_DxrScratchManager.suballocateBuffer(vmPreBuildInfo.scratchDataSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+            if (!m_DxrScratchManager.suballocateBuffer(vmPreBuildInfo.ScratchDataSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
                 &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
             {
                 std::stringstream ss;
                 ss << "Couldn't suballocate a scratch buffer for VM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << vmPreBuildInfo.scratchDataSizeInBytes << " bytes of scratch space.";
+                    "The build requires " << vmPreBuildInfo.ScratchDataSizeInBytes << " bytes of scratch space.";
 
                 m_Context.error(ss.str());
                 return;
             }
         }
 
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        if (m_Context.nativeOpacityMicromapsEnabled)
+        {
+            D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC arrayDesc = {};
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            fillNativeOpacityMicromapInputs(buildDesc.Inputs, arrayDesc, desc);
+            buildDesc.DestAccelerationStructureData = omm->getDeviceAddress();
+            buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
+            buildDesc.SourceAccelerationStructureData = 0;
+
+            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            return;
+        }
+#endif
+
+#if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
+        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
+        fillD3dOpacityMicromapDesc(inputs, desc);
+
         NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC nativeDesc = {};
         nativeDesc.destOpacityMicromapArrayData = omm->getDeviceAddress();
         nativeDesc.inputs = inputs;
@@ -1301,192 +1846,292 @@ namespace nvrhi::d3d12
         params.numPostbuildInfoDescs = 0;
         params.pPostbuildInfoDescs = nullptr;
 
-        status = NvAPI_D3D12_BuildRaytracingOpacityMicromapArray(m_ActiveCommandList->commandList4, &params);
+        [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingOpacityMicromapArray(m_ActiveCommandList->commandList4, &params);
         assert(status == S_OK);
+#endif
 #else
         utils::NotSupported();
 #endif
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        const rt::BottomLevelBuildDesc build = rt::BottomLevelBuildDesc()
+            .setAccelStruct(as)
+            .setGeometries(pGeometries, numGeometries)
+            .setBuildFlags(buildFlags);
 
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
-        {
-            assert(as->allowUpdate);
-        }
+        buildBottomLevelAccelStructs(&build, 1);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds)
+    {
+        if (numBuilds == 0)
+            return;
 
-        for (uint32_t i = 0; i < numGeometries; i++)
+        // Transition the inputs of all builds first, so that they are committed in one batch
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            const auto& geometryDesc = pGeometries[i];
-            if (geometryDesc.geometryType == rt::GeometryType::Triangles)
-            {
-                const auto& triangles = geometryDesc.geometryData.triangles;
+            const rt::BottomLevelBuildDesc& build = pBuilds[buildIndex];
 
-                OpacityMicromap* om = triangles.opacityMicromap ? checked_cast<OpacityMicromap*>(triangles.opacityMicromap) : nullptr;
+            if ((build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+            {
+                assert(checked_cast<AccelStruct*>(build.accelStruct)->allowUpdate);
+            }
 
-                if (m_EnableAutomaticBarriers)
+            for (size_t i = 0; i < build.numGeometries; i++)
+            {
+                const auto& geometryDesc = build.geometries[i];
+                if (geometryDesc.geometryType == rt::GeometryType::Triangles)
                 {
-                    requireBufferState(triangles.indexBuffer, ResourceStates::AccelStructBuildInput);
-                    requireBufferState(triangles.vertexBuffer, ResourceStates::AccelStructBuildInput);
-                    if (om)
-                        requireBufferState(om->dataBuffer, ResourceStates::AccelStructBuildInput);
+                    const auto& triangles = geometryDesc.geometryData.triangles;
+
+                    OpacityMicromap* om = triangles.opacityMicromap ? checked_cast<OpacityMicromap*>(triangles.opacityMicromap) : nullptr;
+
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        requireBufferState(triangles.indexBuffer, ResourceStates::AccelStructBuildInput);
+                        requireBufferState(triangles.vertexBuffer, ResourceStates::AccelStructBuildInput);
+                        if (om)
+                            requireBufferState(om->dataBuffer, ResourceStates::AccelStructBuildInput);
+                        if (triangles.ommIndexBuffer)
+                            requireBufferState(triangles.ommIndexBuffer, ResourceStates::AccelStructBuildInput);
+                    }
+
+                    m_Instance->referencedResources.push_back(triangles.indexBuffer);
+                    m_Instance->referencedResources.push_back(triangles.vertexBuffer);
+                    if (om && om->desc.trackLiveness)
+                        m_Instance->referencedResources.push_back(om);
                     if (triangles.ommIndexBuffer)
-                        requireBufferState(triangles.ommIndexBuffer, ResourceStates::AccelStructBuildInput);
+                        m_Instance->referencedResources.push_back(triangles.ommIndexBuffer);
                 }
+                else
+                {
+                    const auto& aabbs = geometryDesc.geometryData.aabbs;
 
-                m_Instance->referencedResources.push_back(triangles.indexBuffer);
-                m_Instance->referencedResources.push_back(triangles.vertexBuffer);
-                if (om && om->desc.trackLiveness)
-                    m_Instance->referencedResources.push_back(om);
-                if (triangles.ommIndexBuffer)
-                    m_Instance->referencedResources.push_back(triangles.ommIndexBuffer);
-            }
-            else
-            {
-                const auto& aabbs = geometryDesc.geometryData.aabbs;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        requireBufferState(aabbs.buffer, ResourceStates::AccelStructBuildInput);
+                    }
 
-                if (m_EnableAutomaticBarriers)
-                {
-                    requireBufferState(aabbs.buffer, ResourceStates::AccelStructBuildInput);
+                    m_Instance->referencedResources.push_back(aabbs.buffer);
                 }
-
-                m_Instance->referencedResources.push_back(aabbs.buffer);
             }
         }
 
-        commitBarriers();
+        struct BlasBuild
+        {
+            AccelStruct* as = nullptr;
+            D3D12BuildRaytracingAccelerationStructureInputs inputs;
+            uint64_t scratchSize = 0;
+            bool performUpdate = false;
+        };
 
-        D3D12BuildRaytracingAccelerationStructureInputs inputs;
-        inputs.SetType(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL);
-        if (as->allowUpdate)
-            inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE);
-        else
-            inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags);
+        std::vector<BlasBuild> blasBuilds(numBuilds);
 
-        inputs.SetGeometryDescCount((UINT)numGeometries);
-        for (uint32_t i = 0; i < numGeometries; i++)
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            const auto& geometryDesc = pGeometries[i];
+            const rt::BottomLevelBuildDesc& build = pBuilds[buildIndex];
+            BlasBuild& blasBuild = blasBuilds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+
+            blasBuild.as = as;
+            blasBuild.performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+
+            D3D12BuildRaytracingAccelerationStructureInputs& inputs = blasBuild.inputs;
+            inputs.SetType(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL);
+            if (as->allowUpdate)
+                inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)build.buildFlags | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE);
+            else
+                inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)build.buildFlags);
 
-            D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
-            if (geometryDesc.useTransform)
+            inputs.SetGeometryDescCount((UINT)build.numGeometries);
+            for (uint32_t i = 0; i < build.numGeometries; i++)
             {
-                void* cpuVA = nullptr;
-                if (!m_UploadManager.suballocateBuffer(sizeof(rt::AffineTransform), nullptr, nullptr, nullptr,
-                    &cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_TRANSFORM3X4_BYTE_ALIGNMENT))
+                const auto& geometryDesc = build.geometries[i];
+
+                D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
+                if (geometryDesc.useTransform)
                 {
-                    m_Context.error("Couldn't suballocate an upload buffer");
-                    return;
+                    void* cpuVA = nullptr;
+                    if (!m_UploadManager.suballocateBuffer(sizeof(rt::AffineTransform), nullptr, nullptr, nullptr,
+                        &cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_TRANSFORM3X4_BYTE_ALIGNMENT))
+                    {
+                        m_Context.error("Couldn't suballocate an upload buffer");
+                        return;
+                    }
+
+                    memcpy(cpuVA, &geometryDesc.transform, sizeof(rt::AffineTransform));
                 }
 
-                memcpy(cpuVA, &geometryDesc.transform, sizeof(rt::AffineTransform));
+                D3D12RaytracingGeometryDesc& geomDesc = inputs.GetGeometryDesc(i);
+                fillD3dGeometryDesc(geomDesc, geometryDesc, gpuVA, m_Context.nativeOpacityMicromapsEnabled);
+            }
+
+#ifndef NVRHI_WITH_RTXMU
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
+
+            if (!checked_cast<d3d12::Device*>(m_Device)->GetAccelStructPreBuildInfo(ASPreBuildInfo, as->getDesc()))
+                return;
+
+            if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataSize)
+            {
+                std::stringstream ss;
+                ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                    << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
+                    << as->dataSize << " bytes";
+
+                m_Context.error(ss.str());
+                return;
             }
 
-            D3D12RaytracingGeometryDesc& geomDesc = inputs.GetGeometryDesc(i);
-            fillD3dGeometryDesc(geomDesc, geometryDesc, gpuVA);
+            blasBuild.scratchSize = align<uint64_t>(blasBuild.performUpdate
+                ? ASPreBuildInfo.UpdateScratchDataSizeInBytes
+                : ASPreBuildInfo.ScratchDataSizeInBytes,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            }
+#endif
         }
 
+        commitBarriers();
+
 #ifdef NVRHI_WITH_RTXMU
-        std::vector<uint64_t> accelStructsToBuild;
-        std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> buildInputs;
-        buildInputs.push_back(inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>());
+        // RTXMU takes care of the scratch memory and compaction, give it all the new builds and all the updates at once
+        std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> newBuildInputs;
+        std::vector<AccelStruct*> newBuilds;
+        std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> updateInputs;
+        std::vector<uint64_t> buildsToUpdate;
 
-        if(as->rtxmuId == ~0ull)
+        for (BlasBuild& blasBuild : blasBuilds)
         {
+            if (blasBuild.as->rtxmuId == ~0ull)
+            {
+                newBuildInputs.push_back(blasBuild.inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>());
+                newBuilds.push_back(blasBuild.as);
+            }
+            else
+            {
+                updateInputs.push_back(blasBuild.inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>());
+                buildsToUpdate.push_back(blasBuild.as->rtxmuId);
+            }
+        }
+
+        if (!newBuilds.empty())
+        {
+            std::vector<uint64_t> accelStructsToBuild;
             m_Context.rtxMemUtil->PopulateBuildCommandList(m_ActiveCommandList->commandList4.Get(),
-                                                           buildInputs.data(),
-                                                           buildInputs.size(),
+                                                           newBuildInputs.data(),
+                                                           newBuildInputs.size(),
                                                            accelStructsToBuild);
 
-            as->rtxmuId = accelStructsToBuild[0];
-
-            as->rtxmuGpuVA = m_Context.rtxMemUtil->GetAccelStructGPUVA(as->rtxmuId);
-
-            m_Instance->rtxmuBuildIds.push_back(as->rtxmuId);
-
+            for (size_t i = 0; i < newBuilds.size(); i++)
+            {
+                AccelStruct* as = newBuilds[i];
+                as->rtxmuId = accelStructsToBuild[i];
+                as->rtxmuGpuVA = m_Context.rtxMemUtil->GetAccelStructGPUVA(as->rtxmuId);
+                m_Instance->rtxmuBuildIds.push_back(as->rtxmuId);
+            }
         }
-        else
-        {
-            std::vector<uint64_t> buildsToUpdate(1, as->rtxmuId);
 
+        if (!buildsToUpdate.empty())
+        {
             m_Context.rtxMemUtil->PopulateUpdateCommandList(m_ActiveCommandList->commandList4.Get(),
-                                                            buildInputs.data(),
-                                                            uint32_t(buildInputs.size()),
+                                                            updateInputs.data(),
+                                                            uint32_t(updateInputs.size()),
                                                             buildsToUpdate);
         }
 #else
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
-
-        if (!checked_cast<d3d12::Device*>(m_Device)->GetAccelStructPreBuildInfo(ASPreBuildInfo, as->getDesc()))
-            return;
-
-        if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataBuffer->desc.byteSize)
+        // Sort the builds by scratch size, largest first, and pack them into a shared scratch region.
+        // Builds that fit into the region at the same time don't depend on each other and run without barriers,
+        // and the region is only reused after a UAV barrier.
+        std::vector<uint32_t> buildOrder(numBuilds);
+        uint64_t totalScratchSize = 0;
+        uint64_t largestScratchSize = 0;
+        for (uint32_t i = 0; i < uint32_t(numBuilds); i++)
         {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->desc.byteSize << " bytes";
-
-            m_Context.error(ss.str());
-            return;
+            buildOrder[i] = i;
+            totalScratchSize += blasBuilds[i].scratchSize;
+            largestScratchSize = std::max(largestScratchSize, blasBuilds[i].scratchSize);
         }
 
-        uint64_t scratchSize = performUpdate
-            ? ASPreBuildInfo.UpdateScratchDataSizeInBytes
-            : ASPreBuildInfo.ScratchDataSizeInBytes;
+        std::stable_sort(buildOrder.begin(), buildOrder.end(), [&blasBuilds](uint32_t a, uint32_t b)
+            { return blasBuilds[a].scratchSize > blasBuilds[b].scratchSize; });
+
+        const uint64_t regionSize = std::min(totalScratchSize, std::max(largestScratchSize, uint64_t(m_Desc.blasBatchScratchSize)));
 
+        ID3D12Resource* scratchBuffer = nullptr;
         D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (!m_DxrScratchManager.suballocateBuffer(scratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+        if (regionSize > 0 && !m_DxrScratchManager.suballocateBuffer(regionSize, m_ActiveCommandList->commandList, &scratchBuffer, nullptr, nullptr,
             &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
         {
             std::stringstream ss;
-            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
-                "The build requires " << scratchSize << " bytes of scratch space.";
+            ss << "Couldn't suballocate a scratch buffer for " << numBuilds << " BLAS build(s), starting with "
+                << utils::DebugNameToString(blasBuilds[0].as->desc.debugName) << ". "
+                "The builds require " << regionSize << " bytes of scratch space.";
 
             m_Context.error(ss.str());
             return;
         }
 
-        if (m_EnableAutomaticBarriers)
+        uint64_t scratchOffset = 0;
+        for (uint32_t buildIndex : buildOrder)
         {
-            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
-        }
-        commitBarriers();
+            BlasBuild& blasBuild = blasBuilds[buildIndex];
+            AccelStruct* as = blasBuild.as;
+
+            if (scratchOffset + blasBuild.scratchSize > regionSize)
+            {
+                // The region is full: wait for the builds using it before reusing it from the start
+                D3D12_RESOURCE_BARRIER barrier = {};
+                barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                barrier.UAV.pResource = scratchBuffer;
+                m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
+
+                scratchOffset = 0;
+            }
+
+            const D3D12_GPU_VIRTUAL_ADDRESS buildScratchGpuVA = scratchGpuVA + scratchOffset;
+            scratchOffset += blasBuild.scratchSize;
 
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
-        if (checked_cast<d3d12::Device*>(m_Device)->GetNvapiIsInitialized())
-        {
-            NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC_EX buildDesc = {};
-            buildDesc.inputs = inputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
-            buildDesc.scratchAccelerationStructureData = scratchGpuVA;
-            buildDesc.destAccelerationStructureData = as->dataBuffer->gpuVA;
-            buildDesc.sourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
-
-            NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
-            params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
-            params.pDesc = &buildDesc;
-            params.numPostbuildInfoDescs = 0;
-            params.pPostbuildInfoDescs = nullptr;
-            [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
-            assert(status == S_OK);
-        }
-        else
+            if (checked_cast<d3d12::Device*>(m_Device)->GetNvapiIsInitialized() && !m_Context.nativeOpacityMicromapsEnabled)
+            {
+                NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC_EX buildDesc = {};
+                buildDesc.inputs = blasBuild.inputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
+                buildDesc.scratchAccelerationStructureData = buildScratchGpuVA;
+                buildDesc.destAccelerationStructureData = as->getDataGpuVA();
+                buildDesc.sourceAccelerationStructureData = blasBuild.performUpdate ? as->getDataGpuVA() : 0;
+
+                NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
+                params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
+                params.pDesc = &buildDesc;
+                params.numPostbuildInfoDescs = 0;
+                params.pPostbuildInfoDescs = nullptr;
+                [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
+                assert(status == S_OK);
+            }
+            else
 #endif
-        {
-            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
-            buildDesc.Inputs = inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>();
-            buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
-            buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
-            buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
-            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            {
+                D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+                buildDesc.Inputs = blasBuild.inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>();
+                buildDesc.ScratchAccelerationStructureData = buildScratchGpuVA;
+                buildDesc.DestAccelerationStructureData = as->getDataGpuVA();
+                buildDesc.SourceAccelerationStructureData = blasBuild.performUpdate ? as->getDataGpuVA() : 0;
+                m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            }
         }
 #endif // NVRHI_WITH_RTXMU
 
-        if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+        for (const BlasBuild& blasBuild : blasBuilds)
+        {
+            if (blasBuild.as->desc.trackLiveness)
+                m_Instance->referencedResources.push_back(blasBuild.as);
+        }
     }
 
     void CommandList::compactBottomLevelAccelStructs()
@@ -1499,6 +2144,8 @@ namespace nvrhi::d3d12
 
             if (!m_Resources.asBuildsCompleted.empty())
             {
+                suspendRenderPass();
+
                 m_Context.rtxMemUtil->PopulateCompactionCommandList(m_ActiveCommandList->commandList4.Get(), m_Resources.asBuildsCompleted);
 
                 m_Instance->rtxmuCompactionIds.insert(m_Instance->rtxmuCompactionIds.end(), m_Resources.asBuildsCompleted.begin(), m_Resources.asBuildsCompleted.end());
@@ -1534,12 +2181,12 @@ namespace nvrhi::d3d12
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
         m_Context.device5->GetRaytracingAccelerationStructurePrebuildInfo(&ASInputs, &ASPreBuildInfo);
 
-        if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataBuffer->desc.byteSize)
+        if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataSize)
         {
             std::stringstream ss;
             ss << "TLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
                 << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->desc.byteSize << " bytes";
+                << as->dataSize << " bytes";
 
             m_Context.error(ss.str());
             return;
@@ -1564,8 +2211,8 @@ namespace nvrhi::d3d12
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
         buildDesc.Inputs = ASInputs;
         buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
-        buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
-        buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
+        buildDesc.DestAccelerationStructureData = as->getDataGpuVA();
+        buildDesc.SourceAccelerationStructureData = performUpdate ? as->getDataGpuVA() : 0;
 
         m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
     }
@@ -1576,9 +2223,20 @@ namespace nvrhi::d3d12
         
         as->bottomLevelASes.clear();
 
+        if (as->instanceBuffer)
+        {
+            // Persistent TLAS: treat all instances as dirty
+            const rt::InstanceRange allInstances = rt::InstanceRange().setNumInstances(numInstances);
+            buildTopLevelAccelStructFromDirtyRanges(as, pInstances, numInstances, &allInstances, 1, buildFlags);
+            return;
+        }
+
         // Keep the dxrInstances array in the AS object to avoid reallocating it on the next update
         as->dxrInstances.resize(numInstances);
 
+        // Instances are usually sorted by BLAS, so skip the repeated references and transitions for runs of the same BLAS
+        AccelStruct* previousBlas = nullptr;
+
         // Construct the instance array in a local vector first and then copy it over
         // because doing it in GPU memory over PCIe is much slower.
         for (uint32_t i = 0; i < numInstances; i++)
@@ -1589,8 +2247,10 @@ namespace nvrhi::d3d12
             if (instance.bottomLevelAS)
             {
                 AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
+                const bool sameBlas = blas == previousBlas;
+                previousBlas = blas;
 
-                if (blas->desc.trackLiveness)
+                if (blas->desc.trackLiveness && !sameBlas)
                     as->bottomLevelASes.push_back(blas);
 
                 static_assert(sizeof(dxrInstance) == sizeof(instance));
@@ -1599,9 +2259,9 @@ namespace nvrhi::d3d12
 #ifdef NVRHI_WITH_RTXMU
                 dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
 #else
-                dxrInstance.AccelerationStructure = blas->dataBuffer->gpuVA;
+                dxrInstance.AccelerationStructure = blas->getDataGpuVA();
 
-                if (m_EnableAutomaticBarriers)
+                if (m_EnableAutomaticBarriers && !sameBlas)
                 {
                     requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
                 }
@@ -1642,11 +2302,134 @@ namespace nvrhi::d3d12
             m_Instance->referencedResources.push_back(as);
     }
 
+    void CommandList::buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances,
+        const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer)
+        {
+            m_Context.error("buildTopLevelAccelStructFromDirtyRanges requires a TLAS created with persistentInstanceBuffer = true");
+            return;
+        }
+
+        as->bottomLevelASes.clear();
+
+        const size_t previousNumInstances = as->dxrInstances.size();
+
+        // Release the references held by the instances that are gone
+        for (size_t i = numInstances; i < previousNumInstances; i++)
+            as->setInstanceBlas(i, nullptr);
+
+        as->dxrInstances.resize(numInstances);
+        as->instanceBlases.resize(numInstances, nullptr);
+
+        // Collect the ranges to upload: the dirty ones, clamped, plus all the new instances, then merge the overlaps
+        std::vector<rt::InstanceRange> ranges;
+        ranges.reserve(numDirtyRanges + 1);
+        for (size_t r = 0; r < numDirtyRanges; r++)
+        {
+            const size_t first = std::min(dirtyRanges[r].firstInstance, numInstances);
+            const size_t count = std::min(dirtyRanges[r].numInstances, numInstances - first);
+            if (count)
+                ranges.push_back(rt::InstanceRange().setFirstInstance(first).setNumInstances(count));
+        }
+        if (numInstances > previousNumInstances)
+            ranges.push_back(rt::InstanceRange().setFirstInstance(previousNumInstances).setNumInstances(numInstances - previousNumInstances));
+
+#ifdef NVRHI_WITH_RTXMU
+        // BLAS addresses change when RTXMU compacts them, so the persistent data cannot be trusted
+        ranges.clear();
+        if (numInstances)
+            ranges.push_back(rt::InstanceRange().setNumInstances(numInstances));
+#endif
+
+        std::sort(ranges.begin(), ranges.end(), [](const rt::InstanceRange& a, const rt::InstanceRange& b)
+            { return a.firstInstance < b.firstInstance; });
+
+        size_t numMergedRanges = 0;
+        for (const rt::InstanceRange& range : ranges)
+        {
+            if (numMergedRanges > 0)
+            {
+                rt::InstanceRange& last = ranges[numMergedRanges - 1];
+                const size_t lastEnd = last.firstInstance + last.numInstances;
+                if (range.firstInstance <= lastEnd)
+                {
+                    last.numInstances = std::max(lastEnd, range.firstInstance + range.numInstances) - last.firstInstance;
+                    continue;
+                }
+            }
+            ranges[numMergedRanges++] = range;
+        }
+        ranges.resize(numMergedRanges);
+
+        for (const rt::InstanceRange& range : ranges)
+        {
+            for (size_t i = range.firstInstance; i < range.firstInstance + range.numInstances; i++)
+            {
+                const rt::InstanceDesc& instance = pInstances[i];
+                D3D12_RAYTRACING_INSTANCE_DESC& dxrInstance = as->dxrInstances[i];
+
+                AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
+                as->setInstanceBlas(i, blas);
+
+                static_assert(sizeof(dxrInstance) == sizeof(instance));
+                memcpy(&dxrInstance, &instance, sizeof(instance));
+
+                if (blas)
+                {
+#ifdef NVRHI_WITH_RTXMU
+                    dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
+#else
+                    dxrInstance.AccelerationStructure = blas->getDataGpuVA();
+#endif
+                }
+                else
+                {
+                    dxrInstance.AccelerationStructure = 0;
+                }
+            }
+
+            writeBuffer(as->instanceBuffer, &as->dxrInstances[range.firstInstance],
+                range.numInstances * sizeof(D3D12_RAYTRACING_INSTANCE_DESC),
+                range.firstInstance * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+        }
+
+#ifdef NVRHI_WITH_RTXMU
+        m_Context.rtxMemUtil->PopulateUAVBarriersCommandList(m_ActiveCommandList->commandList4, m_Instance->rtxmuBuildIds);
+#endif
+
+        if (m_EnableAutomaticBarriers)
+        {
+#ifndef NVRHI_WITH_RTXMU
+            // Each referenced BLAS is transitioned once, no matter how many instances use it
+            for (const auto& [blas, reference] : as->uniqueBlases)
+                requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+#endif
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            requireBufferState(as->instanceBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+        }
+        commitBarriers();
+
+        buildTopLevelAccelStructInternal(as, as->instanceBuffer->gpuVA, numInstances, buildFlags);
+
+        m_Instance->referencedResources.push_back(as->instanceBuffer);
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.push_back(as);
+    }
+
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
         
         as->bottomLevelASes.clear();
+
+        // The persistent instance data, if any, is no longer valid: the next dirty-range build uploads everything
+        for (size_t i = 0; i < as->instanceBlases.size(); i++)
+            as->setInstanceBlas(i, nullptr);
+        as->instanceBlases.clear();
         as->dxrInstances.clear();
 
         if (m_EnableAutomaticBarriers)
@@ -0,0 +1,226 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    void ResidencyManager::registerObject(ResidencyObject& object, ID3D12Pageable* pageable, uint64_t size)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        assert(!object.registered);
+
+        object.pageable = pageable;
+        object.size = size;
+        object.registered = true;
+        object.resident = true;
+        object.lastUsedInstance.fill(0);
+
+        // New objects have not been used yet, so put them at the LRU end of the list
+        object.lruPosition = m_LruList.insert(m_LruList.end(), &object);
+    }
+
+    void ResidencyManager::unregisterObject(ResidencyObject& object)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!object.registered)
+            return;
+
+        if (!object.resident)
+            m_EvictedMemory -= object.size;
+
+        m_LruList.erase(object.lruPosition);
+        object.registered = false;
+        object.pageable = nullptr;
+    }
+
+    void ResidencyManager::prepareSubmission(const std::vector<ResidencyObject*>& objects, CommandQueue queueType, uint64_t instance,
+        Queue* const* queues)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_PageableScratch.clear();
+
+        for (ResidencyObject* object : objects)
+        {
+            if (!object->registered)
+                continue;
+
+            if (!object->resident)
+            {
+                m_PageableScratch.push_back(object->pageable);
+                m_EvictedMemory -= object->size;
+                object->resident = true;
+            }
+
+            object->lastUsedInstance[size_t(queueType)] = instance;
+            m_LruList.splice(m_LruList.begin(), m_LruList, object->lruPosition);
+        }
+
+        if (!m_PageableScratch.empty())
+        {
+            // MakeResident blocks until the objects are resident, which is what the submission needs anyway
+            const HRESULT hr = m_Context.device->MakeResident(UINT(m_PageableScratch.size()), m_PageableScratch.data());
+
+            if (FAILED(hr))
+            {
+                std::stringstream ss;
+                ss << "MakeResident call failed for " << m_PageableScratch.size() << " objects"
+                    << ", HRESULT = 0x" << std::hex << std::setw(8) << hr;
+                m_Context.error(ss.str());
+            }
+        }
+
+        evictOverBudget(queues);
+    }
+
+    void ResidencyManager::evictOverBudget(Queue* const* queues)
+    {
+        if (!m_Context.adapter)
+            return;
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo{};
+        if (FAILED(m_Context.adapter->QueryVideoMemoryInfo(m_Context.getNodeIndex(), DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo)))
+            return;
+
+        if (memoryInfo.CurrentUsage <= memoryInfo.Budget)
+            return;
+
+        uint64_t excess = memoryInfo.CurrentUsage - memoryInfo.Budget;
+
+        std::array<uint64_t, size_t(CommandQueue::Count)> completedInstances{};
+        for (size_t queueIndex = 0; queueIndex < completedInstances.size(); ++queueIndex)
+        {
+            completedInstances[queueIndex] = queues[queueIndex] ? queues[queueIndex]->updateLastCompletedInstance() : 0;
+        }
+
+        m_PageableScratch.clear();
+
+        // Walk from the least recently used end, skipping the objects that a queue may still be using
+        for (auto it = m_LruList.rbegin(); it != m_LruList.rend() && excess > 0; ++it)
+        {
+            ResidencyObject* object = *it;
+
+            if (!object->resident)
+                continue;
+
+            bool inUse = false;
+            for (size_t queueIndex = 0; queueIndex < completedInstances.size(); ++queueIndex)
+            {
+                if (object->lastUsedInstance[queueIndex] > completedInstances[queueIndex])
+                {
+                    inUse = true;
+                    break;
+                }
+            }
+
+            if (inUse)
+                continue;
+
+            m_PageableScratch.push_back(object->pageable);
+            object->resident = false;
+            m_EvictedMemory += object->size;
+            excess -= std::min(excess, object->size);
+        }
+
+        if (!m_PageableScratch.empty())
+        {
+            m_Context.device->Evict(UINT(m_PageableScratch.size()), m_PageableScratch.data());
+        }
+    }
+
+    uint64_t ResidencyManager::getEvictedMemory()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_EvictedMemory;
+    }
+
+    void Device::initResidency(ResidencyObject& residency, ID3D12Pageable* pageable, uint64_t size, ResidencyPriority priority, bool managed)
+    {
+        if (priority != ResidencyPriority::Normal && m_Context.device1)
+        {
+            const D3D12_RESIDENCY_PRIORITY d3dPriority = convertResidencyPriority(priority);
+            m_Context.device1->SetResidencyPriority(1, &pageable, &d3dPriority);
+        }
+
+        if (managed && m_Resources.residencyManager)
+            m_Resources.residencyManager->registerObject(residency, pageable, size);
+    }
+
+    Heap::~Heap()
+    {
+        if (residencyManager)
+            residencyManager->unregisterObject(residency);
+    }
+
+    ResidencyObject* Texture::getResidencyObject()
+    {
+        if (heap)
+        {
+            Heap* pHeap = checked_cast<Heap*>(heap.Get());
+            return pHeap->residency.registered ? &pHeap->residency : nullptr;
+        }
+
+        return residency.registered ? &residency : nullptr;
+    }
+
+    ResidencyObject* Buffer::getResidencyObject()
+    {
+        if (heap)
+        {
+            Heap* pHeap = checked_cast<Heap*>(heap.Get());
+            return pHeap->residency.registered ? &pHeap->residency : nullptr;
+        }
+
+        return residency.registered ? &residency : nullptr;
+    }
+
+    bool Device::queryMemoryBudget(MemoryBudget& outBudget)
+    {
+        if (!m_Context.adapter)
+            return false;
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO localInfo{};
+        DXGI_QUERY_VIDEO_MEMORY_INFO nonLocalInfo{};
+
+        if (FAILED(m_Context.adapter->QueryVideoMemoryInfo(m_Context.getNodeIndex(), DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &localInfo)) ||
+            FAILED(m_Context.adapter->QueryVideoMemoryInfo(m_Context.getNodeIndex(), DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocalInfo)))
+            return false;
+
+        outBudget = MemoryBudget();
+        outBudget.localBudget = localInfo.Budget;
+        outBudget.localUsage = localInfo.CurrentUsage;
+        outBudget.nonLocalBudget = nonLocalInfo.Budget;
+        outBudget.nonLocalUsage = nonLocalInfo.CurrentUsage;
+        outBudget.evictedMemory = m_Resources.residencyManager ? m_Resources.residencyManager->getEvictedMemory() : 0;
+
+        return true;
+    }
+
+} // namespace nvrhi::d3d12
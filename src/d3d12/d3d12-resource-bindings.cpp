@@ -66,7 +66,27 @@ namespace nvrhi::d3d12
         return false;
     }
     
-    void BindingSet::createDescriptors()
+    static bool GetRootDescriptorParameterType(ResourceType type, D3D12_ROOT_PARAMETER_TYPE& outType)
+    {
+        switch (type)
+        {
+        case ResourceType::StructuredBuffer_SRV:
+        case ResourceType::RawBuffer_SRV:
+            outType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+            return true;
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_UAV:
+            outType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+            return true;
+        case ResourceType::ConstantBuffer:
+            outType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void BindingSet::createDescriptors(DescriptorIndex samplerTableBase, DescriptorIndex srvTableBase)
     {
         // Process the volatile constant buffers: they occupy one root parameter each
         for (const std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>& parameter : layout->rootParametersVolatileCB)
@@ -93,9 +113,52 @@ namespace nvrhi::d3d12
             rootParametersVolatileCB.push_back(std::make_pair(rootParameterIndex, foundBuffer));
         }
 
+        // Process the root SRVs, UAVs and CBVs: they store a GPU VA instead of a descriptor
+        for (const std::pair<RootParameterIndex, D3D12_ROOT_PARAMETER1>& parameter : layout->rootParametersBuffers)
+        {
+            RootDescriptorBinding rootDescriptor;
+            rootDescriptor.rootParameterIndex = parameter.first;
+            rootDescriptor.type = parameter.second.ParameterType;
+
+            for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+            {
+                const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+                D3D12_ROOT_PARAMETER_TYPE bindingParameterType;
+                if (binding.slot != parameter.second.Descriptor.ShaderRegister ||
+                    !GetRootDescriptorParameterType(binding.type, bindingParameterType) ||
+                    bindingParameterType != rootDescriptor.type ||
+                    !binding.resourceHandle)
+                    continue;
+
+                Buffer* buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                resources.push_back(buffer);
+
+                rootDescriptor.address = buffer->gpuVA + binding.range.byteOffset;
+
+                const ResourceStates requiredState = (rootDescriptor.type == D3D12_ROOT_PARAMETER_TYPE_SRV) ? ResourceStates::ShaderResource
+                    : (rootDescriptor.type == D3D12_ROOT_PARAMETER_TYPE_UAV) ? ResourceStates::UnorderedAccess
+                    : ResourceStates::ConstantBuffer;
+
+                if (!buffer->permanentState)
+                    bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
+
+                if (rootDescriptor.type == D3D12_ROOT_PARAMETER_TYPE_UAV)
+                    hasUavBindings = true;
+
+                break;
+            }
+
+            // Like the volatile CBs, an unmatched root descriptor still gets bound, with a null address
+            rootDescriptors.push_back(rootDescriptor);
+        }
+
         if (layout->descriptorTableSizeSamplers > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.samplerHeap.allocateDescriptors(layout->descriptorTableSizeSamplers);
+            DescriptorIndex descriptorTableBaseIndex = samplerTableBase;
             descriptorTableSamplers = descriptorTableBaseIndex;
             rootParameterIndexSamplers = layout->rootParameterSamplers;
             descriptorTableValidSamplers = true;
@@ -130,13 +193,11 @@ namespace nvrhi::d3d12
                     }
                 }
             }
-
-            m_Resources.samplerHeap.copyToShaderVisibleHeap(descriptorTableBaseIndex, layout->descriptorTableSizeSamplers);
         }
 
         if (layout->descriptorTableSizeSRVetc > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
+            DescriptorIndex descriptorTableBaseIndex = srvTableBase;
             descriptorTableSRVetc = descriptorTableBaseIndex;
             rootParameterIndexSRVetc = layout->rootParameterSRVetc;
             descriptorTableValidSRVetc = true;
@@ -318,8 +379,6 @@ namespace nvrhi::d3d12
                     }
                 }
             }
-
-            m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTableBaseIndex, layout->descriptorTableSizeSRVetc);
         }
     }
 
@@ -343,18 +402,88 @@ namespace nvrhi::d3d12
         BindingLayout* pipelineLayout = checked_cast<BindingLayout*>(_layout);
         ret->layout = pipelineLayout;
 
-        ret->createDescriptors();
+        const uint32_t samplerTableSize = pipelineLayout->descriptorTableSizeSamplers;
+        const uint32_t srvTableSize = pipelineLayout->descriptorTableSizeSRVetc;
+
+        DescriptorIndex samplerTableBase = m_Resources.samplerHeap.allocateDescriptors(samplerTableSize);
+        DescriptorIndex srvTableBase = m_Resources.shaderResourceViewHeap.allocateDescriptors(srvTableSize);
+
+        ret->createDescriptors(samplerTableBase, srvTableBase);
+
+        if (samplerTableSize > 0)
+            m_Resources.samplerHeap.copyToShaderVisibleHeap(samplerTableBase, samplerTableSize);
+        if (srvTableSize > 0)
+            m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(srvTableBase, srvTableSize);
 
         return BindingSetHandle::Create(ret);
     }
 
-    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    bool Device::createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* _layout, BindingSetHandle* outBindingSets)
     {
-        (void)layout; // not necessary on DX12
+        if (count == 0)
+            return true;
 
+        BindingLayout* pipelineLayout = checked_cast<BindingLayout*>(_layout);
+
+        const uint32_t samplerTableSize = pipelineLayout->descriptorTableSizeSamplers;
+        const uint32_t srvTableSize = pipelineLayout->descriptorTableSizeSRVetc;
+
+        // Allocate the tables of all sets as one range per heap. Each set releases its own slice of the range
+        // when it's destroyed, which the heap allocator handles like any other release.
+        DescriptorIndex samplerRangeBase = m_Resources.samplerHeap.allocateDescriptors(samplerTableSize * uint32_t(count));
+        DescriptorIndex srvRangeBase = m_Resources.shaderResourceViewHeap.allocateDescriptors(srvTableSize * uint32_t(count));
+
+        if ((samplerTableSize > 0 && samplerRangeBase == c_InvalidDescriptorIndex) ||
+            (srvTableSize > 0 && srvRangeBase == c_InvalidDescriptorIndex))
+        {
+            // The heap couldn't grow to fit the whole batch, release what we got and create the sets one by one
+            m_Resources.samplerHeap.releaseDescriptors(samplerRangeBase, samplerRangeBase == c_InvalidDescriptorIndex ? 0 : samplerTableSize * uint32_t(count));
+            m_Resources.shaderResourceViewHeap.releaseDescriptors(srvRangeBase, srvRangeBase == c_InvalidDescriptorIndex ? 0 : srvTableSize * uint32_t(count));
+
+            bool success = true;
+            for (size_t index = 0; index < count; index++)
+            {
+                outBindingSets[index] = createBindingSet(descs[index], _layout);
+                success &= outBindingSets[index] != nullptr;
+            }
+            return success;
+        }
+
+        for (size_t index = 0; index < count; index++)
+        {
+            BindingSet *ret = new BindingSet(m_Context, m_Resources);
+            ret->desc = descs[index];
+            ret->layout = pipelineLayout;
+
+            ret->createDescriptors(
+                samplerTableSize > 0 ? samplerRangeBase + samplerTableSize * uint32_t(index) : c_InvalidDescriptorIndex,
+                srvTableSize > 0 ? srvRangeBase + srvTableSize * uint32_t(index) : c_InvalidDescriptorIndex);
+
+            outBindingSets[index] = BindingSetHandle::Create(ret);
+        }
+
+        // The descriptors of all sets are contiguous, copy them with a single call per heap
+        if (samplerTableSize > 0)
+            m_Resources.samplerHeap.copyToShaderVisibleHeap(samplerRangeBase, samplerTableSize * uint32_t(count));
+        if (srvTableSize > 0)
+            m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(srvRangeBase, srvTableSize * uint32_t(count));
+
+        return true;
+    }
+
+    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    {
         DescriptorTable* ret = new DescriptorTable(m_Resources);
         ret->capacity = 0;
         ret->firstDescriptor = 0;
+
+        const BindlessLayoutDesc* bindlessDesc = layout ? layout->getBindlessDesc() : nullptr;
+        if (bindlessDesc && bindlessDesc->layoutType == BindlessLayoutType::DirectlyIndexed)
+        {
+            ret->directlyIndexed = true;
+            ret->reservedCapacity = bindlessDesc->maxCapacity;
+            ret->firstDescriptor = m_Resources.shaderResourceViewHeap.allocateDescriptors(ret->reservedCapacity);
+        }
         
         return DescriptorTableHandle::Create(ret);
     }
@@ -368,17 +497,19 @@ namespace nvrhi::d3d12
 
     DescriptorTable::~DescriptorTable()
     {
-        m_Resources.shaderResourceViewHeap.releaseDescriptors(firstDescriptor, capacity);
+        m_Resources.shaderResourceViewHeap.releaseDescriptors(firstDescriptor, directlyIndexed ? reservedCapacity : capacity);
     }
 
     BindingLayout::BindingLayout(const BindingLayoutDesc& _desc)
         : desc(_desc)
+        , descHash(std::hash<BindingLayoutDesc>()(_desc))
     {
         // Start with some invalid values, to make sure that we start a new range on the first binding
         ResourceType currentType = ResourceType(-1);
         uint32_t currentSlot = ~0u;
 
         D3D12_ROOT_CONSTANTS rootConstants = {};
+        D3D12_ROOT_PARAMETER_TYPE rootDescriptorType;
 
         for (const BindingLayoutItem& binding : desc.bindings)
         {
@@ -396,6 +527,19 @@ namespace nvrhi::d3d12
 
                 rootParametersVolatileCB.push_back(std::make_pair(-1, rootDescriptor));
             }
+            else if (binding.rootDescriptor && GetRootDescriptorParameterType(binding.type, rootDescriptorType))
+            {
+                D3D12_ROOT_PARAMETER1 param = {};
+                param.ParameterType = rootDescriptorType;
+                param.ShaderVisibility = convertShaderStage(desc.visibility);
+                param.Descriptor.ShaderRegister = binding.slot;
+                param.Descriptor.RegisterSpace = desc.registerSpace;
+
+                // Same reasoning as for the descriptor table ranges below
+                param.Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE;
+
+                rootParametersBuffers.push_back(std::make_pair(-1, param));
+            }
             else if (binding.type == ResourceType::PushConstants)
             {
                 pushConstantByteSize = binding.size;
@@ -528,6 +672,13 @@ namespace nvrhi::d3d12
             rootParameterVolatileCB.first = RootParameterIndex(rootParameters.size() - 1);
         }
 
+        for (std::pair<RootParameterIndex, D3D12_ROOT_PARAMETER1>& rootParameterBuffer : rootParametersBuffers)
+        {
+            rootParameters.push_back(rootParameterBuffer.second);
+
+            rootParameterBuffer.first = RootParameterIndex(rootParameters.size() - 1);
+        }
+
         if (descriptorTableSizeSamplers > 0)
         {
             rootParameters.resize(rootParameters.size() + 1);
@@ -557,9 +708,17 @@ namespace nvrhi::d3d12
 
     BindlessLayout::BindlessLayout(const BindlessLayoutDesc& _desc)
         : desc(_desc)
+        , descHash(std::hash<BindlessLayoutDesc>()(_desc))
     {
         descriptorRanges.resize(0);
 
+        if (desc.layoutType == BindlessLayoutType::DirectlyIndexed)
+        {
+            // Shaders reach the descriptors through ResourceDescriptorHeap[], no root parameter is needed
+            directlyIndexed = true;
+            return;
+        }
+
         for (const BindingLayoutItem& item : desc.registerSpaces)
         {
             D3D12_DESCRIPTOR_RANGE_TYPE rangeType;
@@ -614,6 +773,57 @@ namespace nvrhi::d3d12
         rootParameter.DescriptorTable.pDescriptorRanges = &descriptorRanges[0];
     }
 
+    // Stable hash of a root signature description, used to find its serialized blob in the pipeline cache
+    static uint64_t hashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& desc)
+    {
+        PipelineLibraryKey key;
+        key.add(desc.Flags);
+        key.add(desc.NumParameters);
+
+        for (UINT index = 0; index < desc.NumParameters; index++)
+        {
+            const D3D12_ROOT_PARAMETER1& parameter = desc.pParameters[index];
+            key.add(parameter.ParameterType);
+            key.add(parameter.ShaderVisibility);
+
+            switch (parameter.ParameterType)
+            {
+            case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+                key.addBytes(parameter.DescriptorTable.pDescriptorRanges,
+                    sizeof(D3D12_DESCRIPTOR_RANGE1) * parameter.DescriptorTable.NumDescriptorRanges);
+                break;
+            case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+                key.add(parameter.Constants);
+                break;
+            default:
+                key.add(parameter.Descriptor);
+                break;
+            }
+        }
+
+        return key.getHash();
+    }
+
+    bool Device::findRootSignatureBlob(uint64_t descHash, std::vector<uint8_t>& outBlob) const
+    {
+        std::shared_lock lock(m_RootSignatureBlobsMutex);
+
+        const auto it = m_RootSignatureBlobs.find(descHash);
+        if (it == m_RootSignatureBlobs.end())
+            return false;
+
+        outBlob = it->second;
+        return true;
+    }
+
+    void Device::storeRootSignatureBlob(uint64_t descHash, const void* data, size_t size)
+    {
+        std::unique_lock lock(m_RootSignatureBlobsMutex);
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_RootSignatureBlobs.try_emplace(descHash, bytes, bytes + size);
+    }
+
     RootSignatureHandle Device::buildRootSignature(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& pipelineLayouts, bool allowInputLayout, bool isLocal, const D3D12_ROOT_PARAMETER1* pCustomParameters, uint32_t numCustomParameters)
     {
         HRESULT res;
@@ -624,6 +834,7 @@ namespace nvrhi::d3d12
         // Also attach the root parameter offsets to the pipeline layouts
 
         std::vector<D3D12_ROOT_PARAMETER1> rootParameters;
+        bool heapDirectlyIndexed = false;
 
         // Add custom parameters in the beginning of the RS
         for (uint32_t index = 0; index < numCustomParameters; index++)
@@ -655,7 +866,10 @@ namespace nvrhi::d3d12
 
                 rootsig->pipelineLayouts.push_back(std::make_pair(layout, rootParameterOffset));
 
-                rootParameters.push_back(layout->rootParameter);
+                if (layout->directlyIndexed)
+                    heapDirectlyIndexed = true;
+                else
+                    rootParameters.push_back(layout->rootParameter);
             }
         }
 
@@ -672,6 +886,15 @@ namespace nvrhi::d3d12
         {
             rsDesc.Desc_1_1.Flags |= D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE;
         }
+        if (heapDirectlyIndexed)
+        {
+#if NVRHI_D3D12_WITH_DIRECT_HEAP_INDEXING
+            rsDesc.Desc_1_1.Flags |= D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED;
+#else
+            m_Context.error("Directly indexed bindless layouts require a d3d12.h from Windows SDK 10.0.20348 or newer");
+            return nullptr;
+#endif
+        }
 
         if (!rootParameters.empty())
         {
@@ -679,27 +902,39 @@ namespace nvrhi::d3d12
             rsDesc.Desc_1_1.NumParameters = UINT(rootParameters.size());
         }
 
-        // Serialize the root signature
+        // Serialize the root signature, or reuse a blob restored from the pipeline cache
 
-        RefCountPtr<ID3DBlob> rsBlob;
-        RefCountPtr<ID3DBlob> errorBlob;
-        res = D3D12SerializeVersionedRootSignature(&rsDesc, &rsBlob, &errorBlob);
+        const uint64_t descHash = hashRootSignatureDesc(rsDesc.Desc_1_1);
 
-        if (FAILED(res))
+        std::vector<uint8_t> rsBlob;
+        if (!findRootSignatureBlob(descHash, rsBlob))
         {
-            std::stringstream ss;
-            ss << "D3D12SerializeVersionedRootSignature call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
-            if (errorBlob) {
-                ss << std::endl << (const char*)errorBlob->GetBufferPointer();
+            RefCountPtr<ID3DBlob> serializedBlob;
+            RefCountPtr<ID3DBlob> errorBlob;
+            res = D3D12SerializeVersionedRootSignature(&rsDesc, &serializedBlob, &errorBlob);
+
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "D3D12SerializeVersionedRootSignature call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+                if (errorBlob) {
+                    ss << std::endl << (const char*)errorBlob->GetBufferPointer();
+                }
+                m_Context.error(ss.str());
+
+                return nullptr;
             }
-            m_Context.error(ss.str());
-            
-            return nullptr;
+
+            const uint8_t* serializedData = static_cast<const uint8_t*>(serializedBlob->GetBufferPointer());
+            rsBlob.assign(serializedData, serializedData + serializedBlob->GetBufferSize());
+            storeRootSignatureBlob(descHash, rsBlob.data(), rsBlob.size());
         }
 
+        rootsig->contentHash = hashPipelineCacheBytes(rsBlob.data(), rsBlob.size());
+
         // Create the RS object
 
-        res = m_Context.device->CreateRootSignature(0, rsBlob->GetBufferPointer(), rsBlob->GetBufferSize(), IID_PPV_ARGS(&rootsig->handle));
+        res = m_Context.device->CreateRootSignature(m_Context.nodeMask, rsBlob.data(), rsBlob.size(), IID_PPV_ARGS(&rootsig->handle));
 
         if (FAILED(res))
         {
@@ -721,29 +956,48 @@ namespace nvrhi::d3d12
             hash_combine(hash, pipelineLayout.Get());
         
         hash_combine(hash, allowInputLayout ? 1u : 0u);
-        
-        // Get a cached RS and AddRef it (if it exists)
-        RefCountPtr<RootSignature> rootsig = m_Resources.rootsigCache[hash];
 
-        if (!rootsig)
-        {
-            // Does not exist - build a new one, take ownership
-            rootsig = checked_cast<RootSignature*>(buildRootSignature(pipelineLayouts, allowInputLayout, false).Get());
-            rootsig->hash = hash;
+        DeviceResources::RootSignatureCacheShard& shard = m_Resources.getRootSignatureCacheShard(hash);
 
-            m_Resources.rootsigCache[hash] = rootsig;
+        // Get a cached RS and AddRef it (if it exists and is not being destroyed)
+        {
+            std::shared_lock lock(shard.mutex);
+            const auto it = shard.rootSignatures.find(hash);
+            if (it != shard.rootSignatures.end() && it->second->tryAddRef())
+                return RefCountPtr<RootSignature>::Create(it->second);
         }
 
+        // Does not exist - build a new one outside of the lock, so that other threads are not blocked
+        // on serialization and CreateRootSignature. Declared before the lock below so that a duplicate
+        // is released after the lock, because its destructor takes the lock as well.
+        RootSignatureHandle newRootsig = buildRootSignature(pipelineLayouts, allowInputLayout, false);
+        if (!newRootsig)
+            return nullptr;
+
+        RootSignature* rootsig = checked_cast<RootSignature*>(newRootsig.Get());
+        rootsig->hash = hash;
+
+        std::unique_lock lock(shard.mutex);
+
+        // Another thread could have built the same RS in the meantime, prefer that one
+        RootSignature*& cachedRootsig = shard.rootSignatures[hash];
+        if (cachedRootsig && cachedRootsig->tryAddRef())
+            return RefCountPtr<RootSignature>::Create(cachedRootsig);
+
+        cachedRootsig = rootsig;
+
         // Pass ownership of the RS to caller
-        return rootsig;
+        return RefCountPtr<RootSignature>(rootsig);
     }
 
     RootSignature::~RootSignature()
     {
         // Remove the root signature from the cache
-        const auto it = m_Resources.rootsigCache.find(hash);
-        if (it != m_Resources.rootsigCache.end())
-            m_Resources.rootsigCache.erase(it);
+        DeviceResources::RootSignatureCacheShard& shard = m_Resources.getRootSignatureCacheShard(hash);
+        std::unique_lock lock(shard.mutex);
+        const auto it = shard.rootSignatures.find(hash);
+        if (it != shard.rootSignatures.end() && it->second == this)
+            shard.rootSignatures.erase(it);
     }
 
     bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& binding)
@@ -818,6 +1072,22 @@ namespace nvrhi::d3d12
         if (newSize == descriptorTable->capacity)
             return;
 
+        if (descriptorTable->directlyIndexed)
+        {
+            // The whole range was reserved at creation, so the table never moves or copies descriptors
+            if (newSize > descriptorTable->reservedCapacity)
+            {
+                std::stringstream ss;
+                ss << "Cannot resize a directly indexed descriptor table to " << newSize
+                   << " descriptors, the layout's maxCapacity is " << descriptorTable->reservedCapacity;
+                m_Context.error(ss.str());
+                return;
+            }
+
+            descriptorTable->capacity = newSize;
+            return;
+        }
+
         if (newSize < descriptorTable->capacity)
         {
             m_Resources.shaderResourceViewHeap.releaseDescriptors(descriptorTable->firstDescriptor + newSize, descriptorTable->capacity - newSize);
@@ -868,6 +1138,8 @@ namespace nvrhi::d3d12
                     continue;
 
                 const bool updateThisSet = (bindingUpdateMask & (1 << bindingSetIndex)) != 0;
+                if (updateThisSet)
+                    m_Statistics.bindingSetBinds++;
 
                 const std::pair<BindingLayoutHandle, RootParameterIndex>& layoutAndOffset = rootSignature->pipelineLayouts[bindingSetIndex];
                 RootParameterIndex rootParameterOffset = layoutAndOffset.second;
@@ -926,6 +1198,27 @@ namespace nvrhi::d3d12
 
                     if (updateThisSet)
                     {
+                        for (const BindingSet::RootDescriptorBinding& rootDescriptor : bindingSet->rootDescriptors)
+                        {
+                            RootParameterIndex rootParameterIndex = rootParameterOffset + rootDescriptor.rootParameterIndex;
+
+                            switch (rootDescriptor.type)
+                            {
+                            case D3D12_ROOT_PARAMETER_TYPE_SRV:
+                                m_ActiveCommandList->commandList->SetComputeRootShaderResourceView(rootParameterIndex, rootDescriptor.address);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_UAV:
+                                m_ActiveCommandList->commandList->SetComputeRootUnorderedAccessView(rootParameterIndex, rootDescriptor.address);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_CBV:
+                                m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(rootParameterIndex, rootDescriptor.address);
+                                break;
+                            default:
+                                utils::InvalidEnum();
+                                break;
+                            }
+                        }
+
                         if (bindingSet->descriptorTableValidSamplers)
                         {
                             m_ActiveCommandList->commandList->SetComputeRootDescriptorTable(
@@ -953,7 +1246,8 @@ namespace nvrhi::d3d12
                 {
                     DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_bindingSet);
 
-                    m_ActiveCommandList->commandList->SetComputeRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
+                    if (!descriptorTable->directlyIndexed)
+                        m_ActiveCommandList->commandList->SetComputeRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
                 }
             }
 
@@ -996,6 +1290,8 @@ namespace nvrhi::d3d12
                     continue;
 
                 const bool updateThisSet = (bindingUpdateMask & (1 << bindingSetIndex)) != 0;
+                if (updateThisSet)
+                    m_Statistics.bindingSetBinds++;
 
                 const std::pair<BindingLayoutHandle, RootParameterIndex>& layoutAndOffset = rootSignature->pipelineLayouts[bindingSetIndex];
                 RootParameterIndex rootParameterOffset = layoutAndOffset.second;
@@ -1054,6 +1350,27 @@ namespace nvrhi::d3d12
 
                     if (updateThisSet)
                     {
+                        for (const BindingSet::RootDescriptorBinding& rootDescriptor : bindingSet->rootDescriptors)
+                        {
+                            RootParameterIndex rootParameterIndex = rootParameterOffset + rootDescriptor.rootParameterIndex;
+
+                            switch (rootDescriptor.type)
+                            {
+                            case D3D12_ROOT_PARAMETER_TYPE_SRV:
+                                m_ActiveCommandList->commandList->SetGraphicsRootShaderResourceView(rootParameterIndex, rootDescriptor.address);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_UAV:
+                                m_ActiveCommandList->commandList->SetGraphicsRootUnorderedAccessView(rootParameterIndex, rootDescriptor.address);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_CBV:
+                                m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, rootDescriptor.address);
+                                break;
+                            default:
+                                utils::InvalidEnum();
+                                break;
+                            }
+                        }
+
                         if (bindingSet->descriptorTableValidSamplers)
                         {
                             m_ActiveCommandList->commandList->SetGraphicsRootDescriptorTable(
@@ -1081,7 +1398,8 @@ namespace nvrhi::d3d12
                 {
                     DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_bindingSet);
 
-                    m_ActiveCommandList->commandList->SetGraphicsRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
+                    if (!descriptorTable->directlyIndexed)
+                        m_ActiveCommandList->commandList->SetGraphicsRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
                 }
             }
 
@@ -69,9 +69,28 @@ namespace nvrhi::d3d12
             return nullptr;
 
         Shader* shader = new Shader();
-        shader->bytecode.resize(binarySize);
+        shader->bytecodeStorage.resize(binarySize);
+        memcpy(&shader->bytecodeStorage[0], binary, binarySize);
+        shader->bytecode = { shader->bytecodeStorage.data(), binarySize };
+
+        return initShader(shader, d);
+    }
+
+    ShaderHandle Device::createShaderNoCopy(const ShaderDesc& d, const void* binary, const size_t binarySize, IResource* binaryOwner)
+    {
+        if (binarySize == 0)
+            return nullptr;
+
+        Shader* shader = new Shader();
+        shader->bytecode = { binary, binarySize };
+        shader->bytecodeOwner = binaryOwner;
+
+        return initShader(shader, d);
+    }
+
+    ShaderHandle Device::initShader(Shader* shader, const ShaderDesc& d)
+    {
         shader->desc = d;
-        memcpy(&shader->bytecode[0], binary, binarySize);
 
 #if NVRHI_D3D12_WITH_NVAPI
         // Save the custom semantics structure because it may be on the stack or otherwise dynamic.
@@ -225,8 +244,19 @@ namespace nvrhi::d3d12
     {
         ShaderLibrary* shaderLibrary = new ShaderLibrary();
 
-        shaderLibrary->bytecode.resize(binarySize);
-        memcpy(&shaderLibrary->bytecode[0], binary, binarySize);
+        shaderLibrary->bytecodeStorage.resize(binarySize);
+        memcpy(shaderLibrary->bytecodeStorage.data(), binary, binarySize);
+        shaderLibrary->bytecode = { shaderLibrary->bytecodeStorage.data(), binarySize };
+
+        return ShaderLibraryHandle::Create(shaderLibrary);
+    }
+
+    nvrhi::ShaderLibraryHandle Device::createShaderLibraryNoCopy(const void* binary, const size_t binarySize, IResource* binaryOwner)
+    {
+        ShaderLibrary* shaderLibrary = new ShaderLibrary();
+
+        shaderLibrary->bytecode = { binary, binarySize };
+        shaderLibrary->bytecodeOwner = binaryOwner;
 
         return ShaderLibraryHandle::Create(shaderLibrary);
     }
@@ -299,8 +329,8 @@ namespace nvrhi::d3d12
 
     void Shader::getBytecode(const void** ppBytecode, size_t* pSize) const
     {
-        if (ppBytecode) *ppBytecode = bytecode.data();
-        if (pSize) *pSize = bytecode.size();
+        if (ppBytecode) *ppBytecode = bytecode.pShaderBytecode;
+        if (pSize) *pSize = bytecode.BytecodeLength;
     }
 
     void ShaderLibraryEntry::getBytecode(const void** ppBytecode, size_t* pSize) const
@@ -310,8 +340,8 @@ namespace nvrhi::d3d12
 
     void ShaderLibrary::getBytecode(const void** ppBytecode, size_t* pSize) const
     {
-        if (ppBytecode) *ppBytecode = bytecode.data();
-        if (pSize) *pSize = bytecode.size();
+        if (ppBytecode) *ppBytecode = bytecode.pShaderBytecode;
+        if (pSize) *pSize = bytecode.BytecodeLength;
     }
 
     ShaderHandle ShaderLibrary::getShader(const char* entryName, ShaderType shaderType)
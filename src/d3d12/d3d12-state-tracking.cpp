@@ -79,27 +79,56 @@ namespace nvrhi::d3d12
     {
         Texture* texture = checked_cast<Texture*>(_texture);
 
+        // Bundles collect the residency objects too, executeBundle adds them to the executing command list
+        if (m_Resources.residencyManager)
+        {
+            if (ResidencyObject* residency = texture->getResidencyObject())
+                m_ResidencyObjects[residency] = true;
+        }
+
+        if (m_IsBundle)
+        {
+            m_BundleStates.requireTextureState(_texture, subresources, state);
+            return;
+        }
+
+        const size_t numBarriers = m_StateTracker.getTextureBarriers().size();
         m_StateTracker.requireTextureState(texture, subresources, state);
+        if (m_StateTracker.getTextureBarriers().size() == numBarriers)
+            m_Statistics.barriersElided++;
     }
     
     void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
+        if (m_Resources.residencyManager)
+        {
+            if (ResidencyObject* residency = buffer->getResidencyObject())
+                m_ResidencyObjects[residency] = true;
+        }
+
+        if (m_IsBundle)
+        {
+            m_BundleStates.requireBufferState(_buffer, state);
+            return;
+        }
+
+        const size_t numBarriers = m_StateTracker.getBufferBarriers().size();
         m_StateTracker.requireBufferState(buffer, state);
+        if (m_StateTracker.getBufferBarriers().size() == numBarriers)
+            m_Statistics.barriersElided++;
     }
 
-    void CommandList::commitBarriers()
+    void CommandList::convertPendingBarriers()
     {
         const auto& textureBarriers = m_StateTracker.getTextureBarriers();
         const auto& bufferBarriers = m_StateTracker.getBufferBarriers();
         const size_t barrierCount = textureBarriers.size() + bufferBarriers.size();
-        if (barrierCount == 0)
-            return;
 
         // Allocate vector space for the barriers assuming 1:1 translation.
-        // For partial transitions on multi-plane textures, original barriers may translate
-        // into more than 1 barrier each, but that's relatively rare.
+        // Partial transitions on subresource ranges or multi-plane textures translate into one barrier
+        // per subresource and plane, because legacy barriers can't describe ranges.
         m_D3DBarriers.clear();
         m_D3DBarriers.reserve(barrierCount);
 
@@ -126,8 +155,14 @@ namespace nvrhi::d3d12
                 {
                     for (uint8_t plane = 0; plane < texture->planeCount; plane++)
                     {
-                        d3dbarrier.Transition.Subresource = calcSubresource(barrier.mipLevel, barrier.arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
-                        m_D3DBarriers.push_back(d3dbarrier);
+                        for (ArraySlice arraySlice = barrier.arraySlice; arraySlice < barrier.arraySlice + barrier.numArraySlices; arraySlice++)
+                        {
+                            for (MipLevel mipLevel = barrier.mipLevel; mipLevel < barrier.mipLevel + barrier.numMipLevels; mipLevel++)
+                            {
+                                d3dbarrier.Transition.Subresource = calcSubresource(mipLevel, arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
+                                m_D3DBarriers.push_back(d3dbarrier);
+                            }
+                        }
                     }
                 }
             }
@@ -168,6 +203,183 @@ namespace nvrhi::d3d12
                 m_D3DBarriers.push_back(d3dbarrier);
             }
         }
+    }
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+    static bool isReadOnlyAccess(D3D12_BARRIER_ACCESS access)
+    {
+        constexpr D3D12_BARRIER_ACCESS writeAccess =
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS |
+            D3D12_BARRIER_ACCESS_RENDER_TARGET |
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE |
+            D3D12_BARRIER_ACCESS_STREAM_OUTPUT |
+            D3D12_BARRIER_ACCESS_COPY_DEST |
+            D3D12_BARRIER_ACCESS_RESOLVE_DEST |
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE;
+
+        // ACCESS_COMMON means any access allowed by the layout, which may include writes
+        return access != D3D12_BARRIER_ACCESS_COMMON && (access & writeAccess) == 0;
+    }
+
+    static D3D12_BARRIER_LAYOUT getTextureLayout(const Texture* texture, ResourceStates state, D3D12_BARRIER_LAYOUT mappedLayout)
+    {
+        // The states that D3D12_BARRIER_LAYOUT_COMMON supports on all queues
+        const ResourceStates commonLayoutStates =
+            ResourceStates::Common |
+            ResourceStates::ShaderResource |
+            ResourceStates::CopySource |
+            ResourceStates::CopyDest |
+            ResourceStates::Present;
+
+        if (texture->commonLayout && (state & ~commonLayoutStates) == 0)
+            return D3D12_BARRIER_LAYOUT_COMMON;
+
+        if (mappedLayout == D3D12_BARRIER_LAYOUT_UNDEFINED)
+            return D3D12_BARRIER_LAYOUT_COMMON;
+
+        return mappedLayout;
+    }
+
+    static D3D12_BARRIER_SYNC restrictSyncToQueue(D3D12_BARRIER_SYNC sync, CommandQueue queueType)
+    {
+        constexpr D3D12_BARRIER_SYNC graphicsOnlySync =
+            D3D12_BARRIER_SYNC_DRAW |
+            D3D12_BARRIER_SYNC_INDEX_INPUT |
+            D3D12_BARRIER_SYNC_VERTEX_SHADING |
+            D3D12_BARRIER_SYNC_PIXEL_SHADING |
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL |
+            D3D12_BARRIER_SYNC_RENDER_TARGET |
+            D3D12_BARRIER_SYNC_RESOLVE;
+
+        // Copy and compute command lists reject the graphics-only sync scopes, fall back to SYNC_ALL there
+        if (sync == D3D12_BARRIER_SYNC_NONE || queueType == CommandQueue::Graphics)
+            return sync;
+
+        if (queueType == CommandQueue::Copy || (sync & graphicsOnlySync) != 0)
+            return D3D12_BARRIER_SYNC_ALL;
+
+        return sync;
+    }
+
+    void CommandList::convertPendingBarriersEnhanced()
+    {
+        const CommandQueue queueType = m_Desc.queueType;
+
+        m_D3DTextureBarriers.clear();
+        m_D3DBufferBarriers.clear();
+
+        for (const auto& barrier : m_StateTracker.getTextureBarriers())
+        {
+            const Texture* texture = static_cast<const Texture*>(barrier.texture);
+
+            const EnhancedBarrierState before = convertResourceStatesEnhanced(barrier.stateBefore);
+            const EnhancedBarrierState after = convertResourceStatesEnhanced(barrier.stateAfter);
+            const D3D12_BARRIER_LAYOUT layoutBefore = getTextureLayout(texture, barrier.stateBefore, before.layout);
+            const D3D12_BARRIER_LAYOUT layoutAfter = getTextureLayout(texture, barrier.stateAfter, after.layout);
+
+            // Reads after reads in the same layout have no hazard to resolve
+            if (layoutBefore == layoutAfter && isReadOnlyAccess(before.access) && isReadOnlyAccess(after.access))
+                continue;
+
+            D3D12_TEXTURE_BARRIER d3dbarrier{};
+            d3dbarrier.SyncBefore = restrictSyncToQueue(before.sync, queueType);
+            d3dbarrier.SyncAfter = restrictSyncToQueue(after.sync, queueType);
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.LayoutBefore = layoutBefore;
+            d3dbarrier.LayoutAfter = layoutAfter;
+            d3dbarrier.pResource = texture->resource;
+            d3dbarrier.Flags = D3D12_TEXTURE_BARRIER_FLAG_NONE;
+
+            if (barrier.entireTexture)
+            {
+                // IndexOrFirstMipLevel = 0xffffffff with NumMipLevels = 0 selects all subresources
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = 0xffffffff;
+            }
+            else
+            {
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = barrier.mipLevel;
+                d3dbarrier.Subresources.NumMipLevels = barrier.numMipLevels;
+                d3dbarrier.Subresources.FirstArraySlice = barrier.arraySlice;
+                d3dbarrier.Subresources.NumArraySlices = barrier.numArraySlices;
+                d3dbarrier.Subresources.FirstPlane = 0;
+                d3dbarrier.Subresources.NumPlanes = texture->planeCount;
+            }
+
+            m_D3DTextureBarriers.push_back(d3dbarrier);
+        }
+
+        for (const auto& barrier : m_StateTracker.getBufferBarriers())
+        {
+            const Buffer* buffer = static_cast<const Buffer*>(barrier.buffer);
+
+            const EnhancedBarrierState before = convertResourceStatesEnhanced(barrier.stateBefore);
+            const EnhancedBarrierState after = convertResourceStatesEnhanced(barrier.stateAfter);
+
+            // Buffers have no layout, so a barrier is only needed when either side writes
+            if (isReadOnlyAccess(before.access) && isReadOnlyAccess(after.access))
+                continue;
+
+            D3D12_BUFFER_BARRIER d3dbarrier{};
+            d3dbarrier.SyncBefore = restrictSyncToQueue(before.sync, queueType);
+            d3dbarrier.SyncAfter = restrictSyncToQueue(after.sync, queueType);
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.pResource = buffer->resource;
+            d3dbarrier.Offset = 0;
+            d3dbarrier.Size = UINT64_MAX;
+
+            m_D3DBufferBarriers.push_back(d3dbarrier);
+        }
+    }
+
+    void CommandList::issueEnhancedBarriers()
+    {
+        D3D12_BARRIER_GROUP barrierGroups[2]{};
+        uint32_t numBarrierGroups = 0;
+
+        if (!m_D3DTextureBarriers.empty())
+        {
+            D3D12_BARRIER_GROUP& group = barrierGroups[numBarrierGroups++];
+            group.Type = D3D12_BARRIER_TYPE_TEXTURE;
+            group.NumBarriers = uint32_t(m_D3DTextureBarriers.size());
+            group.pTextureBarriers = m_D3DTextureBarriers.data();
+        }
+
+        if (!m_D3DBufferBarriers.empty())
+        {
+            D3D12_BARRIER_GROUP& group = barrierGroups[numBarrierGroups++];
+            group.Type = D3D12_BARRIER_TYPE_BUFFER;
+            group.NumBarriers = uint32_t(m_D3DBufferBarriers.size());
+            group.pBufferBarriers = m_D3DBufferBarriers.data();
+        }
+
+        if (numBarrierGroups > 0)
+            m_ActiveCommandList->commandList7->Barrier(numBarrierGroups, barrierGroups);
+    }
+#endif
+
+    void CommandList::commitBarriers()
+    {
+        // All commands that cannot be recorded inside a render pass call commitBarriers first
+        suspendRenderPass();
+
+        if (m_StateTracker.getTextureBarriers().empty() && m_StateTracker.getBufferBarriers().empty())
+            return;
+
+        m_Statistics.barriersEmitted += uint32_t(m_StateTracker.getTextureBarriers().size() + m_StateTracker.getBufferBarriers().size());
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (m_Context.enhancedBarriersEnabled)
+        {
+            convertPendingBarriersEnhanced();
+            issueEnhancedBarriers();
+            m_StateTracker.clearBarriers();
+            return;
+        }
+#endif
+
+        convertPendingBarriers();
 
         if (m_D3DBarriers.size() > 0)
             m_ActiveCommandList->commandList->ResourceBarrier(uint32_t(m_D3DBarriers.size()), m_D3DBarriers.data());
@@ -175,6 +387,188 @@ namespace nvrhi::d3d12
         m_StateTracker.clearBarriers();
     }
 
+    bool CommandList::beginSplitBarriers(IResource* resource)
+    {
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (m_Context.enhancedBarriersEnabled)
+        {
+            convertPendingBarriersEnhanced();
+            m_StateTracker.clearBarriers();
+
+            for (D3D12_TEXTURE_BARRIER& d3dbarrier : m_D3DTextureBarriers)
+            {
+                SplitTextureBarrier splitBarrier;
+                splitBarrier.resource = resource;
+                splitBarrier.barrier = d3dbarrier;
+                splitBarrier.barrier.SyncBefore = D3D12_BARRIER_SYNC_SPLIT;
+                m_SplitTextureBarriers.push_back(splitBarrier);
+
+                d3dbarrier.SyncAfter = D3D12_BARRIER_SYNC_SPLIT;
+            }
+
+            for (D3D12_BUFFER_BARRIER& d3dbarrier : m_D3DBufferBarriers)
+            {
+                SplitBufferBarrier splitBarrier;
+                splitBarrier.resource = resource;
+                splitBarrier.barrier = d3dbarrier;
+                splitBarrier.barrier.SyncBefore = D3D12_BARRIER_SYNC_SPLIT;
+                m_SplitBufferBarriers.push_back(splitBarrier);
+
+                d3dbarrier.SyncAfter = D3D12_BARRIER_SYNC_SPLIT;
+            }
+
+            if (m_D3DTextureBarriers.empty() && m_D3DBufferBarriers.empty())
+                return false;
+
+            issueEnhancedBarriers();
+            return true;
+        }
+#endif
+
+        convertPendingBarriers();
+        m_StateTracker.clearBarriers();
+
+        // Transitions are split into BEGIN_ONLY and END_ONLY halves, UAV barriers cannot be split and are issued as-is
+        for (D3D12_RESOURCE_BARRIER& d3dbarrier : m_D3DBarriers)
+        {
+            if (d3dbarrier.Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+                continue;
+
+            SplitBarrier splitBarrier;
+            splitBarrier.resource = resource;
+            splitBarrier.barrier = d3dbarrier;
+            splitBarrier.barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            m_SplitBarriers.push_back(splitBarrier);
+
+            d3dbarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        }
+
+        if (m_D3DBarriers.empty())
+            return false;
+
+        m_ActiveCommandList->commandList->ResourceBarrier(uint32_t(m_D3DBarriers.size()), m_D3DBarriers.data());
+        return true;
+    }
+
+    void CommandList::endSplitBarriers(IResource* resource)
+    {
+        suspendRenderPass();
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (m_Context.enhancedBarriersEnabled)
+        {
+            m_D3DTextureBarriers.clear();
+            m_D3DBufferBarriers.clear();
+
+            auto textureIt = m_SplitTextureBarriers.begin();
+            while (textureIt != m_SplitTextureBarriers.end())
+            {
+                if (resource == nullptr || textureIt->resource == resource)
+                {
+                    m_D3DTextureBarriers.push_back(textureIt->barrier);
+                    textureIt = m_SplitTextureBarriers.erase(textureIt);
+                }
+                else
+                    ++textureIt;
+            }
+
+            auto bufferIt = m_SplitBufferBarriers.begin();
+            while (bufferIt != m_SplitBufferBarriers.end())
+            {
+                if (resource == nullptr || bufferIt->resource == resource)
+                {
+                    m_D3DBufferBarriers.push_back(bufferIt->barrier);
+                    bufferIt = m_SplitBufferBarriers.erase(bufferIt);
+                }
+                else
+                    ++bufferIt;
+            }
+
+            issueEnhancedBarriers();
+            return;
+        }
+#endif
+
+        m_D3DBarriers.clear();
+
+        auto it = m_SplitBarriers.begin();
+        while (it != m_SplitBarriers.end())
+        {
+            if (resource == nullptr || it->resource == resource)
+            {
+                m_D3DBarriers.push_back(it->barrier);
+                it = m_SplitBarriers.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        if (m_D3DBarriers.size() > 0)
+            m_ActiveCommandList->commandList->ResourceBarrier(uint32_t(m_D3DBarriers.size()), m_D3DBarriers.data());
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        commitBarriers();
+
+        m_StateTracker.requireTextureState(texture, subresources, stateBits);
+
+        // Referenced through the texture type, so that textures without trackLiveness are skipped
+        if (beginSplitBarriers(texture))
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::endTextureStateTransition(ITexture* texture)
+    {
+        endSplitBarriers(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        commitBarriers();
+
+        m_StateTracker.requireBufferState(buffer, stateBits);
+
+        if (beginSplitBarriers(buffer))
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::endBufferStateTransition(IBuffer* buffer)
+    {
+        endSplitBarriers(buffer);
+    }
+
+    void CommandList::textureAliasingBarrier(ITexture* _texture)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        aliasingBarrier(texture->resource);
+    }
+
+    void CommandList::bufferAliasingBarrier(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        aliasingBarrier(buffer->resource);
+    }
+
+    void CommandList::aliasingBarrier(ID3D12Resource* resource)
+    {
+        commitBarriers();
+
+        // A legacy aliasing barrier is also valid on command lists that use enhanced barriers.
+        // pResourceBefore = null means any of the placed resources that may have used the memory before.
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        barrier.Aliasing.pResourceBefore = nullptr;
+        barrier.Aliasing.pResourceAfter = resource;
+        m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
+    }
+
     void CommandList::setEnableAutomaticBarriers(bool enable)
     {
         m_EnableAutomaticBarriers = enable;
@@ -196,19 +590,8 @@ namespace nvrhi::d3d12
     
     ShaderTableState* CommandList::getShaderTableStateTracking(rt::IShaderTable* shaderTable)
     {
-        auto it = m_ShaderTableStates.find(shaderTable);
-
-        if (it != m_ShaderTableStates.end())
-        {
-            return it->second.get();
-        }
-
-        std::unique_ptr<ShaderTableState> trackingRef = std::make_unique<ShaderTableState>();
-
-        ShaderTableState* tracking = trackingRef.get();
-        m_ShaderTableStates.insert(std::make_pair(shaderTable, std::move(trackingRef)));
-
-        return tracking;
+        // New entries start out default-initialized. The pointer is only valid until the next new entry.
+        return &m_ShaderTableStates[shaderTable];
     }
 
     void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
@@ -229,7 +612,7 @@ namespace nvrhi::d3d12
     {
         Texture* texture = checked_cast<Texture*>(_texture);
 
-        m_StateTracker.requireTextureState(texture, subresources, stateBits);
+        requireTextureState(texture, subresources, stateBits);
 
         if (m_Instance)
             m_Instance->referencedResources.push_back(texture);
@@ -239,7 +622,7 @@ namespace nvrhi::d3d12
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.requireBufferState(buffer, stateBits);
+        requireBufferState(buffer, stateBits);
 
         if (m_Instance)
             m_Instance->referencedResources.push_back(buffer);
@@ -251,7 +634,7 @@ namespace nvrhi::d3d12
 
         if (as->dataBuffer)
         {
-            m_StateTracker.requireBufferState(as->dataBuffer, stateBits);
+            requireBufferState(as->dataBuffer, stateBits);
             
             if (m_Instance)
                 m_Instance->referencedResources.push_back(as);
@@ -153,6 +153,9 @@ namespace nvrhi::d3d12
 
         for (auto pair : m_CustomUAVs)
             m_Resources.shaderResourceViewHeap.releaseDescriptor(pair.second);
+
+        if (m_Resources.residencyManager)
+            m_Resources.residencyManager->unregisterObject(residency);
     }
 
     StagingTexture::SliceRegion StagingTexture::getSliceRegion(ID3D12Device *device, const TextureSlice& slice)
@@ -295,10 +298,29 @@ namespace nvrhi::d3d12
         return clearValue;
     }
 
+    // Textures that are only ever sampled or copied can live in D3D12_BARRIER_LAYOUT_COMMON with enhanced barriers.
+    // The initial state must also be compatible because the resource is created in the common state.
+    static bool canUseCommonLayout(const TextureDesc& d)
+    {
+        const ResourceStates commonLayoutStates =
+            ResourceStates::Common |
+            ResourceStates::ShaderResource |
+            ResourceStates::CopySource |
+            ResourceStates::CopyDest;
+
+        return !d.isRenderTarget
+            && !d.isUAV
+            && !d.isShadingRateSurface
+            && d.sampleCount == 1
+            && (d.initialState & ~commonLayoutStates) == 0;
+    }
+
     TextureHandle Device::createTexture(const TextureDesc & d)
     {
         D3D12_RESOURCE_DESC rd = convertTextureDesc(d);
         D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.CreationNodeMask = m_Context.nodeMask;
+        heapProps.VisibleNodeMask = m_Context.getVisibleNodeMask(d.visibleNodeMask);
         D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_NONE;
 
         bool isShared = false;
@@ -312,7 +334,14 @@ namespace nvrhi::d3d12
             isShared = true;
         }
 
+        if (d.isTiled)
+        {
+            // Reserved resources use the standard swizzle so that tile shapes are known
+            rd.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+        }
+
         Texture* texture = new Texture(m_Context, m_Resources, d, rd);
+        texture->commonLayout = m_Context.enhancedBarriersEnabled && canUseCommonLayout(d);
 
         if (d.isVirtual)
         {
@@ -323,14 +352,28 @@ namespace nvrhi::d3d12
         heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
 
         D3D12_CLEAR_VALUE clearValue = convertTextureClearValue(d);
+        const D3D12_RESOURCE_STATES initialState = texture->commonLayout ? D3D12_RESOURCE_STATE_COMMON : convertResourceStates(d.initialState);
 
-        HRESULT hr = m_Context.device->CreateCommittedResource(
-            &heapProps,
-            heapFlags,
-            &texture->resourceDesc,
-            convertResourceStates(d.initialState),
-            d.useClearValue ? &clearValue : nullptr,
-            IID_PPV_ARGS(&texture->resource));
+        HRESULT hr;
+        if (d.isTiled)
+        {
+            // Tiles are mapped to heap memory later, in updateTextureTileMappings
+            hr = m_Context.device->CreateReservedResource(
+                &texture->resourceDesc,
+                initialState,
+                d.useClearValue ? &clearValue : nullptr,
+                IID_PPV_ARGS(&texture->resource));
+        }
+        else
+        {
+            hr = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                heapFlags,
+                &texture->resourceDesc,
+                initialState,
+                d.useClearValue ? &clearValue : nullptr,
+                IID_PPV_ARGS(&texture->resource));
+        }
 
         if (FAILED(hr))
         {
@@ -368,6 +411,12 @@ namespace nvrhi::d3d12
 
         texture->postCreate();
 
+        if (!d.isTiled)
+        {
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &texture->resourceDesc);
+            initResidency(texture->residency, texture->resource, allocInfo.SizeInBytes, d.residencyPriority, !isShared);
+        }
+
         return TextureHandle::Create(texture);
     }
 
@@ -400,7 +449,7 @@ namespace nvrhi::d3d12
         HRESULT hr = m_Context.device->CreatePlacedResource(
             heap->heap, offset,
             &texture->resourceDesc,
-            convertResourceStates(texture->desc.initialState),
+            texture->commonLayout ? D3D12_RESOURCE_STATE_COMMON : convertResourceStates(texture->desc.initialState),
             texture->desc.useClearValue ? &clearValue : nullptr,
             IID_PPV_ARGS(&texture->resource));
 
@@ -420,6 +469,221 @@ namespace nvrhi::d3d12
 
         return true;
     }
+
+    bool Device::writeTextureDirect(ITexture*, uint32_t, uint32_t, const void*, size_t, size_t)
+    {
+        // WriteToSubresource only works for textures in CPU-accessible custom heaps, which nvrhi doesn't create
+        utils::NotSupported();
+        return false;
+    }
+
+    void Device::getTextureTiling(ITexture* _texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        UINT numTilesForEntireResource = 0;
+        D3D12_PACKED_MIP_INFO packedMipInfo = {};
+        D3D12_TILE_SHAPE standardTileShape = {};
+        UINT numSubresourceTilings = subresourceTilingsNum ? *subresourceTilingsNum : 0;
+        std::vector<D3D12_SUBRESOURCE_TILING> d3dSubresourceTilings(numSubresourceTilings);
+
+        m_Context.device->GetResourceTiling(texture->resource, &numTilesForEntireResource, &packedMipInfo, &standardTileShape,
+            subresourceTilingsNum ? &numSubresourceTilings : nullptr, 0, subresourceTilingsNum ? d3dSubresourceTilings.data() : nullptr);
+
+        if (numTiles)
+            *numTiles = numTilesForEntireResource;
+
+        if (desc)
+        {
+            desc->numStandardMips = packedMipInfo.NumStandardMips;
+            desc->numPackedMips = packedMipInfo.NumPackedMips;
+            desc->numTilesForPackedMips = packedMipInfo.NumTilesForPackedMips;
+            desc->startTileIndexInOverallResource = packedMipInfo.StartTileIndexInOverallResource;
+        }
+
+        if (tileShape)
+        {
+            tileShape->widthInTexels = standardTileShape.WidthInTexels;
+            tileShape->heightInTexels = standardTileShape.HeightInTexels;
+            tileShape->depthInTexels = standardTileShape.DepthInTexels;
+        }
+
+        if (subresourceTilingsNum)
+        {
+            *subresourceTilingsNum = numSubresourceTilings;
+
+            for (UINT i = 0; i < numSubresourceTilings; ++i)
+            {
+                subresourceTilings[i].widthInTiles = d3dSubresourceTilings[i].WidthInTiles;
+                subresourceTilings[i].heightInTiles = d3dSubresourceTilings[i].HeightInTiles;
+                subresourceTilings[i].depthInTiles = d3dSubresourceTilings[i].DepthInTiles;
+                subresourceTilings[i].startTileIndexInOverallResource = d3dSubresourceTilings[i].StartTileIndexInOverallResource;
+            }
+        }
+    }
+
+    void Device::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+        Queue* queue = getQueue(executionQueue);
+
+        if (!queue)
+            return;
+
+        std::vector<D3D12_TILED_RESOURCE_COORDINATE> resourceCoordinates;
+        std::vector<D3D12_TILE_REGION_SIZE> regionSizes;
+        std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags;
+        std::vector<UINT> heapStartOffsets;
+        std::vector<UINT> rangeTileCounts;
+
+        for (uint32_t n = 0; n < numTileMappings; ++n)
+        {
+            const TextureTilesMapping& mapping = tileMappings[n];
+            const uint32_t numRegions = mapping.numTextureRegions;
+            ID3D12Heap* heap = mapping.heap ? checked_cast<Heap*>(mapping.heap)->heap.Get() : nullptr;
+
+            resourceCoordinates.resize(numRegions);
+            regionSizes.resize(numRegions);
+            rangeFlags.resize(numRegions);
+            heapStartOffsets.resize(numRegions);
+            rangeTileCounts.resize(numRegions);
+
+            for (uint32_t i = 0; i < numRegions; ++i)
+            {
+                const TiledTextureCoordinate& coordinate = mapping.tiledTextureCoordinates[i];
+                const TiledTextureRegion& region = mapping.tiledTextureRegions[i];
+
+                resourceCoordinates[i].Subresource = calcSubresource(coordinate.mipLevel, coordinate.arrayLevel, 0, texture->desc.mipLevels, texture->desc.arraySize);
+                resourceCoordinates[i].X = coordinate.x;
+                resourceCoordinates[i].Y = coordinate.y;
+                resourceCoordinates[i].Z = coordinate.z;
+
+                if (region.width != 0 && region.height != 0 && region.depth != 0)
+                {
+                    regionSizes[i].UseBox = TRUE;
+                    regionSizes[i].Width = region.width;
+                    regionSizes[i].Height = UINT16(region.height);
+                    regionSizes[i].Depth = UINT16(region.depth);
+                    regionSizes[i].NumTiles = region.width * region.height * region.depth;
+                }
+                else
+                {
+                    regionSizes[i] = D3D12_TILE_REGION_SIZE{};
+                    regionSizes[i].UseBox = FALSE;
+                    regionSizes[i].NumTiles = region.tilesNum;
+                }
+
+                // Each region maps to its own range of consecutive tiles in the heap
+                rangeFlags[i] = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+                heapStartOffsets[i] = heap ? UINT(mapping.byteOffsets[i] / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES) : 0;
+                rangeTileCounts[i] = regionSizes[i].NumTiles;
+            }
+
+            queue->queue->UpdateTileMappings(texture->resource,
+                numRegions, resourceCoordinates.data(), regionSizes.data(),
+                heap,
+                numRegions, rangeFlags.data(), heapStartOffsets.data(), rangeTileCounts.data(),
+                D3D12_TILE_MAPPING_FLAG_NONE);
+        }
+    }
+
+    TextureHandle Device::createSamplerFeedbackTexture(ITexture* _pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+#if NVRHI_D3D12_WITH_SAMPLER_FEEDBACK
+        if (!m_SamplerFeedbackSupported)
+        {
+            utils::NotSupported();
+            return nullptr;
+        }
+
+        Texture* pairedTexture = checked_cast<Texture*>(_pairedTexture);
+
+        // The feedback map has the dimensions of the paired texture, but an opaque format that is only accessible through its UAV
+        TextureDesc textureDesc = pairedTexture->desc;
+        textureDesc.format = Format::UNKNOWN;
+        textureDesc.debugName = pairedTexture->desc.debugName + " (sampler feedback)";
+        textureDesc.isShaderResource = false;
+        textureDesc.isRenderTarget = false;
+        textureDesc.isUAV = true;
+        textureDesc.isTypeless = false;
+        textureDesc.isShadingRateSurface = false;
+        textureDesc.isTransient = false;
+        textureDesc.isVirtual = false;
+        textureDesc.isTiled = false;
+        textureDesc.sharedResourceFlags = SharedResourceFlags::None;
+        textureDesc.useClearValue = false;
+        textureDesc.initialState = desc.initialState;
+        textureDesc.keepInitialState = desc.keepInitialState;
+
+        D3D12_RESOURCE_DESC1 rd = {};
+        rd.Dimension = pairedTexture->resourceDesc.Dimension;
+        rd.Width = pairedTexture->resourceDesc.Width;
+        rd.Height = pairedTexture->resourceDesc.Height;
+        rd.DepthOrArraySize = pairedTexture->resourceDesc.DepthOrArraySize;
+        rd.MipLevels = pairedTexture->resourceDesc.MipLevels;
+        rd.Format = desc.samplerFeedbackFormat == SamplerFeedbackFormat::MinMipOpaque
+            ? DXGI_FORMAT_SAMPLER_FEEDBACK_MIN_MIP_OPAQUE
+            : DXGI_FORMAT_SAMPLER_FEEDBACK_MIP_REGION_USED_OPAQUE;
+        rd.SampleDesc.Count = 1;
+        rd.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        rd.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        rd.SamplerFeedbackMipRegion.Width = desc.samplerFeedbackMipRegionX;
+        rd.SamplerFeedbackMipRegion.Height = desc.samplerFeedbackMipRegionY;
+        rd.SamplerFeedbackMipRegion.Depth = desc.samplerFeedbackMipRegionZ;
+
+        D3D12_RESOURCE_DESC legacyDesc = {};
+        legacyDesc.Dimension = rd.Dimension;
+        legacyDesc.Width = rd.Width;
+        legacyDesc.Height = rd.Height;
+        legacyDesc.DepthOrArraySize = rd.DepthOrArraySize;
+        legacyDesc.MipLevels = rd.MipLevels;
+        legacyDesc.Format = rd.Format;
+        legacyDesc.SampleDesc = rd.SampleDesc;
+        legacyDesc.Layout = rd.Layout;
+        legacyDesc.Flags = rd.Flags;
+
+        Texture* texture = new Texture(m_Context, m_Resources, textureDesc, legacyDesc);
+        texture->pairedTexture = pairedTexture;
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+        heapProps.CreationNodeMask = m_Context.nodeMask;
+        heapProps.VisibleNodeMask = m_Context.nodeMask;
+
+        HRESULT hr = m_Context.device8->CreateCommittedResource2(
+            &heapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &rd,
+            convertResourceStates(desc.initialState),
+            nullptr,
+            nullptr,
+            IID_PPV_ARGS(&texture->resource));
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to create sampler feedback texture " << utils::DebugNameToString(textureDesc.debugName) << ", error code = 0x";
+            ss.setf(std::ios::hex, std::ios::basefield);
+            ss << hr;
+            m_Context.error(ss.str());
+
+            delete texture;
+            return nullptr;
+        }
+
+        texture->postCreate();
+
+        // The opaque feedback formats are not reported by CheckFeatureSupport, but the maps have a single plane
+        texture->planeCount = 1;
+
+        return TextureHandle::Create(texture);
+#else
+        (void)_pairedTexture;
+        (void)desc;
+        utils::NotSupported();
+        return nullptr;
+#endif
+    }
     
     TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object _texture, const TextureDesc& desc)
     {
@@ -602,6 +866,18 @@ namespace nvrhi::d3d12
 
     void Texture::createUAV(size_t descriptor, Format format, TextureDimension dimension, TextureSubresourceSet subresources) const
     {
+#if NVRHI_D3D12_WITH_SAMPLER_FEEDBACK
+        if (pairedTexture)
+        {
+            // Sampler feedback UAVs always cover the entire feedback map
+            m_Context.device8->CreateSamplerFeedbackUnorderedAccessView(
+                checked_cast<Texture*>(pairedTexture.Get())->resource,
+                resource,
+                { descriptor });
+            return;
+        }
+#endif
+
         subresources = subresources.resolve(desc, true);
 
         if (dimension == TextureDimension::Unknown)
@@ -776,7 +1052,17 @@ namespace nvrhi::d3d12
         m_Context.device->CreateDepthStencilView(resource, &viewDesc, { descriptor });
     }
 
-    void *Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    void *Device::mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch, true);
+    }
+
+    void *Device::tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch, false);
+    }
+
+    void *Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch, bool wait)
     {
         StagingTexture* tex = checked_cast<StagingTexture*>(_tex);
 
@@ -791,6 +1077,9 @@ namespace nvrhi::d3d12
 
         if (tex->lastUseFence)
         {
+            if (!wait && tex->lastUseFence->GetCompletedValue() < tex->lastUseFenceValue)
+                return nullptr;
+
             WaitForFence(tex->lastUseFence, tex->lastUseFenceValue, m_FenceEvent);
             tex->lastUseFence = nullptr;
         }
@@ -985,6 +1274,10 @@ namespace nvrhi::d3d12
                     m_Resources.shaderResourceViewHeap.getGpuHandle(index),
                     m_Resources.shaderResourceViewHeap.getCpuHandle(index),
                     t->resource, clearValues, 0, nullptr);
+
+                // Sampler feedback UAVs cover all mip levels, so one clear is enough
+                if (t->pairedTexture)
+                    break;
             }
         }
         else if (t->desc.isRenderTarget)
@@ -1202,7 +1495,107 @@ namespace nvrhi::d3d12
             m_CurrentUploadBuffer = uploadBuffer;
         }
 
+        suspendPredication();
         m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
+        resumePredication();
+    }
+
+    void CommandList::writeTexture(ITexture* _dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        TextureSubresourceSet subresourceSet = subresources.resolve(dest->desc, false);
+        if (numSubresources != size_t(subresourceSet.numArraySlices) * subresourceSet.numMipLevels)
+            // let the validation layer handle the messages
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, subresourceSet, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        D3D12_RESOURCE_DESC resourceDesc = dest->resource->GetDesc();
+
+        // Mip levels of one array slice are consecutive subresources, so get their footprints with one call per slice
+        // and place the slices one after another in a single upload allocation.
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(numSubresources);
+        std::vector<uint32_t> numRows(numSubresources);
+        std::vector<uint64_t> rowSizesInBytes(numSubresources);
+        uint64_t totalBytes = 0;
+
+        for (ArraySlice arrayIndex = 0; arrayIndex < subresourceSet.numArraySlices; arrayIndex++)
+        {
+            const size_t firstIndex = size_t(arrayIndex) * subresourceSet.numMipLevels;
+            const uint32_t firstSubresource = calcSubresource(subresourceSet.baseMipLevel, arrayIndex + subresourceSet.baseArraySlice, 0,
+                dest->desc.mipLevels, dest->desc.arraySize);
+
+            uint64_t sliceBytes = 0;
+            m_Context.device->GetCopyableFootprints(&resourceDesc, firstSubresource, subresourceSet.numMipLevels, 0,
+                &footprints[firstIndex], &numRows[firstIndex], &rowSizesInBytes[firstIndex], &sliceBytes);
+
+            for (MipLevel mipIndex = 0; mipIndex < subresourceSet.numMipLevels; mipIndex++)
+                footprints[firstIndex + mipIndex].Offset += totalBytes;
+
+            totalBytes = align(totalBytes + sliceBytes, uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+        }
+
+        void* cpuVA;
+        ID3D12Resource* uploadBuffer;
+        size_t offsetInUploadBuffer;
+        if (!m_UploadManager.suballocateBuffer(totalBytes, nullptr, &uploadBuffer, &offsetInUploadBuffer, &cpuVA, nullptr, 
+            m_RecordingVersion, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
+
+        m_Instance->referencedResources.push_back(dest);
+
+        if (uploadBuffer != m_CurrentUploadBuffer)
+        {
+            m_Instance->referencedNativeResources.push_back(uploadBuffer);
+            m_CurrentUploadBuffer = uploadBuffer;
+        }
+
+        suspendPredication();
+
+        for (size_t index = 0; index < numSubresources; index++)
+        {
+            const TextureSubresourceData& subresourceData = data[index];
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = footprints[index];
+
+            assert(numRows[index] <= footprint.Footprint.Height);
+
+            for (uint32_t depthSlice = 0; depthSlice < footprint.Footprint.Depth; depthSlice++)
+            {
+                for (uint32_t row = 0; row < numRows[index]; row++)
+                {
+                    void* destAddress = (char*)cpuVA + footprint.Offset + footprint.Footprint.RowPitch * (row + depthSlice * numRows[index]);
+                    const void* srcAddress = (const char*)subresourceData.data + subresourceData.rowPitch * row + subresourceData.depthPitch * depthSlice;
+                    memcpy(destAddress, srcAddress, std::min(subresourceData.rowPitch, rowSizesInBytes[index]));
+                }
+            }
+
+            const MipLevel mipLevel = subresourceSet.baseMipLevel + MipLevel(index % subresourceSet.numMipLevels);
+            const ArraySlice arraySlice = subresourceSet.baseArraySlice + ArraySlice(index / subresourceSet.numMipLevels);
+
+            footprint.Offset += uint64_t(offsetInUploadBuffer);
+
+            D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
+            destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            destCopyLocation.SubresourceIndex = calcSubresource(mipLevel, arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+            destCopyLocation.pResource = dest->resource;
+
+            D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
+            srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcCopyLocation.PlacedFootprint = footprint;
+            srcCopyLocation.pResource = uploadBuffer;
+
+            m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
+        }
+
+        resumePredication();
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
@@ -1240,6 +1633,39 @@ namespace nvrhi::d3d12
         }
     }
 
+    void CommandList::decodeSamplerFeedbackTexture(ITexture* _dest, ITexture* _feedbackTexture)
+    {
+#if NVRHI_D3D12_WITH_SAMPLER_FEEDBACK
+        Texture* dest = checked_cast<Texture*>(_dest);
+        Texture* feedbackTexture = checked_cast<Texture*>(_feedbackTexture);
+
+        if (!feedbackTexture->pairedTexture || !m_ActiveCommandList->commandList4)
+            // let the validation layer handle the messages
+            return;
+
+        const TextureSubresourceSet subresources(0, 1, 0, 1);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, subresources, ResourceStates::ResolveDest);
+            requireTextureState(feedbackTexture, subresources, ResourceStates::ResolveSource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dest);
+        m_Instance->referencedResources.push_back(feedbackTexture);
+
+        m_ActiveCommandList->commandList4->ResolveSubresourceRegion(
+            dest->resource, 0, 0, 0,
+            feedbackTexture->resource, 0, nullptr,
+            DXGI_FORMAT_R8_UINT, D3D12_RESOLVE_MODE_DECODE_SAMPLER_FEEDBACK);
+#else
+        (void)_dest;
+        (void)_feedbackTexture;
+        utils::NotSupported();
+#endif
+    }
+
     // helper function for texture subresource calculations
     // https://msdn.microsoft.com/en-us/library/windows/desktop/dn705766(v=vs.85).aspx
     uint32_t calcSubresource(uint32_t MipSlice, uint32_t ArraySlice, uint32_t PlaneSlice, uint32_t MipLevels, uint32_t ArraySize)
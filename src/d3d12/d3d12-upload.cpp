@@ -37,24 +37,16 @@ namespace nvrhi::d3d12
         }
     }
     
-    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
-        : m_Context(context)
-        , m_Queue(pQueue)
-        , m_DefaultChunkSize(defaultChunkSize)
-        , m_MemoryLimit(memoryLimit)
-        , m_IsScratchBuffer(isScratchBuffer)
-    {
-        assert(pQueue);
-    }
-
-    std::shared_ptr<BufferChunk> UploadManager::createChunk(size_t size) const
+    std::shared_ptr<BufferChunk> createBufferChunk(const Context& context, uint64_t size, bool isScratchBuffer, uint32_t identifier)
     {
         auto chunk = std::make_shared<BufferChunk>();
 
         size = align(size, BufferChunk::c_sizeAlignment);
 
         D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = m_IsScratchBuffer ? D3D12_HEAP_TYPE_DEFAULT : D3D12_HEAP_TYPE_UPLOAD;
+        heapProps.Type = isScratchBuffer ? D3D12_HEAP_TYPE_DEFAULT : D3D12_HEAP_TYPE_UPLOAD;
+        heapProps.CreationNodeMask = context.nodeMask;
+        heapProps.VisibleNodeMask = context.nodeMask;
 
         D3D12_RESOURCE_DESC bufferDesc = {};
         bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -64,20 +56,20 @@ namespace nvrhi::d3d12
         bufferDesc.MipLevels = 1;
         bufferDesc.SampleDesc.Count = 1;
         bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        if (m_IsScratchBuffer) bufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        if (isScratchBuffer) bufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
-        HRESULT hr = m_Context.device->CreateCommittedResource(
+        HRESULT hr = context.device->CreateCommittedResource(
             &heapProps,
             D3D12_HEAP_FLAG_NONE,
             &bufferDesc,
-            m_IsScratchBuffer ? D3D12_RESOURCE_STATE_COMMON: D3D12_RESOURCE_STATE_GENERIC_READ,
+            isScratchBuffer ? D3D12_RESOURCE_STATE_COMMON: D3D12_RESOURCE_STATE_GENERIC_READ,
             nullptr,
             IID_PPV_ARGS(&chunk->buffer));
 
         if (FAILED(hr))
             return nullptr;
 
-        if (!m_IsScratchBuffer)
+        if (!isScratchBuffer)
         {
             hr = chunk->buffer->Map(0, nullptr, &chunk->cpuVA);
 
@@ -87,10 +79,10 @@ namespace nvrhi::d3d12
 
         chunk->bufferSize = size;
         chunk->gpuVA = chunk->buffer->GetGPUVirtualAddress();
-        chunk->identifier = uint32_t(m_ChunkPool.size());
+        chunk->identifier = identifier;
 
         std::wstringstream wss;
-        if (m_IsScratchBuffer)
+        if (isScratchBuffer)
             wss << L"DXR Scratch Buffer " << chunk->identifier;
         else
             wss << L"Upload Buffer " << chunk->identifier;
@@ -98,6 +90,48 @@ namespace nvrhi::d3d12
 
         return chunk;
     }
+
+    UploadManager::UploadManager(const Context& context, class Queue* pQueue, UploadChunkPool* pSharedChunkPool, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+        : m_Context(context)
+        , m_Queue(pQueue)
+        , m_DefaultChunkSize(defaultChunkSize)
+        , m_MemoryLimit(memoryLimit)
+        , m_IsScratchBuffer(isScratchBuffer)
+        , m_SharedChunkPool(pSharedChunkPool)
+    {
+        assert(pQueue);
+        assert(!isScratchBuffer || !pSharedChunkPool);
+    }
+
+    UploadManager::~UploadManager()
+    {
+        if (m_SharedChunkPool)
+        {
+            // All chunks that are still owned by the command list have never been submitted
+            if (m_CurrentChunk)
+            {
+                m_ChunkPool.push_back(m_CurrentChunk);
+                m_CurrentChunk.reset();
+            }
+
+            returnUnsubmittedChunks(0);
+        }
+    }
+
+    void UploadManager::returnUnsubmittedChunks(uint64_t currentVersion)
+    {
+        // Chunks written by a recording that was never executed cannot be in use by the GPU
+        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); )
+        {
+            if ((*it)->version != currentVersion && !VersionGetSubmitted((*it)->version))
+            {
+                m_SharedChunkPool->returnPage(*it);
+                it = m_ChunkPool.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
         
     bool UploadManager::suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset,
         void** pCpuVA, D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment)
@@ -117,6 +151,7 @@ namespace nvrhi::d3d12
             {
                 // The buffer can fit into the current chunk - great, we're done
                 m_CurrentChunk->writePointer = endOfDataInChunk;
+                m_SuballocatedBytes += size;
 
                 if (pBuffer) *pBuffer = m_CurrentChunk->buffer;
                 if (pOffset) *pOffset = alignedOffset;
@@ -132,6 +167,40 @@ namespace nvrhi::d3d12
             m_CurrentChunk.reset();
         }
 
+        if (m_SharedChunkPool)
+        {
+            // Upload chunks are recycled through the device-global pool, see UploadPagePool
+            if (chunkToRetire)
+            {
+                m_ChunkPool.push_back(chunkToRetire);
+            }
+
+            returnUnsubmittedChunks(currentVersion);
+
+            m_CurrentChunk = m_SharedChunkPool->acquirePage(size, m_DefaultChunkSize);
+            if (!m_CurrentChunk)
+                return false;
+        }
+        else if (!acquireOwnedChunk(size, pCommandList, chunkToRetire))
+        {
+            return false;
+        }
+
+        m_CurrentChunk->version = currentVersion;
+        m_CurrentChunk->writePointer = size;
+        m_SuballocatedBytes += size;
+        m_AcquiredChunks++;
+
+        if (pBuffer) *pBuffer = m_CurrentChunk->buffer;
+        if (pOffset) *pOffset = 0;
+        if (pCpuVA) *pCpuVA = m_CurrentChunk->cpuVA;
+        if (pGpuVA) *pGpuVA = m_CurrentChunk->gpuVA;
+
+        return true;
+    }
+
+    bool UploadManager::acquireOwnedChunk(uint64_t size, ID3D12GraphicsCommandList* pCommandList, const std::shared_ptr<BufferChunk>& chunkToRetire)
+    {
         uint64_t completedInstance = m_Queue->lastCompletedInstance;
 
         // Try to find a chunk in the pool that's no longer used and is large enough to allocate our buffer
@@ -223,18 +292,12 @@ namespace nvrhi::d3d12
             }
             else
             {
-                m_CurrentChunk = createChunk(sizeToAllocate);
+                m_CurrentChunk = createBufferChunk(m_Context, sizeToAllocate, m_IsScratchBuffer, uint32_t(m_ChunkPool.size()));
+                if (!m_CurrentChunk)
+                    return false;
             }
         }
 
-        m_CurrentChunk->version = currentVersion;
-        m_CurrentChunk->writePointer = size;
-
-        if (pBuffer) *pBuffer = m_CurrentChunk->buffer;
-        if (pOffset) *pOffset = 0;
-        if (pCpuVA) *pCpuVA = m_CurrentChunk->cpuVA;
-        if (pGpuVA) *pGpuVA = m_CurrentChunk->gpuVA;
-
         return true;
     }
 
@@ -246,6 +309,27 @@ namespace nvrhi::d3d12
             m_CurrentChunk.reset();
         }
 
+        if (m_SharedChunkPool)
+        {
+            // Hand the chunks of this instance over to the pool, which recycles them when the instance has finished executing
+            std::vector<std::shared_ptr<BufferChunk>> submittedChunks;
+            for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); )
+            {
+                if ((*it)->version == currentVersion)
+                {
+                    (*it)->version = submittedVersion;
+                    submittedChunks.push_back(*it);
+                    it = m_ChunkPool.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            m_SharedChunkPool->submitPages(submittedChunks);
+            returnUnsubmittedChunks(currentVersion);
+            return;
+        }
+
         for (const auto& chunk : m_ChunkPool)
         {
             if (chunk->version == currentVersion)
@@ -0,0 +1,349 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace nvrhi::d3d12
+{
+    uint32_t WorkGraph::getEntryPointIndex(const char* nodeName, uint32_t arrayIndex) const
+    {
+        for (size_t index = 0; index < entryPoints.size(); index++)
+        {
+            const EntryPoint& entryPoint = entryPoints[index];
+            if (entryPoint.arrayIndex == arrayIndex && entryPoint.nodeName == nodeName)
+                return uint32_t(index);
+        }
+
+        return ~0u;
+    }
+
+    uint32_t WorkGraph::getEntryPointRecordSize(uint32_t entryPointIndex) const
+    {
+        if (entryPointIndex >= entryPoints.size())
+            return 0;
+
+        return entryPoints[entryPointIndex].recordSize;
+    }
+
+    WorkGraphHandle Device::createWorkGraph([[maybe_unused]] const WorkGraphDesc& desc)
+    {
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        if (!m_WorkGraphsSupported)
+        {
+            m_Context.error("Work graphs are not supported by this device");
+            return nullptr;
+        }
+
+        WorkGraph* workGraph = new WorkGraph();
+        WorkGraphHandle workGraphHandle = WorkGraphHandle::Create(workGraph);
+        workGraph->desc = desc;
+
+        // The graph runs with the compute root signature, so the regular compute binding path is used for it
+        workGraph->rootSignature = getRootSignature(desc.globalBindingLayouts, false);
+
+        static const wchar_t* c_ProgramName = L"WorkGraph";
+
+        std::vector<D3D12_DXIL_LIBRARY_DESC> d3dDxilLibraries;
+        d3dDxilLibraries.reserve(desc.libraries.size());
+
+        for (const ShaderLibraryHandle& library : desc.libraries)
+        {
+            // Export everything from the library, the graph picks up all nodes that it finds
+            D3D12_DXIL_LIBRARY_DESC d3dLibraryDesc = {};
+            library->getBytecode(&d3dLibraryDesc.DXILLibrary.pShaderBytecode, &d3dLibraryDesc.DXILLibrary.BytecodeLength);
+            d3dDxilLibraries.push_back(d3dLibraryDesc);
+        }
+
+        std::vector<D3D12_STATE_SUBOBJECT> d3dSubobjects;
+        D3D12_STATE_SUBOBJECT d3dSubobject = {};
+
+        for (const D3D12_DXIL_LIBRARY_DESC& d3dLibraryDesc : d3dDxilLibraries)
+        {
+            d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY;
+            d3dSubobject.pDesc = &d3dLibraryDesc;
+            d3dSubobjects.push_back(d3dSubobject);
+        }
+
+        D3D12_GLOBAL_ROOT_SIGNATURE d3dGlobalRootSignature = {};
+        d3dGlobalRootSignature.pGlobalRootSignature = workGraph->rootSignature->handle;
+
+        d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE;
+        d3dSubobject.pDesc = &d3dGlobalRootSignature;
+        d3dSubobjects.push_back(d3dSubobject);
+
+        D3D12_WORK_GRAPH_DESC d3dWorkGraphDesc = {};
+        d3dWorkGraphDesc.ProgramName = c_ProgramName;
+        d3dWorkGraphDesc.Flags = D3D12_WORK_GRAPH_FLAG_INCLUDE_ALL_AVAILABLE_NODES;
+
+        d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_WORK_GRAPH;
+        d3dSubobject.pDesc = &d3dWorkGraphDesc;
+        d3dSubobjects.push_back(d3dSubobject);
+
+        D3D12_NODE_MASK d3dNodeMask = { m_Context.nodeMask };
+
+        if (m_Context.nodeMask != 0)
+        {
+            d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_NODE_MASK;
+            d3dSubobject.pDesc = &d3dNodeMask;
+            d3dSubobjects.push_back(d3dSubobject);
+        }
+
+        D3D12_STATE_OBJECT_DESC stateObjectDesc = {};
+        stateObjectDesc.Type = D3D12_STATE_OBJECT_TYPE_EXECUTABLE;
+        stateObjectDesc.NumSubobjects = UINT(d3dSubobjects.size());
+        stateObjectDesc.pSubobjects = d3dSubobjects.data();
+
+        HRESULT hr = m_Context.device5->CreateStateObject(&stateObjectDesc, IID_PPV_ARGS(&workGraph->stateObject));
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to create work graph " << utils::DebugNameToString(desc.debugName)
+                << ", HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        if (!desc.debugName.empty())
+        {
+            std::wstring wname(desc.debugName.begin(), desc.debugName.end());
+            workGraph->stateObject->SetName(wname.c_str());
+        }
+
+        RefCountPtr<ID3D12StateObjectProperties1> stateObjectProperties;
+        RefCountPtr<ID3D12WorkGraphProperties> workGraphProperties;
+        if (FAILED(workGraph->stateObject->QueryInterface(IID_PPV_ARGS(&stateObjectProperties))) ||
+            FAILED(workGraph->stateObject->QueryInterface(IID_PPV_ARGS(&workGraphProperties))))
+        {
+            m_Context.error("Failed to get the work graph properties interfaces from a state object");
+            return nullptr;
+        }
+
+        workGraph->programIdentifier = stateObjectProperties->GetProgramIdentifier(c_ProgramName);
+
+        const UINT workGraphIndex = workGraphProperties->GetWorkGraphIndex(c_ProgramName);
+
+        D3D12_WORK_GRAPH_MEMORY_REQUIREMENTS d3dMemoryRequirements = {};
+        workGraphProperties->GetWorkGraphMemoryRequirements(workGraphIndex, &d3dMemoryRequirements);
+        workGraph->memoryRequirements.minSize = d3dMemoryRequirements.MinSizeInBytes;
+        workGraph->memoryRequirements.maxSize = d3dMemoryRequirements.MaxSizeInBytes;
+        workGraph->memoryRequirements.sizeGranularity = d3dMemoryRequirements.SizeGranularityInBytes;
+
+        const UINT numEntryPoints = workGraphProperties->GetNumEntrypoints(workGraphIndex);
+        workGraph->entryPoints.resize(numEntryPoints);
+
+        for (UINT entryPointIndex = 0; entryPointIndex < numEntryPoints; entryPointIndex++)
+        {
+            const D3D12_NODE_ID nodeId = workGraphProperties->GetEntrypointID(workGraphIndex, entryPointIndex);
+            const std::wstring nodeName = nodeId.Name ? nodeId.Name : L"";
+
+            WorkGraph::EntryPoint& entryPoint = workGraph->entryPoints[entryPointIndex];
+            entryPoint.nodeName.reserve(nodeName.size());
+            for (wchar_t c : nodeName)
+                entryPoint.nodeName.push_back(char(c));
+            entryPoint.arrayIndex = nodeId.ArrayIndex;
+            entryPoint.recordSize = workGraphProperties->GetEntrypointRecordSizeInBytes(workGraphIndex, entryPointIndex);
+        }
+
+        const WorkGraphMemoryRequirements& requirements = workGraph->memoryRequirements;
+
+        if (desc.createBackingMemory && requirements.maxSize > 0)
+        {
+            uint64_t size = std::clamp(desc.backingMemorySize, requirements.minSize, requirements.maxSize);
+
+            // Sizes above the minimum go in steps of the granularity
+            if (requirements.sizeGranularity > 1 && size > requirements.minSize)
+            {
+                const uint64_t steps = (size - requirements.minSize + requirements.sizeGranularity - 1) / requirements.sizeGranularity;
+                size = std::min(requirements.minSize + steps * requirements.sizeGranularity, requirements.maxSize);
+            }
+
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = std::max(size, uint64_t(1));
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.initialState = ResourceStates::UnorderedAccess;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = desc.debugName.empty() ? "WorkGraphBackingMemory" : desc.debugName + " backing memory";
+
+            workGraph->backingMemory = createBuffer(bufferDesc);
+            if (!workGraph->backingMemory)
+                return nullptr;
+        }
+
+        return workGraphHandle;
+#else
+        utils::NotSupported();
+        return nullptr;
+#endif
+    }
+
+    void CommandList::setWorkGraphState([[maybe_unused]] const WorkGraphState& state)
+    {
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        WorkGraph* workGraph = checked_cast<WorkGraph*>(state.workGraph);
+        IBuffer* backingMemory = state.backingMemory ? state.backingMemory : workGraph->backingMemory.Get();
+
+        if (!m_ActiveCommandList->commandList10)
+        {
+            m_Context.error("Work graphs require a command list that supports ID3D12GraphicsCommandList10");
+            return;
+        }
+
+        if (!backingMemory && workGraph->memoryRequirements.minSize > 0)
+        {
+            std::stringstream ss;
+            ss << "Work graph " << utils::DebugNameToString(workGraph->desc.debugName)
+                << " needs backing memory, but none was created with it or provided in the state";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        const bool updateRootSignature = !m_CurrentWorkGraphStateValid || m_CurrentWorkGraphState.workGraph == nullptr ||
+            checked_cast<WorkGraph*>(m_CurrentWorkGraphState.workGraph)->rootSignature != workGraph->rootSignature;
+
+        const bool updateProgram = !m_CurrentWorkGraphStateValid || m_CurrentWorkGraphState.workGraph != state.workGraph ||
+            m_CurrentWorkGraphBackingMemory != backingMemory;
+
+        uint32_t bindingUpdateMask = 0;
+        if (!m_CurrentWorkGraphStateValid || updateRootSignature)
+            bindingUpdateMask = ~0u;
+
+        if (commitDescriptorHeaps())
+            bindingUpdateMask = ~0u;
+
+        if (bindingUpdateMask == 0)
+            bindingUpdateMask = arrayDifferenceMask(m_CurrentWorkGraphState.bindings, state.bindings);
+
+        if (updateRootSignature)
+        {
+            m_ActiveCommandList->commandList->SetComputeRootSignature(workGraph->rootSignature->handle);
+        }
+
+        if (backingMemory && m_EnableAutomaticBarriers)
+        {
+            requireBufferState(backingMemory, ResourceStates::UnorderedAccess);
+        }
+
+        if (updateProgram)
+        {
+            D3D12_SET_PROGRAM_DESC programDesc = {};
+            programDesc.Type = D3D12_PROGRAM_TYPE_WORK_GRAPH;
+            programDesc.WorkGraph.ProgramIdentifier = workGraph->programIdentifier;
+            programDesc.WorkGraph.Flags = D3D12_SET_WORK_GRAPH_FLAG_NONE;
+
+            if (backingMemory)
+            {
+                Buffer* buffer = checked_cast<Buffer*>(backingMemory);
+                programDesc.WorkGraph.BackingMemory.StartAddress = buffer->gpuVA;
+                programDesc.WorkGraph.BackingMemory.SizeInBytes = buffer->desc.byteSize;
+
+                // The memory holds the graph's internal state and has to be initialized before it's used
+                // with a graph for the first time. The recording order is the only order known here,
+                // so that is done once per recording, and again whenever another graph used the memory in between.
+                IWorkGraph*& initializedFor = m_WorkGraphBackingMemoryOwners[backingMemory];
+                if (initializedFor != workGraph)
+                {
+                    programDesc.WorkGraph.Flags = D3D12_SET_WORK_GRAPH_FLAG_INITIALIZE;
+                    initializedFor = workGraph;
+                }
+
+                m_Instance->referencedResources.push_back(backingMemory);
+            }
+
+            m_Statistics.pipelineBinds++;
+            m_ActiveCommandList->commandList10->SetProgram(&programDesc);
+
+            m_Instance->referencedResources.push_back(workGraph);
+        }
+
+        setComputeBindings(state.bindings, bindingUpdateMask, nullptr, false, workGraph->rootSignature);
+
+        unbindShadingRateState();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentWorkGraphStateValid = true;
+        m_CurrentWorkGraphState = state;
+        m_CurrentWorkGraphBackingMemory = backingMemory;
+
+        commitBarriers();
+#else
+        utils::NotSupported();
+#endif
+    }
+
+    void CommandList::dispatchGraph([[maybe_unused]] const DispatchGraphArguments& args)
+    {
+#if NVRHI_D3D12_WITH_WORK_GRAPHS
+        updateComputeVolatileBuffers();
+
+        if (!m_CurrentWorkGraphStateValid)
+        {
+            m_Context.error("setWorkGraphState must be called before dispatchGraph");
+            return;
+        }
+
+        D3D12_DISPATCH_GRAPH_DESC desc = {};
+
+        if (args.inputBuffer)
+        {
+            Buffer* inputBuffer = checked_cast<Buffer*>(args.inputBuffer);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(inputBuffer, ResourceStates::IndirectArgument);
+                commitBarriers();
+            }
+
+            m_Instance->referencedResources.push_back(inputBuffer);
+
+            desc.Mode = D3D12_DISPATCH_MODE_NODE_GPU_INPUT;
+            desc.NodeGPUInput = inputBuffer->gpuVA + args.inputOffset;
+        }
+        else
+        {
+            const WorkGraph* workGraph = checked_cast<const WorkGraph*>(m_CurrentWorkGraphState.workGraph);
+
+            // The runtime copies the records into the command list
+            desc.Mode = D3D12_DISPATCH_MODE_NODE_CPU_INPUT;
+            desc.NodeCPUInput.EntrypointIndex = args.entryPointIndex;
+            desc.NodeCPUInput.NumRecords = args.numRecords;
+            desc.NodeCPUInput.pRecords = args.records;
+            desc.NodeCPUInput.RecordStrideInBytes = args.recordStride
+                ? args.recordStride
+                : workGraph->getEntryPointRecordSize(args.entryPointIndex);
+        }
+
+        m_Statistics.dispatchCalls++;
+        m_ActiveCommandList->commandList10->DispatchGraph(&desc);
+#else
+        utils::NotSupported();
+#endif
+    }
+
+} // namespace nvrhi::d3d12
@@ -0,0 +1,685 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/null.h>
+#include <nvrhi/utils.h>
+#include "../common/binding-set-cache.h"
+#include "../common/gc-budget.h"
+#include "../common/referenced-resources.h"
+#include "../common/state-tracking.h"
+#include "../common/submission-callbacks.h"
+#include "../common/upload-page-pool.h"
+#include "../common/versioning.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nvrhi::null
+{
+    struct Context
+    {
+        IMessageCallback* messageCallback = nullptr;
+        GraphicsAPI graphicsAPI = GraphicsAPI::D3D12;
+
+        void error(const std::string& message) const;
+    };
+
+    // Size of a texture's subresources when they are stored tightly packed, array slice by array slice
+    struct SubresourceLayout
+    {
+        uint64_t offset = 0;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+    };
+
+    [[nodiscard]] SubresourceLayout getSubresourceLayout(const TextureDesc& desc, ArraySlice arraySlice, MipLevel mipLevel);
+    [[nodiscard]] uint64_t getTextureSize(const TextureDesc& desc);
+
+    class Heap : public RefCounter<IHeap>
+    {
+    public:
+        HeapDesc desc;
+
+        const HeapDesc& getDesc() override { return desc; }
+    };
+
+    class Texture : public RefCounter<ITexture>, public TextureStateExtension
+    {
+    public:
+        const TextureDesc desc;
+        HeapHandle heap;
+
+        explicit Texture(TextureDesc desc)
+            : TextureStateExtension(this->desc)
+            , desc(std::move(desc))
+        {
+            TextureStateExtension::stateInitialized = true;
+        }
+
+        const TextureDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override { (void)objectType; return nullptr; }
+        Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override
+        { (void)objectType; (void)format; (void)subresources; (void)dimension; (void)isReadOnlyDSV; return nullptr; }
+    };
+
+    class StagingTexture : public RefCounter<IStagingTexture>
+    {
+    public:
+        TextureDesc desc;
+        CpuAccessMode cpuAccess = CpuAccessMode::None;
+        std::vector<uint8_t> memory;
+        
+        const TextureDesc& getDesc() const override { return desc; }
+    };
+
+    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
+    {
+    public:
+        const BufferDesc desc;
+        HeapHandle heap;
+        // Only allocated for buffers with CPU access, which can be mapped. GPU-only buffers have no contents.
+        std::vector<uint8_t> memory;
+        // Never dereferenced, assigned from a range that is not reused so that stale addresses stay recognizable
+        GpuVirtualAddress gpuVA = 0;
+
+        explicit Buffer(BufferDesc desc)
+            : BufferStateExtension(this->desc)
+            , desc(std::move(desc))
+        { }
+
+        const BufferDesc& getDesc() const override { return desc; }
+        GpuVirtualAddress getGpuVirtualAddress() const override { return gpuVA; }
+    };
+
+    class Shader : public RefCounter<IShader>
+    {
+    public:
+        ShaderDesc desc;
+        // Either owned by the shader, or borrowed from binaryOwner for createShaderNoCopy and library shaders
+        std::vector<char> bytecode;
+        const void* borrowedBytecode = nullptr;
+        size_t borrowedBytecodeSize = 0;
+        RefCountPtr<IResource> binaryOwner;
+        std::vector<ShaderSpecialization> specializationConstants;
+
+        const ShaderDesc& getDesc() const override { return desc; }
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+    };
+
+    class ShaderLibrary : public RefCounter<IShaderLibrary>
+    {
+    public:
+        std::vector<char> bytecode;
+        const void* borrowedBytecode = nullptr;
+        size_t borrowedBytecodeSize = 0;
+        RefCountPtr<IResource> binaryOwner;
+
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+        ShaderHandle getShader(const char* entryName, ShaderType shaderType) override;
+    };
+
+    class Sampler : public RefCounter<ISampler>
+    {
+    public:
+        SamplerDesc desc;
+
+        const SamplerDesc& getDesc() const override { return desc; }
+    };
+
+    class InputLayout : public RefCounter<IInputLayout>
+    {
+    public:
+        std::vector<VertexAttributeDesc> attributes;
+
+        uint32_t getNumAttributes() const override { return uint32_t(attributes.size()); }
+        const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
+    };
+
+    class EventQuery : public RefCounter<IEventQuery>
+    {
+    public:
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t submittedInstance = 0; // 0 if the query has not been set
+    };
+
+    class TimerQuery : public RefCounter<ITimerQuery>
+    {
+    public:
+        bool started = false;
+        bool resolved = false;
+    };
+
+    class QueryPool : public RefCounter<IQueryPool>
+    {
+    public:
+        QueryPoolDesc desc;
+
+        const QueryPoolDesc& getDesc() const override { return desc; }
+    };
+
+    class Framebuffer : public RefCounter<IFramebuffer>
+    {
+    public:
+        FramebufferDesc desc;
+        FramebufferInfoEx framebufferInfo;
+        size_t framebufferInfoHash = 0;
+        std::vector<ResourceHandle> resources;
+
+        const FramebufferDesc& getDesc() const override { return desc; }
+        const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
+    };
+
+    class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
+
+        const GraphicsPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
+    };
+
+    class ComputePipeline : public RefCounter<IComputePipeline>
+    {
+    public:
+        ComputePipelineDesc desc;
+
+        const ComputePipelineDesc& getDesc() const override { return desc; }
+    };
+
+    class MeshletPipeline : public RefCounter<IMeshletPipeline>
+    {
+    public:
+        MeshletPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
+
+        const MeshletPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
+    };
+
+    class BindingLayout : public RefCounter<IBindingLayout>
+    {
+    public:
+        BindingLayoutDesc desc;
+        BindlessLayoutDesc bindlessDesc;
+        bool isBindless = false;
+        size_t descHash = 0;
+
+        const BindingLayoutDesc* getDesc() const override { return isBindless ? nullptr : &desc; }
+        const BindlessLayoutDesc* getBindlessDesc() const override { return isBindless ? &bindlessDesc : nullptr; }
+        size_t getDescHash() const override { return descHash; }
+    };
+
+    class BindingSet : public CacheableBindingSet
+    {
+    public:
+        BindingSetDesc desc;
+        BindingLayoutHandle layout;
+
+        // Indices of the bindings whose resources have no permanent state and are transitioned when the set is bound
+        std::vector<uint16_t> bindingsThatNeedTransitions;
+        std::vector<RefCountPtr<IResource>> resources;
+        bool hasVolatileConstantBuffers = false;
+        bool hasUavBindings = false;
+
+        const BindingSetDesc* getDesc() const override { return &desc; }
+        IBindingLayout* getLayout() const override { return layout; }
+    };
+
+    class DescriptorTable : public RefCounter<IDescriptorTable>
+    {
+    public:
+        BindingLayoutHandle layout;
+        std::vector<BindingSetItem> descriptors;
+        std::vector<RefCountPtr<IResource>> resources; // parallel to descriptors
+
+        const BindingSetDesc* getDesc() const override { return nullptr; }
+        IBindingLayout* getLayout() const override { return layout; }
+        uint32_t getCapacity() const override { return uint32_t(descriptors.size()); }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return 0; }
+    };
+
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        bool isDispatch = false;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+    };
+
+    // A page of CPU memory that stands in for an upload buffer, recycled through the device-global UploadPagePool
+    class UploadPage
+    {
+    public:
+        static const uint64_t c_sizeAlignment = 4096;
+
+        std::unique_ptr<uint8_t[]> memory;
+        uint64_t version = 0;
+        uint64_t bufferSize = 0;
+        uint64_t writePointer = 0;
+    };
+
+    typedef UploadPagePool<UploadPage> UploadPool;
+
+    // Suballocates the data for writeBuffer and writeTexture from upload pages, like the D3D12 and Vulkan upload managers
+    class UploadManager
+    {
+    public:
+        UploadManager(UploadPool& pool, uint64_t defaultPageSize)
+            : m_Pool(pool)
+            , m_DefaultPageSize(defaultPageSize)
+        { }
+
+        ~UploadManager();
+
+        void* suballocate(uint64_t size, uint64_t currentVersion, uint32_t alignment = 256);
+
+        // Hands the pages written by the current recording over to the pool
+        void submitPages(uint64_t submittedVersion);
+        // Gives the pages of a recording that was never executed back to the pool
+        void returnPages();
+
+        // Counters for CommandListStatistics, reset by the command list in open()
+        [[nodiscard]] uint64_t getSuballocatedBytes() const { return m_SuballocatedBytes; }
+        [[nodiscard]] uint32_t getAcquiredPages() const { return m_AcquiredPages; }
+        void resetStatistics() { m_SuballocatedBytes = 0; m_AcquiredPages = 0; }
+
+    private:
+        UploadPool& m_Pool;
+        uint64_t m_DefaultPageSize;
+        std::vector<std::shared_ptr<UploadPage>> m_Pages; // the last one is the current page
+        uint64_t m_SuballocatedBytes = 0;
+        uint32_t m_AcquiredPages = 0;
+    };
+
+    class CommandListInstance
+    {
+    public:
+        uint64_t submittedInstance = 0;
+        CommandQueue commandQueue = CommandQueue::Graphics;
+        ReferencedResources referencedResources;
+        std::vector<RefCountPtr<TimerQuery>> referencedTimerQueries;
+
+        void releaseReferences();
+        // Incremental version for runGarbageCollection(budget), returns false if some references are left
+        bool releaseReferences(GarbageCollectionBudgetTracker& budget);
+    };
+
+    // There is no GPU, so every submitted instance is complete as soon as it has been submitted.
+    // The instances are still kept in flight until runGarbageCollection, like on the other backends.
+    // Submissions to different queues are independent, each queue serializes its own submissions with submissionMutex.
+    struct Queue
+    {
+        CommandQueue queueType = CommandQueue::Graphics;
+        std::atomic<uint64_t> lastSubmittedInstance = 0;
+        std::atomic<uint64_t> recordingInstance = 1;
+
+        // protects the members below
+        std::mutex submissionMutex;
+        std::deque<std::shared_ptr<CommandListInstance>> commandListsInFlight;
+        CommandListStatistics statistics;
+
+        explicit Queue(CommandQueue queueType) : queueType(queueType) { }
+    };
+
+    class CommandList final : public RefCounter<ICommandList>
+    {
+    public:
+        // Bundle command lists record for a CommandBundle and are never submitted to a queue
+        CommandList(IDevice* device, const Context& context, Queue& queue, UploadPool& uploadPool, const CommandListParameters& params, bool isBundle = false);
+        ~CommandList() override;
+
+        std::shared_ptr<CommandListInstance> executed(uint64_t submittedInstance);
+        void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
+        void requireBufferState(IBuffer* buffer, ResourceStates state);
+
+        [[nodiscard]] const BundleStateRequirements& getBundleStates() const { return m_BundleStates; }
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override { (void)objectType; return nullptr; }
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) override { (void)dest; (void)feedbackTexture; utils::NotSupported(); }
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindings(const BindingSetVector& bindings) override;
+        void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes) override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) override;
+
+        void executeBundle(ICommandBundle* bundle) override;
+
+        void setRayTracingState(const rt::State& state) override { (void)state; utils::NotSupported(); }
+        void dispatchRays(const rt::DispatchRaysArguments& args) override { (void)args; utils::NotSupported(); }
+        void setWorkGraphState(const WorkGraphState& state) override { (void)state; utils::NotSupported(); }
+        void dispatchGraph(const DispatchGraphArguments& args) override { (void)args; utils::NotSupported(); }
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override { (void)omm; (void)desc; utils::NotSupported(); }
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override
+        { (void)as; (void)pGeometries; (void)numGeometries; (void)buildFlags; utils::NotSupported(); }
+        void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) override { (void)pBuilds; (void)numBuilds; utils::NotSupported(); }
+        void compactBottomLevelAccelStructs() override { }
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override
+        { (void)as; (void)pInstances; (void)numInstances; (void)buildFlags; utils::NotSupported(); }
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override
+        { (void)as; (void)instanceBuffer; (void)instanceBufferOffset; (void)numInstances; (void)buildFlags; utils::NotSupported(); }
+        void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override
+        { (void)as; (void)pInstances; (void)numInstances; (void)dirtyRanges; (void)numDirtyRanges; (void)buildFlags; utils::NotSupported(); }
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) override;
+        void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) override;
+
+        void beginMarker(const char* name) override { (void)name; }
+        void endMarker() override { }
+        void setGpuProfiler(IGpuProfiler* profiler) override { (void)profiler; }
+        void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) override { (void)buffer; (void)markerId; }
+
+        void setEnableAutomaticBarriers(bool enable) override { m_EnableAutomaticBarriers = enable; }
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override { (void)as; (void)stateBits; }
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void commitBarriers() override;
+        // Split barriers are placed as regular barriers at the beginning of the transition
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void endTextureStateTransition(ITexture* texture) override { (void)texture; }
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void endBufferStateTransition(IBuffer* buffer) override { (void)buffer; }
+        void textureAliasingBarrier(ITexture* texture) override;
+        void bufferAliasingBarrier(IBuffer* buffer) override;
+
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override { return m_Device; }
+        const CommandListParameters& getDesc() override { return m_Desc; }
+        const CommandListStatistics& getStatistics() const override { return m_Statistics; }
+
+    private:
+        IDevice* m_Device; // weak reference, the device owns the queues and the upload pool
+        const Context& m_Context;
+        Queue& m_Queue;
+        CommandListParameters m_Desc;
+        bool m_IsBundle;
+
+        CommandListResourceStateTracker m_StateTracker;
+        BundleStateRequirements m_BundleStates;
+        bool m_EnableAutomaticBarriers = true;
+
+        UploadManager m_UploadManager;
+        uint64_t m_RecordingVersion = 0;
+
+        std::vector<std::shared_ptr<CommandListInstance>> m_InstancePool;
+        std::shared_ptr<CommandListInstance> m_Instance;
+
+        CommandListStatistics m_Statistics;
+
+        // State cache, compared with the new state by the set*State functions to skip redundant work
+        GraphicsState m_CurrentGraphicsState;
+        ComputeState m_CurrentComputeState;
+        MeshletState m_CurrentMeshletState;
+        bool m_CurrentGraphicsStateValid = false;
+        bool m_CurrentComputeStateValid = false;
+        bool m_CurrentMeshletStateValid = false;
+
+        void clearStateCache();
+        void bindResourceSets(const BindingSetVector& bindings, uint32_t updateMask);
+        void requireIndirectBufferState(IBuffer* buffer);
+    };
+
+    class CommandBundle : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+        RefCountPtr<CommandList> commandList;
+
+        CommandBundle(const CommandBundleDesc& desc, RefCountPtr<CommandList> commandList)
+            : desc(desc)
+            , commandList(std::move(commandList))
+        { }
+
+        void open() override { commandList->open(); }
+        void close() override { commandList->close(); }
+
+        void setGraphicsState(const GraphicsState& state) override { commandList->setGraphicsState(state); }
+        void setPushConstants(const void* data, size_t byteSize) override { commandList->setPushConstants(data, byteSize); }
+
+        void draw(const DrawArguments& args) override { commandList->draw(args); }
+        void drawIndexed(const DrawArguments& args) override { commandList->drawIndexed(args); }
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndirect(offsetBytes, drawCount); }
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndexedIndirect(offsetBytes, drawCount); }
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override { (void)objectType; return nullptr; }
+    };
+
+    class Device final : public RefCounter<IDevice>
+    {
+    public:
+        explicit Device(const DeviceDesc& desc);
+        ~Device() override;
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+        TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) override;
+        StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) override;
+        ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) override;
+        BindingSetCacheHandle createBindingSetCache() override;
+        MipGeneratorHandle createMipGenerator() override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override { (void)tex; }
+        void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void unmapBuffer(IBuffer* b) override { (void)b; }
+        void *tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags) override { return mapBuffer(b, mapFlags); }
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner) override;
+        ShaderLibraryHandle createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override { (void)query; }
+        void resetEventQuery(IEventQuery* query) override;
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override;
+        void resetTimerQuery(ITimerQuery* query) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+        GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) override;
+        BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+
+        GraphicsAPI getGraphicsAPI() override { return m_Context.graphicsAPI; }
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+
+        WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) override;
+
+        PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override;
+        PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override;
+
+        bool loadPipelineCache(const void* data, size_t size) override { (void)data; (void)size; return false; }
+        bool savePipelineCache(std::vector<uint8_t>& outData) override { (void)outData; return false; }
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { (void)waitQueue; (void)executionQueue; (void)instance; }
+        void waitForIdle() override { }
+        uint64_t getCompletedInstance(CommandQueue queue) override;
+        bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) override;
+        void runGarbageCollection() override;
+        bool runGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setUploadPoolSettings(const UploadPoolSettings& settings) override { m_UploadPool.setSettings(settings); }
+        UploadPoolStatistics getUploadPoolStatistics() override { return m_UploadPool.getStatistics(); }
+        bool queryMemoryBudget(MemoryBudget& outBudget) override { (void)outBudget; return false; }
+        CommandListStatistics getCommandListStatistics(bool reset = true) override;
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue; return nullptr; }
+        IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+
+    private:
+        Context m_Context;
+        std::array<std::unique_ptr<Queue>, size_t(CommandQueue::Count)> m_Queues;
+        UploadPool m_UploadPool;
+        std::atomic<GpuVirtualAddress> m_NextGpuVirtualAddress = 0;
+        SubmissionCallbackThread m_SubmissionCallbacks;
+
+        GpuVirtualAddress allocateGpuVirtualAddress(uint64_t byteSize);
+        void getCompletedInstances(CompletedInstances& completed);
+    };
+
+} // namespace nvrhi::null
@@ -0,0 +1,561 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cstring>
+
+namespace nvrhi::null
+{
+    UploadManager::~UploadManager()
+    {
+        returnPages();
+    }
+
+    void* UploadManager::suballocate(uint64_t size, uint64_t currentVersion, uint32_t alignment)
+    {
+        if (!m_Pages.empty())
+        {
+            UploadPage& page = *m_Pages.back();
+            const uint64_t alignedOffset = align(page.writePointer, uint64_t(alignment));
+
+            if (alignedOffset + size <= page.bufferSize)
+            {
+                page.writePointer = alignedOffset + size;
+                m_SuballocatedBytes += size;
+                return page.memory.get() + alignedOffset;
+            }
+        }
+
+        std::shared_ptr<UploadPage> page = m_Pool.acquirePage(size, m_DefaultPageSize);
+        if (!page)
+            return nullptr;
+
+        page->version = currentVersion;
+        page->writePointer = size;
+        m_SuballocatedBytes += size;
+        m_AcquiredPages++;
+
+        m_Pages.push_back(page);
+        return page->memory.get();
+    }
+
+    void UploadManager::submitPages(uint64_t submittedVersion)
+    {
+        for (const auto& page : m_Pages)
+            page->version = submittedVersion;
+
+        m_Pool.submitPages(m_Pages);
+    }
+
+    void UploadManager::returnPages()
+    {
+        // These pages have never been submitted, so they can be reused right away
+        for (auto& page : m_Pages)
+            m_Pool.returnPage(std::move(page));
+
+        m_Pages.clear();
+    }
+
+    void CommandListInstance::releaseReferences()
+    {
+        referencedResources.clear();
+        referencedTimerQueries.clear();
+    }
+
+    bool CommandListInstance::releaseReferences(GarbageCollectionBudgetTracker& budget)
+    {
+        if (!budget.release(referencedResources) ||
+            !budget.release(referencedTimerQueries))
+            return false;
+
+        releaseReferences();
+        return true;
+    }
+
+    CommandList::CommandList(IDevice* device, const Context& context, Queue& queue, UploadPool& uploadPool, const CommandListParameters& params, bool isBundle)
+        : m_Device(device)
+        , m_Context(context)
+        , m_Queue(queue)
+        , m_Desc(params)
+        , m_IsBundle(isBundle)
+        , m_StateTracker(context.messageCallback)
+        , m_UploadManager(uploadPool, params.uploadChunkSize)
+    {
+    }
+
+    CommandList::~CommandList()
+    {
+        m_Instance.reset();
+        m_InstancePool.clear();
+    }
+
+    void CommandList::open()
+    {
+        uint32_t poolMisses = 0;
+
+        // Pages written by a recording that was never executed
+        m_UploadManager.returnPages();
+
+        if (m_IsBundle)
+            m_BundleStates.clear();
+
+        if (m_Instance)
+        {
+            // Opened again without executing, or a bundle
+            m_Instance->releaseReferences();
+        }
+        else if (!m_InstancePool.empty() && m_InstancePool.front().use_count() == 1)
+        {
+            // The queue has retired the instance, see d3d12::CommandList::open
+            std::atomic_thread_fence(std::memory_order_acquire);
+            m_Instance = std::move(m_InstancePool.front());
+            m_InstancePool.erase(m_InstancePool.begin());
+        }
+        else
+        {
+            m_Instance = std::make_shared<CommandListInstance>();
+            poolMisses++;
+        }
+
+        m_Instance->submittedInstance = 0;
+        m_Instance->commandQueue = m_Desc.queueType;
+
+        m_RecordingVersion = MakeVersion(m_Queue.recordingInstance++, m_Desc.queueType, false);
+
+        m_Statistics = CommandListStatistics();
+        m_UploadManager.resetStatistics();
+
+#ifndef NDEBUG
+        m_Statistics.recordingAllocations = poolMisses;
+#else
+        (void)poolMisses;
+#endif
+    }
+
+    void CommandList::close()
+    {
+        m_StateTracker.keepBufferInitialStates();
+        m_StateTracker.keepTextureInitialStates();
+        commitBarriers();
+
+        m_Statistics.uploadBytes = m_UploadManager.getSuballocatedBytes();
+        m_Statistics.uploadChunks = m_UploadManager.getAcquiredPages();
+        m_Statistics.referencedResources = uint32_t(m_Instance->referencedResources.size() + m_Instance->referencedTimerQueries.size());
+
+        clearStateCache();
+        m_StateTracker.commandListClosed();
+    }
+
+    std::shared_ptr<CommandListInstance> CommandList::executed(uint64_t submittedInstance)
+    {
+        std::shared_ptr<CommandListInstance> instance = m_Instance;
+        instance->submittedInstance = submittedInstance;
+        m_Instance.reset();
+
+        m_InstancePool.push_back(instance);
+
+        // Nothing is executed, so the queries are resolved as soon as they are submitted
+        for (const auto& query : instance->referencedTimerQueries)
+        {
+            query->started = true;
+            query->resolved = true;
+        }
+
+        m_StateTracker.commandListSubmitted();
+
+        m_UploadManager.submitPages(MakeVersion(instance->submittedInstance, m_Desc.queueType, true));
+        m_RecordingVersion = 0;
+
+        return instance;
+    }
+
+    void CommandList::clearStateCache()
+    {
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+    }
+
+    void CommandList::clearState()
+    {
+        clearStateCache();
+    }
+
+    void CommandList::clearTextureFloat(ITexture* _texture, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        (void)clearColor;
+
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, subresources, texture->desc.isRenderTarget ? ResourceStates::RenderTarget : ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::clearDepthStencilTexture(ITexture* _texture, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        (void)depth;
+        (void)stencil;
+
+        if (!clearDepth && !clearStencil)
+            return;
+
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, subresources, ResourceStates::DepthWrite);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::clearTextureUInt(ITexture* _texture, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        (void)clearColor;
+
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, subresources, texture->desc.isRenderTarget ? ResourceStates::RenderTarget : ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice, ITexture* _src, const TextureSlice& srcSlice)
+    {
+        Texture* dst = checked_cast<Texture*>(_dst);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        const TextureSlice resolvedDstSlice = dstSlice.resolve(dst->desc);
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->desc);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dst, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dst);
+        m_Instance->referencedResources.push_back(src);
+    }
+
+    void CommandList::copyTexture(IStagingTexture* _dst, const TextureSlice& dstSlice, ITexture* _src, const TextureSlice& srcSlice)
+    {
+        (void)dstSlice;
+
+        StagingTexture* dst = checked_cast<StagingTexture*>(_dst);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->desc);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dst);
+        m_Instance->referencedResources.push_back(src);
+    }
+
+    void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice, IStagingTexture* _src, const TextureSlice& srcSlice)
+    {
+        (void)srcSlice;
+
+        Texture* dst = checked_cast<Texture*>(_dst);
+        StagingTexture* src = checked_cast<StagingTexture*>(_src);
+
+        const TextureSlice resolvedDstSlice = dstSlice.resolve(dst->desc);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dst, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dst);
+        m_Instance->referencedResources.push_back(src);
+    }
+
+    // Copies one subresource into upload memory with the tightly packed layout, like the upload paths of the other backends
+    static bool uploadSubresource(UploadManager& uploadManager, uint64_t currentVersion, const TextureDesc& desc,
+        ArraySlice arraySlice, MipLevel mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        const SubresourceLayout layout = getSubresourceLayout(desc, arraySlice, mipLevel);
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+        const size_t numRows = layout.rowPitch ? layout.depthPitch / layout.rowPitch : 0;
+
+        uint8_t* uploadData = static_cast<uint8_t*>(uploadManager.suballocate(uint64_t(layout.depthPitch) * depth, currentVersion));
+        if (!uploadData)
+            return false;
+
+        const size_t bytesPerRow = std::min(layout.rowPitch, rowPitch);
+
+        for (uint32_t depthSlice = 0; depthSlice < depth; depthSlice++)
+        {
+            for (size_t row = 0; row < numRows; row++)
+            {
+                const uint8_t* srcRow = static_cast<const uint8_t*>(data) + depthPitch * depthSlice + rowPitch * row;
+                memcpy(uploadData + layout.depthPitch * depthSlice + layout.rowPitch * row, srcRow, bytesPerRow);
+            }
+        }
+
+        return true;
+    }
+
+    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        if (!uploadSubresource(m_UploadManager, m_RecordingVersion, dest->desc, arraySlice, mipLevel, data, rowPitch, depthPitch))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
+
+        m_Instance->referencedResources.push_back(dest);
+    }
+
+    void CommandList::writeTexture(ITexture* _dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        const TextureSubresourceSet resolvedSubresources = subresources.resolve(dest->desc, false);
+
+        if (numSubresources != size_t(resolvedSubresources.numArraySlices) * resolvedSubresources.numMipLevels)
+        {
+            m_Context.error("writeTexture: numSubresources doesn't match the subresource set");
+            return;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, resolvedSubresources, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        for (ArraySlice arrayIndex = 0; arrayIndex < resolvedSubresources.numArraySlices; arrayIndex++)
+        {
+            for (MipLevel mipIndex = 0; mipIndex < resolvedSubresources.numMipLevels; mipIndex++)
+            {
+                const TextureSubresourceData& subresourceData = data[arrayIndex * resolvedSubresources.numMipLevels + mipIndex];
+
+                if (!uploadSubresource(m_UploadManager, m_RecordingVersion, dest->desc,
+                    resolvedSubresources.baseArraySlice + arrayIndex, resolvedSubresources.baseMipLevel + mipIndex,
+                    subresourceData.data, subresourceData.rowPitch, subresourceData.depthPitch))
+                {
+                    m_Context.error("Couldn't suballocate an upload buffer");
+                    return;
+                }
+            }
+        }
+
+        m_Instance->referencedResources.push_back(dest);
+    }
+
+    void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        const TextureSubresourceSet dstSR = dstSubresources.resolve(dest->desc, false);
+        const TextureSubresourceSet srcSR = srcSubresources.resolve(src->desc, false);
+
+        if (dstSR.numArraySlices != srcSR.numArraySlices || dstSR.numMipLevels != srcSR.numMipLevels)
+            // let the validation layer handle the messages
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, dstSubresources, ResourceStates::ResolveDest);
+            requireTextureState(src, srcSubresources, ResourceStates::ResolveSource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dest);
+        m_Instance->referencedResources.push_back(src);
+    }
+
+    void CommandList::writeBuffer(IBuffer* _buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        (void)destOffsetBytes;
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        void* uploadData = m_UploadManager.suballocate(dataSize, m_RecordingVersion,
+            buffer->desc.isConstantBuffer ? c_ConstantBufferOffsetSizeAlignment : 4);
+
+        if (!uploadData)
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
+
+        memcpy(uploadData, data, dataSize);
+
+        if (!buffer->desc.isVolatile)
+        {
+            // Volatile buffers are read from the upload memory directly and need no copy
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(buffer, ResourceStates::CopyDest);
+            }
+            commitBarriers();
+        }
+
+        m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::clearBufferUInt(IBuffer* _buffer, uint32_t clearValue)
+    {
+        (void)clearValue;
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        (void)destOffsetBytes;
+        (void)srcOffsetBytes;
+        (void)dataSizeBytes;
+
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+        Buffer* src = checked_cast<Buffer*>(_src);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(dest, ResourceStates::CopyDest);
+            requireBufferState(src, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dest);
+        m_Instance->referencedResources.push_back(src);
+    }
+
+    void CommandList::setPushConstants(const void* data, size_t byteSize)
+    {
+        (void)data;
+        (void)byteSize;
+    }
+
+    void CommandList::beginTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        m_Instance->referencedTimerQueries.push_back(query);
+    }
+
+    void CommandList::endTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        m_Instance->referencedTimerQueries.push_back(query);
+    }
+
+    void CommandList::resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries)
+    {
+        (void)firstQuery;
+        (void)numQueries;
+
+        m_Instance->referencedResources.push_back(pool);
+    }
+
+    void CommandList::beginQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        (void)queryIndex;
+
+        m_Instance->referencedResources.push_back(pool);
+    }
+
+    void CommandList::endQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        (void)queryIndex;
+
+        m_Instance->referencedResources.push_back(pool);
+    }
+
+    void CommandList::resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* _buffer, uint64_t offsetBytes)
+    {
+        (void)firstQuery;
+        (void)numQueries;
+        (void)offsetBytes;
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(pool);
+        m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::setPredication(IBuffer* _buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        (void)offsetBytes;
+        (void)op;
+
+        if (!_buffer)
+            return;
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::Predication);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(buffer);
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,459 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+#include "../common/binding-set-cache.h"
+#include "../common/pipeline-creation-task.h"
+#include "../common/readback-ring.h"
+#include "../common/streaming-uploader.h"
+#include "../common/transient-resource-pool.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::null
+{
+    void Context::error(const std::string& message) const
+    {
+        messageCallback->message(MessageSeverity::Error, message.c_str());
+    }
+
+    DeviceHandle createDevice(const DeviceDesc& desc)
+    {
+        Device* device = new Device(desc);
+        return DeviceHandle::Create(device);
+    }
+
+    Device::Device(const DeviceDesc& desc)
+        : m_UploadPool(
+            [](uint64_t size)
+            {
+                auto page = std::make_shared<UploadPage>();
+                page->memory = std::make_unique<uint8_t[]>(size);
+                page->bufferSize = size;
+                return page;
+            },
+            // Everything submitted so far has completed
+            [this](CommandQueue queue) -> uint64_t { return m_Queues[uint32_t(queue)]->lastSubmittedInstance; })
+        , m_SubmissionCallbacks(
+            [this](CompletedInstances& completed) { getCompletedInstances(completed); },
+            // Never called, all submissions are complete by the time a callback is registered for them
+            [](const SubmissionPoint*, size_t, uint64_t) { })
+    {
+        m_Context.messageCallback = desc.messageCallback;
+        m_Context.graphicsAPI = desc.graphicsAPI;
+
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+            m_Queues[queueIndex] = std::make_unique<Queue>(CommandQueue(queueIndex));
+    }
+
+    Device::~Device()
+    {
+        waitForIdle();
+        m_SubmissionCallbacks.shutdown();
+        runGarbageCollection();
+    }
+
+    Object Device::getNativeObject(ObjectType objectType)
+    {
+        if (objectType == ObjectTypes::Nvrhi_Null_Device)
+            return this;
+
+        return nullptr;
+    }
+
+    HeapHandle Device::createHeap(const HeapDesc& d)
+    {
+        Heap* heap = new Heap();
+        heap->desc = d;
+        return HeapHandle::Create(heap);
+    }
+
+    TransientResourcePoolHandle Device::createTransientResourcePool(const TransientResourcePoolDesc& desc)
+    {
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(this, desc));
+    }
+
+    StreamingUploaderHandle Device::createStreamingUploader(const StreamingUploaderDesc& desc)
+    {
+        return StreamingUploaderHandle::Create(new StreamingUploader(this, desc));
+    }
+
+    ReadbackRingHandle Device::createReadbackRing(const ReadbackRingDesc& desc)
+    {
+        return ReadbackRing::create(this, desc);
+    }
+
+    BindingSetCacheHandle Device::createBindingSetCache()
+    {
+        return BindingSetCacheHandle::Create(new BindingSetCache(this));
+    }
+
+    MipGeneratorHandle Device::createMipGenerator()
+    {
+        // The mip generator needs a compiled shader for the reported API, which the null device cannot run anyway
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    EventQueryHandle Device::createEventQuery()
+    {
+        return EventQueryHandle::Create(new EventQuery());
+    }
+
+    void Device::setEventQuery(IEventQuery* _query, CommandQueue queue)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        query->queue = queue;
+        query->submittedInstance = m_Queues[uint32_t(queue)]->lastSubmittedInstance;
+    }
+
+    bool Device::pollEventQuery(IEventQuery* _query)
+    {
+        (void)_query;
+
+        // All submitted work completes immediately
+        return true;
+    }
+
+    void Device::resetEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        query->submittedInstance = 0;
+    }
+
+    TimerQueryHandle Device::createTimerQuery()
+    {
+        return TimerQueryHandle::Create(new TimerQuery());
+    }
+
+    bool Device::pollTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        return query->started && query->resolved;
+    }
+
+    float Device::getTimerQueryTime(ITimerQuery* _query)
+    {
+        (void)_query;
+
+        return 0.f;
+    }
+
+    void Device::resetTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        query->started = false;
+        query->resolved = false;
+    }
+
+    QueryPoolHandle Device::createQueryPool(const QueryPoolDesc& desc)
+    {
+        QueryPool* pool = new QueryPool();
+        pool->desc = desc;
+        return QueryPoolHandle::Create(pool);
+    }
+
+    GpuProfilerHandle Device::createGpuProfiler(const GpuProfilerDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    BreadcrumbBufferHandle Device::createBreadcrumbBuffer(const BreadcrumbBufferDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        CommandSignature* signature = new CommandSignature();
+        signature->desc = desc;
+
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+        {
+            if (argument.type == IndirectArgumentType::Dispatch)
+                signature->isDispatch = true;
+        }
+
+        return CommandSignatureHandle::Create(signature);
+    }
+
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (!desc.framebuffer)
+        {
+            m_Context.error("Cannot create a command bundle without a framebuffer");
+            return nullptr;
+        }
+
+        const CommandListParameters params = CommandListParameters()
+            .setQueueType(CommandQueue::Graphics);
+
+        RefCountPtr<CommandList> commandList = RefCountPtr<CommandList>::Create(
+            new CommandList(this, m_Context, *m_Queues[uint32_t(CommandQueue::Graphics)], m_UploadPool, params, true));
+
+        CommandBundle* bundle = new CommandBundle(desc, commandList);
+        return CommandBundleHandle::Create(bundle);
+    }
+
+    PipelineCreationTaskHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return PipelineCreationTask::createCompleted(createGraphicsPipeline(desc, fb));
+    }
+
+    PipelineCreationTaskHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc)
+    {
+        return PipelineCreationTask::createCompleted(createComputePipeline(desc));
+    }
+
+    PipelineCreationTaskHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return PipelineCreationTask::createCompleted(createMeshletPipeline(desc, fb));
+    }
+
+    PipelineCreationTaskHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc)
+    {
+        return PipelineCreationTask::createCompleted(createRayTracingPipeline(desc));
+    }
+
+    rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    WorkGraphHandle Device::createWorkGraph(const WorkGraphDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    rt::OpacityMicromapHandle Device::createOpacityMicromap(const rt::OpacityMicromapDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    rt::AccelStructHandle Device::createAccelStruct(const rt::AccelStructDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    MemoryRequirements Device::getAccelStructMemoryRequirements(rt::IAccelStruct*)
+    {
+        utils::NotSupported();
+        return MemoryRequirements();
+    }
+
+    bool Device::bindAccelStructMemory(rt::IAccelStruct*, IHeap*, uint64_t)
+    {
+        utils::NotSupported();
+        return false;
+    }
+
+    CommandListHandle Device::createCommandList(const CommandListParameters& params)
+    {
+        CommandList* commandList = new CommandList(this, m_Context, *m_Queues[uint32_t(params.queueType)], m_UploadPool, params);
+        return CommandListHandle::Create(commandList);
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        Queue* pQueue = m_Queues[uint32_t(executionQueue)].get();
+
+        std::lock_guard lockGuard(pQueue->submissionMutex);
+
+        const uint64_t submittedInstance = pQueue->lastSubmittedInstance.load(std::memory_order_relaxed) + 1;
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            pQueue->statistics += commandList->getStatistics();
+
+            auto instance = commandList->executed(submittedInstance);
+            pQueue->commandListsInFlight.push_front(instance);
+        }
+
+        pQueue->lastSubmittedInstance.store(submittedInstance, std::memory_order_release);
+
+        return submittedInstance;
+    }
+
+    void Device::getCompletedInstances(CompletedInstances& completed)
+    {
+        for (size_t queueIndex = 0; queueIndex < completed.size(); queueIndex++)
+            completed[queueIndex] = m_Queues[queueIndex]->lastSubmittedInstance;
+    }
+
+    uint64_t Device::getCompletedInstance(CommandQueue queue)
+    {
+        if (size_t(queue) >= m_Queues.size())
+            return 0;
+
+        return m_Queues[size_t(queue)]->lastSubmittedInstance;
+    }
+
+    bool Device::waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        (void)timeout;
+
+        CompletedInstances completed;
+        getCompletedInstances(completed);
+        return allSubmissionsCompleted(submissions, count, completed);
+    }
+
+    size_t Device::waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        (void)timeout;
+
+        CompletedInstances completed;
+        getCompletedInstances(completed);
+        return findCompletedSubmission(submissions, count, completed);
+    }
+
+    void Device::notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        m_SubmissionCallbacks.add(submissions, count, waitAny, std::move(callback));
+    }
+
+    void Device::runGarbageCollection()
+    {
+        runGarbageCollection(GarbageCollectionBudget());
+    }
+
+    bool Device::runGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        GarbageCollectionBudgetTracker budgetTracker(budget);
+        bool allRetired = true;
+
+        for (const auto& pQueue : m_Queues)
+        {
+            // They have all finished executing, see Queue. Take them so that the references are released
+            // without holding the submission lock, which would block submissions to the queue.
+            std::deque<std::shared_ptr<CommandListInstance>> completedInstances;
+            {
+                std::lock_guard lockGuard(pQueue->submissionMutex);
+                completedInstances.swap(pQueue->commandListsInFlight);
+            }
+
+            // Starting from the back of the queue, i.e. oldest submitted command lists
+            while (!completedInstances.empty())
+            {
+                // A partially released instance stays at the back of the queue, the next call continues with it
+                if (!completedInstances.back()->releaseReferences(budgetTracker))
+                {
+                    allRetired = false;
+                    break;
+                }
+
+                completedInstances.pop_back();
+            }
+
+            if (!allRetired)
+            {
+                // Everything submitted since then is newer, so the remaining instances are still the oldest ones
+                std::lock_guard lockGuard(pQueue->submissionMutex);
+                pQueue->commandListsInFlight.insert(pQueue->commandListsInFlight.end(),
+                    completedInstances.begin(), completedInstances.end());
+                break;
+            }
+        }
+
+        m_UploadPool.endFrame();
+
+        return allRetired;
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(bool reset)
+    {
+        // The statistics are collected per queue, so that submissions to different queues don't share any state
+        CommandListStatistics statistics;
+        for (const auto& pQueue : m_Queues)
+        {
+            std::lock_guard lockGuard(pQueue->submissionMutex);
+            statistics += pQueue->statistics;
+            if (reset)
+                pQueue->statistics = CommandListStatistics();
+        }
+        return statistics;
+    }
+
+    bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        (void)pInfo;
+        (void)infoSize;
+
+        switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case Feature::DeferredCommandLists:
+        case Feature::Meshlets:
+        case Feature::ShaderSpecializations:
+        case Feature::VirtualResources:
+        case Feature::ComputeQueue:
+        case Feature::CopyQueue:
+        case Feature::ConstantBufferRanges:
+        case Feature::DrawIndirectCount:
+        case Feature::DirectTextureWrite:
+        case Feature::OcclusionQueries:
+        case Feature::PipelineStatisticsQueries:
+        case Feature::Predication:
+        case Feature::GpuVirtualAddress:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    FormatSupport Device::queryFormatSupport(Format format)
+    {
+        if (format == Format::UNKNOWN)
+            return FormatSupport::None;
+
+        const FormatInfo& formatInfo = getFormatInfo(format);
+
+        if (formatInfo.hasDepth || formatInfo.hasStencil)
+            return FormatSupport::Texture | FormatSupport::DepthStencil | FormatSupport::ShaderLoad | FormatSupport::ShaderSample;
+
+        FormatSupport result = FormatSupport::Buffer | FormatSupport::Texture | FormatSupport::ShaderLoad | FormatSupport::ShaderSample;
+
+        if (formatInfo.blockSize == 1)
+        {
+            result = result | FormatSupport::VertexBuffer | FormatSupport::RenderTarget | FormatSupport::Blendable
+                | FormatSupport::ShaderUavLoad | FormatSupport::ShaderUavStore;
+        }
+
+        if (format == Format::R16_UINT || format == Format::R32_UINT)
+            result = result | FormatSupport::IndexBuffer;
+
+        if (format == Format::R32_UINT || format == Format::R32_SINT)
+            result = result | FormatSupport::ShaderAtomic;
+
+        return result;
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,452 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::null
+{
+    void CommandList::bindResourceSets(const BindingSetVector& bindings, uint32_t updateMask)
+    {
+        for (uint32_t bindingSetIndex = 0; bindingSetIndex < uint32_t(bindings.size()); bindingSetIndex++)
+        {
+            IBindingSet* _bindingSet = bindings[bindingSetIndex];
+
+            if (!_bindingSet)
+                continue;
+
+            const bool updateThisSet = (updateMask & (1 << bindingSetIndex)) != 0;
+
+            if (updateThisSet)
+                m_Statistics.bindingSetBinds++;
+
+            if (_bindingSet->getDesc())
+            {
+                BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+                if (updateThisSet && bindingSet->desc.trackLiveness)
+                    m_Instance->referencedResources.push_back(bindingSet);
+
+                if (m_EnableAutomaticBarriers && (updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
+                {
+                    setResourceStatesForBindingSet(bindingSet);
+                }
+            }
+        }
+    }
+
+    void CommandList::requireIndirectBufferState(IBuffer* buffer)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::IndirectArgument);
+        }
+        m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::setGraphicsState(const GraphicsState& state)
+    {
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
+
+        const bool updateFramebuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.framebuffer != state.framebuffer;
+        const bool updatePipeline = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.pipeline != state.pipeline;
+        const bool updateIndirectParams = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountParam = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indirectCountBuffer != state.indirectCountBuffer;
+        const bool updateIndexBuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indexBuffer != state.indexBuffer;
+        const bool updateVertexBuffers = !m_CurrentGraphicsStateValid || arraysAreDifferent(m_CurrentGraphicsState.vertexBuffers, state.vertexBuffers);
+
+        const uint32_t bindingUpdateMask = (!m_CurrentGraphicsStateValid || updatePipeline)
+            ? ~0u : arrayDifferenceMask(m_CurrentGraphicsState.bindings, state.bindings);
+
+        if (updatePipeline)
+        {
+            m_Statistics.pipelineBinds++;
+            m_Instance->referencedResources.push_back(pso);
+        }
+
+        // Bundles inherit the render targets of the command list that executes them, see executeBundle
+        if (!m_IsBundle && m_EnableAutomaticBarriers)
+        {
+            setResourceStatesForFramebuffer(framebuffer);
+
+            for (const auto& attachment : framebuffer->desc.colorAttachments)
+            {
+                if (attachment.storeOp == AttachmentStoreOp::Resolve && attachment.resolveTexture)
+                    requireTextureState(attachment.resolveTexture, attachment.resolveSubresources, ResourceStates::ResolveDest);
+            }
+
+            if (framebuffer->desc.shadingRateAttachment.valid() && state.shadingRateState.enabled)
+            {
+                requireTextureState(framebuffer->desc.shadingRateAttachment.texture, TextureSubresourceSet(0, 1, 0, 1), ResourceStates::ShadingRateSurface);
+            }
+        }
+
+        if (updateFramebuffer)
+        {
+            m_Instance->referencedResources.push_back(framebuffer);
+        }
+
+        bindResourceSets(state.bindings, bindingUpdateMask);
+
+        if (state.indirectParams && updateIndirectParams)
+        {
+            requireIndirectBufferState(state.indirectParams);
+        }
+
+        if (state.indirectCountBuffer && updateIndirectCountParam)
+        {
+            requireIndirectBufferState(state.indirectCountBuffer);
+        }
+
+        if (state.indexBuffer.buffer && updateIndexBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(state.indexBuffer.buffer, ResourceStates::IndexBuffer);
+            }
+            m_Instance->referencedResources.push_back(state.indexBuffer.buffer);
+        }
+
+        if (updateVertexBuffers)
+        {
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+            {
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+                }
+                m_Instance->referencedResources.push_back(binding.buffer);
+            }
+        }
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = true;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentGraphicsState = state;
+    }
+
+    void CommandList::setGraphicsBindings(const BindingSetVector& bindings)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsBindings can only be used after setGraphicsState");
+            return;
+        }
+
+        bindResourceSets(bindings, arrayDifferenceMask(m_CurrentGraphicsState.bindings, bindings));
+
+        commitBarriers();
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandList::setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsVertexBuffers can only be used after setGraphicsState");
+            return;
+        }
+
+        if (indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != indexBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(indexBuffer.buffer, ResourceStates::IndexBuffer);
+            }
+            m_Instance->referencedResources.push_back(indexBuffer.buffer);
+        }
+
+        if (arraysAreDifferent(m_CurrentGraphicsState.vertexBuffers, vertexBuffers))
+        {
+            for (const VertexBufferBinding& binding : vertexBuffers)
+            {
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+                }
+                m_Instance->referencedResources.push_back(binding.buffer);
+            }
+        }
+
+        commitBarriers();
+
+        m_CurrentGraphicsState.indexBuffer = indexBuffer;
+        m_CurrentGraphicsState.vertexBuffers = vertexBuffers;
+    }
+
+    void CommandList::draw(const DrawArguments& args)
+    {
+        (void)args;
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::drawIndexed(const DrawArguments& args)
+    {
+        (void)args;
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams); // validation layer handles this
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams);
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams); // validation layer handles this
+
+        requireIndirectBufferState(countBuffer);
+        commitBarriers();
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams);
+
+        requireIndirectBufferState(countBuffer);
+        commitBarriers();
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::setComputeState(const ComputeState& state)
+    {
+        ComputePipeline* pso = checked_cast<ComputePipeline*>(state.pipeline);
+
+        const bool updatePipeline = !m_CurrentComputeStateValid || m_CurrentComputeState.pipeline != state.pipeline;
+        const bool updateIndirectParams = !m_CurrentComputeStateValid || m_CurrentComputeState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountParam = !m_CurrentComputeStateValid || m_CurrentComputeState.indirectCountBuffer != state.indirectCountBuffer;
+
+        const uint32_t bindingUpdateMask = (!m_CurrentComputeStateValid || updatePipeline)
+            ? ~0u : arrayDifferenceMask(m_CurrentComputeState.bindings, state.bindings);
+
+        if (updatePipeline)
+        {
+            m_Statistics.pipelineBinds++;
+            m_Instance->referencedResources.push_back(pso);
+        }
+
+        bindResourceSets(state.bindings, bindingUpdateMask);
+
+        if (state.indirectParams && updateIndirectParams)
+        {
+            requireIndirectBufferState(state.indirectParams);
+        }
+
+        if (state.indirectCountBuffer && updateIndirectCountParam)
+        {
+            requireIndirectBufferState(state.indirectCountBuffer);
+        }
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = true;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentComputeState = state;
+    }
+
+    void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+
+        m_Statistics.dispatchCalls++;
+    }
+
+    void CommandList::dispatchIndirect(uint32_t offsetBytes)
+    {
+        (void)offsetBytes;
+
+        assert(m_CurrentComputeState.indirectParams); // validation layer handles this
+
+        m_Statistics.dispatchCalls++;
+    }
+
+    void CommandList::setMeshletState(const MeshletState& state)
+    {
+        MeshletPipeline* pso = checked_cast<MeshletPipeline*>(state.pipeline);
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
+
+        const bool updateFramebuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.framebuffer != state.framebuffer;
+        const bool updatePipeline = !m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline != state.pipeline;
+        const bool updateIndirectParams = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountParam = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectCountBuffer != state.indirectCountBuffer;
+
+        const uint32_t bindingUpdateMask = (!m_CurrentMeshletStateValid || updatePipeline)
+            ? ~0u : arrayDifferenceMask(m_CurrentMeshletState.bindings, state.bindings);
+
+        if (updatePipeline)
+        {
+            m_Statistics.pipelineBinds++;
+            m_Instance->referencedResources.push_back(pso);
+        }
+
+        if (!m_IsBundle && m_EnableAutomaticBarriers)
+        {
+            setResourceStatesForFramebuffer(framebuffer);
+        }
+
+        if (updateFramebuffer)
+        {
+            m_Instance->referencedResources.push_back(framebuffer);
+        }
+
+        bindResourceSets(state.bindings, bindingUpdateMask);
+
+        if (state.indirectParams && updateIndirectParams)
+        {
+            requireIndirectBufferState(state.indirectParams);
+        }
+
+        if (state.indirectCountBuffer && updateIndirectCountParam)
+        {
+            requireIndirectBufferState(state.indirectCountBuffer);
+        }
+
+        commitBarriers();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = true;
+        m_CurrentMeshletState = state;
+    }
+
+    void CommandList::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        assert(m_CurrentMeshletState.indirectParams); // validation layer handles this
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        assert(m_CurrentMeshletState.indirectParams);
+
+        requireIndirectBufferState(countBuffer);
+        commitBarriers();
+
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* _signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+        uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countOffsetBytes)
+    {
+        (void)argumentOffsetBytes;
+        (void)maxCommandCount;
+        (void)countOffsetBytes;
+
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+
+        requireIndirectBufferState(argumentBuffer);
+        if (countBuffer)
+            requireIndirectBufferState(countBuffer);
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(signature);
+
+        if (signature->isDispatch)
+            m_Statistics.dispatchCalls++;
+        else
+            m_Statistics.drawCalls++;
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+        const CommandList* bundleList = bundle->commandList;
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(bundle->desc.framebuffer.Get());
+
+        // Transition everything that the bundle uses here, like the backends that cannot place barriers in bundles
+        if (m_EnableAutomaticBarriers)
+        {
+            const BundleStateRequirements& states = bundleList->getBundleStates();
+
+            for (const auto& texture : states.getTextures())
+                requireTextureState(texture.texture, texture.subresources, texture.state);
+
+            for (const auto& buffer : states.getBuffers())
+                requireBufferState(buffer.buffer, buffer.state);
+
+            setResourceStatesForFramebuffer(framebuffer);
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(bundle);
+        m_Instance->referencedResources.push_back(framebuffer);
+
+        // The state set by the bundle remains set on the command list
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+    }
+
+} // namespace nvrhi::null
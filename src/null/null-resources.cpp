@@ -0,0 +1,531 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi::null
+{
+    static constexpr uint64_t c_ResourceAlignment = 65536;
+
+    static SubresourceLayout getMipLayout(const TextureDesc& desc, MipLevel mipLevel, uint64_t& outSize)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max(uint32_t(formatInfo.blockSize), 1u);
+
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        SubresourceLayout layout;
+        layout.rowPitch = size_t((width + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+        layout.depthPitch = layout.rowPitch * ((height + blockSize - 1) / blockSize);
+        outSize = uint64_t(layout.depthPitch) * depth;
+        return layout;
+    }
+
+    SubresourceLayout getSubresourceLayout(const TextureDesc& desc, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        uint64_t arraySliceSize = 0;
+        uint64_t mipOffset = 0;
+        SubresourceLayout result;
+
+        for (MipLevel mip = 0; mip < desc.mipLevels; mip++)
+        {
+            uint64_t mipSize = 0;
+            SubresourceLayout layout = getMipLayout(desc, mip, mipSize);
+
+            if (mip == mipLevel)
+            {
+                result = layout;
+                mipOffset = arraySliceSize;
+            }
+
+            arraySliceSize += mipSize;
+        }
+
+        result.offset = arraySliceSize * arraySlice + mipOffset;
+        return result;
+    }
+
+    uint64_t getTextureSize(const TextureDesc& desc)
+    {
+        return getSubresourceLayout(desc, desc.arraySize, 0).offset;
+    }
+
+    TextureHandle Device::createTexture(const TextureDesc& d)
+    {
+        Texture* texture = new Texture(d);
+
+        return TextureHandle::Create(texture);
+    }
+
+    MemoryRequirements Device::getTextureMemoryRequirements(ITexture* _texture)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        MemoryRequirements memReq;
+        memReq.alignment = c_ResourceAlignment;
+        memReq.size = align(getTextureSize(texture->desc), c_ResourceAlignment);
+        return memReq;
+    }
+
+    bool Device::bindTextureMemory(ITexture* _texture, IHeap* heap, uint64_t offset)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (texture->heap || !texture->desc.isVirtual)
+            return false;
+
+        if (offset + getTextureSize(texture->desc) > heap->getDesc().capacity)
+            return false;
+
+        texture->heap = heap;
+        return true;
+    }
+
+    bool Device::writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        // GPU-only textures have no contents
+        (void)dest; (void)arraySlice; (void)mipLevel; (void)data; (void)rowPitch; (void)depthPitch;
+        return true;
+    }
+
+    TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        (void)objectType;
+        (void)texture;
+
+        return createTexture(desc);
+    }
+
+    StagingTextureHandle Device::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTexture* staging = new StagingTexture();
+        staging->desc = d;
+        staging->cpuAccess = cpuAccess;
+        staging->memory.resize(getTextureSize(d));
+        return StagingTextureHandle::Create(staging);
+    }
+
+    void* Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        StagingTexture* tex = checked_cast<StagingTexture*>(_tex);
+
+        if (cpuAccess == CpuAccessMode::None || tex->cpuAccess != cpuAccess)
+            return nullptr;
+
+        const TextureSlice resolvedSlice = slice.resolve(tex->desc);
+        const SubresourceLayout layout = getSubresourceLayout(tex->desc, resolvedSlice.arraySlice, resolvedSlice.mipLevel);
+
+        const FormatInfo& formatInfo = getFormatInfo(tex->desc.format);
+        const uint32_t blockSize = std::max(uint32_t(formatInfo.blockSize), 1u);
+        const uint64_t offset = layout.offset + uint64_t(resolvedSlice.z) * layout.depthPitch
+            + uint64_t(resolvedSlice.y / blockSize) * layout.rowPitch + uint64_t(resolvedSlice.x / blockSize) * formatInfo.bytesPerBlock;
+
+        if (outRowPitch)
+            *outRowPitch = layout.rowPitch;
+
+        return tex->memory.data() + offset;
+    }
+
+    void* Device::tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        // Nothing is ever in use by the GPU
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch);
+    }
+
+    BufferHandle Device::createBuffer(const BufferDesc& d)
+    {
+        Buffer* buffer = new Buffer(d);
+
+        if (d.cpuAccess != CpuAccessMode::None)
+            buffer->memory.resize(d.byteSize);
+
+        if (!d.isVolatile && !d.isVirtual)
+            buffer->gpuVA = allocateGpuVirtualAddress(d.byteSize);
+
+        return BufferHandle::Create(buffer);
+    }
+
+    void* Device::mapBuffer(IBuffer* _buffer, CpuAccessMode cpuAccess)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (cpuAccess == CpuAccessMode::None || buffer->memory.empty())
+            return nullptr;
+
+        return buffer->memory.data();
+    }
+
+    MemoryRequirements Device::getBufferMemoryRequirements(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        MemoryRequirements memReq;
+        memReq.alignment = c_ResourceAlignment;
+        memReq.size = align(buffer->desc.byteSize, c_ResourceAlignment);
+        return memReq;
+    }
+
+    bool Device::bindBufferMemory(IBuffer* _buffer, IHeap* heap, uint64_t offset)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->heap || !buffer->desc.isVirtual)
+            return false;
+
+        if (offset + buffer->desc.byteSize > heap->getDesc().capacity)
+            return false;
+
+        buffer->heap = heap;
+        buffer->gpuVA = allocateGpuVirtualAddress(buffer->desc.byteSize);
+        return true;
+    }
+
+    GpuVirtualAddress Device::allocateGpuVirtualAddress(uint64_t byteSize)
+    {
+        // Start at a non-zero address, 0 means that the buffer has no address
+        return c_ResourceAlignment + m_NextGpuVirtualAddress.fetch_add(align(std::max(byteSize, uint64_t(1)), c_ResourceAlignment));
+    }
+
+    BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        (void)objectType;
+        (void)buffer;
+
+        return createBuffer(desc);
+    }
+
+    void Device::getTextureTiling(ITexture*, uint32_t*, PackedMipDesc*, TileShape*, uint32_t*, SubresourceTiling*)
+    {
+        utils::NotSupported();
+    }
+
+    void Device::updateTextureTileMappings(ITexture*, const TextureTilesMapping*, uint32_t, CommandQueue)
+    {
+        utils::NotSupported();
+    }
+
+    void Device::updateBufferTileMappings(IBuffer*, const BufferTilesMapping*, uint32_t, CommandQueue)
+    {
+        utils::NotSupported();
+    }
+
+    TextureHandle Device::createSamplerFeedbackTexture(ITexture*, const SamplerFeedbackTextureDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    void Shader::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = borrowedBytecode ? borrowedBytecode : bytecode.data();
+        if (pSize) *pSize = borrowedBytecode ? borrowedBytecodeSize : bytecode.size();
+    }
+
+    void ShaderLibrary::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = borrowedBytecode ? borrowedBytecode : bytecode.data();
+        if (pSize) *pSize = borrowedBytecode ? borrowedBytecodeSize : bytecode.size();
+    }
+
+    ShaderHandle ShaderLibrary::getShader(const char* entryName, ShaderType shaderType)
+    {
+        Shader* shader = new Shader();
+        shader->desc.shaderType = shaderType;
+        shader->desc.entryName = entryName;
+        // The library shaders point at the library's binary and keep the library alive
+        getBytecode(&shader->borrowedBytecode, &shader->borrowedBytecodeSize);
+        shader->binaryOwner = this;
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderHandle Device::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        Shader* shader = new Shader();
+        shader->desc = d;
+        shader->bytecode.resize(binarySize);
+        memcpy(shader->bytecode.data(), binary, binarySize);
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderHandle Device::createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner)
+    {
+        Shader* shader = new Shader();
+        shader->desc = d;
+        shader->borrowedBytecode = binary;
+        shader->borrowedBytecodeSize = binarySize;
+        shader->binaryOwner = binaryOwner;
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderHandle Device::createShaderSpecialization(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+
+        Shader* shader = new Shader();
+        shader->desc = baseShader->desc;
+        baseShader->getBytecode(&shader->borrowedBytecode, &shader->borrowedBytecodeSize);
+        shader->binaryOwner = baseShader;
+        shader->specializationConstants.assign(constants, constants + numConstants);
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderLibraryHandle Device::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        ShaderLibrary* library = new ShaderLibrary();
+        library->bytecode.resize(binarySize);
+        memcpy(library->bytecode.data(), binary, binarySize);
+        return ShaderLibraryHandle::Create(library);
+    }
+
+    ShaderLibraryHandle Device::createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner)
+    {
+        ShaderLibrary* library = new ShaderLibrary();
+        library->borrowedBytecode = binary;
+        library->borrowedBytecodeSize = binarySize;
+        library->binaryOwner = binaryOwner;
+        return ShaderLibraryHandle::Create(library);
+    }
+
+    SamplerHandle Device::createSampler(const SamplerDesc& d)
+    {
+        Sampler* sampler = new Sampler();
+        sampler->desc = d;
+        return SamplerHandle::Create(sampler);
+    }
+
+    const VertexAttributeDesc* InputLayout::getAttributeDesc(uint32_t index) const
+    {
+        if (index < uint32_t(attributes.size()))
+            return &attributes[index];
+
+        return nullptr;
+    }
+
+    InputLayoutHandle Device::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        (void)vertexShader;
+
+        InputLayout* layout = new InputLayout();
+        layout->attributes.assign(d, d + attributeCount);
+        return InputLayoutHandle::Create(layout);
+    }
+
+    FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
+    {
+        Framebuffer* fb = new Framebuffer();
+        fb->desc = desc;
+        fb->framebufferInfo = FramebufferInfoEx(desc);
+        fb->framebufferInfoHash = std::hash<FramebufferInfo>()(fb->framebufferInfo);
+
+        for (const auto& attachment : desc.colorAttachments)
+        {
+            fb->resources.push_back(attachment.texture);
+            if (attachment.resolveTexture)
+                fb->resources.push_back(attachment.resolveTexture);
+        }
+
+        if (desc.depthAttachment.valid())
+            fb->resources.push_back(desc.depthAttachment.texture);
+
+        if (desc.shadingRateAttachment.valid())
+            fb->resources.push_back(desc.shadingRateAttachment.texture);
+
+        return FramebufferHandle::Create(fb);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        GraphicsPipeline* pso = new GraphicsPipeline();
+        pso->desc = desc;
+        pso->framebufferInfo = fb->getFramebufferInfo();
+        pso->framebufferInfoHash = fb->getFramebufferInfoHash();
+        return GraphicsPipelineHandle::Create(pso);
+    }
+
+    ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        ComputePipeline* pso = new ComputePipeline();
+        pso->desc = desc;
+        return ComputePipelineHandle::Create(pso);
+    }
+
+    MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        MeshletPipeline* pso = new MeshletPipeline();
+        pso->desc = desc;
+        pso->framebufferInfo = fb->getFramebufferInfo();
+        pso->framebufferInfoHash = fb->getFramebufferInfoHash();
+        return MeshletPipelineHandle::Create(pso);
+    }
+
+    BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->desc = desc;
+        layout->descHash = std::hash<BindingLayoutDesc>()(desc);
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->bindlessDesc = desc;
+        layout->isBindless = true;
+        layout->descHash = std::hash<BindlessLayoutDesc>()(desc);
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSet* bindingSet = new BindingSet();
+        bindingSet->desc = desc;
+        bindingSet->layout = layout;
+        bindingSet->resources.reserve(desc.bindings.size());
+
+        for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+        {
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+            if (!binding.resourceHandle)
+                continue;
+
+            bindingSet->resources.push_back(binding.resourceHandle);
+
+            switch (binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case ResourceType::Texture_SRV:
+            case ResourceType::Texture_UAV: {
+                Texture* texture = checked_cast<Texture*>(binding.resourceHandle);
+                const ResourceStates requiredState = binding.type == ResourceType::Texture_SRV
+                    ? ResourceStates::ShaderResource : ResourceStates::UnorderedAccess;
+
+                if (binding.type == ResourceType::Texture_UAV)
+                    bindingSet->hasUavBindings = true;
+
+                if (!texture->permanentState)
+                    bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(texture->permanentState, requiredState,
+                        true, texture->desc.debugName, m_Context.messageCallback);
+                break;
+            }
+
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::RawBuffer_SRV:
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_UAV:
+            case ResourceType::ConstantBuffer: {
+                Buffer* buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                const ResourceStates requiredState = (binding.type == ResourceType::ConstantBuffer) ? ResourceStates::ConstantBuffer
+                    : (binding.type == ResourceType::TypedBuffer_UAV || binding.type == ResourceType::StructuredBuffer_UAV
+                        || binding.type == ResourceType::RawBuffer_UAV) ? ResourceStates::UnorderedAccess
+                    : ResourceStates::ShaderResource;
+
+                if (binding.type == ResourceType::ConstantBuffer && buffer->desc.isVolatile)
+                {
+                    std::stringstream ss;
+                    ss << "Attempted to bind a volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                        << " to a non-volatile CB layout at slot b" << binding.slot;
+                    m_Context.error(ss.str());
+                    break;
+                }
+
+                if (requiredState == ResourceStates::UnorderedAccess)
+                    bindingSet->hasUavBindings = true;
+
+                if (!buffer->permanentState)
+                    bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
+                break;
+            }
+
+            case ResourceType::VolatileConstantBuffer:
+                bindingSet->hasVolatileConstantBuffers = true;
+                break;
+
+            default:
+                // Samplers and acceleration structures need no transitions
+                break;
+            }
+        }
+
+        return BindingSetHandle::Create(bindingSet);
+    }
+
+    bool Device::createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets)
+    {
+        bool success = true;
+
+        for (size_t index = 0; index < count; index++)
+        {
+            outBindingSets[index] = createBindingSet(descs[index], layout);
+            success &= outBindingSets[index] != nullptr;
+        }
+
+        return success;
+    }
+
+    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    {
+        DescriptorTable* descriptorTable = new DescriptorTable();
+        descriptorTable->layout = layout;
+        return DescriptorTableHandle::Create(descriptorTable);
+    }
+
+    void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (!keepContents)
+        {
+            descriptorTable->descriptors.clear();
+            descriptorTable->resources.clear();
+        }
+
+        descriptorTable->descriptors.resize(newSize, BindingSetItem::None());
+        descriptorTable->resources.resize(newSize);
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& item)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (item.slot >= descriptorTable->getCapacity())
+            return false;
+
+        descriptorTable->descriptors[item.slot] = item;
+        descriptorTable->resources[item.slot] = item.resourceHandle;
+        return true;
+    }
+
+} // namespace nvrhi::null
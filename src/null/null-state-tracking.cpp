@@ -0,0 +1,226 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::null
+{
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    {
+        if (_bindingSet->getDesc() == nullptr)
+            return; // is bindless
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+        for (auto bindingIndex : bindingSet->bindingsThatNeedTransitions)
+        {
+            const BindingSetItem& binding = bindingSet->desc.bindings[bindingIndex];
+
+            switch (binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case ResourceType::Texture_SRV:
+                requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::ShaderResource);
+                break;
+
+            case ResourceType::Texture_UAV:
+                requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::UnorderedAccess);
+                break;
+
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::RawBuffer_SRV:
+                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ShaderResource);
+                break;
+
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_UAV:
+                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::UnorderedAccess);
+                break;
+
+            case ResourceType::ConstantBuffer:
+                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ConstantBuffer);
+                break;
+
+            default:
+                // do nothing
+                break;
+            }
+        }
+    }
+
+    void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        if (m_IsBundle)
+        {
+            m_BundleStates.requireTextureState(_texture, subresources, state);
+            return;
+        }
+
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        const size_t numBarriers = m_StateTracker.getTextureBarriers().size();
+        m_StateTracker.requireTextureState(texture, subresources, state);
+        if (m_StateTracker.getTextureBarriers().size() == numBarriers)
+            m_Statistics.barriersElided++;
+    }
+
+    void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
+    {
+        if (m_IsBundle)
+        {
+            m_BundleStates.requireBufferState(_buffer, state);
+            return;
+        }
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        const size_t numBarriers = m_StateTracker.getBufferBarriers().size();
+        m_StateTracker.requireBufferState(buffer, state);
+        if (m_StateTracker.getBufferBarriers().size() == numBarriers)
+            m_Statistics.barriersElided++;
+    }
+
+    void CommandList::commitBarriers()
+    {
+        if (m_StateTracker.getTextureBarriers().empty() && m_StateTracker.getBufferBarriers().empty())
+            return;
+
+        // There is no native command list to place the barriers on, only the bookkeeping remains
+        m_Statistics.barriersEmitted += uint32_t(m_StateTracker.getTextureBarriers().size() + m_StateTracker.getBufferBarriers().size());
+
+        m_StateTracker.clearBarriers();
+    }
+
+    void CommandList::setEnableUavBarriersForTexture(ITexture* _texture, bool enableBarriers)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandList::setEnableUavBarriersForBuffer(IBuffer* _buffer, bool enableBarriers)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandList::beginTrackingBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandList::setTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        requireTextureState(texture, subresources, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        requireBufferState(buffer, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::setPermanentTextureState(ITexture* _texture, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setPermanentBufferState(buffer, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        commitBarriers();
+        setTextureState(texture, subresources, stateBits);
+        commitBarriers();
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        commitBarriers();
+        setBufferState(buffer, stateBits);
+        commitBarriers();
+    }
+
+    void CommandList::textureAliasingBarrier(ITexture* texture)
+    {
+        commitBarriers();
+        m_Statistics.barriersEmitted++;
+        m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::bufferAliasingBarrier(IBuffer* buffer)
+    {
+        commitBarriers();
+        m_Statistics.barriersEmitted++;
+        m_Instance->referencedResources.push_back(buffer);
+    }
+
+    ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        return m_StateTracker.getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandList::getBufferState(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        return m_StateTracker.getBufferState(buffer);
+    }
+
+} // namespace nvrhi::null
@@ -24,6 +24,12 @@
 
 #include <nvrhi/validation.h>
 #include "../common/sparse-bitset.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_set>
 
 namespace nvrhi::validation
 {
@@ -116,27 +122,43 @@ namespace nvrhi::validation
         bool m_ComputeStateSet = false;
         bool m_MeshletStateSet = false;
         bool m_RayTracingStateSet = false;
+        bool m_WorkGraphStateSet = false;
         GraphicsState m_CurrentGraphicsState;
         ComputeState m_CurrentComputeState;
         MeshletState m_CurrentMeshletState;
         rt::State m_CurrentRayTracingState;
+        WorkGraphState m_CurrentWorkGraphState;
 
         size_t m_PipelinePushConstantSize = 0;
         bool m_PushConstantsSet = false;
 
+        // Calls since the last sampled full check, see ValidationLevel::Lite
+        uint32_t m_CallsSinceFullCheck = 0;
+
+        std::unordered_set<IResource*> m_OpenStateTransitions;
+
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
         bool requireOpenState() const;
         bool requireExecuteState();
         bool requireType(CommandQueue queueType, const char* operation) const;
+        bool validateQueryRange(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, const char* operation) const;
+        bool runFullChecks();
         ICommandList* getUnderlyingCommandList() const { return m_CommandList; }
 
         void evaluatePushConstantSize(const nvrhi::BindingLayoutVector& bindingLayouts);
         bool validatePushConstants(const char* pipelineType, const char* stateFunctionName) const;
+        bool validateIndirectCountBuffer(const char* operation, IBuffer* countBuffer, uint32_t countOffsetBytes) const;
+        bool validateGraphicsState(const GraphicsState& state) const;
+        bool validateComputeState(const ComputeState& state) const;
+        bool validateMeshletState(const MeshletState& state) const;
+        bool validateWorkGraphState(const WorkGraphState& state) const;
         bool validateBindingSetsAgainstLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& layouts, const static_vector<IBindingSet*, c_MaxBindingLayouts>& sets) const;
 
+        bool validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const;
         bool validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const;
+        bool validateTopLevelInstances(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t firstInstance, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const;
 
     public:
 
@@ -158,7 +180,9 @@ namespace nvrhi::validation
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -167,10 +191,14 @@ namespace nvrhi::validation
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindings(const BindingSetVector& bindings) override;
+        void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -178,22 +206,43 @@ namespace nvrhi::validation
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) override;
+
+        void executeBundle(ICommandBundle* bundle) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const DispatchGraphArguments& args) override;
+
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
 
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) override;
+        void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) override;
+
         void beginMarker(const char* name) override;
         void endMarker() override;
+        void setGpuProfiler(IGpuProfiler* profiler) override;
+        void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) override;
 
         void setEnableAutomaticBarriers(bool enable) override;
         void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
@@ -212,12 +261,63 @@ namespace nvrhi::validation
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
 
         void commitBarriers() override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void endTextureStateTransition(ITexture* texture) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void endBufferStateTransition(IBuffer* buffer) override;
+        void textureAliasingBarrier(ITexture* texture) override;
+        void bufferAliasingBarrier(IBuffer* buffer) override;
         
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
         ResourceStates getBufferState(IBuffer* buffer) override;
 
         IDevice* getDevice() override;
         const CommandListParameters& getDesc() override;
+        const CommandListStatistics& getStatistics() const override;
+    };
+
+    class CommandBundleWrapper : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleWrapper(IMessageCallback* messageCallback, ICommandBundle* bundle)
+            : m_Bundle(bundle)
+            , m_MessageCallback(messageCallback)
+        { }
+
+        ICommandBundle* getUnderlyingBundle() const { return m_Bundle; }
+        bool requireExecuteState() const;
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override { return m_Bundle->getNativeObject(objectType); }
+
+        // ICommandBundle implementation
+
+        void open() override;
+        void close() override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setPushConstants(const void* data, size_t byteSize) override;
+
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+
+        const CommandBundleDesc& getDesc() const override { return m_Bundle->getDesc(); }
+
+    private:
+        CommandBundleHandle m_Bundle;
+        IMessageCallback* m_MessageCallback;
+
+        CommandListState m_State = CommandListState::INITIAL;
+        bool m_GraphicsStateSet = false;
+        bool m_ViewportStateSet = false;
+        GraphicsState m_CurrentGraphicsState;
+
+        void error(const std::string& messageText) const;
+        bool requireOpenState() const;
+        bool requireGraphicsState(const char* operation) const;
     };
 
     class DeviceWrapper : public RefCounter<IDevice>
@@ -225,20 +325,46 @@ namespace nvrhi::validation
     public:
         friend class CommandListWrapper;
 
-        DeviceWrapper(IDevice* device);
+        DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc);
         
     protected:
         DeviceHandle m_Device;
         IMessageCallback* m_MessageCallback;
+        ValidationLayerDesc m_Desc;
         std::atomic<unsigned int> m_NumOpenImmediateCommandLists = 0;
 
+        struct DestroyedAddressRange
+        {
+            GpuVirtualAddress end = 0;
+            std::string debugName;
+        };
+
+        // See ValidationLayerDesc::trackGpuVirtualAddresses
+        std::mutex m_GpuAddressMutex;
+        std::vector<BufferHandle> m_GpuAddressableBuffers;
+        std::map<GpuVirtualAddress, DestroyedAddressRange> m_DestroyedAddressRanges;
+        std::deque<GpuVirtualAddress> m_DestroyedAddressOrder;
+        std::atomic<bool> m_AnyDestroyedAddressRanges = false;
+
+        // The last instance returned by executeCommandLists for each queue, used to validate the submission waits
+        std::array<std::atomic<uint64_t>, size_t(CommandQueue::Count)> m_LastSubmittedInstances{};
+
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
+        void trackGpuAddressableBuffer(IBuffer* buffer);
+        void retireReleasedGpuAddressableBuffers();
+        bool checkGpuVirtualAddresses(const char* operation, const void* data, size_t dataSize);
+        bool validateSubmissionPoints(const char* function, const SubmissionPoint* submissions, size_t count) const;
+
         bool validateBindingSetItem(const BindingSetItem& binding, bool isDescriptorTable, std::stringstream& errorStream);
+        bool validateBindingSetDesc(const BindingSetDesc& desc, IBindingLayout* layout);
         bool validatePipelineBindingLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& bindingLayouts, const std::vector<IShader*>& shaders) const;
         bool validateShaderType(ShaderType expected, const ShaderDesc& shaderDesc, const char* function) const;
         bool validateRenderState(const RenderState& renderState, IFramebuffer* fb) const;
+        bool validateGraphicsPipelineDesc(const GraphicsPipelineDesc& pipelineDesc, IFramebuffer* fb, const char* function) const;
+        bool validateComputePipelineDesc(const ComputePipelineDesc& pipelineDesc, const char* function) const;
+        bool validateMeshletPipelineDesc(const MeshletPipelineDesc& pipelineDesc, IFramebuffer* fb, const char* function) const;
 
     public:
 
@@ -249,28 +375,43 @@ namespace nvrhi::validation
         // IDevice implementation
 
         HeapHandle createHeap(const HeapDesc& d) override;
+        TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) override;
+        StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) override;
+        ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) override;
+        BindingSetCacheHandle createBindingSetCache() override;
+        MipGeneratorHandle createMipGenerator() override;
 
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
         StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
         void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
         void unmapStagingTexture(IStagingTexture* tex) override;
+        void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         void unmapBuffer(IBuffer* b) override;
+        void *tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+
         BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
 
         ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
         ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
         ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource* binaryOwner) override;
+        ShaderLibraryHandle createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource* binaryOwner) override;
 
         SamplerHandle createSampler(const SamplerDesc& d) override;
 
@@ -288,6 +429,12 @@ namespace nvrhi::validation
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+        GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) override;
+        BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -301,10 +448,21 @@ namespace nvrhi::validation
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
 
+        WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) override;
+
+        PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override;
+        PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override;
+
+        bool loadPipelineCache(const void* data, size_t size) override;
+        bool savePipelineCache(std::vector<uint8_t>& outData) override;
+
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
 
         BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) override;
         DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
@@ -319,7 +477,16 @@ namespace nvrhi::validation
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
         void waitForIdle() override;
+        uint64_t getCompletedInstance(CommandQueue queue) override;
+        bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) override;
         void runGarbageCollection() override;
+        bool runGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setUploadPoolSettings(const UploadPoolSettings& settings) override;
+        UploadPoolStatistics getUploadPoolStatistics() override;
+        bool queryMemoryBudget(MemoryBudget& outBudget) override;
+        CommandListStatistics getCommandListStatistics(bool reset = true) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
@@ -128,6 +128,20 @@ namespace nvrhi::validation
         return true;
     }
 
+    bool CommandListWrapper::runFullChecks()
+    {
+        const ValidationLayerDesc& desc = m_Device->m_Desc;
+
+        if (desc.level == ValidationLevel::Full)
+            return true;
+
+        if (desc.fullCheckInterval == 0 || ++m_CallsSinceFullCheck < desc.fullCheckInterval)
+            return false;
+
+        m_CallsSinceFullCheck = 0;
+        return true;
+    }
+
     Object CommandListWrapper::getNativeObject(ObjectType objectType)
     {
         return m_CommandList->getNativeObject(objectType);
@@ -172,6 +186,7 @@ namespace nvrhi::validation
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
     }
 
     void CommandListWrapper::close()
@@ -194,12 +209,22 @@ namespace nvrhi::validation
             --m_Device->m_NumOpenImmediateCommandLists;
         }
 
+        if (!m_OpenStateTransitions.empty())
+        {
+            std::stringstream ss;
+            ss << "Closing a command list with " << m_OpenStateTransitions.size() << " state transition(s) that were "
+                "started with begin[Texture|Buffer]StateTransition but never ended, they will be completed by close()";
+            warning(ss.str());
+            m_OpenStateTransitions.clear();
+        }
+
         m_CommandList->close();
 
         m_State = CommandListState::CLOSED;
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_WorkGraphStateSet = false;
     }
 
     void CommandListWrapper::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
@@ -351,6 +376,70 @@ namespace nvrhi::validation
         m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
     }
 
+    void CommandListWrapper::writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!dest)
+        {
+            error("writeTexture: dest is NULL");
+            return;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+        const TextureSubresourceSet subresourceSet = subresources.resolve(desc, false);
+
+        if (subresourceSet.numMipLevels == 0 || subresourceSet.numArraySlices == 0)
+        {
+            error("writeTexture: the subresource set does not contain any subresources of the texture");
+            return;
+        }
+
+        const size_t expectedSubresources = size_t(subresourceSet.numArraySlices) * subresourceSet.numMipLevels;
+        if (numSubresources != expectedSubresources)
+        {
+            std::stringstream ss;
+            ss << "writeTexture: numSubresources (" << numSubresources << ") must be equal to the number of subresources "
+                "in the resolved subresource set (" << expectedSubresources << ")";
+            error(ss.str());
+            return;
+        }
+
+        if (!data)
+        {
+            error("writeTexture: data is NULL");
+            return;
+        }
+
+        bool anyErrors = false;
+
+        for (size_t index = 0; index < numSubresources; index++)
+        {
+            const MipLevel mipLevel = subresourceSet.baseMipLevel + MipLevel(index % subresourceSet.numMipLevels);
+
+            if (!data[index].data)
+            {
+                std::stringstream ss;
+                ss << "writeTexture: data[" << index << "].data is NULL";
+                error(ss.str());
+                anyErrors = true;
+            }
+            else if (std::max(desc.height >> mipLevel, 1u) > 1 && data[index].rowPitch == 0)
+            {
+                std::stringstream ss;
+                ss << "writeTexture: data[" << index << "].rowPitch is 0 but mip level " << mipLevel << " of dest has multiple rows";
+                error(ss.str());
+                anyErrors = true;
+            }
+        }
+
+        if (anyErrors)
+            return;
+
+        m_CommandList->writeTexture(dest, subresources, data, numSubresources);
+    }
+
     void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
     {
         if (!requireOpenState())
@@ -422,6 +511,56 @@ namespace nvrhi::validation
         m_CommandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
     }
 
+    void CommandListWrapper::decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!m_Device->queryFeatureSupport(Feature::SamplerFeedback))
+        {
+            error("decodeSamplerFeedbackTexture: the device does not support Feature::SamplerFeedback");
+            return;
+        }
+
+        bool anyErrors = false;
+
+        if (!dest)
+        {
+            error("decodeSamplerFeedbackTexture: dest is NULL");
+            anyErrors = true;
+        }
+
+        if (!feedbackTexture)
+        {
+            error("decodeSamplerFeedbackTexture: feedbackTexture is NULL");
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+            return;
+
+        if (dest->getDesc().format != Format::R8_UINT)
+        {
+            error("decodeSamplerFeedbackTexture: the destination texture must have the R8_UINT format");
+            anyErrors = true;
+        }
+
+        // Sampler feedback textures are the only ones without a format
+        if (feedbackTexture->getDesc().format != Format::UNKNOWN)
+        {
+            std::stringstream ss;
+            ss << "decodeSamplerFeedbackTexture: texture " << utils::DebugNameToString(feedbackTexture->getDesc().debugName)
+                << " was not created with createSamplerFeedbackTexture";
+            error(ss.str());
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+            return;
+
+        m_CommandList->decodeSamplerFeedbackTexture(dest, feedbackTexture);
+    }
+
     void CommandListWrapper::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
     {
         if (!requireOpenState())
@@ -445,6 +584,9 @@ namespace nvrhi::validation
             return;
         }
 
+        if (m_Device->m_AnyDestroyedAddressRanges && runFullChecks())
+            m_Device->checkGpuVirtualAddresses("writeBuffer", data, dataSize);
+
         m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
     }
 
@@ -521,9 +663,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
-        if (!m_GraphicsStateSet && !m_ComputeStateSet && !m_MeshletStateSet && !m_RayTracingStateSet)
+        if (!m_GraphicsStateSet && !m_ComputeStateSet && !m_MeshletStateSet && !m_RayTracingStateSet && !m_WorkGraphStateSet)
         {
-            error("setPushConstants is only valid when a graphics, compute, meshlet, or ray tracing state is set");
+            error("setPushConstants is only valid when a graphics, compute, meshlet, ray tracing, or work graph state is set");
             return;
         }
 
@@ -548,44 +690,27 @@ namespace nvrhi::validation
             return;
         }
 
+        if (m_Device->m_AnyDestroyedAddressRanges && runFullChecks())
+            m_Device->checkGpuVirtualAddresses("setPushConstants", data, byteSize);
+
         m_PushConstantsSet = true;
 
         m_CommandList->setPushConstants(data, byteSize);
     }
 
-    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    static bool validateGeometryBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer, std::stringstream& ss)
     {
-        if (!requireOpenState())
-            return;
-
-        if (!requireType(CommandQueue::Graphics, "setGraphicsState"))
-            return;
-
         bool anyErrors = false;
-        std::stringstream ss;
-        ss << "setGraphicsState: " << std::endl;
-
-        if (!state.pipeline)
-        {
-            ss << "pipeline is NULL." << std::endl;
-            anyErrors = true;
-        }
 
-        if (!state.framebuffer)
-        {
-            ss << "framebuffer is NULL." << std::endl;
-            anyErrors = true;
-        }
-
-        if (state.indexBuffer.buffer && !state.indexBuffer.buffer->getDesc().isIndexBuffer)
+        if (indexBuffer.buffer && !indexBuffer.buffer->getDesc().isIndexBuffer)
         {
-            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indexBuffer.buffer->getDesc().debugName) << "' as an index buffer because it does not have the isIndexBuffer flag set." << std::endl;
+            ss << "Cannot use buffer '" << utils::DebugNameToString(indexBuffer.buffer->getDesc().debugName) << "' as an index buffer because it does not have the isIndexBuffer flag set." << std::endl;
             anyErrors = true;
         }
 
-        for (size_t index = 0; index < state.vertexBuffers.size(); index++)
+        for (size_t index = 0; index < vertexBuffers.size(); index++)
         {
-            const VertexBufferBinding& vb = state.vertexBuffers[index];
+            const VertexBufferBinding& vb = vertexBuffers[index];
 
             if (!vb.buffer)
             {
@@ -605,6 +730,30 @@ namespace nvrhi::validation
             }
         }
 
+        return !anyErrors;
+    }
+
+    bool CommandListWrapper::validateGraphicsState(const GraphicsState& state) const
+    {
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setGraphicsState: " << std::endl;
+
+        if (!state.pipeline)
+        {
+            ss << "pipeline is NULL." << std::endl;
+            anyErrors = true;
+        }
+
+        if (!state.framebuffer)
+        {
+            ss << "framebuffer is NULL." << std::endl;
+            anyErrors = true;
+        }
+
+        if (!validateGeometryBuffers(state.vertexBuffers, state.indexBuffer, ss))
+            anyErrors = true;
+
         if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
         {
             ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectParams->getDesc().debugName) << "' as a DrawIndirect argument buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
@@ -618,16 +767,23 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (state.indirectCountBuffer && !m_Device->queryFeatureSupport(Feature::DrawIndirectCount))
+        {
+            ss << "GraphicsState::indirectCountBuffer is set, but the device does not support Feature::DrawIndirectCount." << std::endl;
+            anyErrors = true;
+        }
+
         if (anyErrors)
         {
             error(ss.str());
-            return;
+            return false;
         }
 
         if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
             anyErrors = true;
 
-        if (state.framebuffer->getFramebufferInfo() != state.pipeline->getFramebufferInfo())
+        if (state.framebuffer->getFramebufferInfoHash() != state.pipeline->getFramebufferInfoHash()
+            || state.framebuffer->getFramebufferInfo() != state.pipeline->getFramebufferInfo())
         {
             ss << "The framebuffer used in the draw call does not match the framebuffer used to create the pipeline." << std::endl <<
                 "Formats and sample counts of the framebuffers must match." << std::endl;
@@ -637,8 +793,31 @@ namespace nvrhi::validation
         if (anyErrors)
         {
             error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setGraphicsState"))
             return;
+
+        // The lite level only checks for NULLs, except for the sampled calls
+        if (!runFullChecks())
+        {
+            if (!state.pipeline || !state.framebuffer)
+            {
+                error("setGraphicsState: pipeline or framebuffer is NULL");
+                return;
+            }
         }
+        else if (!validateGraphicsState(state))
+            return;
 
         evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
 
@@ -648,10 +827,67 @@ namespace nvrhi::validation
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
         m_RayTracingStateSet = false;
+        m_WorkGraphStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentGraphicsState = state;
     }
 
+    void CommandListWrapper::setGraphicsBindings(const BindingSetVector& bindings)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setGraphicsBindings"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setGraphicsBindings can only be used after setGraphicsState.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (runFullChecks() && !validateBindingSetsAgainstLayouts(m_CurrentGraphicsState.pipeline->getDesc().bindingLayouts, bindings))
+            return;
+
+        m_CommandList->setGraphicsBindings(bindings);
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandListWrapper::setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setGraphicsVertexBuffers"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setGraphicsVertexBuffers can only be used after setGraphicsState.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (runFullChecks())
+        {
+            std::stringstream ss;
+            ss << "setGraphicsVertexBuffers: " << std::endl;
+
+            if (!validateGeometryBuffers(vertexBuffers, indexBuffer, ss))
+            {
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_CommandList->setGraphicsVertexBuffers(vertexBuffers, indexBuffer);
+
+        m_CurrentGraphicsState.vertexBuffers = vertexBuffers;
+        m_CurrentGraphicsState.indexBuffer = indexBuffer;
+    }
+
     void CommandListWrapper::draw(const DrawArguments& args)
     {
         if (!requireOpenState())
@@ -754,46 +990,182 @@ namespace nvrhi::validation
         m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
     }
 
-    void CommandListWrapper::setComputeState(const ComputeState& state)
+    bool CommandListWrapper::validateIndirectCountBuffer(const char* operation, IBuffer* countBuffer, uint32_t countOffsetBytes) const
     {
-        if (!requireOpenState())
-            return;
-
-        if (!requireType(CommandQueue::Compute, "setComputeState"))
-            return;
-
-        bool anyErrors = false;
-        std::stringstream ss;
-        ss << "setComputeState: " << std::endl;
+        if (!m_Device->queryFeatureSupport(Feature::DrawIndirectCount))
+        {
+            std::stringstream ss;
+            ss << operation << " is not supported by the current graphics API (" << utils::GraphicsAPIToString(m_Device->getGraphicsAPI()) << ").";
+            error(ss.str());
+            return false;
+        }
 
-        if (!state.pipeline)
+        if (!countBuffer)
         {
-            ss << "pipeline is NULL." << std::endl;
-            anyErrors = true;
+            std::stringstream ss;
+            ss << "Count buffer is NULL in a " << operation << " call.";
+            error(ss.str());
+            return false;
         }
 
-        if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
+        const BufferDesc& countBufferDesc = countBuffer->getDesc();
+
+        if (!countBufferDesc.isDrawIndirectArgs)
         {
-            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectParams->getDesc().debugName) << "' as a DispatchIndirect argument buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
-            anyErrors = true;
+            std::stringstream ss;
+            ss << "Cannot use buffer '" << utils::DebugNameToString(countBufferDesc.debugName) << "' as a count buffer in a " << operation << " call "
+                "because it does not have the isDrawIndirectArgs flag set.";
+            error(ss.str());
+            return false;
         }
 
-        if (anyErrors)
+        if ((countOffsetBytes & 3) != 0 || uint64_t(countOffsetBytes) + sizeof(uint32_t) > countBufferDesc.byteSize)
         {
+            std::stringstream ss;
+            ss << "Count offset " << countOffsetBytes << " in a " << operation << " call is either not 4-byte aligned or out of bounds of buffer '"
+                << utils::DebugNameToString(countBufferDesc.debugName) << "' (" << countBufferDesc.byteSize << " bytes).";
             error(ss.str());
-            return;
+            return false;
         }
 
-        if (anyErrors)
+        return true;
+    }
+
+    void CommandListWrapper::drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState())
             return;
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
-            anyErrors = true;
+        if (!requireType(CommandQueue::Graphics, "drawIndirectCount"))
+            return;
 
-        if (anyErrors)
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
             return;
+        }
 
-        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndirectCount call.");
+            return;
+        }
+
+        if (!validateIndirectCountBuffer("drawIndirectCount", countBuffer, countOffsetBytes))
+            return;
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirectCount"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndexedIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndexedIndirectCount call.");
+            return;
+        }
+
+        if (m_CurrentGraphicsState.indexBuffer.buffer == nullptr)
+        {
+            error("Index buffer is not set before a drawIndexedIndirectCount call");
+            return;
+        }
+
+        if (!validateIndirectCountBuffer("drawIndexedIndirectCount", countBuffer, countOffsetBytes))
+            return;
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndexedIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
+    }
+
+    bool CommandListWrapper::validateComputeState(const ComputeState& state) const
+    {
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setComputeState: " << std::endl;
+
+        if (!state.pipeline)
+        {
+            ss << "pipeline is NULL." << std::endl;
+            anyErrors = true;
+        }
+
+        if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectParams->getDesc().debugName) << "' as a DispatchIndirect argument buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (state.indirectCountBuffer)
+        {
+            if (!state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+            {
+                ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as a DispatchIndirect count buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+                anyErrors = true;
+            }
+
+            // Only D3D12 can take the count for a dispatch from a buffer (ExecuteIndirect)
+            if (m_Device->getGraphicsAPI() != GraphicsAPI::D3D12)
+            {
+                ss << "ComputeState::indirectCountBuffer is only supported on D3D12." << std::endl;
+                anyErrors = true;
+            }
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return false;
+        }
+
+        if (anyErrors)
+            return false;
+
+        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+            anyErrors = true;
+
+        return !anyErrors;
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "setComputeState"))
+            return;
+
+        if (!runFullChecks())
+        {
+            if (!state.pipeline)
+            {
+                error("setComputeState: pipeline is NULL");
+                return;
+            }
+        }
+        else if (!validateComputeState(state))
+            return;
+
+        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
 
         m_CommandList->setComputeState(state);
 
@@ -801,6 +1173,7 @@ namespace nvrhi::validation
         m_ComputeStateSet = true;
         m_MeshletStateSet = false;
         m_RayTracingStateSet = false;
+        m_WorkGraphStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentComputeState = state;
     }
@@ -853,14 +1226,8 @@ namespace nvrhi::validation
         m_CommandList->dispatchIndirect(offsetBytes);
     }
 
-    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    bool CommandListWrapper::validateMeshletState(const MeshletState& state) const
     {
-        if (!requireOpenState())
-            return;
-
-        if (!requireType(CommandQueue::Graphics, "setMeshletState"))
-            return;
-
         bool anyErrors = false;
         if (!state.pipeline)
         {
@@ -868,13 +1235,44 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            error(std::string("Cannot use buffer '") + utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) + "' as a DispatchMesh count buffer because it does not have the isDrawIndirectArgs flag set.");
+            anyErrors = true;
+        }
+
+        if (state.indirectCountBuffer && !m_Device->queryFeatureSupport(Feature::DrawIndirectCount))
+        {
+            error("MeshletState::indirectCountBuffer is set, but the device does not support Feature::DrawIndirectCount.");
+            anyErrors = true;
+        }
+
         if (anyErrors)
-            return;
+            return false;
 
         if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
             anyErrors = true;
 
-        if (anyErrors)
+        return !anyErrors;
+    }
+
+    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setMeshletState"))
+            return;
+
+        if (!runFullChecks())
+        {
+            if (!state.pipeline)
+            {
+                error("MeshletState::pipeline is NULL");
+                return;
+            }
+        }
+        else if (!validateMeshletState(state))
             return;
 
         evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
@@ -885,6 +1283,7 @@ namespace nvrhi::validation
         m_ComputeStateSet = false;
         m_MeshletStateSet = true;
         m_RayTracingStateSet = false;
+        m_WorkGraphStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentMeshletState = state;
     }
@@ -910,131 +1309,475 @@ namespace nvrhi::validation
         m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
     }
 
-    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
         if (!requireOpenState())
             return;
 
-        m_CommandList->beginTimerQuery(query);
-    }
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirect"))
+            return;
 
-    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
-    {
-        if (!requireOpenState())
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirect call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
             return;
+        }
 
-        m_CommandList->endTimerQuery(query);
-    }
+        if (!m_CurrentMeshletState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchMeshIndirect call.");
+            return;
+        }
 
-    void CommandListWrapper::beginMarker(const char *name)
-    {
-        if (!requireOpenState())
+        if (!validatePushConstants("meshlet", "setMeshletState"))
             return;
 
-        m_CommandList->beginMarker(name);
+        m_CommandList->dispatchMeshIndirect(offsetBytes, drawCount);
     }
 
-    void CommandListWrapper::endMarker()
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
     {
         if (!requireOpenState())
             return;
 
-        m_CommandList->endMarker();
-    }
-
-    void CommandListWrapper::setEnableAutomaticBarriers(bool enable)
-    {
-        if (!requireOpenState())
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirectCount"))
             return;
-        
-        m_CommandList->setEnableAutomaticBarriers(enable);
-    }
 
-    void CommandListWrapper::setResourceStatesForBindingSet(IBindingSet* bindingSet)
-    {
-        if (!requireOpenState())
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirectCount call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
             return;
+        }
 
-        m_CommandList->setResourceStatesForBindingSet(bindingSet);
-    }
+        if (!m_CurrentMeshletState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchMeshIndirectCount call.");
+            return;
+        }
 
-    void CommandListWrapper::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
-    {
-        if (!requireOpenState())
+        if (!validateIndirectCountBuffer("dispatchMeshIndirectCount", countBuffer, countOffsetBytes))
             return;
 
-        if (!requireType(CommandQueue::Compute, "setEnableUavBarriersForTexture"))
+        if (!validatePushConstants("meshlet", "setMeshletState"))
             return;
 
-        m_CommandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countBuffer, countOffsetBytes, maxDrawCount);
     }
 
-    void CommandListWrapper::setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers)
+    void CommandListWrapper::executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+        uint32_t maxCommandCount, IBuffer* countBuffer, uint32_t countOffsetBytes)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "setEnableUavBarriersForBuffer"))
+        if (!signature)
+        {
+            error("Command signature is NULL in an executeIndirect call.");
             return;
+        }
 
-        m_CommandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
-    }
+        const CommandSignatureDesc& signatureDesc = signature->getDesc();
+        const IndirectArgumentType commandType = signatureDesc.arguments[signatureDesc.arguments.size() - 1].type;
 
-    void CommandListWrapper::beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
-    {
-        if (!requireOpenState())
-            return;
+        switch (commandType)
+        {
+        case IndirectArgumentType::Dispatch:
+            if (!requireType(CommandQueue::Compute, "executeIndirect"))
+                return;
 
-        m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
-    }
+            if (!m_ComputeStateSet)
+            {
+                error("Compute state is not set before an executeIndirect call with a Dispatch signature.\n"
+                    "Note that setting graphics state invalidates the compute state.");
+                return;
+            }
 
-    void CommandListWrapper::beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits)
-    {
-        if (!requireOpenState())
-            return;
+            if (!validatePushConstants("compute", "setComputeState"))
+                return;
+            break;
 
-        m_CommandList->beginTrackingBufferState(buffer, stateBits);
-    }
+        case IndirectArgumentType::DispatchMesh:
+            if (!requireType(CommandQueue::Graphics, "executeIndirect"))
+                return;
 
-    void CommandListWrapper::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
-    {
-        if (!requireOpenState())
-            return;
+            if (!m_MeshletStateSet)
+            {
+                error("Meshlet state is not set before an executeIndirect call with a DispatchMesh signature.\n"
+                    "Note that setting graphics or compute state invalidates the meshlet state.");
+                return;
+            }
 
-        m_CommandList->setTextureState(texture, subresources, stateBits);
-    }
+            if (!validatePushConstants("meshlet", "setMeshletState"))
+                return;
+            break;
 
-    void CommandListWrapper::setBufferState(IBuffer* buffer, ResourceStates stateBits)
-    {
-        if (!requireOpenState())
-            return;
+        default:
+            if (!requireType(CommandQueue::Graphics, "executeIndirect"))
+                return;
 
-        m_CommandList->setBufferState(buffer, stateBits);
-    }
+            if (!m_GraphicsStateSet)
+            {
+                error("Graphics state is not set before an executeIndirect call with a Draw or DrawIndexed signature.\n"
+                    "Note that setting compute state invalidates the graphics state.");
+                return;
+            }
 
-    void CommandListWrapper::setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits)
-    {
-        if (!requireOpenState())
+            if (!validatePushConstants("graphics", "setGraphicsState"))
+                return;
+            break;
+        }
+
+        if (!argumentBuffer)
+        {
+            error("Argument buffer is NULL in an executeIndirect call.");
             return;
+        }
 
-        m_CommandList->setAccelStructState(checked_cast<rt::IAccelStruct*>(unwrapResource(as)), stateBits);
-    }
+        const BufferDesc& argumentBufferDesc = argumentBuffer->getDesc();
+        if (!argumentBufferDesc.isDrawIndirectArgs)
+        {
+            std::stringstream ss;
+            ss << "Cannot use buffer '" << utils::DebugNameToString(argumentBufferDesc.debugName) << "' as an argument buffer in an "
+                "executeIndirect call because it does not have the isDrawIndirectArgs flag set.";
+            error(ss.str());
+            return;
+        }
 
-    void CommandListWrapper::setPermanentTextureState(ITexture* texture, ResourceStates stateBits)
-    {
-        if (!requireOpenState())
+        const uint64_t stride = utils::GetCommandSignatureByteStride(signatureDesc);
+        if (maxCommandCount > 0 && uint64_t(argumentOffsetBytes) + stride * maxCommandCount > argumentBufferDesc.byteSize)
+        {
+            std::stringstream ss;
+            ss << "executeIndirect reads " << maxCommandCount << " records of " << stride << " bytes at offset " << argumentOffsetBytes
+                << ", which is outside of buffer '" << utils::DebugNameToString(argumentBufferDesc.debugName)
+                << "' (" << argumentBufferDesc.byteSize << " bytes).";
+            error(ss.str());
             return;
+        }
 
-        m_CommandList->setPermanentTextureState(texture, stateBits);
+        if (countBuffer && !validateIndirectCountBuffer("executeIndirect", countBuffer, countOffsetBytes))
+            return;
+
+        m_CommandList->executeIndirect(signature, argumentBuffer, argumentOffsetBytes, maxCommandCount, countBuffer, countOffsetBytes);
     }
 
-    void CommandListWrapper::setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits)
+    void CommandListWrapper::executeBundle(ICommandBundle* bundle)
     {
         if (!requireOpenState())
             return;
 
-        m_CommandList->setPermanentBufferState(buffer, stateBits);
-    }
+        if (!requireType(CommandQueue::Graphics, "executeBundle"))
+            return;
+
+        if (!bundle)
+        {
+            error("executeBundle: bundle is NULL");
+            return;
+        }
+
+        CommandBundleWrapper* wrapper = dynamic_cast<CommandBundleWrapper*>(bundle);
+        if (wrapper)
+        {
+            if (!wrapper->requireExecuteState())
+                return;
+
+            bundle = wrapper->getUnderlyingBundle();
+        }
+
+        m_CommandList->executeBundle(bundle);
+
+        // The bundle leaves the pipeline state of the command list undefined
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = false;
+        m_RayTracingStateSet = false;
+        m_WorkGraphStateSet = false;
+        m_PushConstantsSet = false;
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginTimerQuery(query);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->endTimerQuery(query);
+    }
+
+    bool CommandListWrapper::validateQueryRange(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, const char* operation) const
+    {
+        if (!pool)
+        {
+            error(std::string(operation) + ": query pool is NULL");
+            return false;
+        }
+
+        const QueryPoolDesc& desc = pool->getDesc();
+        if (uint64_t(firstQuery) + numQueries > desc.count)
+        {
+            std::stringstream ss;
+            ss << operation << ": queries [" << firstQuery << ", " << uint64_t(firstQuery) + numQueries
+               << ") are out of range for query pool " << utils::DebugNameToString(desc.debugName)
+               << " with " << desc.count << " queries";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, firstQuery, numQueries, "resetQueries"))
+            return;
+
+        m_CommandList->resetQueries(pool, firstQuery, numQueries);
+    }
+
+    void CommandListWrapper::beginQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, queryIndex, 1, "beginQuery"))
+            return;
+
+        // Occlusion queries need a graphics queue, pipeline statistics can also count compute shader invocations
+        const CommandQueue requiredQueue = (pool->getDesc().type == QueryType::PipelineStatistics) ? CommandQueue::Compute : CommandQueue::Graphics;
+        if (!requireType(requiredQueue, "beginQuery"))
+            return;
+
+        m_CommandList->beginQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::endQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, queryIndex, 1, "endQuery"))
+            return;
+
+        m_CommandList->endQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, firstQuery, numQueries, "resolveQueries"))
+            return;
+
+        if (!buffer)
+        {
+            error("resolveQueries: buffer is NULL");
+            return;
+        }
+
+        const uint64_t resultSize = (pool->getDesc().type == QueryType::PipelineStatistics)
+            ? sizeof(PipelineStatistics)
+            : sizeof(uint64_t);
+
+        if ((offsetBytes % sizeof(uint64_t)) != 0 || offsetBytes + resultSize * numQueries > buffer->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "resolveQueries: " << numQueries << " results of " << resultSize << " bytes at offset " << offsetBytes
+               << " don't fit into buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+               << " of " << buffer->getDesc().byteSize << " bytes, or the offset is not a multiple of 8";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->resolveQueries(pool, firstQuery, numQueries, buffer, offsetBytes);
+    }
+
+    void CommandListWrapper::setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (buffer)
+        {
+            if (!m_Device->queryFeatureSupport(Feature::Predication))
+            {
+                error("setPredication: Feature::Predication is not supported by the device");
+                return;
+            }
+
+            const BufferDesc& desc = buffer->getDesc();
+            if (!desc.isPredicationBuffer)
+            {
+                error("setPredication: buffer " + std::string(utils::DebugNameToString(desc.debugName)) + " was not created with isPredicationBuffer = true");
+                return;
+            }
+
+            if ((offsetBytes % sizeof(uint64_t)) != 0 || offsetBytes + sizeof(uint64_t) > desc.byteSize)
+            {
+                std::stringstream ss;
+                ss << "setPredication: offset " << offsetBytes << " is not a multiple of 8 or is out of range for buffer "
+                   << utils::DebugNameToString(desc.debugName);
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_CommandList->setPredication(buffer, offsetBytes, op);
+    }
+
+    void CommandListWrapper::beginMarker(const char *name)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginMarker(name);
+    }
+
+    void CommandListWrapper::endMarker()
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->endMarker();
+    }
+
+    void CommandListWrapper::setGpuProfiler(IGpuProfiler* profiler)
+    {
+        if (profiler && m_type == CommandQueue::Copy)
+            warning("setGpuProfiler: command lists on the copy queue are not profiled");
+
+        m_CommandList->setGpuProfiler(profiler);
+    }
+
+    void CommandListWrapper::writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!buffer)
+        {
+            error("writeBreadcrumb: buffer is NULL");
+            return;
+        }
+
+        if (m_GPULog != ULLONG_MAX && m_GPULog >= buffer->getDesc().numSlots)
+        {
+            std::stringstream ss;
+            ss << "writeBreadcrumb: m_GPULog = " << m_GPULog << " is out of range for a breadcrumb buffer with "
+               << buffer->getDesc().numSlots << " slots";
+            error(ss.str());
+            return;
+        }
+
+        // The slot is selected by the m_GPULog value that the application sets on this wrapper
+        m_CommandList->m_GPULog = m_GPULog;
+        m_CommandList->writeBreadcrumb(buffer, markerId);
+    }
+
+    void CommandListWrapper::setEnableAutomaticBarriers(bool enable)
+    {
+        if (!requireOpenState())
+            return;
+        
+        m_CommandList->setEnableAutomaticBarriers(enable);
+    }
+
+    void CommandListWrapper::setResourceStatesForBindingSet(IBindingSet* bindingSet)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->setResourceStatesForBindingSet(bindingSet);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "setEnableUavBarriersForTexture"))
+            return;
+
+        m_CommandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "setEnableUavBarriersForBuffer"))
+            return;
+
+        m_CommandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandListWrapper::beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->setTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::setBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->setBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->setAccelStructState(checked_cast<rt::IAccelStruct*>(unwrapResource(as)), stateBits);
+    }
+
+    void CommandListWrapper::setPermanentTextureState(ITexture* texture, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->setPermanentTextureState(texture, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->setPermanentBufferState(buffer, stateBits);
+    }
 
     void CommandListWrapper::commitBarriers()
     {
@@ -1044,6 +1787,136 @@ namespace nvrhi::validation
         m_CommandList->commitBarriers();
     }
 
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!texture)
+        {
+            error("beginTextureStateTransition: texture is NULL");
+            return;
+        }
+
+        m_OpenStateTransitions.insert(texture);
+
+        m_CommandList->beginTextureStateTransition(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::endTextureStateTransition(ITexture* texture)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (m_OpenStateTransitions.erase(texture) == 0)
+        {
+            std::stringstream ss;
+            ss << "endTextureStateTransition: there is no open state transition for texture "
+                << (texture ? utils::DebugNameToString(texture->getDesc().debugName) : "NULL");
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->endTextureStateTransition(texture);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!buffer)
+        {
+            error("beginBufferStateTransition: buffer is NULL");
+            return;
+        }
+
+        m_OpenStateTransitions.insert(buffer);
+
+        m_CommandList->beginBufferStateTransition(buffer, stateBits);
+    }
+
+    void CommandListWrapper::endBufferStateTransition(IBuffer* buffer)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (m_OpenStateTransitions.erase(buffer) == 0)
+        {
+            std::stringstream ss;
+            ss << "endBufferStateTransition: there is no open state transition for buffer "
+                << (buffer ? utils::DebugNameToString(buffer->getDesc().debugName) : "NULL");
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->endBufferStateTransition(buffer);
+    }
+
+    void CommandListWrapper::textureAliasingBarrier(ITexture* texture)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!texture)
+        {
+            error("textureAliasingBarrier: texture is NULL");
+            return;
+        }
+
+        if (!texture->getDesc().isVirtual)
+        {
+            std::stringstream ss;
+            ss << "textureAliasingBarrier: texture " << utils::DebugNameToString(texture->getDesc().debugName)
+                << " is not a virtual texture and cannot alias other resources";
+            error(ss.str());
+            return;
+        }
+
+        if (m_OpenStateTransitions.find(texture) != m_OpenStateTransitions.end())
+        {
+            std::stringstream ss;
+            ss << "textureAliasingBarrier: texture " << utils::DebugNameToString(texture->getDesc().debugName)
+                << " has an open state transition";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->textureAliasingBarrier(texture);
+    }
+
+    void CommandListWrapper::bufferAliasingBarrier(IBuffer* buffer)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!buffer)
+        {
+            error("bufferAliasingBarrier: buffer is NULL");
+            return;
+        }
+
+        if (!buffer->getDesc().isVirtual)
+        {
+            std::stringstream ss;
+            ss << "bufferAliasingBarrier: buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+                << " is not a virtual buffer and cannot alias other resources";
+            error(ss.str());
+            return;
+        }
+
+        if (m_OpenStateTransitions.find(buffer) != m_OpenStateTransitions.end())
+        {
+            std::stringstream ss;
+            ss << "bufferAliasingBarrier: buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+                << " has an open state transition";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->bufferAliasingBarrier(buffer);
+    }
+
     ResourceStates CommandListWrapper::getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel)
     {
         if (!requireOpenState())
@@ -1069,6 +1942,7 @@ namespace nvrhi::validation
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
         m_RayTracingStateSet = false;
+        m_WorkGraphStateSet = false;
         m_PushConstantsSet = false;
 
         m_CommandList->clearState();
@@ -1084,6 +1958,11 @@ namespace nvrhi::validation
         return m_CommandList->getDesc();
     }
 
+    const CommandListStatistics& CommandListWrapper::getStatistics() const
+    {
+        return m_CommandList->getStatistics();
+    }
+
     void CommandListWrapper::setRayTracingState(const rt::State& state)
     {
         if (!requireOpenState())
@@ -1100,6 +1979,7 @@ namespace nvrhi::validation
         m_ComputeStateSet = false;
         m_MeshletStateSet = true;
         m_RayTracingStateSet = true;
+        m_WorkGraphStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentRayTracingState = state;
     }
@@ -1125,379 +2005,615 @@ namespace nvrhi::validation
         m_CommandList->dispatchRays(args);
     }
 
-    void CommandListWrapper::compactBottomLevelAccelStructs()
+    bool CommandListWrapper::validateWorkGraphState(const WorkGraphState& state) const
     {
-        if (!requireOpenState())
-            return;
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setWorkGraphState: " << std::endl;
 
-        if (!requireType(CommandQueue::Compute, "compactBottomLevelAccelStructs"))
-            return;
+        if (!state.workGraph)
+        {
+            error("setWorkGraphState: workGraph is NULL");
+            return false;
+        }
 
-        m_CommandList->compactBottomLevelAccelStructs();
+        const WorkGraphMemoryRequirements& requirements = state.workGraph->getBackingMemoryRequirements();
+
+        if (state.backingMemory)
+        {
+            const BufferDesc& bufferDesc = state.backingMemory->getDesc();
+
+            if (!bufferDesc.canHaveUAVs)
+            {
+                ss << "Cannot use buffer '" << utils::DebugNameToString(bufferDesc.debugName) << "' as work graph backing memory "
+                    "because it does not have the canHaveUAVs flag set." << std::endl;
+                anyErrors = true;
+            }
+
+            if (bufferDesc.isVolatile)
+            {
+                ss << "Cannot use the volatile buffer '" << utils::DebugNameToString(bufferDesc.debugName) << "' as work graph backing memory." << std::endl;
+                anyErrors = true;
+            }
+
+            if (bufferDesc.byteSize < requirements.minSize)
+            {
+                ss << "Buffer '" << utils::DebugNameToString(bufferDesc.debugName) << "' is too small for the backing memory of the work graph '"
+                    << utils::DebugNameToString(state.workGraph->getDesc().debugName) << "': " << bufferDesc.byteSize
+                    << " bytes, the graph needs at least " << requirements.minSize << " bytes." << std::endl;
+                anyErrors = true;
+            }
+        }
+        else if (!state.workGraph->getBackingMemory() && requirements.minSize > 0)
+        {
+            ss << "The work graph '" << utils::DebugNameToString(state.workGraph->getDesc().debugName) << "' was created without "
+                "backing memory, so WorkGraphState::backingMemory must be set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return false;
+        }
+
+        return validateBindingSetsAgainstLayouts(state.workGraph->getDesc().globalBindingLayouts, state.bindings);
     }
 
-    void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) 
+    void CommandListWrapper::setWorkGraphState(const WorkGraphState& state)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "buildOpacityMicromap"))
+        if (!requireType(CommandQueue::Compute, "setWorkGraphState"))
             return;
 
-        m_CommandList->buildOpacityMicromap(omm, desc);
+        if (!runFullChecks())
+        {
+            if (!state.workGraph)
+            {
+                error("setWorkGraphState: workGraph is NULL");
+                return;
+            }
+        }
+        else if (!validateWorkGraphState(state))
+            return;
+
+        evaluatePushConstantSize(state.workGraph->getDesc().globalBindingLayouts);
+
+        m_CommandList->setWorkGraphState(state);
+
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = false;
+        m_RayTracingStateSet = false;
+        m_WorkGraphStateSet = true;
+        m_PushConstantsSet = false;
+        m_CurrentWorkGraphState = state;
     }
 
-    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandListWrapper::dispatchGraph(const DispatchGraphArguments& args)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStruct"))
+        if (!requireType(CommandQueue::Compute, "dispatchGraph"))
             return;
 
-        rt::IAccelStruct* underlyingAS = as;
+        if (!m_WorkGraphStateSet)
+        {
+            error("Work graph state is not set before a dispatchGraph call.\n"
+                "Note that setting graphics, compute, meshlet, or ray tracing state invalidates the work graph state.");
+            return;
+        }
 
-        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
-        if (wrapper)
+        if (!validatePushConstants("work graph", "setWorkGraphState"))
+            return;
+
+        IWorkGraph* workGraph = m_CurrentWorkGraphState.workGraph;
+
+        if (args.inputBuffer)
         {
-            underlyingAS = wrapper->getUnderlyingObject();
+            const BufferDesc& bufferDesc = args.inputBuffer->getDesc();
 
-            if (wrapper->isTopLevel)
+            if (!bufferDesc.isDrawIndirectArgs)
             {
-                error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+                std::stringstream ss;
+                ss << "Cannot use buffer '" << utils::DebugNameToString(bufferDesc.debugName) << "' as a dispatchGraph input buffer "
+                    "because it does not have the isDrawIndirectArgs flag set.";
+                error(ss.str());
                 return;
             }
-            
-            for (size_t i = 0; i < numGeometries; i++)
+
+            if (args.inputOffset % 8 != 0 || args.inputOffset >= bufferDesc.byteSize)
             {
-                const auto& geom = pGeometries[i];
+                std::stringstream ss;
+                ss << "dispatchGraph: inputOffset (" << args.inputOffset << ") must be a multiple of 8 and within the input buffer '"
+                    << utils::DebugNameToString(bufferDesc.debugName) << "' (" << bufferDesc.byteSize << " bytes).";
+                error(ss.str());
+                return;
+            }
+        }
+        else
+        {
+            if (args.entryPointIndex >= workGraph->getNumEntryPoints())
+            {
+                std::stringstream ss;
+                ss << "dispatchGraph: entryPointIndex (" << args.entryPointIndex << ") is out of range, the work graph '"
+                    << utils::DebugNameToString(workGraph->getDesc().debugName) << "' has " << workGraph->getNumEntryPoints() << " entry points.";
+                error(ss.str());
+                return;
+            }
 
-                if (geom.geometryType == rt::GeometryType::Triangles)
-                {
-                    const auto& triangles = geom.geometryData.triangles;
+            const uint32_t recordSize = workGraph->getEntryPointRecordSize(args.entryPointIndex);
 
-                    if (triangles.indexFormat != Format::UNKNOWN)
-                    {
-                        switch (triangles.indexFormat)  // NOLINT(clang-diagnostic-switch-enum)
-                        {
-                        case Format::R8_UINT:
-                            if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
-                            {
-                                std::stringstream ss;
-                                ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                    << " has index format R8_UINT which is only supported on Vulkan";
-                                error(ss.str());
-                                return;
-                            }
-                            break;
-                        case Format::R16_UINT:
-                        case Format::R32_UINT:
-                            break;
-                        default: {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
-                            error(ss.str());
-                            return;
-                        }
-                        }
+            if (recordSize > 0 && args.numRecords > 0 && !args.records)
+            {
+                std::stringstream ss;
+                ss << "dispatchGraph: records is NULL, but the entry point " << args.entryPointIndex << " takes " << recordSize << "-byte records.";
+                error(ss.str());
+                return;
+            }
 
-                        if (triangles.indexBuffer == nullptr)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
-                            error(ss.str());
-                            return;
-                        }
+            if (args.recordStride != 0 && args.recordStride < recordSize)
+            {
+                std::stringstream ss;
+                ss << "dispatchGraph: recordStride (" << args.recordStride << ") is smaller than the record size of the entry point ("
+                    << recordSize << " bytes).";
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_CommandList->dispatchGraph(args);
+    }
+
+    void CommandListWrapper::compactBottomLevelAccelStructs()
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "compactBottomLevelAccelStructs"))
+            return;
+
+        m_CommandList->compactBottomLevelAccelStructs();
+    }
+
+    void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) 
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildOpacityMicromap"))
+            return;
 
-                        const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
-                        if (!indexBufferDesc.isAccelStructBuildInput)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
-                                << " which does not have the isAccelStructBuildInput flag set";
-                            error(ss.str());
-                            return;
-                        }
+        m_CommandList->buildOpacityMicromap(omm, desc);
+    }
 
-                        const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
-                        if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
-                                << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
-                                << ", which will result in a buffer overrun";
-                            error(ss.str());
-                            return;
-                        }
+    bool CommandListWrapper::validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const
+    {
+        if (wrapper->isTopLevel)
+        {
+            error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+            return false;
+        }
+        
+        for (size_t i = 0; i < numGeometries; i++)
+        {
+            const auto& geom = pGeometries[i];
 
-                        if ((triangles.indexCount % 3) != 0)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexCount = " << triangles.indexCount
-                                << ", which is not a multiple of 3";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                    else
-                    {
-                        if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
-                            error(ss.str());
-                            return;
-                        }
+            if (geom.geometryType == rt::GeometryType::Triangles)
+            {
+                const auto& triangles = geom.geometryData.triangles;
 
-                        if (triangles.indexBuffer != nullptr)
+                if (triangles.indexFormat != Format::UNKNOWN)
+                {
+                    switch (triangles.indexFormat)  // NOLINT(clang-diagnostic-switch-enum)
+                    {
+                    case Format::R8_UINT:
+                        if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
-                                << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                                << " has index format R8_UINT which is only supported on Vulkan";
                             error(ss.str());
-                            return;
+                            return false;
                         }
-                    }
-
-                    switch (triangles.vertexFormat)  // NOLINT(clang-diagnostic-switch-enum)
-                    {
-                    case Format::RG32_FLOAT:
-                    case Format::RGB32_FLOAT:
-                    case Format::RG16_FLOAT:
-                    case Format::RGBA16_FLOAT:
-                    case Format::RG16_SNORM:
-                    case Format::RGBA16_SNORM:
-                    case Format::RGBA16_UNORM:
-                    case Format::RG16_UNORM:
-                    case Format::R10G10B10A2_UNORM:
-                    case Format::RGBA8_UNORM:
-                    case Format::RG8_UNORM:
-                    case Format::RGBA8_SNORM:
-                    case Format::RG8_SNORM:
+                        break;
+                    case Format::R16_UINT:
+                    case Format::R32_UINT:
                         break;
                     default: {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has unsupported vertex format: " << utils::FormatToString(triangles.indexFormat);
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
                         error(ss.str());
-                        return;
-                    }
+                        return false;
                     }
-
-                    if (triangles.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
                     }
 
-                    if (triangles.vertexStride == 0)
+                    if (triangles.indexBuffer == nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has vertexStride = 0";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
+                    const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
+                    if (!indexBufferDesc.isAccelStructBuildInput)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
-                            << ", which is not a multiple of 3";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
+                            << " which does not have the isAccelStructBuildInput flag set";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
-                    if (!vertexBufferDesc.isAccelStructBuildInput)
+                    const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
+                    if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
-                            << " which does not have the isAccelStructBuildInput flag set";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
+                            << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
+                            << ", which will result in a buffer overrun";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
-                    if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
+                    if ((triangles.indexCount % 3) != 0)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
-                            << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
-                            << ", which will result in a buffer overrun";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexCount = " << triangles.indexCount
+                            << ", which is not a multiple of 3";
                         error(ss.str());
-                        return;
+                        return false;
                     }
                 }
-                else // AABBs
+                else
                 {
-                    const auto& aabbs = geom.geometryData.aabbs;
-
-                    if (aabbs.buffer== nullptr)
+                    if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL AABB data buffer";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
-                    if (!aabbBufferDesc.isAccelStructBuildInput)
+                    if (triangles.indexBuffer != nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
-                            << " which does not have the isAccelStructBuildInput flag set";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
+                            << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
                         error(ss.str());
-                        return;
+                        return false;
                     }
+                }
 
-                    if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has AABB stride = " << aabbs.stride
-                            << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
-                        error(ss.str());
-                        return;
-                    }
+                switch (triangles.vertexFormat)  // NOLINT(clang-diagnostic-switch-enum)
+                {
+                case Format::RG32_FLOAT:
+                case Format::RGB32_FLOAT:
+                case Format::RG16_FLOAT:
+                case Format::RGBA16_FLOAT:
+                case Format::RG16_SNORM:
+                case Format::RGBA16_SNORM:
+                case Format::RGBA16_UNORM:
+                case Format::RG16_UNORM:
+                case Format::R10G10B10A2_UNORM:
+                case Format::RGBA8_UNORM:
+                case Format::RG8_UNORM:
+                case Format::RGBA8_SNORM:
+                case Format::RG8_SNORM:
+                    break;
+                default: {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has unsupported vertex format: " << utils::FormatToString(triangles.indexFormat);
+                    error(ss.str());
+                    return false;
+                }
+                }
 
-                    const size_t aabbDataSize = aabbs.count * aabbs.stride;
-                    if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
-                            << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
-                            << ", which will result in a buffer overrun";
-                        error(ss.str());
-                        return;
-                    }
+                if (triangles.vertexBuffer == nullptr)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (geom.useTransform)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " is of type AABB but has useTransform = true, "
-                            "which is unsupported, and the transform will be ignored";
-                        m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
-                    }
+                if (triangles.vertexStride == 0)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has vertexStride = 0";
+                    error(ss.str());
+                    return false;
+                }
+
+                if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
+                        << ", which is not a multiple of 3";
+                    error(ss.str());
+                    return false;
                 }
-            }
 
-            if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+                const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
+                if (!vertexBufferDesc.isAccelStructBuildInput)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
+                        << " which does not have the isAccelStructBuildInput flag set";
+                    error(ss.str());
+                    return false;
+                }
+
+                const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
+                if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
+                        << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
+                        << ", which will result in a buffer overrun";
+                    error(ss.str());
+                    return false;
+                }
+            }
+            else // AABBs
             {
-                if (!wrapper->allowUpdate)
+                const auto& aabbs = geom.geometryData.aabbs;
+
+                if (aabbs.buffer== nullptr)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " that was not created with the AllowUpdate flag";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL AABB data buffer";
                     error(ss.str());
-                    return;
+                    return false;
                 }
 
-                if (!wrapper->wasBuilt)
+                const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
+                if (!aabbBufferDesc.isAccelStructBuildInput)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " before the same BLAS was initially built";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
+                        << " which does not have the isAccelStructBuildInput flag set";
                     error(ss.str());
-                    return;
+                    return false;
                 }
 
-                if (numGeometries != wrapper->buildGeometries.size())
+                if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " with " << numGeometries << " geometries "
-                        "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has AABB stride = " << aabbs.stride
+                        << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
                     error(ss.str());
-                    return;
+                    return false;
+                }
+
+                const size_t aabbDataSize = aabbs.count * aabbs.stride;
+                if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
+                        << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
+                        << ", which will result in a buffer overrun";
+                    error(ss.str());
+                    return false;
+                }
+
+                if (geom.useTransform)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " is of type AABB but has useTransform = true, "
+                        "which is unsupported, and the transform will be ignored";
+                    m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
+                }
+            }
+        }
+
+        if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+        {
+            if (!wrapper->allowUpdate)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " that was not created with the AllowUpdate flag";
+                error(ss.str());
+                return false;
+            }
+
+            if (!wrapper->wasBuilt)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " before the same BLAS was initially built";
+                error(ss.str());
+                return false;
+            }
+
+            if (numGeometries != wrapper->buildGeometries.size())
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " with " << numGeometries << " geometries "
+                    "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                error(ss.str());
+                return false;
+            }
+            
+            for (size_t i = 0; i < numGeometries; i++)
+            {
+                const auto& before = wrapper->buildGeometries[i];
+                const auto& after = pGeometries[i];
+
+                if (before.geometryType != after.geometryType)
+                {
+                    std::stringstream ss;
+                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                        << " with mismatching geometry types in slot " << i;
+                    error(ss.str());
+                    return false;
                 }
-                
-                for (size_t i = 0; i < numGeometries; i++)
+
+                if (before.geometryType == rt::GeometryType::Triangles)
                 {
-                    const auto& before = wrapper->buildGeometries[i];
-                    const auto& after = pGeometries[i];
+                    uint32_t primitivesBefore = (before.geometryData.triangles.vertexFormat == Format::UNKNOWN)
+                        ? before.geometryData.triangles.vertexCount
+                        : before.geometryData.triangles.indexCount;
+
+                    uint32_t primitivesAfter = (after.geometryData.triangles.vertexFormat == Format::UNKNOWN)
+                        ? after.geometryData.triangles.vertexCount
+                        : after.geometryData.triangles.indexCount;
 
-                    if (before.geometryType != after.geometryType)
+                    primitivesBefore /= 3;
+                    primitivesAfter /= 3;
+
+                    if (primitivesBefore != primitivesAfter)
                     {
                         std::stringstream ss;
-                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                            << " with mismatching geometry types in slot " << i;
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                            << " with mismatching triangle counts in geometry slot " << i << ": "
+                            "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
                         error(ss.str());
-                        return;
+                        return false;
                     }
+                }
+                else // AABBs
+                {
+                    uint32_t aabbsBefore = before.geometryData.aabbs.count;
+                    uint32_t aabbsAfter = after.geometryData.aabbs.count;
 
-                    if (before.geometryType == rt::GeometryType::Triangles)
+                    if (aabbsBefore != aabbsAfter)
                     {
-                        uint32_t primitivesBefore = (before.geometryData.triangles.vertexFormat == Format::UNKNOWN)
-                            ? before.geometryData.triangles.vertexCount
-                            : before.geometryData.triangles.indexCount;
+                        std::stringstream ss;
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                            << " with mismatching AABB counts in geometry slot " << i << ": "
+                            "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
+                        error(ss.str());
+                        return false;
+                    }
+                }
+            }
+        }
 
-                        uint32_t primitivesAfter = (after.geometryData.triangles.vertexFormat == Format::UNKNOWN)
-                            ? after.geometryData.triangles.vertexCount
-                            : after.geometryData.triangles.indexCount;
+        if (wrapper->allowCompaction && wrapper->wasBuilt)
+        {
+            std::stringstream ss;
+            ss << "Cannot rebuild BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                << " that has the AllowCompaction flag set";
+            error(ss.str());
+            return false;
+        }
 
-                        primitivesBefore /= 3;
-                        primitivesAfter /= 3;
+        return true;
+    }
 
-                        if (primitivesBefore != primitivesAfter)
-                        {
-                            std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                                << " with mismatching triangle counts in geometry slot " << i << ": "
-                                "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                    else // AABBs
-                    {
-                        uint32_t aabbsBefore = before.geometryData.aabbs.count;
-                        uint32_t aabbsAfter = after.geometryData.aabbs.count;
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!requireOpenState())
+            return;
 
-                        if (aabbsBefore != aabbsAfter)
-                        {
-                            std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                                << " with mismatching AABB counts in geometry slot " << i << ": "
-                                "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                }
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStruct"))
+            return;
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            underlyingAS = wrapper->getUnderlyingObject();
+
+            if (!validateBuildBottomLevelAccelStruct(wrapper, pGeometries, numGeometries, buildFlags))
+                return;
+
+            wrapper->wasBuilt = true;
+            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+        }
+
+        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStructs"))
+            return;
+
+        if (numBuilds > 0 && !pBuilds)
+        {
+            error("buildBottomLevelAccelStructs: 'pBuilds' is NULL");
+            return;
+        }
+
+        std::vector<rt::BottomLevelBuildDesc> patchedBuilds;
+        patchedBuilds.assign(pBuilds, pBuilds + numBuilds);
+
+        std::unordered_set<rt::IAccelStruct*> uniqueAccelStructs;
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            const rt::BottomLevelBuildDesc& build = pBuilds[buildIndex];
+
+            if (!build.accelStruct)
+            {
+                std::stringstream ss;
+                ss << "buildBottomLevelAccelStructs: build " << buildIndex << " has a NULL accelStruct";
+                error(ss.str());
+                return;
             }
 
-            if (wrapper->allowCompaction && wrapper->wasBuilt)
+            if (!uniqueAccelStructs.insert(build.accelStruct).second)
             {
                 std::stringstream ss;
-                ss << "Cannot rebuild BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                    << " that has the AllowCompaction flag set";
+                ss << "BLAS " << utils::DebugNameToString(build.accelStruct->getDesc().debugName)
+                    << " appears more than once in a buildBottomLevelAccelStructs batch";
                 error(ss.str());
                 return;
             }
 
-            wrapper->wasBuilt = true;
-            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                patchedBuilds[buildIndex].accelStruct = wrapper->getUnderlyingObject();
+
+                if (!validateBuildBottomLevelAccelStruct(wrapper, build.geometries, build.numGeometries, build.buildFlags))
+                    return;
+            }
         }
 
-        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            const rt::BottomLevelBuildDesc& build = pBuilds[buildIndex];
+
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                wrapper->wasBuilt = true;
+                wrapper->buildGeometries.assign(build.geometries, build.geometries + build.numGeometries);
+            }
+        }
+
+        m_CommandList->buildBottomLevelAccelStructs(patchedBuilds.data(), patchedBuilds.size());
     }
 
     bool CommandListWrapper::validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const
@@ -1541,21 +2657,79 @@ namespace nvrhi::validation
                 return false;
             }
 
-            if (wrapper->buildInstances != numInstances)
+            if (wrapper->buildInstances != numInstances)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on TLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " with " << numInstances << " instances when this TLAS was built with "
+                    << wrapper->buildInstances << " instances";
+                error(ss.str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool CommandListWrapper::validateTopLevelInstances(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t firstInstance, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const
+    {
+        const bool allowEmptyInstances = (buildFlags & rt::AccelStructBuildFlags::AllowEmptyInstances) != 0;
+
+        for (size_t i = firstInstance; i < firstInstance + numInstances; i++)
+        {
+            const auto& instance = pInstances[i];
+
+            if (instance.bottomLevelAS == nullptr)
+            {
+                if (allowEmptyInstances)
+                {
+                    continue;
+                }
+                else
+                {
+                    std::stringstream ss;
+                    ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
+                        << " has a NULL bottomLevelAS";
+                    error(ss.str());
+                    return false;
+                }
+            }
+
+            AccelStructWrapper* blasWrapper = dynamic_cast<AccelStructWrapper*>(instance.bottomLevelAS);
+            if (blasWrapper)
+            {
+                if (blasWrapper->isTopLevel)
+                {
+                    std::stringstream ss;
+                    ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
+                        << " refers to another TLAS, which is unsupported";
+                    error(ss.str());
+                    return false;
+                }
+
+                if (!blasWrapper->wasBuilt)
+                {
+                    std::stringstream ss;
+                    ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
+                        << " refers to a BLAS which was never built";
+                    error(ss.str());
+                    return false;
+                }
+            }
+
+            if (instance.instanceMask == 0 && !allowEmptyInstances)
             {
                 std::stringstream ss;
-                ss << "Cannot perform an update on TLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
-                    << " with " << numInstances << " instances when this TLAS was built with "
-                    << wrapper->buildInstances << " instances";
-                error(ss.str());
-                return false;
+                ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
+                    << " has instanceMask = 0, which means the instance "
+                    "will never be included in any ray intersections";
+                m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
             }
         }
 
         return true;
     }
 
-
     void CommandListWrapper::buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         if (!requireOpenState())
@@ -1588,64 +2762,92 @@ namespace nvrhi::validation
             if (!validateBuildTopLevelAccelStruct(wrapper, numInstances, buildFlags))
                 return;
 
-            const bool allowEmptyInstances = (buildFlags & rt::AccelStructBuildFlags::AllowEmptyInstances) != 0;
+            if (!validateTopLevelInstances(as, pInstances, 0, numInstances, buildFlags))
+                return;
             
-            for (size_t i = 0; i < numInstances; i++)
-            {
-                const auto& instance = pInstances[i];
+            wrapper->wasBuilt = true;
+            wrapper->buildInstances = numInstances;
+        }
+        m_CommandList->buildTopLevelAccelStruct(underlyingAS, patchedInstances.data(), uint32_t(patchedInstances.size()), buildFlags);
+    }
 
-                if (instance.bottomLevelAS == nullptr)
-                {
-                    if (allowEmptyInstances)
-                    {
-                        continue;
-                    }
-                    else
-                    {
-                        std::stringstream ss;
-                        ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
-                            << " has a NULL bottomLevelAS";
-                        error(ss.str());
-                        return;
-                    }
-                }
+    void CommandListWrapper::buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+        const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!requireOpenState())
+            return;
 
-                AccelStructWrapper* blasWrapper = dynamic_cast<AccelStructWrapper*>(instance.bottomLevelAS);
-                if (blasWrapper)
-                {
-                    if (blasWrapper->isTopLevel)
-                    {
-                        std::stringstream ss;
-                        ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
-                            << " refers to another TLAS, which is unsupported";
-                        error(ss.str());
-                        return;
-                    }
+        if (!requireType(CommandQueue::Compute, "buildTopLevelAccelStructFromDirtyRanges"))
+            return;
 
-                    if (!blasWrapper->wasBuilt)
-                    {
-                        std::stringstream ss;
-                        ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
-                            << " refers to a BLAS which was never built";
-                        error(ss.str());
-                        return;
-                    }
-                }
+        if (!as)
+        {
+            error("buildTopLevelAccelStructFromDirtyRanges: 'as' is NULL");
+            return;
+        }
+
+        if (numDirtyRanges > 0 && !dirtyRanges)
+        {
+            error("buildTopLevelAccelStructFromDirtyRanges: 'dirtyRanges' is NULL");
+            return;
+        }
+
+        if (!as->getDesc().persistentInstanceBuffer)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform buildTopLevelAccelStructFromDirtyRanges on TLAS " << utils::DebugNameToString(as->getDesc().debugName)
+                << " that was not created with persistentInstanceBuffer = true";
+            error(ss.str());
+            return;
+        }
+
+        std::vector<rt::InstanceDesc> patchedInstances;
+        patchedInstances.assign(pInstances, pInstances + numInstances);
+
+        for (auto& instance : patchedInstances)
+        {
+            instance.bottomLevelAS = checked_cast<rt::IAccelStruct*>(unwrapResource(instance.bottomLevelAS));
+        }
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            underlyingAS = wrapper->getUnderlyingObject();
 
-                if (instance.instanceMask == 0 && !allowEmptyInstances)
+            if (!validateBuildTopLevelAccelStruct(wrapper, numInstances, buildFlags))
+                return;
+
+            for (size_t r = 0; r < numDirtyRanges; r++)
+            {
+                const rt::InstanceRange& range = dirtyRanges[r];
+
+                if (range.firstInstance + range.numInstances > numInstances)
                 {
                     std::stringstream ss;
-                    ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build instance " << i
-                        << " has instanceMask = 0, which means the instance "
-                        "will never be included in any ray intersections";
-                    m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
+                    ss << "TLAS " << utils::DebugNameToString(as->getDesc().debugName) << " dirty range " << r
+                        << " (instances " << range.firstInstance << " to " << range.firstInstance + range.numInstances
+                        << ") is out of bounds of the " << numInstances << " instances provided";
+                    error(ss.str());
+                    return;
                 }
+
+                if (!validateTopLevelInstances(as, pInstances, range.firstInstance, range.numInstances, buildFlags))
+                    return;
             }
-            
+
+            // The instances that were not there in the previous build are uploaded as well
+            const size_t previousNumInstances = wrapper->wasBuilt ? std::min(wrapper->buildInstances, numInstances) : 0;
+            if (!validateTopLevelInstances(as, pInstances, previousNumInstances, numInstances - previousNumInstances, buildFlags))
+                return;
+
             wrapper->wasBuilt = true;
             wrapper->buildInstances = numInstances;
         }
-        m_CommandList->buildTopLevelAccelStruct(underlyingAS, patchedInstances.data(), uint32_t(patchedInstances.size()), buildFlags);
+
+        m_CommandList->buildTopLevelAccelStructFromDirtyRanges(underlyingAS, patchedInstances.data(), patchedInstances.size(),
+            dirtyRanges, numDirtyRanges, buildFlags);
     }
 
     void CommandListWrapper::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -1744,4 +2946,228 @@ namespace nvrhi::validation
         return true;
     }
     
+
+    void CommandBundleWrapper::error(const std::string& messageText) const
+    {
+        m_MessageCallback->message(MessageSeverity::Error, messageText.c_str());
+    }
+
+    bool CommandBundleWrapper::requireOpenState() const
+    {
+        if (m_State == CommandListState::OPEN)
+            return true;
+
+        std::stringstream ss;
+        ss << "A command bundle must be opened before any rendering commands can be recorded. "
+            "Actual state: " << CommandListStateToString(m_State);
+        error(ss.str());
+
+        return false;
+    }
+
+    bool CommandBundleWrapper::requireExecuteState() const
+    {
+        // Unlike command lists, bundles stay closed after execution and can be executed again
+        if (m_State == CommandListState::CLOSED)
+            return true;
+
+        error(m_State == CommandListState::OPEN
+            ? "Cannot execute a command bundle before it is closed"
+            : "Cannot execute a command bundle before it is opened and then closed");
+        return false;
+    }
+
+    bool CommandBundleWrapper::requireGraphicsState(const char* operation) const
+    {
+        if (m_GraphicsStateSet)
+            return true;
+
+        std::stringstream ss;
+        ss << "Graphics state is not set before a " << operation << " call in a command bundle.";
+        error(ss.str());
+        return false;
+    }
+
+    void CommandBundleWrapper::open()
+    {
+        if (m_State == CommandListState::OPEN)
+        {
+            error("Cannot open a command bundle that is already open");
+            return;
+        }
+
+        m_Bundle->open();
+
+        m_State = CommandListState::OPEN;
+        m_GraphicsStateSet = false;
+        m_ViewportStateSet = false;
+        m_CurrentGraphicsState = GraphicsState();
+    }
+
+    void CommandBundleWrapper::close()
+    {
+        if (!requireOpenState())
+            return;
+
+        m_Bundle->close();
+
+        m_State = CommandListState::CLOSED;
+    }
+
+    void CommandBundleWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setGraphicsState in a command bundle: " << std::endl;
+
+        if (!state.pipeline)
+        {
+            ss << "pipeline is NULL." << std::endl;
+            anyErrors = true;
+        }
+
+        if (state.framebuffer != m_Bundle->getDesc().framebuffer)
+        {
+            ss << "The framebuffer must be the one the bundle was created with." << std::endl;
+            anyErrors = true;
+        }
+
+        if (!validateGeometryBuffers(state.vertexBuffers, state.indexBuffer, ss))
+            anyErrors = true;
+
+        if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectParams->getDesc().debugName) << "' as a DrawIndirect argument buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as a DrawIndirect argument buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (state.shadingRateState.enabled)
+        {
+            ss << "Variable rate shading is not supported in command bundles." << std::endl;
+            anyErrors = true;
+        }
+
+        if (m_ViewportStateSet && (arraysAreDifferent(m_CurrentGraphicsState.viewport.viewports, state.viewport.viewports) ||
+            arraysAreDifferent(m_CurrentGraphicsState.viewport.scissorRects, state.viewport.scissorRects)))
+        {
+            ss << "All graphics states in a command bundle must use the same viewports and scissor rects." << std::endl;
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return;
+        }
+
+        if (state.framebuffer->getFramebufferInfoHash() != state.pipeline->getFramebufferInfoHash()
+            || state.framebuffer->getFramebufferInfo() != state.pipeline->getFramebufferInfo())
+        {
+            ss << "The framebuffer used in the draw call does not match the framebuffer used to create the pipeline." << std::endl <<
+                "Formats and sample counts of the framebuffers must match." << std::endl;
+            anyErrors = true;
+        }
+
+        for (const BindingLayoutHandle& layout : state.pipeline->getDesc().bindingLayouts)
+        {
+            const BindingLayoutDesc* layoutDesc = layout->getDesc();
+            if (!layoutDesc)
+                continue;
+
+            for (const BindingLayoutItem& item : layoutDesc->bindings)
+            {
+                if (item.type == ResourceType::VolatileConstantBuffer)
+                {
+                    ss << "The pipeline uses volatile constant buffers, which are not supported in command bundles." << std::endl;
+                    anyErrors = true;
+                    break;
+                }
+            }
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return;
+        }
+
+        m_Bundle->setGraphicsState(state);
+
+        m_GraphicsStateSet = true;
+        m_ViewportStateSet = true;
+        m_CurrentGraphicsState = state;
+    }
+
+    void CommandBundleWrapper::setPushConstants(const void* data, size_t byteSize)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireGraphicsState("setPushConstants"))
+            return;
+
+        if (byteSize > c_MaxPushConstantSize)
+        {
+            std::stringstream ss;
+            ss << "Push constant size (" << byteSize << ") cannot exceed " << c_MaxPushConstantSize << " bytes";
+            error(ss.str());
+            return;
+        }
+
+        m_Bundle->setPushConstants(data, byteSize);
+    }
+
+    void CommandBundleWrapper::draw(const DrawArguments& args)
+    {
+        if (!requireOpenState() || !requireGraphicsState("draw"))
+            return;
+
+        m_Bundle->draw(args);
+    }
+
+    void CommandBundleWrapper::drawIndexed(const DrawArguments& args)
+    {
+        if (!requireOpenState() || !requireGraphicsState("drawIndexed"))
+            return;
+
+        m_Bundle->drawIndexed(args);
+    }
+
+    void CommandBundleWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        if (!requireOpenState() || !requireGraphicsState("drawIndirect"))
+            return;
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndirect call in a command bundle.");
+            return;
+        }
+
+        m_Bundle->drawIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandBundleWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        if (!requireOpenState() || !requireGraphicsState("drawIndexedIndirect"))
+            return;
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndexedIndirect call in a command bundle.");
+            return;
+        }
+
+        m_Bundle->drawIndexedIndirect(offsetBytes, drawCount);
+    }
+
 } // namespace nvrhi::validation
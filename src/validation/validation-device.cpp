@@ -24,20 +24,32 @@
 
 #include <nvrhi/utils.h>
 #include <nvrhi/common/misc.h>
+#include "../common/transient-resource-pool.h"
+#include "../common/readback-ring.h"
+#include "../common/binding-set-cache.h"
+#include "../common/mip-generator.h"
+#include "../common/streaming-uploader.h"
 
+#include <cstring>
 #include <sstream>
 
 namespace nvrhi::validation
 {
     DeviceHandle createValidationLayer(IDevice* underlyingDevice)
     {
-        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        return createValidationLayer(underlyingDevice, ValidationLayerDesc());
+    }
+
+    DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc)
+    {
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice, desc);
         return DeviceHandle::Create(wrapper);
     }
 
-    DeviceWrapper::DeviceWrapper(IDevice* device)
+    DeviceWrapper::DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc)
         : m_Device(device)
         , m_MessageCallback(device->getMessageCallback())
+        , m_Desc(desc)
     {
 
     }
@@ -72,6 +84,83 @@ namespace nvrhi::validation
         return m_Device->createHeap(patchedDesc);
     }
 
+    TransientResourcePoolHandle DeviceWrapper::createTransientResourcePool(const TransientResourcePoolDesc& desc)
+    {
+        if (m_Device->getGraphicsAPI() == GraphicsAPI::D3D11)
+        {
+            error("Transient resource pools are not supported on D3D11");
+            return nullptr;
+        }
+
+        if (desc.heapSize == 0)
+        {
+            error("Cannot create a TransientResourcePool with heapSize = 0");
+            return nullptr;
+        }
+
+        // The pool is created on top of the wrapper, so that the resources and heaps it creates are validated
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(this, desc));
+    }
+
+    StreamingUploaderHandle DeviceWrapper::createStreamingUploader(const StreamingUploaderDesc& desc)
+    {
+        if (desc.queue != CommandQueue::Graphics && desc.queue != CommandQueue::Compute && desc.queue != CommandQueue::Copy)
+        {
+            std::stringstream ss;
+            ss << "Cannot create a StreamingUploader with an invalid queue type (" << uint32_t(desc.queue) << ")";
+            error(ss.str());
+            return nullptr;
+        }
+
+        // The uploader is created on top of the wrapper, so that the writes it records are validated when they are flushed
+        return StreamingUploaderHandle::Create(new StreamingUploader(this, desc));
+    }
+
+    ReadbackRingHandle DeviceWrapper::createReadbackRing(const ReadbackRingDesc& desc)
+    {
+        if (desc.byteSize == 0)
+        {
+            error("Cannot create a ReadbackRing with byteSize = 0");
+            return nullptr;
+        }
+
+        if (desc.numSlots < 2)
+        {
+            std::stringstream ss;
+            ss << "Cannot create a ReadbackRing with numSlots = " << desc.numSlots << ", at least 2 slots are required";
+            error(ss.str());
+            return nullptr;
+        }
+
+        // The ring is created on top of the wrapper, so that its buffers and map calls are validated
+        return ReadbackRing::create(this, desc);
+    }
+
+    BindingSetCacheHandle DeviceWrapper::createBindingSetCache()
+    {
+        // The cache is created on top of the wrapper, so that the binding sets it creates are validated
+        return BindingSetCacheHandle::Create(new BindingSetCache(this));
+    }
+
+    MipGeneratorHandle DeviceWrapper::createMipGenerator()
+    {
+        if (getGraphicsAPI() == GraphicsAPI::D3D11)
+        {
+            error("Mip generators are not supported on D3D11");
+            return nullptr;
+        }
+
+        // The generator is created on top of the wrapper, so that its objects and binding sets are validated
+        MipGeneratorHandle generator = MipGenerator::create(this);
+        if (!generator)
+        {
+            warning("Cannot create a mip generator: NVRHI was built without the mip generation shader for this graphics API, "
+                "or its pipeline could not be created");
+        }
+
+        return generator;
+    }
+
     TextureHandle DeviceWrapper::createTexture(const TextureDesc& d)
     {
         bool anyErrors = false;
@@ -223,6 +312,32 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (d.isTiled && !m_Device->queryFeatureSupport(Feature::TiledResources))
+        {
+            std::stringstream ss;
+            ss << dimensionStr << " " << debugName << ": The device does not support tiled resources";
+            error(ss.str());
+            anyErrors = true;
+        }
+
+        if (d.isTiled && (d.isVirtual || d.sampleCount != 1 || d.sharedResourceFlags != SharedResourceFlags::None))
+        {
+            std::stringstream ss;
+            ss << dimensionStr << " " << debugName << ": tiled textures cannot be virtual, multi-sampled or shared";
+            error(ss.str());
+            anyErrors = true;
+        }
+
+        if (d.isTransient && (!d.isRenderTarget || d.isShaderResource || d.isUAV || d.isShadingRateSurface || d.isVirtual || d.isTiled
+            || d.sharedResourceFlags != SharedResourceFlags::None))
+        {
+            std::stringstream ss;
+            ss << dimensionStr << " " << debugName << ": transient textures must be render targets "
+                "and cannot be shader resources, UAVs, shading rate surfaces, virtual, tiled or shared";
+            error(ss.str());
+            anyErrors = true;
+        }
+
         if (d.keepInitialState && d.initialState == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -290,6 +405,19 @@ namespace nvrhi::validation
             return false;
         }
 
+        const HeapCategory textureCategory = textureDesc.isRenderTarget ? HeapCategory::RenderTargetTextures : HeapCategory::Textures;
+        if (heapDesc.category != HeapCategory::Any && heapDesc.category != textureCategory)
+        {
+            std::stringstream ss;
+            ss << "Cannot bind texture " << utils::DebugNameToString(textureDesc.debugName)
+                << " with isRenderTarget = " << (textureDesc.isRenderTarget ? "true" : "false")
+                << " to heap " << utils::DebugNameToString(heapDesc.debugName)
+                << " because the heap category does not allow it";
+
+            error(ss.str());
+            return false;
+        }
+
         MemoryRequirements memReq = m_Device->getTextureMemoryRequirements(texture);
 
         if (offset + memReq.size > heapDesc.capacity)
@@ -318,6 +446,58 @@ namespace nvrhi::validation
 
         return m_Device->bindTextureMemory(texture, heap, offset);
     }
+
+    bool DeviceWrapper::writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        if (dest == nullptr)
+        {
+            error("writeTextureDirect: dest is NULL");
+            return false;
+        }
+
+        if (data == nullptr)
+        {
+            error("writeTextureDirect: data is NULL");
+            return false;
+        }
+
+        if (!m_Device->queryFeatureSupport(Feature::DirectTextureWrite))
+        {
+            error("writeTextureDirect: the device does not support direct texture writes");
+            return false;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+
+        if (!desc.allowDirectWrite)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform writeTextureDirect on texture " << utils::DebugNameToString(desc.debugName)
+                << " because it was created with allowDirectWrite = false, or its format doesn't support host transfers";
+            error(ss.str());
+            return false;
+        }
+
+        if (!desc.keepInitialState || desc.initialState == ResourceStates::Unknown)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform writeTextureDirect on texture " << utils::DebugNameToString(desc.debugName)
+                << " because it doesn't use keepInitialState with a known initialState, so its layout outside of command lists is undefined";
+            error(ss.str());
+            return false;
+        }
+
+        if (mipLevel >= desc.mipLevels || arraySlice >= desc.arraySize)
+        {
+            std::stringstream ss;
+            ss << "writeTextureDirect: subresource (mip " << mipLevel << ", slice " << arraySlice << ") is out of bounds for texture "
+                << utils::DebugNameToString(desc.debugName) << " with " << desc.mipLevels << " mip levels and " << desc.arraySize << " slices";
+            error(ss.str());
+            return false;
+        }
+
+        return m_Device->writeTextureDirect(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+    }
     
     TextureHandle DeviceWrapper::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
     {
@@ -338,6 +518,11 @@ namespace nvrhi::validation
         return m_Device->mapStagingTexture(tex, slice, cpuAccess, outRowPitch);
     }
 
+    void * DeviceWrapper::tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return m_Device->tryMapStagingTexture(tex, slice, cpuAccess, outRowPitch);
+    }
+
     void DeviceWrapper::unmapStagingTexture(IStagingTexture* tex)
     {
         m_Device->unmapStagingTexture(tex);
@@ -396,6 +581,27 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (d.isTiled && !m_Device->queryFeatureSupport(Feature::TiledResources))
+        {
+            error("The device does not support tiled resources");
+            return nullptr;
+        }
+
+        if (d.isTiled && (d.isVolatile || d.isVirtual || d.cpuAccess != CpuAccessMode::None || d.sharedResourceFlags != SharedResourceFlags::None))
+        {
+            std::stringstream ss;
+            ss << "Tiled buffer " << patchedDesc.debugName << " cannot be volatile, virtual, CPU-accessible or shared";
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (d.preferDeviceLocal && d.cpuAccess != CpuAccessMode::Write)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << patchedDesc.debugName << " has preferDeviceLocal = true, which only applies to buffers with cpuAccess = Write.";
+            warning(ss.str());
+        }
+
         if (d.keepInitialState && d.initialState == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -404,7 +610,135 @@ namespace nvrhi::validation
             return nullptr;
         }
 
-        return m_Device->createBuffer(patchedDesc);
+        if (d.isGpuAddressable && !m_Device->queryFeatureSupport(Feature::GpuVirtualAddress))
+        {
+            error("The device does not support GPU virtual addresses for buffers");
+            return nullptr;
+        }
+
+        if (d.isGpuAddressable && d.isVolatile)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << patchedDesc.debugName << " cannot be both volatile and GPU addressable, "
+                "because volatile buffers move to a new address on every write.";
+            error(ss.str());
+            return nullptr;
+        }
+
+        BufferHandle buffer = m_Device->createBuffer(patchedDesc);
+
+        if (buffer && d.isGpuAddressable && !d.isVirtual)
+            trackGpuAddressableBuffer(buffer);
+
+        return buffer;
+    }
+
+    void DeviceWrapper::trackGpuAddressableBuffer(IBuffer* buffer)
+    {
+        const GpuVirtualAddress address = buffer->getGpuVirtualAddress();
+        const BufferDesc& desc = buffer->getDesc();
+
+        if (address == 0)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(desc.debugName) << " was created with isGpuAddressable = true, "
+                "but getGpuVirtualAddress returned 0";
+            error(ss.str());
+            return;
+        }
+
+        if (!m_Desc.trackGpuVirtualAddresses)
+            return;
+
+        std::lock_guard lockGuard(m_GpuAddressMutex);
+
+        m_GpuAddressableBuffers.push_back(buffer);
+
+        // The GPU can reuse the addresses of a destroyed buffer for a new one, they are valid again
+        const GpuVirtualAddress end = address + desc.byteSize;
+        auto it = m_DestroyedAddressRanges.upper_bound(address);
+        if (it != m_DestroyedAddressRanges.begin() && std::prev(it)->second.end > address)
+            --it;
+        while (it != m_DestroyedAddressRanges.end() && it->first < end)
+            it = m_DestroyedAddressRanges.erase(it);
+
+        m_AnyDestroyedAddressRanges = !m_DestroyedAddressRanges.empty();
+    }
+
+    void DeviceWrapper::retireReleasedGpuAddressableBuffers()
+    {
+        if (!m_Desc.trackGpuVirtualAddresses)
+            return;
+
+        // Bounds the memory used by the ranges of buffers destroyed long ago
+        constexpr size_t c_MaxDestroyedAddressRanges = 4096;
+
+        std::lock_guard lockGuard(m_GpuAddressMutex);
+
+        for (size_t i = 0; i < m_GpuAddressableBuffers.size(); )
+        {
+            IBuffer* buffer = m_GpuAddressableBuffers[i];
+
+            // The reference held by the layer is the last one when the application and all command lists released the buffer
+            buffer->AddRef();
+            if (buffer->Release() > 1)
+            {
+                ++i;
+                continue;
+            }
+
+            const BufferDesc& desc = buffer->getDesc();
+            const GpuVirtualAddress address = buffer->getGpuVirtualAddress();
+
+            DestroyedAddressRange& range = m_DestroyedAddressRanges[address];
+            range.end = address + desc.byteSize;
+            range.debugName = desc.debugName;
+            m_DestroyedAddressOrder.push_back(address);
+
+            m_GpuAddressableBuffers[i] = std::move(m_GpuAddressableBuffers.back());
+            m_GpuAddressableBuffers.pop_back();
+        }
+
+        while (m_DestroyedAddressOrder.size() > c_MaxDestroyedAddressRanges)
+        {
+            m_DestroyedAddressRanges.erase(m_DestroyedAddressOrder.front());
+            m_DestroyedAddressOrder.pop_front();
+        }
+
+        m_AnyDestroyedAddressRanges = !m_DestroyedAddressRanges.empty();
+    }
+
+    bool DeviceWrapper::checkGpuVirtualAddresses(const char* operation, const void* data, size_t dataSize)
+    {
+        if (!m_AnyDestroyedAddressRanges || data == nullptr)
+            return true;
+
+        std::lock_guard lockGuard(m_GpuAddressMutex);
+
+        // Addresses are stored as naturally aligned 64-bit values in structures that shaders read
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t offset = 0; offset + sizeof(GpuVirtualAddress) <= dataSize; offset += sizeof(GpuVirtualAddress))
+        {
+            GpuVirtualAddress value;
+            memcpy(&value, bytes + offset, sizeof(value));
+
+            auto it = m_DestroyedAddressRanges.upper_bound(value);
+            if (it == m_DestroyedAddressRanges.begin())
+                continue;
+
+            --it;
+            if (value >= it->second.end)
+                continue;
+
+            std::stringstream ss;
+            ss << operation << ": the data contains the value 0x" << std::hex << value << std::dec
+                << " at offset " << offset << ", which is a GPU virtual address in buffer "
+                << utils::DebugNameToString(it->second.debugName) << " that has been destroyed";
+            warning(ss.str());
+            return false;
+        }
+
+        return true;
     }
 
     void * DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
@@ -412,6 +746,11 @@ namespace nvrhi::validation
         return m_Device->mapBuffer(b, mapFlags);
     }
 
+    void * DeviceWrapper::tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        return m_Device->tryMapBuffer(b, mapFlags);
+    }
+
     void DeviceWrapper::unmapBuffer(IBuffer* b)
     {
         m_Device->unmapBuffer(b);
@@ -466,6 +805,17 @@ namespace nvrhi::validation
             return false;
         }
 
+        if (heapDesc.category != HeapCategory::Any && heapDesc.category != HeapCategory::Buffers)
+        {
+            std::stringstream ss;
+            ss << "Cannot bind buffer " << utils::DebugNameToString(bufferDesc.debugName)
+                << " to heap " << utils::DebugNameToString(heapDesc.debugName)
+                << " because the heap category does not allow buffers";
+
+            error(ss.str());
+            return false;
+        }
+
         MemoryRequirements memReq = m_Device->getBufferMemoryRequirements(buffer);
 
         if (offset + memReq.size > heapDesc.capacity)
@@ -492,7 +842,187 @@ namespace nvrhi::validation
             return false;
         }
 
-        return m_Device->bindBufferMemory(buffer, heap, offset);
+        if (!m_Device->bindBufferMemory(buffer, heap, offset))
+            return false;
+
+        if (bufferDesc.isGpuAddressable)
+            trackGpuAddressableBuffer(buffer);
+
+        return true;
+    }
+
+    static constexpr uint64_t c_TiledResourceTileSize = 65536;
+
+    void DeviceWrapper::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        if (texture == nullptr)
+        {
+            error("getTextureTiling: texture is NULL");
+            return;
+        }
+
+        if (!texture->getDesc().isTiled)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform getTextureTiling on texture " << utils::DebugNameToString(texture->getDesc().debugName)
+                << " because it was created with isTiled = false";
+            error(ss.str());
+            return;
+        }
+
+        if (subresourceTilingsNum && *subresourceTilingsNum != 0 && !subresourceTilings)
+        {
+            error("getTextureTiling: subresourceTilings is NULL, but *subresourceTilingsNum is not zero");
+            return;
+        }
+
+        m_Device->getTextureTiling(texture, numTiles, desc, tileShape, subresourceTilingsNum, subresourceTilings);
+    }
+
+    void DeviceWrapper::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        if (texture == nullptr)
+        {
+            error("updateTextureTileMappings: texture is NULL");
+            return;
+        }
+
+        const TextureDesc& textureDesc = texture->getDesc();
+
+        if (!textureDesc.isTiled)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform updateTextureTileMappings on texture " << utils::DebugNameToString(textureDesc.debugName)
+                << " because it was created with isTiled = false";
+            error(ss.str());
+            return;
+        }
+
+        for (uint32_t n = 0; n < numTileMappings; ++n)
+        {
+            const TextureTilesMapping& mapping = tileMappings[n];
+
+            if (mapping.numTextureRegions != 0 && (!mapping.tiledTextureCoordinates || !mapping.tiledTextureRegions || (mapping.heap && !mapping.byteOffsets)))
+            {
+                std::stringstream ss;
+                ss << "updateTextureTileMappings: mapping " << n << " has " << mapping.numTextureRegions
+                    << " regions, but its coordinate, region or offset arrays are NULL";
+                error(ss.str());
+                return;
+            }
+
+            for (uint32_t i = 0; i < mapping.numTextureRegions; ++i)
+            {
+                const TiledTextureCoordinate& coordinate = mapping.tiledTextureCoordinates[i];
+
+                if (coordinate.mipLevel >= textureDesc.mipLevels || coordinate.arrayLevel >= textureDesc.arraySize)
+                {
+                    std::stringstream ss;
+                    ss << "updateTextureTileMappings: region " << i << " of mapping " << n << " references mip level " << coordinate.mipLevel
+                        << ", array slice " << coordinate.arrayLevel << " that do not exist in texture " << utils::DebugNameToString(textureDesc.debugName);
+                    error(ss.str());
+                    return;
+                }
+
+                if (mapping.heap && (mapping.byteOffsets[i] % c_TiledResourceTileSize) != 0)
+                {
+                    std::stringstream ss;
+                    ss << "updateTextureTileMappings: region " << i << " of mapping " << n << " has heap offset " << mapping.byteOffsets[i]
+                        << ", which is not a multiple of the tile size (" << c_TiledResourceTileSize << " bytes)";
+                    error(ss.str());
+                    return;
+                }
+            }
+        }
+
+        m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
+    }
+
+    void DeviceWrapper::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        if (buffer == nullptr)
+        {
+            error("updateBufferTileMappings: buffer is NULL");
+            return;
+        }
+
+        const BufferDesc& bufferDesc = buffer->getDesc();
+
+        if (!bufferDesc.isTiled)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform updateBufferTileMappings on buffer " << utils::DebugNameToString(bufferDesc.debugName)
+                << " because it was created with isTiled = false";
+            error(ss.str());
+            return;
+        }
+
+        for (uint32_t n = 0; n < numTileMappings; ++n)
+        {
+            const BufferTilesMapping& mapping = tileMappings[n];
+
+            if ((mapping.bufferOffset % c_TiledResourceTileSize) != 0 || (mapping.byteSize % c_TiledResourceTileSize) != 0
+                || (mapping.heapOffset % c_TiledResourceTileSize) != 0)
+            {
+                std::stringstream ss;
+                ss << "updateBufferTileMappings: mapping " << n << " has an offset or size that is not a multiple of the tile size ("
+                    << c_TiledResourceTileSize << " bytes)";
+                error(ss.str());
+                return;
+            }
+
+            if (mapping.bufferOffset + mapping.byteSize > align(bufferDesc.byteSize, c_TiledResourceTileSize))
+            {
+                std::stringstream ss;
+                ss << "updateBufferTileMappings: mapping " << n << " exceeds the size of buffer " << utils::DebugNameToString(bufferDesc.debugName);
+                error(ss.str());
+                return;
+            }
+
+            if (mapping.heap && mapping.heapOffset + mapping.byteSize > mapping.heap->getDesc().capacity)
+            {
+                std::stringstream ss;
+                ss << "updateBufferTileMappings: mapping " << n << " exceeds the capacity of heap " << utils::DebugNameToString(mapping.heap->getDesc().debugName);
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_Device->updateBufferTileMappings(buffer, tileMappings, numTileMappings, executionQueue);
+    }
+
+    TextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        if (!m_Device->queryFeatureSupport(Feature::SamplerFeedback))
+        {
+            error("createSamplerFeedbackTexture: the device does not support Feature::SamplerFeedback");
+            return nullptr;
+        }
+
+        if (pairedTexture == nullptr)
+        {
+            error("createSamplerFeedbackTexture: pairedTexture is NULL");
+            return nullptr;
+        }
+
+        const TextureDesc& pairedDesc = pairedTexture->getDesc();
+
+        if (pairedDesc.dimension != TextureDimension::Texture2D && pairedDesc.dimension != TextureDimension::Texture2DArray)
+        {
+            std::stringstream ss;
+            ss << "createSamplerFeedbackTexture: paired texture " << utils::DebugNameToString(pairedDesc.debugName)
+                << " must be a Texture2D or Texture2DArray";
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (desc.keepInitialState && desc.initialState == ResourceStates::Unknown)
+        {
+            error("createSamplerFeedbackTexture: initialState = Unknown is incompatible with keepInitialState = true");
+            return nullptr;
+        }
+
+        return m_Device->createSamplerFeedbackTexture(pairedTexture, desc);
     }
 
     BufferHandle DeviceWrapper::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
@@ -535,6 +1065,28 @@ namespace nvrhi::validation
     {
         return m_Device->createShaderLibrary(binary, binarySize);
     }
+
+    ShaderHandle DeviceWrapper::createShaderNoCopy(const ShaderDesc& d, const void* binary, const size_t binarySize, IResource* binaryOwner)
+    {
+        if (binary == nullptr || binarySize == 0)
+        {
+            error("Both 'binary' and 'binarySize' must be non-zero in createShaderNoCopy");
+            return nullptr;
+        }
+
+        return m_Device->createShaderNoCopy(d, binary, binarySize, binaryOwner);
+    }
+
+    nvrhi::ShaderLibraryHandle DeviceWrapper::createShaderLibraryNoCopy(const void* binary, const size_t binarySize, IResource* binaryOwner)
+    {
+        if (binary == nullptr || binarySize == 0)
+        {
+            error("Both 'binary' and 'binarySize' must be non-zero in createShaderLibraryNoCopy");
+            return nullptr;
+        }
+
+        return m_Device->createShaderLibraryNoCopy(binary, binarySize, binaryOwner);
+    }
     
     SamplerHandle DeviceWrapper::createSampler(const SamplerDesc& d)
     {
@@ -576,6 +1128,27 @@ namespace nvrhi::validation
         return m_Device->createTimerQuery();
     }
 
+    QueryPoolHandle DeviceWrapper::createQueryPool(const QueryPoolDesc& desc)
+    {
+        if (desc.count == 0)
+        {
+            error("createQueryPool: count must be nonzero for query pool " + std::string(utils::DebugNameToString(desc.debugName)));
+            return nullptr;
+        }
+
+        const Feature requiredFeature = (desc.type == QueryType::PipelineStatistics)
+            ? Feature::PipelineStatisticsQueries
+            : Feature::OcclusionQueries;
+
+        if (!m_Device->queryFeatureSupport(requiredFeature))
+        {
+            error("createQueryPool: the device does not support queries of the requested type");
+            return nullptr;
+        }
+
+        return m_Device->createQueryPool(desc);
+    }
+
     bool DeviceWrapper::pollTimerQuery(ITimerQuery* query)
     {
         return m_Device->pollTimerQuery(query);
@@ -591,13 +1164,251 @@ namespace nvrhi::validation
         return m_Device->resetTimerQuery(query);
     }
 
-    GraphicsAPI DeviceWrapper::getGraphicsAPI()
-    {
-        return m_Device->getGraphicsAPI();
-    }
+    GpuProfilerHandle DeviceWrapper::createGpuProfiler(const GpuProfilerDesc& desc)
+    {
+        if (desc.maxScopesPerFrame == 0 || desc.maxFramesInFlight == 0)
+        {
+            error("createGpuProfiler: maxScopesPerFrame and maxFramesInFlight must be nonzero");
+            return nullptr;
+        }
+
+        return m_Device->createGpuProfiler(desc);
+    }
+
+    BreadcrumbBufferHandle DeviceWrapper::createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc)
+    {
+        if (desc.numSlots == 0)
+        {
+            error("createBreadcrumbBuffer: numSlots must be nonzero");
+            return nullptr;
+        }
+
+        return m_Device->createBreadcrumbBuffer(desc);
+    }
+
+    CommandSignatureHandle DeviceWrapper::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        std::stringstream errorStream;
+        bool anyErrors = false;
+
+        if (desc.arguments.empty())
+        {
+            error("createCommandSignature: the signature has no arguments");
+            return nullptr;
+        }
+
+        const int numPipelines = (desc.graphicsPipeline ? 1 : 0) + (desc.meshletPipeline ? 1 : 0) + (desc.computePipeline ? 1 : 0);
+        if (numPipelines > 1)
+        {
+            errorStream << "At most one pipeline can be specified" << std::endl;
+            anyErrors = true;
+        }
+
+        uint32_t packedSize = 0;
+        for (size_t index = 0; index < desc.arguments.size(); index++)
+        {
+            const IndirectArgumentDesc& argument = desc.arguments[index];
+            const bool isLast = index == desc.arguments.size() - 1;
+            packedSize += utils::GetIndirectArgumentSize(argument);
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::Draw:
+            case IndirectArgumentType::DrawIndexed:
+            case IndirectArgumentType::Dispatch:
+            case IndirectArgumentType::DispatchMesh:
+                if (!isLast)
+                {
+                    errorStream << "Argument " << index << " is a command, but only the last argument can be one" << std::endl;
+                    anyErrors = true;
+                }
+                break;
+
+            case IndirectArgumentType::VertexBuffer:
+                if (argument.slot >= c_MaxVertexAttributes)
+                {
+                    errorStream << "Argument " << index << " uses vertex buffer slot " << argument.slot << ", which is out of range" << std::endl;
+                    anyErrors = true;
+                }
+                break;
+
+            case IndirectArgumentType::PushConstants:
+                if (argument.size == 0 || (argument.size % 4) != 0 || (argument.offset % 4) != 0 || argument.offset + argument.size > c_MaxPushConstantSize)
+                {
+                    errorStream << "Argument " << index << " has invalid push constant offset (" << argument.offset << ") or size ("
+                        << argument.size << "): both must be multiples of 4 and fit into " << c_MaxPushConstantSize << " bytes" << std::endl;
+                    anyErrors = true;
+                }
+                if (numPipelines == 0)
+                {
+                    errorStream << "Argument " << index << " changes push constants, which requires a pipeline to be specified" << std::endl;
+                    anyErrors = true;
+                }
+                break;
+
+            case IndirectArgumentType::IndexBuffer:
+                break;
+
+            default:
+                errorStream << "Argument " << index << " has an invalid type " << int(argument.type) << std::endl;
+                anyErrors = true;
+                break;
+            }
+
+            if (isLast && !(argument.type == IndirectArgumentType::Draw || argument.type == IndirectArgumentType::DrawIndexed ||
+                argument.type == IndirectArgumentType::Dispatch || argument.type == IndirectArgumentType::DispatchMesh))
+            {
+                errorStream << "The last argument must be a Draw, DrawIndexed, Dispatch or DispatchMesh command" << std::endl;
+                anyErrors = true;
+            }
+        }
+
+        if (desc.byteStride != 0 && (desc.byteStride < packedSize || (desc.byteStride % 4) != 0))
+        {
+            errorStream << "byteStride (" << desc.byteStride << ") must be a multiple of 4 and at least the packed size of the arguments ("
+                << packedSize << ")" << std::endl;
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+        {
+            error("createCommandSignature: " + errorStream.str());
+            return nullptr;
+        }
+
+        return m_Device->createCommandSignature(desc);
+    }
+
+    CommandBundleHandle DeviceWrapper::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (!desc.framebuffer)
+        {
+            error("createCommandBundle: framebuffer is NULL");
+            return nullptr;
+        }
+
+        CommandBundleHandle bundle = m_Device->createCommandBundle(desc);
+        if (!bundle)
+            return nullptr;
+
+        return CommandBundleHandle::Create(new CommandBundleWrapper(m_MessageCallback, bundle));
+    }
+
+    GraphicsAPI DeviceWrapper::getGraphicsAPI()
+    {
+        return m_Device->getGraphicsAPI();
+    }
+
+    FramebufferHandle DeviceWrapper::createFramebuffer(const FramebufferDesc& desc)
+    {
+        bool anyErrors = false;
+
+        for (size_t i = 0; i < desc.colorAttachments.size(); i++)
+        {
+            const FramebufferAttachment& attachment = desc.colorAttachments[i];
+            if (!attachment.valid())
+                continue;
+
+            const TextureDesc& textureDesc = attachment.texture->getDesc();
+
+            if (attachment.storeOp == AttachmentStoreOp::Resolve)
+            {
+                std::stringstream ss;
+                ss << "Color attachment " << i << " (" << utils::DebugNameToString(textureDesc.debugName) << ") uses AttachmentStoreOp::Resolve, but ";
+
+                const Format format = attachment.format == Format::UNKNOWN ? textureDesc.format : attachment.format;
+                const TextureSubresourceSet subresources = attachment.subresources.resolve(textureDesc, true);
+
+                if (!attachment.resolveTexture)
+                {
+                    ss << "resolveTexture is NULL";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+                else if (textureDesc.sampleCount == 1)
+                {
+                    ss << "the attachment texture is not multisampled";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+                else if (getFormatInfo(format).kind == FormatKind::Integer)
+                {
+                    ss << "integer formats cannot be resolved";
+                    error(ss.str());
+                    anyErrors = true;
+                }
+                else
+                {
+                    const TextureDesc& resolveDesc = attachment.resolveTexture->getDesc();
+                    const TextureSubresourceSet resolveSubresources = attachment.resolveSubresources.resolve(resolveDesc, true);
+
+                    if (resolveDesc.sampleCount != 1 || resolveDesc.format != textureDesc.format
+                        || std::max(resolveDesc.width >> resolveSubresources.baseMipLevel, 1u) != std::max(textureDesc.width >> subresources.baseMipLevel, 1u)
+                        || std::max(resolveDesc.height >> resolveSubresources.baseMipLevel, 1u) != std::max(textureDesc.height >> subresources.baseMipLevel, 1u))
+                    {
+                        ss << "resolveTexture " << utils::DebugNameToString(resolveDesc.debugName)
+                            << " must be single-sampled and have the same format and dimensions";
+                        error(ss.str());
+                        anyErrors = true;
+                    }
+                    else if (!resolveDesc.isRenderTarget)
+                    {
+                        ss << "resolveTexture " << utils::DebugNameToString(resolveDesc.debugName) << " is not a render target";
+                        error(ss.str());
+                        anyErrors = true;
+                    }
+                    else if (subresources.numArraySlices != 1 || resolveSubresources.numArraySlices != 1)
+                    {
+                        ss << "resolved attachments must use a single array slice";
+                        error(ss.str());
+                        anyErrors = true;
+                    }
+                }
+            }
+
+            if (textureDesc.isTransient && (attachment.loadOp == AttachmentLoadOp::Load || attachment.storeOp == AttachmentStoreOp::Store))
+            {
+                std::stringstream ss;
+                ss << "Color attachment " << i << " uses transient texture " << utils::DebugNameToString(textureDesc.debugName)
+                    << " with AttachmentLoadOp::Load or AttachmentStoreOp::Store, its contents are not preserved";
+                warning(ss.str());
+            }
+        }
+
+        const FramebufferAttachment& depth = desc.depthAttachment;
+        if (depth.valid())
+        {
+            const TextureDesc& textureDesc = depth.texture->getDesc();
+
+            if (depth.storeOp == AttachmentStoreOp::Resolve)
+            {
+                error("Depth attachments cannot use AttachmentStoreOp::Resolve");
+                anyErrors = true;
+            }
+
+            if (depth.isReadOnly && depth.hasNonDefaultOps())
+            {
+                warning("Read-only depth attachments are always loaded and stored, their load and store ops are ignored");
+            }
+
+            if (textureDesc.isTransient && (depth.loadOp == AttachmentLoadOp::Load || depth.storeOp == AttachmentStoreOp::Store))
+            {
+                std::stringstream ss;
+                ss << "Depth attachment uses transient texture " << utils::DebugNameToString(textureDesc.debugName)
+                    << " with AttachmentLoadOp::Load or AttachmentStoreOp::Store, its contents are not preserved";
+                warning(ss.str());
+            }
+        }
+
+        if (desc.shadingRateAttachment.valid() && desc.shadingRateAttachment.hasNonDefaultOps())
+        {
+            error("Shading rate attachments must use AttachmentLoadOp::Load and AttachmentStoreOp::Store");
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+            return nullptr;
 
-    FramebufferHandle DeviceWrapper::createFramebuffer(const FramebufferDesc& desc)
-    {
         return m_Device->createFramebuffer(desc);
     }
 
@@ -762,6 +1573,27 @@ namespace nvrhi::validation
         std::stringstream ssDuplicateBindings;
         std::stringstream ssOverlappingBindings;
 
+        // Vulkan allows only one push descriptor set layout in a pipeline layout
+        if (m_Device->getGraphicsAPI() == GraphicsAPI::VULKAN && m_Device->queryFeatureSupport(Feature::PushDescriptors))
+        {
+            int numPushDescriptorLayouts = 0;
+            for (const BindingLayoutHandle& bindingLayout : bindingLayouts)
+            {
+                const BindingLayoutDesc* layoutDesc = bindingLayout ? bindingLayout->getDesc() : nullptr;
+                if (layoutDesc && layoutDesc->usePushDescriptors)
+                    ++numPushDescriptorLayouts;
+            }
+
+            if (numPushDescriptorLayouts > 1)
+            {
+                std::stringstream ss;
+                ss << "The pipeline uses " << numPushDescriptorLayouts << " binding layouts with usePushDescriptors = true, "
+                    "only one such layout is allowed per pipeline";
+                error(ss.str());
+                anyErrors = true;
+            }
+        }
+
         for (IShader* shader : shaders)
         {
             ShaderType stage = shader->getDesc().shaderType;
@@ -1025,7 +1857,7 @@ namespace nvrhi::validation
         return true;
     }
 
-    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& pipelineDesc, IFramebuffer* fb)
+    bool DeviceWrapper::validateGraphicsPipelineDesc(const GraphicsPipelineDesc& pipelineDesc, IFramebuffer* fb, const char* function) const
     {
         std::vector<IShader*> shaders;
 
@@ -1036,40 +1868,40 @@ namespace nvrhi::validation
             {
                 shaders.push_back(shader);
 
-                if (!validateShaderType(stage, shader->getDesc(), "createGraphicsPipeline"))
-                    return nullptr;
+                if (!validateShaderType(stage, shader->getDesc(), function))
+                    return false;
             }
         }
 
         if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
-            return nullptr;
+            return false;
 
         if (!validateRenderState(pipelineDesc.renderState, fb))
-            return nullptr;
+            return false;
 
-        return m_Device->createGraphicsPipeline(pipelineDesc, fb);
+        return true;
     }
 
-    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& pipelineDesc)
+    bool DeviceWrapper::validateComputePipelineDesc(const ComputePipelineDesc& pipelineDesc, const char* function) const
     {
         if (!pipelineDesc.CS)
         {
-            error("createComputePipeline: CS = NULL");
-            return nullptr;
+            error(std::string(function) + ": CS = NULL");
+            return false;
         }
 
         std::vector<IShader*> shaders = { pipelineDesc.CS };
         
         if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
-            return nullptr;
+            return false;
 
-        if (!validateShaderType(ShaderType::Compute, pipelineDesc.CS->getDesc(), "createComputePipeline"))
-            return nullptr;
+        if (!validateShaderType(ShaderType::Compute, pipelineDesc.CS->getDesc(), function))
+            return false;
 
-        return m_Device->createComputePipeline(pipelineDesc);
+        return true;
     }
 
-    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& pipelineDesc, IFramebuffer* fb)
+    bool DeviceWrapper::validateMeshletPipelineDesc(const MeshletPipelineDesc& pipelineDesc, IFramebuffer* fb, const char* function) const
     {
         std::vector<IShader*> shaders;
 
@@ -1080,15 +1912,39 @@ namespace nvrhi::validation
             {
                 shaders.push_back(shader);
 
-                if (!validateShaderType(stage, shader->getDesc(), "createMeshletPipeline"))
-                    return nullptr;
+                if (!validateShaderType(stage, shader->getDesc(), function))
+                    return false;
             }
         }
 
         if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
-            return nullptr;
+            return false;
 
         if (!validateRenderState(pipelineDesc.renderState, fb))
+            return false;
+
+        return true;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& pipelineDesc, IFramebuffer* fb)
+    {
+        if (!validateGraphicsPipelineDesc(pipelineDesc, fb, "createGraphicsPipeline"))
+            return nullptr;
+
+        return m_Device->createGraphicsPipeline(pipelineDesc, fb);
+    }
+
+    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& pipelineDesc)
+    {
+        if (!validateComputePipelineDesc(pipelineDesc, "createComputePipeline"))
+            return nullptr;
+
+        return m_Device->createComputePipeline(pipelineDesc);
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& pipelineDesc, IFramebuffer* fb)
+    {
+        if (!validateMeshletPipelineDesc(pipelineDesc, fb, "createMeshletPipeline"))
             return nullptr;
 
         return m_Device->createMeshletPipeline(pipelineDesc, fb);
@@ -1099,6 +1955,86 @@ namespace nvrhi::validation
         return m_Device->createRayTracingPipeline(desc);
     }
 
+    WorkGraphHandle DeviceWrapper::createWorkGraph(const WorkGraphDesc& desc)
+    {
+        if (!m_Device->queryFeatureSupport(Feature::WorkGraphs))
+        {
+            error("createWorkGraph: work graphs are not supported by this device");
+            return nullptr;
+        }
+
+        if (desc.libraries.empty())
+        {
+            error("createWorkGraph: at least one shader library is required");
+            return nullptr;
+        }
+
+        for (const ShaderLibraryHandle& library : desc.libraries)
+        {
+            if (!library)
+            {
+                error("createWorkGraph: WorkGraphDesc::libraries contains a NULL library");
+                return nullptr;
+            }
+        }
+
+        for (const BindingLayoutHandle& bindingLayout : desc.globalBindingLayouts)
+        {
+            if (!bindingLayout)
+            {
+                error("createWorkGraph: WorkGraphDesc::globalBindingLayouts contains a NULL layout");
+                return nullptr;
+            }
+        }
+
+        return m_Device->createWorkGraph(desc);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createGraphicsPipelineAsync(const GraphicsPipelineDesc& pipelineDesc, IFramebuffer* fb)
+    {
+        if (!validateGraphicsPipelineDesc(pipelineDesc, fb, "createGraphicsPipelineAsync"))
+            return nullptr;
+
+        return m_Device->createGraphicsPipelineAsync(pipelineDesc, fb);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createComputePipelineAsync(const ComputePipelineDesc& pipelineDesc)
+    {
+        if (!validateComputePipelineDesc(pipelineDesc, "createComputePipelineAsync"))
+            return nullptr;
+
+        return m_Device->createComputePipelineAsync(pipelineDesc);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createMeshletPipelineAsync(const MeshletPipelineDesc& pipelineDesc, IFramebuffer* fb)
+    {
+        if (!validateMeshletPipelineDesc(pipelineDesc, fb, "createMeshletPipelineAsync"))
+            return nullptr;
+
+        return m_Device->createMeshletPipelineAsync(pipelineDesc, fb);
+    }
+
+    PipelineCreationTaskHandle DeviceWrapper::createRayTracingPipelineAsync(const rt::PipelineDesc& desc)
+    {
+        return m_Device->createRayTracingPipelineAsync(desc);
+    }
+
+    bool DeviceWrapper::loadPipelineCache(const void* data, size_t size)
+    {
+        if (size != 0 && data == nullptr)
+        {
+            error("loadPipelineCache: data is NULL while size is nonzero");
+            return false;
+        }
+
+        return m_Device->loadPipelineCache(data, size);
+    }
+
+    bool DeviceWrapper::savePipelineCache(std::vector<uint8_t>& outData)
+    {
+        return m_Device->savePipelineCache(outData);
+    }
+
     BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
     {
         std::stringstream errorStream;
@@ -1129,11 +2065,31 @@ namespace nvrhi::validation
 
         uint32_t noneItemCount = 0;
         uint32_t pushConstantCount = 0;
+        uint32_t rootDescriptorCount = 0;
         for (const BindingLayoutItem& item : desc.bindings)
         {
             if (item.type == ResourceType::None)
                 noneItemCount++;
 
+            if (item.rootDescriptor)
+            {
+                switch (item.type)
+                {
+                case ResourceType::StructuredBuffer_SRV:
+                case ResourceType::StructuredBuffer_UAV:
+                case ResourceType::RawBuffer_SRV:
+                case ResourceType::RawBuffer_UAV:
+                case ResourceType::ConstantBuffer:
+                    rootDescriptorCount++;
+                    break;
+                default:
+                    errorStream << "Binding layout item at slot " << item.slot << " has type " << utils::ResourceTypeToString(item.type)
+                        << " which cannot be bound through a root descriptor" << std::endl;
+                    anyErrors = true;
+                    break;
+                }
+            }
+
             if (item.type == ResourceType::PushConstants)
             {
                 if (item.size == 0)
@@ -1170,6 +2126,13 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (rootDescriptorCount > c_MaxRootDescriptorsPerLayout)
+        {
+            errorStream << "Binding layout contains too many root descriptors (" << rootDescriptorCount << "), the maximum is "
+                << c_MaxRootDescriptorsPerLayout << std::endl;
+            anyErrors = true;
+        }
+
         const GraphicsAPI graphicsApi = m_Device->getGraphicsAPI();
         if (!(graphicsApi == GraphicsAPI::D3D12 || (graphicsApi == GraphicsAPI::VULKAN && desc.registerSpaceIsDescriptorSet)))
         {
@@ -1201,7 +2164,15 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
-        if (desc.registerSpaces.empty())
+        if (desc.layoutType == BindlessLayoutType::DirectlyIndexed)
+        {
+            if (!m_Device->queryFeatureSupport(Feature::HeapDirectlyIndexed))
+            {
+                errorStream << "Directly indexed bindless layouts are not supported by this device" << std::endl;
+                anyErrors = true;
+            }
+        }
+        else if (desc.registerSpaces.empty())
         {
             errorStream << "Bindless layout has no register spaces assigned" << std::endl;
             anyErrors = true;
@@ -1501,19 +2472,19 @@ namespace nvrhi::validation
         return true;
     }
 
-    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    bool DeviceWrapper::validateBindingSetDesc(const BindingSetDesc& desc, IBindingLayout* layout)
     {
         if (layout == nullptr)
         {
             error("Cannot create a binding set without a valid layout");
-            return nullptr;
+            return false;
         }
 
         const BindingLayoutDesc* layoutDesc = layout->getDesc();
         if (!layoutDesc)
         {
             error("Cannot create a binding set from a bindless layout");
-            return nullptr;
+            return false;
         }
 
         std::stringstream errorStream;
@@ -1590,9 +2561,17 @@ namespace nvrhi::validation
         if (anyErrors)
         {
             error(errorStream.str());
-            return nullptr;
+            return false;
         }
 
+        return true;
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        if (!validateBindingSetDesc(desc, layout))
+            return nullptr;
+
         // Unwrap the resources
         BindingSetDesc patchedDesc = desc;
         for (auto& binding : patchedDesc.bindings)
@@ -1603,6 +2582,53 @@ namespace nvrhi::validation
         return m_Device->createBindingSet(patchedDesc, layout);
     }
 
+    bool DeviceWrapper::createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets)
+    {
+        if (count == 0)
+            return true;
+
+        if (!descs || !outBindingSets)
+        {
+            error("createBindingSets: 'descs' and 'outBindingSets' must not be NULL when 'count' is nonzero");
+            return false;
+        }
+
+        // Validate and unwrap each desc, and only pass the valid ones to the device so that they are still created as a batch
+        std::vector<BindingSetDesc> patchedDescs;
+        std::vector<size_t> patchedIndices;
+        patchedDescs.reserve(count);
+        patchedIndices.reserve(count);
+
+        for (size_t index = 0; index < count; index++)
+        {
+            outBindingSets[index] = nullptr;
+
+            if (!validateBindingSetDesc(descs[index], layout))
+                continue;
+
+            BindingSetDesc& patchedDesc = patchedDescs.emplace_back(descs[index]);
+            for (auto& binding : patchedDesc.bindings)
+            {
+                binding.resourceHandle = unwrapResource(binding.resourceHandle);
+            }
+
+            patchedIndices.push_back(index);
+        }
+
+        if (patchedDescs.empty())
+            return false;
+
+        std::vector<BindingSetHandle> bindingSets(patchedDescs.size());
+        bool success = m_Device->createBindingSets(patchedDescs.data(), patchedDescs.size(), layout, bindingSets.data());
+
+        for (size_t index = 0; index < bindingSets.size(); index++)
+        {
+            outBindingSets[patchedIndices[index]] = std::move(bindingSets[index]);
+        }
+
+        return success && patchedDescs.size() == count;
+    }
+
     DescriptorTableHandle DeviceWrapper::createDescriptorTable(IBindingLayout* layout)
     {
         if (!layout->getBindlessDesc()) 
@@ -1685,6 +2711,24 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (desc.persistentInstanceBuffer && !desc.isTopLevel)
+        {
+            std::stringstream ss;
+            ss << "Cannot create BLAS " << utils::DebugNameToString(desc.debugName)
+                << " with persistentInstanceBuffer = true: the persistent instance buffer is only supported for TLAS'es";
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (desc.allowSuballocation && (desc.isTopLevel || desc.isVirtual))
+        {
+            std::stringstream ss;
+            ss << "Cannot create AccelStruct " << utils::DebugNameToString(desc.debugName)
+                << " with allowSuballocation = true: suballocation is only supported for non-virtual BLAS'es";
+            error(ss.str());
+            return nullptr;
+        }
+
         AccelStructWrapper* wrapper = new AccelStructWrapper(as);
         wrapper->isTopLevel = desc.isTopLevel;
         wrapper->allowUpdate = !!(desc.buildFlags & rt::AccelStructBuildFlags::AllowUpdate);
@@ -1856,7 +2900,16 @@ namespace nvrhi::validation
                 unwrappedCommandLists[i] = pCommandLists[i];
         }
 
-        return m_Device->executeCommandLists(unwrappedCommandLists.data(), unwrappedCommandLists.size(), executionQueue);
+        retireReleasedGpuAddressableBuffers();
+
+        const uint64_t instance = m_Device->executeCommandLists(unwrappedCommandLists.data(), unwrappedCommandLists.size(), executionQueue);
+
+        // Concurrent submissions to a queue may return here out of order, keep the maximum
+        std::atomic<uint64_t>& lastSubmittedInstance = m_LastSubmittedInstances[size_t(executionQueue)];
+        uint64_t previous = lastSubmittedInstance.load();
+        while (previous < instance && !lastSubmittedInstance.compare_exchange_weak(previous, instance)) { }
+
+        return instance;
     }
 
     void DeviceWrapper::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance)
@@ -1869,11 +2922,123 @@ namespace nvrhi::validation
         m_Device->waitForIdle();
     }
 
+    bool DeviceWrapper::validateSubmissionPoints(const char* function, const SubmissionPoint* submissions, size_t count) const
+    {
+        if (count == 0)
+            return true;
+
+        if (submissions == nullptr)
+        {
+            std::stringstream ss;
+            ss << function << ": submissions is NULL while count is " << count;
+            error(ss.str());
+            return false;
+        }
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const SubmissionPoint& submission = submissions[index];
+
+            if (submission.queue >= CommandQueue::Count)
+            {
+                std::stringstream ss;
+                ss << function << ": submissions[" << index << "] uses an invalid queue " << uint32_t(submission.queue);
+                error(ss.str());
+                return false;
+            }
+
+            const uint64_t lastSubmittedInstance = m_LastSubmittedInstances[size_t(submission.queue)].load();
+            if (submission.instance > lastSubmittedInstance)
+            {
+                std::stringstream ss;
+                ss << function << ": submissions[" << index << "] refers to instance " << submission.instance
+                    << " of the " << utils::CommandQueueToString(submission.queue) << " queue, which has not been submitted yet"
+                    << " (the last submitted instance is " << lastSubmittedInstance << ")";
+                error(ss.str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t DeviceWrapper::getCompletedInstance(CommandQueue queue)
+    {
+        if (queue >= CommandQueue::Count)
+        {
+            std::stringstream ss;
+            ss << "getCompletedInstance: invalid queue " << uint32_t(queue);
+            error(ss.str());
+            return 0;
+        }
+
+        return m_Device->getCompletedInstance(queue);
+    }
+
+    bool DeviceWrapper::waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        if (!validateSubmissionPoints("waitForAll", submissions, count))
+            return false;
+
+        return m_Device->waitForAll(submissions, count, timeout);
+    }
+
+    size_t DeviceWrapper::waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        if (!validateSubmissionPoints("waitForAny", submissions, count))
+            return count;
+
+        return m_Device->waitForAny(submissions, count, timeout);
+    }
+
+    void DeviceWrapper::notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        if (!callback)
+        {
+            error("notifyOnCompletion: callback is empty");
+            return;
+        }
+
+        if (!validateSubmissionPoints("notifyOnCompletion", submissions, count))
+            return;
+
+        m_Device->notifyOnCompletion(submissions, count, waitAny, std::move(callback));
+    }
+
     void DeviceWrapper::runGarbageCollection()
     {
+        retireReleasedGpuAddressableBuffers();
+
         m_Device->runGarbageCollection();
     }
 
+    bool DeviceWrapper::runGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        retireReleasedGpuAddressableBuffers();
+
+        return m_Device->runGarbageCollection(budget);
+    }
+
+    void DeviceWrapper::setUploadPoolSettings(const UploadPoolSettings& settings)
+    {
+        m_Device->setUploadPoolSettings(settings);
+    }
+
+    UploadPoolStatistics DeviceWrapper::getUploadPoolStatistics()
+    {
+        return m_Device->getUploadPoolStatistics();
+    }
+
+    bool DeviceWrapper::queryMemoryBudget(MemoryBudget& outBudget)
+    {
+        return m_Device->queryMemoryBudget(outBudget);
+    }
+
+    CommandListStatistics DeviceWrapper::getCommandListStatistics(bool reset)
+    {
+        return m_Device->getCommandListStatistics(reset);
+    }
+
     bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
     {
         return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
@@ -20,10 +20,325 @@
 * DEALINGS IN THE SOFTWARE.
 */
 
+
 #include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
 
 namespace nvrhi::vulkan
 {
+    static uint32_t bitScanReverse(uint64_t value)
+    {
+        assert(value != 0);
+        uint32_t index = 0;
+        while (value >>= 1)
+            ++index;
+        return index;
+    }
+
+    static uint32_t bitScanForward(uint64_t value)
+    {
+        assert(value != 0);
+        uint32_t index = 0;
+        while ((value & 1) == 0)
+        {
+            value >>= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    // A single vk::DeviceMemory object that is sub-allocated with a two-level segregated fit (TLSF) allocator.
+    // Free ranges are kept in size-class lists indexed by [log2(size)][next 4 bits of size], and the non-empty lists
+    // are tracked in bitmasks, so both allocation and deallocation are O(1). Adjacent free ranges are always merged.
+    class MemoryBlock
+    {
+    public:
+        static constexpr uint32_t c_InvalidNode = ~0u;
+
+        vk::DeviceMemory memory;
+        vk::DeviceSize size = 0;
+        void* mappedMemory = nullptr;
+        uint32_t memoryTypeIndex = 0;
+        uint32_t poolKind = 0;
+
+        uint32_t allocationCount = 0;
+        vk::DeviceSize allocatedBytes = 0;
+
+        explicit MemoryBlock(vk::DeviceSize blockSize);
+
+        bool allocate(vk::DeviceSize allocationSize, vk::DeviceSize alignment, vk::DeviceSize& outOffset, uint32_t& outNode);
+        void free(uint32_t nodeIndex);
+
+        void getFreeRangeStatistics(uint32_t& outCount, uint64_t& outLargest) const;
+
+    private:
+        static constexpr uint32_t c_SecondLevelLog2 = 4;
+        static constexpr uint32_t c_SecondLevelCount = 1u << c_SecondLevelLog2;
+        static constexpr uint32_t c_FirstLevelCount = 64;
+
+        struct Node
+        {
+            vk::DeviceSize offset = 0;
+            vk::DeviceSize size = 0;
+            uint32_t prevPhysical = c_InvalidNode;
+            uint32_t nextPhysical = c_InvalidNode;
+            uint32_t prevFree = c_InvalidNode;
+            uint32_t nextFree = c_InvalidNode;
+            bool isFree = false;
+        };
+
+        std::vector<Node> m_Nodes;
+        std::vector<uint32_t> m_UnusedNodes;
+
+        uint64_t m_FirstLevelMask = 0;
+        uint32_t m_SecondLevelMasks[c_FirstLevelCount] = {};
+        uint32_t m_FreeLists[c_FirstLevelCount][c_SecondLevelCount];
+
+        static void mapSize(vk::DeviceSize size, uint32_t& fl, uint32_t& sl);
+
+        uint32_t createNode();
+        void releaseNode(uint32_t nodeIndex);
+        void insertFree(uint32_t nodeIndex);
+        void removeFree(uint32_t nodeIndex);
+    };
+
+    MemoryBlock::MemoryBlock(vk::DeviceSize blockSize)
+        : size(blockSize)
+    {
+        for (auto& lists : m_FreeLists)
+            for (uint32_t& head : lists)
+                head = c_InvalidNode;
+
+        const uint32_t root = createNode();
+        m_Nodes[root].offset = 0;
+        m_Nodes[root].size = blockSize;
+        insertFree(root);
+    }
+
+    void MemoryBlock::mapSize(vk::DeviceSize size, uint32_t& fl, uint32_t& sl)
+    {
+        if (size < c_SecondLevelCount)
+        {
+            fl = 0;
+            sl = uint32_t(size);
+        }
+        else
+        {
+            const uint32_t msb = bitScanReverse(size);
+            fl = msb - c_SecondLevelLog2 + 1;
+            sl = uint32_t(size >> (msb - c_SecondLevelLog2)) - c_SecondLevelCount;
+        }
+    }
+
+    uint32_t MemoryBlock::createNode()
+    {
+        if (!m_UnusedNodes.empty())
+        {
+            const uint32_t index = m_UnusedNodes.back();
+            m_UnusedNodes.pop_back();
+            m_Nodes[index] = Node();
+            return index;
+        }
+
+        m_Nodes.emplace_back();
+        return uint32_t(m_Nodes.size() - 1);
+    }
+
+    void MemoryBlock::releaseNode(uint32_t nodeIndex)
+    {
+        m_UnusedNodes.push_back(nodeIndex);
+    }
+
+    void MemoryBlock::insertFree(uint32_t nodeIndex)
+    {
+        Node& node = m_Nodes[nodeIndex];
+        uint32_t fl, sl;
+        mapSize(node.size, fl, sl);
+
+        const uint32_t head = m_FreeLists[fl][sl];
+        node.isFree = true;
+        node.prevFree = c_InvalidNode;
+        node.nextFree = head;
+        if (head != c_InvalidNode)
+            m_Nodes[head].prevFree = nodeIndex;
+
+        m_FreeLists[fl][sl] = nodeIndex;
+        m_FirstLevelMask |= 1ull << fl;
+        m_SecondLevelMasks[fl] |= 1u << sl;
+    }
+
+    void MemoryBlock::removeFree(uint32_t nodeIndex)
+    {
+        Node& node = m_Nodes[nodeIndex];
+        uint32_t fl, sl;
+        mapSize(node.size, fl, sl);
+
+        if (node.prevFree != c_InvalidNode)
+            m_Nodes[node.prevFree].nextFree = node.nextFree;
+        else
+            m_FreeLists[fl][sl] = node.nextFree;
+
+        if (node.nextFree != c_InvalidNode)
+            m_Nodes[node.nextFree].prevFree = node.prevFree;
+
+        if (m_FreeLists[fl][sl] == c_InvalidNode)
+        {
+            m_SecondLevelMasks[fl] &= ~(1u << sl);
+            if (m_SecondLevelMasks[fl] == 0)
+                m_FirstLevelMask &= ~(1ull << fl);
+        }
+
+        node.isFree = false;
+        node.prevFree = c_InvalidNode;
+        node.nextFree = c_InvalidNode;
+    }
+
+    bool MemoryBlock::allocate(vk::DeviceSize allocationSize, vk::DeviceSize alignment, vk::DeviceSize& outOffset, uint32_t& outNode)
+    {
+        if (allocationSize == 0 || allocationSize > size)
+            return false;
+
+        // Reserve room for the worst-case alignment padding, then round the size up to the next size class
+        // so that any range in the selected list is guaranteed to be large enough ("good fit").
+        vk::DeviceSize searchSize = allocationSize + (alignment > 1 ? alignment - 1 : 0);
+        if (searchSize >= c_SecondLevelCount)
+            searchSize += (vk::DeviceSize(1) << (bitScanReverse(searchSize) - c_SecondLevelLog2)) - 1;
+
+        uint32_t fl, sl;
+        mapSize(searchSize, fl, sl);
+        if (fl >= c_FirstLevelCount)
+            return false;
+
+        uint32_t slMask = m_SecondLevelMasks[fl] & (~0u << sl);
+        if (!slMask)
+        {
+            const uint64_t flMask = (fl + 1 < c_FirstLevelCount) ? (m_FirstLevelMask & (~0ull << (fl + 1))) : 0;
+            if (!flMask)
+                return false;
+
+            fl = bitScanForward(flMask);
+            slMask = m_SecondLevelMasks[fl];
+        }
+        sl = bitScanForward(slMask);
+
+        const uint32_t nodeIndex = m_FreeLists[fl][sl];
+        assert(nodeIndex != c_InvalidNode);
+        removeFree(nodeIndex);
+
+        const vk::DeviceSize alignedOffset = align(m_Nodes[nodeIndex].offset, alignment);
+        const vk::DeviceSize padding = alignedOffset - m_Nodes[nodeIndex].offset;
+        assert(m_Nodes[nodeIndex].size >= padding + allocationSize);
+
+        if (padding > 0)
+        {
+            // The previous physical neighbor is never free (free ranges are always merged), so the padding becomes a separate free range
+            const uint32_t paddingIndex = createNode();
+            Node& paddingNode = m_Nodes[paddingIndex];
+            Node& node = m_Nodes[nodeIndex];
+
+            paddingNode.offset = node.offset;
+            paddingNode.size = padding;
+            paddingNode.prevPhysical = node.prevPhysical;
+            paddingNode.nextPhysical = nodeIndex;
+            if (node.prevPhysical != c_InvalidNode)
+                m_Nodes[node.prevPhysical].nextPhysical = paddingIndex;
+
+            node.prevPhysical = paddingIndex;
+            node.offset = alignedOffset;
+            node.size -= padding;
+            insertFree(paddingIndex);
+        }
+
+        if (m_Nodes[nodeIndex].size > allocationSize)
+        {
+            const uint32_t tailIndex = createNode();
+            Node& tailNode = m_Nodes[tailIndex];
+            Node& node = m_Nodes[nodeIndex];
+
+            tailNode.offset = node.offset + allocationSize;
+            tailNode.size = node.size - allocationSize;
+            tailNode.prevPhysical = nodeIndex;
+            tailNode.nextPhysical = node.nextPhysical;
+            if (node.nextPhysical != c_InvalidNode)
+                m_Nodes[node.nextPhysical].prevPhysical = tailIndex;
+
+            node.nextPhysical = tailIndex;
+            node.size = allocationSize;
+            insertFree(tailIndex);
+        }
+
+        ++allocationCount;
+        allocatedBytes += allocationSize;
+
+        outOffset = alignedOffset;
+        outNode = nodeIndex;
+        return true;
+    }
+
+    void MemoryBlock::free(uint32_t nodeIndex)
+    {
+        assert(nodeIndex < m_Nodes.size());
+        assert(!m_Nodes[nodeIndex].isFree);
+
+        --allocationCount;
+        allocatedBytes -= m_Nodes[nodeIndex].size;
+
+        const uint32_t prevIndex = m_Nodes[nodeIndex].prevPhysical;
+        if (prevIndex != c_InvalidNode && m_Nodes[prevIndex].isFree)
+        {
+            removeFree(prevIndex);
+
+            Node& prev = m_Nodes[prevIndex];
+            const Node& node = m_Nodes[nodeIndex];
+            prev.size += node.size;
+            prev.nextPhysical = node.nextPhysical;
+            if (node.nextPhysical != c_InvalidNode)
+                m_Nodes[node.nextPhysical].prevPhysical = prevIndex;
+
+            releaseNode(nodeIndex);
+            nodeIndex = prevIndex;
+        }
+
+        const uint32_t nextIndex = m_Nodes[nodeIndex].nextPhysical;
+        if (nextIndex != c_InvalidNode && m_Nodes[nextIndex].isFree)
+        {
+            removeFree(nextIndex);
+
+            Node& node = m_Nodes[nodeIndex];
+            const Node& next = m_Nodes[nextIndex];
+            node.size += next.size;
+            node.nextPhysical = next.nextPhysical;
+            if (next.nextPhysical != c_InvalidNode)
+                m_Nodes[next.nextPhysical].prevPhysical = nodeIndex;
+
+            releaseNode(nextIndex);
+        }
+
+        insertFree(nodeIndex);
+    }
+
+    void MemoryBlock::getFreeRangeStatistics(uint32_t& outCount, uint64_t& outLargest) const
+    {
+        uint64_t flMask = m_FirstLevelMask;
+        while (flMask)
+        {
+            const uint32_t fl = bitScanForward(flMask);
+            flMask &= flMask - 1;
+
+            uint64_t slMask = m_SecondLevelMasks[fl];
+            while (slMask)
+            {
+                const uint32_t sl = bitScanForward(slMask);
+                slMask &= slMask - 1;
+
+                for (uint32_t nodeIndex = m_FreeLists[fl][sl]; nodeIndex != c_InvalidNode; nodeIndex = m_Nodes[nodeIndex].nextFree)
+                {
+                    ++outCount;
+                    outLargest = std::max(outLargest, uint64_t(m_Nodes[nodeIndex].size));
+                }
+            }
+        }
+    }
 
     static vk::MemoryPropertyFlags pickBufferMemoryProperties(const BufferDesc& d)
     {
@@ -45,38 +360,184 @@ namespace nvrhi::vulkan
         return flags;
     }
 
-    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress) const
+    VulkanAllocator::VulkanAllocator(const VulkanContext& context, uint64_t blockSize)
+        : m_Context(context)
+        , m_BlockSize(blockSize)
     {
-        // figure out memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getBufferMemoryRequirements(buffer->buffer, &memRequirements);
+        m_Context.physicalDevice.getMemoryProperties(&m_MemoryProperties);
 
-        // allocate memory
+        // Without Resizable BAR, the host-visible part of video memory is limited to a 256 MB window
+        // that the driver also uses internally, so don't place application buffers there.
+        constexpr uint64_t legacyBarSize = 256ull * 1024 * 1024;
+        constexpr vk::MemoryPropertyFlags deviceLocalUploadFlags = vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible;
+        for (uint32_t memTypeIndex = 0; memTypeIndex < m_MemoryProperties.memoryTypeCount; memTypeIndex++)
+        {
+            const vk::MemoryType& memType = m_MemoryProperties.memoryTypes[memTypeIndex];
+            if ((memType.propertyFlags & deviceLocalUploadFlags) == deviceLocalUploadFlags
+                && m_MemoryProperties.memoryHeaps[memType.heapIndex].size > legacyBarSize)
+            {
+                m_DeviceLocalUploadMemoryAvailable = true;
+                break;
+            }
+        }
+    }
+
+    VulkanAllocator::~VulkanAllocator()
+    {
+        for (auto& pools : m_Pools)
+        {
+            for (Pool& pool : pools)
+            {
+                for (const auto& block : pool.blocks)
+                {
+                    // Any remaining sub-allocations belong to resources that were leaked past the device lifetime
+                    assert(block->allocationCount == 0);
+
+                    if (block->mappedMemory)
+                        m_Context.device.unmapMemory(block->memory);
+
+                    m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+                }
+                pool.blocks.clear();
+            }
+        }
+    }
+
+    bool VulkanAllocator::findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags, uint32_t& outMemTypeIndex) const
+    {
+        for (uint32_t memTypeIndex = 0; memTypeIndex < m_MemoryProperties.memoryTypeCount; memTypeIndex++)
+        {
+            if ((memoryTypeBits & (1 << memTypeIndex)) &&
+                ((m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
+            {
+                outMemTypeIndex = memTypeIndex;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint64_t VulkanAllocator::getBlockSizeForMemoryType(uint32_t memTypeIndex) const
+    {
+        // Don't let a single block take a large portion of a small heap, such as the 256 MB BAR heap on some systems
+        const uint32_t heapIndex = m_MemoryProperties.memoryTypes[memTypeIndex].heapIndex;
+        const uint64_t heapSize = m_MemoryProperties.memoryHeaps[heapIndex].size;
+
+        return std::min(m_BlockSize, heapSize / 8);
+    }
+
+    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress)
+    {
+        // figure out memory requirements, including whether the driver wants a dedicated allocation
+        auto memRequirementsInfo = vk::BufferMemoryRequirementsInfo2().setBuffer(buffer->buffer);
+        const auto memRequirementsChain = m_Context.device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(memRequirementsInfo);
+        const vk::MemoryRequirements& memRequirements = memRequirementsChain.get<vk::MemoryRequirements2>().memoryRequirements;
+        const vk::MemoryDedicatedRequirements& dedicatedRequirements = memRequirementsChain.get<vk::MemoryDedicatedRequirements>();
+
+        const vk::MemoryPropertyFlags memProperties = pickBufferMemoryProperties(buffer->desc);
         const bool enableMemoryExport = (buffer->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(buffer, memRequirements, pickBufferMemoryProperties(buffer->desc), enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
-        CHECK_VK_RETURN(res)
+        const ResidencyPriority priority = buffer->desc.residencyPriority;
+        // Memory priorities apply to whole allocations, so buffers with a non-default priority don't share blocks
+        const bool needDedicated = enableMemoryExport
+            || (priority != ResidencyPriority::Normal && m_Context.extensions.EXT_memory_priority)
+            || dedicatedRequirements.requiresDedicatedAllocation
+            || dedicatedRequirements.prefersDedicatedAllocation;
 
-        m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, 0);
+        // Upload buffers that prefer device-local memory try the ReBAR memory first and fall back
+        // to regular host-visible memory when it's not available or exhausted
+        vk::MemoryPropertyFlags candidateProperties[2] = { memProperties, memProperties };
+        uint32_t numCandidates = 1;
+        if (buffer->desc.cpuAccess == CpuAccessMode::Write && buffer->desc.preferDeviceLocal && m_DeviceLocalUploadMemoryAvailable)
+        {
+            candidateProperties[0] |= vk::MemoryPropertyFlagBits::eDeviceLocal;
+            numCandidates = 2;
+        }
 
-        return vk::Result::eSuccess;
+        vk::Result res = vk::Result::eErrorOutOfDeviceMemory;
+        for (uint32_t candidate = 0; candidate < numCandidates; ++candidate)
+        {
+            const vk::MemoryPropertyFlags candidateFlags = candidateProperties[candidate];
+            const bool isDeviceLocalUpload = candidate == 0 && numCandidates > 1;
+
+            uint32_t memTypeIndex;
+            if (!needDedicated && m_BlockSize != 0 && findMemoryType(memRequirements.memoryTypeBits, candidateFlags, memTypeIndex)
+                && memRequirements.size <= getBlockSizeForMemoryType(memTypeIndex) / 2)
+            {
+                // Buffer blocks are allocated with the device address flag when the feature is enabled, so any buffer can live in them
+                assert(!enableDeviceAddress || m_Context.extensions.buffer_device_address);
+
+                if (suballocate(buffer, memRequirements, memTypeIndex, PoolKind::Buffer) == vk::Result::eSuccess)
+                {
+                    m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, buffer->memoryOffset);
+                    buffer->desc.preferDeviceLocal = isDeviceLocalUpload;
+                    return vk::Result::eSuccess;
+                }
+
+                // Creating a new block failed - try a dedicated allocation of just the required size below
+            }
+
+            res = allocateMemory(buffer, memRequirements, candidateFlags, enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer, priority);
+            if (res == vk::Result::eSuccess)
+            {
+                m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, 0);
+                buffer->desc.preferDeviceLocal = isDeviceLocalUpload;
+                return vk::Result::eSuccess;
+            }
+        }
+
+        return res;
     }
 
-    void VulkanAllocator::freeBufferMemory(Buffer *buffer) const
+    void VulkanAllocator::freeBufferMemory(Buffer *buffer)
     {
-        freeMemory(buffer);
+        if (buffer->memoryBlock)
+            freeSuballocation(buffer);
+        else
+            freeMemory(buffer);
     }
 
-    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture) const
+    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture)
     {
-        // grab the image memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getImageMemoryRequirements(texture->image, &memRequirements);
+        // grab the image memory requirements, including whether the driver wants a dedicated allocation
+        auto memRequirementsInfo = vk::ImageMemoryRequirementsInfo2().setImage(texture->image);
+        const auto memRequirementsChain = m_Context.device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(memRequirementsInfo);
+        const vk::MemoryRequirements& memRequirements = memRequirementsChain.get<vk::MemoryRequirements2>().memoryRequirements;
+        const vk::MemoryDedicatedRequirements& dedicatedRequirements = memRequirementsChain.get<vk::MemoryDedicatedRequirements>();
 
-        // allocate memory
-        const vk::MemoryPropertyFlags memProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+        vk::MemoryPropertyFlags memProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
         const bool enableDeviceAddress = false;
         const bool enableMemoryExport = (texture->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(texture, memRequirements, memProperties, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
+
+        uint32_t memTypeIndex;
+
+        // Transient attachments go into lazily allocated memory when the device has it, mostly on tiled GPUs,
+        // so that physical pages are only committed if the attachment contents ever leave the on-chip memory.
+        // Such allocations are never suballocated from the shared blocks.
+        const vk::MemoryPropertyFlags lazyProperties = memProperties | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+        const bool lazilyAllocated = texture->desc.isTransient
+            && findMemoryType(memRequirements.memoryTypeBits, lazyProperties, memTypeIndex);
+        if (lazilyAllocated)
+            memProperties = lazyProperties;
+
+        const ResidencyPriority priority = texture->desc.residencyPriority;
+        const bool needDedicated = enableMemoryExport
+            || lazilyAllocated
+            || (priority != ResidencyPriority::Normal && m_Context.extensions.EXT_memory_priority)
+            || dedicatedRequirements.requiresDedicatedAllocation
+            || dedicatedRequirements.prefersDedicatedAllocation;
+
+        if (!needDedicated && m_BlockSize != 0 && findMemoryType(memRequirements.memoryTypeBits, memProperties, memTypeIndex)
+            && memRequirements.size <= getBlockSizeForMemoryType(memTypeIndex) / 2)
+        {
+            if (suballocate(texture, memRequirements, memTypeIndex, PoolKind::Image) == vk::Result::eSuccess)
+            {
+                m_Context.device.bindImageMemory(texture->image, texture->memory, texture->memoryOffset);
+                return vk::Result::eSuccess;
+            }
+        }
+
+        const vk::Result res = allocateMemory(texture, memRequirements, memProperties, enableDeviceAddress, enableMemoryExport, texture->image, nullptr, priority);
         CHECK_VK_RETURN(res)
 
         m_Context.device.bindImageMemory(texture->image, texture->memory, 0);
@@ -84,9 +545,126 @@ namespace nvrhi::vulkan
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeTextureMemory(Texture *texture) const
+    void VulkanAllocator::freeTextureMemory(Texture *texture)
     {
-        freeMemory(texture);
+        if (texture->memoryBlock)
+            freeSuballocation(texture);
+        else
+            freeMemory(texture);
+    }
+
+    vk::Result VulkanAllocator::suballocate(MemoryResource* res, const vk::MemoryRequirements& memRequirements,
+        uint32_t memTypeIndex, PoolKind kind)
+    {
+        const vk::MemoryPropertyFlags typeFlags = m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags;
+        const bool hostVisible = !!(typeFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+        const bool hostCoherent = !!(typeFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+
+        vk::DeviceSize size = memRequirements.size;
+        vk::DeviceSize alignment = memRequirements.alignment;
+
+        if (hostVisible && !hostCoherent)
+        {
+            // Keep flush/invalidate ranges of neighboring resources from overlapping
+            const vk::DeviceSize atomSize = m_Context.physicalDeviceProperties.limits.nonCoherentAtomSize;
+            alignment = std::max(alignment, atomSize);
+            size = align(size, atomSize);
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        Pool& pool = m_Pools[memTypeIndex][uint32_t(kind)];
+
+        for (const auto& block : pool.blocks)
+        {
+            if (block->allocate(size, alignment, res->memoryOffset, res->memoryNode))
+            {
+                res->managed = true;
+                res->memory = block->memory;
+                res->memoryBlock = block.get();
+                res->hostCoherent = !hostVisible || hostCoherent;
+                return vk::Result::eSuccess;
+            }
+        }
+
+        // No block has enough space, create a new one
+        auto block = std::make_unique<MemoryBlock>(getBlockSizeForMemoryType(memTypeIndex));
+        block->memoryTypeIndex = memTypeIndex;
+        block->poolKind = uint32_t(kind);
+
+        auto allocFlags = vk::MemoryAllocateFlagsInfo();
+        if (kind == PoolKind::Buffer && m_Context.extensions.buffer_device_address)
+            allocFlags.flags |= vk::MemoryAllocateFlagBits::eDeviceAddress;
+
+        auto allocInfo = vk::MemoryAllocateInfo()
+            .setAllocationSize(block->size)
+            .setMemoryTypeIndex(memTypeIndex)
+            .setPNext(&allocFlags);
+
+        vk::Result result = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &block->memory);
+        if (result != vk::Result::eSuccess)
+            return result;
+
+        m_Context.nameVKObject(block->memory, vk::DebugReportObjectTypeEXT::eDeviceMemory, "NVRHI Memory Block");
+
+        if (hostVisible)
+        {
+            // Persistently map the whole block: a memory object can only be mapped once at a time
+            result = m_Context.device.mapMemory(block->memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &block->mappedMemory);
+            if (result != vk::Result::eSuccess)
+            {
+                m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+                return result;
+            }
+        }
+
+        [[maybe_unused]] const bool allocated = block->allocate(size, alignment, res->memoryOffset, res->memoryNode);
+        assert(allocated);
+
+        res->managed = true;
+        res->memory = block->memory;
+        res->memoryBlock = block.get();
+        res->hostCoherent = !hostVisible || hostCoherent;
+        pool.blocks.push_back(std::move(block));
+
+        return vk::Result::eSuccess;
+    }
+
+    void VulkanAllocator::freeSuballocation(MemoryResource* res)
+    {
+        assert(res->managed);
+        assert(res->memoryBlock);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        MemoryBlock* block = res->memoryBlock;
+        block->free(res->memoryNode);
+
+        res->memory = vk::DeviceMemory(nullptr);
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->memoryNode = 0;
+
+        if (block->allocationCount != 0)
+            return;
+
+        // Release empty blocks, but keep the last one in each pool to avoid reallocating it on every create/destroy cycle
+        Pool& pool = m_Pools[block->memoryTypeIndex][block->poolKind];
+        if (pool.blocks.size() <= 1)
+            return;
+
+        for (auto it = pool.blocks.begin(); it != pool.blocks.end(); ++it)
+        {
+            if (it->get() == block)
+            {
+                if (block->mappedMemory)
+                    m_Context.device.unmapMemory(block->memory);
+
+                m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+                pool.blocks.erase(it);
+                break;
+            }
+        }
     }
 
     vk::Result VulkanAllocator::allocateMemory(MemoryResource *res,
@@ -95,25 +673,18 @@ namespace nvrhi::vulkan
                                                 bool enableDeviceAddress,
                                                 bool enableExportMemory,
                                                 VkImage dedicatedImage,
-                                                VkBuffer dedicatedBuffer) const
+                                                VkBuffer dedicatedBuffer,
+                                                ResidencyPriority priority)
     {
         res->managed = true;
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->persistentMapping = nullptr;
+        res->hostCoherent = true;
 
         // find a memory space that satisfies the requirements
-        vk::PhysicalDeviceMemoryProperties memProperties;
-        m_Context.physicalDevice.getMemoryProperties(&memProperties);
-
         uint32_t memTypeIndex;
-        for(memTypeIndex = 0; memTypeIndex < memProperties.memoryTypeCount; memTypeIndex++)
-        {
-            if ((memRequirements.memoryTypeBits & (1 << memTypeIndex)) &&
-                ((memProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
-            {
-                break;
-            }
-        }
-
-        if (memTypeIndex == memProperties.memoryTypeCount)
+        if (!findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags, memTypeIndex))
         {
             // xxxnsubtil: this is incorrect; need better error reporting
             return vk::Result::eErrorOutOfDeviceMemory;
@@ -151,20 +722,150 @@ namespace nvrhi::vulkan
             pNext = &exportInfo;
         }
 
+        auto priorityInfo = vk::MemoryPriorityAllocateInfoEXT()
+            .setPriority(convertResidencyPriority(priority))
+            .setPNext(pNext);
+
+        if (m_Context.extensions.EXT_memory_priority && priority != ResidencyPriority::Normal)
+        {
+            // Append the VkMemoryPriorityAllocateInfoEXT structure to the chain
+            pNext = &priorityInfo;
+        }
+
         auto allocInfo = vk::MemoryAllocateInfo()
                             .setAllocationSize(memRequirements.size)
                             .setMemoryTypeIndex(memTypeIndex)
                             .setPNext(pNext);
 
-        return m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+        const vk::Result result = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+
+        if (result == vk::Result::eSuccess)
+        {
+            const vk::MemoryPropertyFlags typeFlags = m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags;
+            if (typeFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+            {
+                res->hostCoherent = !!(typeFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+
+                // Map the allocation once and keep it mapped, so that mapBuffer doesn't call into the driver.
+                // If that fails, e.g. due to running out of address space, mapMemory falls back to vkMapMemory.
+                if (m_Context.device.mapMemory(res->memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &res->persistentMapping) != vk::Result::eSuccess)
+                    res->persistentMapping = nullptr;
+            }
+
+            std::lock_guard lockGuard(m_Mutex);
+            m_DedicatedAllocationCount += 1;
+            m_DedicatedAllocationBytes += memRequirements.size;
+            res->memorySize = memRequirements.size;
+        }
+
+        return result;
     }
 
-    void VulkanAllocator::freeMemory(MemoryResource *res) const
+    void VulkanAllocator::freeMemory(MemoryResource *res)
     {
         assert(res->managed);
+        assert(!res->memoryBlock);
+
+        if (res->persistentMapping)
+        {
+            m_Context.device.unmapMemory(res->memory);
+            res->persistentMapping = nullptr;
+        }
 
         m_Context.device.freeMemory(res->memory, m_Context.allocationCallbacks);
         res->memory = vk::DeviceMemory(nullptr);
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_DedicatedAllocationCount -= 1;
+        m_DedicatedAllocationBytes -= res->memorySize;
+        res->memorySize = 0;
+    }
+
+    void* VulkanAllocator::mapMemory(MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const
+    {
+        if (res->memoryBlock)
+        {
+            if (!res->memoryBlock->mappedMemory)
+                return nullptr;
+
+            return static_cast<char*>(res->memoryBlock->mappedMemory) + res->memoryOffset + offset;
+        }
+
+        if (res->persistentMapping)
+            return static_cast<char*>(res->persistentMapping) + offset;
+
+        void* ptr = nullptr;
+        const vk::Result result = m_Context.device.mapMemory(res->memory, offset, size, vk::MemoryMapFlags(), &ptr);
+        if (result != vk::Result::eSuccess)
+            return nullptr;
+
+        return ptr;
+    }
+
+    void VulkanAllocator::unmapMemory(MemoryResource* res) const
+    {
+        // Blocks and persistently mapped allocations stay mapped for their whole lifetime
+        if (!res->memoryBlock && !res->persistentMapping)
+            m_Context.device.unmapMemory(res->memory);
+    }
+
+    vk::MappedMemoryRange VulkanAllocator::getMappedMemoryRange(const MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const
+    {
+        const vk::DeviceSize atomSize = std::max(m_Context.physicalDeviceProperties.limits.nonCoherentAtomSize, vk::DeviceSize(1));
+        const vk::DeviceSize memorySize = res->memoryBlock ? res->memoryBlock->size : res->memorySize;
+
+        const vk::DeviceSize begin = (res->memoryOffset + offset) / atomSize * atomSize;
+        const vk::DeviceSize end = align(res->memoryOffset + offset + size, atomSize);
+
+        return vk::MappedMemoryRange()
+            .setMemory(res->memory)
+            .setOffset(begin)
+            .setSize(end >= memorySize ? VK_WHOLE_SIZE : end - begin);
+    }
+
+    void VulkanAllocator::flushMappedMemory(const MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const
+    {
+        if (res->hostCoherent || size == 0)
+            return;
+
+        const vk::MappedMemoryRange range = getMappedMemoryRange(res, offset, size);
+        m_Context.device.flushMappedMemoryRanges(range);
+    }
+
+    void VulkanAllocator::invalidateMappedMemory(const MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const
+    {
+        if (res->hostCoherent || size == 0)
+            return;
+
+        const vk::MappedMemoryRange range = getMappedMemoryRange(res, offset, size);
+        m_Context.device.invalidateMappedMemoryRanges(range);
+    }
+
+    MemoryAllocatorStatistics VulkanAllocator::getStatistics() const
+    {
+        MemoryAllocatorStatistics stats;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const auto& pools : m_Pools)
+        {
+            for (const Pool& pool : pools)
+            {
+                for (const auto& block : pool.blocks)
+                {
+                    stats.blockCount += 1;
+                    stats.blockBytes += block->size;
+                    stats.suballocationCount += block->allocationCount;
+                    stats.suballocatedBytes += block->allocatedBytes;
+                    block->getFreeRangeStatistics(stats.freeRangeCount, stats.largestFreeRange);
+                }
+            }
+        }
+
+        stats.dedicatedAllocationCount = m_DedicatedAllocationCount;
+        stats.dedicatedAllocationBytes = m_DedicatedAllocationBytes;
+
+        return stats;
     }
 
 } // namespace nvrhi::vulkan
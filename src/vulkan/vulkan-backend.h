@@ -26,8 +26,22 @@
 #include <nvrhi/utils.h>
 #include "../common/state-tracking.h"
 #include "../common/versioning.h"
+#include "../common/pipeline-creation-task.h"
+#include "../common/gpu-profiler.h"
+#include "../common/referenced-resources.h"
+#include "../common/gc-budget.h"
+#include "../common/pointer-map.h"
+#include "../common/submission-callbacks.h"
+#include "../common/upload-page-pool.h"
+#include "../common/accel-struct-pool.h"
+#include "../common/binding-set-cache.h"
+#include "../common/sampler-cache.h"
+#include <atomic>
 #include <mutex>
+#include <shared_mutex>
 #include <list>
+#include <map>
+#include <memory>
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
@@ -36,8 +50,15 @@
 #include <rtxmu/VkAccelStructManager.h>
 #endif
 
-#if (VK_HEADER_VERSION < 230)
-#error "Vulkan SDK version 1.3.230 or later is required to compile NVRHI"
+#if (VK_HEADER_VERSION < 235)
+#error "Vulkan SDK version 1.3.235 or later is required to compile NVRHI"
+#endif
+
+// VK_EXT_host_image_copy is only available in Vulkan headers 1.3.258 or newer
+#if defined(VK_EXT_host_image_copy)
+#define NVRHI_VULKAN_WITH_HOST_IMAGE_COPY (1)
+#else
+#define NVRHI_VULKAN_WITH_HOST_IMAGE_COPY (0)
 #endif
 
 namespace std
@@ -69,6 +90,7 @@ namespace nvrhi::vulkan
     class Shader;
     class Sampler;
     class Framebuffer;
+    class DescriptorBufferHeap;
     class GraphicsPipeline;
     class ComputePipeline;
     class BindingSet;
@@ -76,6 +98,7 @@ namespace nvrhi::vulkan
     class TimerQuery;
     class Marker;
     class Device;
+    class CommandBundle;
 
     struct ResourceStateMapping
     {
@@ -107,6 +130,8 @@ namespace nvrhi::vulkan
     vk::CullModeFlagBits convertCullMode(RasterCullMode mode);
     vk::CompareOp convertCompareOp(ComparisonFunc op);
     vk::StencilOp convertStencilOp(StencilOp op);
+    vk::AttachmentLoadOp convertAttachmentLoadOp(AttachmentLoadOp op);
+    vk::AttachmentStoreOp convertAttachmentStoreOp(AttachmentStoreOp op);
     vk::StencilOpState convertStencilState(const DepthStencilState& depthStencilState, const DepthStencilState::StencilOpDesc& desc);
     vk::BlendFactor convertBlendValue(BlendFactor value);
     vk::BlendOp convertBlendOp(BlendOp op);
@@ -116,6 +141,7 @@ namespace nvrhi::vulkan
     vk::GeometryInstanceFlagsKHR convertInstanceFlags(rt::InstanceFlags instanceFlags);
     vk::Extent2D convertFragmentShadingRate(VariableShadingRate shadingRate);
     vk::FragmentShadingRateCombinerOpKHR convertShadingRateCombiner(ShadingRateCombiner combiner);
+    float convertResidencyPriority(ResidencyPriority priority);
 
     void countSpecializationConstants(
         Shader* shader,
@@ -163,17 +189,31 @@ namespace nvrhi::vulkan
             bool EXT_debug_report = false;
             bool EXT_debug_marker = false;
             bool KHR_acceleration_structure = false;
+            bool KHR_deferred_host_operations = false;
             bool buffer_device_address = false; // either KHR_ or Vulkan 1.2 versions
+            bool draw_indirect_count = false; // either KHR_ or Vulkan 1.2 versions
+            bool dynamic_rendering = false; // either KHR_ or Vulkan 1.3 versions
             bool KHR_ray_query = false;
             bool KHR_ray_tracing_pipeline = false;
             bool NV_mesh_shader = false;
+            bool EXT_mesh_shader = false; // preferred over NV_mesh_shader when both are enabled
             bool KHR_fragment_shading_rate = false;
             bool EXT_conservative_rasterization = false;
             bool EXT_opacity_micromap = false;
             bool NV_ray_tracing_invocation_reorder = false;
+            bool KHR_push_descriptor = false;
+            bool EXT_descriptor_buffer = false;
+            bool KHR_pipeline_library = false;
+            bool EXT_graphics_pipeline_library = false;
+            bool EXT_memory_budget = false;
+            bool EXT_memory_priority = false; // the memoryPriority feature must also be enabled
+            bool AMD_buffer_marker = false;
+            bool EXT_host_image_copy = false; // the hostImageCopy feature must also be enabled
+            bool EXT_conditional_rendering = false; // the conditionalRendering feature must also be enabled
         } extensions;
 
         vk::PhysicalDeviceProperties physicalDeviceProperties;
+        vk::PhysicalDeviceFeatures physicalDeviceFeatures;
         vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingPipelineProperties;
         vk::PhysicalDeviceAccelerationStructurePropertiesKHR accelStructProperties;
         vk::PhysicalDeviceConservativeRasterizationPropertiesEXT conservativeRasterizationProperties;
@@ -181,7 +221,12 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceOpacityMicromapPropertiesEXT opacityMicromapProperties;
         vk::PhysicalDeviceRayTracingInvocationReorderPropertiesNV nvRayTracingInvocationReorderProperties;
         vk::PhysicalDeviceFragmentShadingRateFeaturesKHR shadingRateFeatures;
+        vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties;
+        vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
         IMessageCallback* messageCallback = nullptr;
+
+        // Owned by the device, only set when binding sets and descriptor tables live in a descriptor buffer
+        DescriptorBufferHeap* descriptorBufferHeap = nullptr;
 #ifdef NVRHI_WITH_RTXMU
         std::unique_ptr<rtxmu::VkAccelStructManager> rtxMemUtil;
         std::unique_ptr<RtxMuResources> rtxMuResources;
@@ -192,6 +237,8 @@ namespace nvrhi::vulkan
         void warning(const std::string& message) const;
     };
 
+    class CommandPoolBlock;
+
     // command buffer with resource tracking
     class TrackedCommandBuffer
     {
@@ -199,11 +246,17 @@ namespace nvrhi::vulkan
 
         // the command buffer itself
         vk::CommandBuffer cmdBuf = vk::CommandBuffer();
-        vk::CommandPool cmdPool = vk::CommandPool();
 
-        std::vector<RefCountPtr<IResource>> referencedResources; // to keep them alive
+        // the pool that the command buffer is allocated from, owned by the queue
+        CommandPoolBlock* block = nullptr;
+
+        ReferencedResources referencedResources; // to keep them alive
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers; // to allow synchronous mapBuffer
 
+        // events used for split barriers, reused across recordings of this command buffer
+        std::vector<vk::Event> events;
+        size_t numEventsUsed = 0;
+
         uint64_t recordingID = 0;
         uint64_t submissionID = 0;
 
@@ -217,6 +270,9 @@ namespace nvrhi::vulkan
         { }
 
         ~TrackedCommandBuffer();
+
+        // returns an unsignaled event, or a null handle if the event couldn't be created
+        vk::Event acquireEvent();
     
     private:
         const VulkanContext& m_Context;
@@ -224,7 +280,38 @@ namespace nvrhi::vulkan
 
     typedef std::shared_ptr<TrackedCommandBuffer> TrackedCommandBufferPtr;
 
+    // A command pool used by a single recording thread during one frame. All of its command buffers
+    // are reset at once with vkResetCommandPool when the pool is reused, after every one of them has retired.
+    class CommandPoolBlock
+    {
+    public:
+        vk::CommandPool cmdPool = vk::CommandPool();
+
+        // command buffers allocated from cmdPool, the first numUsed of them are taken in the current use of the pool
+        std::vector<TrackedCommandBufferPtr> commandBuffers;
+        size_t numUsed = 0;
+
+        // frame in which the pool was last taken into use, see Queue::retireCommandBuffers
+        uint64_t frameIndex = 0;
+
+        // command buffers taken from this pool and not retired yet, decremented by the thread that retires them
+        std::atomic<uint32_t> numPending = 0;
+    };
+
+    // The command pools of one recording thread on one queue. Only that thread accesses the blocks,
+    // until it exits and the queue reclaims them, see Queue::reclaimThreadCommandPools.
+    struct ThreadCommandPools
+    {
+        std::vector<std::unique_ptr<CommandPoolBlock>> blocks;
+        CommandPoolBlock* current = nullptr;
+
+        // set from the thread-local cache destructor when the recording thread exits
+        std::atomic<bool> threadExited = false;
+    };
+
     // represents a hardware queue
+    // Submissions to different queues are independent: each queue serializes its own submission state and vkQueueSubmit calls
+    // with m_SubmissionMutex, and command buffer acquisition doesn't take that lock.
     class Queue
     {
     public:
@@ -233,84 +320,208 @@ namespace nvrhi::vulkan
         Queue(const VulkanContext& context, CommandQueue queueID, vk::Queue queue, uint32_t queueFamilyIndex);
         ~Queue();
 
-        // creates a command buffer and its synchronization resources
-        TrackedCommandBufferPtr createCommandBuffer();
-
+        // Returns a command buffer from the calling thread's pool for the current frame, without locking
+        // except for the first call on each thread. Command buffers from one pool must not be recorded concurrently,
+        // so a command list should be recorded on the thread that opened it.
         TrackedCommandBufferPtr getOrCreateCommandBuffer();
 
+        // Gives back a command buffer from getOrCreateCommandBuffer that won't be submitted, e.g. when a command list
+        // is reopened or destroyed without being executed. May be called from any thread.
+        void releaseCommandBuffer(const TrackedCommandBufferPtr& cmdBuf);
+
         void addWaitSemaphore(vk::Semaphore semaphore, uint64_t value);
         void addSignalSemaphore(vk::Semaphore semaphore, uint64_t value);
 
         // submits a command buffer to this queue, returns submissionID
-        uint64_t submit(ICommandList* const* ppCmd, size_t numCmd);
+        // the prologue, if provided, is an internal command buffer that executes before the command lists
+        uint64_t submit(ICommandList* const* ppCmd, size_t numCmd, const TrackedCommandBufferPtr& prologue = nullptr);
+
+        // with deferred submissions, submit() only queues the work, and flushSubmissions() makes one submit call for all of it
+        void setDeferSubmissions(bool value) { m_DeferSubmissions = value; }
+        void flushSubmissions();
 
-        // retire any command buffers that have finished execution from the pending execution list
-        void retireCommandBuffers();
+        // submits a sparse binding operation ordered with the other submissions to this queue, returns submissionID
+        uint64_t bindSparse(vk::BindSparseInfo bindInfo);
+
+        // retire any command buffers that have finished execution from the pending execution list,
+        // returns false if the budget ran out before all of them were retired
+        bool retireCommandBuffers(GarbageCollectionBudgetTracker& budget);
 
         TrackedCommandBufferPtr getCommandBufferInFlight(uint64_t submissionID);
 
         uint64_t updateLastFinishedID();
-        uint64_t getLastSubmittedID() const { return m_LastSubmittedID; }
-        uint64_t getLastFinishedID() const { return m_LastFinishedID; }
+        uint64_t getLastSubmittedID() const { return m_LastSubmittedID.load(std::memory_order_acquire); }
+        uint64_t getLastFinishedID() const { return m_LastFinishedID.load(std::memory_order_acquire); }
         CommandQueue getQueueID() const { return m_QueueID; }
         vk::Queue getVkQueue() const { return m_Queue; }
+        uint32_t getQueueFamilyIndex() const { return m_QueueFamilyIndex; }
+        bool supportsSparseBinding() const { return m_SupportsSparseBinding; }
 
         bool pollCommandList(uint64_t commandListID);
         bool waitCommandList(uint64_t commandListID, uint64_t timeout);
 
+        // returns the statistics of the command lists submitted to this queue, optionally resetting them
+        CommandListStatistics getStatistics(bool reset);
+
     private:
         const VulkanContext& m_Context;
 
         vk::Queue m_Queue;
         CommandQueue m_QueueID;
         uint32_t m_QueueFamilyIndex = uint32_t(-1);
+        bool m_SupportsSparseBinding = false;
 
+        // protects m_ThreadCommandPools
         std::mutex m_Mutex;
+
+        // protects everything that submit() touches, and the VkQueue itself, which requires external synchronization
+        std::mutex m_SubmissionMutex;
         std::vector<vk::Semaphore> m_WaitSemaphores;
         std::vector<uint64_t> m_WaitSemaphoreValues;
         std::vector<vk::Semaphore> m_SignalSemaphores;
         std::vector<uint64_t> m_SignalSemaphoreValues;
 
-        uint64_t m_LastRecordingID = 0;
-        uint64_t m_LastSubmittedID = 0;
-        uint64_t m_LastFinishedID = 0;
+        struct Submission
+        {
+            std::vector<vk::CommandBuffer> commandBuffers;
+            std::vector<vk::Semaphore> waitSemaphores;
+            std::vector<uint64_t> waitSemaphoreValues;
+            std::vector<vk::Semaphore> signalSemaphores;
+            std::vector<uint64_t> signalSemaphoreValues;
+        };
 
-        // tracks the list of command buffers in flight on this queue
+        bool m_DeferSubmissions = false;
+        std::vector<Submission> m_PendingSubmissions;
+
+        CommandListStatistics m_Statistics;
+
+        void submitBatches(const Submission* submissions, size_t numSubmissions);
+        void flushSubmissionsLocked();
+
+        // identifies the queue in the per-thread pool caches, never reused by another queue
+        uint64_t m_UniqueID = 0;
+
+        std::atomic<uint64_t> m_LastRecordingID = 0;
+        std::atomic<uint64_t> m_FrameIndex = 0;
+        // written under m_SubmissionMutex, but read without it
+        std::atomic<uint64_t> m_LastSubmittedID = 0;
+        std::atomic<uint64_t> m_LastFinishedID = 0;
+
+        // tracks the list of command buffers in flight on this queue (protected by m_SubmissionMutex)
         std::list<TrackedCommandBufferPtr> m_CommandBuffersInFlight;
-        std::list<TrackedCommandBufferPtr> m_CommandBuffersPool;
+
+        // per-thread command pools, one entry is added on the first getOrCreateCommandBuffer call of each thread
+        // and removed after that thread exits (protected by m_Mutex). Shared with the thread-local caches.
+        std::vector<std::shared_ptr<ThreadCommandPools>> m_ThreadCommandPools;
+
+        ThreadCommandPools& getThreadCommandPools();
+        void reclaimThreadCommandPools();
+        std::unique_ptr<CommandPoolBlock> createCommandPoolBlock();
+        TrackedCommandBufferPtr allocateCommandBuffer(CommandPoolBlock* block);
     };
 
+    class MemoryBlock;
+
     class MemoryResource
     {
     public:
         bool managed = true;
         vk::DeviceMemory memory;
+
+        // When the resource is placed into a shared memory block, 'memory' is the block's memory object,
+        // 'memoryOffset' is the offset of the resource within it, and 'memoryBlock'/'memoryNode' identify the sub-allocation.
+        // Dedicated allocations have memoryBlock == nullptr and memoryOffset == 0, and 'memorySize' is the size of the allocation.
+        vk::DeviceSize memoryOffset = 0;
+        vk::DeviceSize memorySize = 0;
+        MemoryBlock* memoryBlock = nullptr;
+        uint32_t memoryNode = 0;
+
+        // Host-visible dedicated allocations are mapped once when they are created and stay mapped until freed,
+        // this is the CPU address of the start of the allocation. Sub-allocations use the block's mapping instead.
+        void* persistentMapping = nullptr;
+
+        // False when the memory is host-visible but not host-coherent, which means that CPU writes
+        // need a flush and GPU writes need an invalidate, see VulkanAllocator::flush/invalidateMappedMemory.
+        bool hostCoherent = true;
     };
 
     class VulkanAllocator
     {
     public:
-        explicit VulkanAllocator(const VulkanContext& context)
-            : m_Context(context)
-        { }
+        explicit VulkanAllocator(const VulkanContext& context, uint64_t blockSize = c_DefaultBlockSize);
+        ~VulkanAllocator();
 
-        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false) const;
-        void freeBufferMemory(Buffer* buffer) const;
+        VulkanAllocator(const VulkanAllocator&) = delete;
+        VulkanAllocator& operator=(const VulkanAllocator&) = delete;
 
-        vk::Result allocateTextureMemory(Texture* texture) const;
-        void freeTextureMemory(Texture* texture) const;
+        static constexpr uint64_t c_DefaultBlockSize = 64ull * 1024 * 1024;
 
+        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false);
+        void freeBufferMemory(Buffer* buffer);
+
+        vk::Result allocateTextureMemory(Texture* texture);
+        void freeTextureMemory(Texture* texture);
+
+        // Always creates a dedicated vk::DeviceMemory object, used for heaps and exportable resources
         vk::Result allocateMemory(MemoryResource* res,
             vk::MemoryRequirements memRequirements,
             vk::MemoryPropertyFlags memPropertyFlags,
             bool enableDeviceAddress = false,
             bool enableExportMemory = false,
             VkImage dedicatedImage = nullptr,
-            VkBuffer dedicatedBuffer = nullptr) const;
-        void freeMemory(MemoryResource* res) const;
+            VkBuffer dedicatedBuffer = nullptr,
+            ResidencyPriority priority = ResidencyPriority::Normal);
+        void freeMemory(MemoryResource* res);
+
+        // Returns a CPU pointer to the resource memory at 'offset'. All host-visible memory allocated here
+        // is persistently mapped, so mapping is free and mapping several resources from one block is legal.
+        void* mapMemory(MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const;
+        void unmapMemory(MemoryResource* res) const;
+
+        // Builds a range for vkFlush/InvalidateMappedMemoryRanges that is aligned to nonCoherentAtomSize
+        vk::MappedMemoryRange getMappedMemoryRange(const MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const;
+
+        // Make CPU writes to a mapped range visible to the device, or device writes visible to the CPU.
+        // Both are no-ops for host-coherent memory.
+        void flushMappedMemory(const MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const;
+        void invalidateMappedMemory(const MemoryResource* res, vk::DeviceSize offset, vk::DeviceSize size) const;
+
+        MemoryAllocatorStatistics getStatistics() const;
+
+        // Returns true when there is a DEVICE_LOCAL | HOST_VISIBLE memory type that is larger than
+        // the legacy 256 MB BAR window, i.e. Resizable BAR is enabled or the device has unified memory.
+        [[nodiscard]] bool isDeviceLocalUploadMemoryAvailable() const { return m_DeviceLocalUploadMemoryAvailable; }
 
     private:
+        enum class PoolKind : uint32_t
+        {
+            Buffer = 0,
+            Image = 1,
+            Count
+        };
+
+        struct Pool
+        {
+            std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        };
+
         const VulkanContext& m_Context;
+        uint64_t m_BlockSize;
+        vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+        bool m_DeviceLocalUploadMemoryAvailable = false;
+
+        // Buffers and optimal-tiling images are kept in separate pools so that bufferImageGranularity never applies
+        Pool m_Pools[VK_MAX_MEMORY_TYPES][uint32_t(PoolKind::Count)];
+        mutable std::mutex m_Mutex;
+
+        uint32_t m_DedicatedAllocationCount = 0;
+        uint64_t m_DedicatedAllocationBytes = 0;
+
+        bool findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags, uint32_t& outMemTypeIndex) const;
+        uint64_t getBlockSizeForMemoryType(uint32_t memTypeIndex) const;
+        vk::Result suballocate(MemoryResource* res, const vk::MemoryRequirements& memRequirements,
+            uint32_t memTypeIndex, PoolKind kind);
+        void freeSuballocation(MemoryResource* res);
     };
 
     class Heap : public MemoryResource, public RefCounter<IHeap>
@@ -400,8 +611,14 @@ namespace nvrhi::vulkan
 
         void* sharedHandle = nullptr;
 
+        // The queue that executed the last submitted command list using this texture, and the state that command list left it in.
+        // ownerQueue == Count means that the texture hasn't been used yet. See Device::transferQueueOwnership.
+        CommandQueue ownerQueue = CommandQueue::Count;
+        TextureState ownerState;
+
         // contains subresource views for this texture
         // note that we only create the views that the app uses, and that multiple views may map to the same subresources
+        // views that match getFastSubresourceViewIndex(...) live in m_FastSubresourceViews instead (protected by m_Mutex)
         std::unordered_map<SubresourceViewKey, TextureSubresourceView, Texture::Hash> subresourceViews;
 
         Texture(const VulkanContext& context, VulkanAllocator& allocator)
@@ -425,9 +642,20 @@ namespace nvrhi::vulkan
         Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override;
 
     private:
+        // Views of all mips, or of a single one of the first c_MaxFastSubresourceViewMips mips, covering all array slices
+        // with the texture's own format and dimension are looked up without locking, see getSubresourceView()
+        static constexpr uint32_t c_MaxFastSubresourceViewMips = 16;
+        static constexpr uint32_t c_NumFastSubresourceViews = 3 * (c_MaxFastSubresourceViewMips + 1); // x TextureSubresourceViewType
+
+        int getFastSubresourceViewIndex(const TextureSubresourceSet& subresources, TextureDimension dimension,
+            Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype) const;
+        void createSubresourceView(TextureSubresourceView& view, const TextureSubresourceSet& subresources, TextureDimension dimension,
+            Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype);
+
         const VulkanContext& m_Context;
         VulkanAllocator& m_Allocator;
-        std::mutex m_Mutex;
+        std::shared_mutex m_Mutex;
+        std::atomic<TextureSubresourceView*> m_FastSubresourceViews[c_NumFastSubresourceViews] = {};
     };
 
     /* ----------------------------------------------------------------------------
@@ -548,10 +776,19 @@ namespace nvrhi::vulkan
         void* sharedHandle = nullptr;
         uint32_t versionSearchStart = 0;
 
+        // The queue that executed the last submitted command list using this buffer, or Count if it hasn't been used yet.
+        // See Device::transferQueueOwnership.
+        CommandQueue ownerQueue = CommandQueue::Count;
+
         // For staging buffers only
         CommandQueue lastUseQueue = CommandQueue::Graphics;
         uint64_t lastUseCommandListID = 0;
 
+        // The range and access mode of the current mapBuffer call, used to flush CPU writes on unmapBuffer
+        CpuAccessMode mappedAccess = CpuAccessMode::None;
+        uint64_t mappedRangeOffset = 0;
+        uint64_t mappedRangeSize = 0;
+
         Buffer(const VulkanContext& context, VulkanAllocator& allocator)
             : BufferStateExtension(desc)
             , m_Context(context)
@@ -560,6 +797,8 @@ namespace nvrhi::vulkan
 
         ~Buffer() override;
         const BufferDesc& getDesc() const override { return desc; }
+        // Volatile buffers have one address per version, so there is no single address for the buffer
+        GpuVirtualAddress getGpuVirtualAddress() const override { return desc.isVolatile ? 0 : deviceAddress; }
         Object getNativeObject(ObjectType type) override;
 
     private:
@@ -599,7 +838,7 @@ namespace nvrhi::vulkan
         const TextureDesc& getDesc() const override { return desc; }
     };
 
-    class Sampler : public RefCounter<ISampler>
+    class Sampler : public WeakCachedRefCounter<ISampler>
     {
     public:
         SamplerDesc desc;
@@ -607,8 +846,9 @@ namespace nvrhi::vulkan
         vk::SamplerCreateInfo samplerInfo;
         vk::Sampler sampler;
 
-        explicit Sampler(const VulkanContext& context)
+        Sampler(const VulkanContext& context, SamplerCache<Sampler>& cache)
             : m_Context(context)
+            , m_Cache(cache)
         { }
 
         ~Sampler() override;
@@ -617,6 +857,7 @@ namespace nvrhi::vulkan
 
     private:
         const VulkanContext& m_Context;
+        SamplerCache<Sampler>& m_Cache;
     };
 
     class Shader : public RefCounter<IShader>
@@ -701,15 +942,78 @@ namespace nvrhi::vulkan
         utils::BitSetAllocator& m_QueryAllocator;
     };
 
+    class QueryPool : public RefCounter<IQueryPool>
+    {
+    public:
+        QueryPoolDesc desc;
+        vk::QueryPool queryPool;
+
+        explicit QueryPool(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~QueryPool() override;
+
+        const QueryPoolDesc& getDesc() const override { return desc; }
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
+    class GpuProfiler final : public GpuProfilerBase
+    {
+    public:
+        vk::QueryPool queryPool;
+
+        GpuProfiler(const VulkanContext& context, Device* device, const GpuProfilerDesc& desc);
+        ~GpuProfiler() override;
+
+    protected:
+        void onFrameEnded(uint32_t frameSlot) override;
+        bool isFrameCompleted(uint32_t frameSlot, bool wait) override;
+        double getTimestampFrequency(CommandQueue queue) override;
+
+    private:
+        const VulkanContext& m_Context;
+        Device* m_Device;
+        // Last submitted command list ID of each queue when the frame ended, indexed by [frameSlot * CommandQueue::Count + queue]
+        std::vector<uint64_t> m_FrameSubmissionIDs;
+    };
+
     class Framebuffer : public RefCounter<IFramebuffer>
     {
     public:
         FramebufferDesc desc;
         FramebufferInfoEx framebufferInfo;
+        size_t framebufferInfoHash = 0;
         
         vk::RenderPass renderPass = vk::RenderPass();
         vk::Framebuffer framebuffer = vk::Framebuffer();
 
+        // A render pass compatible with 'renderPass' that loads all attachments, used to resume a suspended
+        // render pass. Only created when some attachments are cleared or discarded on load.
+        vk::RenderPass resumeRenderPass = vk::RenderPass();
+
+        // Clear values for the color and depth attachments, empty if none of them is cleared on load
+        static_vector<vk::ClearValue, c_MaxRenderTargets + 1> clearValues;
+
+        // True if some attachments use a store op other than Store, i.e. their contents don't survive a suspended render pass
+        bool discardsContents = false;
+
+        // Per color attachment, null for attachments that don't use AttachmentStoreOp::Resolve
+        static_vector<vk::ImageView, c_MaxRenderTargets> colorAttachmentResolveViews;
+
+        // Used with dynamic rendering, when there is no render pass or framebuffer object
+        static_vector<vk::Format, c_MaxRenderTargets> colorAttachmentFormats;
+        static_vector<vk::ImageView, c_MaxRenderTargets> colorAttachmentViews;
+        vk::Format depthAttachmentFormat = vk::Format::eUndefined;
+        vk::ImageView depthAttachmentView = vk::ImageView();
+        vk::ImageLayout depthAttachmentLayout = vk::ImageLayout::eUndefined;
+        bool depthAttachmentHasStencil = false;
+        vk::ImageView shadingRateAttachmentView = vk::ImageView();
+        vk::Extent2D shadingRateAttachmentTexelSize;
+        uint32_t layerCount = 1;
+
         std::vector<ResourceHandle> resources;
 
         bool managed = true;
@@ -721,18 +1025,92 @@ namespace nvrhi::vulkan
         ~Framebuffer() override;
         const FramebufferDesc& getDesc() const override { return desc; }
         const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
         Object getNativeObject(ObjectType objectType) override;
 
+        [[nodiscard]] vk::PipelineRenderingCreateInfo getPipelineRenderingInfo() const;
+
     private:
         const VulkanContext& m_Context;
     };
 
+    // Stores the descriptors of all binding sets and descriptor tables in one persistently mapped buffer when
+    // VK_EXT_descriptor_buffer is used, see DeviceDesc::descriptorBufferSupported. Writing a descriptor is
+    // a vkGetDescriptorEXT call into the buffer memory, and binding a set only sets its offset in the buffer.
+    class DescriptorBufferHeap
+    {
+    public:
+        DescriptorBufferHeap(const VulkanContext& context, VulkanAllocator& allocator)
+            : m_Context(context)
+            , m_Allocator(allocator)
+        { }
+
+        vk::Result create(uint64_t size);
+
+        // Returns a zeroed range, or false if the heap is full. The offsets are aligned for vkCmdSetDescriptorBufferOffsetsEXT.
+        bool allocate(uint64_t size, uint64_t& outOffset);
+        void release(uint64_t offset, uint64_t size);
+
+        // The image info is used for images and samplers, the address info for buffers, texel buffers and acceleration structures
+        void writeDescriptor(uint64_t offset, vk::DescriptorType type, const vk::DescriptorImageInfo* imageInfo, const vk::DescriptorAddressInfoEXT* addressInfo) const;
+        [[nodiscard]] size_t getDescriptorSize(vk::DescriptorType type) const;
+        [[nodiscard]] vk::DescriptorBufferBindingInfoEXT getBindingInfo() const;
+
+    private:
+        const VulkanContext& m_Context;
+        VulkanAllocator& m_Allocator;
+        RefCountPtr<Buffer> m_Buffer;
+        uint8_t* m_MappedMemory = nullptr;
+        std::map<uint64_t, uint64_t> m_FreeRanges; // offset -> size
+        std::mutex m_Mutex;
+    };
+
+    // Allocates descriptor sets of a single layout from a list of pools that grow on demand.
+    // Sets released by destroyed binding sets are recycled: command lists keep the binding sets they use alive
+    // until the GPU has retired them, so a released set is guaranteed not to be in flight anymore.
+    class DescriptorSetAllocator
+    {
+    public:
+        explicit DescriptorSetAllocator(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~DescriptorSetAllocator();
+
+        vk::Result allocate(vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorPoolSize>& setPoolSizes,
+            vk::DescriptorSet& outSet, vk::DescriptorPool& outPool);
+        void release(vk::DescriptorSet set, vk::DescriptorPool pool);
+
+    private:
+        static constexpr uint32_t c_InitialPoolCapacity = 16;
+        static constexpr uint32_t c_MaxPoolCapacity = 1024;
+
+        const VulkanContext& m_Context;
+        std::mutex m_Mutex;
+
+        std::vector<vk::DescriptorPool> m_Pools;
+        uint32_t m_CurrentPoolCapacity = 0;
+        uint32_t m_CurrentPoolAllocated = 0;
+
+        std::vector<std::pair<vk::DescriptorSet, vk::DescriptorPool>> m_FreeSets;
+
+        vk::Result createPool(const std::vector<vk::DescriptorPoolSize>& setPoolSizes);
+    };
+
     class BindingLayout : public RefCounter<IBindingLayout>
     {
     public:
         BindingLayoutDesc desc;
         BindlessLayoutDesc bindlessDesc;
         bool isBindless;
+        size_t descHash;
+
+        // the sets are recorded with vkCmdPushDescriptorSetKHR and don't use the descriptor set allocator
+        bool usesPushDescriptors = false;
+
+        // the size of a set and the offsets of the bindings (by binding number) in the descriptor buffer, if it is used
+        vk::DeviceSize descriptorBufferSize = 0;
+        std::unordered_map<uint32_t, vk::DeviceSize> descriptorBufferBindingOffsets;
 
         std::vector<vk::DescriptorSetLayoutBinding> vulkanLayoutBindings;
 
@@ -741,11 +1119,15 @@ namespace nvrhi::vulkan
         // descriptor pool size information per binding set
         std::vector<vk::DescriptorPoolSize> descriptorPoolSizeInfo;
 
+        // shared pools that the binding sets using this layout are allocated from
+        DescriptorSetAllocator descriptorSetAllocator;
+
         BindingLayout(const VulkanContext& context, const BindingLayoutDesc& desc);
         BindingLayout(const VulkanContext& context, const BindlessLayoutDesc& desc);
         ~BindingLayout() override;
         const BindingLayoutDesc* getDesc() const override { return isBindless ? nullptr : &desc; }
         const BindlessLayoutDesc* getBindlessDesc() const override { return isBindless ? &bindlessDesc : nullptr; }
+        size_t getDescHash() const override { return descHash; }
         Object getNativeObject(ObjectType objectType) override;
 
         // generate the descriptor set layout
@@ -755,17 +1137,33 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
-    // contains a vk::DescriptorSet
-    class BindingSet : public RefCounter<IBindingSet>
+    // descriptor writes for a binding set, with the storage that they point to
+    struct DescriptorWriteData
+    {
+        static_vector<vk::DescriptorImageInfo, c_MaxBindingsPerLayout> imageInfos;
+        static_vector<vk::DescriptorBufferInfo, c_MaxBindingsPerLayout> bufferInfos;
+        static_vector<vk::WriteDescriptorSetAccelerationStructureKHR, c_MaxBindingsPerLayout> accelStructWrites;
+        static_vector<vk::WriteDescriptorSet, c_MaxBindingsPerLayout> writes;
+    };
+
+    // contains a vk::DescriptorSet, or the descriptor writes to push if the layout uses push descriptors
+    class BindingSet : public CacheableBindingSet
     {
     public:
         BindingSetDesc desc;
         BindingLayoutHandle layout;
 
-        // TODO: move pool to the context instead
+        // the pool is owned by the layout's DescriptorSetAllocator and shared with other binding sets
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
+        // only used with push descriptor layouts, kept on the heap because it doesn't move
+        std::unique_ptr<DescriptorWriteData> pushDescriptorWrites;
+
+        // the range of the descriptor buffer that holds the set, used instead of descriptorSet when the buffer exists
+        uint64_t descriptorBufferOffset = 0;
+        uint64_t descriptorBufferSize = 0;
+
         std::vector<ResourceHandle> resources;
         static_vector<Buffer*, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBuffers;
 
@@ -793,6 +1191,10 @@ namespace nvrhi::vulkan
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
+        // the range of the descriptor buffer that holds the table, used instead of descriptorSet when the buffer exists
+        uint64_t descriptorBufferOffset = 0;
+        uint64_t descriptorBufferSize = 0;
+
         explicit DescriptorTable(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -801,6 +1203,7 @@ namespace nvrhi::vulkan
         const BindingSetDesc* getDesc() const override { return nullptr; }
         IBindingLayout* getLayout() const override { return layout; }
         uint32_t getCapacity() const override { return capacity; }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return 0; }
         Object getNativeObject(ObjectType objectType) override;
 
     private:
@@ -810,11 +1213,58 @@ namespace nvrhi::vulkan
     template <typename T>
     using BindingVector = static_vector<T, c_MaxBindingLayouts>;
 
+    // Stores the parts of graphics pipelines that have been compiled as VK_EXT_graphics_pipeline_library libraries.
+    // Pipelines that use the same state for a part share its library, so only the parts that differ are compiled,
+    // and the linked pipeline is created from the libraries quickly. The libraries are kept until the device is destroyed.
+    class GraphicsPipelineLibraryCache
+    {
+    public:
+        enum Part
+        {
+            VertexInput,
+            PreRasterization,
+            FragmentShader,
+            FragmentOutput,
+            PartCount
+        };
+
+        // The state that a library depends on, packed into words; pointers identify shaders and layouts
+        typedef std::vector<uint64_t> Key;
+
+        explicit GraphicsPipelineLibraryCache(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~GraphicsPipelineLibraryCache();
+
+        // Returns the library for the key, calling createLibrary if the cache doesn't have it yet.
+        // The keepAlive objects are referenced by the key and must live as long as the library, so that their addresses aren't reused.
+        vk::Pipeline getOrCreate(Part part, const Key& key, const std::vector<RefCountPtr<IResource>>& keepAlive,
+            const std::function<vk::Pipeline()>& createLibrary);
+
+    private:
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry
+        {
+            vk::Pipeline library;
+            std::vector<RefCountPtr<IResource>> keepAlive;
+        };
+
+        const VulkanContext& m_Context;
+        std::array<std::unordered_map<Key, Entry, KeyHash>, PartCount> m_Libraries;
+        std::mutex m_Mutex;
+    };
+
     class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
     {
     public:
         GraphicsPipelineDesc desc;
         FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
         ShaderType shaderMask = ShaderType::None;
         BindingVector<RefCountPtr<BindingLayout>> pipelineBindingLayouts;
         vk::PipelineLayout pipelineLayout;
@@ -822,6 +1272,14 @@ namespace nvrhi::vulkan
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
 
+        // The graphics pipeline libraries that 'pipeline' has been linked from, owned by the device's GraphicsPipelineLibraryCache.
+        // Null when the pipeline was created without libraries.
+        std::array<vk::Pipeline, GraphicsPipelineLibraryCache::PartCount> libraries;
+        bool linkedFromLibraries = false;
+
+        // Link-time optimized version of 'pipeline', set once by createOptimizedGraphicsPipelineAsync
+        std::atomic<VkPipeline> optimizedPipeline = VK_NULL_HANDLE;
+
         explicit GraphicsPipeline(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -829,8 +1287,16 @@ namespace nvrhi::vulkan
         ~GraphicsPipeline() override;
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
         Object getNativeObject(ObjectType objectType) override;
 
+        // Returns the pipeline to bind in new commands, which is the optimized one when it's available
+        [[nodiscard]] vk::Pipeline getPipeline() const
+        {
+            const VkPipeline optimized = optimizedPipeline.load();
+            return optimized ? vk::Pipeline(optimized) : pipeline;
+        }
+
     private:
         const VulkanContext& m_Context;
     };
@@ -862,6 +1328,7 @@ namespace nvrhi::vulkan
     public:
         MeshletPipelineDesc desc;
         FramebufferInfo framebufferInfo;
+        size_t framebufferInfoHash = 0;
         ShaderType shaderMask = ShaderType::None;
         BindingVector<RefCountPtr<BindingLayout>> pipelineBindingLayouts;
         vk::PipelineLayout pipelineLayout;
@@ -876,12 +1343,24 @@ namespace nvrhi::vulkan
         ~MeshletPipeline() override;
         const MeshletPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+        size_t getFramebufferInfoHash() const override { return framebufferInfoHash; }
         Object getNativeObject(ObjectType objectType) override;
 
     private:
         const VulkanContext& m_Context;
     };
 
+    // Signatures map to the vkCmd*Indirect(Count) commands, so they can only contain a single command argument
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        IndirectArgumentType commandType = IndirectArgumentType::Draw;
+        uint32_t byteStride = 0;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+    };
+
     class RayTracingPipeline : public RefCounter<rt::IPipeline>
     {
     public:
@@ -901,6 +1380,9 @@ namespace nvrhi::vulkan
         ~RayTracingPipeline() override;
         const rt::PipelineDesc& getDesc() const override { return desc; }
         rt::ShaderTableHandle createShaderTable() override;
+        rt::ShaderTableHandle createShaderTable(const rt::ShaderTableDesc& desc) override;
+        uint32_t getShaderTableEntrySize() const override;
+        const void* getShaderIdentifier(const char* exportName) override;
         Object getNativeObject(ObjectType objectType) override;
 
         int findShaderGroup(const std::string& name); // returns -1 if not found
@@ -912,6 +1394,8 @@ namespace nvrhi::vulkan
     class ShaderTable : public RefCounter<rt::IShaderTable>
     {
     public:
+        // Cached tables are not implemented on Vulkan yet, the table is uploaded as a whole when it changes
+        rt::ShaderTableDesc desc;
         RefCountPtr<RayTracingPipeline> pipeline;
 
         int rayGenerationShader = -1;
@@ -921,25 +1405,32 @@ namespace nvrhi::vulkan
 
         uint32_t version = 0;
 
-        ShaderTable(const VulkanContext& context, RayTracingPipeline* _pipeline)
-            : pipeline(_pipeline)
+        ShaderTable(const VulkanContext& context, RayTracingPipeline* _pipeline, const rt::ShaderTableDesc& _desc)
+            : desc(_desc)
+            , pipeline(_pipeline)
             , m_Context(context)
         { }
         
+        const rt::ShaderTableDesc& getDesc() const override { return desc; }
         void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
         rt::IPipeline* getPipeline() override { return pipeline; }
+        IBuffer* getBuffer() const override { return nullptr; }
         uint32_t getNumEntries() const;
 
     private:
         const VulkanContext& m_Context;
 
         bool verifyShaderGroupExists(const char* exportName, int shaderGroupIndex) const;
+        bool setShaderGroup(std::vector<uint32_t>& groups, uint32_t index, const char* exportName, IBindingSet* bindings);
     };
 
     struct BufferChunk
@@ -953,36 +1444,60 @@ namespace nvrhi::vulkan
         static constexpr uint64_t c_sizeAlignment = 4096; // GPU page size
     };
 
+    std::shared_ptr<BufferChunk> createBufferChunk(Device* device, uint64_t size, bool isScratchBuffer);
+
+    typedef UploadPagePool<BufferChunk> UploadChunkPool;
+
     class UploadManager
     {
     public:
-        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+        // Upload managers take their chunks from the device-global pSharedChunkPool, scratch managers (pSharedChunkPool = nullptr) own them
+        UploadManager(Device* pParent, UploadChunkPool* pSharedChunkPool, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
             : m_Device(pParent)
             , m_DefaultChunkSize(defaultChunkSize)
             , m_MemoryLimit(memoryLimit)
             , m_IsScratchBuffer(isScratchBuffer)
-        { }
+            , m_SharedChunkPool(pSharedChunkPool)
+        {
+            assert(!isScratchBuffer || !pSharedChunkPool);
+        }
 
-        std::shared_ptr<BufferChunk> CreateChunk(uint64_t size);
+        ~UploadManager();
 
         bool suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA, uint64_t currentVersion, uint32_t alignment = 256);
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
+        // Counters for CommandListStatistics, reset by the command list in open()
+        [[nodiscard]] uint64_t getSuballocatedBytes() const { return m_SuballocatedBytes; }
+        [[nodiscard]] uint32_t getAcquiredChunks() const { return m_AcquiredChunks; }
+        void resetStatistics() { m_SuballocatedBytes = 0; m_AcquiredChunks = 0; }
+
     private:
         Device* m_Device;
         uint64_t m_DefaultChunkSize = 0;
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
         bool m_IsScratchBuffer = false;
+        UploadChunkPool* m_SharedChunkPool = nullptr;
+        uint64_t m_SuballocatedBytes = 0;
+        uint32_t m_AcquiredChunks = 0;
 
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
+
+        bool acquireOwnedChunk(uint64_t size, uint64_t currentVersion, const std::shared_ptr<BufferChunk>& chunkToRetire);
+        void returnUnsubmittedChunks(uint64_t currentVersion);
     };
 
     class AccelStruct : public RefCounter<rt::IAccelStruct>
     {
     public:
         BufferHandle dataBuffer;
+        // Location of the AS data in dataBuffer, which is shared with other BLAS'es when the AS is suballocated
+        uint64_t dataOffset = 0;
+        uint64_t dataSize = 0;
+        AccelStructPool* pool = nullptr;
+        AccelStructPool::Allocation poolAllocation;
         std::vector<vk::AccelerationStructureInstanceKHR> instances;
         vk::AccelerationStructureKHR accelStruct;
         vk::DeviceAddress accelStructDeviceAddress = 0;
@@ -992,6 +1507,19 @@ namespace nvrhi::vulkan
         size_t rtxmuId = ~0ull;
         vk::Buffer rtxmuBuffer;
 
+        // Persistent instance data, only used when desc.persistentInstanceBuffer is set.
+        // The BLAS'es are referenced per instance and counted, so that each one is transitioned once per build.
+        struct BlasReference
+        {
+            rt::AccelStructHandle handle;
+            size_t numInstances = 0;
+        };
+
+        BufferHandle instanceBuffer;
+        std::vector<AccelStruct*> instanceBlases;
+        std::unordered_map<AccelStruct*, BlasReference> uniqueBlases;
+
+        void setInstanceBlas(size_t index, AccelStruct* blas);
 
         explicit AccelStruct(const VulkanContext& context)
             : m_Context(context)
@@ -1032,7 +1560,7 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
-    class Device : public RefCounter<nvrhi::vulkan::IDevice>
+    class Device final : public RefCounter<nvrhi::vulkan::IDevice>
     {
     public:
         // Internal backend methods
@@ -1042,6 +1570,8 @@ namespace nvrhi::vulkan
 
         Queue* getQueue(CommandQueue queue) const { return m_Queues[int(queue)].get(); }
         vk::QueryPool getTimerQueryPool() const { return m_TimerQueryPool; }
+        VulkanAllocator& getAllocator() { return m_Allocator; }
+        UploadChunkPool* getUploadChunkPool() { return &m_UploadChunkPool; }
 
         // IResource implementation
 
@@ -1051,28 +1581,44 @@ namespace nvrhi::vulkan
         // IDevice implementation
 
         HeapHandle createHeap(const HeapDesc& d) override;
+        TransientResourcePoolHandle createTransientResourcePool(const TransientResourcePoolDesc& desc) override;
+        StreamingUploaderHandle createStreamingUploader(const StreamingUploaderDesc& desc) override;
+        ReadbackRingHandle createReadbackRing(const ReadbackRingDesc& desc) override;
+        BindingSetCacheHandle createBindingSetCache() override;
+        MipGeneratorHandle createMipGenerator() override;
 
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        bool writeTextureDirect(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
         StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
         void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
         void unmapStagingTexture(IStagingTexture* tex) override;
+        void *tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         void unmapBuffer(IBuffer* b) override;
+        void *tryMapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        TextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+
         BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
 
         ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
         ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
         ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+        // vkCreateShaderModule doesn't keep the code, there is nothing to reference
+        ShaderHandle createShaderNoCopy(const ShaderDesc& d, const void* binary, size_t binarySize, IResource*) override { return createShader(d, binary, binarySize); }
+        ShaderLibraryHandle createShaderLibraryNoCopy(const void* binary, size_t binarySize, IResource*) override { return createShaderLibrary(binary, binarySize); }
 
         SamplerHandle createSampler(const SamplerDesc& d) override;
 
@@ -1090,6 +1636,12 @@ namespace nvrhi::vulkan
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+        GpuProfilerHandle createGpuProfiler(const GpuProfilerDesc& desc) override;
+        BreadcrumbBufferHandle createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc) override;
+
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -1103,10 +1655,21 @@ namespace nvrhi::vulkan
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
 
+        WorkGraphHandle createWorkGraph(const WorkGraphDesc& desc) override;
+
+        PipelineCreationTaskHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override;
+        PipelineCreationTaskHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        PipelineCreationTaskHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override;
+
+        bool loadPipelineCache(const void* data, size_t size) override;
+        bool savePipelineCache(std::vector<uint8_t>& outData) override;
+
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
 
         BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        bool createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* layout, BindingSetHandle* outBindingSets) override;
         DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
@@ -1121,7 +1684,14 @@ namespace nvrhi::vulkan
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
         void waitForIdle() override;
+        uint64_t getCompletedInstance(CommandQueue queue) override;
+        bool waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        size_t waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout = c_InfiniteTimeout) override;
+        void notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback) override;
         void runGarbageCollection() override;
+        bool runGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setUploadPoolSettings(const UploadPoolSettings& settings) override;
+        UploadPoolStatistics getUploadPoolStatistics() override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
@@ -1134,9 +1704,19 @@ namespace nvrhi::vulkan
         uint64_t queueGetCompletedInstance(CommandQueue queue) override;
         FramebufferHandle createHandleForNativeFramebuffer(VkRenderPass renderPass, VkFramebuffer framebuffer,
             const FramebufferDesc& desc, bool transferOwnership) override;
+        MemoryAllocatorStatistics getMemoryAllocatorStatistics() override;
+        bool queryMemoryBudget(MemoryBudget& outBudget) override;
+        CommandListStatistics getCommandListStatistics(bool reset = true) override;
+        void flushSubmissions() override;
+        PipelineCreationTaskHandle createOptimizedGraphicsPipelineAsync(IGraphicsPipeline* pipeline) override;
 
     private:
         VulkanContext m_Context;
+
+        // Interned samplers, see createSampler. Drivers may limit the number of VkSampler objects to as few as 4000.
+        // Declared early, so that it outlives the members that can hold samplers.
+        SamplerCache<Sampler> m_SamplerCache;
+
         VulkanAllocator m_Allocator;
         
         vk::QueryPool m_TimerQueryPool = nullptr;
@@ -1144,18 +1724,70 @@ namespace nvrhi::vulkan
 
         std::mutex m_Mutex;
 
+        // Upload chunks shared by all command lists. Declared after the allocator that their buffers come from,
+        // and before the queues, which may hold the last references to command lists that give their chunks back on destruction.
+        UploadChunkPool m_UploadChunkPool;
+
+        // Storage for suballocated BLAS'es. Also declared before the queues, for the same reason.
+        AccelStructPool m_AccelStructPool;
+
+        // The descriptor buffer for all binding sets and descriptor tables, if DeviceDesc::descriptorBufferSupported is set.
+        // Declared before the queues, because binding sets referenced by command lists release their ranges in it.
+        std::unique_ptr<DescriptorBufferHeap> m_DescriptorBufferHeap;
+
         // array of submission queues
         std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> m_Queues;
+
+        // Set when the queues belong to different families, and resources created with exclusive sharing mode need
+        // their ownership transferred between them. The mutex serializes executeCommandLists across queues in that case.
+        bool m_QueueOwnershipTransfersNeeded = false;
+        std::mutex m_QueueOwnershipMutex;
+
+        // Runs the callbacks registered with notifyOnCompletion. With DeviceDesc::deferQueueSubmissions,
+        // the thread flushes the deferred submissions before it waits for pending callbacks.
+        SubmissionCallbackThread m_SubmissionCallbacks;
+
+        // Libraries for the parts of graphics pipelines, if DeviceDesc::graphicsPipelineLibrarySupported is set and fast linking is available
+        std::unique_ptr<GraphicsPipelineLibraryCache> m_PipelineLibraryCache;
         
-        void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size) const;
+        void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size, bool wait = true) const;
+
+        // Creates a binding set and generates its descriptor writes. When the set uses a descriptor set from the layout's pools,
+        // the writes are stored in poolWriteData and the caller must submit them with vkUpdateDescriptorSets.
+        // Push descriptor writes are kept in the set, and descriptor buffer writes go to the buffer directly.
+        BindingSet* createBindingSetWithoutUpdate(const BindingSetDesc& desc, BindingLayout* layout, DescriptorWriteData& poolWriteData);
+
+        // Makes the deferred submissions of all queues, which must happen before the CPU waits for any of them,
+        // because a submission may wait on the GPU for a deferred submission to another queue
+        void flushQueueSubmissions() const;
+
+        void getCompletedInstances(CompletedInstances& completed) const;
+        bool waitForSubmissions(const SubmissionPoint* submissions, size_t count, bool waitAny, uint64_t timeout, bool flush) const;
+
+        // Submits the release barriers for the resources used by the command lists that are owned by queues from
+        // other families, and returns a command buffer with the matching acquire barriers to execute on dstQueue first,
+        // or nullptr if no transfers are needed. Also records dstQueue as the new owner of all these resources.
+        TrackedCommandBufferPtr transferQueueOwnership(Queue& dstQueue, ICommandList* const* pCommandLists, size_t numCommandLists);
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch, bool wait);
+
+        // When a task is provided, the pipeline is compiled through a deferred operation that other threads can join
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc, PipelineCreationTask* task);
+
+        // Compiles or finds the libraries for the parts of the pipeline described by pipelineInfo, and links them into pso->pipeline
+        vk::Result createGraphicsPipelineFromLibraries(GraphicsPipeline* pso, Framebuffer* fb,
+            const vk::GraphicsPipelineCreateInfo& pipelineInfo, const vk::PipelineRenderingCreateInfo& renderingInfo,
+            const vk::PipelineFragmentShadingRateStateCreateInfoKHR& shadingRateState);
+        vk::Result linkGraphicsPipeline(const GraphicsPipeline* pso, bool optimize, vk::Pipeline& outPipeline) const;
     };
 
-    class CommandList : public RefCounter<ICommandList>
+    class CommandList final : public RefCounter<ICommandList>
     {
     public:
         // Internal backend methods
 
-        CommandList(Device* device, const VulkanContext& context, const CommandListParameters& parameters);
+        // Command lists of a bundle record into the bundle's secondary command buffer and are never submitted to a queue
+        CommandList(Device* device, const VulkanContext& context, const CommandListParameters& parameters, CommandBundle* bundle = nullptr);
+        ~CommandList() override;
 
         void executed(Queue& queue, uint64_t submissionID);
 
@@ -1177,7 +1809,9 @@ namespace nvrhi::vulkan
         void copyTexture(IStagingTexture* dest, const TextureSlice& dstSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& dstSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTexture(ITexture* dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -1186,10 +1820,14 @@ namespace nvrhi::vulkan
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindings(const BindingSetVector& bindings) override;
+        void setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -1197,22 +1835,43 @@ namespace nvrhi::vulkan
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void executeIndirect(ICommandSignature* signature, IBuffer* argumentBuffer, uint32_t argumentOffsetBytes,
+            uint32_t maxCommandCount, IBuffer* countBuffer = nullptr, uint32_t countOffsetBytes = 0) override;
+
+        void executeBundle(ICommandBundle* bundle) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void setWorkGraphState(const WorkGraphState& state) override;
+        void dispatchGraph(const DispatchGraphArguments& args) override;
         
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances,
+            const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
 
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* buffer, uint64_t offsetBytes) override;
+        void setPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op = PredicationOp::SkipIfZero) override;
+
         void beginMarker(const char* name) override;
         void endMarker() override;
+        void setGpuProfiler(IGpuProfiler* profiler) override;
+        void writeBreadcrumb(IBreadcrumbBuffer* buffer, uint32_t markerId) override;
 
         void setEnableAutomaticBarriers(bool enable) override;
         void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
@@ -1231,14 +1890,22 @@ namespace nvrhi::vulkan
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
 
         void commitBarriers() override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void endTextureStateTransition(ITexture* texture) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void endBufferStateTransition(IBuffer* buffer) override;
+        void textureAliasingBarrier(ITexture* texture) override;
+        void bufferAliasingBarrier(IBuffer* buffer) override;
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
         ResourceStates getBufferState(IBuffer* buffer) override;
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_CommandListParameters; }
+        const CommandListStatistics& getStatistics() const override { return m_Statistics; }
 
         TrackedCommandBufferPtr getCurrentCmdBuf() const { return m_CurrentCmdBuf; }
+        const CommandListResourceStateTracker& getStateTracker() const { return m_StateTracker; }
 
     private:
         Device* m_Device;
@@ -1249,6 +1916,22 @@ namespace nvrhi::vulkan
         CommandListResourceStateTracker m_StateTracker;
         bool m_EnableAutomaticBarriers = true;
 
+        // Conditional rendering is begun and ended outside of render passes, and must be ended before the command buffer
+        bool m_ConditionalRenderingActive = false;
+        void endConditionalRendering();
+
+        CommandListStatistics m_Statistics;
+
+#ifndef NDEBUG
+        // Capacities of the command buffer, command list and state tracker storage when the recording was opened,
+        // see CommandListStatistics::recordingAllocations
+        std::array<size_t, 3> getStorageCapacities() const;
+        std::array<size_t, 3> m_StorageCapacitiesAtOpen{};
+#endif
+
+        // the bundle that owns this command list, if any
+        CommandBundle* m_Bundle = nullptr;
+
         // current internal command buffer
         TrackedCommandBufferPtr m_CurrentCmdBuf = nullptr;
 
@@ -1260,6 +1943,14 @@ namespace nvrhi::vulkan
         rt::State m_CurrentRayTracingState;
         bool m_AnyVolatileBufferWrites = false;
 
+        // Dynamic offsets of the volatile CBs in the currently bound descriptor sets, in binding order
+        static_vector<uint32_t, c_MaxVolatileConstantBuffers> m_BoundVolatileBufferOffsets;
+
+        // The framebuffer of the current logical render pass. It stays set while the render pass is suspended
+        // by commands that cannot be recorded inside it, so that the render pass can be resumed
+        // without applying the attachment load ops again, including by partial graphics state updates.
+        Framebuffer* m_RenderPassFramebuffer = nullptr;
+
         struct ShaderTableState
         {
             vk::StridedDeviceAddressRegionKHR rayGen;
@@ -1269,16 +1960,40 @@ namespace nvrhi::vulkan
             uint32_t version = 0;
         } m_CurrentShaderTablePointers;
 
-        std::unordered_map<Buffer*, VolatileBufferState> m_VolatileBufferStates;
+        PointerMap<Buffer, VolatileBufferState> m_VolatileBufferStates;
+        std::vector<vk::MappedMemoryRange> m_MappedMemoryRanges; // used locally in flushVolatileBufferWrites, member to avoid re-allocations
 
         std::unique_ptr<UploadManager> m_UploadManager;
         std::unique_ptr<UploadManager> m_ScratchManager;
+
+        GpuProfilerRecording m_ProfilerRecording;
+
+        struct SplitBarrier
+        {
+            IResource* resource = nullptr;
+            vk::Event event;
+            std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+            std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+        };
+
+        // split barriers started with begin[...]StateTransition, waited on in end[...]StateTransition
+        std::vector<SplitBarrier> m_SplitBarriers;
         
         void clearTexture(ITexture* texture, TextureSubresourceSet subresources, const vk::ClearColorValue& clearValue);
 
         void bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings);
+        void bindVolatileBufferOffsets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings);
+        uint32_t getVolatileBufferOffset(Buffer* buffer);
 
+        // With secondaryContents, the render pass is recorded for executing secondary command buffers only
+        void beginRenderPass(Framebuffer* fb, bool secondaryContents = false);
         void endRenderPass();
+        void openBundle();
+        void releaseUnsubmittedCmdBuf();
+        void commitBarriersInsideRenderPass();
+
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void bindVertexBuffers(const VertexBufferBindingVector& bindings);
 
         void trackResourcesAndBarriers(const GraphicsState& state);
         void trackResourcesAndBarriers(const MeshletState& state);
@@ -1288,6 +2003,7 @@ namespace nvrhi::vulkan
         void submitVolatileBuffers(uint64_t recordingID, uint64_t submittedID);
 
         void updateGraphicsVolatileBuffers();
+        void prepareIndirectCountBuffer(Buffer* countBuffer);
         void updateComputeVolatileBuffers();
         void updateMeshletVolatileBuffers();
         void updateRayTracingVolatileBuffers();
@@ -1300,6 +2016,49 @@ namespace nvrhi::vulkan
 
         void commitBarriersInternal();
         void commitBarriersInternal_synchronization2();
+        void convertPendingBarriers2(std::vector<vk::ImageMemoryBarrier2>& imageBarriers, std::vector<vk::BufferMemoryBarrier2>& bufferBarriers);
+        bool beginSplitBarriers(IResource* resource); // returns true if barriers were recorded, the caller then references the resource
+        void endSplitBarriers(IResource* resource); // nullptr ends all open split barriers
+        void writeProfilerTimestamp(const GpuProfilerRecording::Query& query);
+        void resolveProfilerQueries();
+    };
+
+    class CommandBundle final : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+        RefCountPtr<CommandList> commandList;
+
+        // The secondary command buffer, allocated from a pool owned by the bundle so that it outlives the frame
+        vk::CommandPool commandPool;
+        TrackedCommandBufferPtr cmdBuf;
+
+        // Resource states required by the recorded commands, set by the command list that executes the bundle
+        BundleStateRequirements states;
+
+        CommandBundle(const VulkanContext& context, const CommandBundleDesc& desc)
+            : desc(desc)
+            , m_Context(context)
+        { }
+
+        ~CommandBundle() override;
+
+        void open() override { commandList->open(); }
+        void close() override { commandList->close(); }
+
+        void setGraphicsState(const GraphicsState& state) override { commandList->setGraphicsState(state); }
+        void setPushConstants(const void* data, size_t byteSize) override { commandList->setPushConstants(data, byteSize); }
+
+        void draw(const DrawArguments& args) override { commandList->draw(args); }
+        void drawIndexed(const DrawArguments& args) override { commandList->drawIndexed(args); }
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndirect(offsetBytes, drawCount); }
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override { commandList->drawIndexedIndirect(offsetBytes, drawCount); }
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
+
+    private:
+        const VulkanContext& m_Context;
     };
 
 } // namespace nvrhi::vulkan
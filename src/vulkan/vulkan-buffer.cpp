@@ -41,6 +41,9 @@ namespace nvrhi::vulkan
         if (desc.byteSize == 0)
             return nullptr;
 
+        if (desc.isGpuAddressable && (desc.isVolatile || !m_Context.extensions.buffer_device_address))
+            return nullptr;
+
 
         Buffer *buffer = new Buffer(m_Context, m_Allocator);
         buffer->desc = desc;
@@ -78,6 +81,9 @@ namespace nvrhi::vulkan
         if (desc.isShaderBindingTable)
             usageFlags |= vk::BufferUsageFlagBits::eShaderBindingTableKHR;
 
+        if (desc.isPredicationBuffer && m_Context.extensions.EXT_conditional_rendering)
+            usageFlags |= vk::BufferUsageFlagBits::eConditionalRenderingEXT;
+
         if (m_Context.extensions.buffer_device_address)
             usageFlags |= vk::BufferUsageFlagBits::eShaderDeviceAddress;
 
@@ -117,6 +123,9 @@ namespace nvrhi::vulkan
             .setUsage(usageFlags)
             .setSharingMode(vk::SharingMode::eExclusive);
 
+        if (desc.isTiled)
+            bufferInfo.setFlags(vk::BufferCreateFlagBits::eSparseBinding | vk::BufferCreateFlagBits::eSparseResidency);
+
 #if _WIN32
         const auto handleType = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueWin32;
 #else
@@ -131,16 +140,28 @@ namespace nvrhi::vulkan
 
         m_Context.nameVKObject(VkBuffer(buffer->buffer), vk::DebugReportObjectTypeEXT::eBuffer, desc.debugName.c_str());
 
-        if (!desc.isVirtual)
+        if (desc.isTiled)
+        {
+            // Sparse buffers have an address before any memory is bound to them
+            if (m_Context.extensions.buffer_device_address)
+            {
+                auto addressInfo = vk::BufferDeviceAddressInfo().setBuffer(buffer->buffer);
+
+                buffer->deviceAddress = m_Context.device.getBufferAddress(addressInfo);
+            }
+        }
+        else if (!desc.isVirtual)
         {
             res = m_Allocator.allocateBufferMemory(buffer, (usageFlags & vk::BufferUsageFlagBits::eShaderDeviceAddress) != vk::BufferUsageFlags(0));
             CHECK_VK_FAIL(res)
 
-            m_Context.nameVKObject(buffer->memory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            // Sub-allocated buffers share the memory object with other resources, so only name dedicated allocations
+            if (!buffer->memoryBlock)
+                m_Context.nameVKObject(buffer->memory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
 
             if (desc.isVolatile)
             {
-                buffer->mappedMemory = m_Context.device.mapMemory(buffer->memory, 0, size);
+                buffer->mappedMemory = m_Allocator.mapMemory(buffer, 0, size);
                 assert(buffer->mappedMemory);
             }
 
@@ -177,6 +198,14 @@ namespace nvrhi::vulkan
         buffer->desc = desc;
         buffer->managed = false;
 
+        // The application guarantees that the native buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+        if (desc.isGpuAddressable && m_Context.extensions.buffer_device_address)
+        {
+            auto addressInfo = vk::BufferDeviceAddressInfo().setBuffer(buffer->buffer);
+
+            buffer->deviceAddress = m_Context.device.getBufferAddress(addressInfo);
+        }
+
         return BufferHandle::Create(buffer);
     }
 
@@ -343,31 +372,27 @@ namespace nvrhi::vulkan
         // so before using the data on the GPU, we need to make sure it's available there.
         // Go over all the volatile CBs that were used in this CL and flush their written versions.
 
-        std::vector<vk::MappedMemoryRange> ranges;
+        m_MappedMemoryRanges.clear();
 
-        for (auto& iter : m_VolatileBufferStates)
+        m_VolatileBufferStates.forEach([this](Buffer* buffer, VolatileBufferState& state)
         {
-            Buffer* buffer = iter.first;
-            VolatileBufferState& state = iter.second;
-
             if (state.maxVersion < state.minVersion || !state.initialized)
-                continue;
+                return;
 
             // Flush all the versions between min and max - that might be too conservative,
             // but that should be fine - better than using potentially hundreds of ranges.
             int numVersions = state.maxVersion - state.minVersion + 1;
 
-            auto range = vk::MappedMemoryRange()
-                .setMemory(buffer->memory)
-                .setOffset(state.minVersion * buffer->desc.byteSize)
-                .setSize(numVersions * buffer->desc.byteSize);
+            auto range = m_Device->getAllocator().getMappedMemoryRange(buffer,
+                state.minVersion * buffer->desc.byteSize,
+                numVersions * buffer->desc.byteSize);
 
-            ranges.push_back(range);
-        }
+            m_MappedMemoryRanges.push_back(range);
+        });
 
-        if (!ranges.empty())
+        if (!m_MappedMemoryRanges.empty())
         {
-            m_Context.device.flushMappedMemoryRanges(ranges);
+            m_Context.device.flushMappedMemoryRanges(m_MappedMemoryRanges);
         }
     }
 
@@ -381,13 +406,10 @@ namespace nvrhi::vulkan
         uint64_t stateToFind = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (recordingID & c_VersionIDMask);
         uint64_t stateToReplace = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (submittedID & c_VersionIDMask) | c_VersionSubmittedFlag;
 
-        for (auto& iter : m_VolatileBufferStates)
+        m_VolatileBufferStates.forEach([stateToFind, stateToReplace](Buffer* buffer, VolatileBufferState& state)
         {
-            Buffer* buffer = iter.first;
-            VolatileBufferState& state = iter.second;
-
             if (!state.initialized)
-                continue;
+                return;
 
             for (int version = state.minVersion; version <= state.maxVersion; version++)
             {
@@ -395,7 +417,7 @@ namespace nvrhi::vulkan
                 uint64_t expected = stateToFind;
                 buffer->versionTracking[version].compare_exchange_strong(expected, stateToReplace);
             }
-        }
+        });
     }
 
     void CommandList::writeBuffer(IBuffer* _buffer, const void *data, size_t dataSize, uint64_t destOffsetBytes)
@@ -480,7 +502,7 @@ namespace nvrhi::vulkan
     {
         if (mappedMemory)
         {
-            m_Context.device.unmapMemory(memory);
+            m_Allocator.unmapMemory(this);
             mappedMemory = nullptr;
         }
 
@@ -521,7 +543,7 @@ namespace nvrhi::vulkan
         }
     }
 
-    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size) const
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size, bool wait) const
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
@@ -531,6 +553,12 @@ namespace nvrhi::vulkan
         if (buffer->lastUseCommandListID != 0)
         {
             auto& queue = m_Queues[uint32_t(buffer->lastUseQueue)];
+
+            flushQueueSubmissions();
+
+            if (!wait && !queue->pollCommandList(buffer->lastUseCommandListID))
+                return nullptr;
+
             queue->waitCommandList(buffer->lastUseCommandListID, ~0ull);
         }
 
@@ -555,9 +583,16 @@ namespace nvrhi::vulkan
         // TODO: there should be a barrier... But there can't be a command list here
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eHost, accessFlags);
 
-        void* ptr = nullptr;
-        [[maybe_unused]] const vk::Result res = m_Context.device.mapMemory(buffer->memory, offset, size, vk::MemoryMapFlags(), &ptr);
-        assert(res == vk::Result::eSuccess);
+        void* ptr = m_Allocator.mapMemory(buffer, offset, size);
+        assert(ptr);
+
+        // The memory stays mapped, so make the GPU writes visible for non-coherent memory types
+        if (flags == CpuAccessMode::Read)
+            m_Allocator.invalidateMappedMemory(buffer, offset, size);
+
+        buffer->mappedAccess = flags;
+        buffer->mappedRangeOffset = offset;
+        buffer->mappedRangeSize = size;
 
         return ptr;
     }
@@ -569,11 +604,24 @@ namespace nvrhi::vulkan
         return mapBuffer(buffer, flags, 0, buffer->desc.byteSize);
     }
 
+    void *Device::tryMapBuffer(IBuffer* _buffer, CpuAccessMode flags)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        return mapBuffer(buffer, flags, 0, buffer->desc.byteSize, false);
+    }
+
     void Device::unmapBuffer(IBuffer* _buffer)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_Context.device.unmapMemory(buffer->memory);
+        // Make the CPU writes visible to the GPU for non-coherent memory types
+        if (buffer->mappedAccess == CpuAccessMode::Write)
+            m_Allocator.flushMappedMemory(buffer, buffer->mappedRangeOffset, buffer->mappedRangeSize);
+
+        buffer->mappedAccess = CpuAccessMode::None;
+
+        m_Allocator.unmapMemory(buffer);
 
         // TODO: there should be a barrier
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
@@ -617,4 +665,47 @@ namespace nvrhi::vulkan
         return true;
     }
 
+    void Device::updateBufferTileMappings(IBuffer* _buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+        Queue* queue = m_Queues[uint32_t(executionQueue)].get();
+
+        if (!queue)
+            return;
+
+        if (!queue->supportsSparseBinding())
+        {
+            std::stringstream ss;
+            ss << "Cannot update the tile mappings of buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                << ": the family of the execution queue doesn't support sparse binding";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        std::vector<vk::SparseMemoryBind> binds(numTileMappings);
+
+        for (uint32_t n = 0; n < numTileMappings; ++n)
+        {
+            const BufferTilesMapping& mapping = tileMappings[n];
+            const vk::DeviceMemory memory = mapping.heap ? checked_cast<Heap*>(mapping.heap)->memory : vk::DeviceMemory();
+
+            binds[n] = vk::SparseMemoryBind()
+                .setResourceOffset(mapping.bufferOffset)
+                .setSize(mapping.byteSize)
+                .setMemory(memory)
+                .setMemoryOffset(memory ? mapping.heapOffset : 0);
+        }
+
+        auto bufferBindInfo = vk::SparseBufferMemoryBindInfo()
+            .setBuffer(buffer->buffer)
+            .setBindCount(uint32_t(binds.size()))
+            .setPBinds(binds.data());
+
+        auto bindSparseInfo = vk::BindSparseInfo()
+            .setBufferBindCount(1)
+            .setPBufferBinds(&bufferBindInfo);
+
+        queue->bindSparse(bindSparseInfo);
+    }
+
 } // namespace nvrhi::vulkan
@@ -0,0 +1,194 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::vulkan
+{
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (!desc.framebuffer)
+        {
+            m_Context.error("Cannot create a command bundle without a framebuffer");
+            return nullptr;
+        }
+
+        Queue* queue = getQueue(CommandQueue::Graphics);
+
+        CommandBundle* bundle = new CommandBundle(m_Context, desc);
+        CommandBundleHandle handle = CommandBundleHandle::Create(bundle);
+
+        auto poolInfo = vk::CommandPoolCreateInfo()
+            .setQueueFamilyIndex(queue->getQueueFamilyIndex())
+            .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+
+        vk::Result res = m_Context.device.createCommandPool(&poolInfo, m_Context.allocationCallbacks, &bundle->commandPool);
+        CHECK_VK_FAIL(res)
+
+        bundle->cmdBuf = std::make_shared<TrackedCommandBuffer>(m_Context);
+
+        auto allocInfo = vk::CommandBufferAllocateInfo()
+            .setLevel(vk::CommandBufferLevel::eSecondary)
+            .setCommandPool(bundle->commandPool)
+            .setCommandBufferCount(1);
+
+        res = m_Context.device.allocateCommandBuffers(&allocInfo, &bundle->cmdBuf->cmdBuf);
+        CHECK_VK_FAIL(res)
+
+        m_Context.nameVKObject(VkCommandBuffer(bundle->cmdBuf->cmdBuf), vk::DebugReportObjectTypeEXT::eCommandBuffer, desc.debugName.c_str());
+
+        const CommandListParameters params = CommandListParameters()
+            .setQueueType(CommandQueue::Graphics);
+
+        bundle->commandList = RefCountPtr<CommandList>::Create(new CommandList(this, m_Context, params, bundle));
+
+        return handle;
+    }
+
+    CommandBundle::~CommandBundle()
+    {
+        // Destroying the pool frees the command buffer
+        cmdBuf = nullptr;
+
+        if (commandPool)
+        {
+            m_Context.device.destroyCommandPool(commandPool, m_Context.allocationCallbacks);
+            commandPool = vk::CommandPool();
+        }
+    }
+
+    Object CommandBundle::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::VK_CommandBuffer:
+            return Object(cmdBuf->cmdBuf);
+        default:
+            return nullptr;
+        }
+    }
+
+    void CommandList::openBundle()
+    {
+        // The application makes sure that the GPU is done with the previous recording, see ICommandBundle
+        m_CurrentCmdBuf = m_Bundle->cmdBuf;
+        m_CurrentCmdBuf->referencedResources.clear();
+        m_CurrentCmdBuf->referencedStagingBuffers.clear();
+        m_Bundle->states.clear();
+
+        (void)m_CurrentCmdBuf->cmdBuf.reset(vk::CommandBufferResetFlags());
+
+        const Framebuffer* fb = checked_cast<Framebuffer*>(m_Bundle->desc.framebuffer.Get());
+
+        // Secondary command buffers continue a render pass, described either by the render pass object
+        // or by the attachment formats for dynamic rendering
+        auto renderingInfo = vk::CommandBufferInheritanceRenderingInfo()
+            .setColorAttachmentCount(uint32_t(fb->colorAttachmentFormats.size()))
+            .setPColorAttachmentFormats(fb->colorAttachmentFormats.data())
+            .setDepthAttachmentFormat(fb->depthAttachmentFormat)
+            .setStencilAttachmentFormat(fb->depthAttachmentHasStencil ? fb->depthAttachmentFormat : vk::Format::eUndefined)
+            .setRasterizationSamples(vk::SampleCountFlagBits(fb->framebufferInfo.sampleCount));
+
+        auto inheritanceInfo = vk::CommandBufferInheritanceInfo();
+        if (fb->renderPass)
+        {
+            inheritanceInfo
+                .setRenderPass(fb->renderPass)
+                .setSubpass(0)
+                .setFramebuffer(fb->framebuffer);
+        }
+        else
+        {
+            inheritanceInfo.setPNext(&renderingInfo);
+        }
+
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse)
+            .setPInheritanceInfo(&inheritanceInfo);
+
+        (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
+
+        // Secondary command buffers don't inherit the descriptor buffer bindings
+        if (m_Context.descriptorBufferHeap)
+        {
+            const vk::DescriptorBufferBindingInfoEXT bindingInfo = m_Context.descriptorBufferHeap->getBindingInfo();
+            m_CurrentCmdBuf->cmdBuf.bindDescriptorBuffersEXT(1, &bindingInfo);
+        }
+
+        clearState();
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        assert(m_CurrentCmdBuf);
+
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+        Framebuffer* fb = checked_cast<Framebuffer*>(bundle->desc.framebuffer.Get());
+
+        endRenderPass();
+
+        // Secondary command buffers inside a render pass cannot place barriers, so transition everything that the bundle uses here.
+        // The bundle states include the attachments and resolve textures of the framebuffer if the bundle set any graphics state.
+        if (m_EnableAutomaticBarriers)
+        {
+            for (const auto& texture : bundle->states.getTextures())
+                requireTextureState(texture.texture, texture.subresources, texture.state);
+
+            for (const auto& buffer : bundle->states.getBuffers())
+                requireBufferState(buffer.buffer, buffer.state);
+
+            setResourceStatesForFramebuffer(fb);
+        }
+
+        if (fb->desc.shadingRateAttachment.valid())
+        {
+            setTextureState(fb->desc.shadingRateAttachment.texture, nvrhi::TextureSubresourceSet(0, 1, 0, 1), nvrhi::ResourceStates::ShadingRateSurface);
+        }
+
+        commitBarriers();
+
+        beginRenderPass(fb, true);
+        m_CurrentCmdBuf->cmdBuf.executeCommands(1, &bundle->cmdBuf->cmdBuf);
+        m_CurrentGraphicsState.framebuffer = fb;
+        endRenderPass();
+
+        m_CurrentCmdBuf->referencedResources.push_back(bundle);
+        m_CurrentCmdBuf->referencedResources.push_back(fb);
+
+        // The state of the command buffer is undefined after executing secondary command buffers.
+        // m_RenderPassFramebuffer stays set, so that another render pass on the same framebuffer loads its contents.
+        m_CurrentPipelineLayout = vk::PipelineLayout();
+        m_CurrentPushConstantsVisibility = vk::ShaderStageFlagBits();
+        m_CurrentGraphicsState = GraphicsState();
+        m_CurrentComputeState = ComputeState();
+        m_CurrentMeshletState = MeshletState();
+        m_CurrentRayTracingState = rt::State();
+
+        if (m_Context.descriptorBufferHeap)
+        {
+            const vk::DescriptorBufferBindingInfoEXT bindingInfo = m_Context.descriptorBufferHeap->getBindingInfo();
+            m_CurrentCmdBuf->cmdBuf.bindDescriptorBuffersEXT(1, &bindingInfo);
+        }
+    }
+
+} // namespace nvrhi::vulkan
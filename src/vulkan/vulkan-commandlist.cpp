@@ -25,16 +25,31 @@
 namespace nvrhi::vulkan
 {
 
-    CommandList::CommandList(Device* device, const VulkanContext& context, const CommandListParameters& parameters)
+    CommandList::CommandList(Device* device, const VulkanContext& context, const CommandListParameters& parameters, CommandBundle* bundle)
         : m_Device(device)
         , m_Context(context)
         , m_CommandListParameters(parameters)
         , m_StateTracker(context.messageCallback)
-        , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false))
-        , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
+        , m_Bundle(bundle)
+        , m_UploadManager(std::make_unique<UploadManager>(device, device->getUploadChunkPool(), parameters.uploadChunkSize, 0, false))
+        , m_ScratchManager(std::make_unique<UploadManager>(device, nullptr, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
     {
     }
 
+    CommandList::~CommandList()
+    {
+        releaseUnsubmittedCmdBuf();
+    }
+
+    void CommandList::releaseUnsubmittedCmdBuf()
+    {
+        // The current command buffer of a non-bundle list is cleared in executed(), so one that's still here was never submitted
+        if (m_CurrentCmdBuf && !m_Bundle)
+            m_Device->getQueue(m_CommandListParameters.queueType)->releaseCommandBuffer(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf = nullptr;
+    }
+
     nvrhi::Object CommandList::getNativeObject(ObjectType objectType)
     {
         switch (objectType)
@@ -48,13 +63,38 @@ namespace nvrhi::vulkan
 
     void CommandList::open()
     {
+        m_Statistics = CommandListStatistics();
+        m_UploadManager->resetStatistics();
+
+        if (m_Bundle)
+        {
+            openBundle();
+#ifndef NDEBUG
+            m_StorageCapacitiesAtOpen = getStorageCapacities();
+#endif
+            return;
+        }
+
+        releaseUnsubmittedCmdBuf();
+
         m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->getOrCreateCommandBuffer();
 
+#ifndef NDEBUG
+        // A command buffer that was just created from the pool has no storage yet, its growth counts as the pool miss
+        m_StorageCapacitiesAtOpen = getStorageCapacities();
+#endif
+
         auto beginInfo = vk::CommandBufferBeginInfo()
             .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 
         (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
-        m_CurrentCmdBuf->referencedResources.push_back(this); // prevent deletion of e.g. UploadManager
+
+        // binding sets only set their offsets in the descriptor buffer, which is bound once per command buffer
+        if (m_Context.descriptorBufferHeap && m_CommandListParameters.queueType != CommandQueue::Copy)
+        {
+            const vk::DescriptorBufferBindingInfoEXT bindingInfo = m_Context.descriptorBufferHeap->getBindingInfo();
+            m_CurrentCmdBuf->cmdBuf.bindDescriptorBuffersEXT(1, &bindingInfo);
+        }
 
         clearState();
     }
@@ -62,11 +102,16 @@ namespace nvrhi::vulkan
     void CommandList::close()
     {
         endRenderPass();
+        endConditionalRendering();
+
+        endSplitBarriers(nullptr);
 
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
 
+        resolveProfilerQueries();
+
 #ifdef NVRHI_WITH_RTXMU
         if (!m_CurrentCmdBuf->rtxmuBuildIds.empty())
         {
@@ -76,11 +121,42 @@ namespace nvrhi::vulkan
 
         m_CurrentCmdBuf->cmdBuf.end();
 
+        m_Statistics.uploadBytes = m_UploadManager->getSuballocatedBytes();
+        m_Statistics.uploadChunks = m_UploadManager->getAcquiredChunks();
+        m_Statistics.referencedResources = uint32_t(m_CurrentCmdBuf->referencedResources.size() + m_CurrentCmdBuf->referencedStagingBuffers.size());
+
         clearState();
 
         flushVolatileBufferWrites();
+
+#ifndef NDEBUG
+        const std::array<size_t, 3> capacities = getStorageCapacities();
+        for (size_t i = 0; i < capacities.size(); i++)
+        {
+            if (capacities[i] > m_StorageCapacitiesAtOpen[i])
+                m_Statistics.recordingAllocations++;
+        }
+#endif
+
+        m_StateTracker.commandListClosed();
     }
 
+#ifndef NDEBUG
+    std::array<size_t, 3> CommandList::getStorageCapacities() const
+    {
+        size_t commandBufferCapacity = 0;
+        if (m_CurrentCmdBuf)
+        {
+            commandBufferCapacity = m_CurrentCmdBuf->referencedResources.capacity() + m_CurrentCmdBuf->referencedStagingBuffers.capacity()
+                + m_CurrentCmdBuf->events.capacity();
+        }
+
+        const size_t commandListCapacity = m_VolatileBufferStates.capacity() + m_MappedMemoryRanges.capacity() + m_SplitBarriers.capacity();
+
+        return { commandBufferCapacity, commandListCapacity, m_StateTracker.getStorageCapacity() };
+    }
+#endif
+
     void CommandList::clearState()
     {
         endRenderPass();
@@ -92,6 +168,7 @@ namespace nvrhi::vulkan
         m_CurrentComputeState = ComputeState();
         m_CurrentMeshletState = MeshletState();
         m_CurrentRayTracingState = rt::State();
+        m_RenderPassFramebuffer = nullptr;
         m_CurrentShaderTablePointers = ShaderTableState();
 
         m_AnyVolatileBufferWrites = false;
@@ -109,6 +109,9 @@ namespace nvrhi::vulkan
                                 .setStage(shaderStageInfo)
                                 .setLayout(pso->pipelineLayout);
 
+        if (m_Context.descriptorBufferHeap)
+            pipelineInfo.flags |= vk::PipelineCreateFlagBits::eDescriptorBufferEXT;
+
         res = m_Context.device.createComputePipelines(m_Context.pipelineCache,
                                                     1, &pipelineInfo,
                                                     m_Context.allocationCallbacks,
@@ -174,14 +177,19 @@ namespace nvrhi::vulkan
         if (m_CurrentComputeState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, pso->pipeline);
+            m_Statistics.pipelineBinds++;
 
             m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
         }
 
-        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_CurrentPipelineLayout != pso->pipelineLayout)
         {
             bindBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, state.bindings);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, state.bindings);
+        }
 
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
@@ -213,7 +221,7 @@ namespace nvrhi::vulkan
         {
             ComputePipeline* pso = checked_cast<ComputePipeline*>(m_CurrentComputeState.pipeline);
 
-            bindBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, m_CurrentComputeState.bindings);
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, m_CurrentComputeState.bindings);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -226,6 +234,7 @@ namespace nvrhi::vulkan
         updateComputeVolatileBuffers();
 
         m_CurrentCmdBuf->cmdBuf.dispatch(groupsX, groupsY, groupsZ);
+        m_Statistics.dispatchCalls++;
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
@@ -237,7 +246,32 @@ namespace nvrhi::vulkan
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentComputeState.indirectParams);
         assert(indirectParams);
 
+        if (m_CurrentComputeState.indirectCountBuffer)
+        {
+            // There is no vkCmdDispatchIndirectCount, and ignoring the count could launch work that was culled
+            m_Context.error("ComputeState::indirectCountBuffer is not supported on Vulkan");
+            return;
+        }
+
         m_CurrentCmdBuf->cmdBuf.dispatchIndirect(indirectParams->buffer, offsetBytes);
+        m_Statistics.dispatchCalls++;
+    }
+
+    // Work graphs only exist as the experimental VK_AMDX_shader_enqueue extension, which is not supported
+    WorkGraphHandle Device::createWorkGraph(const WorkGraphDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    void CommandList::setWorkGraphState(const WorkGraphState&)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchGraph(const DispatchGraphArguments&)
+    {
+        utils::NotSupported();
     }
 
 } // namespace nvrhi::vulkan
@@ -329,6 +329,10 @@ namespace nvrhi::vulkan
             vk::PipelineStageFlagBits2::eMicromapBuildEXT,
             vk::AccessFlagBits2::eShaderRead,
             vk::ImageLayout::eUndefined },
+        { ResourceStates::Predication,
+            vk::PipelineStageFlagBits2::eConditionalRenderingEXT,
+            vk::AccessFlagBits2::eConditionalRenderingReadEXT,
+            vk::ImageLayout::eUndefined },
     };
 
     ResourceStateMappingInternal convertResourceStateInternal(ResourceStates state)
@@ -607,6 +611,43 @@ namespace nvrhi::vulkan
         }
     }
 
+    vk::AttachmentLoadOp convertAttachmentLoadOp(AttachmentLoadOp op)
+    {
+        switch(op)
+        {
+            case AttachmentLoadOp::Load:
+                return vk::AttachmentLoadOp::eLoad;
+
+            case AttachmentLoadOp::Clear:
+                return vk::AttachmentLoadOp::eClear;
+
+            case AttachmentLoadOp::DontCare:
+                return vk::AttachmentLoadOp::eDontCare;
+
+            default:
+                utils::InvalidEnum();
+                return vk::AttachmentLoadOp::eLoad;
+        }
+    }
+
+    vk::AttachmentStoreOp convertAttachmentStoreOp(AttachmentStoreOp op)
+    {
+        switch(op)
+        {
+            case AttachmentStoreOp::Store:
+                return vk::AttachmentStoreOp::eStore;
+
+            // The resolve itself is done through the resolve attachment, the multisampled contents are not needed
+            case AttachmentStoreOp::DontCare:
+            case AttachmentStoreOp::Resolve:
+                return vk::AttachmentStoreOp::eDontCare;
+
+            default:
+                utils::InvalidEnum();
+                return vk::AttachmentStoreOp::eStore;
+        }
+    }
+
     vk::StencilOpState convertStencilState(const DepthStencilState& depthStencilState, const DepthStencilState::StencilOpDesc& desc)
     {
         return vk::StencilOpState()
@@ -818,4 +859,23 @@ namespace nvrhi::vulkan
         }
     }
 
+    float convertResidencyPriority(ResidencyPriority priority)
+    {
+        // VK_EXT_memory_priority uses 0.5 for allocations without an explicit priority
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum:
+            return 0.f;
+        case ResidencyPriority::Low:
+            return 0.25f;
+        case ResidencyPriority::High:
+            return 0.75f;
+        case ResidencyPriority::Maximum:
+            return 1.f;
+        case ResidencyPriority::Normal:
+        default:
+            return 0.5f;
+        }
+    }
+
 } // namespace nvrhi::vulkan
@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+
+namespace nvrhi::vulkan
+{
+    vk::Result DescriptorBufferHeap::create(uint64_t size)
+    {
+        const auto& properties = m_Context.descriptorBufferProperties;
+
+        // Sets may contain both resources and samplers, so the buffer is bound as both kinds of descriptor buffer,
+        // and every offset in it must be valid for both
+        size = std::min({ size,
+            uint64_t(properties.maxResourceDescriptorBufferRange),
+            uint64_t(properties.maxSamplerDescriptorBufferRange),
+            uint64_t(properties.resourceDescriptorBufferAddressSpaceSize),
+            uint64_t(properties.samplerDescriptorBufferAddressSpaceSize) });
+
+        m_Buffer = RefCountPtr<Buffer>::Create(new Buffer(m_Context, m_Allocator));
+        m_Buffer->desc.byteSize = size;
+        m_Buffer->desc.cpuAccess = CpuAccessMode::Write;
+        m_Buffer->desc.debugName = "DescriptorBuffer";
+
+        auto bufferInfo = vk::BufferCreateInfo()
+            .setSize(size)
+            .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT
+                | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT
+                | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .setSharingMode(vk::SharingMode::eExclusive);
+
+        vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &m_Buffer->buffer);
+        CHECK_VK_RETURN(res)
+
+        m_Context.nameVKObject(VkBuffer(m_Buffer->buffer), vk::DebugReportObjectTypeEXT::eBuffer, m_Buffer->desc.debugName.c_str());
+
+        // Descriptors are written with plain CPU stores and never flushed, so the memory must be coherent
+        const vk::MemoryRequirements memRequirements = m_Context.device.getBufferMemoryRequirements(m_Buffer->buffer);
+        res = m_Allocator.allocateMemory(m_Buffer, memRequirements,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            /* enableDeviceAddress = */ true, /* enableExportMemory = */ false, nullptr, m_Buffer->buffer);
+        CHECK_VK_RETURN(res)
+
+        m_Context.device.bindBufferMemory(m_Buffer->buffer, m_Buffer->memory, 0);
+
+        m_Buffer->mappedMemory = m_Allocator.mapMemory(m_Buffer, 0, size);
+        if (!m_Buffer->mappedMemory)
+            return vk::Result::eErrorMemoryMapFailed;
+
+        m_MappedMemory = static_cast<uint8_t*>(m_Buffer->mappedMemory);
+        m_Buffer->deviceAddress = m_Context.device.getBufferAddress(vk::BufferDeviceAddressInfo().setBuffer(m_Buffer->buffer));
+
+        m_FreeRanges[0] = size;
+
+        return vk::Result::eSuccess;
+    }
+
+    bool DescriptorBufferHeap::allocate(uint64_t size, uint64_t& outOffset)
+    {
+        outOffset = 0;
+
+        if (size == 0)
+            return true;
+
+        size = align(size, uint64_t(m_Context.descriptorBufferProperties.descriptorBufferOffsetAlignment));
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // First fit: the free ranges are always aligned, and so are the allocation sizes
+        for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+        {
+            if (it->second < size)
+                continue;
+
+            outOffset = it->first;
+            const uint64_t remainingSize = it->second - size;
+            m_FreeRanges.erase(it);
+
+            if (remainingSize > 0)
+                m_FreeRanges[outOffset + size] = remainingSize;
+
+            // Unwritten descriptors, e.g. for NULL bindings, should not contain stale data from a previous set
+            memset(m_MappedMemory + outOffset, 0, size);
+            return true;
+        }
+
+        return false;
+    }
+
+    void DescriptorBufferHeap::release(uint64_t offset, uint64_t size)
+    {
+        if (size == 0)
+            return;
+
+        size = align(size, uint64_t(m_Context.descriptorBufferProperties.descriptorBufferOffsetAlignment));
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Merge with the following free range
+        auto next = m_FreeRanges.lower_bound(offset);
+        if (next != m_FreeRanges.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next = m_FreeRanges.erase(next);
+        }
+
+        // Merge with the preceding free range
+        if (next != m_FreeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                size += prev->second;
+                m_FreeRanges.erase(prev);
+            }
+        }
+
+        m_FreeRanges[offset] = size;
+    }
+
+    size_t DescriptorBufferHeap::getDescriptorSize(vk::DescriptorType type) const
+    {
+        const auto& properties = m_Context.descriptorBufferProperties;
+
+        switch (type)
+        {
+        case vk::DescriptorType::eSampler:
+            return properties.samplerDescriptorSize;
+        case vk::DescriptorType::eSampledImage:
+            return properties.sampledImageDescriptorSize;
+        case vk::DescriptorType::eStorageImage:
+            return properties.storageImageDescriptorSize;
+        case vk::DescriptorType::eUniformTexelBuffer:
+            return properties.uniformTexelBufferDescriptorSize;
+        case vk::DescriptorType::eStorageTexelBuffer:
+            return properties.storageTexelBufferDescriptorSize;
+        case vk::DescriptorType::eUniformBuffer:
+            return properties.uniformBufferDescriptorSize;
+        case vk::DescriptorType::eStorageBuffer:
+            return properties.storageBufferDescriptorSize;
+        case vk::DescriptorType::eAccelerationStructureKHR:
+            return properties.accelerationStructureDescriptorSize;
+        default:
+            utils::InvalidEnum();
+            return 0;
+        }
+    }
+
+    void DescriptorBufferHeap::writeDescriptor(uint64_t offset, vk::DescriptorType type,
+        const vk::DescriptorImageInfo* imageInfo, const vk::DescriptorAddressInfoEXT* addressInfo) const
+    {
+        auto getInfo = vk::DescriptorGetInfoEXT()
+            .setType(type);
+
+        switch (type)
+        {
+        case vk::DescriptorType::eSampler:
+            getInfo.data.setPSampler(&imageInfo->sampler);
+            break;
+        case vk::DescriptorType::eSampledImage:
+            getInfo.data.setPSampledImage(imageInfo);
+            break;
+        case vk::DescriptorType::eStorageImage:
+            getInfo.data.setPStorageImage(imageInfo);
+            break;
+        case vk::DescriptorType::eUniformTexelBuffer:
+            getInfo.data.setPUniformTexelBuffer(addressInfo);
+            break;
+        case vk::DescriptorType::eStorageTexelBuffer:
+            getInfo.data.setPStorageTexelBuffer(addressInfo);
+            break;
+        case vk::DescriptorType::eUniformBuffer:
+            getInfo.data.setPUniformBuffer(addressInfo);
+            break;
+        case vk::DescriptorType::eStorageBuffer:
+            getInfo.data.setPStorageBuffer(addressInfo);
+            break;
+        case vk::DescriptorType::eAccelerationStructureKHR:
+            getInfo.data.setAccelerationStructure(addressInfo->address);
+            break;
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+
+        m_Context.device.getDescriptorEXT(&getInfo, getDescriptorSize(type), m_MappedMemory + offset);
+    }
+
+    vk::DescriptorBufferBindingInfoEXT DescriptorBufferHeap::getBindingInfo() const
+    {
+        return vk::DescriptorBufferBindingInfoEXT()
+            .setAddress(m_Buffer->deviceAddress)
+            .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT);
+    }
+
+} // namespace nvrhi::vulkan
@@ -21,6 +21,12 @@
 */
 
 #include "vulkan-backend.h"
+#include "../common/pipeline-cache.h"
+#include "../common/transient-resource-pool.h"
+#include "../common/readback-ring.h"
+#include "../common/binding-set-cache.h"
+#include "../common/mip-generator.h"
+#include "../common/streaming-uploader.h"
 #include <unordered_map>
 
 #include <nvrhi/common/misc.h>
@@ -47,8 +53,19 @@ namespace nvrhi::vulkan
         
     Device::Device(const DeviceDesc& desc)
         : m_Context(desc.instance, desc.physicalDevice, desc.device, reinterpret_cast<vk::AllocationCallbacks*>(desc.allocationCallbacks))
-        , m_Allocator(m_Context)
+        , m_Allocator(m_Context, desc.memoryBlockSize)
         , m_TimerQueryAllocator(desc.maxTimerQueries, true)
+        , m_UploadChunkPool(
+            [this](uint64_t size) { return createBufferChunk(this, size, false); },
+            [this](CommandQueue queue) { return queueGetCompletedInstance(queue); })
+        , m_AccelStructPool(this)
+        , m_SubmissionCallbacks(
+            [this](CompletedInstances& completed) { getCompletedInstances(completed); },
+            [this](const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+            {
+                // Flush so that deferred submissions that the callbacks wait for reach the GPU
+                waitForSubmissions(submissions, count, true, timeout, true);
+            })
     {
         if (desc.graphicsQueue)
         {
@@ -68,6 +85,23 @@ namespace nvrhi::vulkan
                 CommandQueue::Copy, desc.transferQueue, desc.transferQueueIndex);
         }
 
+        for (auto& queue : m_Queues)
+        {
+            if (queue)
+                queue->setDeferSubmissions(desc.deferQueueSubmissions);
+        }
+
+        // Buffers and images use exclusive sharing mode, so their ownership has to be transferred
+        // when they move between queues from different families
+        for (const auto& queue : m_Queues)
+        {
+            if (queue && m_Queues[uint32_t(CommandQueue::Graphics)] &&
+                queue->getQueueFamilyIndex() != m_Queues[uint32_t(CommandQueue::Graphics)]->getQueueFamilyIndex())
+            {
+                m_QueueOwnershipTransfersNeeded = true;
+            }
+        }
+
         // maps Vulkan extension strings into the corresponding boolean flags in Device
         const std::unordered_map<std::string, bool*> extensionStringMap = {
             { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, &m_Context.extensions.KHR_synchronization2 },
@@ -75,14 +109,29 @@ namespace nvrhi::vulkan
             { VK_EXT_DEBUG_REPORT_EXTENSION_NAME, &m_Context.extensions.EXT_debug_report },
             { VK_EXT_DEBUG_MARKER_EXTENSION_NAME, &m_Context.extensions.EXT_debug_marker },
             { VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME, &m_Context.extensions.KHR_acceleration_structure },
+            { VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME, &m_Context.extensions.KHR_deferred_host_operations },
             { VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME, &m_Context.extensions.buffer_device_address },
+            { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, &m_Context.extensions.draw_indirect_count },
+            { VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, &m_Context.extensions.dynamic_rendering },
             { VK_KHR_RAY_QUERY_EXTENSION_NAME,&m_Context.extensions.KHR_ray_query },
             { VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, &m_Context.extensions.KHR_ray_tracing_pipeline },
             { VK_NV_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.NV_mesh_shader },
+            { VK_EXT_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.EXT_mesh_shader },
             { VK_EXT_CONSERVATIVE_RASTERIZATION_EXTENSION_NAME, &m_Context.extensions.EXT_conservative_rasterization},
             { VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME, &m_Context.extensions.KHR_fragment_shading_rate },
             { VK_EXT_OPACITY_MICROMAP_EXTENSION_NAME, &m_Context.extensions.EXT_opacity_micromap },
             { VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_invocation_reorder },
+            { VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, &m_Context.extensions.KHR_push_descriptor },
+            { VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, &m_Context.extensions.EXT_descriptor_buffer },
+            { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.KHR_pipeline_library },
+            { VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.EXT_graphics_pipeline_library },
+            { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, &m_Context.extensions.EXT_memory_budget },
+            { VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME, &m_Context.extensions.EXT_memory_priority },
+            { VK_AMD_BUFFER_MARKER_EXTENSION_NAME, &m_Context.extensions.AMD_buffer_marker },
+            { VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME, &m_Context.extensions.EXT_conditional_rendering },
+#if NVRHI_VULKAN_WITH_HOST_IMAGE_COPY
+            { VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME, &m_Context.extensions.EXT_host_image_copy },
+#endif
         };
 
         // parse the extension/layer lists and figure out which extensions are enabled
@@ -108,6 +157,14 @@ namespace nvrhi::vulkan
         if (desc.bufferDeviceAddressSupported)
             m_Context.extensions.buffer_device_address = true;
 
+        // Same for drawIndirectCount. The dynamic dispatcher aliases the core and KHR entry points, so either works.
+        if (desc.drawIndirectCountSupported)
+            m_Context.extensions.draw_indirect_count = true;
+
+        // And for dynamicRendering, which was promoted to core in Vulkan 1.3
+        if (desc.dynamicRenderingSupported)
+            m_Context.extensions.dynamic_rendering = true;
+
         void* pNext = nullptr;
         vk::PhysicalDeviceAccelerationStructurePropertiesKHR accelStructProperties;
         vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingPipelineProperties;
@@ -115,6 +172,8 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceFragmentShadingRatePropertiesKHR shadingRateProperties;
         vk::PhysicalDeviceOpacityMicromapPropertiesEXT opacityMicromapProperties;
         vk::PhysicalDeviceRayTracingInvocationReorderPropertiesNV nvRayTracingInvocationReorderProperties;
+        vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties;
+        vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
         
         vk::PhysicalDeviceProperties2 deviceProperties2;
 
@@ -154,19 +213,71 @@ namespace nvrhi::vulkan
             pNext = &nvRayTracingInvocationReorderProperties;
         }
 
+        if (m_Context.extensions.EXT_descriptor_buffer)
+        {
+            descriptorBufferProperties.pNext = pNext;
+            pNext = &descriptorBufferProperties;
+        }
+
+        if (m_Context.extensions.EXT_graphics_pipeline_library)
+        {
+            graphicsPipelineLibraryProperties.pNext = pNext;
+            pNext = &graphicsPipelineLibraryProperties;
+        }
+
         deviceProperties2.pNext = pNext;
 
         m_Context.physicalDevice.getProperties2(&deviceProperties2);
 
         m_Context.physicalDeviceProperties = deviceProperties2.properties;
+        m_Context.physicalDeviceFeatures = m_Context.physicalDevice.getFeatures();
         m_Context.accelStructProperties = accelStructProperties;
         m_Context.rayTracingPipelineProperties = rayTracingPipelineProperties;
         m_Context.conservativeRasterizationProperties = conservativeRasterizationProperties;
         m_Context.shadingRateProperties = shadingRateProperties;
         m_Context.opacityMicromapProperties = opacityMicromapProperties;
         m_Context.nvRayTracingInvocationReorderProperties = nvRayTracingInvocationReorderProperties;
+        m_Context.descriptorBufferProperties = descriptorBufferProperties;
+        m_Context.graphicsPipelineLibraryProperties = graphicsPipelineLibraryProperties;
         m_Context.messageCallback = desc.errorCB;
 
+        if (desc.descriptorBufferSupported)
+        {
+            if (!m_Context.extensions.EXT_descriptor_buffer || !m_Context.extensions.buffer_device_address)
+            {
+                m_Context.warning("DeviceDesc::descriptorBufferSupported is set, but VK_EXT_descriptor_buffer or bufferDeviceAddress "
+                    "is not enabled. Binding sets will use descriptor pools.");
+            }
+            else
+            {
+                m_DescriptorBufferHeap = std::make_unique<DescriptorBufferHeap>(m_Context, m_Allocator);
+                if (m_DescriptorBufferHeap->create(desc.descriptorBufferSize) == vk::Result::eSuccess)
+                    m_Context.descriptorBufferHeap = m_DescriptorBufferHeap.get();
+                else
+                {
+                    m_Context.error("Failed to create the descriptor buffer, binding sets will use descriptor pools");
+                    m_DescriptorBufferHeap.reset();
+                }
+            }
+        }
+
+        if (desc.graphicsPipelineLibrarySupported)
+        {
+            if (!m_Context.extensions.EXT_graphics_pipeline_library || !m_Context.extensions.KHR_pipeline_library)
+            {
+                m_Context.warning("DeviceDesc::graphicsPipelineLibrarySupported is set, but VK_EXT_graphics_pipeline_library "
+                    "or VK_KHR_pipeline_library is not enabled. Graphics pipelines will be created without libraries.");
+            }
+            else if (!graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking)
+            {
+                // Without fast linking, linking the libraries may take as long as creating the whole pipeline
+                m_Context.warning("The device doesn't support fast linking of graphics pipeline libraries. "
+                    "Graphics pipelines will be created without libraries.");
+            }
+            else
+                m_PipelineLibraryCache = std::make_unique<GraphicsPipelineLibraryCache>(m_Context);
+        }
+
         if (m_Context.extensions.EXT_opacity_micromap && !m_Context.extensions.KHR_synchronization2)
         {
             m_Context.warning(
@@ -210,6 +321,10 @@ namespace nvrhi::vulkan
 
     Device::~Device()
     {
+        if (m_SubmissionCallbacks.hasPendingCallbacks())
+            waitForIdle();
+        m_SubmissionCallbacks.shutdown();
+
         if (m_TimerQueryPool)
         {
             m_Context.device.destroyQueryPool(m_TimerQueryPool);
@@ -247,18 +362,139 @@ namespace nvrhi::vulkan
 
     void Device::waitForIdle()
     {
+        flushQueueSubmissions();
+
         m_Context.device.waitIdle();
     }
 
+    void Device::flushSubmissions()
+    {
+        flushQueueSubmissions();
+    }
+
+    void Device::flushQueueSubmissions() const
+    {
+        for (auto& queue : m_Queues)
+        {
+            if (queue)
+                queue->flushSubmissions();
+        }
+    }
+
+    void Device::getCompletedInstances(CompletedInstances& completed) const
+    {
+        for (size_t queueIndex = 0; queueIndex < completed.size(); queueIndex++)
+        {
+            const Queue* queue = m_Queues[queueIndex].get();
+            completed[queueIndex] = queue ? m_Context.device.getSemaphoreCounterValue(queue->trackingSemaphore) : ~0ull;
+        }
+    }
+
+    uint64_t Device::getCompletedInstance(CommandQueue queue)
+    {
+        const Queue* pQueue = queue < CommandQueue::Count ? getQueue(queue) : nullptr;
+
+        // Deferred submissions must reach the GPU, or an application that polls this would never see them complete
+        flushQueueSubmissions();
+
+        return pQueue ? m_Context.device.getSemaphoreCounterValue(pQueue->trackingSemaphore) : 0;
+    }
+
+    bool Device::waitForSubmissions(const SubmissionPoint* submissions, size_t count, bool waitAny, uint64_t timeout, bool flush) const
+    {
+        if (count == 0)
+            return !waitAny;
+
+        // Deferred submissions must reach the GPU before they can complete
+        if (flush)
+            flushQueueSubmissions();
+
+        std::vector<vk::Semaphore> semaphores;
+        std::vector<uint64_t> values;
+        semaphores.reserve(count);
+        values.reserve(count);
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const SubmissionPoint& submission = submissions[index];
+            const Queue* queue = submission.queue < CommandQueue::Count ? getQueue(submission.queue) : nullptr;
+
+            if (!queue || submission.instance == 0)
+            {
+                // This submission counts as completed
+                if (waitAny)
+                    return true;
+                continue;
+            }
+
+            semaphores.push_back(queue->trackingSemaphore);
+            values.push_back(submission.instance);
+        }
+
+        if (semaphores.empty())
+            return true;
+
+        auto waitInfo = vk::SemaphoreWaitInfo()
+            .setFlags(waitAny ? vk::SemaphoreWaitFlagBits::eAny : vk::SemaphoreWaitFlags())
+            .setSemaphores(semaphores)
+            .setValues(values);
+
+        return m_Context.device.waitSemaphores(waitInfo, timeout) == vk::Result::eSuccess;
+    }
+
+    bool Device::waitForAll(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        return waitForSubmissions(submissions, count, false, timeout, true);
+    }
+
+    size_t Device::waitForAny(const SubmissionPoint* submissions, size_t count, uint64_t timeout)
+    {
+        if (!waitForSubmissions(submissions, count, true, timeout, true))
+            return count;
+
+        CompletedInstances completed;
+        getCompletedInstances(completed);
+        return findCompletedSubmission(submissions, count, completed);
+    }
+
+    void Device::notifyOnCompletion(const SubmissionPoint* submissions, size_t count, bool waitAny, SubmissionCallback callback)
+    {
+        m_SubmissionCallbacks.add(submissions, count, waitAny, std::move(callback));
+    }
+
     void Device::runGarbageCollection()
     {
+        runGarbageCollection(GarbageCollectionBudget());
+    }
+
+    bool Device::runGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        flushQueueSubmissions();
+
+        GarbageCollectionBudgetTracker budgetTracker(budget);
+        bool allRetired = true;
+
         for (auto& m_Queue : m_Queues)
         {
             if (m_Queue)
             {
-                m_Queue->retireCommandBuffers();
+                allRetired &= m_Queue->retireCommandBuffers(budgetTracker);
             }
         }
+
+        m_UploadChunkPool.endFrame();
+
+        return allRetired;
+    }
+
+    void Device::setUploadPoolSettings(const UploadPoolSettings& settings)
+    {
+        m_UploadChunkPool.setSettings(settings);
+    }
+
+    UploadPoolStatistics Device::getUploadPoolStatistics()
+    {
+        return m_UploadChunkPool.getStatistics();
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -290,7 +526,7 @@ namespace nvrhi::vulkan
         case Feature::ShaderSpecializations:
             return true;
         case Feature::Meshlets:
-            return m_Context.extensions.NV_mesh_shader;
+            return m_Context.extensions.NV_mesh_shader || m_Context.extensions.EXT_mesh_shader;
         case Feature::VariableRateShading:
             if (pInfo)
             {
@@ -306,6 +542,8 @@ namespace nvrhi::vulkan
             return m_Context.extensions.KHR_fragment_shading_rate && m_Context.shadingRateFeatures.attachmentFragmentShadingRate;
         case Feature::ConservativeRasterization:
             return m_Context.extensions.EXT_conservative_rasterization;
+        case Feature::PushDescriptors:
+            return m_Context.extensions.KHR_push_descriptor && !m_Context.descriptorBufferHeap;
         case Feature::VirtualResources:
             return true;
         case Feature::ComputeQueue:
@@ -314,6 +552,25 @@ namespace nvrhi::vulkan
             return (m_Queues[uint32_t(CommandQueue::Copy)] != nullptr);
         case Feature::ConstantBufferRanges:
             return true;
+        case Feature::DrawIndirectCount:
+            return m_Context.extensions.draw_indirect_count;
+        case Feature::TiledResources:
+            return m_Context.physicalDeviceFeatures.sparseBinding
+                && m_Queues[uint32_t(CommandQueue::Graphics)] && m_Queues[uint32_t(CommandQueue::Graphics)]->supportsSparseBinding()
+                && m_Context.physicalDeviceFeatures.sparseResidencyBuffer
+                && m_Context.physicalDeviceFeatures.sparseResidencyImage2D;
+        case Feature::DeviceLocalUploadHeap:
+            return m_Allocator.isDeviceLocalUploadMemoryAvailable();
+        case Feature::DirectTextureWrite:
+            return m_Context.extensions.EXT_host_image_copy;
+        case Feature::OcclusionQueries:
+            return true;
+        case Feature::PipelineStatisticsQueries:
+            return m_Context.physicalDeviceFeatures.pipelineStatisticsQuery;
+        case Feature::Predication:
+            return m_Context.extensions.EXT_conditional_rendering;
+        case Feature::GpuVirtualAddress:
+            return m_Context.extensions.buffer_device_address;
         default:
             return false;
         }
@@ -401,11 +658,21 @@ namespace nvrhi::vulkan
     {
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
 
-        uint64_t submissionID = queue.submit(pCommandLists, numCommandLists);
+        // The ownership transfers submit to other queues, and the owners must be updated in submission order
+        std::unique_lock<std::mutex> ownershipLock(m_QueueOwnershipMutex, std::defer_lock);
+        TrackedCommandBufferPtr acquireCmdBuf;
+        if (m_QueueOwnershipTransfersNeeded)
+        {
+            ownershipLock.lock();
+            acquireCmdBuf = transferQueueOwnership(queue, pCommandLists, numCommandLists);
+        }
+
+        uint64_t submissionID = queue.submit(pCommandLists, numCommandLists, acquireCmdBuf);
 
         for (size_t i = 0; i < numCommandLists; i++)
         {
-            checked_cast<CommandList*>(pCommandLists[i])->executed(queue, submissionID);
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            commandList->executed(queue, submissionID);
         }
 
         return submissionID;
@@ -442,7 +709,8 @@ namespace nvrhi::vulkan
         // Set the Device Address bit if that feature is supported, because the heap might be used to store acceleration structures
         const bool enableDeviceAddress = m_Context.extensions.buffer_device_address;
 
-        const vk::Result res = m_Allocator.allocateMemory(heap, memoryRequirements, memoryPropertyFlags, enableDeviceAddress);
+        const vk::Result res = m_Allocator.allocateMemory(heap, memoryRequirements, memoryPropertyFlags, enableDeviceAddress,
+            false, nullptr, nullptr, d.residencyPriority);
 
         if (res != vk::Result::eSuccess)
         {
@@ -464,6 +732,31 @@ namespace nvrhi::vulkan
         return HeapHandle::Create(heap);
     }
 
+    TransientResourcePoolHandle Device::createTransientResourcePool(const TransientResourcePoolDesc& desc)
+    {
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(this, desc));
+    }
+
+    StreamingUploaderHandle Device::createStreamingUploader(const StreamingUploaderDesc& desc)
+    {
+        return StreamingUploaderHandle::Create(new StreamingUploader(this, desc));
+    }
+
+    ReadbackRingHandle Device::createReadbackRing(const ReadbackRingDesc& desc)
+    {
+        return ReadbackRing::create(this, desc);
+    }
+
+    BindingSetCacheHandle Device::createBindingSetCache()
+    {
+        return BindingSetCacheHandle::Create(new BindingSetCache(this));
+    }
+
+    MipGeneratorHandle Device::createMipGenerator()
+    {
+        return MipGenerator::create(this);
+    }
+
     Heap::~Heap()
     {
         if (memory && managed)
@@ -473,6 +766,182 @@ namespace nvrhi::vulkan
         }
     }
 
+    MemoryAllocatorStatistics Device::getMemoryAllocatorStatistics()
+    {
+        return m_Allocator.getStatistics();
+    }
+
+    bool Device::queryMemoryBudget(MemoryBudget& outBudget)
+    {
+        if (!m_Context.extensions.EXT_memory_budget)
+            return false;
+
+        const auto propertiesChain = m_Context.physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties = propertiesChain.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+        const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& budgetProperties = propertiesChain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+        outBudget = MemoryBudget();
+
+        for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; heapIndex++)
+        {
+            if (memoryProperties.memoryHeaps[heapIndex].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+            {
+                outBudget.localBudget += budgetProperties.heapBudget[heapIndex];
+                outBudget.localUsage += budgetProperties.heapUsage[heapIndex];
+            }
+            else
+            {
+                outBudget.nonLocalBudget += budgetProperties.heapBudget[heapIndex];
+                outBudget.nonLocalUsage += budgetProperties.heapUsage[heapIndex];
+            }
+        }
+
+        return true;
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(bool reset)
+    {
+        // The statistics are collected per queue, so that submissions to different queues don't share any state
+        CommandListStatistics statistics;
+        for (const auto& queue : m_Queues)
+        {
+            if (queue)
+                statistics += queue->getStatistics(reset);
+        }
+        return statistics;
+    }
+
+    static PipelineCacheIdentity getPipelineCacheIdentity(const vk::PhysicalDeviceProperties& properties)
+    {
+        PipelineCacheIdentity identity;
+        identity.graphicsAPI = GraphicsAPI::VULKAN;
+        identity.vendorID = properties.vendorID;
+        identity.deviceID = properties.deviceID;
+        identity.driverVersion = properties.driverVersion;
+        static_assert(sizeof(identity.cacheUUID) == VK_UUID_SIZE);
+        memcpy(identity.cacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+        return identity;
+    }
+
+    // The tasks hold a reference to the device, because they may be joined after the application has released it
+
+    PipelineCreationTaskHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+        {
+            m_Context.error("createGraphicsPipelineAsync: the framebuffer is NULL");
+            return PipelineCreationTask::createCompleted(GraphicsPipelineHandle());
+        }
+
+        FramebufferHandle framebuffer = fb;
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc, framebuffer](PipelineCreationTask& task)
+        {
+            task.setResult(device->createGraphicsPipeline(desc, framebuffer));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    PipelineCreationTaskHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc)
+    {
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc](PipelineCreationTask& task)
+        {
+            task.setResult(device->createComputePipeline(desc));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    PipelineCreationTaskHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+        {
+            m_Context.error("createMeshletPipelineAsync: the framebuffer is NULL");
+            return PipelineCreationTask::createCompleted(MeshletPipelineHandle());
+        }
+
+        FramebufferHandle framebuffer = fb;
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc, framebuffer](PipelineCreationTask& task)
+        {
+            task.setResult(device->createMeshletPipeline(desc, framebuffer));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    PipelineCreationTaskHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc)
+    {
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), desc](PipelineCreationTask& task)
+        {
+            task.setResult(device->createRayTracingPipeline(desc, &task));
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+
+    bool Device::loadPipelineCache(const void* data, size_t size)
+    {
+        const PipelineCacheIdentity identity = getPipelineCacheIdentity(m_Context.physicalDeviceProperties);
+
+        const void* payload = nullptr;
+        size_t payloadSize = 0;
+        bool accepted = true;
+        if (data && size)
+        {
+            accepted = readPipelineCacheBlob(identity, data, size, payload, payloadSize);
+            if (!accepted)
+                m_Context.warning("The pipeline cache data is corrupted or was created by a different device or driver, ignoring it");
+        }
+
+        auto cacheInfo = vk::PipelineCacheCreateInfo()
+            .setInitialDataSize(payloadSize)
+            .setPInitialData(payload);
+
+        vk::PipelineCache newCache;
+        vk::Result res = m_Context.device.createPipelineCache(&cacheInfo, m_Context.allocationCallbacks, &newCache);
+
+        if (res != vk::Result::eSuccess && payloadSize != 0)
+        {
+            // The driver may still reject data that passed the header check, fall back to an empty cache
+            accepted = false;
+            cacheInfo.setInitialDataSize(0).setPInitialData(nullptr);
+            res = m_Context.device.createPipelineCache(&cacheInfo, m_Context.allocationCallbacks, &newCache);
+        }
+
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to create the pipeline cache");
+            return false;
+        }
+
+        if (m_Context.pipelineCache)
+        {
+            // Keep the pipelines that were created before the cache was loaded
+            (void)m_Context.device.mergePipelineCaches(newCache, 1, &m_Context.pipelineCache);
+            m_Context.device.destroyPipelineCache(m_Context.pipelineCache, m_Context.allocationCallbacks);
+        }
+
+        m_Context.pipelineCache = newCache;
+        return accepted;
+    }
+
+    bool Device::savePipelineCache(std::vector<uint8_t>& outData)
+    {
+        outData.clear();
+
+        if (!m_Context.pipelineCache)
+            return false;
+
+        size_t dataSize = 0;
+        vk::Result res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, &dataSize, nullptr);
+        if (res != vk::Result::eSuccess)
+            return false;
+
+        std::vector<uint8_t> payload(dataSize);
+        res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, &dataSize, payload.data());
+        if (res != vk::Result::eSuccess && res != vk::Result::eIncomplete)
+            return false;
+
+        writePipelineCacheBlob(getPipelineCacheIdentity(m_Context.physicalDeviceProperties), payload.data(), dataSize, outData);
+        return true;
+    }
+
     void VulkanContext::nameVKObject(const void* handle, const vk::DebugReportObjectTypeEXT objtype, const char* name) const
     {
         if (extensions.EXT_debug_marker && name && *name && handle)
@@ -27,7 +27,7 @@ namespace nvrhi::vulkan
 {
 
     template <typename T>
-    using attachment_vector = nvrhi::static_vector<T, c_MaxRenderTargets + 1>; // render targets + depth
+    using attachment_vector = nvrhi::static_vector<T, c_MaxRenderTargets * 2 + 2>; // render targets + depth + shading rate + resolve targets
 
     static TextureDimension getDimensionForFramebuffer(TextureDimension dimension, bool isArray)
     {
@@ -57,19 +57,38 @@ namespace nvrhi::vulkan
         return dimension;
     }
 
+    static vk::ClearColorValue convertClearColor(const Color& color, Format format)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(format);
+        auto clearValue = vk::ClearColorValue();
+
+        if (formatInfo.kind == FormatKind::Integer && formatInfo.isSigned)
+            clearValue.setInt32({ int32_t(color.r), int32_t(color.g), int32_t(color.b), int32_t(color.a) });
+        else if (formatInfo.kind == FormatKind::Integer)
+            clearValue.setUint32({ uint32_t(color.r), uint32_t(color.g), uint32_t(color.b), uint32_t(color.a) });
+        else
+            clearValue.setFloat32({ color.r, color.g, color.b, color.a });
+
+        return clearValue;
+    }
+
     FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
     {
         Framebuffer *fb = new Framebuffer(m_Context);
         fb->desc = desc;
         fb->framebufferInfo = FramebufferInfoEx(desc);
+        fb->framebufferInfoHash = std::hash<FramebufferInfo>()(fb->framebufferInfo);
 
         attachment_vector<vk::AttachmentDescription2> attachmentDescs(desc.colorAttachments.size());
         attachment_vector<vk::AttachmentReference2> colorAttachmentRefs(desc.colorAttachments.size());
         vk::AttachmentReference2 depthAttachmentRef;
 
-        static_vector<vk::ImageView, c_MaxRenderTargets + 1> attachmentViews;
+        attachment_vector<vk::ImageView> attachmentViews;
         attachmentViews.resize(desc.colorAttachments.size());
 
+        bool anyClear = false;
+        bool anyNonLoad = false;
+
         uint32_t numArraySlices = 0;
 
         for(uint32_t i = 0; i < desc.colorAttachments.size(); i++)
@@ -85,11 +104,18 @@ namespace nvrhi::vulkan
             attachmentDescs[i] = vk::AttachmentDescription2()
                                         .setFormat(attachmentFormat)
                                         .setSamples(t->imageInfo.samples)
-                                        .setLoadOp(vk::AttachmentLoadOp::eLoad)
-                                        .setStoreOp(vk::AttachmentStoreOp::eStore)
+                                        .setLoadOp(convertAttachmentLoadOp(rt.loadOp))
+                                        .setStoreOp(convertAttachmentStoreOp(rt.storeOp))
                                         .setInitialLayout(vk::ImageLayout::eColorAttachmentOptimal)
                                         .setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal);
 
+            fb->clearValues.push_back(vk::ClearValue().setColor(
+                convertClearColor(rt.clearColor, rt.format == Format::UNKNOWN ? t->desc.format : rt.format)));
+
+            anyClear = anyClear || rt.loadOp == AttachmentLoadOp::Clear;
+            anyNonLoad = anyNonLoad || rt.loadOp != AttachmentLoadOp::Load;
+            fb->discardsContents = fb->discardsContents || rt.storeOp != AttachmentStoreOp::Store;
+
             colorAttachmentRefs[i] = vk::AttachmentReference2()
                                         .setAttachment(i)
                                         .setLayout(vk::ImageLayout::eColorAttachmentOptimal);
@@ -125,14 +151,26 @@ namespace nvrhi::vulkan
                 depthLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
             }
 
+            // Read-only depth attachments are never cleared or discarded
+            const vk::AttachmentLoadOp loadOp = att.isReadOnly ? vk::AttachmentLoadOp::eLoad : convertAttachmentLoadOp(att.loadOp);
+            const vk::AttachmentStoreOp storeOp = att.isReadOnly ? vk::AttachmentStoreOp::eStore : convertAttachmentStoreOp(att.storeOp);
+
             attachmentDescs.push_back(vk::AttachmentDescription2()
                                         .setFormat(texture->imageInfo.format)
                                         .setSamples(texture->imageInfo.samples)
-                                        .setLoadOp(vk::AttachmentLoadOp::eLoad)
-                                        .setStoreOp(vk::AttachmentStoreOp::eStore)
+                                        .setLoadOp(loadOp)
+                                        .setStoreOp(storeOp)
+                                        .setStencilLoadOp(loadOp)
+                                        .setStencilStoreOp(storeOp)
                                         .setInitialLayout(depthLayout)
                                         .setFinalLayout(depthLayout));
 
+            fb->clearValues.push_back(vk::ClearValue().setDepthStencil(vk::ClearDepthStencilValue(att.clearDepth, att.clearStencil)));
+
+            anyClear = anyClear || loadOp == vk::AttachmentLoadOp::eClear;
+            anyNonLoad = anyNonLoad || loadOp != vk::AttachmentLoadOp::eLoad;
+            fb->discardsContents = fb->discardsContents || storeOp != vk::AttachmentStoreOp::eStore;
+
             depthAttachmentRef = vk::AttachmentReference2()
                                     .setAttachment(uint32_t(attachmentDescs.size()) - 1)
                                     .setLayout(depthLayout);
@@ -208,6 +246,85 @@ namespace nvrhi::vulkan
             subpass.setPNext(&shadingRateAttachmentInfo);
         }
 
+        // add resolve attachments for the color attachments that use AttachmentStoreOp::Resolve
+        attachment_vector<vk::AttachmentReference2> resolveAttachmentRefs(desc.colorAttachments.size());
+        bool anyResolve = false;
+
+        for (uint32_t i = 0; i < desc.colorAttachments.size(); i++)
+        {
+            const auto& rt = desc.colorAttachments[i];
+
+            if (rt.storeOp != AttachmentStoreOp::Resolve || !rt.resolveTexture)
+            {
+                resolveAttachmentRefs[i] = vk::AttachmentReference2()
+                    .setAttachment(VK_ATTACHMENT_UNUSED);
+                fb->colorAttachmentResolveViews.push_back(vk::ImageView());
+                continue;
+            }
+
+            Texture* resolveTexture = checked_cast<Texture*>(rt.resolveTexture);
+
+            attachmentDescs.push_back(vk::AttachmentDescription2()
+                .setFormat(attachmentDescs[i].format)
+                .setSamples(vk::SampleCountFlagBits::e1)
+                .setLoadOp(vk::AttachmentLoadOp::eDontCare)
+                .setStoreOp(vk::AttachmentStoreOp::eStore)
+                .setInitialLayout(vk::ImageLayout::eColorAttachmentOptimal)
+                .setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal));
+
+            resolveAttachmentRefs[i] = vk::AttachmentReference2()
+                .setAttachment(uint32_t(attachmentDescs.size()) - 1)
+                .setLayout(vk::ImageLayout::eColorAttachmentOptimal);
+
+            TextureSubresourceSet subresources = rt.resolveSubresources.resolve(resolveTexture->desc, true);
+            TextureDimension dimension = getDimensionForFramebuffer(resolveTexture->desc.dimension, subresources.numArraySlices > 1);
+
+            const auto& view = resolveTexture->getSubresourceView(subresources, dimension, rt.format, vk::ImageUsageFlagBits::eColorAttachment);
+            attachmentViews.push_back(view.view);
+            fb->colorAttachmentResolveViews.push_back(view.view);
+
+            fb->resources.push_back(rt.resolveTexture);
+            anyResolve = true;
+        }
+
+        if (anyResolve)
+            subpass.setPResolveAttachments(resolveAttachmentRefs.data());
+
+        if (!anyClear)
+            fb->clearValues.resize(0);
+
+        if (m_Context.extensions.dynamic_rendering)
+        {
+            // Dynamic rendering doesn't need render pass or framebuffer objects,
+            // keep the views and formats for vkCmdBeginRendering and pipeline creation instead
+            for (uint32_t i = 0; i < desc.colorAttachments.size(); i++)
+            {
+                fb->colorAttachmentFormats.push_back(attachmentDescs[i].format);
+                fb->colorAttachmentViews.push_back(attachmentViews[i]);
+            }
+
+            if (desc.depthAttachment.valid())
+            {
+                const uint32_t depthIndex = uint32_t(desc.colorAttachments.size());
+                const Texture* texture = checked_cast<Texture*>(desc.depthAttachment.texture);
+
+                fb->depthAttachmentFormat = attachmentDescs[depthIndex].format;
+                fb->depthAttachmentView = attachmentViews[depthIndex];
+                fb->depthAttachmentLayout = depthAttachmentRef.layout;
+                fb->depthAttachmentHasStencil = getFormatInfo(texture->desc.format).hasStencil;
+            }
+
+            if (desc.shadingRateAttachment.valid())
+            {
+                fb->shadingRateAttachmentView = attachmentViews[attachmentViews.size() - 1];
+                fb->shadingRateAttachmentTexelSize = shadingRateAttachmentInfo.shadingRateAttachmentTexelSize;
+            }
+
+            fb->layerCount = std::max(numArraySlices, 1u);
+
+            return FramebufferHandle::Create(fb);
+        }
+
         auto renderPassInfo = vk::RenderPassCreateInfo2()
                     .setAttachmentCount(uint32_t(attachmentDescs.size()))
                     .setPAttachments(attachmentDescs.data())
@@ -218,6 +335,24 @@ namespace nvrhi::vulkan
                                                            m_Context.allocationCallbacks,
                                                            &fb->renderPass);
         CHECK_VK_FAIL(res)
+
+        // Render passes that are suspended mid-way, e.g. for a copy or a barrier, must resume with the contents
+        // preserved, so create a compatible render pass that loads all attachments for that case
+        if (anyNonLoad)
+        {
+            // Only the color and depth attachments, the resolve attachments are overwritten anyway
+            const size_t numLoadedAttachments = desc.colorAttachments.size() + (desc.depthAttachment.valid() ? 1 : 0);
+            for (size_t i = 0; i < numLoadedAttachments; i++)
+            {
+                attachmentDescs[i].setLoadOp(vk::AttachmentLoadOp::eLoad);
+                attachmentDescs[i].setStencilLoadOp(vk::AttachmentLoadOp::eLoad);
+            }
+
+            res = m_Context.device.createRenderPass2(&renderPassInfo,
+                                                    m_Context.allocationCallbacks,
+                                                    &fb->resumeRenderPass);
+            CHECK_VK_FAIL(res)
+        }
         
         // set up the framebuffer object
         auto framebufferInfo = vk::FramebufferCreateInfo()
@@ -241,6 +376,7 @@ namespace nvrhi::vulkan
         Framebuffer* fb = new Framebuffer(m_Context);
         fb->desc = desc;
         fb->framebufferInfo = FramebufferInfoEx(desc);
+        fb->framebufferInfoHash = std::hash<FramebufferInfo>()(fb->framebufferInfo);
         fb->renderPass = renderPass;
         fb->framebuffer = framebuffer;
         fb->managed = transferOwnership;
@@ -272,6 +408,21 @@ namespace nvrhi::vulkan
             m_Context.device.destroyRenderPass(renderPass);
             renderPass = nullptr;
         }
+
+        if (resumeRenderPass && managed)
+        {
+            m_Context.device.destroyRenderPass(resumeRenderPass);
+            resumeRenderPass = nullptr;
+        }
+    }
+
+    vk::PipelineRenderingCreateInfo Framebuffer::getPipelineRenderingInfo() const
+    {
+        return vk::PipelineRenderingCreateInfo()
+            .setColorAttachmentCount(uint32_t(colorAttachmentFormats.size()))
+            .setPColorAttachmentFormats(colorAttachmentFormats.data())
+            .setDepthAttachmentFormat(depthAttachmentFormat)
+            .setStencilAttachmentFormat(depthAttachmentHasStencil ? depthAttachmentFormat : vk::Format::eUndefined);
     }
 
     Object Framebuffer::getNativeObject(ObjectType objectType)
@@ -371,6 +522,7 @@ namespace nvrhi::vulkan
         GraphicsPipeline *pso = new GraphicsPipeline(m_Context);
         pso->desc = desc;
         pso->framebufferInfo = fb->framebufferInfo;
+        pso->framebufferInfoHash = fb->framebufferInfoHash;
         
         for (const BindingLayoutHandle& _layout : desc.bindingLayouts)
         {
@@ -593,6 +745,17 @@ namespace nvrhi::vulkan
         if (pso->desc.shadingRateState.enabled)
             pipelineInfo.setPNext(&shadingRateState);
 
+        // Pipelines for dynamic rendering describe the attachment formats instead of referencing a render pass
+        vk::PipelineRenderingCreateInfo renderingInfo = fb->getPipelineRenderingInfo();
+        if (!fb->renderPass)
+        {
+            renderingInfo.setPNext(pipelineInfo.pNext);
+            pipelineInfo.setPNext(&renderingInfo);
+
+            if (fb->shadingRateAttachmentView)
+                pipelineInfo.flags |= vk::PipelineCreateFlagBits::eRenderingFragmentShadingRateAttachmentKHR;
+        }
+
         auto tessellationState = vk::PipelineTessellationStateCreateInfo();
 
         if (desc.primType == PrimitiveType::PatchList)
@@ -601,10 +764,20 @@ namespace nvrhi::vulkan
             pipelineInfo.setPTessellationState(&tessellationState);
         }
 
-        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
-                                                     1, &pipelineInfo,
-                                                     m_Context.allocationCallbacks,
-                                                     &pso->pipeline);
+        if (m_Context.descriptorBufferHeap)
+            pipelineInfo.flags |= vk::PipelineCreateFlagBits::eDescriptorBufferEXT;
+
+        if (m_PipelineLibraryCache && !fb->renderPass)
+        {
+            res = createGraphicsPipelineFromLibraries(pso, fb, pipelineInfo, renderingInfo, shadingRateState);
+        }
+        else
+        {
+            res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                                                         1, &pipelineInfo,
+                                                         m_Context.allocationCallbacks,
+                                                         &pso->pipeline);
+        }
         ASSERT_VK_OK(res); // for debugging
         CHECK_VK_FAIL(res);
         
@@ -619,6 +792,9 @@ namespace nvrhi::vulkan
             pipeline = nullptr;
         }
 
+        if (const VkPipeline optimized = optimizedPipeline.exchange(VK_NULL_HANDLE))
+            m_Context.device.destroyPipeline(optimized, m_Context.allocationCallbacks);
+
         if (pipelineLayout)
         {
             m_Context.device.destroyPipelineLayout(pipelineLayout, m_Context.allocationCallbacks);
@@ -633,22 +809,149 @@ namespace nvrhi::vulkan
         case ObjectTypes::VK_PipelineLayout:
             return Object(pipelineLayout);
         case ObjectTypes::VK_Pipeline:
-            return Object(pipeline);
+            return Object(VkPipeline(getPipeline()));
         default:
             return nullptr;
         }
     }
 
+    void CommandList::beginRenderPass(Framebuffer* fb, bool secondaryContents)
+    {
+        // Bundles continue the render pass of the command list that executes them, see executeBundle
+        if (m_Bundle)
+            return;
+
+        // Resuming a suspended render pass must preserve the attachment contents instead of applying the load ops again
+        const bool resume = fb == m_RenderPassFramebuffer;
+        m_RenderPassFramebuffer = fb;
+
+        if (resume && fb->discardsContents)
+        {
+            m_Context.warning("Resuming a render pass with attachments that use AttachmentStoreOp::DontCare or Resolve. "
+                "The render pass was suspended by a command that cannot be recorded inside it, "
+                "and the contents rendered before that command are undefined now.");
+        }
+
+        const auto renderArea = vk::Rect2D()
+            .setOffset(vk::Offset2D(0, 0))
+            .setExtent(vk::Extent2D(fb->framebufferInfo.width, fb->framebufferInfo.height));
+
+        if (fb->renderPass)
+        {
+            const bool useResumeRenderPass = resume && fb->resumeRenderPass;
+
+            m_CurrentCmdBuf->cmdBuf.beginRenderPass(vk::RenderPassBeginInfo()
+                .setRenderPass(useResumeRenderPass ? fb->resumeRenderPass : fb->renderPass)
+                .setFramebuffer(fb->framebuffer)
+                .setRenderArea(renderArea)
+                .setClearValueCount(useResumeRenderPass ? 0 : uint32_t(fb->clearValues.size()))
+                .setPClearValues(fb->clearValues.data()),
+                secondaryContents ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+
+            return;
+        }
+
+        const FramebufferDesc& desc = fb->desc;
+
+        static_vector<vk::RenderingAttachmentInfo, c_MaxRenderTargets> colorAttachments;
+        for (uint32_t i = 0; i < desc.colorAttachments.size(); i++)
+        {
+            const FramebufferAttachment& attachment = desc.colorAttachments[i];
+
+            auto attachmentInfo = vk::RenderingAttachmentInfo()
+                .setImageView(fb->colorAttachmentViews[i])
+                .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
+                .setLoadOp(resume ? vk::AttachmentLoadOp::eLoad : convertAttachmentLoadOp(attachment.loadOp))
+                .setStoreOp(convertAttachmentStoreOp(attachment.storeOp));
+
+            if (!fb->clearValues.empty())
+                attachmentInfo.setClearValue(fb->clearValues[i]);
+
+            if (fb->colorAttachmentResolveViews[i])
+            {
+                attachmentInfo
+                    .setResolveMode(vk::ResolveModeFlagBits::eAverage)
+                    .setResolveImageView(fb->colorAttachmentResolveViews[i])
+                    .setResolveImageLayout(vk::ImageLayout::eColorAttachmentOptimal);
+            }
+
+            colorAttachments.push_back(attachmentInfo);
+        }
+
+        const FramebufferAttachment& depth = desc.depthAttachment;
+        const bool depthKeepsContents = resume || depth.isReadOnly;
+
+        auto depthAttachment = vk::RenderingAttachmentInfo()
+            .setImageView(fb->depthAttachmentView)
+            .setImageLayout(fb->depthAttachmentLayout)
+            .setLoadOp(depthKeepsContents ? vk::AttachmentLoadOp::eLoad : convertAttachmentLoadOp(depth.loadOp))
+            .setStoreOp(depth.isReadOnly ? vk::AttachmentStoreOp::eStore : convertAttachmentStoreOp(depth.storeOp));
+
+        if (fb->depthAttachmentView && !fb->clearValues.empty())
+            depthAttachment.setClearValue(fb->clearValues[desc.colorAttachments.size()]);
+
+        auto renderingInfo = vk::RenderingInfo()
+            .setRenderArea(renderArea)
+            .setLayerCount(fb->layerCount)
+            .setColorAttachmentCount(uint32_t(colorAttachments.size()))
+            .setPColorAttachments(colorAttachments.data())
+            .setPDepthAttachment(fb->depthAttachmentView ? &depthAttachment : nullptr)
+            .setPStencilAttachment(fb->depthAttachmentHasStencil ? &depthAttachment : nullptr);
+
+        const auto shadingRateAttachment = vk::RenderingFragmentShadingRateAttachmentInfoKHR()
+            .setImageView(fb->shadingRateAttachmentView)
+            .setImageLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR)
+            .setShadingRateAttachmentTexelSize(fb->shadingRateAttachmentTexelSize);
+
+        if (fb->shadingRateAttachmentView)
+            renderingInfo.setPNext(&shadingRateAttachment);
+
+        if (secondaryContents)
+            renderingInfo.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+
+        m_CurrentCmdBuf->cmdBuf.beginRendering(renderingInfo);
+    }
+
     void CommandList::endRenderPass()
     {
         if (m_CurrentGraphicsState.framebuffer || m_CurrentMeshletState.framebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.endRenderPass();
+            const Framebuffer* fb = checked_cast<Framebuffer*>(m_CurrentGraphicsState.framebuffer
+                ? m_CurrentGraphicsState.framebuffer
+                : m_CurrentMeshletState.framebuffer);
+
+            // The render pass of a bundle belongs to the command list that executes it
+            if (!m_Bundle)
+            {
+                if (fb->renderPass)
+                    m_CurrentCmdBuf->cmdBuf.endRenderPass();
+                else
+                    m_CurrentCmdBuf->cmdBuf.endRendering();
+            }
+
             m_CurrentGraphicsState.framebuffer = nullptr;
             m_CurrentMeshletState.framebuffer = nullptr;
         }
     }
 
+    void CommandList::commitBarriersInsideRenderPass()
+    {
+        if (anyBarriers())
+        {
+            // Barriers cannot be recorded inside a render pass, so suspend it.
+            // The render pass is resumed below with all attachments loaded.
+            endRenderPass();
+            commitBarriers();
+        }
+
+        // Resume the render pass interrupted above, or by a copy, clear or query command since the last setGraphicsState
+        if (!m_CurrentGraphicsState.framebuffer && m_CurrentGraphicsState.pipeline && m_RenderPassFramebuffer)
+        {
+            beginRenderPass(m_RenderPassFramebuffer);
+            m_CurrentGraphicsState.framebuffer = m_RenderPassFramebuffer;
+        }
+    }
+
     static vk::Viewport VKViewportWithDXCoords(const Viewport& v)
     {
         // requires VK_KHR_maintenance1 which allows negative-height to indicate an inverted coord space to match DX
@@ -672,7 +975,8 @@ namespace nvrhi::vulkan
 
         if (m_CurrentGraphicsState.pipeline != state.pipeline)
         {
-            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->getPipeline());
+            m_Statistics.pipelineBinds++;
 
             m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
             updatePipeline = true;
@@ -684,7 +988,7 @@ namespace nvrhi::vulkan
         }
 
         auto desc = state.framebuffer->getDesc();
-        if (desc.shadingRateAttachment.valid())
+        if (desc.shadingRateAttachment.valid() && !m_Bundle)
         {
             setTextureState(desc.shadingRateAttachment.texture, nvrhi::TextureSubresourceSet(0, 1, 0, 1), nvrhi::ResourceStates::ShadingRateSurface);
         }
@@ -693,25 +997,24 @@ namespace nvrhi::vulkan
 
         if(!m_CurrentGraphicsState.framebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.beginRenderPass(vk::RenderPassBeginInfo()
-                .setRenderPass(fb->renderPass)
-                .setFramebuffer(fb->framebuffer)
-                .setRenderArea(vk::Rect2D()
-                    .setOffset(vk::Offset2D(0, 0))
-                    .setExtent(vk::Extent2D(fb->framebufferInfo.width, fb->framebufferInfo.height)))
-                .setClearValueCount(0),
-                vk::SubpassContents::eInline);
+            beginRenderPass(fb);
 
             m_CurrentCmdBuf->referencedResources.push_back(state.framebuffer);
         }
 
+        // Descriptor sets stay bound across pipeline changes as long as the pipeline layout is the same
+        const bool updatePipelineLayout = m_CurrentPipelineLayout != pso->pipelineLayout;
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
 
-        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (updatePipelineLayout || arraysAreDifferent(m_CurrentGraphicsState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings);
+        }
 
         if (!state.viewport.viewports.empty() && arraysAreDifferent(state.viewport.viewports, m_CurrentGraphicsState.viewport.viewports))
         {
@@ -748,34 +1051,12 @@ namespace nvrhi::vulkan
 
         if (state.indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != state.indexBuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->buffer,
-                state.indexBuffer.offset,
-                state.indexBuffer.format == Format::R16_UINT ?
-                vk::IndexType::eUint16 : vk::IndexType::eUint32);
-
-            m_CurrentCmdBuf->referencedResources.push_back(state.indexBuffer.buffer);
+            bindIndexBuffer(state.indexBuffer);
         }
 
         if (!state.vertexBuffers.empty() && arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
         {
-            vk::Buffer vertexBuffers[c_MaxVertexAttributes];
-            vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
-            uint32_t maxVbIndex = 0;
-
-            for (const auto& binding : state.vertexBuffers)
-            {
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-
-                vertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
-                vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-
-                m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
-            }
-
-            m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+            bindVertexBuffers(state.vertexBuffers);
         }
 
         if (state.indirectParams)
@@ -783,6 +1064,11 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
         }
 
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
         if (state.shadingRateState.enabled)
         {
             vk::FragmentShadingRateCombinerOpKHR combiners[2] = { convertShadingRateCombiner(state.shadingRateState.pipelinePrimitiveCombiner), convertShadingRateCombiner(state.shadingRateState.imageCombiner) };
@@ -797,13 +1083,128 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = false;
     }
 
+    void CommandList::setGraphicsBindings(const BindingSetVector& bindings)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_CurrentGraphicsState.pipeline)
+        {
+            m_Context.error("setGraphicsBindings can only be used after setGraphicsState");
+            return;
+        }
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+
+        const bool updateBindings = arraysAreDifferent(m_CurrentGraphicsState.bindings, bindings);
+
+        if (m_EnableAutomaticBarriers && updateBindings)
+        {
+            for (IBindingSet* bindingSet : bindings)
+            {
+                setResourceStatesForBindingSet(bindingSet);
+            }
+        }
+
+        commitBarriersInsideRenderPass();
+
+        if (updateBindings)
+        {
+            bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, bindings);
+            m_AnyVolatileBufferWrites = false;
+        }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, bindings);
+            m_AnyVolatileBufferWrites = false;
+        }
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandList::setGraphicsVertexBuffers(const VertexBufferBindingVector& vertexBuffers, const IndexBufferBinding& indexBuffer)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_CurrentGraphicsState.pipeline)
+        {
+            m_Context.error("setGraphicsVertexBuffers can only be used after setGraphicsState");
+            return;
+        }
+
+        const bool updateIndexBuffer = indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != indexBuffer;
+        const bool updateVertexBuffers = !vertexBuffers.empty() && arraysAreDifferent(vertexBuffers, m_CurrentGraphicsState.vertexBuffers);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            if (updateIndexBuffer)
+            {
+                requireBufferState(indexBuffer.buffer, ResourceStates::IndexBuffer);
+            }
+
+            if (updateVertexBuffers)
+            {
+                for (const auto& vb : vertexBuffers)
+                {
+                    requireBufferState(vb.buffer, ResourceStates::VertexBuffer);
+                }
+            }
+        }
+
+        commitBarriersInsideRenderPass();
+
+        if (updateIndexBuffer)
+        {
+            bindIndexBuffer(indexBuffer);
+        }
+
+        if (updateVertexBuffers)
+        {
+            bindVertexBuffers(vertexBuffers);
+        }
+
+        m_CurrentGraphicsState.indexBuffer = indexBuffer;
+        m_CurrentGraphicsState.vertexBuffers = vertexBuffers;
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(indexBuffer.buffer)->buffer,
+            indexBuffer.offset,
+            indexBuffer.format == Format::R16_UINT ?
+            vk::IndexType::eUint16 : vk::IndexType::eUint32);
+
+        m_CurrentCmdBuf->referencedResources.push_back(indexBuffer.buffer);
+    }
+
+    void CommandList::bindVertexBuffers(const VertexBufferBindingVector& bindings)
+    {
+        vk::Buffer vertexBuffers[c_MaxVertexAttributes];
+        vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
+        uint32_t maxVbIndex = 0;
+
+        for (const auto& binding : bindings)
+        {
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            vertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
+            vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+
+            m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
+        }
+
+        m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+    }
+
     void CommandList::updateGraphicsVolatileBuffers()
     {
         if (m_AnyVolatileBufferWrites && m_CurrentGraphicsState.pipeline)
         {
             GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
 
-            bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentGraphicsState.bindings);
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentGraphicsState.bindings);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -819,6 +1220,7 @@ namespace nvrhi::vulkan
             args.instanceCount,
             args.startVertexLocation,
             args.startInstanceLocation);
+        m_Statistics.drawCalls++;
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
@@ -832,6 +1234,7 @@ namespace nvrhi::vulkan
             args.startIndexLocation,
             args.startVertexLocation,
             args.startInstanceLocation);
+        m_Statistics.drawCalls++;
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -843,7 +1246,19 @@ namespace nvrhi::vulkan
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams);
 
+        if (m_CurrentGraphicsState.indirectCountBuffer)
+        {
+            // The actual draw count is read from the first uint32 of the count buffer, 'drawCount' is the maximum
+            Buffer* indirectCountBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+
+            m_CurrentCmdBuf->cmdBuf.drawIndirectCount(indirectParams->buffer, offsetBytes, indirectCountBuffer->buffer, 0,
+                drawCount, sizeof(DrawIndirectArguments));
+            m_Statistics.drawCalls++;
+            return;
+        }
+
         m_CurrentCmdBuf->cmdBuf.drawIndirect(indirectParams->buffer, offsetBytes, drawCount, sizeof(DrawIndirectArguments));
+        m_Statistics.drawCalls++;
     }
 
     void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -855,7 +1270,64 @@ namespace nvrhi::vulkan
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams);
 
+        if (m_CurrentGraphicsState.indirectCountBuffer)
+        {
+            Buffer* indirectCountBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+
+            m_CurrentCmdBuf->cmdBuf.drawIndexedIndirectCount(indirectParams->buffer, offsetBytes, indirectCountBuffer->buffer, 0,
+                drawCount, sizeof(DrawIndexedIndirectArguments));
+            m_Statistics.drawCalls++;
+            return;
+        }
+
         m_CurrentCmdBuf->cmdBuf.drawIndexedIndirect(indirectParams->buffer, offsetBytes, drawCount, sizeof(DrawIndexedIndirectArguments));
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::prepareIndirectCountBuffer(Buffer* countBuffer)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(countBuffer, ResourceStates::IndirectArgument);
+
+            commitBarriersInsideRenderPass();
+        }
+
+        m_CurrentCmdBuf->referencedResources.push_back(countBuffer);
+    }
+
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, IBuffer* _countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        assert(indirectParams);
+
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+        prepareIndirectCountBuffer(countBuffer);
+
+        updateGraphicsVolatileBuffers();
+
+        m_CurrentCmdBuf->cmdBuf.drawIndirectCount(indirectParams->buffer, paramOffsetBytes, countBuffer->buffer, countOffsetBytes,
+            maxDrawCount, sizeof(DrawIndirectArguments));
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, IBuffer* _countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        assert(indirectParams);
+
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+        prepareIndirectCountBuffer(countBuffer);
+
+        updateGraphicsVolatileBuffers();
+
+        m_CurrentCmdBuf->cmdBuf.drawIndexedIndirectCount(indirectParams->buffer, paramOffsetBytes, countBuffer->buffer, countOffsetBytes,
+            maxDrawCount, sizeof(DrawIndexedIndirectArguments));
+        m_Statistics.drawCalls++;
     }
 
 } // namespace nvrhi::vulkan
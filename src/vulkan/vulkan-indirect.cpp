@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+namespace nvrhi::vulkan
+{
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        // State changes in indirect records would need VK_EXT_device_generated_commands, which is not implemented here
+        if (desc.arguments.size() != 1)
+        {
+            m_Context.error("Command signatures on Vulkan must contain exactly one Draw, DrawIndexed, Dispatch or DispatchMesh argument");
+            return nullptr;
+        }
+
+        const IndirectArgumentType commandType = desc.arguments[0].type;
+
+        switch (commandType)
+        {
+        case IndirectArgumentType::Draw:
+        case IndirectArgumentType::DrawIndexed:
+        case IndirectArgumentType::Dispatch:
+            break;
+        case IndirectArgumentType::DispatchMesh:
+            if (!m_Context.extensions.EXT_mesh_shader)
+            {
+                m_Context.error("DispatchMesh command signatures require VK_EXT_mesh_shader");
+                return nullptr;
+            }
+            break;
+        default:
+            m_Context.error("Indirect state changes are not supported on Vulkan");
+            return nullptr;
+        }
+
+        CommandSignature* signature = new CommandSignature();
+        signature->desc = desc;
+        signature->commandType = commandType;
+        signature->byteStride = utils::GetCommandSignatureByteStride(desc);
+
+        return CommandSignatureHandle::Create(signature);
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* _signature, IBuffer* _argumentBuffer, uint32_t argumentOffsetBytes,
+        uint32_t maxCommandCount, IBuffer* _countBuffer, uint32_t countOffsetBytes)
+    {
+        assert(m_CurrentCmdBuf);
+
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+        Buffer* argumentBuffer = checked_cast<Buffer*>(_argumentBuffer);
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+
+        if (signature->commandType == IndirectArgumentType::Dispatch)
+        {
+            // There is no vkCmdDispatchIndirectCount or multi-dispatch
+            if (countBuffer || maxCommandCount > 1)
+            {
+                m_Context.error("Dispatch command signatures on Vulkan only support a single command without a count buffer");
+                return;
+            }
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(argumentBuffer, ResourceStates::IndirectArgument);
+                commitBarriers();
+            }
+            m_CurrentCmdBuf->referencedResources.push_back(argumentBuffer);
+
+            updateComputeVolatileBuffers();
+
+            m_CurrentCmdBuf->cmdBuf.dispatchIndirect(argumentBuffer->buffer, argumentOffsetBytes);
+            m_Statistics.dispatchCalls++;
+            return;
+        }
+
+        prepareIndirectCountBuffer(argumentBuffer);
+        if (countBuffer)
+            prepareIndirectCountBuffer(countBuffer);
+
+        if (signature->commandType == IndirectArgumentType::DispatchMesh)
+            updateMeshletVolatileBuffers();
+        else
+            updateGraphicsVolatileBuffers();
+
+        const uint32_t stride = signature->byteStride;
+        vk::CommandBuffer cmdBuf = m_CurrentCmdBuf->cmdBuf;
+        m_Statistics.drawCalls++;
+
+        switch (signature->commandType)
+        {
+        case IndirectArgumentType::Draw:
+            if (countBuffer)
+                cmdBuf.drawIndirectCount(argumentBuffer->buffer, argumentOffsetBytes, countBuffer->buffer, countOffsetBytes, maxCommandCount, stride);
+            else
+                cmdBuf.drawIndirect(argumentBuffer->buffer, argumentOffsetBytes, maxCommandCount, stride);
+            break;
+
+        case IndirectArgumentType::DrawIndexed:
+            if (countBuffer)
+                cmdBuf.drawIndexedIndirectCount(argumentBuffer->buffer, argumentOffsetBytes, countBuffer->buffer, countOffsetBytes, maxCommandCount, stride);
+            else
+                cmdBuf.drawIndexedIndirect(argumentBuffer->buffer, argumentOffsetBytes, maxCommandCount, stride);
+            break;
+
+        case IndirectArgumentType::DispatchMesh:
+            if (countBuffer)
+                cmdBuf.drawMeshTasksIndirectCountEXT(argumentBuffer->buffer, argumentOffsetBytes, countBuffer->buffer, countOffsetBytes, maxCommandCount, stride);
+            else
+                cmdBuf.drawMeshTasksIndirectEXT(argumentBuffer->buffer, argumentOffsetBytes, maxCommandCount, stride);
+            break;
+
+        default:
+            utils::InvalidEnum();
+            break;
+        }
+    }
+
+} // namespace nvrhi::vulkan
@@ -31,7 +31,7 @@ namespace nvrhi::vulkan
 
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* _fb)
     {
-        if (!m_Context.extensions.NV_mesh_shader)
+        if (!m_Context.extensions.NV_mesh_shader && !m_Context.extensions.EXT_mesh_shader)
             utils::NotSupported();
 
         vk::Result res;
@@ -41,6 +41,7 @@ namespace nvrhi::vulkan
         MeshletPipeline *pso = new MeshletPipeline(m_Context);
         pso->desc = desc;
         pso->framebufferInfo = fb->framebufferInfo;
+        pso->framebufferInfoHash = fb->framebufferInfoHash;
         
         for (const BindingLayoutHandle& _layout : desc.bindingLayouts)
         {
@@ -215,6 +216,16 @@ namespace nvrhi::vulkan
             .setBasePipelineHandle(nullptr)
             .setBasePipelineIndex(-1);
 
+        // Pipelines for dynamic rendering describe the attachment formats instead of referencing a render pass
+        vk::PipelineRenderingCreateInfo renderingInfo = fb->getPipelineRenderingInfo();
+        if (!fb->renderPass)
+        {
+            pipelineInfo.setPNext(&renderingInfo);
+        }
+
+        if (m_Context.descriptorBufferHeap)
+            pipelineInfo.flags |= vk::PipelineCreateFlagBits::eDescriptorBufferEXT;
+
         res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
                                                      1, &pipelineInfo,
                                                      m_Context.allocationCallbacks,
@@ -277,6 +288,7 @@ namespace nvrhi::vulkan
         if (m_CurrentMeshletState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            m_Statistics.pipelineBinds++;
 
             m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
             updatePipeline = true;
@@ -291,25 +303,23 @@ namespace nvrhi::vulkan
 
         if(!m_CurrentMeshletState.framebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.beginRenderPass(vk::RenderPassBeginInfo()
-                .setRenderPass(fb->renderPass)
-                .setFramebuffer(fb->framebuffer)
-                .setRenderArea(vk::Rect2D()
-                    .setOffset(vk::Offset2D(0, 0))
-                    .setExtent(vk::Extent2D(fb->framebufferInfo.width, fb->framebufferInfo.height)))
-                .setClearValueCount(0),
-                vk::SubpassContents::eInline);
+            beginRenderPass(fb);
 
             m_CurrentCmdBuf->referencedResources.push_back(state.framebuffer);
         }
 
+        const bool updatePipelineLayout = m_CurrentPipelineLayout != pso->pipelineLayout;
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
 
-        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (updatePipelineLayout || arraysAreDifferent(m_CurrentMeshletState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings);
+        }
 
         if (!state.viewport.viewports.empty() && arraysAreDifferent(state.viewport.viewports, m_CurrentMeshletState.viewport.viewports))
         {
@@ -349,6 +359,11 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
         }
 
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
         m_CurrentComputeState = ComputeState();
         m_CurrentGraphicsState = GraphicsState();
         m_CurrentMeshletState = state;
@@ -362,7 +377,7 @@ namespace nvrhi::vulkan
         {
             MeshletPipeline* pso = checked_cast<MeshletPipeline*>(m_CurrentMeshletState.pipeline);
 
-            bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentMeshletState.bindings);
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentMeshletState.bindings);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -372,9 +387,18 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            updateMeshletVolatileBuffers();
+
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksEXT(groupsX, groupsY, groupsZ);
+            m_Statistics.drawCalls++;
+            return;
+        }
+
         if (groupsY > 1 || groupsZ > 1)
         {
-            // only 1D dispatches are supported by Vulkan
+            // only 1D dispatches are supported by VK_NV_mesh_shader
             utils::NotSupported();
             return;
         }
@@ -382,6 +406,60 @@ namespace nvrhi::vulkan
         updateMeshletVolatileBuffers();
 
         m_CurrentCmdBuf->cmdBuf.drawMeshTasksNV(groupsX, 0);
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.EXT_mesh_shader)
+        {
+            // VK_NV_mesh_shader records are { taskCount, firstTask } and can't read DispatchMeshIndirectArguments
+            m_Context.error("dispatchMeshIndirect requires VK_EXT_mesh_shader");
+            return;
+        }
+
+        updateMeshletVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams);
+
+        if (m_CurrentMeshletState.indirectCountBuffer)
+        {
+            Buffer* indirectCountBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountEXT(indirectParams->buffer, offsetBytes, indirectCountBuffer->buffer, 0,
+                drawCount, sizeof(DispatchMeshIndirectArguments));
+            m_Statistics.drawCalls++;
+            return;
+        }
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectEXT(indirectParams->buffer, offsetBytes, drawCount, sizeof(DispatchMeshIndirectArguments));
+        m_Statistics.drawCalls++;
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, IBuffer* _countBuffer, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.EXT_mesh_shader)
+        {
+            m_Context.error("dispatchMeshIndirectCount requires VK_EXT_mesh_shader");
+            return;
+        }
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams);
+
+        Buffer* countBuffer = checked_cast<Buffer*>(_countBuffer);
+        prepareIndirectCountBuffer(countBuffer);
+
+        updateMeshletVolatileBuffers();
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountEXT(indirectParams->buffer, paramOffsetBytes, countBuffer->buffer, countOffsetBytes,
+            maxDrawCount, sizeof(DispatchMeshIndirectArguments));
+        m_Statistics.drawCalls++;
     }
 
 } // namespace nvrhi::vulkan
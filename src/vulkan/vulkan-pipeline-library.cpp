@@ -0,0 +1,418 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <cstring>
+
+namespace nvrhi::vulkan
+{
+    typedef GraphicsPipelineLibraryCache::Key LibraryKey;
+
+    static void addToKey(LibraryKey& key, uint64_t value)
+    {
+        key.push_back(value);
+    }
+
+    static void addToKey(LibraryKey& key, float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        key.push_back(bits);
+    }
+
+    static void addToKey(LibraryKey& key, const void* pointer)
+    {
+        key.push_back(uint64_t(reinterpret_cast<uintptr_t>(pointer)));
+    }
+
+    static void addStencilOpToKey(LibraryKey& key, const vk::StencilOpState& state)
+    {
+        addToKey(key, uint64_t(state.failOp));
+        addToKey(key, uint64_t(state.passOp));
+        addToKey(key, uint64_t(state.depthFailOp));
+        addToKey(key, uint64_t(state.compareOp));
+        addToKey(key, uint64_t(state.compareMask));
+        addToKey(key, uint64_t(state.writeMask));
+        addToKey(key, uint64_t(state.reference));
+    }
+
+    static void addMultisampleToKey(LibraryKey& key, const vk::PipelineMultisampleStateCreateInfo& state)
+    {
+        addToKey(key, uint64_t(state.rasterizationSamples));
+        addToKey(key, uint64_t(state.alphaToCoverageEnable));
+    }
+
+    static void addShadingRateToKey(LibraryKey& key, const GraphicsPipeline* pso,
+        const vk::PipelineFragmentShadingRateStateCreateInfoKHR& state)
+    {
+        addToKey(key, uint64_t(pso->desc.shadingRateState.enabled));
+        if (pso->desc.shadingRateState.enabled)
+        {
+            addToKey(key, uint64_t(state.fragmentSize.width));
+            addToKey(key, uint64_t(state.fragmentSize.height));
+            addToKey(key, uint64_t(state.combinerOps[0]));
+            addToKey(key, uint64_t(state.combinerOps[1]));
+        }
+    }
+
+    // Pipeline layouts must be identically defined in all libraries of a pipeline, so the parts that use the layout
+    // are keyed on the descriptor set layouts and push constants it has been created from
+    static void addLayoutToKey(LibraryKey& key, const GraphicsPipeline* pso, std::vector<RefCountPtr<IResource>>& keepAlive)
+    {
+        addToKey(key, uint64_t(pso->pipelineBindingLayouts.size()));
+        for (const auto& layout : pso->pipelineBindingLayouts)
+        {
+            addToKey(key, layout.Get());
+            keepAlive.push_back(layout.Get());
+        }
+        addToKey(key, uint64_t(VkShaderStageFlags(pso->pushConstantVisibility)));
+    }
+
+    static void addShaderToKey(LibraryKey& key, IShader* shader, std::vector<RefCountPtr<IResource>>& keepAlive)
+    {
+        addToKey(key, shader);
+        if (shader)
+            keepAlive.push_back(shader);
+    }
+
+    size_t GraphicsPipelineLibraryCache::KeyHash::operator()(const Key& key) const
+    {
+        size_t hash = key.size();
+        for (uint64_t word : key)
+            hash_combine(hash, word);
+        return hash;
+    }
+
+    GraphicsPipelineLibraryCache::~GraphicsPipelineLibraryCache()
+    {
+        for (auto& libraries : m_Libraries)
+        {
+            for (auto& it : libraries)
+                m_Context.device.destroyPipeline(it.second.library, m_Context.allocationCallbacks);
+        }
+    }
+
+    vk::Pipeline GraphicsPipelineLibraryCache::getOrCreate(Part part, const Key& key,
+        const std::vector<RefCountPtr<IResource>>& keepAlive, const std::function<vk::Pipeline()>& createLibrary)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto it = m_Libraries[part].find(key);
+            if (it != m_Libraries[part].end())
+                return it->second.library;
+        }
+
+        // Compile the library without holding the mutex, so that other threads can create other pipelines meanwhile
+        vk::Pipeline library = createLibrary();
+        if (!library)
+            return nullptr;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto [it, inserted] = m_Libraries[part].try_emplace(key);
+        if (inserted)
+        {
+            it->second.library = library;
+            it->second.keepAlive = keepAlive;
+        }
+        else
+        {
+            // Another thread has created the same library first
+            m_Context.device.destroyPipeline(library, m_Context.allocationCallbacks);
+        }
+
+        return it->second.library;
+    }
+
+    vk::Result Device::createGraphicsPipelineFromLibraries(GraphicsPipeline* pso, Framebuffer* fb,
+        const vk::GraphicsPipelineCreateInfo& pipelineInfo, const vk::PipelineRenderingCreateInfo& renderingInfo,
+        const vk::PipelineFragmentShadingRateStateCreateInfoKHR& shadingRateState)
+    {
+        const GraphicsPipelineDesc& desc = pso->desc;
+        const bool shadingRateAttachment = bool(fb->shadingRateAttachmentView);
+
+        // The flags that must be the same in all libraries and in the linked pipeline
+        const vk::PipelineCreateFlags commonFlags = pipelineInfo.flags &
+            (vk::PipelineCreateFlagBits::eDescriptorBufferEXT | vk::PipelineCreateFlagBits::eRenderingFragmentShadingRateAttachmentKHR);
+
+        vk::Result res = vk::Result::eSuccess;
+
+        // Creates one library from the parts of pipelineInfo that belong to it, which the caller copies into libraryPipelineInfo
+        auto createLibrary = [this, &pipelineInfo, &renderingInfo, &shadingRateState, commonFlags, &res](
+            vk::GraphicsPipelineLibraryFlagsEXT libraryFlags, vk::GraphicsPipelineCreateInfo libraryPipelineInfo,
+            bool usesRenderingInfo, bool usesShadingRate, const static_vector<vk::DynamicState, 5>& dynamicStates)
+        {
+            auto libraryInfo = vk::GraphicsPipelineLibraryCreateInfoEXT()
+                .setFlags(libraryFlags);
+
+            vk::PipelineRenderingCreateInfo libraryRenderingInfo = renderingInfo;
+            vk::PipelineFragmentShadingRateStateCreateInfoKHR libraryShadingRateState = shadingRateState;
+
+            const void* pNext = nullptr;
+            if (usesShadingRate)
+            {
+                libraryShadingRateState.setPNext(pNext);
+                pNext = &libraryShadingRateState;
+            }
+            if (usesRenderingInfo)
+            {
+                libraryRenderingInfo.setPNext(pNext);
+                pNext = &libraryRenderingInfo;
+            }
+            libraryInfo.setPNext(pNext);
+
+            auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo()
+                .setDynamicStateCount(uint32_t(dynamicStates.size()))
+                .setPDynamicStates(dynamicStates.data());
+
+            libraryPipelineInfo
+                .setPNext(&libraryInfo)
+                .setFlags(commonFlags | vk::PipelineCreateFlagBits::eLibraryKHR
+                    | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT)
+                .setPDynamicState(dynamicStates.empty() ? nullptr : &dynamicStateInfo)
+                .setBasePipelineHandle(nullptr)
+                .setBasePipelineIndex(-1);
+
+            vk::Pipeline library;
+            res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                1, &libraryPipelineInfo, m_Context.allocationCallbacks, &library);
+            return res == vk::Result::eSuccess ? library : vk::Pipeline();
+        };
+
+        // The shader stages are ordered VS, HS, DS, GS, PS, so the pixel shader is the last one if present
+        const uint32_t numPreRasterizationStages = pipelineInfo.stageCount - (desc.PS ? 1 : 0);
+
+        // Vertex input interface
+        {
+            LibraryKey key;
+            std::vector<RefCountPtr<IResource>> keepAlive;
+            addToKey(key, desc.inputLayout.Get());
+            if (desc.inputLayout)
+                keepAlive.push_back(desc.inputLayout.Get());
+            addToKey(key, uint64_t(pipelineInfo.pInputAssemblyState->topology));
+
+            pso->libraries[GraphicsPipelineLibraryCache::VertexInput] = m_PipelineLibraryCache->getOrCreate(
+                GraphicsPipelineLibraryCache::VertexInput, key, keepAlive, [&]()
+            {
+                auto info = vk::GraphicsPipelineCreateInfo()
+                    .setPVertexInputState(pipelineInfo.pVertexInputState)
+                    .setPInputAssemblyState(pipelineInfo.pInputAssemblyState);
+
+                return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface, info, false, false, {});
+            });
+        }
+
+        // Pre-rasterization shaders
+        {
+            LibraryKey key;
+            std::vector<RefCountPtr<IResource>> keepAlive;
+            addShaderToKey(key, desc.VS.Get(), keepAlive);
+            addShaderToKey(key, desc.HS.Get(), keepAlive);
+            addShaderToKey(key, desc.DS.Get(), keepAlive);
+            addShaderToKey(key, desc.GS.Get(), keepAlive);
+            addLayoutToKey(key, pso, keepAlive);
+
+            const vk::PipelineRasterizationStateCreateInfo& rasterizer = *pipelineInfo.pRasterizationState;
+            addToKey(key, uint64_t(rasterizer.polygonMode));
+            addToKey(key, uint64_t(VkCullModeFlags(rasterizer.cullMode)));
+            addToKey(key, uint64_t(rasterizer.frontFace));
+            addToKey(key, uint64_t(rasterizer.depthBiasEnable));
+            addToKey(key, rasterizer.depthBiasConstantFactor);
+            addToKey(key, rasterizer.depthBiasClamp);
+            addToKey(key, rasterizer.depthBiasSlopeFactor);
+            addToKey(key, uint64_t(rasterizer.pNext != nullptr)); // conservative rasterization
+            addToKey(key, uint64_t(pipelineInfo.pTessellationState ? pipelineInfo.pTessellationState->patchControlPoints : 0));
+            addShadingRateToKey(key, pso, shadingRateState);
+            addToKey(key, uint64_t(shadingRateAttachment));
+
+            static_vector<vk::DynamicState, 5> dynamicStates = {
+                vk::DynamicState::eViewport,
+                vk::DynamicState::eScissor
+            };
+            if (desc.shadingRateState.enabled)
+                dynamicStates.push_back(vk::DynamicState::eFragmentShadingRateKHR);
+
+            pso->libraries[GraphicsPipelineLibraryCache::PreRasterization] = m_PipelineLibraryCache->getOrCreate(
+                GraphicsPipelineLibraryCache::PreRasterization, key, keepAlive, [&]()
+            {
+                auto info = vk::GraphicsPipelineCreateInfo()
+                    .setStageCount(numPreRasterizationStages)
+                    .setPStages(pipelineInfo.pStages)
+                    .setPViewportState(pipelineInfo.pViewportState)
+                    .setPRasterizationState(pipelineInfo.pRasterizationState)
+                    .setPTessellationState(pipelineInfo.pTessellationState)
+                    .setLayout(pso->pipelineLayout);
+
+                return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders, info, true,
+                    desc.shadingRateState.enabled, dynamicStates);
+            });
+        }
+
+        // Fragment shader
+        {
+            LibraryKey key;
+            std::vector<RefCountPtr<IResource>> keepAlive;
+            addShaderToKey(key, desc.PS.Get(), keepAlive);
+            addLayoutToKey(key, pso, keepAlive);
+
+            const vk::PipelineDepthStencilStateCreateInfo& depthStencil = *pipelineInfo.pDepthStencilState;
+            addToKey(key, uint64_t(depthStencil.depthTestEnable));
+            addToKey(key, uint64_t(depthStencil.depthWriteEnable));
+            addToKey(key, uint64_t(depthStencil.depthCompareOp));
+            addToKey(key, uint64_t(depthStencil.stencilTestEnable));
+            addStencilOpToKey(key, depthStencil.front);
+            addStencilOpToKey(key, depthStencil.back);
+            addToKey(key, uint64_t(desc.renderState.depthStencilState.dynamicStencilRef));
+            addMultisampleToKey(key, *pipelineInfo.pMultisampleState);
+            addShadingRateToKey(key, pso, shadingRateState);
+            addToKey(key, uint64_t(shadingRateAttachment));
+
+            static_vector<vk::DynamicState, 5> dynamicStates;
+            if (desc.renderState.depthStencilState.dynamicStencilRef)
+                dynamicStates.push_back(vk::DynamicState::eStencilReference);
+            if (desc.shadingRateState.enabled)
+                dynamicStates.push_back(vk::DynamicState::eFragmentShadingRateKHR);
+
+            pso->libraries[GraphicsPipelineLibraryCache::FragmentShader] = m_PipelineLibraryCache->getOrCreate(
+                GraphicsPipelineLibraryCache::FragmentShader, key, keepAlive, [&]()
+            {
+                auto info = vk::GraphicsPipelineCreateInfo()
+                    .setStageCount(desc.PS ? 1 : 0)
+                    .setPStages(desc.PS ? pipelineInfo.pStages + numPreRasterizationStages : nullptr)
+                    .setPMultisampleState(pipelineInfo.pMultisampleState)
+                    .setPDepthStencilState(pipelineInfo.pDepthStencilState)
+                    .setLayout(pso->pipelineLayout);
+
+                return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader, info, true,
+                    desc.shadingRateState.enabled, dynamicStates);
+            });
+        }
+
+        // Fragment output interface
+        {
+            LibraryKey key;
+            addToKey(key, uint64_t(renderingInfo.colorAttachmentCount));
+            for (uint32_t i = 0; i < renderingInfo.colorAttachmentCount; i++)
+                addToKey(key, uint64_t(renderingInfo.pColorAttachmentFormats[i]));
+            addToKey(key, uint64_t(renderingInfo.depthAttachmentFormat));
+            addToKey(key, uint64_t(renderingInfo.stencilAttachmentFormat));
+
+            const vk::PipelineColorBlendStateCreateInfo& colorBlend = *pipelineInfo.pColorBlendState;
+            for (uint32_t i = 0; i < colorBlend.attachmentCount; i++)
+            {
+                const vk::PipelineColorBlendAttachmentState& target = colorBlend.pAttachments[i];
+                addToKey(key, uint64_t(target.blendEnable));
+                addToKey(key, uint64_t(target.srcColorBlendFactor));
+                addToKey(key, uint64_t(target.dstColorBlendFactor));
+                addToKey(key, uint64_t(target.colorBlendOp));
+                addToKey(key, uint64_t(target.srcAlphaBlendFactor));
+                addToKey(key, uint64_t(target.dstAlphaBlendFactor));
+                addToKey(key, uint64_t(target.alphaBlendOp));
+                addToKey(key, uint64_t(VkColorComponentFlags(target.colorWriteMask)));
+            }
+            addMultisampleToKey(key, *pipelineInfo.pMultisampleState);
+            addToKey(key, uint64_t(pso->usesBlendConstants));
+            addToKey(key, uint64_t(shadingRateAttachment));
+
+            static_vector<vk::DynamicState, 5> dynamicStates;
+            if (pso->usesBlendConstants)
+                dynamicStates.push_back(vk::DynamicState::eBlendConstants);
+
+            pso->libraries[GraphicsPipelineLibraryCache::FragmentOutput] = m_PipelineLibraryCache->getOrCreate(
+                GraphicsPipelineLibraryCache::FragmentOutput, key, {}, [&]()
+            {
+                auto info = vk::GraphicsPipelineCreateInfo()
+                    .setPMultisampleState(pipelineInfo.pMultisampleState)
+                    .setPColorBlendState(pipelineInfo.pColorBlendState);
+
+                return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface, info, true,
+                    false, dynamicStates);
+            });
+        }
+
+        for (const vk::Pipeline& library : pso->libraries)
+        {
+            if (!library)
+                return res == vk::Result::eSuccess ? vk::Result::eErrorUnknown : res;
+        }
+
+        pso->linkedFromLibraries = true;
+
+        // Link without optimization to keep pipeline creation fast, createOptimizedGraphicsPipelineAsync can do it later
+        return linkGraphicsPipeline(pso, false, pso->pipeline);
+    }
+
+    vk::Result Device::linkGraphicsPipeline(const GraphicsPipeline* pso, bool optimize, vk::Pipeline& outPipeline) const
+    {
+        auto libraryInfo = vk::PipelineLibraryCreateInfoKHR()
+            .setLibraryCount(uint32_t(pso->libraries.size()))
+            .setPLibraries(pso->libraries.data());
+
+        vk::PipelineCreateFlags flags;
+        if (optimize)
+            flags |= vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT;
+        if (m_Context.descriptorBufferHeap)
+            flags |= vk::PipelineCreateFlagBits::eDescriptorBufferEXT;
+
+        auto pipelineInfo = vk::GraphicsPipelineCreateInfo()
+            .setPNext(&libraryInfo)
+            .setFlags(flags)
+            .setLayout(pso->pipelineLayout)
+            .setBasePipelineHandle(nullptr)
+            .setBasePipelineIndex(-1);
+
+        return m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &pipelineInfo, m_Context.allocationCallbacks, &outPipeline);
+    }
+
+    PipelineCreationTaskHandle Device::createOptimizedGraphicsPipelineAsync(IGraphicsPipeline* _pipeline)
+    {
+        GraphicsPipelineHandle pipeline = _pipeline;
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(_pipeline);
+
+        if (!pso || !pso->linkedFromLibraries || pso->optimizedPipeline.load())
+            return PipelineCreationTask::createCompleted(pipeline);
+
+        // The task holds a reference to the device, like the create*PipelineAsync tasks
+        PipelineCreationTask* task = new PipelineCreationTask([device = RefCountPtr<Device>(this), pipeline, pso](PipelineCreationTask& task)
+        {
+            vk::Pipeline optimized;
+            const vk::Result res = device->linkGraphicsPipeline(pso, true, optimized);
+            if (res != vk::Result::eSuccess)
+            {
+                device->m_Context.error("Failed to link an optimized graphics pipeline: " + std::string(resultToString(VkResult(res))));
+                return;
+            }
+
+            // Bind points pick the optimized pipeline up through GraphicsPipeline::getPipeline, and the pipeline
+            // that has been bound before stays alive with the GraphicsPipeline object, so it's safe to publish it now
+            VkPipeline expected = VK_NULL_HANDLE;
+            if (!pso->optimizedPipeline.compare_exchange_strong(expected, optimized))
+                device->m_Context.device.destroyPipeline(optimized, device->m_Context.allocationCallbacks);
+
+            task.setResult(pipeline);
+        });
+        return PipelineCreationTaskHandle::Create(task);
+    }
+}
@@ -21,6 +21,7 @@
 */
 
 #include "vulkan-backend.h"
+#include "../common/breadcrumb-buffer.h"
 #include <nvrhi/common/misc.h>
 
 namespace nvrhi::vulkan
@@ -48,6 +49,8 @@ namespace nvrhi::vulkan
         
         auto& queue = *m_Queues[uint32_t(query->queue)];
 
+        flushQueueSubmissions();
+
         return queue.pollCommandList(query->commandListID);
     }
 
@@ -60,6 +63,8 @@ namespace nvrhi::vulkan
 
         auto& queue = *m_Queues[uint32_t(query->queue)];
 
+        flushQueueSubmissions();
+
         bool success = queue.waitCommandList(query->commandListID, ~0ull);
         assert(success);
         (void)success;
@@ -187,6 +192,8 @@ namespace nvrhi::vulkan
 
         if (!query->resolved)
         {
+            flushQueueSubmissions();
+
             while(!pollTimerQuery(query))
                 ;
         }
@@ -207,6 +214,173 @@ namespace nvrhi::vulkan
     }
 
 
+    QueryPool::~QueryPool()
+    {
+        if (queryPool)
+        {
+            m_Context.device.destroyQueryPool(queryPool, m_Context.allocationCallbacks);
+            queryPool = vk::QueryPool();
+        }
+    }
+
+    // Stride of one query in the results written by resolveQueries, see PipelineStatistics
+    static uint64_t getQueryResultStride(QueryType type)
+    {
+        return (type == QueryType::PipelineStatistics) ? sizeof(PipelineStatistics) : sizeof(uint64_t);
+    }
+
+    QueryPoolHandle Device::createQueryPool(const QueryPoolDesc& desc)
+    {
+        auto poolInfo = vk::QueryPoolCreateInfo()
+            .setQueryCount(desc.count);
+
+        if (desc.type == QueryType::PipelineStatistics)
+        {
+            // All the statistics, which makes the results match the D3D12_QUERY_DATA_PIPELINE_STATISTICS layout
+            poolInfo.setQueryType(vk::QueryType::ePipelineStatistics)
+                .setPipelineStatistics(
+                    vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+                    vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+                    vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+                    vk::QueryPipelineStatisticFlagBits::eGeometryShaderInvocations |
+                    vk::QueryPipelineStatisticFlagBits::eGeometryShaderPrimitives |
+                    vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+                    vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+                    vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+                    vk::QueryPipelineStatisticFlagBits::eTessellationControlShaderPatches |
+                    vk::QueryPipelineStatisticFlagBits::eTessellationEvaluationShaderInvocations |
+                    vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations);
+        }
+        else
+        {
+            poolInfo.setQueryType(vk::QueryType::eOcclusion);
+        }
+
+        QueryPool* pool = new QueryPool(m_Context);
+        pool->desc = desc;
+
+        const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &pool->queryPool);
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to create query pool " + std::string(utils::DebugNameToString(desc.debugName)));
+            delete pool;
+            return nullptr;
+        }
+
+        m_Context.nameVKObject(VkQueryPool(pool->queryPool), vk::DebugReportObjectTypeEXT::eQueryPool, desc.debugName.c_str());
+
+        return QueryPoolHandle::Create(pool);
+    }
+
+    void CommandList::resetQueries(IQueryPool* _pool, uint32_t firstQuery, uint32_t numQueries)
+    {
+        // Query resets are not allowed inside a render pass
+        endRenderPass();
+
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(pool->queryPool, firstQuery, numQueries);
+    }
+
+    void CommandList::beginQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        // Counting occlusion queries need exact sample counts, binary ones are satisfied by any nonzero value
+        vk::QueryControlFlags flags;
+        if (pool->desc.type == QueryType::Occlusion && m_Context.physicalDeviceFeatures.occlusionQueryPrecise)
+            flags = vk::QueryControlFlagBits::ePrecise;
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+        m_CurrentCmdBuf->cmdBuf.beginQuery(pool->queryPool, queryIndex, flags);
+    }
+
+    void CommandList::endQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->cmdBuf.endQuery(pool->queryPool, queryIndex);
+    }
+
+    void CommandList::resolveQueries(IQueryPool* _pool, uint32_t firstQuery, uint32_t numQueries, IBuffer* _buffer, uint64_t offsetBytes)
+    {
+        endRenderPass();
+
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        assert(m_CurrentCmdBuf);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+
+        // eWait makes the copy wait for the queries to be available on the GPU, like ResolveQueryData does
+        m_CurrentCmdBuf->cmdBuf.copyQueryPoolResults(pool->queryPool, firstQuery, numQueries,
+            buffer->buffer, offsetBytes, getQueryResultStride(pool->desc.type),
+            vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+    }
+
+    void CommandList::setPredication(IBuffer* _buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        if (!m_Context.extensions.EXT_conditional_rendering)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        // Conditional rendering that is begun outside of a render pass must also end outside of it
+        endRenderPass();
+        endConditionalRendering();
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (!buffer)
+            return;
+
+        assert(m_CurrentCmdBuf);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::Predication);
+        }
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+
+        // Vulkan skips the commands when the 32-bit value is zero, unless the condition is inverted
+        auto conditionalRenderingInfo = vk::ConditionalRenderingBeginInfoEXT()
+            .setBuffer(buffer->buffer)
+            .setOffset(offsetBytes)
+            .setFlags(op == PredicationOp::SkipIfNotZero
+                ? vk::ConditionalRenderingFlagBitsEXT::eInverted
+                : vk::ConditionalRenderingFlagsEXT());
+
+        m_CurrentCmdBuf->cmdBuf.beginConditionalRenderingEXT(&conditionalRenderingInfo);
+        m_ConditionalRenderingActive = true;
+    }
+
+    void CommandList::endConditionalRendering()
+    {
+        if (m_ConditionalRenderingActive)
+        {
+            m_CurrentCmdBuf->cmdBuf.endConditionalRenderingEXT();
+            m_ConditionalRenderingActive = false;
+        }
+    }
+
     void CommandList::beginMarker(const char* name)
     {
         if (m_Context.extensions.EXT_debug_marker)
@@ -217,10 +391,14 @@ namespace nvrhi::vulkan
                                 .setPMarkerName(name);
             m_CurrentCmdBuf->cmdBuf.debugMarkerBeginEXT(&markerInfo);
         }
+
+        writeProfilerTimestamp(m_ProfilerRecording.beginScope(name));
     }
 
     void CommandList::endMarker()
     {
+        writeProfilerTimestamp(m_ProfilerRecording.endScope());
+
         if (m_Context.extensions.EXT_debug_marker)
         {
             assert(m_CurrentCmdBuf);
@@ -229,4 +407,187 @@ namespace nvrhi::vulkan
         }
     }
 
+    GpuProfiler::GpuProfiler(const VulkanContext& context, Device* device, const GpuProfilerDesc& desc)
+        : GpuProfilerBase(device, desc)
+        , m_Context(context)
+        , m_Device(device)
+        , m_FrameSubmissionIDs(size_t(getFrameCount()) * size_t(CommandQueue::Count), 0)
+    { }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        if (queryPool)
+        {
+            m_Context.device.destroyQueryPool(queryPool, m_Context.allocationCallbacks);
+            queryPool = vk::QueryPool();
+        }
+    }
+
+    void GpuProfiler::onFrameEnded(uint32_t frameSlot)
+    {
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            Queue* queue = m_Device->getQueue(CommandQueue(queueIndex));
+            m_FrameSubmissionIDs[frameSlot * uint32_t(CommandQueue::Count) + queueIndex] = queue ? queue->getLastSubmittedID() : 0;
+        }
+    }
+
+    bool GpuProfiler::isFrameCompleted(uint32_t frameSlot, bool wait)
+    {
+        m_Device->flushSubmissions();
+
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            const uint64_t submissionID = m_FrameSubmissionIDs[frameSlot * uint32_t(CommandQueue::Count) + queueIndex];
+            Queue* queue = m_Device->getQueue(CommandQueue(queueIndex));
+
+            if (!queue || submissionID == 0)
+                continue;
+
+            const bool completed = wait
+                ? queue->waitCommandList(submissionID, ~0ull)
+                : queue->pollCommandList(submissionID);
+
+            if (!completed)
+                return false;
+        }
+
+        return true;
+    }
+
+    double GpuProfiler::getTimestampFrequency(CommandQueue queue)
+    {
+        (void)queue;
+
+        const float timestampPeriod = m_Context.physicalDeviceProperties.limits.timestampPeriod; // in nanoseconds
+        if (timestampPeriod <= 0.f)
+            return 1.0;
+
+        return 1e9 / double(timestampPeriod);
+    }
+
+    GpuProfilerHandle Device::createGpuProfiler(const GpuProfilerDesc& desc)
+    {
+        GpuProfiler* profiler = new GpuProfiler(m_Context, this, desc);
+
+        auto poolInfo = vk::QueryPoolCreateInfo()
+            .setQueryType(vk::QueryType::eTimestamp)
+            .setQueryCount(profiler->getTotalQueryCount());
+
+        const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &profiler->queryPool);
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to create a query pool for the GPU profiler");
+            delete profiler;
+            return nullptr;
+        }
+
+        BufferDesc readbackDesc;
+        readbackDesc.byteSize = uint64_t(profiler->getTotalQueryCount()) * sizeof(uint64_t);
+        readbackDesc.cpuAccess = CpuAccessMode::Read;
+        readbackDesc.debugName = "GpuProfilerReadback";
+
+        profiler->readbackBuffer = createBuffer(readbackDesc);
+        if (!profiler->readbackBuffer)
+        {
+            delete profiler;
+            return nullptr;
+        }
+
+        return GpuProfilerHandle::Create(profiler);
+    }
+
+    void CommandList::setGpuProfiler(IGpuProfiler* profiler)
+    {
+        // Transfer queues are not required to support timestamps, they are not profiled
+        if (m_CommandListParameters.queueType == CommandQueue::Copy)
+            profiler = nullptr;
+
+        m_ProfilerRecording.setProfiler(profiler, m_CommandListParameters.queueType);
+    }
+
+    BreadcrumbBufferHandle Device::createBreadcrumbBuffer(const BreadcrumbBufferDesc& desc)
+    {
+        return BreadcrumbBuffer::create(this, desc);
+    }
+
+    void CommandList::writeBreadcrumb(IBreadcrumbBuffer* _breadcrumbs, uint32_t markerId)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (m_GPULog == ULLONG_MAX)
+            return;
+
+        BreadcrumbBuffer* breadcrumbs = checked_cast<BreadcrumbBuffer*>(_breadcrumbs);
+        Buffer* buffer = checked_cast<Buffer*>(breadcrumbs->getBuffer());
+        assert(m_GPULog < breadcrumbs->getDesc().numSlots);
+
+        const vk::DeviceSize offset = m_GPULog * sizeof(uint32_t);
+
+        if (m_Context.extensions.AMD_buffer_marker)
+        {
+            // Written when all preceding commands have passed the bottom of the pipe, also allowed inside render passes
+            m_CurrentCmdBuf->cmdBuf.writeBufferMarkerAMD(vk::PipelineStageFlagBits::eBottomOfPipe, buffer->buffer, offset, markerId);
+        }
+        else
+        {
+            // Transfers can't be recorded inside a render pass, the next draw resumes it
+            endRenderPass();
+            m_CurrentCmdBuf->cmdBuf.fillBuffer(buffer->buffer, offset, sizeof(uint32_t), markerId);
+        }
+
+        m_CurrentCmdBuf->referencedResources.push_back(breadcrumbs);
+    }
+
+    void CommandList::writeProfilerTimestamp(const GpuProfilerRecording::Query& query)
+    {
+        if (query.index < 0)
+            return;
+
+        assert(m_CurrentCmdBuf);
+
+        GpuProfiler* profiler = checked_cast<GpuProfiler*>(m_ProfilerRecording.getProfiler());
+
+        if (query.startsBlock)
+        {
+            // Query resets are not allowed inside a render pass, same as in beginTimerQuery
+            endRenderPass();
+
+            m_CurrentCmdBuf->cmdBuf.resetQueryPool(profiler->queryPool, uint32_t(query.index), c_GpuProfilerQueryBlockSize);
+        }
+
+        m_CurrentCmdBuf->cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, profiler->queryPool, uint32_t(query.index));
+    }
+
+    void CommandList::resolveProfilerQueries()
+    {
+        GpuProfiler* profiler = checked_cast<GpuProfiler*>(m_ProfilerRecording.getProfiler());
+        if (!profiler || m_ProfilerRecording.getQueryBlocks().empty())
+        {
+            m_ProfilerRecording.finish();
+            return;
+        }
+
+        Buffer* readbackBuffer = checked_cast<Buffer*>(profiler->readbackBuffer.Get());
+
+        for (const GpuProfilerRecording::QueryBlock& block : m_ProfilerRecording.getQueryBlocks())
+        {
+            m_CurrentCmdBuf->cmdBuf.copyQueryPoolResults(profiler->queryPool,
+                block.firstQuery, block.numQueries,
+                readbackBuffer->buffer, vk::DeviceSize(block.firstQuery) * sizeof(uint64_t), sizeof(uint64_t),
+                vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+        }
+
+        auto memoryBarrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eHostRead);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+            vk::DependencyFlags(), { memoryBarrier }, {}, {});
+
+        m_CurrentCmdBuf->referencedResources.push_back(profiler);
+
+        m_ProfilerRecording.finish();
+    }
+
 } // namespace nvrhi::vulkan
\ No newline at end of file
@@ -20,15 +20,38 @@
 * DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
+
 #include "vulkan-backend.h"
 #include "nvrhi/common/misc.h"
 
 namespace nvrhi::vulkan
 {
+    static std::atomic<uint64_t> g_QueueUniqueID = 0;
 
     TrackedCommandBuffer::~TrackedCommandBuffer()
     {
-        m_Context.device.destroyCommandPool(cmdPool, m_Context.allocationCallbacks);
+        for (vk::Event event : events)
+            m_Context.device.destroyEvent(event, m_Context.allocationCallbacks);
+    }
+
+    vk::Event TrackedCommandBuffer::acquireEvent()
+    {
+        // Events are reset by the command list after each wait, so the used ones are unsignaled when the command buffer is reused
+        if (numEventsUsed < events.size())
+            return events[numEventsUsed++];
+
+        auto eventInfo = vk::EventCreateInfo()
+            .setFlags(vk::EventCreateFlagBits::eDeviceOnly);
+
+        vk::Event event;
+        const vk::Result res = m_Context.device.createEvent(&eventInfo, m_Context.allocationCallbacks, &event);
+        if (res != vk::Result::eSuccess)
+            return vk::Event();
+
+        events.push_back(event);
+        ++numEventsUsed;
+        return event;
     }
 
     Queue::Queue(const VulkanContext& context, CommandQueue queueID, vk::Queue queue, uint32_t queueFamilyIndex)
@@ -36,6 +59,7 @@ namespace nvrhi::vulkan
         , m_Queue(queue)
         , m_QueueID(queueID)
         , m_QueueFamilyIndex(queueFamilyIndex)
+        , m_UniqueID(++g_QueueUniqueID)
     {
         auto semaphoreTypeInfo = vk::SemaphoreTypeCreateInfo()
             .setSemaphoreType(vk::SemaphoreType::eTimeline);
@@ -44,35 +68,128 @@ namespace nvrhi::vulkan
             .setPNext(&semaphoreTypeInfo);
 
         trackingSemaphore = context.device.createSemaphore(semaphoreInfo, context.allocationCallbacks);
+
+        const std::vector<vk::QueueFamilyProperties> queueFamilies = context.physicalDevice.getQueueFamilyProperties();
+        if (queueFamilyIndex < queueFamilies.size())
+            m_SupportsSparseBinding = bool(queueFamilies[queueFamilyIndex].queueFlags & vk::QueueFlagBits::eSparseBinding);
     }
 
     Queue::~Queue()
     {
+        // Destroying the pools frees their command buffers. The blocks are released here even if a thread-local cache
+        // still holds the ThreadCommandPools object, because the tracked command buffers need the context to destroy their events.
+        for (const auto& threadPools : m_ThreadCommandPools)
+        {
+            for (const auto& block : threadPools->blocks)
+                m_Context.device.destroyCommandPool(block->cmdPool, m_Context.allocationCallbacks);
+            threadPools->blocks.clear();
+            threadPools->current = nullptr;
+        }
+        m_ThreadCommandPools.clear();
+
         m_Context.device.destroySemaphore(trackingSemaphore, m_Context.allocationCallbacks);
         trackingSemaphore = vk::Semaphore();
     }
 
-    TrackedCommandBufferPtr Queue::createCommandBuffer()
+    ThreadCommandPools& Queue::getThreadCommandPools()
     {
-        vk::Result res;
+        struct CacheEntry
+        {
+            uint64_t queueID;
+            std::shared_ptr<ThreadCommandPools> pools;
+        };
 
-        TrackedCommandBufferPtr ret = std::make_shared<TrackedCommandBuffer>(m_Context);
+        struct ThreadCache
+        {
+            std::vector<CacheEntry> entries;
+
+            ~ThreadCache()
+            {
+                // Let the queues reclaim the pools of this thread
+                for (const CacheEntry& entry : entries)
+                    entry.pools->threadExited.store(true, std::memory_order_release);
+            }
+        };
+
+        // Entries of destroyed queues are never matched again, because queue IDs are not reused
+        thread_local ThreadCache t_Cache;
+
+        for (const CacheEntry& entry : t_Cache.entries)
+        {
+            if (entry.queueID == m_UniqueID)
+                return *entry.pools;
+        }
+
+        // Drop the entries of destroyed queues, which were the only other owners of their pools
+        t_Cache.entries.erase(std::remove_if(t_Cache.entries.begin(), t_Cache.entries.end(),
+            [](const CacheEntry& entry) { return entry.pools.use_count() == 1; }), t_Cache.entries.end());
+
+        auto pools = std::make_shared<ThreadCommandPools>();
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_ThreadCommandPools.push_back(pools);
+        }
+
+        t_Cache.entries.push_back({ m_UniqueID, pools });
+        return *pools;
+    }
+
+    void Queue::reclaimThreadCommandPools()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (size_t index = 0; index < m_ThreadCommandPools.size(); )
+        {
+            ThreadCommandPools& pools = *m_ThreadCommandPools[index];
+
+            // The pools of an exited thread can go once none of their command buffers is pending
+            bool reclaimable = pools.threadExited.load(std::memory_order_acquire);
+            for (size_t blockIndex = 0; reclaimable && blockIndex < pools.blocks.size(); blockIndex++)
+            {
+                if (pools.blocks[blockIndex]->numPending.load(std::memory_order_acquire) != 0)
+                    reclaimable = false;
+            }
+
+            if (!reclaimable)
+            {
+                ++index;
+                continue;
+            }
+
+            for (const auto& block : pools.blocks)
+                m_Context.device.destroyCommandPool(block->cmdPool, m_Context.allocationCallbacks);
+
+            m_ThreadCommandPools[index] = std::move(m_ThreadCommandPools.back());
+            m_ThreadCommandPools.pop_back();
+        }
+    }
 
+    std::unique_ptr<CommandPoolBlock> Queue::createCommandPoolBlock()
+    {
         auto cmdPoolInfo = vk::CommandPoolCreateInfo()
                             .setQueueFamilyIndex(m_QueueFamilyIndex)
-                            .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer |
-                                        vk::CommandPoolCreateFlagBits::eTransient);
+                            .setFlags(vk::CommandPoolCreateFlagBits::eTransient);
 
-        res = m_Context.device.createCommandPool(&cmdPoolInfo, m_Context.allocationCallbacks, &ret->cmdPool);
+        vk::CommandPool cmdPool;
+        const vk::Result res = m_Context.device.createCommandPool(&cmdPoolInfo, m_Context.allocationCallbacks, &cmdPool);
         CHECK_VK_FAIL(res)
-        
-        // allocate command buffer
+
+        auto block = std::make_unique<CommandPoolBlock>();
+        block->cmdPool = cmdPool;
+        return block;
+    }
+
+    TrackedCommandBufferPtr Queue::allocateCommandBuffer(CommandPoolBlock* block)
+    {
+        TrackedCommandBufferPtr ret = std::make_shared<TrackedCommandBuffer>(m_Context);
+        ret->block = block;
+
         auto allocInfo = vk::CommandBufferAllocateInfo()
                             .setLevel(vk::CommandBufferLevel::ePrimary)
-                            .setCommandPool(ret->cmdPool)
+                            .setCommandPool(block->cmdPool)
                             .setCommandBufferCount(1);
 
-        res = m_Context.device.allocateCommandBuffers(&allocInfo, &ret->cmdBuf);
+        const vk::Result res = m_Context.device.allocateCommandBuffers(&allocInfo, &ret->cmdBuf);
         CHECK_VK_FAIL(res)
 
         return ret;
@@ -80,30 +197,86 @@ namespace nvrhi::vulkan
 
     TrackedCommandBufferPtr Queue::getOrCreateCommandBuffer()
     {
-        std::lock_guard lockGuard(m_Mutex); // this is called from CommandList::open, so free-threaded
+        // This is called from CommandList::open, so free-threaded. The pools are only accessed by the calling thread.
+        ThreadCommandPools& pools = getThreadCommandPools();
+        const uint64_t frameIndex = m_FrameIndex.load(std::memory_order_relaxed);
 
-        uint64_t recordingID = ++m_LastRecordingID;
-
-        TrackedCommandBufferPtr cmdBuf;
-        if (m_CommandBuffersPool.empty())
+        if (!pools.current || pools.current->frameIndex != frameIndex)
         {
-            cmdBuf = createCommandBuffer();
+            // Start a new frame with a pool whose command buffers have all retired, or with a new pool
+            CommandPoolBlock* block = nullptr;
+            for (const auto& candidate : pools.blocks)
+            {
+                if (candidate->numPending.load(std::memory_order_acquire) == 0)
+                {
+                    block = candidate.get();
+                    break;
+                }
+            }
+
+            if (block)
+            {
+                if (block->numUsed != 0)
+                    m_Context.device.resetCommandPool(block->cmdPool, vk::CommandPoolResetFlags());
+            }
+            else
+            {
+                std::unique_ptr<CommandPoolBlock> newBlock = createCommandPoolBlock();
+                if (!newBlock)
+                    return nullptr;
+
+                block = newBlock.get();
+                pools.blocks.push_back(std::move(newBlock));
+            }
+
+            block->numUsed = 0;
+            block->frameIndex = frameIndex;
+            pools.current = block;
         }
-        else
+
+        CommandPoolBlock* block = pools.current;
+
+        if (block->numUsed == block->commandBuffers.size())
         {
-            cmdBuf = m_CommandBuffersPool.front();
-            m_CommandBuffersPool.pop_front();
+            TrackedCommandBufferPtr cmdBuf = allocateCommandBuffer(block);
+            if (!cmdBuf)
+                return nullptr;
+
+            block->commandBuffers.push_back(cmdBuf);
         }
 
-        cmdBuf->recordingID = recordingID;
+        TrackedCommandBufferPtr cmdBuf = block->commandBuffers[block->numUsed++];
+        block->numPending.fetch_add(1, std::memory_order_relaxed);
+
+        cmdBuf->recordingID = ++m_LastRecordingID;
+        cmdBuf->numEventsUsed = 0;
         return cmdBuf;
     }
 
+    void Queue::releaseCommandBuffer(const TrackedCommandBufferPtr& cmdBuf)
+    {
+        // A command buffer that was never submitted is not in m_CommandBuffersInFlight, so retireCommandBuffers
+        // doesn't see it. It stays allocated in its pool and is reset with the pool.
+        assert(cmdBuf->submissionID == 0);
+
+        cmdBuf->referencedResources.clear();
+        cmdBuf->referencedStagingBuffers.clear();
+
+#ifdef NVRHI_WITH_RTXMU
+        cmdBuf->rtxmuBuildIds.clear();
+        cmdBuf->rtxmuCompactionIds.clear();
+#endif
+
+        // The owning thread may reset the pool as soon as this reaches zero, so it comes last
+        cmdBuf->block->numPending.fetch_sub(1, std::memory_order_release);
+    }
+
     void Queue::addWaitSemaphore(vk::Semaphore semaphore, uint64_t value)
     {
         if (!semaphore)
             return;
 
+        std::lock_guard lockGuard(m_SubmissionMutex);
         m_WaitSemaphores.push_back(semaphore);
         m_WaitSemaphoreValues.push_back(value);
     }
@@ -113,91 +286,270 @@ namespace nvrhi::vulkan
         if (!semaphore)
             return;
 
+        std::lock_guard lockGuard(m_SubmissionMutex);
         m_SignalSemaphores.push_back(semaphore);
         m_SignalSemaphoreValues.push_back(value);
     }
 
-    uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd)
+    uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd, const TrackedCommandBufferPtr& prologue)
     {
-        std::vector<vk::PipelineStageFlags> waitStageArray(m_WaitSemaphores.size());
-        std::vector<vk::CommandBuffer> commandBuffers(numCmd);
+        std::vector<vk::CommandBuffer> commandBuffers;
+        commandBuffers.reserve(numCmd + 1);
+
+        std::lock_guard lockGuard(m_SubmissionMutex);
 
-        for (size_t i = 0; i < m_WaitSemaphores.size(); i++)
+        const uint64_t submissionID = m_LastSubmittedID.load(std::memory_order_relaxed) + 1;
+
+        if (prologue)
         {
-            waitStageArray[i] = vk::PipelineStageFlagBits::eTopOfPipe;
+            // The prologue has no command list that would set its submission ID in CommandList::executed
+            prologue->submissionID = submissionID;
+            commandBuffers.push_back(prologue->cmdBuf);
+            m_CommandBuffersInFlight.push_back(prologue);
         }
 
-        m_LastSubmittedID++;
-
         for (size_t i = 0; i < numCmd; i++)
         {
             CommandList* commandList = checked_cast<CommandList*>(ppCmd[i]);
             TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
 
-            commandBuffers[i] = commandBuffer->cmdBuf;
+            // Set the ID before the command buffer becomes visible to retireCommandBuffers on another thread
+            commandBuffer->submissionID = submissionID;
+            commandBuffers.push_back(commandBuffer->cmdBuf);
             m_CommandBuffersInFlight.push_back(commandBuffer);
 
+            // Prevent deletion of e.g. UploadManager while the GPU runs. This is only taken at submission,
+            // so that an unsubmitted command buffer doesn't keep its command list alive.
+            commandBuffer->referencedResources.push_back(commandList);
+
+            m_Statistics += commandList->getStatistics();
+
             for (const auto& buffer : commandBuffer->referencedStagingBuffers)
             {
                 buffer->lastUseQueue = m_QueueID;
-                buffer->lastUseCommandListID = m_LastSubmittedID;
+                buffer->lastUseCommandListID = submissionID;
             }
         }
         
         m_SignalSemaphores.push_back(trackingSemaphore);
-        m_SignalSemaphoreValues.push_back(m_LastSubmittedID);
+        m_SignalSemaphoreValues.push_back(submissionID);
 
-        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
-            .setSignalSemaphoreValueCount(uint32_t(m_SignalSemaphoreValues.size()))
-            .setPSignalSemaphoreValues(m_SignalSemaphoreValues.data());
+        Submission submission;
+        submission.commandBuffers = std::move(commandBuffers);
+        submission.waitSemaphores = std::move(m_WaitSemaphores);
+        submission.waitSemaphoreValues = std::move(m_WaitSemaphoreValues);
+        submission.signalSemaphores = std::move(m_SignalSemaphores);
+        submission.signalSemaphoreValues = std::move(m_SignalSemaphoreValues);
 
-        if (!m_WaitSemaphoreValues.empty()) 
-        {
-            timelineSemaphoreInfo.setWaitSemaphoreValueCount(uint32_t(m_WaitSemaphoreValues.size()));
-            timelineSemaphoreInfo.setPWaitSemaphoreValues(m_WaitSemaphoreValues.data());
-        }
-
-        auto submitInfo = vk::SubmitInfo()
-            .setPNext(&timelineSemaphoreInfo)
-            .setCommandBufferCount(uint32_t(numCmd))
-            .setPCommandBuffers(commandBuffers.data())
-            .setWaitSemaphoreCount(uint32_t(m_WaitSemaphores.size()))
-            .setPWaitSemaphores(m_WaitSemaphores.data())
-            .setPWaitDstStageMask(waitStageArray.data())
-            .setSignalSemaphoreCount(uint32_t(m_SignalSemaphores.size()))
-            .setPSignalSemaphores(m_SignalSemaphores.data());
-
-        m_Queue.submit(submitInfo);
+        if (m_DeferSubmissions)
+            m_PendingSubmissions.push_back(std::move(submission));
+        else
+            submitBatches(&submission, 1);
 
         m_WaitSemaphores.clear();
         m_WaitSemaphoreValues.clear();
         m_SignalSemaphores.clear();
         m_SignalSemaphoreValues.clear();
+
+        m_LastSubmittedID.store(submissionID, std::memory_order_release);
         
-        return m_LastSubmittedID;
+        return submissionID;
+    }
+
+    void Queue::flushSubmissions()
+    {
+        // Set at device creation, so this is a cheap early out for the callers that flush on every poll
+        if (!m_DeferSubmissions)
+            return;
+
+        std::lock_guard lockGuard(m_SubmissionMutex);
+
+        flushSubmissionsLocked();
+    }
+
+    void Queue::flushSubmissionsLocked()
+    {
+        if (m_PendingSubmissions.empty())
+            return;
+
+        submitBatches(m_PendingSubmissions.data(), m_PendingSubmissions.size());
+        m_PendingSubmissions.clear();
+    }
+
+    void Queue::submitBatches(const Submission* submissions, size_t numSubmissions)
+    {
+        if (m_Context.extensions.KHR_synchronization2)
+        {
+            std::vector<vk::CommandBufferSubmitInfo> commandBufferInfos;
+            std::vector<vk::SemaphoreSubmitInfo> semaphoreInfos;
+            std::vector<vk::SubmitInfo2> submitInfos(numSubmissions);
+
+            // Reserve the arrays up front, the submit infos point into them
+            size_t numCommandBuffers = 0;
+            size_t numSemaphores = 0;
+            for (size_t i = 0; i < numSubmissions; i++)
+            {
+                numCommandBuffers += submissions[i].commandBuffers.size();
+                numSemaphores += submissions[i].waitSemaphores.size() + submissions[i].signalSemaphores.size();
+            }
+            commandBufferInfos.reserve(numCommandBuffers);
+            semaphoreInfos.reserve(numSemaphores);
+
+            for (size_t i = 0; i < numSubmissions; i++)
+            {
+                const Submission& submission = submissions[i];
+
+                const size_t firstCommandBuffer = commandBufferInfos.size();
+                for (vk::CommandBuffer commandBuffer : submission.commandBuffers)
+                    commandBufferInfos.push_back(vk::CommandBufferSubmitInfo().setCommandBuffer(commandBuffer));
+
+                const size_t firstWaitSemaphore = semaphoreInfos.size();
+                for (size_t j = 0; j < submission.waitSemaphores.size(); j++)
+                {
+                    semaphoreInfos.push_back(vk::SemaphoreSubmitInfo()
+                        .setSemaphore(submission.waitSemaphores[j])
+                        .setValue(submission.waitSemaphoreValues[j])
+                        .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+                }
+
+                const size_t firstSignalSemaphore = semaphoreInfos.size();
+                for (size_t j = 0; j < submission.signalSemaphores.size(); j++)
+                {
+                    semaphoreInfos.push_back(vk::SemaphoreSubmitInfo()
+                        .setSemaphore(submission.signalSemaphores[j])
+                        .setValue(submission.signalSemaphoreValues[j])
+                        .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+                }
+
+                submitInfos[i]
+                    .setCommandBufferInfoCount(uint32_t(submission.commandBuffers.size()))
+                    .setPCommandBufferInfos(commandBufferInfos.data() + firstCommandBuffer)
+                    .setWaitSemaphoreInfoCount(uint32_t(submission.waitSemaphores.size()))
+                    .setPWaitSemaphoreInfos(semaphoreInfos.data() + firstWaitSemaphore)
+                    .setSignalSemaphoreInfoCount(uint32_t(submission.signalSemaphores.size()))
+                    .setPSignalSemaphoreInfos(semaphoreInfos.data() + firstSignalSemaphore);
+            }
+
+            m_Queue.submit2(submitInfos);
+        }
+        else
+        {
+            std::vector<vk::PipelineStageFlags> waitStageArray;
+            std::vector<vk::TimelineSemaphoreSubmitInfo> timelineSemaphoreInfos(numSubmissions);
+            std::vector<vk::SubmitInfo> submitInfos(numSubmissions);
+
+            size_t numWaitSemaphores = 0;
+            for (size_t i = 0; i < numSubmissions; i++)
+                numWaitSemaphores += submissions[i].waitSemaphores.size();
+            waitStageArray.resize(numWaitSemaphores, vk::PipelineStageFlagBits::eTopOfPipe);
+
+            size_t firstWaitStage = 0;
+            for (size_t i = 0; i < numSubmissions; i++)
+            {
+                const Submission& submission = submissions[i];
+
+                timelineSemaphoreInfos[i]
+                    .setSignalSemaphoreValueCount(uint32_t(submission.signalSemaphoreValues.size()))
+                    .setPSignalSemaphoreValues(submission.signalSemaphoreValues.data());
+
+                if (!submission.waitSemaphoreValues.empty()) 
+                {
+                    timelineSemaphoreInfos[i].setWaitSemaphoreValueCount(uint32_t(submission.waitSemaphoreValues.size()));
+                    timelineSemaphoreInfos[i].setPWaitSemaphoreValues(submission.waitSemaphoreValues.data());
+                }
+
+                submitInfos[i]
+                    .setPNext(&timelineSemaphoreInfos[i])
+                    .setCommandBufferCount(uint32_t(submission.commandBuffers.size()))
+                    .setPCommandBuffers(submission.commandBuffers.data())
+                    .setWaitSemaphoreCount(uint32_t(submission.waitSemaphores.size()))
+                    .setPWaitSemaphores(submission.waitSemaphores.data())
+                    .setPWaitDstStageMask(waitStageArray.data() + firstWaitStage)
+                    .setSignalSemaphoreCount(uint32_t(submission.signalSemaphores.size()))
+                    .setPSignalSemaphores(submission.signalSemaphores.data());
+
+                firstWaitStage += submission.waitSemaphores.size();
+            }
+
+            m_Queue.submit(submitInfos);
+        }
+    }
+
+    uint64_t Queue::bindSparse(vk::BindSparseInfo bindInfo)
+    {
+        // Sparse binding is not ordered with the other work on the queue: wait for the previous submission,
+        // and make the next submission wait for the binding, both through the tracking semaphore.
+        std::lock_guard lockGuard(m_SubmissionMutex);
+
+        flushSubmissionsLocked();
+
+        const uint64_t waitValue = m_LastSubmittedID.load(std::memory_order_relaxed);
+        const uint64_t signalValue = waitValue + 1;
+
+        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
+            .setWaitSemaphoreValueCount(1)
+            .setPWaitSemaphoreValues(&waitValue)
+            .setSignalSemaphoreValueCount(1)
+            .setPSignalSemaphoreValues(&signalValue);
+
+        bindInfo.setPNext(&timelineSemaphoreInfo)
+            .setWaitSemaphoreCount(1)
+            .setPWaitSemaphores(&trackingSemaphore)
+            .setSignalSemaphoreCount(1)
+            .setPSignalSemaphores(&trackingSemaphore);
+
+        m_Queue.bindSparse(bindInfo, vk::Fence());
+
+        m_LastSubmittedID.store(signalValue, std::memory_order_release);
+
+        m_WaitSemaphores.push_back(trackingSemaphore);
+        m_WaitSemaphoreValues.push_back(signalValue);
+
+        return signalValue;
     }
 
     uint64_t Queue::updateLastFinishedID()
     {
-        m_LastFinishedID = m_Context.device.getSemaphoreCounterValue(trackingSemaphore);
+        const uint64_t lastFinishedID = m_Context.device.getSemaphoreCounterValue(trackingSemaphore);
+
+        // Several threads may update this, keep the largest value
+        uint64_t previous = m_LastFinishedID.load(std::memory_order_relaxed);
+        while (previous < lastFinishedID && !m_LastFinishedID.compare_exchange_weak(previous, lastFinishedID, std::memory_order_acq_rel))
+        { }
 
-        return m_LastFinishedID;
+        return lastFinishedID;
     }
 
-    void Queue::retireCommandBuffers()
+    bool Queue::retireCommandBuffers(GarbageCollectionBudgetTracker& budget)
     {
-        std::list<TrackedCommandBufferPtr> submissions = std::move(m_CommandBuffersInFlight);
+        // Take the list so that the resources are released without holding the submission lock,
+        // and give back the command buffers that are still in flight at the end
+        std::list<TrackedCommandBufferPtr> submissions;
+        {
+            std::lock_guard lockGuard(m_SubmissionMutex);
+            submissions.swap(m_CommandBuffersInFlight);
+        }
+
+        std::list<TrackedCommandBufferPtr> stillInFlight;
 
         uint64_t lastFinishedID = updateLastFinishedID();
+        bool allRetired = true;
         
         for (const TrackedCommandBufferPtr& cmd : submissions)
         {
             if (cmd->submissionID <= lastFinishedID)
             {
+                // A partially released command buffer stays in flight, the next call continues with it
+                if (!budget.release(cmd->referencedResources) || !budget.release(cmd->referencedStagingBuffers))
+                {
+                    allRetired = false;
+                    stillInFlight.push_back(cmd);
+                    continue;
+                }
+
                 cmd->referencedResources.clear();
                 cmd->referencedStagingBuffers.clear();
                 cmd->submissionID = 0;
-                m_CommandBuffersPool.push_back(cmd);
 
 #ifdef NVRHI_WITH_RTXMU
                 if (!cmd->rtxmuBuildIds.empty())
@@ -215,16 +567,33 @@ namespace nvrhi::vulkan
                     cmd->rtxmuCompactionIds.clear();
                 }
 #endif
+
+                // The owning thread may reset the pool as soon as this reaches zero, so it comes last
+                cmd->block->numPending.fetch_sub(1, std::memory_order_release);
             }
             else
             {
-                m_CommandBuffersInFlight.push_back(cmd);
+                stillInFlight.push_back(cmd);
             }
         }
+
+        {
+            std::lock_guard lockGuard(m_SubmissionMutex);
+            m_CommandBuffersInFlight.splice(m_CommandBuffersInFlight.begin(), stillInFlight);
+        }
+
+        // Garbage collection happens once per frame, recording threads move to another pool after that
+        ++m_FrameIndex;
+
+        reclaimThreadCommandPools();
+
+        return allRetired;
     }
 
     TrackedCommandBufferPtr Queue::getCommandBufferInFlight(uint64_t submissionID)
     {
+        std::lock_guard lockGuard(m_SubmissionMutex);
+
         for (const TrackedCommandBufferPtr& cmd : m_CommandBuffersInFlight)
         {
             if (cmd->submissionID == submissionID)
@@ -267,7 +636,7 @@ namespace nvrhi::vulkan
 
     bool Queue::pollCommandList(uint64_t commandListID)
     {
-        if (commandListID > m_LastSubmittedID || commandListID == 0)
+        if (commandListID > getLastSubmittedID() || commandListID == 0)
             return false;
         
         bool completed = getLastFinishedID() >= commandListID;
@@ -280,7 +649,7 @@ namespace nvrhi::vulkan
 
     bool Queue::waitCommandList(uint64_t commandListID, uint64_t timeout)
     {
-        if (commandListID > m_LastSubmittedID || commandListID == 0)
+        if (commandListID > getLastSubmittedID() || commandListID == 0)
             return false;
 
         if (pollCommandList(commandListID))
@@ -297,4 +666,14 @@ namespace nvrhi::vulkan
 
         return (result == vk::Result::eSuccess);
     }
+
+    CommandListStatistics Queue::getStatistics(bool reset)
+    {
+        std::lock_guard lockGuard(m_SubmissionMutex);
+
+        CommandListStatistics statistics = m_Statistics;
+        if (reset)
+            m_Statistics = CommandListStatistics();
+        return statistics;
+    }
 } // namespace nvrhi::vulkan
@@ -22,6 +22,8 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <thread>
+#include <algorithm>
 
 namespace nvrhi::vulkan
 {
@@ -255,20 +257,34 @@ namespace nvrhi::vulkan
             auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
                 vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
 
-            BufferDesc bufferDesc;
-            bufferDesc.byteSize = buildSizes.accelerationStructureSize;
-            bufferDesc.debugName = desc.debugName;
-            bufferDesc.initialState = desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
-            bufferDesc.keepInitialState = true;
-            bufferDesc.isAccelStructStorage = true;
-            bufferDesc.isVirtual = desc.isVirtual;
-            as->dataBuffer = createBuffer(bufferDesc);
+            const bool suballocate = desc.allowSuballocation && !desc.isTopLevel && !desc.isVirtual;
+
+            if (suballocate && m_AccelStructPool.allocate(buildSizes.accelerationStructureSize, as->poolAllocation))
+            {
+                as->pool = &m_AccelStructPool;
+                as->dataBuffer = as->poolAllocation.buffer;
+                as->dataOffset = as->poolAllocation.offset;
+            }
+            else
+            {
+                BufferDesc bufferDesc;
+                bufferDesc.byteSize = buildSizes.accelerationStructureSize;
+                bufferDesc.debugName = desc.debugName;
+                bufferDesc.initialState = desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
+                bufferDesc.keepInitialState = true;
+                bufferDesc.isAccelStructStorage = true;
+                bufferDesc.isVirtual = desc.isVirtual;
+                as->dataBuffer = createBuffer(bufferDesc);
+            }
+
+            as->dataSize = buildSizes.accelerationStructureSize;
 
             Buffer* dataBuffer = checked_cast<Buffer*>(as->dataBuffer.Get());
 
             auto createInfo = vk::AccelerationStructureCreateInfoKHR()
                 .setType(desc.isTopLevel ? vk::AccelerationStructureTypeKHR::eTopLevel : vk::AccelerationStructureTypeKHR::eBottomLevel)
                 .setBuffer(dataBuffer->buffer)
+                .setOffset(as->dataOffset)
                 .setSize(buildSizes.accelerationStructureSize);
 
             as->accelStruct = m_Context.device.createAccelerationStructureKHR(createInfo, m_Context.allocationCallbacks);
@@ -282,6 +298,22 @@ namespace nvrhi::vulkan
             }
         }
 
+        if (desc.isTopLevel && desc.persistentInstanceBuffer)
+        {
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = std::max<uint64_t>(desc.topLevelMaxInstances, 1) * sizeof(vk::AccelerationStructureInstanceKHR);
+            bufferDesc.isAccelStructBuildInput = true;
+            bufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = desc.debugName + " instances";
+            as->instanceBuffer = createBuffer(bufferDesc);
+            if (!as->instanceBuffer)
+            {
+                delete as;
+                return nullptr;
+            }
+        }
+
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the Desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
         {
@@ -389,161 +421,274 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.buildMicromapsEXT(1, &buildInfo);
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        const rt::BottomLevelBuildDesc build = rt::BottomLevelBuildDesc()
+            .setAccelStruct(as)
+            .setGeometries(pGeometries, numGeometries)
+            .setBuildFlags(buildFlags);
 
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
+        buildBottomLevelAccelStructs(&build, 1);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BottomLevelBuildDesc* pBuilds, size_t numBuilds)
+    {
+        if (numBuilds == 0)
+            return;
+
+        struct BlasBuild
         {
-            assert(as->allowUpdate);
-        }
+            AccelStruct* as = nullptr;
+            std::vector<vk::AccelerationStructureGeometryKHR> geometries;
+            std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
+            std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
+            std::vector<uint32_t> maxPrimitiveCounts;
+            vk::AccelerationStructureBuildGeometryInfoKHR buildInfo;
+            uint64_t scratchSize = 0;
+        };
 
-        std::vector<vk::AccelerationStructureGeometryKHR> geometries;
-        std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
-        std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
-        std::vector<uint32_t> maxPrimitiveCounts;
-        geometries.resize(numGeometries);
-        omms.resize(numGeometries);
-        maxPrimitiveCounts.resize(numGeometries);
-        buildRanges.resize(numGeometries);
+        std::vector<BlasBuild> blasBuilds(numBuilds);
 
-        for (size_t i = 0; i < numGeometries; i++)
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            convertBottomLevelGeometry(pGeometries[i], geometries[i], omms[i], maxPrimitiveCounts[i], &buildRanges[i], m_Context);
+            const rt::BottomLevelBuildDesc& build = pBuilds[buildIndex];
+            BlasBuild& blasBuild = blasBuilds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+            blasBuild.as = as;
 
-            const rt::GeometryDesc& src = pGeometries[i];
+            const bool performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+            if (performUpdate)
+            {
+                assert(as->allowUpdate);
+            }
 
-            switch (src.geometryType)
+            const size_t numGeometries = build.numGeometries;
+            blasBuild.geometries.resize(numGeometries);
+            blasBuild.omms.resize(numGeometries);
+            blasBuild.maxPrimitiveCounts.resize(numGeometries);
+            blasBuild.buildRanges.resize(numGeometries);
+
+            for (size_t i = 0; i < numGeometries; i++)
             {
-            case rt::GeometryType::Triangles: {
-                const rt::GeometryTriangles& srct = src.geometryData.triangles;
-                if (m_EnableAutomaticBarriers)
+                convertBottomLevelGeometry(build.geometries[i], blasBuild.geometries[i], blasBuild.omms[i],
+                    blasBuild.maxPrimitiveCounts[i], &blasBuild.buildRanges[i], m_Context);
+
+                const rt::GeometryDesc& src = build.geometries[i];
+
+                switch (src.geometryType)
                 {
-                    if (srct.indexBuffer)
-                        requireBufferState(srct.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
-                    if (srct.vertexBuffer)
-                        requireBufferState(srct.vertexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
-                    if (OpacityMicromap* om = checked_cast<OpacityMicromap*>(srct.opacityMicromap))
-                        requireBufferState(om->dataBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                case rt::GeometryType::Triangles: {
+                    const rt::GeometryTriangles& srct = src.geometryData.triangles;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (srct.indexBuffer)
+                            requireBufferState(srct.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                        if (srct.vertexBuffer)
+                            requireBufferState(srct.vertexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                        if (OpacityMicromap* om = checked_cast<OpacityMicromap*>(srct.opacityMicromap))
+                            requireBufferState(om->dataBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                    }
+                    break;
+                }
+                case rt::GeometryType::AABBs: {
+                    const rt::GeometryAABBs& srca = src.geometryData.aabbs;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (srca.buffer)
+                            requireBufferState(srca.buffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                    }
+                    break;
                 }
-                break;
-            }
-            case rt::GeometryType::AABBs: {
-                const rt::GeometryAABBs& srca = src.geometryData.aabbs;
-                if (m_EnableAutomaticBarriers)
-                {
-                    if (srca.buffer)
-                        requireBufferState(srca.buffer, nvrhi::ResourceStates::AccelStructBuildInput);
                 }
-                break;
             }
+
+            blasBuild.buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
+                .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+                .setMode(performUpdate ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild)
+                .setGeometries(blasBuild.geometries)
+                .setFlags(convertAccelStructBuildFlags(build.buildFlags))
+                .setDstAccelerationStructure(as->accelStruct);
+
+            if (as->allowUpdate)
+                blasBuild.buildInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+
+            if (performUpdate)
+                blasBuild.buildInfo.setSrcAccelerationStructure(as->accelStruct);
+
+#ifndef NVRHI_WITH_RTXMU
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
             }
-        }
 
-        auto buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
-            .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
-            .setMode(performUpdate ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild)
-            .setGeometries(geometries)
-            .setFlags(convertAccelStructBuildFlags(buildFlags))
-            .setDstAccelerationStructure(as->accelStruct);
+            auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
+                vk::AccelerationStructureBuildTypeKHR::eDevice, blasBuild.buildInfo, blasBuild.maxPrimitiveCounts);
 
-        if (as->allowUpdate)
-            buildInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+            if (buildSizes.accelerationStructureSize > as->dataSize)
+            {
+                std::stringstream ss;
+                ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                    << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
+                    << as->dataSize << " bytes";
 
-        if (performUpdate)
-            buildInfo.setSrcAccelerationStructure(as->accelStruct);
-        
-#ifdef NVRHI_WITH_RTXMU
+                m_Context.error(ss.str());
+                return;
+            }
+
+            blasBuild.scratchSize = align<uint64_t>(performUpdate
+                ? buildSizes.updateScratchSize
+                : buildSizes.buildScratchSize,
+                m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
+#endif
+        }
+
+        // Commit the transitions of all builds at once
         commitBarriers();
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
-        std::array<const uint32_t*, 1> maxPrimArrays = { maxPrimitiveCounts.data() };
+#ifdef NVRHI_WITH_RTXMU
+        // RTXMU takes care of the scratch memory and compaction, give it all the new builds and all the updates at once
+        std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> newBuildInfos;
+        std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> newBuildRanges;
+        std::vector<const uint32_t*> newMaxPrimArrays;
+        std::vector<AccelStruct*> newBuilds;
+        std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> updateInfos;
+        std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> updateRanges;
+        std::vector<const uint32_t*> updateMaxPrimArrays;
+        std::vector<uint64_t> buildsToUpdate;
+
+        for (BlasBuild& blasBuild : blasBuilds)
+        {
+            if (blasBuild.as->rtxmuId == ~0ull)
+            {
+                newBuildInfos.push_back(blasBuild.buildInfo);
+                newBuildRanges.push_back(blasBuild.buildRanges.data());
+                newMaxPrimArrays.push_back(blasBuild.maxPrimitiveCounts.data());
+                newBuilds.push_back(blasBuild.as);
+            }
+            else
+            {
+                updateInfos.push_back(blasBuild.buildInfo);
+                updateRanges.push_back(blasBuild.buildRanges.data());
+                updateMaxPrimArrays.push_back(blasBuild.maxPrimitiveCounts.data());
+                buildsToUpdate.push_back(blasBuild.as->rtxmuId);
+            }
+        }
 
-        if(as->rtxmuId == ~0ull)
+        if (!newBuilds.empty())
         {
             std::vector<uint64_t> accelStructsToBuild;
             m_Context.rtxMemUtil->PopulateBuildCommandList(m_CurrentCmdBuf->cmdBuf,
-                                                           buildInfos.data(),
-                                                           buildRangeArrays.data(),
-                                                           maxPrimArrays.data(),
-                                                           (uint32_t)buildInfos.size(),
+                                                           newBuildInfos.data(),
+                                                           newBuildRanges.data(),
+                                                           newMaxPrimArrays.data(),
+                                                           (uint32_t)newBuildInfos.size(),
                                                            accelStructsToBuild);
 
+            for (size_t i = 0; i < newBuilds.size(); i++)
+            {
+                AccelStruct* as = newBuilds[i];
+                as->rtxmuId = accelStructsToBuild[i];
 
-            as->rtxmuId = accelStructsToBuild[0];
-            
-            as->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(as->rtxmuId);
-            as->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(as->rtxmuId);
-            as->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(as->rtxmuId);
+                as->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(as->rtxmuId);
+                as->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(as->rtxmuId);
+                as->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(as->rtxmuId);
 
-            m_CurrentCmdBuf->rtxmuBuildIds.push_back(as->rtxmuId);
+                m_CurrentCmdBuf->rtxmuBuildIds.push_back(as->rtxmuId);
+            }
         }
-        else
-        {
-            std::vector<uint64_t> buildsToUpdate(1, as->rtxmuId);
 
+        if (!buildsToUpdate.empty())
+        {
             m_Context.rtxMemUtil->PopulateUpdateCommandList(m_CurrentCmdBuf->cmdBuf,
-                                                            buildInfos.data(),
-                                                            buildRangeArrays.data(),
-                                                            maxPrimArrays.data(),
-                                                            (uint32_t)buildInfos.size(),
+                                                            updateInfos.data(),
+                                                            updateRanges.data(),
+                                                            updateMaxPrimArrays.data(),
+                                                            (uint32_t)updateInfos.size(),
                                                             buildsToUpdate);
         }
 #else
-
-        if (m_EnableAutomaticBarriers)
+        // Sort the builds by scratch size, largest first, and pack them into a shared scratch region.
+        // Builds that fit into the region at the same time go into one vkCmdBuildAccelerationStructuresKHR call,
+        // and the region is only reused after a barrier.
+        std::vector<uint32_t> buildOrder(numBuilds);
+        uint64_t totalScratchSize = 0;
+        uint64_t largestScratchSize = 0;
+        for (uint32_t i = 0; i < uint32_t(numBuilds); i++)
         {
-            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            buildOrder[i] = i;
+            totalScratchSize += blasBuilds[i].scratchSize;
+            largestScratchSize = std::max(largestScratchSize, blasBuilds[i].scratchSize);
         }
-        commitBarriers();
 
-        auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
-            vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
-
-        if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
-        {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->getDesc().byteSize << " bytes";
-
-            m_Context.error(ss.str());
-            return;
-        }
+        std::stable_sort(buildOrder.begin(), buildOrder.end(), [&blasBuilds](uint32_t a, uint32_t b)
+            { return blasBuilds[a].scratchSize > blasBuilds[b].scratchSize; });
 
-        size_t scratchSize = performUpdate
-            ? buildSizes.updateScratchSize
-            : buildSizes.buildScratchSize;
+        const uint64_t regionSize = std::min(totalScratchSize, std::max(largestScratchSize, uint64_t(m_CommandListParameters.blasBatchScratchSize)));
 
         Buffer* scratchBuffer = nullptr;
-        uint64_t scratchOffset = 0;
+        uint64_t scratchBaseOffset = 0;
         uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-        bool allocated = m_ScratchManager->suballocateBuffer(scratchSize, &scratchBuffer, &scratchOffset, nullptr,
+        bool allocated = m_ScratchManager->suballocateBuffer(regionSize, &scratchBuffer, &scratchBaseOffset, nullptr,
             currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
 
         if (!allocated)
         {
             std::stringstream ss;
-            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
-                "The build requires " << scratchSize << " bytes of scratch space.";
+            ss << "Couldn't suballocate a scratch buffer for " << numBuilds << " BLAS build(s), starting with "
+                << utils::DebugNameToString(blasBuilds[0].as->desc.debugName) << ". "
+                "The builds require " << regionSize << " bytes of scratch space.";
 
             m_Context.error(ss.str());
             return;
         }
-        
+
         assert(scratchBuffer->deviceAddress);
-        buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchOffset);
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
+        std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos;
+        std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> buildRangeArrays;
+        buildInfos.reserve(numBuilds);
+        buildRangeArrays.reserve(numBuilds);
 
-        m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
+        uint64_t scratchOffset = 0;
+        for (size_t orderIndex = 0; orderIndex <= numBuilds; orderIndex++)
+        {
+            BlasBuild* blasBuild = (orderIndex < numBuilds) ? &blasBuilds[buildOrder[orderIndex]] : nullptr;
+
+            if (!blasBuild || scratchOffset + blasBuild->scratchSize > regionSize)
+            {
+                // The region is full or this is the end of the batch: build everything that uses the region
+                m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(uint32_t(buildInfos.size()), buildInfos.data(), buildRangeArrays.data());
+                buildInfos.clear();
+                buildRangeArrays.clear();
+
+                if (!blasBuild)
+                    break;
+
+                // Wait for these builds before the next ones reuse the scratch memory
+                const auto memoryBarrier = vk::MemoryBarrier()
+                    .setSrcAccessMask(vk::AccessFlagBits::eAccelerationStructureWriteKHR)
+                    .setDstAccessMask(vk::AccessFlagBits::eAccelerationStructureReadKHR | vk::AccessFlagBits::eAccelerationStructureWriteKHR);
+
+                m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+                    vk::DependencyFlags(), memoryBarrier, {}, {});
+
+                scratchOffset = 0;
+            }
+
+            blasBuild->buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchBaseOffset + scratchOffset);
+            scratchOffset += blasBuild->scratchSize;
+
+            buildInfos.push_back(blasBuild->buildInfo);
+            buildRangeArrays.push_back(blasBuild->buildRanges.data());
+        }
 #endif
-        if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
+
+        for (const BlasBuild& blasBuild : blasBuilds)
+        {
+            if (blasBuild.as->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.push_back(blasBuild.as);
+        }
     }
 
     void CommandList::compactBottomLevelAccelStructs()
@@ -606,12 +751,12 @@ namespace nvrhi::vulkan
         auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
             vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
 
-        if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+        if (buildSizes.accelerationStructureSize > as->dataSize)
         {
             std::stringstream ss;
             ss << "TLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
                 << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->getDesc().byteSize << " bytes";
+                << as->dataSize << " bytes";
 
             m_Context.error(ss.str());
             return;
@@ -646,44 +791,88 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
     }
 
+    void AccelStruct::setInstanceBlas(size_t index, AccelStruct* blas)
+    {
+        AccelStruct* previous = instanceBlases[index];
+        if (previous == blas)
+            return;
+
+        if (previous)
+        {
+            auto it = uniqueBlases.find(previous);
+            assert(it != uniqueBlases.end());
+            if (--it->second.numInstances == 0)
+                uniqueBlases.erase(it);
+        }
+
+        if (blas)
+        {
+            BlasReference& reference = uniqueBlases[blas];
+            if (!reference.handle)
+                reference.handle = blas;
+            ++reference.numInstances;
+        }
+
+        instanceBlases[index] = blas;
+    }
+
+    static void convertInstance(const rt::InstanceDesc& src, vk::AccelerationStructureInstanceKHR& dst, const VulkanContext& context)
+    {
+        if (src.bottomLevelAS)
+        {
+            AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
+#ifdef NVRHI_WITH_RTXMU
+            blas->rtxmuBuffer = context.rtxMemUtil->GetBuffer(blas->rtxmuId);
+            blas->accelStruct = context.rtxMemUtil->GetAccelerationStruct(blas->rtxmuId);
+            blas->accelStructDeviceAddress = context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
+#else
+            (void)context;
+#endif
+            dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+        }
+        else // !src.bottomLevelAS
+        {
+            dst.setAccelerationStructureReference(0);
+        }
+
+        dst.setInstanceCustomIndex(src.instanceID);
+        dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
+        dst.setFlags(convertInstanceFlags(src.flags));
+        dst.setMask(src.instanceMask);
+        memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
+    }
+
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
 
+        if (as->instanceBuffer)
+        {
+            // Persistent TLAS: treat all instances as dirty
+            const rt::InstanceRange allInstances = rt::InstanceRange().setNumInstances(numInstances);
+            buildTopLevelAccelStructFromDirtyRanges(as, pInstances, numInstances, &allInstances, 1, buildFlags);
+            return;
+        }
+
         as->instances.resize(numInstances);
 
+        // Instances are usually sorted by BLAS, so skip the repeated transitions for runs of the same BLAS
+        rt::IAccelStruct* previousBlas = nullptr;
+
         for (size_t i = 0; i < numInstances; i++)
         {
             const rt::InstanceDesc& src = pInstances[i];
-            vk::AccelerationStructureInstanceKHR& dst = as->instances[i];
 
-            if (src.bottomLevelAS)
-            {
-                AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
-#ifdef NVRHI_WITH_RTXMU
-                blas->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(blas->rtxmuId);
-                blas->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(blas->rtxmuId);
-                blas->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
-                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
-#else
-                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+            convertInstance(src, as->instances[i], m_Context);
 
-                if (m_EnableAutomaticBarriers)
-                {
-                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
-                }
-#endif
-            }
-            else // !src.bottomLevelAS
+#ifndef NVRHI_WITH_RTXMU
+            if (src.bottomLevelAS && src.bottomLevelAS != previousBlas && m_EnableAutomaticBarriers)
             {
-                dst.setAccelerationStructureReference(0);
+                AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
+                requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
             }
-
-            dst.setInstanceCustomIndex(src.instanceID);
-            dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
-            dst.setFlags(convertInstanceFlags(src.flags));
-            dst.setMask(src.instanceMask);
-            memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
+#endif
+            previousBlas = src.bottomLevelAS;
         }
 
 #ifdef NVRHI_WITH_RTXMU
@@ -716,11 +905,116 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(as);
     }
 
+    void CommandList::buildTopLevelAccelStructFromDirtyRanges(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances,
+        const rt::InstanceRange* dirtyRanges, size_t numDirtyRanges, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer)
+        {
+            m_Context.error("buildTopLevelAccelStructFromDirtyRanges requires a TLAS created with persistentInstanceBuffer = true");
+            return;
+        }
+
+        Buffer* instanceBuffer = checked_cast<Buffer*>(as->instanceBuffer.Get());
+
+        const size_t previousNumInstances = as->instances.size();
+
+        // Release the references held by the instances that are gone
+        for (size_t i = numInstances; i < previousNumInstances; i++)
+            as->setInstanceBlas(i, nullptr);
+
+        as->instances.resize(numInstances);
+        as->instanceBlases.resize(numInstances, nullptr);
+
+        // Collect the ranges to upload: the dirty ones, clamped, plus all the new instances, then merge the overlaps
+        std::vector<rt::InstanceRange> ranges;
+        ranges.reserve(numDirtyRanges + 1);
+        for (size_t r = 0; r < numDirtyRanges; r++)
+        {
+            const size_t first = std::min(dirtyRanges[r].firstInstance, numInstances);
+            const size_t count = std::min(dirtyRanges[r].numInstances, numInstances - first);
+            if (count)
+                ranges.push_back(rt::InstanceRange().setFirstInstance(first).setNumInstances(count));
+        }
+        if (numInstances > previousNumInstances)
+            ranges.push_back(rt::InstanceRange().setFirstInstance(previousNumInstances).setNumInstances(numInstances - previousNumInstances));
+
+#ifdef NVRHI_WITH_RTXMU
+        // BLAS addresses change when RTXMU compacts them, so the persistent data cannot be trusted
+        ranges.clear();
+        if (numInstances)
+            ranges.push_back(rt::InstanceRange().setNumInstances(numInstances));
+#endif
+
+        std::sort(ranges.begin(), ranges.end(), [](const rt::InstanceRange& a, const rt::InstanceRange& b)
+            { return a.firstInstance < b.firstInstance; });
+
+        size_t numMergedRanges = 0;
+        for (const rt::InstanceRange& range : ranges)
+        {
+            if (numMergedRanges > 0)
+            {
+                rt::InstanceRange& last = ranges[numMergedRanges - 1];
+                const size_t lastEnd = last.firstInstance + last.numInstances;
+                if (range.firstInstance <= lastEnd)
+                {
+                    last.numInstances = std::max(lastEnd, range.firstInstance + range.numInstances) - last.firstInstance;
+                    continue;
+                }
+            }
+            ranges[numMergedRanges++] = range;
+        }
+        ranges.resize(numMergedRanges);
+
+        for (const rt::InstanceRange& range : ranges)
+        {
+            for (size_t i = range.firstInstance; i < range.firstInstance + range.numInstances; i++)
+            {
+                convertInstance(pInstances[i], as->instances[i], m_Context);
+                as->setInstanceBlas(i, checked_cast<AccelStruct*>(pInstances[i].bottomLevelAS));
+            }
+
+            writeBuffer(instanceBuffer, &as->instances[range.firstInstance], // NOLINT(bugprone-undefined-memory-manipulation)
+                range.numInstances * sizeof(vk::AccelerationStructureInstanceKHR),
+                range.firstInstance * sizeof(vk::AccelerationStructureInstanceKHR));
+        }
+
+#ifdef NVRHI_WITH_RTXMU
+        m_Context.rtxMemUtil->PopulateUAVBarriersCommandList(m_CurrentCmdBuf->cmdBuf, m_CurrentCmdBuf->rtxmuBuildIds);
+#endif
+
+        if (m_EnableAutomaticBarriers)
+        {
+#ifndef NVRHI_WITH_RTXMU
+            // Each referenced BLAS is transitioned once, no matter how many instances use it
+            for (const auto& [blas, reference] : as->uniqueBlases)
+                requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+#endif
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            requireBufferState(instanceBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+        }
+        commitBarriers();
+
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+        buildTopLevelAccelStructInternal(as, instanceBuffer->deviceAddress, numInstances, buildFlags, currentVersion);
+
+        m_CurrentCmdBuf->referencedResources.push_back(instanceBuffer);
+
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.push_back(as);
+    }
+
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* _instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
         Buffer* instanceBuffer = checked_cast<Buffer*>(_instanceBuffer);
 
+        // The persistent instance data, if any, is no longer valid: the next dirty-range build uploads everything
+        for (size_t i = 0; i < as->instanceBlases.size(); i++)
+            as->setInstanceBlas(i, nullptr);
+        as->instanceBlases.clear();
         as->instances.clear();
 
         if (m_EnableAutomaticBarriers)
@@ -757,6 +1051,9 @@ namespace nvrhi::vulkan
             m_Context.device.destroyAccelerationStructureKHR(accelStruct, m_Context.allocationCallbacks);
             accelStruct = nullptr;
         }
+
+        if (pool)
+            pool->release(poolAllocation);
     }
 
     Object AccelStruct::getNativeObject(ObjectType objectType)
@@ -781,7 +1078,7 @@ namespace nvrhi::vulkan
         if (!desc.isTopLevel)
             return m_Context.rtxMemUtil->GetDeviceAddress(rtxmuId);
 #endif
-        return getBufferAddress(dataBuffer, 0).deviceAddress;
+        return getBufferAddress(dataBuffer, dataOffset).deviceAddress;
     }
 
     OpacityMicromap::~OpacityMicromap()
@@ -841,17 +1138,24 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(state.shaderTable);
         }
 
-        if (!m_CurrentRayTracingState.shaderTable || m_CurrentRayTracingState.shaderTable->getPipeline() != pso)
+        const bool updatePipeline = !m_CurrentRayTracingState.shaderTable || m_CurrentRayTracingState.shaderTable->getPipeline() != pso;
+
+        if (updatePipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, pso->pipeline);
+            m_Statistics.pipelineBinds++;
             m_CurrentPipelineLayout = pso->pipelineLayout;
             m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
         }
 
-        if (arraysAreDifferent(m_CurrentRayTracingState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (updatePipeline || arraysAreDifferent(m_CurrentRayTracingState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, state.bindings);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, state.bindings);
+        }
 
         // Rebuild the SBT if we're binding a new one or if it's been changed since the previous bind.
 
@@ -976,6 +1280,7 @@ namespace nvrhi::vulkan
             &m_CurrentShaderTablePointers.hitGroups,
             &m_CurrentShaderTablePointers.callable,
             args.width, args.height, args.depth);
+        m_Statistics.dispatchCalls++;
     }
 
     void CommandList::updateRayTracingVolatileBuffers()
@@ -984,7 +1289,7 @@ namespace nvrhi::vulkan
         {
             RayTracingPipeline* pso = checked_cast<RayTracingPipeline*>(m_CurrentRayTracingState.shaderTable->getPipeline());
 
-            bindBindingSets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, m_CurrentComputeState.bindings);
+            bindVolatileBufferOffsets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, m_CurrentRayTracingState.bindings);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -1010,6 +1315,11 @@ namespace nvrhi::vulkan
     }
 
     rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        return createRayTracingPipeline(desc, nullptr);
+    }
+
+    rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc, PipelineCreationTask* task)
     {
         RayTracingPipeline* pso = new RayTracingPipeline(m_Context);
         pso->desc = desc;
@@ -1200,11 +1510,54 @@ namespace nvrhi::vulkan
             .setMaxPipelineRayRecursionDepth(desc.maxRecursionDepth)
             .setPLibraryInfo(&libraryInfo);
 
-        res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
+        if (m_Context.descriptorBufferHeap)
+            pipelineInfo.flags |= vk::PipelineCreateFlagBits::eDescriptorBufferEXT;
+
+        vk::DeferredOperationKHR deferredOperation;
+        if (task && m_Context.extensions.KHR_deferred_host_operations)
+        {
+            res = m_Context.device.createDeferredOperationKHR(m_Context.allocationCallbacks, &deferredOperation);
+            if (res != vk::Result::eSuccess)
+                deferredOperation = vk::DeferredOperationKHR();
+        }
+
+        res = m_Context.device.createRayTracingPipelinesKHR(deferredOperation, m_Context.pipelineCache,
             1, &pipelineInfo,
             m_Context.allocationCallbacks,
             &pso->pipeline);
 
+        if (deferredOperation)
+        {
+            if (res == vk::Result::eOperationDeferredKHR)
+            {
+                // Let the other threads joining the task work on the operation, then join it on this thread.
+                // The create infos above must stay alive until the operation completes, so this function does not return early.
+                const vk::Device device = m_Context.device;
+                auto joinOperation = [device, deferredOperation]()
+                {
+                    while (device.deferredOperationJoinKHR(deferredOperation) == vk::Result::eThreadIdleKHR)
+                        std::this_thread::yield();
+                };
+
+                const uint32_t maxConcurrency = m_Context.device.getDeferredOperationMaxConcurrencyKHR(deferredOperation);
+                task->setHelper(joinOperation, maxConcurrency > 1 ? maxConcurrency - 1 : 0);
+
+                joinOperation();
+
+                // Other threads may still be finishing their parts of the work
+                while ((res = m_Context.device.getDeferredOperationResultKHR(deferredOperation)) == vk::Result::eNotReady)
+                    std::this_thread::yield();
+
+                task->clearHelper();
+            }
+            else if (res == vk::Result::eOperationNotDeferredKHR)
+            {
+                res = vk::Result::eSuccess;
+            }
+
+            m_Context.device.destroyDeferredOperationKHR(deferredOperation, m_Context.allocationCallbacks);
+        }
+
         CHECK_VK_FAIL(res)
 
         // Obtain the shader group handles to fill the SBT buffer later
@@ -1237,10 +1590,36 @@ namespace nvrhi::vulkan
 
     rt::ShaderTableHandle RayTracingPipeline::createShaderTable()
     {
-        ShaderTable* st = new ShaderTable(m_Context, this);
+        return createShaderTable(rt::ShaderTableDesc());
+    }
+
+    rt::ShaderTableHandle RayTracingPipeline::createShaderTable(const rt::ShaderTableDesc& tableDesc)
+    {
+        if (tableDesc.allowGpuWrites)
+        {
+            // GPU-filled tables need a cached table buffer, which is not implemented on Vulkan
+            utils::NotSupported();
+            return nullptr;
+        }
+
+        ShaderTable* st = new ShaderTable(m_Context, this, tableDesc);
         return rt::ShaderTableHandle::Create(st);
     }
 
+    uint32_t RayTracingPipeline::getShaderTableEntrySize() const
+    {
+        return m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment;
+    }
+
+    const void* RayTracingPipeline::getShaderIdentifier(const char* exportName)
+    {
+        const int shaderGroupIndex = findShaderGroup(exportName);
+        if (shaderGroupIndex < 0)
+            return nullptr;
+
+        return shaderGroupHandles.data() + size_t(shaderGroupIndex) * m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
+    }
+
     Object RayTracingPipeline::getNativeObject(ObjectType objectType)
     {
         switch (objectType)
@@ -1342,6 +1721,42 @@ namespace nvrhi::vulkan
         return -1;
     }
 
+    bool ShaderTable::setShaderGroup(std::vector<uint32_t>& groups, uint32_t index, const char* exportName, IBindingSet* bindings)
+    {
+        if (bindings != nullptr)
+            utils::NotSupported();
+
+        if (index >= groups.size())
+        {
+            m_Context.error("Shader table record index is out of bounds");
+            return false;
+        }
+
+        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
+
+        if (!verifyShaderGroupExists(exportName, shaderGroupIndex))
+            return false;
+
+        groups[index] = uint32_t(shaderGroupIndex);
+        ++version;
+        return true;
+    }
+
+    bool ShaderTable::setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setShaderGroup(missShaders, index, exportName, bindings);
+    }
+
+    bool ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setShaderGroup(hitGroups, index, exportName, bindings);
+    }
+
+    bool ShaderTable::setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        return setShaderGroup(callableShaders, index, exportName, bindings);
+    }
+
     void ShaderTable::clearMissShaders()
     {
         missShaders.clear();
@@ -22,12 +22,30 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <sstream>
+#include <thread>
 
 namespace nvrhi::vulkan
 {
+    // the minimum value of VkPhysicalDevicePushDescriptorPropertiesKHR::maxPushDescriptors guaranteed by the spec
+    constexpr uint32_t c_MinMaxPushDescriptors = 32;
 
     BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
     {
+        if (m_Context.descriptorBufferHeap)
+        {
+            // descriptor buffers cannot contain dynamic descriptors, which are used for volatile CBs
+            for (const BindingLayoutItem& binding : desc.bindings)
+            {
+                if (binding.type == ResourceType::VolatileConstantBuffer)
+                {
+                    m_Context.error("Volatile constant buffers are not supported when the device uses a descriptor buffer");
+                    return nullptr;
+                }
+            }
+        }
+
         BindingLayout* ret = new BindingLayout(m_Context, desc);
 
         ret->bake();
@@ -37,6 +55,12 @@ namespace nvrhi::vulkan
 
     BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
     {
+        if (desc.layoutType == BindlessLayoutType::DirectlyIndexed)
+        {
+            m_Context.error("Directly indexed bindless layouts are not supported on Vulkan");
+            return nullptr;
+        }
+
         BindingLayout* ret = new BindingLayout(m_Context, desc);
 
         ret->bake();
@@ -47,6 +71,8 @@ namespace nvrhi::vulkan
     BindingLayout::BindingLayout(const VulkanContext& context, const BindingLayoutDesc& _desc)
         : desc(_desc)
         , isBindless(false)
+        , descHash(std::hash<BindingLayoutDesc>()(_desc))
+        , descriptorSetAllocator(context)
         , m_Context(context)
     {
         vk::ShaderStageFlagBits shaderStageFlags = convertShaderTypeToShaderStageFlagBits(desc.visibility);
@@ -138,11 +164,23 @@ namespace nvrhi::vulkan
 
             vulkanLayoutBindings.push_back(descriptorSetLayoutBinding);
         }
+
+        if (desc.usePushDescriptors && m_Context.extensions.KHR_push_descriptor && !m_Context.descriptorBufferHeap)
+        {
+            // push descriptor layouts cannot contain dynamic descriptors, which are used for volatile CBs
+            bool hasVolatileConstantBuffers = false;
+            for (const BindingLayoutItem& binding : desc.bindings)
+                hasVolatileConstantBuffers = hasVolatileConstantBuffers || binding.type == ResourceType::VolatileConstantBuffer;
+
+            usesPushDescriptors = !hasVolatileConstantBuffers && vulkanLayoutBindings.size() <= c_MinMaxPushDescriptors;
+        }
     }
 
     BindingLayout::BindingLayout(const VulkanContext& context, const BindlessLayoutDesc& _desc)
         : bindlessDesc(_desc)
         , isBindless(true)
+        , descHash(std::hash<BindlessLayoutDesc>()(_desc))
+        , descriptorSetAllocator(context)
         , m_Context(context)
     {
         desc.visibility = bindlessDesc.visibility;
@@ -249,11 +287,38 @@ namespace nvrhi::vulkan
             descriptorSetLayoutInfo.setPNext(&extendedInfo);
         }
 
+        if (usesPushDescriptors)
+        {
+            descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+        }
+        else if (m_Context.descriptorBufferHeap)
+        {
+            descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT);
+        }
+
         const vk::Result res = m_Context.device.createDescriptorSetLayout(&descriptorSetLayoutInfo,
                                                                         m_Context.allocationCallbacks,
                                                                         &descriptorSetLayout);
         CHECK_VK_RETURN(res)
 
+        // descriptor buffer sets don't come from pools either, but their layout in the buffer is needed
+        if (m_Context.descriptorBufferHeap)
+        {
+            descriptorBufferSize = m_Context.device.getDescriptorSetLayoutSizeEXT(descriptorSetLayout);
+
+            for (const auto& layoutBinding : vulkanLayoutBindings)
+            {
+                descriptorBufferBindingOffsets[layoutBinding.binding] =
+                    m_Context.device.getDescriptorSetLayoutBindingOffsetEXT(descriptorSetLayout, layoutBinding.binding);
+            }
+
+            return vk::Result::eSuccess;
+        }
+
+        // push descriptors don't come from pools
+        if (usesPushDescriptors)
+            return vk::Result::eSuccess;
+
         // count the number of descriptors required per type
         std::unordered_map<vk::DescriptorType, uint32_t> poolSizeMap;
         for (auto layoutBinding : vulkanLayoutBindings)
@@ -289,6 +354,98 @@ namespace nvrhi::vulkan
         }
     }
 
+    DescriptorSetAllocator::~DescriptorSetAllocator()
+    {
+        for (vk::DescriptorPool pool : m_Pools)
+        {
+            m_Context.device.destroyDescriptorPool(pool, m_Context.allocationCallbacks);
+        }
+        m_Pools.clear();
+        m_FreeSets.clear();
+    }
+
+    vk::Result DescriptorSetAllocator::createPool(const std::vector<vk::DescriptorPoolSize>& setPoolSizes)
+    {
+        // grow the pools geometrically so that layouts with few sets don't waste memory
+        const uint32_t capacity = m_CurrentPoolCapacity == 0
+            ? c_InitialPoolCapacity
+            : std::min(m_CurrentPoolCapacity * 2, c_MaxPoolCapacity);
+
+        std::vector<vk::DescriptorPoolSize> poolSizes = setPoolSizes;
+        for (auto& poolSize : poolSizes)
+        {
+            poolSize.descriptorCount *= capacity;
+        }
+
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setPoolSizeCount(uint32_t(poolSizes.size()))
+            .setPPoolSizes(poolSizes.data())
+            .setMaxSets(capacity);
+
+        vk::DescriptorPool pool;
+        const vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pool);
+        CHECK_VK_RETURN(res)
+
+        m_Pools.push_back(pool);
+        m_CurrentPoolCapacity = capacity;
+        m_CurrentPoolAllocated = 0;
+
+        return vk::Result::eSuccess;
+    }
+
+    vk::Result DescriptorSetAllocator::allocate(vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorPoolSize>& setPoolSizes,
+        vk::DescriptorSet& outSet, vk::DescriptorPool& outPool)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // all sets in this allocator have the same layout, so a released set can be rewritten and reused directly
+        if (!m_FreeSets.empty())
+        {
+            outSet = m_FreeSets.back().first;
+            outPool = m_FreeSets.back().second;
+            m_FreeSets.pop_back();
+            return vk::Result::eSuccess;
+        }
+
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            if (m_Pools.empty() || m_CurrentPoolAllocated >= m_CurrentPoolCapacity)
+            {
+                const vk::Result res = createPool(setPoolSizes);
+                CHECK_VK_RETURN(res)
+            }
+
+            auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+                .setDescriptorPool(m_Pools.back())
+                .setDescriptorSetCount(1)
+                .setPSetLayouts(&layout);
+
+            const vk::Result res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+
+            if (res == vk::Result::eSuccess)
+            {
+                outPool = m_Pools.back();
+                ++m_CurrentPoolAllocated;
+                return res;
+            }
+
+            if (res != vk::Result::eErrorOutOfPoolMemory && res != vk::Result::eErrorFragmentedPool)
+                return res;
+
+            // the pool is exhausted earlier than expected, start a new one and try again
+            m_CurrentPoolAllocated = m_CurrentPoolCapacity;
+        }
+
+        return vk::Result::eErrorOutOfPoolMemory;
+    }
+
+    void DescriptorSetAllocator::release(vk::DescriptorSet set, vk::DescriptorPool pool)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_FreeSets.push_back(std::make_pair(set, pool));
+    }
+
     static Texture::TextureSubresourceViewType getTextureViewType(Format bindingFormat, Format textureFormat)
     {
         Format format = (bindingFormat == Format::UNKNOWN) ? textureFormat : bindingFormat;
@@ -303,43 +460,57 @@ namespace nvrhi::vulkan
             return Texture::TextureSubresourceViewType::AllAspects;
     }
 
-    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    BindingSet* Device::createBindingSetWithoutUpdate(const BindingSetDesc& desc, BindingLayout* layout, DescriptorWriteData& poolWriteData)
     {
-        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
-
         BindingSet *ret = new BindingSet(m_Context);
         ret->desc = desc;
         ret->layout = layout;
 
-        const auto& descriptorSetLayout = layout->descriptorSetLayout;
-        const auto& poolSizes = layout->descriptorPoolSizeInfo;
+        vk::Result res = vk::Result::eSuccess;
 
-        // create descriptor pool to allocate a descriptor from
-        auto poolInfo = vk::DescriptorPoolCreateInfo()
-            .setPoolSizeCount(uint32_t(poolSizes.size()))
-            .setPPoolSizes(poolSizes.data())
-            .setMaxSets(1);
+        // collect all of the descriptor write data, either to update the set by the caller or to push it at bind time
+        DescriptorWriteData* writeData = &poolWriteData;
 
-        vk::Result res = m_Context.device.createDescriptorPool(&poolInfo,
-                                                             m_Context.allocationCallbacks,
-                                                             &ret->descriptorPool);
-        CHECK_VK_FAIL(res)
-        
-        // create the descriptor set
-        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
-            .setDescriptorPool(ret->descriptorPool)
-            .setDescriptorSetCount(1)
-            .setPSetLayouts(&descriptorSetLayout);
+        DescriptorBufferHeap* descriptorBufferHeap = m_Context.descriptorBufferHeap;
 
-        res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo,
-            &ret->descriptorSet);
-        CHECK_VK_FAIL(res)
+        if (layout->usesPushDescriptors)
+        {
+            ret->pushDescriptorWrites = std::make_unique<DescriptorWriteData>();
+            writeData = ret->pushDescriptorWrites.get();
+        }
+        else if (descriptorBufferHeap)
+        {
+            // get a range of the descriptor buffer, the descriptors are written there directly below
+            if (!descriptorBufferHeap->allocate(layout->descriptorBufferSize, ret->descriptorBufferOffset))
+            {
+                m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                delete ret;
+                return nullptr;
+            }
+
+            ret->descriptorBufferSize = layout->descriptorBufferSize;
+        }
+        else
+        {
+            // get a descriptor set from the layout's shared pools
+            res = layout->descriptorSetAllocator.allocate(layout->descriptorSetLayout,
+                layout->descriptorPoolSizeInfo, ret->descriptorSet, ret->descriptorPool);
+
+            if (res != vk::Result::eSuccess)
+            {
+                std::stringstream ss;
+                ss << "Failed to allocate a descriptor set for a binding set, VkResult = " << resultToString(VkResult(res));
+                m_Context.error(ss.str());
+
+                delete ret;
+                return nullptr;
+            }
+        }
         
-        // collect all of the descriptor write data
-        static_vector<vk::DescriptorImageInfo, c_MaxBindingsPerLayout> descriptorImageInfo;
-        static_vector<vk::DescriptorBufferInfo, c_MaxBindingsPerLayout> descriptorBufferInfo;
-        static_vector<vk::WriteDescriptorSet, c_MaxBindingsPerLayout> descriptorWriteInfo;
-        static_vector<vk::WriteDescriptorSetAccelerationStructureKHR, c_MaxBindingsPerLayout> accelStructWriteInfo;
+        auto& descriptorImageInfo = writeData->imageInfos;
+        auto& descriptorBufferInfo = writeData->bufferInfos;
+        auto& descriptorWriteInfo = writeData->writes;
+        auto& accelStructWriteInfo = writeData->accelStructWrites;
 
         auto generateWriteDescriptorData =
             // generates a vk::WriteDescriptorSet struct in descriptorWriteInfo
@@ -348,8 +519,16 @@ namespace nvrhi::vulkan
                 vk::DescriptorImageInfo *imageInfo,
                 vk::DescriptorBufferInfo *bufferInfo,
                 vk::BufferView *bufferView,
-                const void* pNext = nullptr)
+                const void* pNext = nullptr,
+                const vk::DescriptorAddressInfoEXT* addressInfo = nullptr)
         {
+            if (descriptorBufferHeap)
+            {
+                descriptorBufferHeap->writeDescriptor(ret->descriptorBufferOffset + layout->descriptorBufferBindingOffsets.at(bindingLocation),
+                    descriptorType, imageInfo, addressInfo);
+                return;
+            }
+
             descriptorWriteInfo.push_back(
                 vk::WriteDescriptorSet()
                 .setDstSet(ret->descriptorSet)
@@ -452,30 +631,42 @@ namespace nvrhi::vulkan
                 auto vkformat = nvrhi::vulkan::convertFormat(format);
                 const auto range = binding.range.resolve(buffer->desc);
 
-                size_t viewInfoHash = 0;
-                nvrhi::hash_combine(viewInfoHash, range.byteOffset);
-                nvrhi::hash_combine(viewInfoHash, range.byteSize);
-                nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
-
-                const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
-                auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
-                if (bufferViewFound == buffer->viewCache.end())
+                // descriptor buffers describe texel buffers by address and format, there is no view object
+                vk::BufferView* bufferView = nullptr;
+                if (!descriptorBufferHeap)
                 {
-                    assert(format != Format::UNKNOWN);
+                    size_t viewInfoHash = 0;
+                    nvrhi::hash_combine(viewInfoHash, range.byteOffset);
+                    nvrhi::hash_combine(viewInfoHash, range.byteSize);
+                    nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
 
-                    auto bufferViewInfo = vk::BufferViewCreateInfo()
-                        .setBuffer(buffer->buffer)
-                        .setOffset(range.byteOffset)
-                        .setRange(range.byteSize)
-                        .setFormat(vk::Format(vkformat));
+                    const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
+                    auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
+                    if (bufferViewFound == buffer->viewCache.end())
+                    {
+                        assert(format != Format::UNKNOWN);
+
+                        auto bufferViewInfo = vk::BufferViewCreateInfo()
+                            .setBuffer(buffer->buffer)
+                            .setOffset(range.byteOffset)
+                            .setRange(range.byteSize)
+                            .setFormat(vk::Format(vkformat));
+
+                        res = m_Context.device.createBufferView(&bufferViewInfo, m_Context.allocationCallbacks, &bufferViewRef);
+                        ASSERT_VK_OK(res);
+                    }
 
-                    res = m_Context.device.createBufferView(&bufferViewInfo, m_Context.allocationCallbacks, &bufferViewRef);
-                    ASSERT_VK_OK(res);
+                    bufferView = &bufferViewRef;
                 }
 
+                const auto addressInfo = vk::DescriptorAddressInfoEXT()
+                    .setAddress(buffer->deviceAddress + range.byteOffset)
+                    .setRange(range.byteSize)
+                    .setFormat(vk::Format(vkformat));
+
                 generateWriteDescriptorData(layoutBinding.binding,
                     layoutBinding.descriptorType,
-                    nullptr, nullptr, &bufferViewRef);
+                    nullptr, nullptr, bufferView, nullptr, &addressInfo);
 
                 if (!buffer->permanentState)
                     ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
@@ -510,10 +701,14 @@ namespace nvrhi::vulkan
                     .setOffset(range.byteOffset)
                     .setRange(range.byteSize);
 
+                const auto addressInfo = vk::DescriptorAddressInfoEXT()
+                    .setAddress(buffer->deviceAddress + range.byteOffset)
+                    .setRange(range.byteSize);
+
                 assert(buffer->buffer);
                 generateWriteDescriptorData(layoutBinding.binding,
                     layoutBinding.descriptorType,
-                    nullptr, &bufferInfo, nullptr);
+                    nullptr, &bufferInfo, nullptr, nullptr, &addressInfo);
 
                 if (binding.type == ResourceType::VolatileConstantBuffer) 
                 {
@@ -565,9 +760,12 @@ namespace nvrhi::vulkan
                 accelStructWrite.accelerationStructureCount = 1;
                 accelStructWrite.pAccelerationStructures = &as->accelStruct;
 
+                const auto addressInfo = vk::DescriptorAddressInfoEXT()
+                    .setAddress(as->accelStructDeviceAddress);
+
                 generateWriteDescriptorData(layoutBinding.binding,
                     layoutBinding.descriptorType,
-                    nullptr, nullptr, nullptr, &accelStructWrite);
+                    nullptr, nullptr, nullptr, &accelStructWrite, &addressInfo);
 
                 ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
             }
@@ -585,16 +783,102 @@ namespace nvrhi::vulkan
             }
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        return ret;
+    }
+
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    {
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        DescriptorWriteData writeData;
+        BindingSet* ret = createBindingSetWithoutUpdate(desc, layout, writeData);
+        if (!ret)
+            return nullptr;
+
+        if (!writeData.writes.empty())
+            m_Context.device.updateDescriptorSets(uint32_t(writeData.writes.size()), writeData.writes.data(), 0, nullptr);
 
         return BindingSetHandle::Create(ret);
     }
 
+    bool Device::createBindingSets(const BindingSetDesc* descs, size_t count, IBindingLayout* _layout, BindingSetHandle* outBindingSets)
+    {
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        // Creates the sets in [begin, end) and submits their descriptor writes in batches.
+        // The write data holds up to c_MaxBindingsPerLayout entries per set, so the batches are limited to keep the storage small.
+        constexpr size_t c_SetsPerUpdate = 64;
+
+        auto createRange = [this, descs, layout, outBindingSets](size_t begin, size_t end)
+        {
+            std::vector<DescriptorWriteData> writeData(std::min(end - begin, c_SetsPerUpdate));
+            std::vector<vk::WriteDescriptorSet> writes;
+            bool success = true;
+
+            for (size_t batchBegin = begin; batchBegin < end; batchBegin += c_SetsPerUpdate)
+            {
+                const size_t batchEnd = std::min(batchBegin + c_SetsPerUpdate, end);
+                writes.clear();
+
+                for (size_t index = batchBegin; index < batchEnd; index++)
+                {
+                    DescriptorWriteData& setWriteData = writeData[index - batchBegin];
+                    setWriteData = DescriptorWriteData();
+
+                    BindingSet* bindingSet = createBindingSetWithoutUpdate(descs[index], layout, setWriteData);
+                    outBindingSets[index] = BindingSetHandle::Create(bindingSet);
+                    success &= bindingSet != nullptr;
+
+                    // the write structures point into setWriteData, which stays in place until the update below
+                    writes.insert(writes.end(), setWriteData.writes.begin(), setWriteData.writes.end());
+                }
+
+                if (!writes.empty())
+                    m_Context.device.updateDescriptorSets(uint32_t(writes.size()), writes.data(), 0, nullptr);
+            }
+
+            return success;
+        };
+
+        // Generating the writes is the expensive part, and everything it touches is free-threaded,
+        // so large batches are split across worker threads. Small batches aren't worth the thread startup.
+        constexpr size_t c_MinSetsPerThread = 256;
+        const size_t numThreads = std::clamp<size_t>(count / c_MinSetsPerThread, 1, std::max(1u, std::thread::hardware_concurrency()));
+        const size_t setsPerThread = (count + numThreads - 1) / numThreads;
+
+        std::vector<std::thread> workers;
+        std::unique_ptr<bool[]> workerSuccess = std::make_unique<bool[]>(numThreads);
+
+        for (size_t thread = 1; thread < numThreads; thread++)
+        {
+            const size_t begin = std::min(thread * setsPerThread, count);
+            const size_t end = std::min(begin + setsPerThread, count);
+            workers.emplace_back([&createRange, &workerSuccess, thread, begin, end]()
+            {
+                workerSuccess[thread] = createRange(begin, end);
+            });
+        }
+
+        workerSuccess[0] = createRange(0, std::min(setsPerThread, count));
+
+        bool success = workerSuccess[0];
+        for (size_t thread = 1; thread < numThreads; thread++)
+        {
+            workers[thread - 1].join();
+            success &= workerSuccess[thread];
+        }
+
+        return success;
+    }
+
     BindingSet::~BindingSet()
     {
-        if (descriptorPool)
+        if (m_Context.descriptorBufferHeap)
+            m_Context.descriptorBufferHeap->release(descriptorBufferOffset, descriptorBufferSize);
+
+        if (descriptorSet)
         {
-            m_Context.device.destroyDescriptorPool(descriptorPool, m_Context.allocationCallbacks);
+            checked_cast<BindingLayout*>(layout.Get())->descriptorSetAllocator.release(descriptorSet, descriptorPool);
             descriptorPool = vk::DescriptorPool();
             descriptorSet = vk::DescriptorSet();
         }
@@ -621,6 +905,21 @@ namespace nvrhi::vulkan
         ret->layout = layout;
         ret->capacity = layout->vulkanLayoutBindings[0].descriptorCount;
 
+        if (m_Context.descriptorBufferHeap)
+        {
+            // the table is a range of the descriptor buffer big enough for the layout's maxCapacity
+            if (!m_Context.descriptorBufferHeap->allocate(layout->descriptorBufferSize, ret->descriptorBufferOffset))
+            {
+                m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                delete ret;
+                return nullptr;
+            }
+
+            ret->descriptorBufferSize = layout->descriptorBufferSize;
+
+            return DescriptorTableHandle::Create(ret);
+        }
+
         const auto& descriptorSetLayout = layout->descriptorSetLayout;
         const auto& poolSizes = layout->descriptorPoolSizeInfo;
 
@@ -650,6 +949,9 @@ namespace nvrhi::vulkan
 
     DescriptorTable::~DescriptorTable()
     {
+        if (m_Context.descriptorBufferHeap)
+            m_Context.descriptorBufferHeap->release(descriptorBufferOffset, descriptorBufferSize);
+
         if (descriptorPool)
         {
             m_Context.device.destroyDescriptorPool(descriptorPool, m_Context.allocationCallbacks);
@@ -689,6 +991,8 @@ namespace nvrhi::vulkan
 
         vk::Result res;
 
+        DescriptorBufferHeap* descriptorBufferHeap = m_Context.descriptorBufferHeap;
+
         // collect all of the descriptor write data
         static_vector<vk::DescriptorImageInfo, c_MaxBindingsPerLayout> descriptorImageInfo;
         static_vector<vk::DescriptorBufferInfo, c_MaxBindingsPerLayout> descriptorBufferInfo;
@@ -700,8 +1004,20 @@ namespace nvrhi::vulkan
                 vk::DescriptorType descriptorType,
                 vk::DescriptorImageInfo* imageInfo,
                 vk::DescriptorBufferInfo* bufferInfo,
-                vk::BufferView* bufferView)
+                vk::BufferView* bufferView,
+                const vk::DescriptorAddressInfoEXT* addressInfo = nullptr)
         {
+            // with a descriptor buffer, the write is a copy of the descriptor into the array element
+            if (descriptorBufferHeap)
+            {
+                const uint64_t offset = descriptorTable->descriptorBufferOffset
+                    + layout->descriptorBufferBindingOffsets.at(bindingLocation)
+                    + uint64_t(binding.slot) * descriptorBufferHeap->getDescriptorSize(descriptorType);
+
+                descriptorBufferHeap->writeDescriptor(offset, descriptorType, imageInfo, addressInfo);
+                return;
+            }
+
             descriptorWriteInfo.push_back(
                 vk::WriteDescriptorSet()
                 .setDstSet(descriptorTable->descriptorSet)
@@ -771,30 +1087,43 @@ namespace nvrhi::vulkan
                     auto vkformat = nvrhi::vulkan::convertFormat(binding.format);
 
                     const auto range = binding.range.resolve(buffer->desc);
-                    size_t viewInfoHash = 0;
-                    nvrhi::hash_combine(viewInfoHash, range.byteOffset);
-                    nvrhi::hash_combine(viewInfoHash, range.byteSize);
-                    nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
 
-                    const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
-                    auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
-                    if (bufferViewFound == buffer->viewCache.end())
+                    // descriptor buffers describe texel buffers by address and format, there is no view object
+                    vk::BufferView* bufferView = nullptr;
+                    if (!descriptorBufferHeap)
                     {
-                        assert(binding.format != Format::UNKNOWN);
-
-                        auto bufferViewInfo = vk::BufferViewCreateInfo()
-                            .setBuffer(buffer->buffer)
-                            .setOffset(range.byteOffset)
-                            .setRange(range.byteSize)
-                            .setFormat(vk::Format(vkformat));
-
-                        res = m_Context.device.createBufferView(&bufferViewInfo, m_Context.allocationCallbacks, &bufferViewRef);
-                        ASSERT_VK_OK(res);
+                        size_t viewInfoHash = 0;
+                        nvrhi::hash_combine(viewInfoHash, range.byteOffset);
+                        nvrhi::hash_combine(viewInfoHash, range.byteSize);
+                        nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
+
+                        const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
+                        auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
+                        if (bufferViewFound == buffer->viewCache.end())
+                        {
+                            assert(binding.format != Format::UNKNOWN);
+
+                            auto bufferViewInfo = vk::BufferViewCreateInfo()
+                                .setBuffer(buffer->buffer)
+                                .setOffset(range.byteOffset)
+                                .setRange(range.byteSize)
+                                .setFormat(vk::Format(vkformat));
+
+                            res = m_Context.device.createBufferView(&bufferViewInfo, m_Context.allocationCallbacks, &bufferViewRef);
+                            ASSERT_VK_OK(res);
+                        }
+
+                        bufferView = &bufferViewRef;
                     }
 
+                    const auto addressInfo = vk::DescriptorAddressInfoEXT()
+                        .setAddress(buffer->deviceAddress + range.byteOffset)
+                        .setRange(range.byteSize)
+                        .setFormat(vk::Format(vkformat));
+
                     generateWriteDescriptorData(layoutBinding.binding,
                         layoutBinding.descriptorType,
-                        nullptr, nullptr, &bufferViewRef);
+                        nullptr, nullptr, bufferView, &addressInfo);
                 }
                 break;
 
@@ -815,10 +1144,14 @@ namespace nvrhi::vulkan
                         .setOffset(range.byteOffset)
                         .setRange(range.byteSize);
 
+                    const auto addressInfo = vk::DescriptorAddressInfoEXT()
+                        .setAddress(buffer->deviceAddress + range.byteOffset)
+                        .setRange(range.byteSize);
+
                     assert(buffer->buffer);
                     generateWriteDescriptorData(layoutBinding.binding,
                         layoutBinding.descriptorType,
-                        nullptr, &bufferInfo, nullptr);
+                        nullptr, &bufferInfo, nullptr, &addressInfo);
                 }
 
                 break;
@@ -854,44 +1187,98 @@ namespace nvrhi::vulkan
             }
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        if (!descriptorWriteInfo.empty())
+            m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
 
         return true;
     }
 
+    uint32_t CommandList::getVolatileBufferOffset(Buffer* buffer)
+    {
+        const VolatileBufferState* state = m_VolatileBufferStates.find(buffer);
+        if (!state)
+        {
+            std::stringstream ss;
+            ss << "Binding volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
+               << " before writing into it is invalid.";
+            m_Context.error(ss.str());
+
+            return 0; // use zero offset just to use something
+        }
+
+        uint32_t version = state->latestVersion;
+        uint64_t offset = version * buffer->desc.byteSize;
+        assert(offset < std::numeric_limits<uint32_t>::max());
+        return uint32_t(offset);
+    }
+
     void CommandList::bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings)
     {
         BindingVector<vk::DescriptorSet> descriptorSets;
+        BindingVector<vk::DeviceSize> descriptorBufferOffsets;
         static_vector<uint32_t, c_MaxVolatileConstantBuffers> dynamicOffsets;
+        uint32_t firstSet = 0;
+        uint32_t firstDynamicOffset = 0;
+
+        // binds the accumulated range of regular descriptor sets, which is interrupted by push descriptor sets
+        auto flushDescriptorSets = [&](uint32_t nextSet)
+        {
+            if (!descriptorSets.empty())
+            {
+                m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
+                    firstSet, uint32_t(descriptorSets.size()), descriptorSets.data(),
+                    uint32_t(dynamicOffsets.size()) - firstDynamicOffset, dynamicOffsets.data() + firstDynamicOffset);
+                m_Statistics.bindingSetBinds += uint32_t(descriptorSets.size());
+            }
+
+            if (!descriptorBufferOffsets.empty())
+            {
+                // all sets live in the one descriptor buffer bound in open()
+                BindingVector<uint32_t> bufferIndices;
+                bufferIndices.resize(descriptorBufferOffsets.size());
+                std::fill(bufferIndices.begin(), bufferIndices.end(), 0u);
+
+                m_CurrentCmdBuf->cmdBuf.setDescriptorBufferOffsetsEXT(bindPoint, pipelineLayout,
+                    firstSet, uint32_t(descriptorBufferOffsets.size()), bufferIndices.data(), descriptorBufferOffsets.data());
+                m_Statistics.bindingSetBinds += uint32_t(descriptorBufferOffsets.size());
+            }
 
-        for (const auto& bindingSetHandle : bindings)
+            descriptorSets.resize(0);
+            descriptorBufferOffsets.resize(0);
+            firstSet = nextSet;
+            firstDynamicOffset = uint32_t(dynamicOffsets.size());
+        };
+
+        for (uint32_t setIndex = 0; setIndex < uint32_t(bindings.size()); setIndex++)
         {
+            IBindingSet* bindingSetHandle = bindings[setIndex];
             const BindingSetDesc* desc = bindingSetHandle->getDesc();
             if (desc)
             {
                 BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
-                descriptorSets.push_back(bindingSet->descriptorSet);
 
-                for (Buffer* constnatBuffer : bindingSet->volatileConstantBuffers)
+                if (bindingSet->pushDescriptorWrites)
                 {
-                    auto found = m_VolatileBufferStates.find(constnatBuffer);
-                    if (found == m_VolatileBufferStates.end())
-                    {
-                        std::stringstream ss;
-                        ss << "Binding volatile constant buffer " << utils::DebugNameToString(constnatBuffer->desc.debugName)
-                           << " before writing into it is invalid.";
-                        m_Context.error(ss.str());
+                    flushDescriptorSets(setIndex + 1);
 
-                        dynamicOffsets.push_back(0); // use zero offset just to use something
-                    }
-                    else
+                    const auto& writes = bindingSet->pushDescriptorWrites->writes;
+                    if (!writes.empty())
                     {
-                        uint32_t version = found->second.latestVersion;
-                        uint64_t offset = version * constnatBuffer->desc.byteSize;
-                        assert(offset < std::numeric_limits<uint32_t>::max());
-                        dynamicOffsets.push_back(uint32_t(offset));
+                        m_CurrentCmdBuf->cmdBuf.pushDescriptorSetKHR(bindPoint, pipelineLayout,
+                            setIndex, uint32_t(writes.size()), writes.data());
+                        m_Statistics.bindingSetBinds++;
+                        m_Statistics.descriptorCopies += uint32_t(writes.size());
                     }
                 }
+                else if (m_Context.descriptorBufferHeap)
+                    descriptorBufferOffsets.push_back(bindingSet->descriptorBufferOffset);
+                else
+                    descriptorSets.push_back(bindingSet->descriptorSet);
+
+                for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
+                {
+                    dynamicOffsets.push_back(getVolatileBufferOffset(constantBuffer));
+                }
 
                 if (desc->trackLiveness)
                     m_CurrentCmdBuf->referencedResources.push_back(bindingSetHandle);
@@ -899,15 +1286,60 @@ namespace nvrhi::vulkan
             else
             {
                 DescriptorTable* table = checked_cast<DescriptorTable*>(bindingSetHandle);
-                descriptorSets.push_back(table->descriptorSet);
+                if (m_Context.descriptorBufferHeap)
+                    descriptorBufferOffsets.push_back(table->descriptorBufferOffset);
+                else
+                    descriptorSets.push_back(table->descriptorSet);
             }
         }
 
-        if (!descriptorSets.empty())
+        flushDescriptorSets(0);
+
+        m_BoundVolatileBufferOffsets = dynamicOffsets;
+    }
+
+    void CommandList::bindVolatileBufferOffsets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings)
+    {
+        // Writing a volatile CB only moves it to a new version, i.e. changes its dynamic offset.
+        // The offsets can only be changed by binding the descriptor set again, so bind just the sets
+        // whose volatile CBs have been written since they were bound, and leave the other sets alone.
+        // The bindings are the same as in the last bindBindingSets call, so m_BoundVolatileBufferOffsets matches them.
+
+        uint32_t firstOffset = 0;
+
+        for (uint32_t setIndex = 0; setIndex < uint32_t(bindings.size()); setIndex++)
         {
-            m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
-                /* firstSet = */ 0, uint32_t(descriptorSets.size()), descriptorSets.data(),
-                uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+            IBindingSet* bindingSetHandle = bindings[setIndex];
+            if (!bindingSetHandle->getDesc())
+                continue;
+
+            BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
+            const auto& constantBuffers = bindingSet->volatileConstantBuffers;
+            if (constantBuffers.empty())
+                continue;
+
+            static_vector<uint32_t, c_MaxVolatileConstantBuffersPerLayout> dynamicOffsets;
+            bool offsetsChanged = false;
+
+            for (size_t index = 0; index < constantBuffers.size(); index++)
+            {
+                const uint32_t offset = getVolatileBufferOffset(constantBuffers[index]);
+                offsetsChanged = offsetsChanged || m_BoundVolatileBufferOffsets[firstOffset + index] != offset;
+                dynamicOffsets.push_back(offset);
+            }
+
+            if (offsetsChanged)
+            {
+                m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
+                    /* firstSet = */ setIndex, 1, &bindingSet->descriptorSet,
+                    uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+                m_Statistics.bindingSetBinds++;
+
+                for (size_t index = 0; index < dynamicOffsets.size(); index++)
+                    m_BoundVolatileBufferOffsets[firstOffset + index] = dynamicOffsets[index];
+            }
+
+            firstOffset += uint32_t(constantBuffers.size());
         }
     }
 
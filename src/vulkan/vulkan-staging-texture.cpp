@@ -135,7 +135,17 @@ namespace nvrhi::vulkan
         return StagingTextureHandle::Create(tex);
     }
 
-    void *Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    void *Device::mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch, true);
+    }
+
+    void *Device::tryMapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
+    {
+        return mapStagingTexture(tex, slice, cpuAccess, outRowPitch, false);
+    }
+
+    void *Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch, bool wait)
     {
         assert(slice.x == 0);
         assert(slice.y == 0);
@@ -157,7 +167,7 @@ namespace nvrhi::vulkan
 
         *outRowPitch = wInBlocks * formatInfo.bytesPerBlock;
 
-        return mapBuffer(tex->buffer, cpuAccess, region.offset, region.size);
+        return mapBuffer(tex->buffer, cpuAccess, region.offset, region.size, wait);
     }
 
     void Device::unmapStagingTexture(IStagingTexture* _tex)
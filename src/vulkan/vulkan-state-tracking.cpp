@@ -25,6 +25,19 @@
 
 namespace nvrhi::vulkan
 {
+
+    static void setResourceStatesForResolveTextures(ICommandList* commandList, IFramebuffer* framebuffer)
+    {
+        // Resolve attachments are written as color attachments inside the render pass
+        for (const auto& attachment : framebuffer->getDesc().colorAttachments)
+        {
+            if (attachment.storeOp == AttachmentStoreOp::Resolve && attachment.resolveTexture)
+            {
+                commandList->setTextureState(attachment.resolveTexture, attachment.resolveSubresources,
+                    ResourceStates::RenderTarget);
+            }
+        }
+    }
     
     void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
     {
@@ -101,12 +114,18 @@ namespace nvrhi::vulkan
         if (m_CurrentGraphicsState.framebuffer != state.framebuffer)
         {
             setResourceStatesForFramebuffer(state.framebuffer);
+            setResourceStatesForResolveTextures(this, state.framebuffer);
         }
 
         if (state.indirectParams && state.indirectParams != m_CurrentGraphicsState.indirectParams)
         {
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer)
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
     }
 
     void CommandList::trackResourcesAndBarriers(const MeshletState& state)
@@ -124,26 +143,50 @@ namespace nvrhi::vulkan
         if (m_CurrentMeshletState.framebuffer != state.framebuffer)
         {
             setResourceStatesForFramebuffer(state.framebuffer);
+            setResourceStatesForResolveTextures(this, state.framebuffer);
         }
 
         if (state.indirectParams && state.indirectParams != m_CurrentMeshletState.indirectParams)
         {
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentMeshletState.indirectCountBuffer)
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
     }
 
     void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
     {
+        if (m_Bundle)
+        {
+            m_Bundle->states.requireTextureState(_texture, subresources, state);
+            return;
+        }
+
         Texture* texture = checked_cast<Texture*>(_texture);
 
+        const size_t numBarriers = m_StateTracker.getTextureBarriers().size();
         m_StateTracker.requireTextureState(texture, subresources, state);
+        if (m_StateTracker.getTextureBarriers().size() == numBarriers)
+            m_Statistics.barriersElided++;
     }
 
     void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
     {
+        if (m_Bundle)
+        {
+            m_Bundle->states.requireBufferState(_buffer, state);
+            return;
+        }
+
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
+        const size_t numBarriers = m_StateTracker.getBufferBarriers().size();
         m_StateTracker.requireBufferState(buffer, state);
+        if (m_StateTracker.getBufferBarriers().size() == numBarriers)
+            m_Statistics.barriersElided++;
     }
 
     bool CommandList::anyBarriers() const
@@ -187,9 +230,9 @@ namespace nvrhi::vulkan
 
             vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
                 .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
+                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : barrier.numArraySlices)
                 .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
+                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : barrier.numMipLevels)
                 .setAspectMask(aspectMask);
 
             imageBarriers.push_back(vk::ImageMemoryBarrier()
@@ -251,11 +294,8 @@ namespace nvrhi::vulkan
         m_StateTracker.clearBarriers();
     }
 
-    void CommandList::commitBarriersInternal_synchronization2()
+    void CommandList::convertPendingBarriers2(std::vector<vk::ImageMemoryBarrier2>& imageBarriers, std::vector<vk::BufferMemoryBarrier2>& bufferBarriers)
     {
-        std::vector<vk::ImageMemoryBarrier2> imageBarriers;
-        std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
-
         for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
         {
             ResourceStateMapping2 before = convertResourceState2(barrier.stateBefore);
@@ -274,9 +314,9 @@ namespace nvrhi::vulkan
 
             vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
                 .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
+                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : barrier.numArraySlices)
                 .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
+                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : barrier.numMipLevels)
                 .setAspectMask(aspectMask);
 
             imageBarriers.push_back(vk::ImageMemoryBarrier2()
@@ -292,16 +332,6 @@ namespace nvrhi::vulkan
                 .setSubresourceRange(subresourceRange));
         }
 
-        if (!imageBarriers.empty())
-        {
-            vk::DependencyInfo dep_info;
-            dep_info.setImageMemoryBarriers(imageBarriers);
-
-            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
-        }
-
-        imageBarriers.clear();
-
         for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
         {
             ResourceStateMapping2 before = convertResourceState2(barrier.stateBefore);
@@ -320,6 +350,22 @@ namespace nvrhi::vulkan
                 .setOffset(0)
                 .setSize(buffer->desc.byteSize));
         }
+    }
+
+    void CommandList::commitBarriersInternal_synchronization2()
+    {
+        std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+        std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+
+        convertPendingBarriers2(imageBarriers, bufferBarriers);
+
+        if (!imageBarriers.empty())
+        {
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(imageBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+        }
 
         if (!bufferBarriers.empty())
         {
@@ -328,7 +374,6 @@ namespace nvrhi::vulkan
 
             m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
         }
-        bufferBarriers.clear();
 
         m_StateTracker.clearBarriers();
     }
@@ -338,6 +383,8 @@ namespace nvrhi::vulkan
         if (m_StateTracker.getBufferBarriers().empty() && m_StateTracker.getTextureBarriers().empty())
             return;
 
+        m_Statistics.barriersEmitted += uint32_t(m_StateTracker.getTextureBarriers().size() + m_StateTracker.getBufferBarriers().size());
+
         endRenderPass();
 
         if (m_Context.extensions.KHR_synchronization2)
@@ -350,6 +397,205 @@ namespace nvrhi::vulkan
         }
     }
 
+    bool CommandList::beginSplitBarriers(IResource* resource)
+    {
+        if (m_StateTracker.getBufferBarriers().empty() && m_StateTracker.getTextureBarriers().empty())
+            return false;
+
+        m_Statistics.barriersEmitted += uint32_t(m_StateTracker.getTextureBarriers().size() + m_StateTracker.getBufferBarriers().size());
+
+        endRenderPass();
+
+        if (!m_Context.extensions.KHR_synchronization2)
+        {
+            // Events with dependency info need synchronization2, complete the transition right away
+            commitBarriersInternal();
+            return false;
+        }
+
+        SplitBarrier splitBarrier;
+        splitBarrier.resource = resource;
+        convertPendingBarriers2(splitBarrier.imageBarriers, splitBarrier.bufferBarriers);
+        m_StateTracker.clearBarriers();
+
+        auto depInfo = vk::DependencyInfo()
+            .setImageMemoryBarriers(splitBarrier.imageBarriers)
+            .setBufferMemoryBarriers(splitBarrier.bufferBarriers);
+
+        splitBarrier.event = m_CurrentCmdBuf->acquireEvent();
+        if (!splitBarrier.event)
+        {
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(depInfo);
+            return false;
+        }
+
+        m_CurrentCmdBuf->cmdBuf.setEvent2(splitBarrier.event, depInfo);
+
+        m_SplitBarriers.push_back(std::move(splitBarrier));
+        return true;
+    }
+
+    void CommandList::endSplitBarriers(IResource* resource)
+    {
+        auto it = m_SplitBarriers.begin();
+        while (it != m_SplitBarriers.end())
+        {
+            if (resource == nullptr || it->resource == resource)
+            {
+                endRenderPass();
+
+                auto depInfo = vk::DependencyInfo()
+                    .setImageMemoryBarriers(it->imageBarriers)
+                    .setBufferMemoryBarriers(it->bufferBarriers);
+
+                m_CurrentCmdBuf->cmdBuf.waitEvents2(1, &it->event, &depInfo);
+                m_CurrentCmdBuf->cmdBuf.resetEvent2(it->event, vk::PipelineStageFlagBits2::eAllCommands);
+
+                it = m_SplitBarriers.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        commitBarriers();
+
+        m_StateTracker.requireTextureState(texture, subresources, stateBits);
+
+        // Referenced through the texture type, so that textures without trackLiveness are skipped
+        if (beginSplitBarriers(texture))
+            m_CurrentCmdBuf->referencedResources.push_back(texture);
+    }
+
+    void CommandList::endTextureStateTransition(ITexture* texture)
+    {
+        endSplitBarriers(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        commitBarriers();
+
+        m_StateTracker.requireBufferState(buffer, stateBits);
+
+        if (beginSplitBarriers(buffer))
+            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::endBufferStateTransition(IBuffer* buffer)
+    {
+        endSplitBarriers(buffer);
+    }
+
+    void CommandList::textureAliasingBarrier(ITexture* _texture)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        commitBarriers();
+        endRenderPass();
+
+        // The layout of an image is undefined after another resource has used its memory.
+        // Transition it from eUndefined into the layout of its tracked state, so that the tracking stays valid.
+        const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+
+        vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
+        if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
+        if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
+        if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
+
+        auto getTrackedState = [this, texture](ArraySlice arraySlice, MipLevel mipLevel)
+        {
+            ResourceStates state = m_StateTracker.getTextureSubresourceState(texture, arraySlice, mipLevel);
+
+            // Textures that have not been used in this command list yet start in their initial state
+            if (state == ResourceStates::Unknown && texture->desc.keepInitialState)
+                state = texture->stateInitialized ? texture->desc.initialState : ResourceStates::Common;
+
+            return state;
+        };
+
+        const ResourceStates firstState = getTrackedState(0, 0);
+        bool uniformState = true;
+        for (ArraySlice arraySlice = 0; arraySlice < texture->desc.arraySize && uniformState; arraySlice++)
+        {
+            for (MipLevel mipLevel = 0; mipLevel < texture->desc.mipLevels && uniformState; mipLevel++)
+                uniformState = getTrackedState(arraySlice, mipLevel) == firstState;
+        }
+
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+        auto addImageBarrier = [&imageBarriers, texture, aspectMask](ResourceStates state, vk::ImageSubresourceRange subresourceRange)
+        {
+            if (state == ResourceStates::Unknown)
+                return;
+
+            const ResourceStateMapping after = convertResourceState(state);
+
+            imageBarriers.push_back(vk::ImageMemoryBarrier()
+                .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+                .setDstAccessMask(after.accessMask)
+                .setOldLayout(vk::ImageLayout::eUndefined)
+                .setNewLayout(after.imageLayout)
+                .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                .setImage(texture->image)
+                .setSubresourceRange(subresourceRange.setAspectMask(aspectMask)));
+        };
+
+        if (uniformState)
+        {
+            addImageBarrier(firstState, vk::ImageSubresourceRange()
+                .setBaseArrayLayer(0)
+                .setLayerCount(texture->desc.arraySize)
+                .setBaseMipLevel(0)
+                .setLevelCount(texture->desc.mipLevels));
+        }
+        else
+        {
+            for (ArraySlice arraySlice = 0; arraySlice < texture->desc.arraySize; arraySlice++)
+            {
+                for (MipLevel mipLevel = 0; mipLevel < texture->desc.mipLevels; mipLevel++)
+                {
+                    addImageBarrier(getTrackedState(arraySlice, mipLevel), vk::ImageSubresourceRange()
+                        .setBaseArrayLayer(arraySlice)
+                        .setLayerCount(1)
+                        .setBaseMipLevel(mipLevel)
+                        .setLevelCount(1));
+                }
+            }
+        }
+
+        // Wait for all previous accesses to the memory, which may have been made through other resources
+        const auto memoryBarrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlags(), memoryBarrier, {}, imageBarriers);
+    }
+
+    void CommandList::bufferAliasingBarrier(IBuffer* buffer)
+    {
+        (void)buffer;
+
+        commitBarriers();
+        endRenderPass();
+
+        // Buffers have no layout, a memory dependency on all previous accesses to any memory is enough
+        const auto memoryBarrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlags(), memoryBarrier, {}, {});
+    }
+
     void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
@@ -368,7 +614,7 @@ namespace nvrhi::vulkan
     {
         Texture* texture = checked_cast<Texture*>(_texture);
 
-        m_StateTracker.requireTextureState(texture, subresources, stateBits);
+        requireTextureState(texture, subresources, stateBits);
 
         if (m_CurrentCmdBuf)
             m_CurrentCmdBuf->referencedResources.push_back(texture);
@@ -378,7 +624,7 @@ namespace nvrhi::vulkan
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.requireBufferState(buffer, stateBits);
+        requireBufferState(buffer, stateBits);
         
         if (m_CurrentCmdBuf)
             m_CurrentCmdBuf->referencedResources.push_back(buffer);
@@ -391,7 +637,7 @@ namespace nvrhi::vulkan
         if (as->dataBuffer)
         {
             Buffer* buffer = checked_cast<Buffer*>(as->dataBuffer.Get());
-            m_StateTracker.requireBufferState(buffer, stateBits);
+            requireBufferState(buffer, stateBits);
 
             if (m_CurrentCmdBuf)
                 m_CurrentCmdBuf->referencedResources.push_back(as);
@@ -451,4 +697,186 @@ namespace nvrhi::vulkan
         m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
     }
 
+    static void appendOwnershipTransferBarriers(std::vector<vk::ImageMemoryBarrier>& barriers, Texture* texture,
+        uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+    {
+        const TextureState& state = texture->ownerState;
+        const TextureDesc& desc = texture->desc;
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
+        if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
+        if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
+        if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
+
+        auto appendBarrier = [&](ResourceStates resourceState, uint32_t baseMip, uint32_t numMips, uint32_t baseSlice, uint32_t numSlices)
+        {
+            // The image keeps its layout, and images with unknown contents don't need to be transferred
+            const vk::ImageLayout layout = convertResourceState(resourceState).imageLayout;
+            if (resourceState == ResourceStates::Unknown || layout == vk::ImageLayout::eUndefined)
+                return;
+
+            barriers.push_back(vk::ImageMemoryBarrier()
+                .setOldLayout(layout)
+                .setNewLayout(layout)
+                .setSrcQueueFamilyIndex(srcQueueFamily)
+                .setDstQueueFamilyIndex(dstQueueFamily)
+                .setImage(texture->image)
+                .setSubresourceRange(vk::ImageSubresourceRange()
+                    .setBaseMipLevel(baseMip)
+                    .setLevelCount(numMips)
+                    .setBaseArrayLayer(baseSlice)
+                    .setLayerCount(numSlices)
+                    .setAspectMask(aspectMask)));
+        };
+
+        if (state.subresourceStates.empty())
+        {
+            appendBarrier(state.state, 0, desc.mipLevels, 0, desc.arraySize);
+            return;
+        }
+
+        for (uint32_t arraySlice = 0; arraySlice < desc.arraySize; arraySlice++)
+        {
+            for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+            {
+                appendBarrier(state.subresourceStates[mipLevel + arraySlice * desc.mipLevels], mipLevel, 1, arraySlice, 1);
+            }
+        }
+    }
+
+    TrackedCommandBufferPtr Device::transferQueueOwnership(Queue& dstQueue, ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        struct QueueTransfers
+        {
+            std::vector<vk::ImageMemoryBarrier> imageBarriers;
+            std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+            std::vector<Texture*> textures;
+            std::vector<Buffer*> buffers;
+        };
+        std::array<QueueTransfers, uint32_t(CommandQueue::Count)> transfers;
+        bool anyTransfers = false;
+
+        const CommandQueue dstQueueID = dstQueue.getQueueID();
+        const uint32_t dstQueueFamily = dstQueue.getQueueFamilyIndex();
+
+        auto needsTransfer = [this, dstQueueID, dstQueueFamily](CommandQueue ownerQueue)
+        {
+            return ownerQueue != CommandQueue::Count && ownerQueue != dstQueueID &&
+                m_Queues[uint32_t(ownerQueue)]->getQueueFamilyIndex() != dstQueueFamily;
+        };
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            const CommandListResourceStateTracker& stateTracker = checked_cast<CommandList*>(pCommandLists[i])->getStateTracker();
+
+            for (uint32_t index = 0; index < stateTracker.getNumTrackedTextures(); index++)
+            {
+                Texture* texture = static_cast<Texture*>(stateTracker.getTrackedTexture(index));
+
+                if (needsTransfer(texture->ownerQueue))
+                {
+                    QueueTransfers& queueTransfers = transfers[uint32_t(texture->ownerQueue)];
+                    appendOwnershipTransferBarriers(queueTransfers.imageBarriers, texture,
+                        m_Queues[uint32_t(texture->ownerQueue)]->getQueueFamilyIndex(), dstQueueFamily);
+                    queueTransfers.textures.push_back(texture);
+                    anyTransfers = true;
+                }
+
+                texture->ownerQueue = dstQueueID;
+                texture->ownerState = stateTracker.getTrackedTextureState(index);
+            }
+
+            for (uint32_t index = 0; index < stateTracker.getNumTrackedBuffers(); index++)
+            {
+                Buffer* buffer = static_cast<Buffer*>(stateTracker.getTrackedBuffer(index));
+
+                // Volatile buffers are only read by the GPU after CPU writes to a new version, nothing to preserve
+                if (buffer->desc.isVolatile)
+                    continue;
+
+                if (needsTransfer(buffer->ownerQueue))
+                {
+                    QueueTransfers& queueTransfers = transfers[uint32_t(buffer->ownerQueue)];
+                    queueTransfers.bufferBarriers.push_back(vk::BufferMemoryBarrier()
+                        .setSrcQueueFamilyIndex(m_Queues[uint32_t(buffer->ownerQueue)]->getQueueFamilyIndex())
+                        .setDstQueueFamilyIndex(dstQueueFamily)
+                        .setBuffer(buffer->buffer)
+                        .setOffset(0)
+                        .setSize(VK_WHOLE_SIZE));
+                    queueTransfers.buffers.push_back(buffer);
+                    anyTransfers = true;
+                }
+
+                buffer->ownerQueue = dstQueueID;
+            }
+        }
+
+        if (!anyTransfers)
+            return nullptr;
+
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+        TrackedCommandBufferPtr acquireCmdBuf = dstQueue.getOrCreateCommandBuffer();
+        if (!acquireCmdBuf)
+            return nullptr;
+        (void)acquireCmdBuf->cmdBuf.begin(&beginInfo);
+
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            QueueTransfers& queueTransfers = transfers[queueIndex];
+            if (queueTransfers.imageBarriers.empty() && queueTransfers.bufferBarriers.empty())
+                continue;
+
+            Queue& srcQueue = *m_Queues[queueIndex];
+
+            // The release half of the transfer makes the writes of the previous owner available,
+            // and executes after all work already submitted to that queue
+            for (auto& barrier : queueTransfers.imageBarriers)
+                barrier.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite).setDstAccessMask(vk::AccessFlags());
+            for (auto& barrier : queueTransfers.bufferBarriers)
+                barrier.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite).setDstAccessMask(vk::AccessFlags());
+
+            TrackedCommandBufferPtr releaseCmdBuf = srcQueue.getOrCreateCommandBuffer();
+            if (!releaseCmdBuf)
+                continue;
+
+            (void)releaseCmdBuf->cmdBuf.begin(&beginInfo);
+            releaseCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eBottomOfPipe,
+                vk::DependencyFlags(), {}, queueTransfers.bufferBarriers, queueTransfers.imageBarriers);
+            (void)releaseCmdBuf->cmdBuf.end();
+
+            // The typed overloads skip the resources without trackLiveness
+            for (Texture* texture : queueTransfers.textures)
+            {
+                releaseCmdBuf->referencedResources.push_back(texture);
+                acquireCmdBuf->referencedResources.push_back(texture);
+            }
+            for (Buffer* buffer : queueTransfers.buffers)
+            {
+                releaseCmdBuf->referencedResources.push_back(buffer);
+                acquireCmdBuf->referencedResources.push_back(buffer);
+            }
+
+            const uint64_t releaseID = srcQueue.submit(nullptr, 0, releaseCmdBuf);
+
+            // The acquire half must not start before the release completes
+            dstQueue.addWaitSemaphore(srcQueue.trackingSemaphore, releaseID);
+
+            for (auto& barrier : queueTransfers.imageBarriers)
+                barrier.setSrcAccessMask(vk::AccessFlags()).setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+            for (auto& barrier : queueTransfers.bufferBarriers)
+                barrier.setSrcAccessMask(vk::AccessFlags()).setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+            acquireCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands,
+                vk::DependencyFlags(), {}, queueTransfers.bufferBarriers, queueTransfers.imageBarriers);
+        }
+
+        (void)acquireCmdBuf->cmdBuf.end();
+
+        return acquireCmdBuf;
+    }
+
 } // namespace nvrhi::vulkan
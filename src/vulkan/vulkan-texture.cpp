@@ -21,6 +21,7 @@
 */
 
 #include <algorithm>
+#include <sstream>
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
@@ -102,6 +103,15 @@ namespace nvrhi::vulkan
     static vk::ImageUsageFlags pickImageUsage(const TextureDesc& d)
     {
         const FormatInfo& formatInfo = getFormatInfo(d.format);
+
+        if (d.isTransient)
+        {
+            // Transient images may only be used as attachments
+            if (formatInfo.hasDepth || formatInfo.hasStencil)
+                return vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+            else
+                return vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment;
+        }
         
         vk::ImageUsageFlags ret = vk::ImageUsageFlagBits::eTransferSrc |
                                   vk::ImageUsageFlagBits::eTransferDst;
@@ -212,6 +222,9 @@ namespace nvrhi::vulkan
         if (d.isTypeless)
             flags |= vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage;
 
+        if (d.isTiled)
+            flags |= vk::ImageCreateFlagBits::eSparseBinding | vk::ImageCreateFlagBits::eSparseResidency;
+
         return flags;
     }
 
@@ -253,34 +266,31 @@ namespace nvrhi::vulkan
             texture->imageInfo.setPNext(&texture->externalMemoryImageInfo);
     }
 
-    TextureSubresourceView& Texture::getSubresourceView(const TextureSubresourceSet& subresource, TextureDimension dimension,
-        Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype)
+    int Texture::getFastSubresourceViewIndex(const TextureSubresourceSet& subresources, TextureDimension dimension,
+        Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype) const
     {
-        // This function is called from createBindingSet etc. and therefore free-threaded.
-        // It modifies the subresourceViews map associated with the texture.
-        std::lock_guard lockGuard(m_Mutex);
+        if (dimension != desc.dimension || format != desc.format || uint32_t(usage) != 0)
+            return -1;
 
-        if (dimension == TextureDimension::Unknown)
-            dimension = desc.dimension;
+        const TextureSubresourceSet allSubresources = AllSubresources.resolve(desc, false);
+        if (subresources.baseArraySlice != allSubresources.baseArraySlice ||
+            subresources.numArraySlices != allSubresources.numArraySlices)
+            return -1;
 
-        if (format == Format::UNKNOWN)
-            format = desc.format;
+        const int viewTypeOffset = int(viewtype) * int(c_MaxFastSubresourceViewMips + 1);
 
-        // Only use VkImageViewUsageCreateInfo when the image is typeless, i.e. it was created
-        // with the MUTABLE_FORMAT and EXTENDED_USAGE bits.
-        if (!desc.isTypeless)
-            usage = vk::ImageUsageFlags(0);
+        if (subresources.baseMipLevel == 0 && subresources.numMipLevels == allSubresources.numMipLevels)
+            return viewTypeOffset;
 
-        auto cachekey = std::make_tuple(subresource, viewtype, dimension, format, usage);
-        auto iter = subresourceViews.find(cachekey);
-        if (iter != subresourceViews.end())
-        {
-            return iter->second;
-        }
+        if (subresources.numMipLevels == 1 && subresources.baseMipLevel < c_MaxFastSubresourceViewMips)
+            return viewTypeOffset + 1 + int(subresources.baseMipLevel);
 
-        auto iter_pair = subresourceViews.emplace(cachekey, *this);
-        auto& view = std::get<0>(iter_pair)->second;
+        return -1;
+    }
 
+    void Texture::createSubresourceView(TextureSubresourceView& view, const TextureSubresourceSet& subresource, TextureDimension dimension,
+        Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype)
+    {
         view.subresource = subresource;
 
         auto vkformat = nvrhi::vulkan::convertFormat(format);
@@ -319,6 +329,64 @@ namespace nvrhi::vulkan
 
         const std::string debugName = std::string("ImageView for: ") + utils::DebugNameToString(desc.debugName);
         m_Context.nameVKObject(VkImageView(view.view), vk::DebugReportObjectTypeEXT::eImageView, debugName.c_str());
+    }
+
+    TextureSubresourceView& Texture::getSubresourceView(const TextureSubresourceSet& subresource, TextureDimension dimension,
+        Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype)
+    {
+        // This function is called from createBindingSet etc. and therefore free-threaded.
+
+        if (dimension == TextureDimension::Unknown)
+            dimension = desc.dimension;
+
+        if (format == Format::UNKNOWN)
+            format = desc.format;
+
+        // Only use VkImageViewUsageCreateInfo when the image is typeless, i.e. it was created
+        // with the MUTABLE_FORMAT and EXTENDED_USAGE bits.
+        if (!desc.isTypeless)
+            usage = vk::ImageUsageFlags(0);
+
+        // The common views are kept in a flat array and published with a CAS. When two threads race to create
+        // the same view, the loser destroys its copy and returns the published one.
+        const int fastIndex = getFastSubresourceViewIndex(subresource, dimension, format, usage, viewtype);
+        if (fastIndex >= 0)
+        {
+            std::atomic<TextureSubresourceView*>& fastView = m_FastSubresourceViews[fastIndex];
+
+            TextureSubresourceView* existingView = fastView.load(std::memory_order_acquire);
+            if (existingView)
+                return *existingView;
+
+            TextureSubresourceView* newView = new TextureSubresourceView(*this);
+            createSubresourceView(*newView, subresource, dimension, format, usage, viewtype);
+
+            if (fastView.compare_exchange_strong(existingView, newView, std::memory_order_acq_rel, std::memory_order_acquire))
+                return *newView;
+
+            m_Context.device.destroyImageView(newView->view, m_Context.allocationCallbacks);
+            delete newView;
+            return *existingView;
+        }
+
+        // Everything else goes through the map, which is read-mostly once the app's views have been created.
+        // Map elements don't move on rehash, so the returned reference stays valid.
+        auto cachekey = std::make_tuple(subresource, viewtype, dimension, format, usage);
+
+        {
+            std::shared_lock lock(m_Mutex);
+            auto iter = subresourceViews.find(cachekey);
+            if (iter != subresourceViews.end())
+                return iter->second;
+        }
+
+        std::unique_lock lock(m_Mutex);
+
+        auto [iter, inserted] = subresourceViews.try_emplace(cachekey, *this);
+        auto& view = iter->second;
+
+        if (inserted)
+            createSubresourceView(view, subresource, dimension, format, usage, viewtype);
 
         return view;
     }
@@ -329,13 +397,36 @@ namespace nvrhi::vulkan
         assert(texture);
         fillTextureInfo(texture, desc);
 
+        if (desc.allowDirectWrite)
+        {
+            bool hostTransferSupported = false;
+#if NVRHI_VULKAN_WITH_HOST_IMAGE_COPY
+            if (m_Context.extensions.EXT_host_image_copy)
+            {
+                auto formatProperties3 = vk::FormatProperties3();
+                auto formatProperties2 = vk::FormatProperties2().setPNext(&formatProperties3);
+                m_Context.physicalDevice.getFormatProperties2(texture->imageInfo.format, &formatProperties2);
+
+                const vk::FormatFeatureFlags2 features = (texture->imageInfo.tiling == vk::ImageTiling::eOptimal)
+                    ? formatProperties3.optimalTilingFeatures
+                    : formatProperties3.linearTilingFeatures;
+
+                hostTransferSupported = (features & vk::FormatFeatureFlagBits2::eHostImageTransferEXT) != vk::FormatFeatureFlags2(0);
+            }
+
+            if (hostTransferSupported)
+                texture->imageInfo.usage |= vk::ImageUsageFlagBits::eHostTransferEXT;
+#endif
+            texture->desc.allowDirectWrite = hostTransferSupported;
+        }
+
         vk::Result res = m_Context.device.createImage(&texture->imageInfo, m_Context.allocationCallbacks, &texture->image);
         ASSERT_VK_OK(res);
         CHECK_VK_FAIL(res)
 
         m_Context.nameVKObject(texture->image, vk::DebugReportObjectTypeEXT::eImage, desc.debugName.c_str());
 
-        if (!desc.isVirtual)
+        if (!desc.isVirtual && !desc.isTiled)
         {
             res = m_Allocator.allocateTextureMemory(texture);
             ASSERT_VK_OK(res);
@@ -350,7 +441,8 @@ namespace nvrhi::vulkan
 #endif
             }
 
-            m_Context.nameVKObject(texture->memory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            if (!texture->memoryBlock)
+                m_Context.nameVKObject(texture->memory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
         }
 
         return TextureHandle::Create(texture);
@@ -387,6 +479,213 @@ namespace nvrhi::vulkan
         return true;
     }
 
+    void Device::getTextureTiling(ITexture* _texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        std::vector<vk::SparseImageMemoryRequirements> sparseRequirements = m_Context.device.getImageSparseMemoryRequirements(texture->image);
+        if (sparseRequirements.empty())
+            return;
+
+        const vk::SparseImageMemoryRequirements& requirements = sparseRequirements[0];
+        const vk::Extent3D& granularity = requirements.formatProperties.imageGranularity;
+        const bool singleMipTail = (requirements.formatProperties.flags & vk::SparseImageFormatFlagBits::eSingleMiptail) != vk::SparseImageFormatFlags(0);
+
+        vk::MemoryRequirements memoryRequirements;
+        m_Context.device.getImageMemoryRequirements(texture->image, &memoryRequirements);
+        const vk::DeviceSize tileSize = memoryRequirements.alignment;
+
+        const uint32_t numStandardMips = std::min(requirements.imageMipTailFirstLod, texture->desc.mipLevels);
+        const uint32_t numSubresourceTilings = subresourceTilingsNum ? std::min(*subresourceTilingsNum, numStandardMips) : 0;
+        
+        // Tiles are counted in the D3D12 order: the standard mips of each array slice followed by its packed mips
+        uint32_t numStandardTiles = 0;
+        for (uint32_t mipLevel = 0; mipLevel < numStandardMips; ++mipLevel)
+        {
+            const uint32_t widthInTiles = (std::max(texture->desc.width >> mipLevel, 1u) + granularity.width - 1) / granularity.width;
+            const uint32_t heightInTiles = (std::max(texture->desc.height >> mipLevel, 1u) + granularity.height - 1) / granularity.height;
+            const uint32_t depthInTiles = (std::max(texture->desc.depth >> mipLevel, 1u) + granularity.depth - 1) / granularity.depth;
+
+            if (mipLevel < numSubresourceTilings)
+            {
+                subresourceTilings[mipLevel].widthInTiles = widthInTiles;
+                subresourceTilings[mipLevel].heightInTiles = heightInTiles;
+                subresourceTilings[mipLevel].depthInTiles = depthInTiles;
+                subresourceTilings[mipLevel].startTileIndexInOverallResource = numStandardTiles;
+            }
+
+            numStandardTiles += widthInTiles * heightInTiles * depthInTiles;
+        }
+
+        const uint32_t numPackedTiles = numStandardMips < texture->desc.mipLevels ? uint32_t(requirements.imageMipTailSize / tileSize) : 0;
+        
+        if (numTiles)
+        {
+            *numTiles = singleMipTail
+                ? numStandardTiles * texture->desc.arraySize + numPackedTiles
+                : (numStandardTiles + numPackedTiles) * texture->desc.arraySize;
+        }
+
+        if (desc)
+        {
+            desc->numStandardMips = numStandardMips;
+            desc->numPackedMips = texture->desc.mipLevels - numStandardMips;
+            desc->numTilesForPackedMips = numPackedTiles;
+            desc->startTileIndexInOverallResource = numStandardTiles;
+        }
+
+        if (tileShape)
+        {
+            tileShape->widthInTexels = granularity.width;
+            tileShape->heightInTexels = granularity.height;
+            tileShape->depthInTexels = granularity.depth;
+        }
+
+        if (subresourceTilingsNum)
+            *subresourceTilingsNum = numSubresourceTilings;
+    }
+
+    void Device::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+        Queue* queue = m_Queues[uint32_t(executionQueue)].get();
+
+        if (!queue)
+            return;
+
+        if (!queue->supportsSparseBinding())
+        {
+            std::stringstream ss;
+            ss << "Cannot update the tile mappings of texture " << utils::DebugNameToString(texture->desc.debugName)
+                << ": the family of the execution queue doesn't support sparse binding";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        std::vector<vk::SparseImageMemoryRequirements> sparseRequirements = m_Context.device.getImageSparseMemoryRequirements(texture->image);
+        if (sparseRequirements.empty())
+            return;
+
+        const vk::SparseImageMemoryRequirements& requirements = sparseRequirements[0];
+        const vk::Extent3D& granularity = requirements.formatProperties.imageGranularity;
+        const bool singleMipTail = (requirements.formatProperties.flags & vk::SparseImageFormatFlagBits::eSingleMiptail) != vk::SparseImageFormatFlags(0);
+
+        vk::MemoryRequirements memoryRequirements;
+        m_Context.device.getImageMemoryRequirements(texture->image, &memoryRequirements);
+        const vk::DeviceSize tileSize = memoryRequirements.alignment;
+
+        std::vector<vk::SparseImageMemoryBind> imageBinds;
+        std::vector<vk::SparseMemoryBind> mipTailBinds;
+
+        for (uint32_t n = 0; n < numTileMappings; ++n)
+        {
+            const TextureTilesMapping& mapping = tileMappings[n];
+            const vk::DeviceMemory memory = mapping.heap ? checked_cast<Heap*>(mapping.heap)->memory : vk::DeviceMemory();
+
+            for (uint32_t i = 0; i < mapping.numTextureRegions; ++i)
+            {
+                const TiledTextureCoordinate& coordinate = mapping.tiledTextureCoordinates[i];
+                const TiledTextureRegion& region = mapping.tiledTextureRegions[i];
+                const vk::DeviceSize memoryOffset = memory ? mapping.byteOffsets[i] : 0;
+
+                if (coordinate.mipLevel >= requirements.imageMipTailFirstLod)
+                {
+                    // The packed mips are bound as a whole, as opaque memory
+                    const vk::DeviceSize resourceOffset = requirements.imageMipTailOffset
+                        + (singleMipTail ? 0 : coordinate.arrayLevel * requirements.imageMipTailStride);
+
+                    mipTailBinds.push_back(vk::SparseMemoryBind()
+                        .setResourceOffset(resourceOffset)
+                        .setSize(requirements.imageMipTailSize)
+                        .setMemory(memory)
+                        .setMemoryOffset(memoryOffset));
+                    continue;
+                }
+
+                const uint32_t mipWidth = std::max(texture->desc.width >> coordinate.mipLevel, 1u);
+                const uint32_t mipHeight = std::max(texture->desc.height >> coordinate.mipLevel, 1u);
+                const uint32_t mipDepth = std::max(texture->desc.depth >> coordinate.mipLevel, 1u);
+                const uint32_t widthInTiles = (mipWidth + granularity.width - 1) / granularity.width;
+                const uint32_t heightInTiles = (mipHeight + granularity.height - 1) / granularity.height;
+
+                const auto subresource = vk::ImageSubresource()
+                    .setAspectMask(requirements.formatProperties.aspectMask)
+                    .setMipLevel(coordinate.mipLevel)
+                    .setArrayLayer(coordinate.arrayLevel);
+
+                // Extents at the edges of the mip level are clamped to it, which is what Vulkan requires for partial tiles
+                auto addImageBind = [&](uint32_t x, uint32_t y, uint32_t z, uint32_t width, uint32_t height, uint32_t depth, vk::DeviceSize offset)
+                {
+                    const uint32_t texelX = x * granularity.width;
+                    const uint32_t texelY = y * granularity.height;
+                    const uint32_t texelZ = z * granularity.depth;
+
+                    imageBinds.push_back(vk::SparseImageMemoryBind()
+                        .setSubresource(subresource)
+                        .setOffset(vk::Offset3D(int32_t(texelX), int32_t(texelY), int32_t(texelZ)))
+                        .setExtent(vk::Extent3D(
+                            std::min(width * granularity.width, mipWidth - texelX),
+                            std::min(height * granularity.height, mipHeight - texelY),
+                            std::min(depth * granularity.depth, mipDepth - texelZ)))
+                        .setMemory(memory)
+                        .setMemoryOffset(offset));
+                };
+
+                if (region.width != 0 && region.height != 0 && region.depth != 0)
+                {
+                    addImageBind(coordinate.x, coordinate.y, coordinate.z, region.width, region.height, region.depth, memoryOffset);
+                }
+                else
+                {
+                    // Without a box, the region is a run of tiles in row-major order that may wrap to the following rows
+                    const uint32_t firstTile = coordinate.x + (coordinate.y + coordinate.z * heightInTiles) * widthInTiles;
+
+                    for (uint32_t tile = 0; tile < region.tilesNum; ++tile)
+                    {
+                        const uint32_t tileIndex = firstTile + tile;
+                        addImageBind(tileIndex % widthInTiles, (tileIndex / widthInTiles) % heightInTiles, tileIndex / (widthInTiles * heightInTiles),
+                            1, 1, 1, memory ? memoryOffset + tile * tileSize : 0);
+                    }
+                }
+            }
+        }
+
+        auto imageBindInfo = vk::SparseImageMemoryBindInfo()
+            .setImage(texture->image)
+            .setBindCount(uint32_t(imageBinds.size()))
+            .setPBinds(imageBinds.data());
+
+        auto mipTailBindInfo = vk::SparseImageOpaqueMemoryBindInfo()
+            .setImage(texture->image)
+            .setBindCount(uint32_t(mipTailBinds.size()))
+            .setPBinds(mipTailBinds.data());
+
+        auto bindSparseInfo = vk::BindSparseInfo();
+
+        if (!imageBinds.empty())
+            bindSparseInfo.setImageBindCount(1).setPImageBinds(&imageBindInfo);
+
+        if (!mipTailBinds.empty())
+            bindSparseInfo.setImageOpaqueBindCount(1).setPImageOpaqueBinds(&mipTailBindInfo);
+
+        queue->bindSparse(bindSparseInfo);
+    }
+
+    TextureHandle Device::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        (void)pairedTexture;
+        (void)desc;
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    void CommandList::decodeSamplerFeedbackTexture(ITexture* dest, ITexture* feedbackTexture)
+    {
+        (void)dest;
+        (void)feedbackTexture;
+        utils::NotSupported();
+    }
+
     void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice,
                                   ITexture* _src, const TextureSlice& srcSlice)
     {
@@ -467,6 +766,134 @@ namespace nvrhi::vulkan
             *depthOut = depth;
     }
 
+    bool Device::writeTextureDirect(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+#if NVRHI_VULKAN_WITH_HOST_IMAGE_COPY
+        Texture* dest = checked_cast<Texture*>(_dest);
+        const TextureDesc& desc = dest->desc;
+
+        if (!m_Context.extensions.EXT_host_image_copy || !desc.allowDirectWrite)
+            return false;
+
+        // Outside of command lists, the image layout is only known for textures that return to a fixed state
+        ResourceStates currentState = dest->permanentState;
+        if (currentState == ResourceStates::Unknown)
+        {
+            if (!desc.keepInitialState)
+                return false;
+
+            currentState = desc.initialState;
+        }
+
+        // The image contents can only be preserved across command lists in a defined layout
+        const vk::ImageLayout finalLayout = convertResourceState(currentState).imageLayout;
+        if (finalLayout == vk::ImageLayout::eUndefined)
+            return false;
+
+        // Layout transitions cover all aspects of the image, but a copy region must address a single aspect:
+        // the data is the depth plane of depth-stencil formats
+        const vk::ImageAspectFlags aspectMask = guessImageAspectFlags(dest->imageInfo.format);
+        const vk::ImageAspectFlags copyAspectMask = guessSubresourceImageAspectFlags(dest->imageInfo.format,
+            Texture::TextureSubresourceViewType::DepthOnly);
+
+        // GENERAL is always a valid layout for host copies
+        constexpr vk::ImageLayout copyLayout = vk::ImageLayout::eGeneral;
+
+        uint32_t mipWidth, mipHeight, mipDepth;
+        computeMipLevelInformation(desc, mipLevel, &mipWidth, &mipHeight, &mipDepth);
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        if (rowPitch % formatInfo.bytesPerBlock != 0 || (depthPitch != 0 && depthPitch % rowPitch != 0))
+            return false;
+
+        const uint32_t memoryRowLength = uint32_t(rowPitch / formatInfo.bytesPerBlock) * formatInfo.blockSize;
+        const uint32_t memoryImageHeight = depthPitch ? uint32_t(depthPitch / rowPitch) * formatInfo.blockSize : 0;
+
+        const auto subresourceRange = vk::ImageSubresourceRange()
+            .setAspectMask(aspectMask)
+            .setBaseMipLevel(mipLevel)
+            .setLevelCount(1)
+            .setBaseArrayLayer(arraySlice)
+            .setLayerCount(1);
+
+        // An image that hasn't been used yet is in the UNDEFINED layout, and command lists will expect
+        // all of its subresources in the initial state after this call - transition the whole image first.
+        // Transitions passed to one call must not overlap, so they are issued one by one.
+        const bool firstUse = dest->permanentState == ResourceStates::Unknown && !dest->stateInitialized;
+        if (firstUse)
+        {
+            const auto transition = vk::HostImageLayoutTransitionInfoEXT()
+                .setImage(dest->image)
+                .setOldLayout(vk::ImageLayout::eUndefined)
+                .setNewLayout(finalLayout)
+                .setSubresourceRange(vk::ImageSubresourceRange()
+                    .setAspectMask(aspectMask)
+                    .setBaseMipLevel(0)
+                    .setLevelCount(desc.mipLevels)
+                    .setBaseArrayLayer(0)
+                    .setLayerCount(dest->imageInfo.arrayLayers));
+
+            if (m_Context.device.transitionImageLayoutEXT(1, &transition) != vk::Result::eSuccess)
+                return false;
+
+            dest->stateInitialized = true;
+        }
+
+        if (finalLayout != copyLayout)
+        {
+            const auto transition = vk::HostImageLayoutTransitionInfoEXT()
+                .setImage(dest->image)
+                .setOldLayout(finalLayout)
+                .setNewLayout(copyLayout)
+                .setSubresourceRange(subresourceRange);
+
+            if (m_Context.device.transitionImageLayoutEXT(1, &transition) != vk::Result::eSuccess)
+                return false;
+        }
+
+        const auto region = vk::MemoryToImageCopyEXT()
+            .setPHostPointer(data)
+            .setMemoryRowLength(memoryRowLength)
+            .setMemoryImageHeight(memoryImageHeight)
+            .setImageSubresource(vk::ImageSubresourceLayers()
+                .setAspectMask(copyAspectMask)
+                .setMipLevel(mipLevel)
+                .setBaseArrayLayer(arraySlice)
+                .setLayerCount(1))
+            .setImageExtent(vk::Extent3D(mipWidth, mipHeight, mipDepth));
+
+        const auto copyInfo = vk::CopyMemoryToImageInfoEXT()
+            .setDstImage(dest->image)
+            .setDstImageLayout(copyLayout)
+            .setRegionCount(1)
+            .setPRegions(&region);
+
+        const vk::Result res = m_Context.device.copyMemoryToImageEXT(&copyInfo);
+
+        // Return the subresource to the layout that command lists expect, even if the copy failed
+        if (finalLayout != copyLayout)
+        {
+            const auto transition = vk::HostImageLayoutTransitionInfoEXT()
+                .setImage(dest->image)
+                .setOldLayout(copyLayout)
+                .setNewLayout(finalLayout)
+                .setSubresourceRange(subresourceRange);
+
+            (void)m_Context.device.transitionImageLayoutEXT(1, &transition);
+        }
+
+        return res == vk::Result::eSuccess;
+#else
+        (void)_dest;
+        (void)arraySlice;
+        (void)mipLevel;
+        (void)data;
+        (void)rowPitch;
+        (void)depthPitch;
+        return false;
+#endif
+    }
+
     void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
     {
         endRenderPass();
@@ -533,6 +960,103 @@ namespace nvrhi::vulkan
             1, &imageCopy);
     }
 
+    void CommandList::writeTexture(ITexture* _dest, const TextureSubresourceSet& subresources, const TextureSubresourceData* data, size_t numSubresources)
+    {
+        endRenderPass();
+
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        const TextureDesc& desc = dest->getDesc();
+
+        TextureSubresourceSet subresourceSet = subresources.resolve(desc, false);
+        if (numSubresources != size_t(subresourceSet.numArraySlices) * subresourceSet.numMipLevels)
+            // let the validation layer handle the messages
+            return;
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        // Region offsets must be multiples of the texel block size and of 4, which is not always a power of 2
+        const uint64_t regionAlignment = uint64_t(formatInfo.bytesPerBlock) * 4;
+
+        std::vector<vk::BufferImageCopy> imageCopies(numSubresources);
+        uint64_t totalSize = 0;
+
+        for (size_t index = 0; index < numSubresources; index++)
+        {
+            const MipLevel mipLevel = subresourceSet.baseMipLevel + MipLevel(index % subresourceSet.numMipLevels);
+            const ArraySlice arraySlice = subresourceSet.baseArraySlice + ArraySlice(index / subresourceSet.numMipLevels);
+
+            uint32_t mipWidth, mipHeight, mipDepth;
+            computeMipLevelInformation(desc, mipLevel, &mipWidth, &mipHeight, &mipDepth);
+
+            uint32_t deviceNumCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            uint32_t deviceNumRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            uint32_t deviceRowPitch = deviceNumCols * formatInfo.bytesPerBlock;
+
+            imageCopies[index] = vk::BufferImageCopy()
+                .setBufferOffset(totalSize)
+                .setBufferRowLength(deviceNumCols * formatInfo.blockSize)
+                .setBufferImageHeight(deviceNumRows * formatInfo.blockSize)
+                .setImageSubresource(vk::ImageSubresourceLayers()
+                    .setAspectMask(guessImageAspectFlags(dest->imageInfo.format))
+                    .setMipLevel(mipLevel)
+                    .setBaseArrayLayer(arraySlice)
+                    .setLayerCount(1))
+                .setImageExtent(vk::Extent3D().setWidth(mipWidth).setHeight(mipHeight).setDepth(mipDepth));
+
+            totalSize += uint64_t(deviceRowPitch) * deviceNumRows * mipDepth;
+            totalSize = (totalSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+        }
+
+        Buffer* uploadBuffer;
+        uint64_t uploadOffset;
+        void* uploadCpuVA;
+        m_UploadManager->suballocateBuffer(
+            totalSize,
+            &uploadBuffer,
+            &uploadOffset,
+            &uploadCpuVA,
+            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false));
+
+        for (size_t index = 0; index < numSubresources; index++)
+        {
+            const TextureSubresourceData& subresourceData = data[index];
+            vk::BufferImageCopy& imageCopy = imageCopies[index];
+
+            const uint32_t deviceNumRows = imageCopy.bufferImageHeight / formatInfo.blockSize;
+            const size_t deviceRowPitch = size_t(imageCopy.bufferRowLength / formatInfo.blockSize) * formatInfo.bytesPerBlock;
+            const size_t minRowPitch = std::min(deviceRowPitch, subresourceData.rowPitch);
+
+            uint8_t* mappedPtr = (uint8_t*)uploadCpuVA + imageCopy.bufferOffset;
+            for (uint32_t slice = 0; slice < imageCopy.imageExtent.depth; slice++)
+            {
+                const uint8_t* sourcePtr = (const uint8_t*)subresourceData.data + subresourceData.depthPitch * slice;
+                for (uint32_t row = 0; row < deviceNumRows; row++)
+                {
+                    memcpy(mappedPtr, sourcePtr, minRowPitch);
+                    mappedPtr += deviceRowPitch;
+                    sourcePtr += subresourceData.rowPitch;
+                }
+            }
+
+            imageCopy.bufferOffset += uploadOffset;
+        }
+
+        assert(m_CurrentCmdBuf);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, subresourceSet, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.push_back(dest);
+
+        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(uploadBuffer->buffer,
+            dest->image, vk::ImageLayout::eTransferDstOptimal,
+            uint32_t(imageCopies.size()), imageCopies.data());
+    }
+
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
     {
         endRenderPass();
@@ -726,6 +1250,16 @@ namespace nvrhi::vulkan
         }
         subresourceViews.clear();
 
+        for (std::atomic<TextureSubresourceView*>& fastView : m_FastSubresourceViews)
+        {
+            TextureSubresourceView* view = fastView.exchange(nullptr);
+            if (view)
+            {
+                m_Context.device.destroyImageView(view->view, m_Context.allocationCallbacks);
+                delete view;
+            }
+        }
+
         if (managed)
         {
             if (image)
@@ -790,7 +1324,10 @@ namespace nvrhi::vulkan
 
     SamplerHandle Device::createSampler(const SamplerDesc& desc)
     {
-        Sampler *sampler = new Sampler(m_Context);
+        if (SamplerHandle cachedSampler = m_SamplerCache.find(desc))
+            return cachedSampler;
+
+        Sampler *sampler = new Sampler(m_Context, m_SamplerCache);
 
         const bool anisotropyEnable = desc.maxAnisotropy > 1.0f;
 
@@ -823,8 +1360,12 @@ namespace nvrhi::vulkan
 
         const vk::Result res = m_Context.device.createSampler(&sampler->samplerInfo, m_Context.allocationCallbacks, &sampler->sampler);
         CHECK_VK_FAIL(res)
-        
-        return SamplerHandle::Create(sampler);
+
+        // The reduction info is a local, don't leave a dangling pointer in the stored create info
+        sampler->samplerInfo.setPNext(nullptr);
+
+        // Another thread could have created the same sampler in the meantime, then the cache returns that one
+        return m_SamplerCache.add(sampler);
     }
 
     Object Sampler::getNativeObject(ObjectType objectType)
@@ -840,6 +1381,7 @@ namespace nvrhi::vulkan
 
     Sampler::~Sampler() 
     { 
+        m_Cache.remove(this);
         m_Context.device.destroySampler(sampler);
     }
 
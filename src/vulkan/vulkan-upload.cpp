@@ -26,11 +26,11 @@
 namespace nvrhi::vulkan
 {
 
-    std::shared_ptr<BufferChunk> UploadManager::CreateChunk(uint64_t size)
+    std::shared_ptr<BufferChunk> createBufferChunk(Device* device, uint64_t size, bool isScratchBuffer)
     {
         std::shared_ptr<BufferChunk> chunk = std::make_shared<BufferChunk>();
 
-        if (m_IsScratchBuffer)
+        if (isScratchBuffer)
         {
             BufferDesc desc;
             desc.byteSize = size;
@@ -38,7 +38,7 @@ namespace nvrhi::vulkan
             desc.debugName = "ScratchBufferChunk";
             desc.canHaveUAVs = true;
 
-            chunk->buffer = m_Device->createBuffer(desc);
+            chunk->buffer = device->createBuffer(desc);
             chunk->mappedMemory = nullptr;
             chunk->bufferSize = size;
         }
@@ -50,17 +50,47 @@ namespace nvrhi::vulkan
             desc.debugName = "UploadChunk";
 
             // The upload manager buffers are used in buildTopLevelAccelStruct to store instance data, and SBT for shader entries
-            desc.isAccelStructBuildInput = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
-            desc.isShaderBindingTable = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
+            desc.isAccelStructBuildInput = device->queryFeatureSupport(Feature::RayTracingAccelStruct);
+            desc.isShaderBindingTable = device->queryFeatureSupport(Feature::RayTracingAccelStruct);
 
-            chunk->buffer = m_Device->createBuffer(desc);
-            chunk->mappedMemory = m_Device->mapBuffer(chunk->buffer, CpuAccessMode::Write);
+            chunk->buffer = device->createBuffer(desc);
+            chunk->mappedMemory = device->mapBuffer(chunk->buffer, CpuAccessMode::Write);
             chunk->bufferSize = size;
         }
 
         return chunk;
     }
 
+    UploadManager::~UploadManager()
+    {
+        if (m_SharedChunkPool)
+        {
+            // All chunks that are still owned by the command list have never been submitted
+            if (m_CurrentChunk)
+            {
+                m_ChunkPool.push_back(m_CurrentChunk);
+                m_CurrentChunk.reset();
+            }
+
+            returnUnsubmittedChunks(0);
+        }
+    }
+
+    void UploadManager::returnUnsubmittedChunks(uint64_t currentVersion)
+    {
+        // Chunks written by a recording that was never executed cannot be in use by the GPU
+        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); )
+        {
+            if ((*it)->version != currentVersion && !VersionGetSubmitted((*it)->version))
+            {
+                m_SharedChunkPool->returnPage(*it);
+                it = m_ChunkPool.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
     bool UploadManager::suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA,
         uint64_t currentVersion, uint32_t alignment)
     {
@@ -74,6 +104,7 @@ namespace nvrhi::vulkan
             if (endOfDataInChunk <= m_CurrentChunk->bufferSize)
             {
                 m_CurrentChunk->writePointer = endOfDataInChunk;
+                m_SuballocatedBytes += size;
 
                 *pBuffer = checked_cast<Buffer*>(m_CurrentChunk->buffer.Get());
                 *pOffset = alignedOffset;
@@ -87,6 +118,40 @@ namespace nvrhi::vulkan
             m_CurrentChunk.reset();
         }
 
+        if (m_SharedChunkPool)
+        {
+            // Upload chunks are recycled through the device-global pool, see UploadPagePool
+            if (chunkToRetire)
+            {
+                m_ChunkPool.push_back(chunkToRetire);
+            }
+
+            returnUnsubmittedChunks(currentVersion);
+
+            m_CurrentChunk = m_SharedChunkPool->acquirePage(size, m_DefaultChunkSize);
+            if (!m_CurrentChunk)
+                return false;
+        }
+        else if (!acquireOwnedChunk(size, currentVersion, chunkToRetire))
+        {
+            return false;
+        }
+
+        m_CurrentChunk->version = currentVersion;
+        m_CurrentChunk->writePointer = size;
+        m_SuballocatedBytes += size;
+        m_AcquiredChunks++;
+
+        *pBuffer = checked_cast<Buffer*>(m_CurrentChunk->buffer.Get());
+        *pOffset = 0;
+        if (pCpuVA)
+            *pCpuVA = m_CurrentChunk->mappedMemory;
+
+        return true;
+    }
+
+    bool UploadManager::acquireOwnedChunk(uint64_t size, uint64_t currentVersion, const std::shared_ptr<BufferChunk>& chunkToRetire)
+    {
         CommandQueue queue = VersionGetQueue(currentVersion);
         uint64_t completedInstance = m_Device->queueGetCompletedInstance(queue);
 
@@ -120,17 +185,9 @@ namespace nvrhi::vulkan
             if ((m_MemoryLimit > 0) && (m_AllocatedMemory + sizeToAllocate > m_MemoryLimit))
                 return false;
 
-            m_CurrentChunk = CreateChunk(sizeToAllocate);
+            m_CurrentChunk = createBufferChunk(m_Device, sizeToAllocate, m_IsScratchBuffer);
         }
 
-        m_CurrentChunk->version = currentVersion;
-        m_CurrentChunk->writePointer = size;
-
-        *pBuffer = checked_cast<Buffer*>(m_CurrentChunk->buffer.Get());
-        *pOffset = 0;
-        if (pCpuVA)
-            *pCpuVA = m_CurrentChunk->mappedMemory;
-
         return true;
     }
 
@@ -142,6 +199,27 @@ namespace nvrhi::vulkan
             m_CurrentChunk.reset();
         }
 
+        if (m_SharedChunkPool)
+        {
+            // Hand the chunks of this instance over to the pool, which recycles them when the instance has finished executing
+            std::vector<std::shared_ptr<BufferChunk>> submittedChunks;
+            for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); )
+            {
+                if ((*it)->version == currentVersion)
+                {
+                    (*it)->version = submittedVersion;
+                    submittedChunks.push_back(*it);
+                    it = m_ChunkPool.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            m_SharedChunkPool->submitPages(submittedChunks);
+            returnUnsubmittedChunks(currentVersion);
+            return;
+        }
+
         for (const auto& chunk : m_ChunkPool)
         {
             if (chunk->version == currentVersion)
@@ -0,0 +1,592 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <nvrhi/utils.h>
+#include <nvrhi/validation.h>
+#if NVRHI_WITH_CAPTURE
+#include <nvrhi/capture.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct BenchmarkOptions
+{
+    std::vector<std::string> apis;
+    std::string filter;
+    fs::path shaderPath;
+    uint32_t maxThreads = 0;
+    uint32_t iterations = 10000;
+    bool validation = false;
+    fs::path capturePath;
+};
+
+class MessageCallback : public nvrhi::IMessageCallback
+{
+public:
+    void message(nvrhi::MessageSeverity severity, const char* messageText) override
+    {
+        if (severity == nvrhi::MessageSeverity::Info)
+            return;
+
+        fprintf(stderr, "%s\n", messageText);
+    }
+};
+
+static MessageCallback g_MessageCallback;
+
+static void printUsage()
+{
+    printf("Usage: nvrhi-benchmark [options] [filter]\n"
+        "  --api <d3d11|d3d12|vulkan|null>\n"
+        "                              Run on the given API only, can be repeated (default: all compiled APIs)\n"
+        "  --threads <N>               Maximum number of recording threads (default: hardware concurrency)\n"
+        "  --iterations <N>            Operations recorded per thread (default: 10000)\n"
+        "  --shaders <path>            Directory with the compiled benchmark shaders\n"
+        "  --validation                Wrap the device into the NVRHI validation layer\n"
+#if NVRHI_WITH_CAPTURE
+        "  --capture <file>            Capture all executed command lists into a file for nvrhi-replay,\n"
+        "                              use with a small iteration count\n"
+#endif
+        "  filter                      Only run benchmarks whose name contains this string\n");
+}
+
+static bool parseCommandLine(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "--api") && hasValue)
+            options.apis.push_back(argv[++i]);
+        else if (!strcmp(arg, "--threads") && hasValue)
+            options.maxThreads = uint32_t(std::max(1, atoi(argv[++i])));
+        else if (!strcmp(arg, "--iterations") && hasValue)
+            options.iterations = uint32_t(std::max(1, atoi(argv[++i])));
+        else if (!strcmp(arg, "--shaders") && hasValue)
+            options.shaderPath = argv[++i];
+        else if (!strcmp(arg, "--validation"))
+            options.validation = true;
+#if NVRHI_WITH_CAPTURE
+        else if (!strcmp(arg, "--capture") && hasValue)
+            options.capturePath = argv[++i];
+#endif
+        else if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+            return false;
+        else if (arg[0] != '-' && options.filter.empty())
+            options.filter = arg;
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options.maxThreads == 0)
+        options.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (options.apis.empty())
+    {
+#if NVRHI_WITH_DX11
+        options.apis.push_back("d3d11");
+#endif
+#if NVRHI_WITH_DX12
+        options.apis.push_back("d3d12");
+#endif
+#if NVRHI_WITH_VULKAN
+        options.apis.push_back("vulkan");
+#endif
+#if NVRHI_WITH_NULL
+        options.apis.push_back("null");
+#endif
+    }
+
+    if (options.shaderPath.empty())
+        options.shaderPath = fs::path(argv[0]).parent_path() / "shaders";
+
+    return true;
+}
+
+static std::vector<char> readFile(const fs::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return {};
+
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static const char* getShaderExtension(nvrhi::GraphicsAPI api)
+{
+    switch (api)
+    {
+    case nvrhi::GraphicsAPI::D3D11: return "dxbc";
+    case nvrhi::GraphicsAPI::D3D12: return "dxil";
+    case nvrhi::GraphicsAPI::VULKAN: return "spirv";
+    default: return "";
+    }
+}
+
+// Runs 'record' on 'threadCount' threads at once, each on its own command list, and returns
+// the wall-clock time between releasing the threads and the last one finishing.
+// Submission and GPU execution are not included in the measurement.
+static double runThreads(nvrhi::IDevice* device, uint32_t threadCount, const std::function<void(nvrhi::ICommandList*, uint32_t)>& record)
+{
+    std::vector<nvrhi::CommandListHandle> commandLists;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        commandLists.push_back(device->createCommandList(nvrhi::CommandListParameters()
+            .setEnableImmediateExecution(false)));
+    }
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    bool started = false;
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            {
+                std::unique_lock lock(mutex);
+                startCondition.wait(lock, [&started]() { return started; });
+            }
+
+            nvrhi::ICommandList* commandList = commandLists[i];
+            commandList->open();
+            record(commandList, i);
+            commandList->close();
+        });
+    }
+
+    // Give the threads a chance to reach the gate before starting the clock
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    {
+        std::lock_guard lockGuard(mutex);
+        started = true;
+    }
+    startCondition.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    const auto endTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<nvrhi::ICommandList*> rawCommandLists;
+    for (const auto& commandList : commandLists)
+        rawCommandLists.push_back(commandList);
+
+    device->executeCommandLists(rawCommandLists.data(), rawCommandLists.size());
+    device->waitForIdle();
+    device->runGarbageCollection();
+
+    return std::chrono::duration<double>(endTime - startTime).count();
+}
+
+static void printResult(const char* apiName, const char* benchmarkName, uint32_t threadCount, uint64_t operations, double seconds)
+{
+    const double nsPerOp = seconds * 1e9 / double(operations);
+    const double opsPerSecond = double(operations) / seconds;
+
+    printf("%-8s %-14s threads=%-3u %10.1f ns/op %14.0f ops/s\n", apiName, benchmarkName, threadCount, nsPerOp, opsPerSecond);
+    fflush(stdout);
+}
+
+class BenchmarkScene
+{
+public:
+    nvrhi::TextureHandle renderTarget;
+    nvrhi::FramebufferHandle framebuffer;
+    nvrhi::TextureHandle texture;
+    nvrhi::SamplerHandle sampler;
+    nvrhi::BufferHandle staticConstantBuffer;
+    nvrhi::BufferHandle volatileConstantBuffer;
+    nvrhi::BindingLayoutHandle bindingLayout;
+    nvrhi::BindingLayoutHandle volatileBindingLayout;
+    std::vector<nvrhi::BindingSetHandle> bindingSets;
+    nvrhi::GraphicsPipelineHandle pipeline;
+
+    bool init(nvrhi::IDevice* device, const fs::path& shaderPath, bool placeholderShaders)
+    {
+        renderTarget = device->createTexture(nvrhi::TextureDesc()
+            .setDimension(nvrhi::TextureDimension::Texture2D)
+            .setWidth(256)
+            .setHeight(256)
+            .setFormat(nvrhi::Format::RGBA8_UNORM)
+            .setIsRenderTarget(true)
+            .setInitialState(nvrhi::ResourceStates::RenderTarget)
+            .setKeepInitialState(true)
+            .setDebugName("BenchmarkRenderTarget"));
+
+        texture = device->createTexture(nvrhi::TextureDesc()
+            .setDimension(nvrhi::TextureDimension::Texture2D)
+            .setWidth(64)
+            .setHeight(64)
+            .setFormat(nvrhi::Format::RGBA8_UNORM)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("BenchmarkTexture"));
+
+        sampler = device->createSampler(nvrhi::SamplerDesc());
+
+        staticConstantBuffer = device->createBuffer(nvrhi::utils::CreateStaticConstantBufferDesc(256, "BenchmarkStaticCB")
+            .setInitialState(nvrhi::ResourceStates::ConstantBuffer)
+            .setKeepInitialState(true));
+
+        volatileConstantBuffer = device->createBuffer(nvrhi::utils::CreateVolatileConstantBufferDesc(256, "BenchmarkVolatileCB", 4096));
+
+        if (!renderTarget || !texture || !sampler || !staticConstantBuffer || !volatileConstantBuffer)
+            return false;
+
+        framebuffer = device->createFramebuffer(nvrhi::FramebufferDesc().addColorAttachment(renderTarget));
+
+        bindingLayout = device->createBindingLayout(nvrhi::BindingLayoutDesc()
+            .setVisibility(nvrhi::ShaderType::All)
+            .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(0))
+            .addItem(nvrhi::BindingLayoutItem::Texture_SRV(0))
+            .addItem(nvrhi::BindingLayoutItem::Sampler(0)));
+
+        volatileBindingLayout = device->createBindingLayout(nvrhi::BindingLayoutDesc()
+            .setVisibility(nvrhi::ShaderType::All)
+            .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(0)));
+
+        if (!framebuffer || !bindingLayout || !volatileBindingLayout)
+            return false;
+
+        // Several distinct binding sets so that the draw loop actually changes state between draws
+        for (int i = 0; i < 8; i++)
+        {
+            nvrhi::BindingSetHandle bindingSet = device->createBindingSet(createBindingSetDesc(), bindingLayout);
+            if (!bindingSet)
+                return false;
+
+            bindingSets.push_back(bindingSet);
+        }
+
+        createPipeline(device, shaderPath, placeholderShaders);
+
+        return true;
+    }
+
+    nvrhi::BindingSetDesc createBindingSetDesc() const
+    {
+        return nvrhi::BindingSetDesc()
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(0, staticConstantBuffer))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(0, texture))
+            .addItem(nvrhi::BindingSetItem::Sampler(0, sampler));
+    }
+
+private:
+    void createPipeline(nvrhi::IDevice* device, const fs::path& shaderPath, bool placeholderShaders)
+    {
+        const char* extension = getShaderExtension(device->getGraphicsAPI());
+        const fs::path vsPath = shaderPath / (std::string("benchmark_vs.") + extension);
+        const fs::path psPath = shaderPath / (std::string("benchmark_ps.") + extension);
+
+        std::vector<char> vsBinary = readFile(vsPath);
+        std::vector<char> psBinary = readFile(psPath);
+
+        if ((vsBinary.empty() || psBinary.empty()) && placeholderShaders)
+        {
+            // The device only stores the bytes, any non-empty binary will do
+            vsBinary.assign(4, 0);
+            psBinary.assign(4, 0);
+        }
+
+        if (vsBinary.empty() || psBinary.empty())
+        {
+            fprintf(stderr, "Cannot load '%s' or '%s', the draw benchmark will be skipped.\n",
+                vsPath.generic_string().c_str(), psPath.generic_string().c_str());
+            return;
+        }
+
+        nvrhi::ShaderDesc vsDesc(nvrhi::ShaderType::Vertex);
+        vsDesc.entryName = "main_vs";
+        nvrhi::ShaderHandle vertexShader = device->createShader(vsDesc, vsBinary.data(), vsBinary.size());
+
+        nvrhi::ShaderDesc psDesc(nvrhi::ShaderType::Pixel);
+        psDesc.entryName = "main_ps";
+        nvrhi::ShaderHandle pixelShader = device->createShader(psDesc, psBinary.data(), psBinary.size());
+
+        if (!vertexShader || !pixelShader)
+            return;
+
+        nvrhi::RenderState renderState;
+        renderState.rasterState.setCullNone();
+        renderState.depthStencilState.setDepthTestEnable(false);
+
+        nvrhi::GraphicsPipelineDesc pipelineDesc;
+        pipelineDesc.VS = vertexShader;
+        pipelineDesc.PS = pixelShader;
+        pipelineDesc.setPrimType(nvrhi::PrimitiveType::TriangleList)
+            .setRenderState(renderState)
+            .addBindingLayout(bindingLayout);
+
+        pipeline = device->createGraphicsPipeline(pipelineDesc, framebuffer);
+    }
+};
+
+static void runBenchmarks(const char* apiName, nvrhi::IDevice* device, const BenchmarkOptions& options, bool placeholderShaders)
+{
+    BenchmarkScene scene;
+    if (!scene.init(device, options.shaderPath, placeholderShaders))
+    {
+        fprintf(stderr, "Failed to create the benchmark resources on %s.\n", apiName);
+        return;
+    }
+
+    const uint32_t iterations = options.iterations;
+
+    auto isEnabled = [&options](const char* name)
+    {
+        return options.filter.empty() || strstr(name, options.filter.c_str()) != nullptr;
+    };
+
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threads = 1; threads < options.maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(options.maxThreads);
+
+    if (isEnabled("draw") && scene.pipeline)
+    {
+        nvrhi::ViewportState viewportState;
+        viewportState.addViewportAndScissorRect(nvrhi::Viewport(256.f, 256.f));
+
+        for (uint32_t threads : threadCounts)
+        {
+            const double seconds = runThreads(device, threads, [&](nvrhi::ICommandList* commandList, uint32_t)
+            {
+                for (uint32_t i = 0; i < iterations; i++)
+                {
+                    nvrhi::GraphicsState state;
+                    state.setPipeline(scene.pipeline)
+                        .setFramebuffer(scene.framebuffer)
+                        .setViewport(viewportState)
+                        .addBindingSet(scene.bindingSets[i % scene.bindingSets.size()]);
+
+                    commandList->setGraphicsState(state);
+                    commandList->draw(nvrhi::DrawArguments().setVertexCount(3));
+                }
+            });
+
+            printResult(apiName, "draw", threads, uint64_t(threads) * iterations, seconds);
+        }
+    }
+
+    if (isEnabled("binding-sets"))
+    {
+        // Binding set creation is a device operation, the command lists stay empty
+        const uint32_t setsPerThread = std::max(1u, iterations / 10);
+
+        for (uint32_t threads : threadCounts)
+        {
+            std::vector<std::vector<nvrhi::BindingSetHandle>> createdSets(threads);
+
+            const double seconds = runThreads(device, threads, [&](nvrhi::ICommandList*, uint32_t threadIndex)
+            {
+                const nvrhi::BindingSetDesc desc = scene.createBindingSetDesc();
+                auto& sets = createdSets[threadIndex];
+                sets.reserve(setsPerThread);
+
+                for (uint32_t i = 0; i < setsPerThread; i++)
+                    sets.push_back(device->createBindingSet(desc, scene.bindingLayout));
+            });
+
+            printResult(apiName, "binding-sets", threads, uint64_t(threads) * setsPerThread, seconds);
+        }
+    }
+
+    if (isEnabled("volatile-cb"))
+    {
+        uint8_t constants[256] = {};
+
+        for (uint32_t threads : threadCounts)
+        {
+            const double seconds = runThreads(device, threads, [&](nvrhi::ICommandList* commandList, uint32_t)
+            {
+                for (uint32_t i = 0; i < iterations; i++)
+                    commandList->writeBuffer(scene.volatileConstantBuffer, constants, sizeof(constants));
+            });
+
+            printResult(apiName, "volatile-cb", threads, uint64_t(threads) * iterations, seconds);
+        }
+    }
+
+    if (isEnabled("barriers"))
+    {
+        std::vector<nvrhi::TextureHandle> textures;
+        for (uint32_t i = 0; i < options.maxThreads; i++)
+        {
+            textures.push_back(device->createTexture(nvrhi::TextureDesc()
+                .setDimension(nvrhi::TextureDimension::Texture2D)
+                .setWidth(64)
+                .setHeight(64)
+                .setFormat(nvrhi::Format::RGBA8_UNORM)
+                .setIsRenderTarget(true)
+                .setInitialState(nvrhi::ResourceStates::ShaderResource)
+                .setKeepInitialState(true)
+                .setDebugName("BenchmarkBarrierTexture")));
+        }
+
+        for (uint32_t threads : threadCounts)
+        {
+            const double seconds = runThreads(device, threads, [&](nvrhi::ICommandList* commandList, uint32_t threadIndex)
+            {
+                nvrhi::ITexture* texture = textures[threadIndex];
+
+                for (uint32_t i = 0; i < iterations; i++)
+                {
+                    const nvrhi::ResourceStates state = (i & 1) ? nvrhi::ResourceStates::ShaderResource : nvrhi::ResourceStates::RenderTarget;
+                    commandList->setTextureState(texture, nvrhi::AllSubresources, state);
+                    commandList->commitBarriers();
+                }
+            });
+
+            printResult(apiName, "barriers", threads, uint64_t(threads) * iterations, seconds);
+        }
+    }
+
+    if (isEnabled("execute"))
+    {
+        // Submission happens on one thread, measure the cost of executeCommandLists for growing batches
+        const uint32_t submits = std::max(1u, iterations / 100);
+
+        for (uint32_t batchSize : threadCounts)
+        {
+            std::vector<nvrhi::CommandListHandle> commandLists;
+            std::vector<nvrhi::ICommandList*> rawCommandLists;
+            for (uint32_t i = 0; i < batchSize; i++)
+            {
+                commandLists.push_back(device->createCommandList(nvrhi::CommandListParameters()
+                    .setEnableImmediateExecution(false)));
+                rawCommandLists.push_back(commandLists.back());
+            }
+
+            double seconds = 0.0;
+            for (uint32_t i = 0; i < submits; i++)
+            {
+                for (const auto& commandList : commandLists)
+                {
+                    commandList->open();
+                    commandList->close();
+                }
+
+                const auto startTime = std::chrono::high_resolution_clock::now();
+                device->executeCommandLists(rawCommandLists.data(), rawCommandLists.size());
+                seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+                device->waitForIdle();
+            }
+
+            device->runGarbageCollection();
+
+            printResult(apiName, "execute", batchSize, uint64_t(submits) * batchSize, seconds);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    int result = 0;
+
+    for (const std::string& api : options.apis)
+    {
+        std::unique_ptr<HeadlessDevice> headless = createHeadlessDevice(api, &g_MessageCallback);
+        if (!headless)
+        {
+            result = 1;
+            continue;
+        }
+
+        printf("%s: %s\n", api.c_str(), headless->getAdapterName());
+
+        nvrhi::DeviceHandle device = headless->getDevice();
+        if (options.validation)
+            device = nvrhi::validation::createValidationLayer(device);
+
+#if NVRHI_WITH_CAPTURE
+        nvrhi::capture::CaptureDeviceHandle captureDevice;
+        if (!options.capturePath.empty())
+        {
+            captureDevice = nvrhi::capture::createCaptureLayer(device);
+            captureDevice->beginCapture();
+            device = captureDevice;
+        }
+#endif
+
+        runBenchmarks(api.c_str(), device, options, headless->acceptsPlaceholderShaders());
+
+        device->waitForIdle();
+
+#if NVRHI_WITH_CAPTURE
+        if (captureDevice)
+        {
+            // With multiple APIs, each capture goes into its own file
+            fs::path capturePath = options.capturePath;
+            if (options.apis.size() > 1)
+                capturePath.replace_filename(capturePath.stem().string() + "-" + api + capturePath.extension().string());
+
+            std::vector<uint8_t> captureData;
+            captureDevice->endCapture(captureData);
+
+            std::ofstream file(capturePath, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(captureData.data()), std::streamsize(captureData.size()));
+            if (!file)
+            {
+                fprintf(stderr, "Failed to write the capture to '%s'.\n", capturePath.string().c_str());
+                result = 1;
+            }
+            else
+                printf("%s: wrote a %zu byte capture to '%s'\n", api.c_str(), captureData.size(), capturePath.string().c_str());
+        }
+#endif
+    }
+
+    return result;
+}
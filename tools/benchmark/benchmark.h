@@ -0,0 +1,59 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <memory>
+#include <string>
+
+// A device created without a window or swap chain, owning the native API objects behind the NVRHI device
+class HeadlessDevice
+{
+public:
+    virtual ~HeadlessDevice() = default;
+    virtual nvrhi::IDevice* getDevice() const = 0;
+    virtual const char* getAdapterName() const = 0;
+
+    // True if the device doesn't parse shader binaries, so the draw benchmark can run without the compiled shaders
+    virtual bool acceptsPlaceholderShaders() const { return false; }
+};
+
+// Creates a device for an API named on the command line: d3d11, d3d12, vulkan or null.
+// Prints an error and returns nullptr if the API is not compiled in or the device cannot be created.
+std::unique_ptr<HeadlessDevice> createHeadlessDevice(const std::string& api, nvrhi::IMessageCallback* messageCallback);
+
+#if NVRHI_WITH_DX11
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceD3D11(nvrhi::IMessageCallback* messageCallback);
+#endif
+
+#if NVRHI_WITH_DX12
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceD3D12(nvrhi::IMessageCallback* messageCallback);
+#endif
+
+#if NVRHI_WITH_VULKAN
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceVulkan(nvrhi::IMessageCallback* messageCallback);
+#endif
+
+#if NVRHI_WITH_NULL
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceNull(nvrhi::IMessageCallback* messageCallback);
+#endif
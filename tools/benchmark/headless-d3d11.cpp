@@ -0,0 +1,82 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <nvrhi/d3d11.h>
+#include <d3d11.h>
+#include <dxgi.h>
+#include <string>
+
+class HeadlessDeviceD3D11 : public HeadlessDevice
+{
+public:
+    nvrhi::RefCountPtr<ID3D11Device> d3dDevice;
+    nvrhi::RefCountPtr<ID3D11DeviceContext> immediateContext;
+    nvrhi::DeviceHandle device;
+    std::string adapterName;
+
+    ~HeadlessDeviceD3D11() override
+    {
+        // The NVRHI device holds references to the context, release it first
+        device = nullptr;
+    }
+
+    nvrhi::IDevice* getDevice() const override { return device; }
+    const char* getAdapterName() const override { return adapterName.c_str(); }
+};
+
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceD3D11(nvrhi::IMessageCallback* messageCallback)
+{
+    auto headless = std::make_unique<HeadlessDeviceD3D11>();
+
+    const D3D_FEATURE_LEVEL featureLevels[] = { D3D_FEATURE_LEVEL_11_1, D3D_FEATURE_LEVEL_11_0 };
+
+    HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0,
+        featureLevels, UINT(std::size(featureLevels)), D3D11_SDK_VERSION,
+        &headless->d3dDevice, nullptr, &headless->immediateContext);
+
+    if (FAILED(hr))
+        return nullptr;
+
+    nvrhi::RefCountPtr<IDXGIDevice> dxgiDevice;
+    nvrhi::RefCountPtr<IDXGIAdapter> dxgiAdapter;
+    DXGI_ADAPTER_DESC adapterDesc{};
+    if (SUCCEEDED(headless->d3dDevice->QueryInterface(IID_PPV_ARGS(&dxgiDevice)))
+        && SUCCEEDED(dxgiDevice->GetAdapter(&dxgiAdapter))
+        && SUCCEEDED(dxgiAdapter->GetDesc(&adapterDesc)))
+    {
+        char name[128];
+        WideCharToMultiByte(CP_UTF8, 0, adapterDesc.Description, -1, name, sizeof(name), nullptr, nullptr);
+        headless->adapterName = name;
+    }
+
+    nvrhi::d3d11::DeviceDesc deviceDesc;
+    deviceDesc.messageCallback = messageCallback;
+    deviceDesc.context = headless->immediateContext;
+
+    headless->device = nvrhi::d3d11::createDevice(deviceDesc);
+    if (!headless->device)
+        return nullptr;
+
+    return headless;
+}
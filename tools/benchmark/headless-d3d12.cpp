@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <nvrhi/d3d12.h>
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#include <string>
+
+class HeadlessDeviceD3D12 : public HeadlessDevice
+{
+public:
+    nvrhi::RefCountPtr<ID3D12Device> d3dDevice;
+    nvrhi::RefCountPtr<ID3D12CommandQueue> graphicsQueue;
+    nvrhi::RefCountPtr<ID3D12CommandQueue> computeQueue;
+    nvrhi::RefCountPtr<ID3D12CommandQueue> copyQueue;
+    nvrhi::DeviceHandle device;
+    std::string adapterName;
+
+    ~HeadlessDeviceD3D12() override
+    {
+        if (device)
+            device->waitForIdle();
+
+        device = nullptr;
+    }
+
+    nvrhi::IDevice* getDevice() const override { return device; }
+    const char* getAdapterName() const override { return adapterName.c_str(); }
+};
+
+static bool createQueue(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type, nvrhi::RefCountPtr<ID3D12CommandQueue>& outQueue)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc{};
+    queueDesc.Type = type;
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    return SUCCEEDED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&outQueue)));
+}
+
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceD3D12(nvrhi::IMessageCallback* messageCallback)
+{
+    auto headless = std::make_unique<HeadlessDeviceD3D12>();
+
+    nvrhi::RefCountPtr<IDXGIFactory4> factory;
+    nvrhi::RefCountPtr<IDXGIAdapter1> adapter;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory))))
+        return nullptr;
+
+    // Use the first hardware adapter that supports D3D12
+    for (UINT adapterIndex = 0; factory->EnumAdapters1(adapterIndex, &adapter) != DXGI_ERROR_NOT_FOUND; ++adapterIndex)
+    {
+        DXGI_ADAPTER_DESC1 adapterDesc{};
+        adapter->GetDesc1(&adapterDesc);
+
+        if ((adapterDesc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0
+            && SUCCEEDED(D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&headless->d3dDevice))))
+        {
+            char name[128];
+            WideCharToMultiByte(CP_UTF8, 0, adapterDesc.Description, -1, name, sizeof(name), nullptr, nullptr);
+            headless->adapterName = name;
+            break;
+        }
+
+        adapter = nullptr;
+    }
+
+    if (!headless->d3dDevice)
+        return nullptr;
+
+    if (!createQueue(headless->d3dDevice, D3D12_COMMAND_LIST_TYPE_DIRECT, headless->graphicsQueue) ||
+        !createQueue(headless->d3dDevice, D3D12_COMMAND_LIST_TYPE_COMPUTE, headless->computeQueue) ||
+        !createQueue(headless->d3dDevice, D3D12_COMMAND_LIST_TYPE_COPY, headless->copyQueue))
+        return nullptr;
+
+    nvrhi::d3d12::DeviceDesc deviceDesc;
+    deviceDesc.errorCB = messageCallback;
+    deviceDesc.pDevice = headless->d3dDevice;
+    deviceDesc.pGraphicsCommandQueue = headless->graphicsQueue;
+    deviceDesc.pComputeCommandQueue = headless->computeQueue;
+    deviceDesc.pCopyCommandQueue = headless->copyQueue;
+
+    headless->device = nvrhi::d3d12::createDevice(deviceDesc);
+    if (!headless->device)
+        return nullptr;
+
+    return headless;
+}
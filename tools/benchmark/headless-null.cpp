@@ -0,0 +1,49 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <nvrhi/null.h>
+
+class HeadlessDeviceNull : public HeadlessDevice
+{
+public:
+    nvrhi::DeviceHandle device;
+
+    nvrhi::IDevice* getDevice() const override { return device; }
+    const char* getAdapterName() const override { return "NVRHI null device (no GPU)"; }
+    bool acceptsPlaceholderShaders() const override { return true; }
+};
+
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceNull(nvrhi::IMessageCallback* messageCallback)
+{
+    auto headless = std::make_unique<HeadlessDeviceNull>();
+
+    nvrhi::null::DeviceDesc deviceDesc;
+    deviceDesc.messageCallback = messageCallback;
+
+    headless->device = nvrhi::null::createDevice(deviceDesc);
+    if (!headless->device)
+        return nullptr;
+
+    return headless;
+}
@@ -0,0 +1,208 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+#include <nvrhi/vulkan.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class HeadlessDeviceVulkan : public HeadlessDevice
+{
+public:
+    vk::DynamicLoader loader;
+    vk::Instance instance;
+    vk::PhysicalDevice physicalDevice;
+    vk::Device vulkanDevice;
+    std::vector<const char*> deviceExtensions;
+    nvrhi::vulkan::DeviceHandle device;
+    std::string adapterName;
+
+    ~HeadlessDeviceVulkan() override
+    {
+        if (device)
+            device->waitForIdle();
+
+        device = nullptr;
+
+        if (vulkanDevice)
+            vulkanDevice.destroy();
+
+        if (instance)
+            instance.destroy();
+    }
+
+    nvrhi::IDevice* getDevice() const override { return device; }
+    const char* getAdapterName() const override { return adapterName.c_str(); }
+};
+
+// Returns the index of a queue family that supports 'required' and none of 'excluded', or -1
+static int findQueueFamily(const std::vector<vk::QueueFamilyProperties>& families, vk::QueueFlags required, vk::QueueFlags excluded)
+{
+    for (size_t i = 0; i < families.size(); i++)
+    {
+        if ((families[i].queueFlags & required) == required && !(families[i].queueFlags & excluded))
+            return int(i);
+    }
+
+    return -1;
+}
+
+std::unique_ptr<HeadlessDevice> createHeadlessDeviceVulkan(nvrhi::IMessageCallback* messageCallback)
+{
+    auto headless = std::make_unique<HeadlessDeviceVulkan>();
+
+    // NVRHI and the application share the default dispatcher in static library builds
+    auto vkGetInstanceProcAddr = headless->loader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
+    if (!vkGetInstanceProcAddr)
+        return nullptr;
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+
+    vk::ApplicationInfo applicationInfo("nvrhi-benchmark", 1, "NVRHI", 1, VK_API_VERSION_1_3);
+    vk::InstanceCreateInfo instanceInfo({}, &applicationInfo);
+    if (vk::createInstance(&instanceInfo, nullptr, &headless->instance) != vk::Result::eSuccess)
+        return nullptr;
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(headless->instance);
+
+    uint32_t physicalDeviceCount = 0;
+    (void)headless->instance.enumeratePhysicalDevices(&physicalDeviceCount, nullptr);
+    std::vector<vk::PhysicalDevice> physicalDevices(physicalDeviceCount);
+    (void)headless->instance.enumeratePhysicalDevices(&physicalDeviceCount, physicalDevices.data());
+
+    // Prefer a discrete GPU, NVRHI needs Vulkan 1.2 for timeline semaphores
+    for (const vk::PhysicalDevice& candidate : physicalDevices)
+    {
+        vk::PhysicalDeviceProperties properties = candidate.getProperties();
+        if (properties.apiVersion < VK_API_VERSION_1_2)
+            continue;
+
+        if (!headless->physicalDevice || properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu)
+        {
+            headless->physicalDevice = candidate;
+            headless->adapterName = properties.deviceName.data();
+        }
+    }
+
+    if (!headless->physicalDevice)
+        return nullptr;
+
+    const std::vector<vk::QueueFamilyProperties> queueFamilies = headless->physicalDevice.getQueueFamilyProperties();
+    int graphicsFamily = findQueueFamily(queueFamilies, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute, {});
+    int computeFamily = findQueueFamily(queueFamilies, vk::QueueFlagBits::eCompute, vk::QueueFlagBits::eGraphics);
+    int transferFamily = findQueueFamily(queueFamilies, vk::QueueFlagBits::eTransfer, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute);
+
+    if (graphicsFamily < 0)
+        return nullptr;
+
+    const float queuePriority = 1.f;
+    std::vector<vk::DeviceQueueCreateInfo> queueInfos;
+    for (int family : { graphicsFamily, computeFamily, transferFamily })
+    {
+        if (family >= 0)
+            queueInfos.push_back(vk::DeviceQueueCreateInfo({}, uint32_t(family), 1, &queuePriority));
+    }
+
+    uint32_t extensionCount = 0;
+    (void)headless->physicalDevice.enumerateDeviceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<vk::ExtensionProperties> availableExtensions(extensionCount);
+    (void)headless->physicalDevice.enumerateDeviceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+    for (const char* name : { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, VK_KHR_MAINTENANCE1_EXTENSION_NAME })
+    {
+        for (const vk::ExtensionProperties& extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName.data(), name) == 0)
+            {
+                headless->deviceExtensions.push_back(name);
+                break;
+            }
+        }
+    }
+
+    const bool synchronization2 = std::find_if(headless->deviceExtensions.begin(), headless->deviceExtensions.end(),
+        [](const char* name) { return strcmp(name, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) == 0; }) != headless->deviceExtensions.end();
+
+    vk::PhysicalDeviceVulkan12Features supported12;
+    vk::PhysicalDeviceFeatures2 supportedFeatures;
+    supportedFeatures.pNext = &supported12;
+    headless->physicalDevice.getFeatures2(&supportedFeatures);
+
+    vk::PhysicalDeviceSynchronization2Features synchronization2Features;
+    synchronization2Features.synchronization2 = true;
+
+    vk::PhysicalDeviceVulkan12Features features12;
+    features12.timelineSemaphore = true;
+    features12.bufferDeviceAddress = supported12.bufferDeviceAddress;
+    features12.drawIndirectCount = supported12.drawIndirectCount;
+    features12.pNext = synchronization2 ? &synchronization2Features : nullptr;
+
+    vk::PhysicalDeviceFeatures2 features;
+    features.pNext = &features12;
+
+    vk::DeviceCreateInfo deviceInfo;
+    deviceInfo.pNext = &features;
+    deviceInfo.queueCreateInfoCount = uint32_t(queueInfos.size());
+    deviceInfo.pQueueCreateInfos = queueInfos.data();
+    deviceInfo.enabledExtensionCount = uint32_t(headless->deviceExtensions.size());
+    deviceInfo.ppEnabledExtensionNames = headless->deviceExtensions.data();
+
+    if (headless->physicalDevice.createDevice(&deviceInfo, nullptr, &headless->vulkanDevice) != vk::Result::eSuccess)
+        return nullptr;
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(headless->vulkanDevice);
+
+    nvrhi::vulkan::DeviceDesc deviceDesc;
+    deviceDesc.errorCB = messageCallback;
+    deviceDesc.instance = headless->instance;
+    deviceDesc.physicalDevice = headless->physicalDevice;
+    deviceDesc.device = headless->vulkanDevice;
+    deviceDesc.graphicsQueue = headless->vulkanDevice.getQueue(uint32_t(graphicsFamily), 0);
+    deviceDesc.graphicsQueueIndex = graphicsFamily;
+    deviceDesc.computeQueue = VK_NULL_HANDLE;
+    deviceDesc.transferQueue = VK_NULL_HANDLE;
+    if (computeFamily >= 0)
+    {
+        deviceDesc.computeQueue = headless->vulkanDevice.getQueue(uint32_t(computeFamily), 0);
+        deviceDesc.computeQueueIndex = computeFamily;
+    }
+    if (transferFamily >= 0)
+    {
+        deviceDesc.transferQueue = headless->vulkanDevice.getQueue(uint32_t(transferFamily), 0);
+        deviceDesc.transferQueueIndex = transferFamily;
+    }
+    deviceDesc.deviceExtensions = headless->deviceExtensions.data();
+    deviceDesc.numDeviceExtensions = headless->deviceExtensions.size();
+    deviceDesc.bufferDeviceAddressSupported = features12.bufferDeviceAddress;
+    deviceDesc.drawIndirectCountSupported = features12.drawIndirectCount;
+
+    headless->device = nvrhi::vulkan::createDevice(deviceDesc);
+    if (!headless->device)
+        return nullptr;
+
+    return headless;
+}
@@ -0,0 +1,60 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <cstdio>
+
+std::unique_ptr<HeadlessDevice> createHeadlessDevice(const std::string& api, nvrhi::IMessageCallback* messageCallback)
+{
+    std::unique_ptr<HeadlessDevice> headless;
+
+#if NVRHI_WITH_DX11
+    if (api == "d3d11")
+        headless = createHeadlessDeviceD3D11(messageCallback);
+    else
+#endif
+#if NVRHI_WITH_DX12
+    if (api == "d3d12")
+        headless = createHeadlessDeviceD3D12(messageCallback);
+    else
+#endif
+#if NVRHI_WITH_VULKAN
+    if (api == "vulkan")
+        headless = createHeadlessDeviceVulkan(messageCallback);
+    else
+#endif
+#if NVRHI_WITH_NULL
+    if (api == "null")
+        headless = createHeadlessDeviceNull(messageCallback);
+    else
+#endif
+    {
+        fprintf(stderr, "API '%s' is not supported by this build.\n", api.c_str());
+        return nullptr;
+    }
+
+    if (!headless)
+        fprintf(stderr, "Failed to create a %s device.\n", api.c_str());
+
+    return headless;
+}
@@ -0,0 +1,194 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <nvrhi/capture.h>
+#include <nvrhi/validation.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct ReplayOptions
+{
+    std::string api;
+    std::string capturePath;
+    uint32_t frames = 10;
+    bool validation = false;
+};
+
+class MessageCallback : public nvrhi::IMessageCallback
+{
+public:
+    void message(nvrhi::MessageSeverity severity, const char* messageText) override
+    {
+        if (severity == nvrhi::MessageSeverity::Info)
+            return;
+
+        fprintf(stderr, "%s\n", messageText);
+    }
+};
+
+static MessageCallback g_MessageCallback;
+
+static void printUsage()
+{
+    printf("Usage: nvrhi-replay [options] <capture file>\n"
+        "  --api <d3d11|d3d12|vulkan|null>\n"
+        "                              Replay on the given API (default: the API of the capture, or null)\n"
+        "  --frames <N>                Number of times the captured frame is replayed (default: 10)\n"
+        "  --validation                Wrap the device into the NVRHI validation layer\n");
+}
+
+static bool parseCommandLine(int argc, char** argv, ReplayOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "--api") && hasValue)
+            options.api = argv[++i];
+        else if (!strcmp(arg, "--frames") && hasValue)
+            options.frames = uint32_t(std::max(1, atoi(argv[++i])));
+        else if (!strcmp(arg, "--validation"))
+            options.validation = true;
+        else if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+            return false;
+        else if (arg[0] != '-' && options.capturePath.empty())
+            options.capturePath = arg;
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return false;
+        }
+    }
+
+    return !options.capturePath.empty();
+}
+
+static const char* getApiName(nvrhi::GraphicsAPI api)
+{
+    switch (api)
+    {
+    case nvrhi::GraphicsAPI::D3D11:  return "d3d11";
+    case nvrhi::GraphicsAPI::D3D12:  return "d3d12";
+    case nvrhi::GraphicsAPI::VULKAN: return "vulkan";
+    default:                         return "unknown";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::ifstream file(options.capturePath, std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open '%s'.\n", options.capturePath.c_str());
+        return 1;
+    }
+
+    const std::vector<uint8_t> captureData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    nvrhi::capture::CaptureInfo captureInfo;
+    if (!nvrhi::capture::getCaptureInfo(captureData.data(), captureData.size(), captureInfo))
+    {
+        fprintf(stderr, "'%s' is not a capture that this version of NVRHI can replay.\n", options.capturePath.c_str());
+        return 1;
+    }
+
+    std::unique_ptr<HeadlessDevice> headless;
+    if (options.api.empty())
+    {
+        // Prefer the API of the capture, the null device can replay any capture when that API is not available
+        options.api = getApiName(captureInfo.graphicsAPI);
+        headless = createHeadlessDevice(options.api, &g_MessageCallback);
+        if (!headless)
+        {
+            options.api = "null";
+            headless = createHeadlessDevice(options.api, &g_MessageCallback);
+        }
+    }
+    else
+        headless = createHeadlessDevice(options.api, &g_MessageCallback);
+
+    if (!headless)
+        return 1;
+
+    printf("%s: %s\n", options.api.c_str(), headless->getAdapterName());
+    printf("Capture: %s, %zu bytes, captured on %s with NVRHI header version %u\n", options.capturePath.c_str(),
+        captureData.size(), getApiName(captureInfo.graphicsAPI), captureInfo.headerVersion);
+
+    nvrhi::DeviceHandle device = headless->getDevice();
+
+    // Shader binaries are specific to the API, only the null device can replay them on another one
+    if (device->getGraphicsAPI() != captureInfo.graphicsAPI && !headless->acceptsPlaceholderShaders())
+    {
+        fprintf(stderr, "The capture can only be replayed on %s or on the null device.\n", getApiName(captureInfo.graphicsAPI));
+        return 1;
+    }
+
+    if (options.validation)
+        device = nvrhi::validation::createValidationLayer(device);
+
+    nvrhi::capture::ReplayHandle replay = nvrhi::capture::createReplay(device, captureData.data(), captureData.size());
+    if (!replay)
+        return 1;
+
+    double totalCpuTime = 0.0;
+    double totalGpuTime = 0.0;
+    double minCpuTime = 0.0;
+
+    for (uint32_t frame = 0; frame < options.frames; frame++)
+    {
+        nvrhi::capture::ReplayStatistics statistics;
+        if (!replay->replayFrame(&statistics))
+            return 1;
+
+        printf("frame %3u: CPU %9.3f ms, GPU %9.3f ms, %u command lists, %u commands\n", frame,
+            statistics.cpuRecordingTime * 1e3, statistics.gpuTime * 1e3,
+            statistics.commandListsRecorded, statistics.commandsReplayed);
+
+        totalCpuTime += statistics.cpuRecordingTime;
+        totalGpuTime += statistics.gpuTime;
+        minCpuTime = frame == 0 ? statistics.cpuRecordingTime : std::min(minCpuTime, statistics.cpuRecordingTime);
+
+        device->runGarbageCollection();
+    }
+
+    printf("average:   CPU %9.3f ms, GPU %9.3f ms; minimum CPU %.3f ms\n",
+        totalCpuTime * 1e3 / options.frames, totalGpuTime * 1e3 / options.frames, minCpuTime * 1e3);
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+cbuffer Constants : register(b0)
+{
+    float4 g_Color;
+    float4 g_Offset;
+};
+
+Texture2D t_Texture : register(t0);
+SamplerState s_Sampler : register(s0);
+
+void main_vs(
+    uint i_vertexID : SV_VertexID,
+    out float4 o_position : SV_Position,
+    out float2 o_uv : TEXCOORD)
+{
+    // Fullscreen triangle
+    o_uv = float2((i_vertexID << 1) & 2, i_vertexID & 2);
+    o_position = float4(o_uv * float2(2, -2) + float2(-1, 1) + g_Offset.xy, 0, 1);
+}
+
+void main_ps(
+    in float4 i_position : SV_Position,
+    in float2 i_uv : TEXCOORD,
+    out float4 o_color : SV_Target0)
+{
+    o_color = t_Texture.Sample(s_Sampler, i_uv) * g_Color;
+}
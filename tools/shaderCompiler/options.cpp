@@ -72,8 +72,11 @@ bool CommandLineOptions::parse(int argc, char** argv)
 		("p,parallel", "Compile shaders in multiple CPU threads", value(parallel))
 		("v,verbose", "Print commands before executing them", value(verbose))
 		("f,force", "Treat all source files as modified", value(force))
+		("cache-dir", "Shared directory with compiled permutations, reused across output directories and machines", value(cacheDirectory))
 		("k,keep", "Keep intermediate files", value(keep))
+		("archive", "Write all shaders and permutations into one indexed file with this name in the output directory, for nvrhi::openShaderArchive", value(archive))
 		("c,compiler", "Path to the compiler executable (FXC or DXC)", value(compilerPath))
+		("in-process", "Load dxcompiler from the compiler directory and compile without spawning processes (DXIL and SPIR-V only)", value(inProcess))
 		("I,include", "Include paths", value(includePaths))
 		("D,define", "Additional defines", value(additionalDefines))
 		("ignore", "Include files to ignore", value(ignoreFileNames))
@@ -124,6 +127,9 @@ bool CommandLineOptions::parse(int argc, char** argv)
 		else
 			throw OptionException("Unrecognized platform: " + platformName);
 
+		if (inProcess && platform == Platform::DXBC)
+			throw OptionException("In-process compilation requires DXC, it is not available for DXBC");
+
 		if (argc > 1)
 			throw OptionException("Unexpected positional arguments");
 
@@ -40,12 +40,15 @@ struct CommandLineOptions
     std::vector<std::string> ignoreFileNames;
     std::vector<std::string> additionalCompilerOptions;
 	std::string compilerPath;
+	std::string cacheDirectory;
+	std::string archive;
 	Platform platform = Platform::UNKNOWN;
 	bool parallel = false;
 	bool verbose = false;
 	bool force = false;
 	bool help = false;
 	bool keep = false;
+	bool inProcess = false;
 	int vulkanTextureShift = 0;
 	int vulkanSamplerShift = 128;
 	int vulkanConstantShift = 256;
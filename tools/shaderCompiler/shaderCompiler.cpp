@@ -26,12 +26,18 @@
 #include <sstream>
 #include <map>
 #include <list>
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <random>
 #include <cstdio>
+#include <cstring>
 #include <regex>
 #include <thread>
 #include <mutex>
 #include <csignal>
 #include <nvrhi/common/shader-blob.h>
+#include <nvrhi/common/shader-archive.h>
 #include <nvrhi/common/misc.h>
 
 #if __has_include(<filesystem>)
@@ -44,12 +50,30 @@ namespace fs = std::experimental::filesystem;
 error "Missing the <filesystem> header."
 #endif
 
+// Define NVRHI_SHADERCOMPILER_WITH_DXCAPI=1 and put dxcapi.h on the include path to enable --in-process
+#if NVRHI_SHADERCOMPILER_WITH_DXCAPI
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#include <dxcapi.h>
+#endif
+
 #ifdef _MSC_VER 
 #define popen _popen
 #define pclose _pclose
 #define putenv _putenv
 #endif
 
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
 using namespace std;
 
 CommandLineOptions g_Options;
@@ -62,16 +86,46 @@ struct CompileTask
 	string entryPoint;
 	string combinedDefines;
 	string commandLine;
+	string dependencyCommandLine; // empty if the compiler cannot list dependencies (FXC)
+	vector<string> compilerArguments; // for in-process compilation, without the output file
+	string permutationName;
+	fs::path compiledPermutationFile;
+	uint64_t commandHash = 0;
+	uint32_t expectedCompileTime = 0; // milliseconds, from the previous build
 };
 
+// Immutable while the workers run, they claim tasks by incrementing g_NextTaskIndex
 vector<CompileTask> g_CompileTasks;
+atomic<size_t> g_NextTaskIndex;
 int g_OriginalTaskCount;
 atomic<int> g_ProcessedTaskCount;
-mutex g_TaskMutex;
+atomic<int> g_RestoredTaskCount;
 mutex g_ReportMutex;
 bool g_Terminate = false;
 bool g_CompileSuccess = true;
-fs::file_time_type g_ConfigWriteTime;
+
+// All permutations that produce the same output file, keyed by that file's name
+map<string, vector<CompileTask>> g_OutputTasks;
+
+// Content hash of a permutation's inputs and the list of files it was compiled from.
+// Dependencies are stored relative to the config file so that entries stay valid in other checkouts.
+struct CacheEntry
+{
+	uint64_t contentHash = 0;
+	uint32_t compileTime = 0; // milliseconds
+	vector<string> dependencies;
+};
+
+const char* c_CacheFormatVersion = "nvrhi-scomp-cache-1";
+
+map<string, CacheEntry> g_CacheDatabase;
+mutex g_CacheMutex;
+fs::path g_CacheDatabaseFile;
+fs::path g_ConfigBasePath;
+uint64_t g_CompilerHash = 0;
+
+map<string, uint64_t> g_FileHashes;
+mutex g_FileHashMutex;
 
 struct BlobEntry
 {
@@ -81,7 +135,6 @@ struct BlobEntry
 
 map<string, vector<BlobEntry>> g_ShaderBlobs;
 
-map<fs::path, fs::file_time_type> g_HierarchicalUpdateTimes;
 vector<fs::path> g_IgnoreIncludes;
 
 const char* g_SharedCompilerOptions = "-nologo ";
@@ -91,23 +144,277 @@ string path_string(fs::path path)
 	return path.make_preferred().string();
 }
 
-bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& callStack, fs::file_time_type& outTime)
+// a version of std::isspace that is a bit more compatible between various compilers
+inline bool _isspace(int ch)
 {
-	static basic_regex<char> include_pattern("\\s*#include\\s+[\"<]([^>\"]+)[>\"].*");
+	return strchr(" \t\r\n", ch) != nullptr;
+}
 
-	auto found = g_HierarchicalUpdateTimes.find(rootFilePath);
-	if (found != g_HierarchicalUpdateTimes.end())
+// FNV-1a, used instead of std::hash because cache keys must match across compilers and machines
+const uint64_t c_FnvOffsetBasis = 0xcbf29ce484222325ull;
+const uint64_t c_FnvPrime = 0x100000001b3ull;
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
 	{
-		outTime = found->second;
-		return true;
+		hash ^= bytes[i];
+		hash *= c_FnvPrime;
+	}
+	return hash;
+}
+
+uint64_t hashString(const string& s, uint64_t hash)
+{
+	// include the terminator so that "ab","c" and "a","bc" produce different hashes
+	return hashBytes(s.c_str(), s.size() + 1, hash);
+}
+
+bool hashFile(const fs::path& path, uint64_t& outHash)
+{
+	ifstream file(path, ios::binary);
+	if (!file.is_open())
+		return false;
+
+	uint64_t hash = c_FnvOffsetBasis;
+	char buf[16384];
+	while (file)
+	{
+		file.read(buf, sizeof(buf));
+		hash = hashBytes(buf, size_t(file.gcount()), hash);
+	}
+
+	outHash = hash;
+	return true;
+}
+
+string toHex(uint64_t value)
+{
+	char buf[20];
+	snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)value);
+	return buf;
+}
+
+string makeDependencyName(const fs::path& path)
+{
+	error_code ec;
+	fs::path relativePath = fs::proximate(fs::absolute(path, ec), g_ConfigBasePath, ec);
+	if (ec)
+		return path.generic_string();
+
+	return relativePath.generic_string();
+}
+
+bool getDependencyHash(const string& dependency, uint64_t& outHash)
+{
+	{
+		lock_guard<mutex> guard(g_FileHashMutex);
+		auto found = g_FileHashes.find(dependency);
+		if (found != g_FileHashes.end())
+		{
+			outHash = found->second;
+			return true;
+		}
+	}
+
+	uint64_t hash;
+	if (!hashFile(g_ConfigBasePath / dependency, hash))
+		return false;
+
+	lock_guard<mutex> guard(g_FileHashMutex);
+	g_FileHashes[dependency] = hash;
+	outHash = hash;
+	return true;
+}
+
+// Returns false if any of the dependencies no longer exists, which means the permutation must be rebuilt
+bool computeContentHash(uint64_t commandHash, const vector<string>& dependencies, uint64_t& outHash)
+{
+	uint64_t hash = commandHash;
+	for (const string& dependency : dependencies)
+	{
+		uint64_t fileHash;
+		if (!getDependencyHash(dependency, fileHash))
+			return false;
+
+		hash = hashString(dependency, hash);
+		hash = hashBytes(&fileHash, sizeof(fileHash), hash);
 	}
 
+	outHash = hash;
+	return true;
+}
+
+// Hashes everything that affects the compiled binary except the source files,
+// and nothing that depends on the output location or the machine.
+uint64_t computeCommandHash(const string& shaderConfig)
+{
+	uint64_t hash = hashString(c_CacheFormatVersion, c_FnvOffsetBasis);
+	hash = hashString(g_PlatformName, hash);
+	hash = hashBytes(&g_CompilerHash, sizeof(g_CompilerHash), hash);
+	hash = hashString(shaderConfig, hash);
+
+	for (const string& define : g_Options.additionalDefines)
+		hash = hashString(define, hash);
+	for (const string& dir : g_Options.includePaths)
+		hash = hashString(makeDependencyName(dir), hash);
+	for (const string& option : g_Options.additionalCompilerOptions)
+		hash = hashString(option, hash);
+
+	if (g_Options.platform == Platform::SPIRV)
+	{
+		const int shifts[] = { g_Options.vulkanTextureShift, g_Options.vulkanSamplerShift, g_Options.vulkanConstantShift, g_Options.vulkanUavShift };
+		hash = hashBytes(shifts, sizeof(shifts), hash);
+	}
+
+	return hash;
+}
+
+bool loadCacheDatabase()
+{
+	ifstream file(g_CacheDatabaseFile);
+	if (!file.is_open())
+		return false;
+
+	string line;
+	if (!getline(file, line) || line != c_CacheFormatVersion)
+		return false;
+
+	CacheEntry* entry = nullptr;
+	while (getline(file, line))
+	{
+		if (line.size() > 2 && line[0] == 'P' && line[1] == ' ')
+		{
+			size_t space = line.find(' ', 2);
+			if (space == string::npos)
+				return false;
+
+			entry = &g_CacheDatabase[line.substr(space + 1)];
+			entry->contentHash = strtoull(line.substr(2, space - 2).c_str(), nullptr, 16);
+		}
+		else if (line.size() > 2 && line[0] == 'D' && line[1] == ' ' && entry)
+		{
+			entry->dependencies.push_back(line.substr(2));
+		}
+		else if (line.size() > 2 && line[0] == 'T' && line[1] == ' ' && entry)
+		{
+			entry->compileTime = (uint32_t)strtoul(line.c_str() + 2, nullptr, 10);
+		}
+	}
+
+	return true;
+}
+
+bool writeFileAtomically(const fs::path& path, const string& contents)
+{
+	// Write to a unique temporary file and rename it, so that concurrent builds sharing
+	// the same cache directory never observe a partially written file.
+	// The name has the process ID, the thread, and a random number that changes with every call,
+	// so it doesn't collide even when a process ID is reused while a stale temporary file exists.
+	static const uint64_t processNonce = (uint64_t(random_device()()) << 32) | random_device()();
+	static atomic<uint64_t> writeCounter = 0;
+	fs::path tempPath = path;
+	tempPath += "." + to_string(getpid())
+		+ "." + toHex(std::hash<thread::id>()(this_thread::get_id()))
+		+ "." + toHex(processNonce + writeCounter++) + ".tmp";
+
+	{
+		ofstream file(tempPath, ios::binary);
+		if (!file.is_open())
+			return false;
+
+		file.write(contents.data(), contents.size());
+		if (!file)
+			return false;
+	}
+
+	error_code ec;
+	fs::rename(tempPath, path, ec);
+	if (ec)
+	{
+		fs::remove(tempPath, ec);
+		return false;
+	}
+
+	return true;
+}
+
+bool saveCacheDatabase()
+{
+	ostringstream ss;
+	ss << c_CacheFormatVersion << endl;
+	for (const pair<const string, CacheEntry>& it : g_CacheDatabase)
+	{
+		ss << "P " << toHex(it.second.contentHash) << " " << it.first << endl;
+		if (it.second.compileTime)
+			ss << "T " << it.second.compileTime << endl;
+		for (const string& dependency : it.second.dependencies)
+			ss << "D " << dependency << endl;
+	}
+
+	return writeFileAtomically(g_CacheDatabaseFile, ss.str());
+}
+
+// Parses a make-style dependency rule ("target: dep1 dep2 \<newline> dep3") as printed by DXC -M.
+bool parseDependencyList(const string& contents, set<string>& outDependencies)
+{
+	size_t pos = contents.find(": ");
+	if (pos == string::npos)
+		return false;
+
+	string current;
+	auto flush = [&outDependencies, &current]()
+	{
+		if (!current.empty())
+			outDependencies.insert(makeDependencyName(current));
+		current.clear();
+	};
+
+	for (pos += 2; pos < contents.size(); pos++)
+	{
+		char ch = contents[pos];
+		if (ch == '\\' && pos + 1 < contents.size())
+		{
+			char next = contents[pos + 1];
+			if (next == ' ')
+			{
+				current += ' ';
+				pos++;
+				continue;
+			}
+			if (next == '\n' || next == '\r')
+			{
+				flush();
+				continue;
+			}
+		}
+
+		if (_isspace(ch))
+			flush();
+		else
+			current += ch;
+	}
+	flush();
+
+	return !outDependencies.empty();
+}
+
+// Fallback dependency scanner for compilers that cannot list dependencies themselves (FXC).
+// Conditional includes are always followed, so the result may be a superset of the real dependencies.
+bool collectIncludes(const fs::path& rootFilePath, list<fs::path>& callStack, set<string>& dependencies, ostream& log)
+{
+	static basic_regex<char> include_pattern("\\s*#include\\s+[\"<]([^>\"]+)[>\"].*");
+
+	if (!dependencies.insert(makeDependencyName(rootFilePath)).second)
+		return true;
+
 	ifstream inputFile(rootFilePath);
 	if (!inputFile.is_open())
 	{
-		cout << "ERROR: Cannot open file  " << path_string(rootFilePath) << endl;
+		log << "ERROR: Cannot open file  " << path_string(rootFilePath) << endl;
 		for (const fs::path& otherPath : callStack)
-			cout << "            included in  " << path_string(otherPath) << endl;
+			log << "            included in  " << path_string(otherPath) << endl;
 
 		return false;
 	}
@@ -115,7 +422,6 @@ bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& cal
 	callStack.push_front(rootFilePath);
 
 	fs::path rootBasePath = rootFilePath.parent_path();
-	fs::file_time_type hierarchicalUpdateTime = fs::last_write_time(rootFilePath);
 
 	uint32_t lineno = 0;
 	for (string line; getline(inputFile, line);)
@@ -162,68 +468,91 @@ bool getHierarchicalUpdateTime(const fs::path& rootFilePath, list<fs::path>& cal
 
 			if (!foundIncludedFile)
 			{
-				cout << "ERROR: Cannot find include file  " << path_string(include) << endl;
+				log << "ERROR: Cannot find include file  " << path_string(include) << endl;
 				for (const fs::path& otherPath : callStack)
-					cout << "                    included in  " << path_string(otherPath) << endl;
+					log << "                    included in  " << path_string(otherPath) << endl;
 
 				return false;
 			}
 
-			fs::file_time_type dependencyTime;
-			if (!getHierarchicalUpdateTime(includedFilePath, callStack, dependencyTime))
+			if (!collectIncludes(includedFilePath, callStack, dependencies, log))
 				return false;
-
-			hierarchicalUpdateTime = std::max(dependencyTime, hierarchicalUpdateTime);
 		}
 	}
 
 	callStack.pop_front();
 
-	g_HierarchicalUpdateTimes[rootFilePath] = hierarchicalUpdateTime;
-	outTime = hierarchicalUpdateTime;
-
 	return true;
 }
 
-string buildCompilerCommandLine(const CompilerOptions& options, const fs::path& shaderFile, const fs::path& outputFile)
+vector<string> buildCompilerArguments(const CompilerOptions& options, const fs::path& shaderFile, const fs::path& outputFile)
 {
-	std::ostringstream ss;
-#ifdef _WIN32
-	ss << "%COMPILER% ";
-#else
-	ss << "$COMPILER ";
-#endif
-	ss << path_string(shaderFile) << " ";
-	ss << "-Fo " << path_string(outputFile) << " ";
-	ss << "-T " << options.target << " ";
+	vector<string> arguments;
+	arguments.push_back(path_string(shaderFile));
+	if (!outputFile.empty())
+	{
+		arguments.push_back("-Fo");
+		arguments.push_back(path_string(outputFile));
+	}
+	arguments.push_back("-T");
+	arguments.push_back(options.target);
 	if (!options.entryPoint.empty())
-		ss << "-E " << options.entryPoint << " ";
+	{
+		arguments.push_back("-E");
+		arguments.push_back(options.entryPoint);
+	}
 	for (const string& define : options.definitions)
-		ss << "-D" << define << " ";
+		arguments.push_back("-D" + define);
 	for (const string& define : g_Options.additionalDefines)
-		ss << "-D" << define << " ";
+		arguments.push_back("-D" + define);
 	for (const string& dir : g_Options.includePaths)
-		ss << "-I" << path_string(dir) << " ";
-
-	ss << g_SharedCompilerOptions;
+		arguments.push_back("-I" + path_string(dir));
 
 	for (const string& option : g_Options.additionalCompilerOptions)
 	{
-		ss << option << " ";
+		// --cflags values may contain several options, split them like the shell would
+		istringstream ss(option);
+		for (string argument; ss >> argument;)
+			arguments.push_back(argument);
 	}
 
 	if (g_Options.platform == Platform::SPIRV)
 	{
-		ss << "-spirv ";
+		arguments.push_back("-spirv");
 
 		for (int space = 0; space < 10; space++)
 		{
-			ss << "-fvk-t-shift " << g_Options.vulkanTextureShift << " " << space << " ";
-			ss << "-fvk-s-shift " << g_Options.vulkanSamplerShift << " " << space << " ";
-			ss << "-fvk-b-shift " << g_Options.vulkanConstantShift << " " << space << " ";
-			ss << "-fvk-u-shift " << g_Options.vulkanUavShift << " " << space << " ";
+			const pair<const char*, int> shifts[] = {
+				{ "-fvk-t-shift", g_Options.vulkanTextureShift },
+				{ "-fvk-s-shift", g_Options.vulkanSamplerShift },
+				{ "-fvk-b-shift", g_Options.vulkanConstantShift },
+				{ "-fvk-u-shift", g_Options.vulkanUavShift }
+			};
+
+			for (const auto& shift : shifts)
+			{
+				arguments.push_back(shift.first);
+				arguments.push_back(to_string(shift.second));
+				arguments.push_back(to_string(space));
+			}
 		}
 	}
+
+	return arguments;
+}
+
+string buildCompilerCommandLine(const CompilerOptions& options, const fs::path& shaderFile, const fs::path& outputFile)
+{
+	std::ostringstream ss;
+#ifdef _WIN32
+	ss << "%COMPILER% ";
+#else
+	ss << "$COMPILER ";
+#endif
+	ss << g_SharedCompilerOptions;
+
+	for (const string& argument : buildCompilerArguments(options, shaderFile, outputFile))
+		ss << argument << " ";
 	
 	return ss.str();
 }
@@ -290,24 +619,6 @@ bool processShaderConfig(uint32_t lineno, const string& shaderConfig)
 		cout << "INFO: Creating directory " << compiledShaderPath << endl;
 		fs::create_directories(compiledShaderPath);
 	}
-	else if(!g_Options.force)
-	{
-		fs::path compiledShaderFile = g_Options.outputPath / compiledShaderName;
-		if (fs::exists(compiledShaderFile))
-		{
-			fs::file_time_type compiledFileTime = fs::last_write_time(compiledShaderFile);
-
-			fs::file_time_type sourceHierarchyTime;
-			list<fs::path> callStack;
-			if (!getHierarchicalUpdateTime(sourceFile, callStack, sourceHierarchyTime))
-				return false;
-
-			sourceHierarchyTime = std::max(sourceHierarchyTime, g_ConfigWriteTime);
-
-			if (compiledFileTime > sourceHierarchyTime)
-				return true;
-		}
-	}
 
 	fs::path compiledPermutationName = compiledShaderName;
 	compiledPermutationName.replace_extension("");
@@ -329,7 +640,18 @@ bool processShaderConfig(uint32_t lineno, const string& shaderConfig)
 	task.entryPoint = compilerOptions.entryPoint;
 	task.combinedDefines = combinedDefines.str();
 	task.commandLine = commandLine;
-	g_CompileTasks.push_back(task);
+	task.permutationName = compiledPermutationName.generic_string();
+	task.compiledPermutationFile = compiledPermutationFile;
+	task.commandHash = computeCommandHash(shaderConfig);
+
+	if (g_Options.platform != Platform::DXBC)
+	{
+		// DXC prints the make-style dependency list with -M and skips code generation
+		task.dependencyCommandLine = buildCompilerCommandLine(compilerOptions, sourceFile, fs::path()) + "-M ";
+		task.compilerArguments = buildCompilerArguments(compilerOptions, sourceFile, fs::path());
+	}
+
+	g_OutputTasks[path_string(compiledShaderName)].push_back(task);
 
 	if (!compilerOptions.definitions.empty())
 	{
@@ -383,12 +705,6 @@ bool expandPermutations(uint32_t lineno, const string& shaderConfig)
 	return processShaderConfig(lineno, shaderConfig);
 }
 
-// a version of std::isspace that is a bit more compatible between various compilers
-inline bool _isspace(int ch)
-{
-	return strchr(" \t\r\n", ch) != nullptr;
-}
-
 bool trim(string& s)
 {
 	size_t pos;
@@ -480,50 +796,507 @@ bool WriteShaderBlob(const string& compiledShaderName, const vector<BlobEntry>&
 	return true;
 }
 
-void compileThreadProc()
+// Writes every permutation of every output into one file, see shader-archive.h for the layout.
+// Built in memory and written atomically, so that a running application never maps a half-written archive.
+bool WriteShaderArchive(const fs::path& archiveFile)
 {
-	while (!g_Terminate)
+	struct ArchiveItem
+	{
+		nvrhi::ShaderArchiveEntry entry;
+		string name;
+		const CompileTask* task = nullptr;
+	};
+
+	vector<ArchiveItem> items;
+	for (const pair<const string, vector<CompileTask>>& it : g_OutputTasks)
 	{
-		CompileTask task;
+		// Runtime lookups use '/' on every platform
+		string name = fs::path(it.first).generic_string();
+
+		for (const CompileTask& task : it.second)
 		{
-			lock_guard<mutex> guard(g_TaskMutex);
-			if (g_CompileTasks.empty())
-				return;
+			ArchiveItem item;
+			item.name = name;
+			item.task = &task;
+			item.entry.key = nvrhi::getShaderArchiveKey(name.data(), name.size(), task.combinedDefines.data(), task.combinedDefines.size());
+			item.entry.nameSize = uint32_t(name.size());
+			item.entry.permutationSize = uint32_t(task.combinedDefines.size());
+			items.push_back(item);
+		}
+	}
+
+	sort(items.begin(), items.end(), [](const ArchiveItem& a, const ArchiveItem& b)
+	{
+		return a.entry.key < b.entry.key;
+	});
 
-			task = g_CompileTasks[g_CompileTasks.size() - 1];
-			g_CompileTasks.pop_back();
+	for (size_t i = 1; i < items.size(); i++)
+	{
+		if (items[i].entry.key == items[i - 1].entry.key)
+		{
+			cout << "ERROR: " << path_string(items[i].task->compiledPermutationFile) << " and " << path_string(items[i - 1].task->compiledPermutationFile)
+				<< " have the same archive key, change the output name or the defines of one of them" << endl;
+			return false;
+		}
+	}
+
+	nvrhi::ShaderArchiveHeader header;
+	header.numEntries = uint32_t(items.size());
+
+	string strings;
+	for (ArchiveItem& item : items)
+	{
+		item.entry.stringsOffset = strings.size();
+		strings += item.name;
+		strings += item.task->combinedDefines;
+	}
+
+	uint64_t stringsStart = sizeof(header) + items.size() * sizeof(nvrhi::ShaderArchiveEntry);
+
+	string data;
+	vector<string> inputFiles;
+	for (ArchiveItem& item : items)
+	{
+		string inputFileName = path_string(item.task->compiledPermutationFile);
+		ifstream inputFile(inputFileName, ios::binary);
+		if (!inputFile.is_open())
+		{
+			cout << "ERROR: cannot read " << inputFileName << endl;
+			return false;
 		}
 
+		string binary((istreambuf_iterator<char>(inputFile)), istreambuf_iterator<char>());
+
+		// Offsets are final once the string table size is known, align each binary in file space
+		uint64_t dataStart = stringsStart + strings.size();
+		uint64_t offset = dataStart + data.size();
+		uint64_t padding = (nvrhi::c_ShaderArchiveDataAlignment - offset % nvrhi::c_ShaderArchiveDataAlignment) % nvrhi::c_ShaderArchiveDataAlignment;
+		data.append(size_t(padding), '\0');
+
+		item.entry.stringsOffset += stringsStart;
+		item.entry.dataOffset = dataStart + data.size();
+		item.entry.dataSize = binary.size();
+		data += binary;
+
+		inputFiles.push_back(inputFileName);
+	}
+
+	string contents;
+	contents.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const ArchiveItem& item : items)
+		contents.append(reinterpret_cast<const char*>(&item.entry), sizeof(item.entry));
+	contents += strings;
+	contents += data;
+
+	if (g_Options.verbose)
+	{
+		cout << "INFO: writing " << path_string(archiveFile) << endl;
+	}
+
+	if (!writeFileAtomically(archiveFile, contents))
+	{
+		cout << "ERROR: cannot write " << path_string(archiveFile) << endl;
+		return false;
+	}
+
+	if (!g_Options.keep)
+	{
+		for (const string& inputFile : inputFiles)
+			fs::remove(inputFile);
+	}
+
+	return true;
+}
+
+bool isUpToDate(const CompileTask& task)
+{
+	auto found = g_CacheDatabase.find(task.permutationName);
+	if (found == g_CacheDatabase.end())
+		return false;
+
+	uint64_t contentHash;
+	if (!computeContentHash(task.commandHash, found->second.dependencies, contentHash))
+		return false;
+
+	return contentHash == found->second.contentHash;
+}
+
+bool readSharedDependencyList(uint64_t commandHash, vector<string>& outDependencies)
+{
+	ifstream file(fs::path(g_Options.cacheDirectory) / (toHex(commandHash) + ".deps"));
+	if (!file.is_open())
+		return false;
+
+	for (string line; getline(file, line);)
+	{
+		if (!line.empty())
+			outDependencies.push_back(line);
+	}
+
+	return !outDependencies.empty();
+}
+
+bool restoreFromSharedCache(const CompileTask& task)
+{
+	if (g_Options.cacheDirectory.empty())
+		return false;
+
+	// The local database knows the dependencies from the previous build in this output directory;
+	// the shared cache knows them from the last build anywhere with the same command.
+	vector<vector<string>> candidates;
+	uint32_t compileTime = 0;
+	auto found = g_CacheDatabase.find(task.permutationName);
+	if (found != g_CacheDatabase.end())
+	{
+		candidates.push_back(found->second.dependencies);
+		compileTime = found->second.compileTime;
+	}
+
+	vector<string> sharedDependencies;
+	if (readSharedDependencyList(task.commandHash, sharedDependencies))
+		candidates.push_back(sharedDependencies);
+
+	for (const vector<string>& dependencies : candidates)
+	{
+		CacheEntry entry;
+		entry.compileTime = compileTime;
+		entry.dependencies = dependencies;
+		if (!computeContentHash(task.commandHash, entry.dependencies, entry.contentHash))
+			continue;
+
+		fs::path cachedFile = fs::path(g_Options.cacheDirectory) / (toHex(entry.contentHash) + ".bin");
+
+		error_code ec;
+		if (!fs::exists(cachedFile, ec))
+			continue;
+
+		fs::copy_file(cachedFile, task.compiledPermutationFile, fs::copy_options::overwrite_existing, ec);
+		if (ec)
+			continue;
+
+		if (g_Options.verbose)
+		{
+			cout << "INFO: restored " << path_string(task.compiledPermutationFile) << " from " << path_string(cachedFile) << endl;
+		}
+
+		g_CacheDatabase[task.permutationName] = entry;
+		return true;
+	}
+
+	return false;
+}
+
+string readPipe(const string& commandLine, int& outResult)
+{
+	outResult = -1;
+
+	FILE* pipe = popen(commandLine.c_str(), "r");
+	if (!pipe)
+		return string();
+
+	ostringstream ss;
+	char buf[1024];
+	while (fgets(buf, sizeof(buf), pipe))
+		ss << buf;
+
+	outResult = pclose(pipe);
+	return ss.str();
+}
+
+// Records the dependencies and content hash of a freshly compiled permutation,
+// and publishes the binary to the shared cache. Failures here only cost a rebuild next time.
+void storeCompiledPermutation(const CompileTask& task, set<string>& dependencies, bool haveDependencies, uint32_t compileTime, ostream& log)
+{
+	if (!haveDependencies && !task.dependencyCommandLine.empty())
+	{
+#ifdef _WIN32
+		string commandLine = task.dependencyCommandLine + " 2>nul";
+#else
+		string commandLine = task.dependencyCommandLine + " 2>/dev/null";
+#endif
+		int result;
+		string output = readPipe(commandLine, result);
+		haveDependencies = (result == 0) && parseDependencyList(output, dependencies);
+	}
+
+	if (!haveDependencies)
+	{
+		dependencies.clear();
+		list<fs::path> callStack;
+		haveDependencies = collectIncludes(task.sourceFile, callStack, dependencies, log);
+	}
+
+	if (!haveDependencies)
+		return;
+
+	CacheEntry entry;
+	entry.compileTime = compileTime;
+	entry.dependencies.assign(dependencies.begin(), dependencies.end());
+	if (!computeContentHash(task.commandHash, entry.dependencies, entry.contentHash))
+		return;
+
+	if (!g_Options.cacheDirectory.empty())
+	{
+		fs::path cacheDirectory = g_Options.cacheDirectory;
+
+		ifstream compiledFile(task.compiledPermutationFile, ios::binary);
+		string binary((istreambuf_iterator<char>(compiledFile)), istreambuf_iterator<char>());
+
+		ostringstream ss;
+		for (const string& dependency : entry.dependencies)
+			ss << dependency << endl;
+
+		if (!compiledFile.is_open()
+			|| !writeFileAtomically(cacheDirectory / (toHex(entry.contentHash) + ".bin"), binary)
+			|| !writeFileAtomically(cacheDirectory / (toHex(task.commandHash) + ".deps"), ss.str()))
+		{
+			log << "WARNING: cannot store " << path_string(task.compiledPermutationFile) << " in the shared cache" << endl;
+		}
+	}
+
+	lock_guard<mutex> guard(g_CacheMutex);
+	g_CacheDatabase[task.permutationName] = entry;
+}
+
+#if NVRHI_SHADERCOMPILER_WITH_DXCAPI
+DxcCreateInstanceProc g_DxcCreateInstance = nullptr;
+
+bool loadDxcLibrary(fs::path& outLibraryPath)
+{
+	fs::path compilerDirectory = fs::absolute(g_Options.compilerPath).parent_path();
+
+#ifdef _WIN32
+	const fs::path candidates[] = { compilerDirectory / "dxcompiler.dll" };
+#else
+	const fs::path candidates[] = { compilerDirectory / "libdxcompiler.so", compilerDirectory / ".." / "lib" / "libdxcompiler.so" };
+#endif
+
+	for (const fs::path& candidate : candidates)
+	{
+		if (!fs::exists(candidate))
+			continue;
+
+#ifdef _WIN32
+		HMODULE module = LoadLibraryW(candidate.wstring().c_str());
+		if (module)
+			g_DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(module, "DxcCreateInstance");
+#else
+		void* module = dlopen(candidate.string().c_str(), RTLD_NOW);
+		if (module)
+			g_DxcCreateInstance = (DxcCreateInstanceProc)dlsym(module, "DxcCreateInstance");
+#endif
+
+		if (g_DxcCreateInstance)
+		{
+			outLibraryPath = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Forwards to the default include handler and records every file that DXC opens,
+// which gives in-process compilations their dependency list without a separate -M pass.
+class RecordingIncludeHandler : public IDxcIncludeHandler
+{
+public:
+	set<string> dependencies;
+
+	explicit RecordingIncludeHandler(IDxcIncludeHandler* inner) : m_Inner(inner) { }
+
+	HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR pFilename, IDxcBlob** ppIncludeSource) override
+	{
+		HRESULT hr = m_Inner->LoadSource(pFilename, ppIncludeSource);
+		if (SUCCEEDED(hr))
+			dependencies.insert(makeDependencyName(fs::path(pFilename)));
+		return hr;
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+	{
+		if (memcmp(&riid, &__uuidof(IDxcIncludeHandler), sizeof(IID)) == 0 || memcmp(&riid, &__uuidof(IUnknown), sizeof(IID)) == 0)
+		{
+			*ppvObject = this;
+			return S_OK;
+		}
+
+		*ppvObject = nullptr;
+		return E_NOINTERFACE;
+	}
+
+	// Lives on the stack for the duration of one Compile call
+	ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+	ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+private:
+	IDxcIncludeHandler* m_Inner;
+};
+
+// One compiler instance per worker thread, DXC objects are not meant to be shared between threads
+struct DxcWorker
+{
+	IDxcCompiler3* compiler = nullptr;
+	IDxcUtils* utils = nullptr;
+	IDxcIncludeHandler* includeHandler = nullptr;
+
+	bool init()
+	{
+		return SUCCEEDED(g_DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler)))
+			&& SUCCEEDED(g_DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils)))
+			&& SUCCEEDED(utils->CreateDefaultIncludeHandler(&includeHandler));
+	}
+
+	~DxcWorker()
+	{
+		if (includeHandler) includeHandler->Release();
+		if (utils) utils->Release();
+		if (compiler) compiler->Release();
+	}
+};
+
+// Returns 0 on success, like the compiler process would
+int compileInProcess(DxcWorker& worker, const CompileTask& task, string& outMessages, set<string>& outDependencies)
+{
+	IDxcBlobEncoding* source = nullptr;
+	if (FAILED(worker.utils->LoadFile(fs::path(task.sourceFile).wstring().c_str(), nullptr, &source)))
+	{
+		outMessages = "ERROR: cannot read " + task.sourceFile;
+		return 1;
+	}
+
+	DxcBuffer sourceBuffer;
+	sourceBuffer.Ptr = source->GetBufferPointer();
+	sourceBuffer.Size = source->GetBufferSize();
+	sourceBuffer.Encoding = DXC_CP_ACP;
+
+	vector<wstring> arguments;
+	for (const string& argument : task.compilerArguments)
+		arguments.push_back(fs::path(argument).wstring());
+
+	vector<LPCWSTR> argumentPointers;
+	for (const wstring& argument : arguments)
+		argumentPointers.push_back(argument.c_str());
+
+	RecordingIncludeHandler includeHandler(worker.includeHandler);
+	includeHandler.dependencies.insert(makeDependencyName(task.sourceFile));
+
+	IDxcResult* result = nullptr;
+	HRESULT hr = worker.compiler->Compile(&sourceBuffer, argumentPointers.data(), (UINT32)argumentPointers.size(),
+		&includeHandler, IID_PPV_ARGS(&result));
+	source->Release();
+
+	if (FAILED(hr))
+	{
+		outMessages = "ERROR: IDxcCompiler3::Compile failed";
+		return 1;
+	}
+
+	IDxcBlobUtf8* errors = nullptr;
+	if (SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr)) && errors)
+	{
+		outMessages.assign(errors->GetStringPointer(), errors->GetStringLength());
+		errors->Release();
+	}
+
+	int exitCode = 1;
+	HRESULT status;
+	if (SUCCEEDED(result->GetStatus(&status)) && SUCCEEDED(status))
+	{
+		IDxcBlob* object = nullptr;
+		if (SUCCEEDED(result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&object), nullptr)) && object)
+		{
+			ofstream outputFile(task.compiledPermutationFile, ios::binary);
+			outputFile.write(static_cast<const char*>(object->GetBufferPointer()), object->GetBufferSize());
+			if (outputFile)
+				exitCode = 0;
+			else
+				outMessages += "ERROR: cannot write " + path_string(task.compiledPermutationFile);
+
+			object->Release();
+		}
+	}
+	result->Release();
+
+	if (exitCode == 0)
+		outDependencies = std::move(includeHandler.dependencies);
+
+	return exitCode;
+}
+#endif
+
+void compileThreadProc()
+{
+#if NVRHI_SHADERCOMPILER_WITH_DXCAPI
+	DxcWorker dxc;
+	if (g_Options.inProcess && !dxc.init())
+	{
+		lock_guard<mutex> guard(g_ReportMutex);
+		cout << "ERROR: cannot create a DXC compiler instance" << endl;
+		g_CompileSuccess = false;
+		g_Terminate = true;
+		return;
+	}
+#endif
+
+	while (!g_Terminate)
+	{
+		// The tasks are sorted by expected compile time, longest first,
+		// so that the tail of the build is made of the fastest permutations.
+		size_t taskIndex = g_NextTaskIndex++;
+		if (taskIndex >= g_CompileTasks.size())
+			return;
+
+		const CompileTask& task = g_CompileTasks[taskIndex];
+
 		if (g_Options.verbose)
 		{
 			lock_guard<mutex> guard(g_ReportMutex);
 			cout << task.commandLine << endl;
 		}
 
-		string commandLine = task.commandLine + " 2>&1";
+		auto startTime = chrono::steady_clock::now();
+
+		int result;
+		string output;
+		set<string> dependencies;
+		bool haveDependencies = false;
 
-		FILE* pipe = popen(commandLine.c_str(), "r");
-		if (!pipe)
+#if NVRHI_SHADERCOMPILER_WITH_DXCAPI
+		if (g_Options.inProcess)
 		{
-			lock_guard<mutex> guard(g_ReportMutex);
-			cout << "ERROR: cannot run " << g_Options.compilerPath << endl;
-			g_CompileSuccess = false;
-			g_Terminate = true;
-			return;
+			result = compileInProcess(dxc, task, output, dependencies);
+			haveDependencies = true;
 		}
+		else
+#endif
+		{
+			string commandLine = task.commandLine + " 2>&1";
 
-		ostringstream ss;
-		char buf[1024];
-		while (fgets(buf, sizeof(buf), pipe))
-			ss << buf;
+			output = readPipe(commandLine, result);
+			if (result == -1)
+			{
+				lock_guard<mutex> guard(g_ReportMutex);
+				cout << "ERROR: cannot run " << g_Options.compilerPath << endl;
+				g_CompileSuccess = false;
+				g_Terminate = true;
+				return;
+			}
+		}
+
+		auto compileTime = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime);
+
+		ostringstream log;
+		if (result == 0)
+			storeCompiledPermutation(task, dependencies, haveDependencies, (uint32_t)compileTime.count(), log);
 
-		int result = pclose(pipe);
 		g_ProcessedTaskCount++;
 
 		{
 			lock_guard<mutex> guard(g_ReportMutex);
 
 			const char* resultCode = (result == 0) ? " OK  " : "FAIL ";
+			char buf[1024];
 			float progress = (float)g_ProcessedTaskCount / (float)g_OriginalTaskCount;
 
 			sprintf(buf, "[%5.1f%%] %s %s %s:%s %s", 
@@ -535,11 +1308,12 @@ void compileThreadProc()
 				task.combinedDefines.c_str());
 
 			cout << buf << endl;
+			cout << log.str();
  
 			if (result != 0 && !g_Terminate)
 			{
 				cout << "ERRORS for " << task.shaderName << ":" << task.entryPoint << " " << task.combinedDefines << ": " << endl;
-				cout << ss.str() << endl;
+				cout << output << endl;
 				g_CompileSuccess = false;
 			}
 		}
@@ -577,10 +1351,44 @@ int main(int argc, char** argv)
 		g_IgnoreIncludes.push_back(fileName);
 	}
 	
-	g_ConfigWriteTime = fs::last_write_time(g_Options.inputFile);
+	g_ConfigBasePath = fs::absolute(g_Options.inputFile).parent_path();
+	g_CacheDatabaseFile = fs::path(g_Options.outputPath) / (".scomp-cache-" + g_PlatformName);
+
+	// A different compiler version means everything must be recompiled
+	if (!hashFile(g_Options.compilerPath, g_CompilerHash))
+	{
+		cout << "ERROR: cannot read " << g_Options.compilerPath << endl;
+		return 1;
+	}
+
+	if (!g_Options.cacheDirectory.empty() && !fs::exists(g_Options.cacheDirectory))
+	{
+		cout << "INFO: Creating directory " << g_Options.cacheDirectory << endl;
+		fs::create_directories(g_Options.cacheDirectory);
+	}
+
+	if (g_Options.inProcess)
+	{
+#if NVRHI_SHADERCOMPILER_WITH_DXCAPI
+		fs::path libraryPath;
+		if (!loadDxcLibrary(libraryPath))
+		{
+			cout << "ERROR: cannot load dxcompiler from " << path_string(fs::absolute(g_Options.compilerPath).parent_path()) << endl;
+			return 1;
+		}
 
-	// Updated shaderCompiler executable also means everything must be recompiled
-	g_ConfigWriteTime = std::max(g_ConfigWriteTime, fs::last_write_time(argv[0]));
+		// The library does the actual compilation, so its version matters more than the executable's
+		uint64_t libraryHash;
+		if (hashFile(libraryPath, libraryHash))
+			g_CompilerHash = hashBytes(&libraryHash, sizeof(libraryHash), g_CompilerHash);
+#else
+		cout << "ERROR: this build of the shader compiler does not support --in-process" << endl;
+		return 1;
+#endif
+	}
+
+	if (!g_Options.force)
+		loadCacheDatabase();
 	
 	ifstream configFile(g_Options.inputFile);
 	uint32_t lineno = 0;
@@ -595,14 +1403,83 @@ int main(int argc, char** argv)
 			return 1;
 	}
 
-	if (g_CompileTasks.empty())
+	fs::path archiveFile;
+	bool archiveUpToDate = false;
+	if (!g_Options.archive.empty())
+	{
+		// The archive replaces the individual outputs, and it is rebuilt as a whole
+		archiveFile = fs::path(g_Options.outputPath) / g_Options.archive;
+		g_ShaderBlobs.clear();
+
+		archiveUpToDate = !g_Options.force && fs::exists(archiveFile);
+		for (auto it = g_OutputTasks.begin(); archiveUpToDate && it != g_OutputTasks.end(); ++it)
+		{
+			for (size_t i = 0; archiveUpToDate && i < it->second.size(); i++)
+				archiveUpToDate = isUpToDate(it->second[i]);
+		}
+	}
+
+	// An output is rebuilt when any of its permutations changed, and then every permutation is needed
+	// because the intermediate files are deleted after the blob is written.
+	for (const pair<const string, vector<CompileTask>>& it : g_OutputTasks)
+	{
+		const vector<CompileTask>& tasks = it.second;
+
+		bool upToDate;
+		if (!archiveFile.empty())
+		{
+			upToDate = archiveUpToDate;
+		}
+		else
+		{
+			upToDate = !g_Options.force && fs::exists(fs::path(g_Options.outputPath) / it.first);
+			for (size_t i = 0; upToDate && i < tasks.size(); i++)
+				upToDate = isUpToDate(tasks[i]);
+		}
+
+		if (upToDate)
+		{
+			g_ShaderBlobs.erase(it.first);
+			continue;
+		}
+
+		for (const CompileTask& task : tasks)
+		{
+			if (!g_Options.force && restoreFromSharedCache(task))
+			{
+				g_RestoredTaskCount++;
+				continue;
+			}
+
+			g_CompileTasks.push_back(task);
+
+			auto found = g_CacheDatabase.find(task.permutationName);
+			if (found != g_CacheDatabase.end() && found->second.compileTime != 0)
+				g_CompileTasks.back().expectedCompileTime = found->second.compileTime;
+			else
+				g_CompileTasks.back().expectedCompileTime = UINT32_MAX; // unknown, assume it's expensive
+		}
+	}
+
+	stable_sort(g_CompileTasks.begin(), g_CompileTasks.end(), [](const CompileTask& a, const CompileTask& b)
+	{
+		return a.expectedCompileTime > b.expectedCompileTime;
+	});
+
+	if (g_CompileTasks.empty() && g_RestoredTaskCount == 0)
 	{
 		cout << "All " << g_PlatformName << " outputs are up to date." << endl;
 		return 0;
 	}
 
+	if (g_RestoredTaskCount > 0)
+	{
+		cout << "INFO: " << g_RestoredTaskCount << " " << g_PlatformName << " permutations restored from the shared cache." << endl;
+	}
+
 	g_OriginalTaskCount = (int)g_CompileTasks.size();
 	g_ProcessedTaskCount = 0;
+	g_NextTaskIndex = 0;
 
 	{
 		// Workaround for weird behavior of _popen / cmd.exe on Windows
@@ -650,5 +1527,15 @@ int main(int argc, char** argv)
 			return 1;
 	}
 
+	if (!archiveFile.empty() && !WriteShaderArchive(archiveFile))
+		return 1;
+
+	// Only save the database after a fully successful build: on failure, the outputs on disk
+	// do not necessarily match the hashes recorded for the permutations that did compile.
+	if (!saveCacheDatabase())
+	{
+		cout << "WARNING: cannot write " << path_string(g_CacheDatabaseFile) << endl;
+	}
+
 	return 0;
 }